@@ -0,0 +1,31 @@
+// Copyright 2024 - FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  Analog conversions provided by the ESP32 ADC1 peripheral via the ESP-IDF driver.
+  ADC2 is not used because WiFi takes it over.
+*/
+
+#include "Driver/AnalogReader.h"
+
+#include "driver/adc.h"
+
+AnalogReader* AnalogReader::create(const Pin& pin) {
+    if (!pin.capabilities().has(Pin::Capabilities::ADC)) {
+        return nullptr;
+    }
+    int gpio = pin.getNative(Pin::Capabilities::Input);
+    for (int ch = 0; ch < ADC1_CHANNEL_MAX; ch++) {
+        gpio_num_t io;
+        if (adc1_pad_get_io_num(adc1_channel_t(ch), &io) == ESP_OK && io == gpio) {
+            adc1_config_width(ADC_WIDTH_BIT_12);
+            adc1_config_channel_atten(adc1_channel_t(ch), ADC_ATTEN_DB_11);  // About 0 to 3.1V
+            return new AnalogReader(ch);
+        }
+    }
+    return nullptr;
+}
+
+int AnalogReader::read() {
+    return adc1_get_raw(adc1_channel_t(_channel));
+}
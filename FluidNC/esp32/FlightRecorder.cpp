@@ -0,0 +1,184 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "src/FlightRecorder.h"
+#include "src/Planner.h"  // plan_get_current_block(), plan_get_block_buffer_available()
+#include "src/Stepper.h"  // Stepper::segments_free()
+#include "src/System.h"   // sys, get_motor_steps()
+#include "src/Logging.h"
+
+#include <esp_attr.h>    // __NOINIT_ATTR
+#include <esp_system.h>  // esp_reset_reason()
+#include <esp_timer.h>
+#include <algorithm>
+#include <atomic>
+
+// The rings are in internal RAM that is not cleared at boot.  It keeps its contents
+// across a software reset or a panic, but not across a power cycle.  The RTC RAM that
+// holds the startup log is too small for them.
+
+namespace FlightRecorder {
+    enum class Kind : uint8_t {
+        Boot,
+        Sample,
+        State,
+        Alarm,
+        Error,
+    };
+
+    struct Record {
+        uint32_t seq;  // Index + 1, stored last, so that a record cut short by a reset is skipped
+        uint32_t ms;
+        int32_t  line;
+        int32_t  steps[3];  // Of the first three motors
+        Kind     kind;
+        State    state;
+        uint8_t  planner_free;
+        uint8_t  segments_free;
+        uint8_t  code;  // The alarm, the error or the reset reason, by kind
+        uint8_t  last_error;
+        uint8_t  pad[2];
+    };
+    static_assert(sizeof(Record) == 32, "Records are 32 bytes");
+
+    static const size_t   n_records = 128;  // Per ring; about 13 s of samples
+    static const uint32_t magic     = 0x46524543;
+    static const uint32_t sampleMs  = 100;
+
+    struct Ring {
+        uint32_t              magic;
+        std::atomic<uint32_t> head;
+        Record                records[n_records];
+    };
+
+    static __NOINIT_ATTR Ring     rings[2];
+    static __NOINIT_ATTR uint32_t current;
+
+    static Ring*              ring       = nullptr;  // Recorded into once init() has run
+    static Ring*              previous   = nullptr;  // The previous run's, if it was kept
+    static esp_reset_reason_t reason     = ESP_RST_UNKNOWN;
+    static uint8_t            lastError  = 0;
+    static uint32_t           lastSample = 0;
+
+    static uint32_t now_ms() {
+        return uint32_t(esp_timer_get_time() / 1000);
+    }
+
+    static void record(Kind kind, uint8_t code) {
+        if (!ring) {
+            return;
+        }
+        uint32_t index = ring->head.fetch_add(1, std::memory_order_relaxed);
+        Record&  r     = ring->records[index % n_records];
+        r.seq          = 0;
+        r.ms           = now_ms();
+        r.kind         = kind;
+        r.code         = code;
+        r.state        = sys.state;
+        r.last_error   = lastError;
+        if (kind == Kind::Boot) {
+            // Nothing else is set up yet
+            r.line          = 0;
+            r.planner_free  = 0;
+            r.segments_free = 0;
+            std::fill_n(r.steps, 3, 0);
+        } else {
+            // Read without a lock; a block discarded meanwhile still holds its line number
+            auto block      = plan_get_current_block();
+            r.line          = block ? block->line_number : 0;
+            r.planner_free  = uint8_t(std::min(plan_get_block_buffer_available(), size_t(255)));
+            r.segments_free = uint8_t(std::min(Stepper::segments_free(), uint32_t(255)));
+            auto steps      = get_motor_steps();
+            std::copy_n(steps, 3, r.steps);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        r.seq = index + 1;
+    }
+
+    void init() {
+        reason    = esp_reset_reason();
+        bool kept = reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT && reason != ESP_RST_UNKNOWN;
+        if (kept && current < 2 && rings[current].magic == magic) {
+            previous = &rings[current];
+            current ^= 1;
+        } else {
+            rings[0].magic = 0;
+            rings[1].magic = 0;
+            current        = 0;
+        }
+        ring = &rings[current];
+        ring->head.store(0);
+        ring->magic = magic;
+        record(Kind::Boot, uint8_t(reason));
+
+        if (previous && previous->head.load() > 1) {
+            log_info("Flight recorder has the run before the reset, see $Recorder/Dump");
+        }
+    }
+
+    void sample() {
+        if (state_is(State::Idle) || state_is(State::Alarm) || state_is(State::ConfigAlarm) || state_is(State::Sleep)) {
+            return;
+        }
+        uint32_t now = now_ms();
+        if (now - lastSample >= sampleMs) {
+            lastSample = now;
+            record(Kind::Sample, 0);
+        }
+    }
+
+    void state_changed() { record(Kind::State, 0); }
+    void alarm(ExecAlarm alarm) { record(Kind::Alarm, uint8_t(alarm)); }
+
+    void error(Error error) {
+        lastError = uint8_t(error);
+        record(Kind::Error, uint8_t(error));
+    }
+
+    static const char* kind_name(Kind kind) {
+        switch (kind) {
+            case Kind::Boot:
+                return "Boot";
+            case Kind::Sample:
+                return "Sample";
+            case Kind::State:
+                return "State";
+            case Kind::Alarm:
+                return "Alarm";
+            case Kind::Error:
+                return "Error";
+        }
+        return "?";
+    }
+
+    static const char* state_names[] = {
+        "Idle", "Alarm", "Check", "Home", "Run", "Hold", "Jog", "Door", "Sleep", "ConfigAlarm", "Critical",
+    };
+
+    void dump(Channel& out, bool previous_run) {
+        Ring* r = previous_run ? previous : ring;
+        if (!r || r->head.load() == 0) {
+            log_stream(out, "No flight recorder records" << (previous_run ? " from before the reset" : ""));
+            return;
+        }
+        if (previous_run) {
+            log_stream(out, "Flight recorder, run ended by reset reason " << int(reason));
+        }
+        // Times are in ms before the newest record
+        uint32_t head  = r->head.load();
+        uint32_t first = head > n_records ? head - n_records : 0;
+        uint32_t last  = r->records[(head - 1) % n_records].ms;
+        for (uint32_t i = first; i < head; i++) {
+            const Record& rec = r->records[i % n_records];
+            if (rec.seq != i + 1) {
+                continue;
+            }
+            size_t state = size_t(rec.state);
+            log_stream(out,
+                       "[REC:" << -int32_t(last - rec.ms) << "," << kind_name(rec.kind) << ","
+                               << (state < sizeof(state_names) / sizeof(state_names[0]) ? state_names[state] : "?") << ",N" << rec.line
+                               << "," << rec.steps[0] << "," << rec.steps[1] << "," << rec.steps[2] << ",P" << int(rec.planner_free)
+                               << ",S" << int(rec.segments_free) << ",C" << int(rec.code) << ",E" << int(rec.last_error) << "]");
+        }
+    }
+}
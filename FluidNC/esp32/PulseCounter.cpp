@@ -0,0 +1,138 @@
+// Copyright 2024 - FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  Edge counting provided by the ESP32 PCNT peripheral via the ESP-IDF driver
+*/
+
+#include "Driver/PulseCounter.h"
+#include "src/Assert.h"
+
+#include "driver/pcnt.h"
+#include <hal/pcnt_ll.h>
+#include <soc/pcnt_struct.h>
+#include <esp_attr.h>
+
+static int allocateUnit() {
+    static int nextUnit = 0;
+
+    // The last unit belongs to the MCPWM stepping engine
+    Assert(nextUnit < PCNT_UNIT_MAX - 1, "Out of pulse counter units");
+    return nextUnit++;
+}
+
+PulseCounter::PulseCounter(const Pin& pin) : _unit(allocateUnit()) {
+    pcnt_unit_t unit = pcnt_unit_t(_unit);
+
+    pcnt_config_t config  = {};
+    config.pulse_gpio_num = pin.getNative(Pin::Capabilities::Input);
+    config.ctrl_gpio_num  = PCNT_PIN_NOT_USED;
+    config.lctrl_mode     = PCNT_MODE_KEEP;
+    config.hctrl_mode     = PCNT_MODE_KEEP;
+    config.pos_mode       = PCNT_COUNT_INC;
+    config.neg_mode       = PCNT_COUNT_DIS;
+    config.counter_h_lim  = maxCount;
+    config.counter_l_lim  = 0;
+    config.unit           = unit;
+    config.channel        = PCNT_CHANNEL_0;
+    Assert(pcnt_unit_config(&config) == ESP_OK, "Pulse counter setup failed");
+
+    // Ignore glitches shorter than 1023 APB cycles, about 12.8 us
+    pcnt_set_filter_value(unit, 1023);
+    pcnt_filter_enable(unit);
+
+    pcnt_counter_clear(unit);
+    pcnt_counter_resume(unit);
+}
+
+uint32_t PulseCounter::take() {
+    pcnt_unit_t unit = pcnt_unit_t(_unit);
+    int16_t     count;
+    pcnt_get_counter_value(unit, &count);
+    pcnt_counter_clear(unit);
+    return uint32_t(count);
+}
+
+PulseCounter::~PulseCounter() {
+    // XXX the unit is not released for reuse
+    pcnt_counter_pause(pcnt_unit_t(_unit));
+}
+
+// The counter returns to 0 when it reaches either limit
+static const int16_t quadratureLimit = 30000;
+
+QuadratureCounter::QuadratureCounter(const Pin& a, const Pin& b) : _unit(allocateUnit()) {
+    pcnt_unit_t unit = pcnt_unit_t(_unit);
+    int         a_io = a.getNative(Pin::Capabilities::Input);
+    int         b_io = b.getNative(Pin::Capabilities::Input);
+
+    // Each channel counts the edges of one signal, in a direction that the level of
+    // the other signal reverses, so every edge of A and B is counted.
+    pcnt_config_t config  = {};
+    config.pulse_gpio_num = a_io;
+    config.ctrl_gpio_num  = b_io;
+    config.lctrl_mode     = PCNT_MODE_REVERSE;
+    config.hctrl_mode     = PCNT_MODE_KEEP;
+    config.pos_mode       = PCNT_COUNT_DEC;
+    config.neg_mode       = PCNT_COUNT_INC;
+    config.counter_h_lim  = quadratureLimit;
+    config.counter_l_lim  = -quadratureLimit;
+    config.unit           = unit;
+    config.channel        = PCNT_CHANNEL_0;
+    Assert(pcnt_unit_config(&config) == ESP_OK, "Quadrature counter setup failed");
+
+    config.pulse_gpio_num = b_io;
+    config.ctrl_gpio_num  = a_io;
+    config.pos_mode       = PCNT_COUNT_INC;
+    config.neg_mode       = PCNT_COUNT_DEC;
+    config.channel        = PCNT_CHANNEL_1;
+    Assert(pcnt_unit_config(&config) == ESP_OK, "Quadrature counter setup failed");
+
+    // Ignore glitches shorter than 100 APB cycles, about 1.25 us, which permits
+    // edge rates of a few hundred kHz
+    pcnt_set_filter_value(unit, 100);
+    pcnt_filter_enable(unit);
+
+    // The service might already have been installed for another unit
+    esp_err_t err = pcnt_isr_service_install(0);
+    Assert(err == ESP_OK || err == ESP_ERR_INVALID_STATE, "Quadrature counter interrupt setup failed");
+    pcnt_isr_handler_add(unit, handle_limit, this);
+    pcnt_event_enable(unit, PCNT_EVT_H_LIM);
+    pcnt_event_enable(unit, PCNT_EVT_L_LIM);
+
+    pcnt_counter_pause(unit);
+    pcnt_counter_clear(unit);
+    pcnt_counter_resume(unit);
+}
+
+void QuadratureCounter::handle_limit(void* arg) {
+    auto     counter = static_cast<QuadratureCounter*>(arg);
+    uint32_t status;
+    pcnt_get_event_status(pcnt_unit_t(counter->_unit), &status);
+    if (status & PCNT_EVT_H_LIM) {
+        counter->_wraps += quadratureLimit;
+    }
+    if (status & PCNT_EVT_L_LIM) {
+        counter->_wraps -= quadratureLimit;
+    }
+}
+
+// The counter is read through the HAL, not the driver, so that this can run from IRAM
+int32_t IRAM_ATTR QuadratureCounter::position() {
+    pcnt_unit_t unit = pcnt_unit_t(_unit);
+    int32_t     wraps;
+    int16_t     count;
+    // Retry if the limit interrupt ran between the two reads
+    do {
+        wraps = _wraps;
+        pcnt_ll_get_counter_value(&PCNT, unit, &count);
+    } while (wraps != _wraps);
+    return wraps + count;
+}
+
+QuadratureCounter::~QuadratureCounter() {
+    // XXX the unit is not released for reuse
+    pcnt_unit_t unit = pcnt_unit_t(_unit);
+    pcnt_counter_pause(unit);
+    pcnt_isr_handler_remove(unit);
+}
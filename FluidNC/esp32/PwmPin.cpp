@@ -105,23 +105,40 @@ PwmPin::PwmPin(const Pin& pin, uint32_t frequency) : _frequency(frequency) {
         log_error("ledc channel setup failed");
         throw -1;
     }
+
+    // The other conf1 fields do not change after the setup, so the words that
+    // setDuty() stores can be made now, saving it a read of the register
+    auto& regs = LEDC.channel_group[group].channel[_channel & 7];
+    _dutyReg   = &regs.duty.val;
+    _conf1Reg  = &regs.conf1.val;
+
+    decltype(regs.conf1) conf1;
+    conf1.val        = regs.conf1.val;
+    conf1.duty_start = 1;
+    _conf1Start      = conf1.val;
+    conf1.duty_start = 0;
+    _conf1Stop       = conf1.val;
 }
 
 // cppcheck-suppress unusedFunction
 void IRAM_ATTR PwmPin::setDuty(uint32_t duty) {
-    uint8_t g = _channel >> 3, c = _channel & 7;
-    bool    on = duty != 0;
+    int on = duty != 0;
 
     // This is like ledcWrite, but it is called from an ISR
     // and ledcWrite uses RTOS features not compatible with ISRs
     // Also, ledcWrite infers enable from duty, which is incorrect
     // for use with RcServo which wants the
 
-    // We might be able to use ledc_duty_config() which is IRAM_ATTR
+    // The duty has 4 fraction bits.  conf0 is read and written only when the
+    // output is turned on or off, not at each change of duty.
+    *_dutyReg = duty << 4;
+    if (on != _on) {
+        uint8_t g = _channel >> 3, c = _channel & 7;
 
-    LEDC.channel_group[g].channel[c].duty.duty        = duty << 4;
-    LEDC.channel_group[g].channel[c].conf0.sig_out_en = on;
-    LEDC.channel_group[g].channel[c].conf1.duty_start = on;
+        LEDC.channel_group[g].channel[c].conf0.sig_out_en = on;
+        _on                                               = on;
+    }
+    *_conf1Reg = on ? _conf1Start : _conf1Stop;
 }
 
 PwmPin::~PwmPin() {
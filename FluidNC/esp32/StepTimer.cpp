@@ -46,6 +46,13 @@ void IRAM_ATTR stepTimerSetTicks(uint32_t ticks) {
     }
 }
 
+// The counter reloads to 0 at each alarm, so it holds the time since the last interrupt
+uint32_t IRAM_ATTR stepTimerGetTicks() {
+    uint64_t ticks;
+    timer_ll_get_counter_value(&TIMERG0, TIMER_0, &ticks);
+    return (uint32_t)ticks;
+}
+
 void IRAM_ATTR stepTimerStop() {
     timer_ll_set_counter_enable(&TIMERG0, TIMER_0, false);
     timer_ll_set_alarm_enable(&TIMERG0, TIMER_0, false);
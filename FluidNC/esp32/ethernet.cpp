@@ -0,0 +1,239 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Ethernet with the esp_eth driver from ESP-IDF v4.4.  The internal EMAC exists
+// only on the ESP32, and the W5500 driver only when the SDK config enables it,
+// so either start function can return false for lack of support.
+
+#include "Driver/ethernet.h"
+
+#include "esp_eth.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_system.h"  // esp_read_mac()
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+
+#include <sdkconfig.h>
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+#    define HSPI_HOST SPI2_HOST
+#endif
+
+static esp_eth_handle_t            eth_handle = nullptr;
+static esp_netif_t*                eth_netif  = nullptr;
+static esp_eth_netif_glue_handle_t eth_glue   = nullptr;
+static spi_device_handle_t         eth_spi    = nullptr;
+
+static volatile bool     link_up     = false;
+static volatile int      speed       = 0;
+static volatile bool     full_duplex = false;
+static volatile uint32_t local_ip    = 0;
+static bool              dhcp        = true;
+
+static void eth_event(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    switch (id) {
+        case ETHERNET_EVENT_CONNECTED: {
+            eth_speed_t  s;
+            eth_duplex_t d;
+            esp_eth_ioctl(eth_handle, ETH_CMD_G_SPEED, &s);
+            esp_eth_ioctl(eth_handle, ETH_CMD_G_DUPLEX_MODE, &d);
+            speed       = s == ETH_SPEED_100M ? 100 : 10;
+            full_duplex = d == ETH_DUPLEX_FULL;
+            link_up     = true;
+            break;
+        }
+        case ETHERNET_EVENT_DISCONNECTED:
+            link_up = false;
+            speed   = 0;
+            if (dhcp) {
+                local_ip = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void ip_event(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    local_ip = static_cast<ip_event_got_ip_t*>(data)->ip_info.ip.addr;
+}
+
+static bool eth_start(esp_eth_mac_t* mac, esp_eth_phy_t* phy, bool set_mac, const char* hostname, const eth_addr_t* addr) {
+    if (!mac || !phy) {
+        if (mac) {
+            mac->del(mac);
+        }
+        if (phy) {
+            phy->del(phy);
+        }
+        return false;
+    }
+
+    // Already done if WiFi has been started
+    esp_netif_init();
+    esp_err_t err = esp_event_loop_create_default();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return false;
+    }
+
+    esp_eth_config_t config = ETH_DEFAULT_CONFIG(mac, phy);
+    if (esp_eth_driver_install(&config, &eth_handle) != ESP_OK) {
+        mac->del(mac);
+        phy->del(phy);
+        eth_handle = nullptr;
+        return false;
+    }
+
+    // Chips without a MAC address of their own get the one the ESP32 reserves for Ethernet
+    if (set_mac) {
+        uint8_t mac_addr[6];
+        esp_read_mac(mac_addr, ESP_MAC_ETH);
+        esp_eth_ioctl(eth_handle, ETH_CMD_S_MAC_ADDR, mac_addr);
+    }
+
+    esp_netif_config_t netif_config = ESP_NETIF_DEFAULT_ETH();
+    eth_netif                       = esp_netif_new(&netif_config);
+    esp_eth_set_default_handlers(eth_netif);
+    esp_netif_set_hostname(eth_netif, hostname);
+
+    dhcp = addr->ip == 0;
+    if (!dhcp) {
+        esp_netif_dhcpc_stop(eth_netif);
+        esp_netif_ip_info_t info;
+        info.ip.addr      = addr->ip;
+        info.gw.addr      = addr->gateway;
+        info.netmask.addr = addr->netmask;
+        esp_netif_set_ip_info(eth_netif, &info);
+        local_ip = addr->ip;
+    }
+
+    eth_glue = esp_eth_new_netif_glue(eth_handle);
+    esp_netif_attach(eth_netif, eth_glue);
+
+    esp_event_handler_register(ETH_EVENT, ESP_EVENT_ANY_ID, eth_event, nullptr);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, ip_event, nullptr);
+
+    if (esp_eth_start(eth_handle) != ESP_OK) {
+        eth_stop();
+        return false;
+    }
+    return true;
+}
+
+bool eth_start_rmii(int phy_addr, int mdc_pin, int mdio_pin, eth_clock_t clock, const char* hostname, const eth_addr_t* addr) {
+#if CONFIG_ETH_USE_ESP32_EMAC
+    eth_mac_config_t mac_config  = ETH_MAC_DEFAULT_CONFIG();
+    mac_config.smi_mdc_gpio_num  = mdc_pin;
+    mac_config.smi_mdio_gpio_num = mdio_pin;
+    switch (clock) {
+        case ETH_CLOCK_GPIO0_IN:
+            mac_config.clock_config.rmii.clock_mode = EMAC_CLK_EXT_IN;
+            mac_config.clock_config.rmii.clock_gpio = EMAC_CLK_IN_GPIO;
+            break;
+        case ETH_CLOCK_GPIO0_OUT:
+            mac_config.clock_config.rmii.clock_mode = EMAC_CLK_OUT;
+            mac_config.clock_config.rmii.clock_gpio = EMAC_APPL_CLK_OUT_GPIO;
+            break;
+        case ETH_CLOCK_GPIO16_OUT:
+            mac_config.clock_config.rmii.clock_mode = EMAC_CLK_OUT;
+            mac_config.clock_config.rmii.clock_gpio = EMAC_CLK_OUT_GPIO;
+            break;
+        case ETH_CLOCK_GPIO17_OUT:
+            mac_config.clock_config.rmii.clock_mode = EMAC_CLK_OUT;
+            mac_config.clock_config.rmii.clock_gpio = EMAC_CLK_OUT_180_GPIO;
+            break;
+    }
+
+    eth_phy_config_t phy_config = ETH_PHY_DEFAULT_CONFIG();
+    phy_config.phy_addr         = phy_addr;
+    phy_config.reset_gpio_num   = -1;
+
+    return eth_start(esp_eth_mac_new_esp32(&mac_config), esp_eth_phy_new_lan87xx(&phy_config), false, hostname, addr);
+#else
+    return false;
+#endif
+}
+
+bool eth_start_w5500(int cs_pin, int int_pin, int reset_pin, int mhz, const char* hostname, const eth_addr_t* addr) {
+#if CONFIG_ETH_SPI_ETHERNET_W5500
+    spi_device_interface_config_t devcfg = {};
+    devcfg.command_bits                  = 16;  // the W5500 address phase
+    devcfg.address_bits                  = 8;   // the W5500 control phase
+    devcfg.mode                          = 0;
+    devcfg.clock_speed_hz                = mhz * 1000000;
+    devcfg.spics_io_num                  = cs_pin;
+    devcfg.queue_size                    = 20;
+    if (spi_bus_add_device(HSPI_HOST, &devcfg, &eth_spi) != ESP_OK) {
+        return false;
+    }
+
+    // The W5500 driver uses a GPIO interrupt for received frames
+    gpio_install_isr_service(ESP_INTR_FLAG_IRAM);  // Will return an err if already called
+
+    eth_w5500_config_t w5500_config = ETH_W5500_DEFAULT_CONFIG(eth_spi);
+    w5500_config.int_gpio_num       = int_pin;
+
+    eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
+    eth_phy_config_t phy_config = ETH_PHY_DEFAULT_CONFIG();
+    phy_config.reset_gpio_num   = reset_pin;
+
+    if (eth_start(esp_eth_mac_new_w5500(&w5500_config, &mac_config), esp_eth_phy_new_w5500(&phy_config), true, hostname, addr)) {
+        return true;
+    }
+    eth_stop();
+    return false;
+#else
+    return false;
+#endif
+}
+
+void eth_stop() {
+    if (eth_handle) {
+        esp_event_handler_unregister(ETH_EVENT, ESP_EVENT_ANY_ID, eth_event);
+        esp_event_handler_unregister(IP_EVENT, IP_EVENT_ETH_GOT_IP, ip_event);
+        esp_eth_stop(eth_handle);
+        if (eth_glue) {
+            esp_eth_del_netif_glue(eth_glue);
+            eth_glue = nullptr;
+        }
+        if (eth_netif) {
+            esp_eth_clear_default_handlers(eth_netif);
+            esp_netif_destroy(eth_netif);
+            eth_netif = nullptr;
+        }
+        esp_eth_driver_uninstall(eth_handle);
+        eth_handle = nullptr;
+    }
+    if (eth_spi) {
+        spi_bus_remove_device(eth_spi);
+        eth_spi = nullptr;
+    }
+    link_up  = false;
+    speed    = 0;
+    local_ip = 0;
+}
+
+bool eth_link_up() {
+    return link_up;
+}
+
+int eth_speed_mbps() {
+    return speed;
+}
+
+bool eth_full_duplex() {
+    return full_duplex;
+}
+
+uint32_t eth_local_ip() {
+    return local_ip;
+}
+
+void eth_mac(uint8_t mac[6]) {
+    if (eth_handle) {
+        esp_eth_ioctl(eth_handle, ETH_CMD_G_MAC_ADDR, mac);
+    } else {
+        esp_read_mac(mac, ESP_MAC_ETH);
+    }
+}
@@ -0,0 +1,64 @@
+#include "Driver/flashdata.h"
+#include "esp_partition.h"
+#include "src/Config.h"
+
+#include <cstring>
+
+// One partition is mapped at a time; mapping a different one releases it
+static const esp_partition_t*  mapped_part = nullptr;
+static spi_flash_mmap_handle_t mapped_handle;
+static const char*             mapped_data = nullptr;
+
+static void unmap() {
+    if (mapped_part) {
+        spi_flash_munmap(mapped_handle);
+        mapped_part = nullptr;
+        mapped_data = nullptr;
+    }
+}
+
+std::string_view flashdata_map(const char* label) {
+    auto part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        return {};
+    }
+    if (part != mapped_part) {
+        unmap();
+        const void* ptr;
+        if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &ptr, &mapped_handle) != ESP_OK) {
+            log_error("Cannot map partition " << label);
+            return {};
+        }
+        mapped_part = part;
+        mapped_data = static_cast<const char*>(ptr);
+    }
+    size_t len = 0;
+    while (len < part->size && mapped_data[len] != '\0' && mapped_data[len] != '\xff') {
+        ++len;
+    }
+    return { mapped_data, len };
+}
+
+bool flashdata_write(const char* label, std::string_view text) {
+    auto part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) {
+        log_error("No partition " << label);
+        return true;
+    }
+    if (text.length() >= part->size) {
+        log_error("Partition " << label << " is too small");
+        return true;
+    }
+    if (part == mapped_part) {
+        unmap();
+    }
+    const size_t sector = SPI_FLASH_SEC_SIZE;
+    size_t       erase  = (text.length() + 1 + sector - 1) / sector * sector;
+    const char   nul    = '\0';
+    if (esp_partition_erase_range(part, 0, erase) != ESP_OK || esp_partition_write(part, 0, text.data(), text.length()) != ESP_OK ||
+        esp_partition_write(part, text.length(), &nul, 1) != ESP_OK) {
+        log_error("Cannot write partition " << label);
+        return true;
+    }
+    return false;
+}
@@ -16,6 +16,23 @@ void IRAM_ATTR gpio_write(pinnum_t pin, int value) {
 int IRAM_ATTR gpio_read(pinnum_t pin) {
     return gpio_ll_get_level(_gpio_dev, (gpio_num_t)pin);
 }
+void gpio_fast_resolve(pinnum_t pin, int inverted, gpio_fast_t* regs) {
+    volatile uint32_t* set;
+    volatile uint32_t* clear;
+    if (pin < 32) {
+        set      = &_gpio_dev->out_w1ts;
+        clear    = &_gpio_dev->out_w1tc;
+        regs->in = &_gpio_dev->in;
+    } else {
+        set      = &_gpio_dev->out1_w1ts.val;
+        clear    = &_gpio_dev->out1_w1tc.val;
+        regs->in = &_gpio_dev->in1.val;
+    }
+    regs->on       = inverted ? clear : set;
+    regs->off      = inverted ? set : clear;
+    regs->mask     = 1u << (pin & 31);
+    regs->inverted = inverted;
+}
 void gpio_mode(pinnum_t pin, int input, int output, int pullup, int pulldown, int opendrain) {
     gpio_config_t conf = { .pin_bit_mask = (1ULL << pin), .intr_type = GPIO_INTR_DISABLE };
 
@@ -36,11 +53,11 @@ void gpio_mode(pinnum_t pin, int input, int output, int pullup, int pulldown, in
     }
     gpio_config(&conf);
 }
-#if 0
 void gpio_add_interrupt(pinnum_t pin, int mode, void (*callback)(void*), void* arg) {
     gpio_install_isr_service(ESP_INTR_FLAG_IRAM);  // Will return an err if already called
 
     gpio_num_t gpio = (gpio_num_t)pin;
+    gpio_set_intr_type(gpio, (gpio_int_type_t)mode);
     gpio_isr_handler_add(gpio, callback, arg);
 
     //FIX interrupts on peripherals outputs (eg. LEDC,...)
@@ -54,7 +71,6 @@ void gpio_remove_interrupt(pinnum_t pin) {
     gpio_isr_handler_remove(gpio);  //remove handle and disable isr for pin
     gpio_set_intr_type(gpio, GPIO_INTR_DISABLE);
 }
-#endif
 void gpio_route(pinnum_t pin, uint32_t signal) {
     if (pin == 255) {
         return;
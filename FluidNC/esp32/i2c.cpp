@@ -78,3 +78,9 @@ int i2c_write(int bus_number, uint8_t address, const uint8_t* data, size_t count
 int i2c_read(int bus_number, uint8_t address, uint8_t* data, size_t count) {
     return i2c_master_read_from_device((i2c_port_t)bus_number, address, data, count, 10 / portTICK_RATE_MS) ? -1 : count;
 }
+
+// cppcheck-suppress unusedFunction
+int i2c_write_read(int bus_number, uint8_t address, const uint8_t* out, size_t out_count, uint8_t* in, size_t in_count) {
+    esp_err_t err = i2c_master_write_read_device((i2c_port_t)bus_number, address, out, out_count, in, in_count, 10 / portTICK_RATE_MS);
+    return err ? -1 : in_count;
+}
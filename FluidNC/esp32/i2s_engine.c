@@ -9,6 +9,11 @@
 // pulse_func to determine the new values of those variables. The FIFO lets the ISR stay
 // just far enough ahead so the information is always ready, but not so far ahead to cause
 // latency problems.
+//
+// The I2S_STREAM variant renders the same samples ahead into a ring of DMA buffers
+// instead, which the peripheral clocks out with no CPU involvement.  The ISR then runs
+// once per buffer rather than once per FIFO_RELOAD samples, at the cost of a step
+// latency of up to the depth of the ring.
 
 #include "Driver/step_engine.h"
 #include "Driver/i2s_out.h"
@@ -30,6 +35,7 @@
 #include "Driver/fluidnc_gpio.h"
 
 #include "esp_intr_alloc.h"
+#include <esp_heap_caps.h>
 
 uint32_t i2s_frame_us;  // 1, 2 or 4
 
@@ -154,27 +160,40 @@ static int i2s_out_start() {
 
 static bool timer_running = false;
 
+// DMA streaming; see the I2S_STREAM engine below
+static bool      dma_running        = false;
+static uint32_t  dma_buffers        = 4;
+static uint32_t  dma_buffer_samples = 64;
+static lldesc_t* dma_desc           = NULL;
+
 void i2s_out_delay() {
     // Depending on the timing, it may not be reflected immediately,
     // so wait twice as long just in case.
-    uint32_t wait_counts = timer_running ? FIFO_THRESHOLD + FIFO_RELOAD : 2;
+    uint32_t wait_counts = dma_running ? dma_buffers * dma_buffer_samples + 2 : timer_running ? FIFO_THRESHOLD + FIFO_RELOAD : 2;
     delay_us(i2s_frame_us * wait_counts);
 }
 
-void IRAM_ATTR i2s_out_write(pinnum_t pin, uint8_t val) {
-    uint32_t bit = 1 << pin;
-    if (val) {
-        i2s_out_port_data |= bit;
-    } else {
-        i2s_out_port_data &= ~bit;
-    }
+// The port word is shared by the stepping ISR and by tasks on both cores, so it is
+// updated with compare-and-swap rather than a read-modify-write that could lose bits.
+void IRAM_ATTR i2s_out_write_mask(uint32_t mask, uint32_t value) {
+    uint32_t* port = (uint32_t*)&i2s_out_port_data;
+    uint32_t  old  = *port;
+    uint32_t  desired;
+    do {
+        desired = (old & ~mask) | (value & mask);
+    } while (!__atomic_compare_exchange_n(port, &old, desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 
-    if (!timer_running) {
+    if (!timer_running && !dma_running) {
         // Direct write to the I2S FIFO in case the pulse timer is not running
-        I2S0.fifo_wr = i2s_out_port_data;
+        I2S0.fifo_wr = desired;
     }
 }
 
+void IRAM_ATTR i2s_out_write(pinnum_t pin, uint8_t val) {
+    uint32_t bit = 1 << pin;
+    i2s_out_write_mask(bit, val ? bit : 0);
+}
+
 uint8_t i2s_out_read(pinnum_t pin) {
     uint32_t port_data = i2s_out_port_data;
     return !!(port_data & (1 << pin));
@@ -189,6 +208,13 @@ int i2s_out_init(i2s_out_init_t* init_param) {
 
     i2s_out_port_data = init_param->init_val;
 
+    if (init_param->dma_buffers >= 2) {
+        dma_buffers = init_param->dma_buffers;
+    }
+    if (init_param->dma_buffer_samples) {
+        dma_buffer_samples = init_param->dma_buffer_samples;
+    }
+
     // To make sure hardware is enabled before any hardware register operations.
     periph_module_reset(PERIPH_I2S0_MODULE);
     periph_module_enable(PERIPH_I2S0_MODULE);
@@ -306,15 +332,18 @@ int i2s_out_init(i2s_out_init_t* init_param) {
 
 static uint32_t _pulse_counts = 2;
 static uint32_t _dir_delay_us;
+static uint32_t _dir_counts = 0;
 
 bool (*_pulse_func)();
 
+static uint32_t _remaining_dir_counts   = 0;
 static uint32_t _remaining_pulse_counts = 0;
 static uint32_t _remaining_delay_counts = 0;
 
 static uint32_t _pulse_data;
 static uint32_t _delay_counts = 40;
 static uint32_t _tick_divisor;
+static uint32_t _lead_counts = 0;  // Direction delay samples before the next pulse
 
 static void IRAM_ATTR set_timer_ticks(uint32_t ticks) {
     if (ticks) {
@@ -336,23 +365,32 @@ static void IRAM_ATTR stop_timer() {
     }
 }
 
-static void IRAM_ATTR i2s_isr() {
-    // gpio_write(12, 1);  // For debugging
-
+// Generates n samples of step pulses and inter-pulse delays, calling pulse_func()
+// when each delay is done.  dst advances by stride words per sample, so the same
+// code feeds the FIFO register (stride 0) and the DMA buffers (stride 1).
+static inline __attribute__((always_inline)) void render_samples(volatile uint32_t* dst, int stride, int n) {
     // Keeping local copies of this information speeds up the ISR
     uint32_t pulse_data             = _pulse_data;
+    uint32_t remaining_dir_counts   = _remaining_dir_counts;
     uint32_t remaining_pulse_counts = _remaining_pulse_counts;
     uint32_t remaining_delay_counts = _remaining_delay_counts;
 
-    int i = FIFO_RELOAD;
     do {
-        if (remaining_pulse_counts) {
-            I2S0.fifo_wr = pulse_data;
-            --i;
+        if (remaining_dir_counts) {
+            // New direction levels without the step bits
+            *dst = i2s_out_port_data;
+            dst += stride;
+            --n;
+            --remaining_dir_counts;
+        } else if (remaining_pulse_counts) {
+            *dst = pulse_data;
+            dst += stride;
+            --n;
             --remaining_pulse_counts;
         } else if (remaining_delay_counts) {
-            I2S0.fifo_wr = i2s_out_port_data;
-            --i;
+            *dst = i2s_out_port_data;
+            dst += stride;
+            --n;
             --remaining_delay_counts;
         } else {
             // Set _pulse_data to the non-pulse value in case pulse_func() does nothing,
@@ -364,13 +402,24 @@ static void IRAM_ATTR i2s_isr() {
             // Reload from variables that could have been modified by pulse_func
             pulse_data             = _pulse_data;
             remaining_pulse_counts = pulse_data == i2s_out_port_data ? 0 : _pulse_counts;
-            remaining_delay_counts = _delay_counts - remaining_pulse_counts;
+            remaining_dir_counts   = _lead_counts;
+            _lead_counts           = 0;
+
+            uint32_t used          = remaining_dir_counts + remaining_pulse_counts;
+            remaining_delay_counts = _delay_counts > used ? _delay_counts - used : 0;
         }
-    } while (i);
+    } while (n);
 
     // Save the counts back to the variables
+    _remaining_dir_counts   = remaining_dir_counts;
     _remaining_pulse_counts = remaining_pulse_counts;
     _remaining_delay_counts = remaining_delay_counts;
+}
+
+static void IRAM_ATTR i2s_isr() {
+    // gpio_write(12, 1);  // For debugging
+
+    render_samples(&I2S0.fifo_wr, 0, FIFO_RELOAD);
 
     // Clear the interrupt after pushing new data into the FIFO.  If you clear
     // it before, the interrupt will re-fire back because the FIFO is still
@@ -391,9 +440,8 @@ static void i2s_fifo_intr_setup() {
                               NULL);
 }
 
-static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t frequency, bool (*callback)(void)) {
+static uint32_t init_pulser(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t frequency, bool (*callback)(void)) {
     _pulse_func = callback;
-    i2s_fifo_intr_setup();
 
     if (pulse_us < i2s_frame_us) {
         pulse_us = i2s_frame_us;
@@ -402,19 +450,29 @@ static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t f
         pulse_us = I2S_MAX_USEC_PER_PULSE;
     }
     _dir_delay_us = dir_delay_us;
+    _dir_counts   = (dir_delay_us + i2s_frame_us - 1) / i2s_frame_us;
     _pulse_counts = (pulse_us + i2s_frame_us - 1) / i2s_frame_us;
     _tick_divisor = frequency * i2s_frame_us / 1000000;
 
+    _remaining_dir_counts   = 0;
     _remaining_pulse_counts = 0;
     _remaining_delay_counts = 0;
 
+    return _pulse_counts * i2s_frame_us;
+}
+
+static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t frequency, bool (*callback)(void)) {
+    uint32_t actual = init_pulser(dir_delay_us, pulse_us, frequency, callback);
+
+    i2s_fifo_intr_setup();
+
     // gpio_mode(12, 0, 1, 0, 0, 0);
 
     // Run the pulser all the time to pick up writes to non-stepping I2S outputs
     start_timer();
     set_timer_ticks(100);
 
-    return _pulse_counts * i2s_frame_us;
+    return actual;
 }
 
 static int init_step_pin(int step_pin, int step_invert) {
@@ -483,3 +541,163 @@ step_engine_t i2s_engine = {
 };
 // clang-format on
 REGISTER_STEP_ENGINE(I2S, &i2s_engine);
+
+// DMA streaming.  The descriptors form a ring of dma_buffers buffers of dma_buffer_samples
+// samples each, with an EOF interrupt at the end of every buffer.  When a buffer has been
+// sent, it is the one that will be sent again last, so the ISR renders new samples into it
+// while the peripheral works through the others.  The look-ahead, and thus the latency from
+// pulse_func() to the pins, is up to dma_buffers * dma_buffer_samples frames; the ISR must
+// run within (dma_buffers - 1) buffer times or the peripheral resends old samples.
+
+static uint32_t dma_fill_index = 0;     // The buffer to render into next
+static bool     dma_stepping   = false;  // Whether the ISR calls pulse_func()
+
+static void IRAM_ATTR fill_idle(uint32_t* buf, uint32_t n) {
+    uint32_t port_data = i2s_out_port_data;
+    for (uint32_t i = 0; i < n; i++) {
+        buf[i] = port_data;
+    }
+}
+
+static void IRAM_ATTR i2s_dma_isr() {
+    if (I2S0.int_st.out_eof) {
+        lldesc_t* finished = (lldesc_t*)I2S0.out_eof_des_addr;
+
+        // Refill every buffer up to the one that just finished, in case a late ISR
+        // missed an earlier EOF
+        for (uint32_t n = 0; n < dma_buffers; n++) {
+            lldesc_t* desc = &dma_desc[dma_fill_index];
+            if (++dma_fill_index == dma_buffers) {
+                dma_fill_index = 0;
+            }
+            if (dma_stepping) {
+                render_samples((volatile uint32_t*)desc->buf, 1, dma_buffer_samples);
+            } else {
+                fill_idle((uint32_t*)desc->buf, dma_buffer_samples);
+            }
+            desc->owner = 1;
+            if (desc == finished) {
+                break;
+            }
+        }
+    }
+    I2S0.int_clr.val = I2S0.int_st.val;
+}
+
+static bool i2s_dma_setup() {
+    uint32_t buffer_bytes = dma_buffer_samples * sizeof(uint32_t);
+
+    dma_desc         = (lldesc_t*)heap_caps_malloc(dma_buffers * sizeof(lldesc_t), MALLOC_CAP_DMA);
+    uint8_t* samples = (uint8_t*)heap_caps_malloc(dma_buffers * buffer_bytes, MALLOC_CAP_DMA);
+    if (!dma_desc || !samples) {
+        heap_caps_free(dma_desc);
+        heap_caps_free(samples);
+        dma_desc = NULL;
+        return false;
+    }
+    for (uint32_t i = 0; i < dma_buffers; i++) {
+        lldesc_t* desc = &dma_desc[i];
+        desc->size         = buffer_bytes;
+        desc->length       = buffer_bytes;
+        desc->offset       = 0;
+        desc->sosf         = 0;
+        desc->eof          = 1;
+        desc->owner        = 1;
+        desc->buf          = samples + i * buffer_bytes;
+        desc->qe.stqe_next = &dma_desc[i + 1 == dma_buffers ? 0 : i + 1];
+        fill_idle((uint32_t*)desc->buf, dma_buffer_samples);
+    }
+    dma_fill_index = 0;
+
+    // Switch the peripheral from CPU-fed FIFO to DMA
+    i2s_ll_tx_stop(&I2S0);
+    i2s_ll_tx_stop_link(&I2S0);
+    i2s_out_reset_tx_rx();
+    i2s_out_reset_fifo_without_lock();
+
+    I2S0.lc_conf.out_rst  = 1;
+    I2S0.lc_conf.out_rst  = 0;
+    I2S0.lc_conf.ahbm_rst = 1;
+    I2S0.lc_conf.ahbm_rst = 0;
+
+    I2S0.lc_conf.out_eof_mode      = 1;  // EOF when the last word of a buffer has been popped
+    I2S0.lc_conf.outdscr_burst_en  = 1;
+    I2S0.lc_conf.out_data_burst_en = 1;
+    I2S0.lc_conf.out_auto_wrback   = 0;
+    i2s_ll_enable_dma(&I2S0, true);
+
+    esp_intr_alloc_intrstatus(ETS_I2S0_INTR_SOURCE,
+                              ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL3,
+                              (uint32_t)i2s_ll_get_intr_status_reg(&I2S0),
+                              I2S_OUT_EOF_INT_ST_M,
+                              i2s_dma_isr,
+                              NULL,
+                              NULL);
+    I2S0.int_clr.val     = 0xFFFFFFFF;
+    I2S0.int_ena.out_eof = 1;
+
+    I2S0.out_link.addr  = (uint32_t)&dma_desc[0];
+    I2S0.out_link.start = 1;
+    i2s_ll_tx_start(&I2S0);
+
+    dma_running = true;
+    return true;
+}
+
+static IRAM_ATTR void stream_finish_dir() {
+    if (!dma_running) {
+        finish_dir();
+        return;
+    }
+    // The delay is rendered as samples with the new direction levels before the next pulse
+    _lead_counts = _dir_counts;
+}
+
+static void IRAM_ATTR stream_start_timer() {
+    if (!dma_running) {
+        start_timer();
+        return;
+    }
+    dma_stepping = true;
+}
+
+static void IRAM_ATTR stream_stop_timer() {
+    if (!dma_running) {
+        stop_timer();
+        return;
+    }
+    dma_stepping = false;
+}
+
+static uint32_t init_stream_engine(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t frequency, bool (*callback)(void)) {
+    uint32_t actual = init_pulser(dir_delay_us, pulse_us, frequency, callback);
+
+    // If the DMA memory cannot be had, fall back to feeding the FIFO directly
+    if (!i2s_dma_setup()) {
+        i2s_fifo_intr_setup();
+        start_timer();
+    }
+    set_timer_ticks(100);
+
+    return actual;
+}
+
+// clang-format off
+step_engine_t i2s_stream_engine = {
+    "I2S_STREAM",
+    init_stream_engine,
+    init_step_pin,
+    set_dir_pin,
+    stream_finish_dir,
+    start_step,
+    set_step_pin,
+    finish_step,
+    start_unstep,
+    finish_unstep,
+    max_pulses_per_sec,
+    set_timer_ticks,
+    stream_start_timer,
+    stream_stop_timer
+};
+// clang-format on
+REGISTER_STEP_ENGINE(I2S_STREAM, &i2s_stream_engine);
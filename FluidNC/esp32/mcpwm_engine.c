@@ -0,0 +1,459 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Stepping engine for a single fast axis, in which the ESP32 MCPWM hardware generates
+// the step pulses and a PCNT unit counts them.
+//
+// The events that pulse_func() renders are grouped into runs of equal periods that
+// either all pulse or all do not.  The MCPWM timer plays a run by pulsing at the end of
+// each period, and the step timer interrupts once per run, in the middle of its last
+// period, to load the next run into the timer's shadow registers.  They take effect at
+// the end of the period, so consecutive runs join without a gap.  At step rates of
+// 100 kHz the timer interrupts a few thousand times a second instead of 100,000.
+//
+// A run that follows a direction change starts after a gap, in the middle of which the
+// direction pins change.  An interrupt that comes after the end of the period it was
+// meant for lets the running run pulse again; the count that PCNT reads from the step
+// pin shows that, and the extra pulses are taken off the next run in that direction.
+// Pulses still owed when the direction changes or stepping stops are made up before it.
+//
+// Only one step pin is driven; the step pins of other motors are ignored, so machines
+// with more than one stepper axis must use another engine.  The engine uses MCPWM unit
+// 0 timer 0 and the last PCNT unit.  Like RMT_BATCH, pulse_func() runs ahead of the
+// pulses, by up to BATCH_HORIZON_US.
+
+#include "Driver/step_engine.h"
+#include "Driver/fluidnc_gpio.h"
+#include "Driver/StepTimer.h"
+#include <driver/mcpwm.h>
+#include <driver/pcnt.h>
+#include <driver/gpio.h>
+#include <hal/mcpwm_ll.h>
+#include <hal/pcnt_ll.h>
+#include <soc/mcpwm_struct.h>
+#include <soc/pcnt_struct.h>
+#include <esp_attr.h>  // IRAM_ATTR
+
+#include <freertos/FreeRTOS.h>
+
+#define BATCH_HORIZON_US 1000
+#define MAX_RUN_PULSES 16384  // Fewer than the PCNT limit between two reads
+#define RUN_QUEUE 8
+#define MAX_DIR_PINS 4
+
+static const uint32_t    mcpwm_hz    = 10000000;  // MCPWM timer resolution
+static const uint32_t    max_period  = 65535;     // MCPWM timer periods are 16 bits
+static const uint32_t    idle_period = 1000;      // 100 us between runs while stopped
+static const pcnt_unit_t pcnt_unit   = (pcnt_unit_t)(PCNT_UNIT_MAX - 1);
+static const int16_t     pcnt_limit  = 32767;
+
+#define MCPWM_DEV (&MCPWM0)
+
+static uint32_t _pulse_delay_us;
+static uint32_t _dir_delay_us;
+
+static bool (*_pulse_func)(void);
+
+static uint32_t _ratio;        // Stepping timer ticks per MCPWM tick
+static uint32_t _horizon;      // BATCH_HORIZON_US in MCPWM ticks
+static uint32_t _pulse_ticks;  // Pulse length in MCPWM ticks
+static uint32_t _gap_ticks;    // Period of a direction change gap
+static uint32_t _min_period;   // Shortest period with a pulse
+
+static int  _step_pin = -1;
+static bool _step_inverted;
+
+typedef struct {
+    uint32_t count;   // Number of periods
+    uint32_t period;  // In MCPWM ticks
+    bool     pulse;   // Each period ends with a step pulse
+    int      n_dirs;  // Direction pin changes, applied in the middle of a gap run
+    int      dir_pins[MAX_DIR_PINS];
+    int      dir_levels[MAX_DIR_PINS];
+} run_t;
+
+// Runs rendered but not yet loaded into the MCPWM timer
+static run_t    _runs[RUN_QUEUE];
+static uint32_t _head;
+static uint32_t _tail;
+
+static run_t _current;  // The run that the MCPWM timer is playing
+
+// Pulse accounting.  _owed is the pulses due in the current direction, less those
+// that have been emitted; it is negative after extra pulses.
+static uint32_t _loaded;      // Pulses loaded into the timer
+static uint32_t _counted;     // Pulses counted by PCNT
+static int16_t  _last_count;  // The last PCNT reading
+static int32_t  _owed;
+static uint32_t _last_period;  // Of the last run with pulses, for making up pulses
+
+// State of the event that pulse_func() is executing
+static bool     _rendering = false;
+static bool     _ev_pulse;
+static int      _ev_n_dirs;
+static int      _ev_dir_pins[MAX_DIR_PINS];
+static int      _ev_dir_levels[MAX_DIR_PINS];
+static uint32_t _period_ticks;  // From set_timer_ticks(), in stepping timer ticks
+
+static volatile bool _active   = false;  // The timer is running runs
+static volatile bool _stopping = false;  // Stepping has stopped; play out the queue and quit
+
+static portMUX_TYPE mcpwm_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline IRAM_ATTR uint32_t queued() {
+    return _tail - _head;
+}
+
+static IRAM_ATTR run_t* push_run(uint32_t count, uint32_t period, bool pulse) {
+    run_t* run  = &_runs[_tail++ % RUN_QUEUE];
+    run->count  = count;
+    run->period = period;
+    run->pulse  = pulse;
+    run->n_dirs = 0;
+    return run;
+}
+
+// Add one period to the last queued run if it matches, else queue a new run
+static IRAM_ATTR void add_period(uint32_t period, bool pulse) {
+    if (queued()) {
+        run_t* last = &_runs[(_tail - 1) % RUN_QUEUE];
+        if (!last->n_dirs && last->period == period && last->pulse == pulse && last->count < MAX_RUN_PULSES) {
+            ++last->count;
+            return;
+        }
+    }
+    push_run(1, period, pulse);
+}
+
+static IRAM_ATTR void render_event() {
+    if (_ev_n_dirs) {
+        run_t* gap  = push_run(1, _gap_ticks, false);
+        gap->n_dirs = _ev_n_dirs;
+        for (int i = 0; i < _ev_n_dirs; i++) {
+            gap->dir_pins[i]   = _ev_dir_pins[i];
+            gap->dir_levels[i] = _ev_dir_levels[i];
+        }
+    }
+    uint32_t period = _period_ticks / _ratio;
+    if (_ev_pulse && period < _min_period) {
+        period = _min_period;
+    }
+    if (period > max_period) {
+        // Too long for the timer; wait out most of it in shorter periods without pulses
+        uint32_t parts = (period + max_period - 1) / max_period;
+        uint32_t part  = period / parts;
+        for (uint32_t i = 1; i < parts; i++) {
+            add_period(part, false);
+        }
+        period -= part * (parts - 1);
+    }
+    add_period(period, _ev_pulse);
+}
+
+// Calls pulse_func() for the events of about BATCH_HORIZON_US, leaving room in the queue
+// for the runs that one event can add
+static IRAM_ATTR void render() {
+    uint32_t ticks = 0;
+    _rendering     = true;
+    while (!_stopping && ticks < _horizon && queued() < RUN_QUEUE - 4) {
+        _ev_pulse  = false;
+        _ev_n_dirs = 0;
+        bool more  = _pulse_func();
+        render_event();
+        ticks += _period_ticks / _ratio;
+        if (!more) {
+            _stopping = true;
+        }
+    }
+    _rendering = false;
+}
+
+// Loads a run into the shadow registers, to start when the current period ends
+static IRAM_ATTR void load_run(const run_t* run) {
+    mcpwm_ll_timer_set_peak(MCPWM_DEV, 0, run->period, false);
+    // The pulse ends at the end of the period; a compare value past it never matches
+    uint32_t compare = run->pulse ? run->period - _pulse_ticks : run->period;
+    mcpwm_ll_operator_set_compare_value(MCPWM_DEV, 0, 0, compare);
+    if (run->pulse) {
+        _loaded += run->count;
+        _last_period = run->period;
+    }
+    _current = *run;
+}
+
+static IRAM_ATTR void read_count() {
+    int16_t count;
+    pcnt_ll_get_counter_value(&PCNT, pcnt_unit, &count);
+    int32_t delta = count - _last_count;
+    if (delta < 0) {
+        delta += pcnt_limit;  // The counter returned to 0 at the limit
+    }
+    _last_count = count;
+    _counted += delta;
+}
+
+// Loads a run and arranges to interrupt again in the middle of its last period.  The
+// run starts when the period that is playing now ends, remaining MCPWM ticks from the
+// time, late stepping timer ticks after the interrupt, that the timer was read.
+static IRAM_ATTR uint32_t play(const run_t* run, uint32_t late, uint32_t remaining) {
+    load_run(run);
+    uint32_t alarm = late + (remaining + (run->count - 1) * run->period + run->period / 2) * _ratio;
+    stepTimerSetTicks(alarm);
+    return alarm;
+}
+
+static IRAM_ATTR void play_makeup(uint32_t late, uint32_t remaining) {
+    run_t makeup = { (uint32_t)_owed, _last_period, true, 0 };
+    _owed        = 0;
+    play(&makeup, late, remaining);
+}
+
+static bool IRAM_ATTR mcpwm_isr(void) {
+    // Where the MCPWM timer is in the period that is playing now
+    uint32_t late      = stepTimerGetTicks();
+    uint32_t remaining = _current.period - mcpwm_ll_timer_get_count_value(MCPWM_DEV, 0);
+
+    // All of the loaded pulses but the one at the end of this period should have been
+    // counted.  More means this interrupt came after the period it was meant for.
+    read_count();
+    uint32_t due   = _loaded - (_current.pulse ? 1 : 0);
+    int32_t  extra = (int32_t)(_counted - due);
+    if (extra) {
+        _owed -= extra;
+        _loaded += extra;
+    }
+
+    if (_current.n_dirs) {
+        // The middle of a gap, so the pulses in the old direction have ended
+        if (_owed > 0) {
+            // Make them up first, then come back to this gap
+            _runs[--_head % RUN_QUEUE] = _current;
+            play_makeup(late, remaining);
+            return true;
+        }
+        for (int i = 0; i < _current.n_dirs; i++) {
+            gpio_write(_current.dir_pins[i], _current.dir_levels[i]);
+        }
+        // Extra pulses in the old direction are owed in the new one
+        _owed = -_owed;
+    }
+
+    if (!queued() && !_stopping) {
+        // Only after a start; otherwise the queue is refilled after loading a run
+        render();
+    }
+
+    if (queued()) {
+        run_t* run = &_runs[_head++ % RUN_QUEUE];
+        if (run->pulse && _owed) {
+            int32_t n = (int32_t)run->count + _owed;
+            if (n <= 0) {
+                // Skip the pulses but keep the time
+                _owed      = n;
+                run->pulse = false;
+            } else {
+                _owed      = 0;
+                run->count = n;
+            }
+        }
+        uint32_t alarm = play(run, late, remaining);
+        if (!queued() && !_stopping) {
+            render();
+            // Rendering can outlast a short run.  If the interrupt time has passed,
+            // interrupt now; the count accounts for any extra pulses.
+            uint32_t soon = stepTimerGetTicks() + 10 * _ratio;
+            if (soon > alarm) {
+                stepTimerSetTicks(soon);
+            }
+        }
+        return true;
+    }
+
+    // Nothing left to play
+    if (_owed > 0) {
+        play_makeup(late, remaining);
+        return true;
+    }
+    run_t idle = { 1, idle_period, false, 0 };
+    load_run(&idle);
+    portENTER_CRITICAL_ISR(&mcpwm_mux);
+    _active   = false;
+    _stopping = false;
+    portEXIT_CRITICAL_ISR(&mcpwm_mux);
+    stepTimerStop();
+    return false;
+}
+
+static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_delay_us, uint32_t frequency, bool (*callback)(void)) {
+    _pulse_func = callback;
+    stepTimerInit(frequency, mcpwm_isr);
+    _dir_delay_us   = dir_delay_us;
+    _pulse_delay_us = pulse_delay_us;
+
+    _ratio       = frequency / mcpwm_hz;
+    _horizon     = mcpwm_hz / 1000000 * BATCH_HORIZON_US;
+    _pulse_ticks = _pulse_delay_us * (mcpwm_hz / 1000000);
+    _min_period  = 2 * _pulse_ticks;
+    // The direction changes in the middle of the gap, which must leave the direction
+    // delay before the next pulse and a pulse time after the last one
+    _gap_ticks = 2 * (_dir_delay_us + _pulse_delay_us + 5) * (mcpwm_hz / 1000000);
+    return _pulse_delay_us;
+}
+
+// Attach the step pin to the MCPWM output and to the PCNT input.  Only one is supported.
+static int init_step_pin(int step_pin, int step_inverted) {
+    if (_step_pin != -1) {
+        return -1;
+    }
+    _step_pin      = step_pin;
+    _step_inverted = step_inverted;
+
+    // Count the leading edges of the step pulses
+    pcnt_config_t pcnt    = {};
+    pcnt.pulse_gpio_num   = step_pin;
+    pcnt.ctrl_gpio_num    = PCNT_PIN_NOT_USED;
+    pcnt.lctrl_mode       = PCNT_MODE_KEEP;
+    pcnt.hctrl_mode       = PCNT_MODE_KEEP;
+    pcnt.pos_mode         = step_inverted ? PCNT_COUNT_DIS : PCNT_COUNT_INC;
+    pcnt.neg_mode         = step_inverted ? PCNT_COUNT_INC : PCNT_COUNT_DIS;
+    pcnt.counter_h_lim    = pcnt_limit;
+    pcnt.counter_l_lim    = 0;
+    pcnt.unit             = pcnt_unit;
+    pcnt.channel          = PCNT_CHANNEL_0;
+    pcnt_unit_config(&pcnt);
+    pcnt_counter_clear(pcnt_unit);
+    pcnt_counter_resume(pcnt_unit);
+
+    // The timer counts up from 0 to the period, and the generator pulses from the
+    // compare value to the end of the period.  New periods and compare values take
+    // effect when the timer returns to 0.
+    mcpwm_gpio_init(MCPWM_UNIT_0, MCPWM0A, step_pin);
+    mcpwm_group_set_resolution(MCPWM_UNIT_0, 80000000);
+    mcpwm_timer_set_resolution(MCPWM_UNIT_0, MCPWM_TIMER_0, mcpwm_hz);
+
+    mcpwm_config_t config = {};
+    config.frequency      = mcpwm_hz / idle_period;
+    config.cmpr_a         = 0;
+    config.cmpr_b         = 0;
+    config.counter_mode   = MCPWM_UP_COUNTER;
+    config.duty_mode      = MCPWM_DUTY_MODE_0;
+    mcpwm_init(MCPWM_UNIT_0, MCPWM_TIMER_0, &config);
+
+    int lead  = step_inverted ? MCPWM_ACTION_FORCE_LOW : MCPWM_ACTION_FORCE_HIGH;
+    int trail = step_inverted ? MCPWM_ACTION_FORCE_HIGH : MCPWM_ACTION_FORCE_LOW;
+    mcpwm_ll_generator_reset_actions(MCPWM_DEV, 0, 0);
+    mcpwm_ll_generator_set_action_on_compare_event(MCPWM_DEV, 0, 0, MCPWM_TIMER_DIRECTION_UP, 0, lead);
+    mcpwm_ll_generator_set_action_on_timer_event(MCPWM_DEV, 0, 0, MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_PEAK, trail);
+    mcpwm_ll_timer_enable_update_period_on_tez(MCPWM_DEV, 0, true);
+    mcpwm_ll_operator_enable_update_compare_on_tez(MCPWM_DEV, 0, 0, true);
+
+    run_t idle = { 1, idle_period, false, 0 };
+    load_run(&idle);
+    _loaded = 0;
+
+    // Both peripherals use the pin, so it is an output that can also be read
+    gpio_set_direction((gpio_num_t)step_pin, GPIO_MODE_INPUT_OUTPUT);
+    return 0;
+}
+
+// Direction changes wait for a gap between runs
+static IRAM_ATTR void set_dir_pin(int pin, int level) {
+    if (!_rendering) {
+        gpio_write(pin, level);
+        return;
+    }
+    if (_ev_n_dirs < MAX_DIR_PINS) {
+        _ev_dir_pins[_ev_n_dirs]     = pin;
+        _ev_dir_levels[_ev_n_dirs++] = level;
+    }
+}
+
+// The direction delay is part of the gap
+static IRAM_ATTR void finish_dir() {}
+
+// No need for any common setup before setting step pins
+static IRAM_ATTR void start_step() {}
+
+// Mark the current event as one with a pulse
+static IRAM_ATTR void set_step_pin(int pin, int level) {
+    if (pin == 0) {
+        _ev_pulse = true;
+    }
+}
+
+// This is a noop because the MCPWM timer does everything
+static IRAM_ATTR void finish_step() {}
+
+// The MCPWM generator ends the pulses.
+// Return 1 (true) to tell Stepping.cpp that it can
+// skip the rest of the step pin deassertion process
+static IRAM_ATTR int start_unstep() {
+    return 1;
+}
+
+// This is a noop and will not be called because start_unstep()
+// returns 1
+static IRAM_ATTR void finish_unstep() {}
+
+static uint32_t max_pulses_per_sec() {
+    return 1000000 / (2 * _pulse_delay_us);
+}
+
+static void IRAM_ATTR set_timer_ticks(uint32_t ticks) {
+    _period_ticks = ticks;
+}
+
+static void IRAM_ATTR start_timer() {
+    portENTER_CRITICAL_SAFE(&mcpwm_mux);
+    _stopping  = false;
+    bool start = !_active;
+    _active    = true;
+    portEXIT_CRITICAL_SAFE(&mcpwm_mux);
+    if (start) {
+        // The timer plays idle periods while stepping is stopped, so the first
+        // interrupt finds it in one
+        _head = _tail = 0;
+        mcpwm_ll_timer_set_execute_command(MCPWM_DEV, 0, MCPWM_TIMER_START_NO_STOP);
+        stepTimerStart();
+    }
+}
+
+// From pulse_func(), let the queued runs play out.  From anywhere else, as for
+// a reset, discard them and stop at the end of the period that is playing.
+static void IRAM_ATTR stop_timer() {
+    if (_rendering) {
+        _stopping = true;
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&mcpwm_mux);
+    stepTimerStop();
+    mcpwm_ll_timer_set_execute_command(MCPWM_DEV, 0, MCPWM_TIMER_STOP_AT_ZERO);
+    run_t idle = { 1, idle_period, false, 0 };
+    load_run(&idle);
+    _head = _tail = 0;
+    _owed         = 0;
+    _loaded       = _counted;
+    _stopping     = false;
+    _active       = false;
+    portEXIT_CRITICAL_SAFE(&mcpwm_mux);
+}
+
+// clang-format off
+static step_engine_t engine = {
+    "MCPWM",
+    init_engine,
+    init_step_pin,
+    set_dir_pin,
+    finish_dir,
+    start_step,
+    set_step_pin,
+    finish_step,
+    start_unstep,
+    finish_unstep,
+    max_pulses_per_sec,
+    set_timer_ticks,
+    start_timer,
+    stop_timer
+};
+
+REGISTER_STEP_ENGINE(MCPWM, &engine);
@@ -0,0 +1,115 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// PC sampling with the two timers of timer group 1, one per core, using the
+// timer_ll API from ESP-IDF v4.4.  Timer group 0 timer 0 is the step timer.
+
+#include "Driver/pc_sampler.h"
+
+#include "hal/timer_ll.h"
+#include "esp_intr_alloc.h"
+#include "esp_ipc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/xtensa_context.h"
+
+static const uint32_t fTimers = 80000000;  // the frequency of ESP32 timers
+static const uint32_t fCount  = 1000000;   // the counters tick in microseconds
+
+struct sample_ring_t {
+    pc_sample_t*    samples;
+    volatile size_t count;
+    size_t          size;
+    intr_handle_t   handle;
+};
+static sample_ring_t rings[2];
+
+static void IRAM_ATTR sampler_isr(void* arg) {
+    int         core  = xPortGetCoreID();
+    timer_idx_t timer = timer_idx_t(core);
+    timer_ll_clear_intr_status(&TIMERG1, timer);
+    timer_ll_set_alarm_enable(&TIMERG1, timer, true);
+
+    sample_ring_t& ring = rings[core];
+    if (ring.count < ring.size) {
+        // On entry to the first level of interrupt, the FreeRTOS port saves the interrupted
+        // context on the stack of the running task and points pxTopOfStack, the first member
+        // of the task control block, at it.  A sample taken while another interrupt handler
+        // runs gets the PC of the task that it interrupted.
+        TaskHandle_t task = xTaskGetCurrentTaskHandleForCPU(core);
+        uint32_t     pc   = 0;
+        if (task) {
+            XtExcFrame* frame = *reinterpret_cast<XtExcFrame**>(task);
+            pc                = frame->pc;
+        }
+        ring.samples[ring.count] = { pc, task };
+        ring.count               = ring.count + 1;
+    }
+}
+
+// Runs on the core whose timer it sets up, since an interrupt is allocated on the calling core
+static void start_on_core(void* arg) {
+    uint32_t    ticks = *static_cast<uint32_t*>(arg);
+    int         core  = xPortGetCoreID();
+    timer_idx_t timer = timer_idx_t(core);
+
+    timer_ll_intr_disable(&TIMERG1, timer);
+    timer_ll_set_counter_enable(&TIMERG1, timer, false);
+    timer_ll_set_divider(&TIMERG1, timer, fTimers / fCount);
+    timer_ll_set_counter_increase(&TIMERG1, timer, true);
+    timer_ll_set_counter_value(&TIMERG1, timer, 0);
+    timer_ll_set_auto_reload(&TIMERG1, timer, true);
+    timer_ll_set_alarm_value(&TIMERG1, timer, ticks);
+    timer_ll_clear_intr_status(&TIMERG1, timer);
+
+    int irq = core ? timer_group_periph_signals.groups[TIMER_GROUP_1].t1_irq_id : timer_group_periph_signals.groups[TIMER_GROUP_1].t0_irq_id;
+    esp_intr_alloc_intrstatus(irq,
+                              ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL1,
+                              timer_ll_get_intr_status_reg(&TIMERG1),
+                              1 << timer,
+                              sampler_isr,
+                              NULL,
+                              &rings[core].handle);
+
+    timer_ll_intr_enable(&TIMERG1, timer);
+    timer_ll_set_alarm_enable(&TIMERG1, timer, true);
+    timer_ll_set_counter_enable(&TIMERG1, timer, true);
+}
+
+static void stop_on_core(void* arg) {
+    int         core  = xPortGetCoreID();
+    timer_idx_t timer = timer_idx_t(core);
+    timer_ll_set_counter_enable(&TIMERG1, timer, false);
+    timer_ll_set_alarm_enable(&TIMERG1, timer, false);
+    timer_ll_intr_disable(&TIMERG1, timer);
+    if (rings[core].handle) {
+        esp_intr_free(rings[core].handle);
+        rings[core].handle = nullptr;
+    }
+}
+
+bool pc_sampler_start(uint32_t frequency, pc_sample_t* buffer, size_t n_samples) {
+    if (rings[0].handle || rings[1].handle || frequency == 0) {
+        return false;
+    }
+    uint32_t ticks = fCount / frequency;
+    size_t   half  = n_samples / 2;
+    for (int core = 0; core < 2; core++) {
+        rings[core].samples = buffer + core * half;
+        rings[core].size    = half;
+        rings[core].count   = 0;
+        if (esp_ipc_call_blocking(core, start_on_core, &ticks) != ESP_OK || !rings[core].handle) {
+            size_t counts[2];
+            pc_sampler_stop(counts);
+            return false;
+        }
+    }
+    return true;
+}
+
+void pc_sampler_stop(size_t counts[2]) {
+    for (int core = 0; core < 2; core++) {
+        esp_ipc_call_blocking(core, stop_on_core, NULL);
+        counts[core] = rings[core].count;
+    }
+}
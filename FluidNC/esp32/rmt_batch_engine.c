@@ -0,0 +1,363 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Stepping engine that uses the ESP32 RMT hardware like the RMT engine, but encodes
+// a batch of step pulses per channel into the RMT memory at once, so the step timer
+// interrupts once per batch instead of once per step event.
+//
+// Each timer interrupt starts the batch that was rendered by the previous interrupt,
+// then calls pulse_func() repeatedly to render the next one, advancing a virtual time
+// by the timer period that pulse_func() sets for each event.  The pulses that Stepping
+// asserts for each event become RMT items, timed from the start of the batch, in a RAM
+// staging area; starting a batch copies them to the RMT memory blocks and starts all of
+// the channels together.  The step timer is set to the length of the batch.
+//
+// A batch ends when it spans BATCH_HORIZON_US, when a channel's memory block is full,
+// when stepping stops, or at an event that changes a direction pin after pulses have
+// been queued.  Direction pins are GPIOs, so their changes wait for the start of the
+// next batch and the pulses of that event follow after the direction delay.
+//
+// Step pulses reach the pins up to two batches after pulse_func() computes them.
+
+#include "Driver/step_engine.h"
+#include "Driver/fluidnc_gpio.h"
+#include "Driver/StepTimer.h"
+#include <driver/rmt.h>
+#include <soc/rmt_struct.h>
+#include <esp32-hal-gpio.h>
+#include <esp_attr.h>  // IRAM_ATTR
+
+#include <freertos/FreeRTOS.h>
+
+#define BATCH_HORIZON_US 500
+#define BATCH_ITEMS (SOC_RMT_MEM_WORDS_PER_CHANNEL - 1)  // Less one for the end marker
+#define MAX_DIR_PINS 16
+
+static const uint32_t rmt_ticks_per_us = 4;  // APB 80 MHz / clk_div 20
+
+static uint32_t _pulse_delay_us;
+static uint32_t _dir_delay_us;
+
+static bool (*_pulse_func)(void);
+
+static uint32_t _ticks_per_rmt;  // Stepping timer ticks per RMT tick
+static uint32_t _horizon_ticks;  // BATCH_HORIZON_US in stepping timer ticks
+static uint32_t _pulse_rmt;      // Pulse length in RMT ticks
+static uint32_t _dir_rmt;        // Direction delay in RMT ticks
+
+static int      _n_channels = 0;
+static uint32_t _idle_level[RMT_CHANNEL_MAX];
+
+// The batch being rendered, then staged until the next interrupt starts it
+static rmt_item32_t _items[RMT_CHANNEL_MAX][BATCH_ITEMS];
+static uint32_t     _n_items[RMT_CHANNEL_MAX];
+static uint32_t     _last_end[RMT_CHANNEL_MAX];  // End of the last pulse per channel in RMT ticks
+static uint32_t     _max_items;
+static int          _dir_pins[MAX_DIR_PINS];
+static int          _dir_levels[MAX_DIR_PINS];
+static int          _n_dirs;
+static uint32_t     _batch_ticks;  // Length of the staged batch in stepping timer ticks
+static bool         _staged = false;
+
+// State of the event that pulse_func() is executing
+static bool     _rendering = false;
+static uint32_t _event_ticks;   // Time of the event from the start of the batch
+static uint32_t _period_ticks;  // Time to the next event, from set_timer_ticks()
+static uint32_t _lead_rmt;      // Direction delay before this event's pulses
+
+// An event that changed direction pins after the batch had pulses; it starts the next batch
+static bool     _deferring = false;
+static bool     _deferred  = false;
+static int      _next_dir_pins[MAX_DIR_PINS];
+static int      _next_dir_levels[MAX_DIR_PINS];
+static int      _n_next_dirs;
+static uint32_t _next_step_mask;
+static uint32_t _next_period_ticks;
+
+static volatile bool _active   = false;  // The timer is running batches
+static volatile bool _stopping = false;  // Stepping has stopped; start the staged batch and quit
+
+static portMUX_TYPE batch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR start_channel(int ch) {
+#ifdef CONFIG_IDF_TARGET_ESP32
+    RMT.conf_ch[ch].conf1.mem_rd_rst = 1;
+    RMT.conf_ch[ch].conf1.mem_rd_rst = 0;
+    RMT.conf_ch[ch].conf1.tx_start   = 1;
+#endif
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+    RMT.chnconf0[ch].mem_rd_rst_n = 1;
+    RMT.chnconf0[ch].mem_rd_rst_n = 0;
+    RMT.chnconf0[ch].tx_start_n   = 1;
+#endif
+}
+
+static void IRAM_ATTR queue_pulse(int ch, uint32_t t) {
+    uint32_t n = _n_items[ch];
+    if (n == BATCH_ITEMS) {
+        return;  // Cannot happen; batches end before a block fills
+    }
+    uint32_t gap = t > _last_end[ch] ? t - _last_end[ch] : 1;
+
+    rmt_item32_t* item = &_items[ch][n];
+    item->duration0    = gap;
+    item->level0       = _idle_level[ch];
+    item->duration1    = _pulse_rmt;
+    item->level1       = !_idle_level[ch];
+
+    _last_end[ch] += gap + _pulse_rmt;
+    if (++n > _max_items) {
+        _max_items = n;
+    }
+    _n_items[ch] = n;
+}
+
+static void IRAM_ATTR start_staged() {
+    for (int i = 0; i < _n_dirs; i++) {
+        gpio_write(_dir_pins[i], _dir_levels[i]);
+    }
+    for (int ch = 0; ch < _n_channels; ch++) {
+        uint32_t n = _n_items[ch];
+        if (n) {
+            volatile rmt_item32_t* mem = RMTMEM.chan[ch].data32;
+            for (uint32_t i = 0; i < n; i++) {
+                mem[i].val = _items[ch][i].val;
+            }
+            mem[n].val = 0;
+        }
+    }
+    for (int ch = 0; ch < _n_channels; ch++) {
+        if (_n_items[ch]) {
+            start_channel(ch);
+        }
+    }
+    stepTimerSetTicks(_batch_ticks);
+    _staged = false;
+}
+
+static void IRAM_ATTR render_batch() {
+    for (int ch = 0; ch < _n_channels; ch++) {
+        _n_items[ch]  = 0;
+        _last_end[ch] = 0;
+    }
+    _max_items   = 0;
+    _n_dirs      = 0;
+    _event_ticks = 0;
+
+    if (_deferred) {
+        // The event that ended the previous batch begins this one
+        for (int i = 0; i < _n_next_dirs; i++) {
+            _dir_pins[i]   = _next_dir_pins[i];
+            _dir_levels[i] = _next_dir_levels[i];
+        }
+        _n_dirs = _n_next_dirs;
+        for (int ch = 0; ch < _n_channels; ch++) {
+            if (_next_step_mask & (1 << ch)) {
+                queue_pulse(ch, _dir_rmt);
+            }
+        }
+        _event_ticks = _next_period_ticks;
+        _deferred    = false;
+    }
+
+    _rendering = true;
+    while (true) {
+        _lead_rmt  = 0;
+        _deferring = false;
+        bool more  = _pulse_func();
+        if (_deferring) {
+            _next_period_ticks = _period_ticks;
+            _deferred          = true;
+            break;
+        }
+        _event_ticks += _period_ticks;
+        if (!more || _stopping || _event_ticks >= _horizon_ticks || _max_items == BATCH_ITEMS) {
+            break;
+        }
+    }
+    _rendering = false;
+
+    _batch_ticks = _event_ticks;
+    _staged      = true;
+}
+
+static bool IRAM_ATTR batch_isr(void) {
+    if (!_staged) {
+        // Either the last batch has played out after stepping stopped, or this is
+        // the first interrupt after start_timer() and nothing is playing yet.
+        portENTER_CRITICAL_ISR(&batch_mux);
+        bool stop = _stopping;
+        if (stop) {
+            _active   = false;
+            _stopping = false;
+            _deferred = false;
+        }
+        portEXIT_CRITICAL_ISR(&batch_mux);
+        if (stop) {
+            stepTimerStop();
+            return false;
+        }
+        render_batch();
+    }
+    start_staged();
+    if (!_stopping) {
+        render_batch();
+    }
+    return true;
+}
+
+static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_delay_us, uint32_t frequency, bool (*callback)(void)) {
+    _pulse_func = callback;
+    stepTimerInit(frequency, batch_isr);
+    _dir_delay_us   = dir_delay_us;
+    _pulse_delay_us = pulse_delay_us;
+
+    _ticks_per_rmt = frequency / (rmt_ticks_per_us * 1000000);
+    _horizon_ticks = frequency / 1000000 * BATCH_HORIZON_US;
+    _pulse_rmt     = _pulse_delay_us * rmt_ticks_per_us;
+    _dir_rmt       = _dir_delay_us * rmt_ticks_per_us;
+    _period_ticks  = _horizon_ticks;
+    return _pulse_delay_us;
+}
+
+// Allocate an RMT channel with one memory block and attach the step_pin GPIO to it.
+// Return the index of that RMT channel which will be presented to set_step_pin() later.
+static int init_step_pin(int step_pin, int step_inverted) {
+    if (_n_channels == RMT_CHANNEL_MAX) {
+        return -1;
+    }
+    rmt_channel_t rmt_chan_num = (rmt_channel_t)_n_channels++;
+
+    rmt_config_t rmtConfig = { .rmt_mode      = RMT_MODE_TX,
+                               .channel       = rmt_chan_num,
+                               .gpio_num      = (gpio_num_t)step_pin,
+                               .clk_div       = 20,
+                               .mem_block_num = 1,
+                               .flags         = 0,
+                               .tx_config     = {
+                                       .carrier_freq_hz      = 0,
+                                       .carrier_level        = RMT_CARRIER_LEVEL_LOW,
+                                       .idle_level           = step_inverted ? RMT_IDLE_LEVEL_HIGH : RMT_IDLE_LEVEL_LOW,
+                                       .carrier_duty_percent = 50,
+#if SOC_RMT_SUPPORT_TX_LOOP_COUNT
+                                   .loop_count = 1,
+#endif
+                                   .carrier_en     = false,
+                                   .loop_en        = false,
+                                   .idle_output_en = true,
+                               } };
+
+    _idle_level[rmt_chan_num] = rmtConfig.tx_config.idle_level;
+    rmt_config(&rmtConfig);
+    return (int)rmt_chan_num;
+}
+
+// Direction changes apply at the start of a batch, before any of its pulses
+static IRAM_ATTR void set_dir_pin(int pin, int level) {
+    if (!_rendering) {
+        gpio_write(pin, level);
+        return;
+    }
+    if (_max_items == 0 && !_deferring) {
+        if (_n_dirs < MAX_DIR_PINS) {
+            _dir_pins[_n_dirs]     = pin;
+            _dir_levels[_n_dirs++] = level;
+        }
+        return;
+    }
+    if (!_deferring) {
+        _deferring      = true;
+        _n_next_dirs    = 0;
+        _next_step_mask = 0;
+    }
+    if (_n_next_dirs < MAX_DIR_PINS) {
+        _next_dir_pins[_n_next_dirs]     = pin;
+        _next_dir_levels[_n_next_dirs++] = level;
+    }
+}
+
+static IRAM_ATTR void finish_dir() {
+    _lead_rmt = _dir_rmt;
+}
+
+// No need for any common setup before setting step pins
+static IRAM_ATTR void start_step() {}
+
+// Queue a pulse on the channel at the time of the current event
+static IRAM_ATTR void set_step_pin(int pin, int level) {
+    if (_deferring) {
+        _next_step_mask |= 1 << pin;
+        return;
+    }
+    queue_pulse(pin, _event_ticks / _ticks_per_rmt + _lead_rmt);
+}
+
+// This is a noop because the RMT channels do everything
+static IRAM_ATTR void finish_step() {}
+
+// The RMT channels take care of the pulse trailing edges.
+// Return 1 (true) to tell Stepping.cpp that it can
+// skip the rest of the step pin deassertion process
+static IRAM_ATTR int start_unstep() {
+    return 1;
+}
+
+// This is a noop and will not be called because start_unstep()
+// returns 1
+static IRAM_ATTR void finish_unstep() {}
+
+static uint32_t max_pulses_per_sec() {
+    uint32_t pps = 1000000 / (2 * _pulse_delay_us + _dir_delay_us);
+    return pps;
+}
+
+static void IRAM_ATTR set_timer_ticks(uint32_t ticks) {
+    _period_ticks = ticks;
+}
+
+static void IRAM_ATTR start_timer() {
+    portENTER_CRITICAL_SAFE(&batch_mux);
+    _stopping  = false;
+    bool start = !_active;
+    _active    = true;
+    portEXIT_CRITICAL_SAFE(&batch_mux);
+    if (start) {
+        stepTimerStart();
+    }
+}
+
+// From pulse_func(), let the batch being rendered play out.  From anywhere else, as for
+// a reset, discard the staged batch and stop at once.
+static void IRAM_ATTR stop_timer() {
+    if (_rendering) {
+        _stopping = true;
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&batch_mux);
+    stepTimerStop();
+    _staged   = false;
+    _deferred = false;
+    _stopping = false;
+    _active   = false;
+    portEXIT_CRITICAL_SAFE(&batch_mux);
+}
+
+// clang-format off
+static step_engine_t engine = {
+    "RMT_BATCH",
+    init_engine,
+    init_step_pin,
+    set_dir_pin,
+    finish_dir,
+    start_step,
+    set_step_pin,
+    finish_step,
+    start_unstep,
+    finish_unstep,
+    max_pulses_per_sec,
+    set_timer_ticks,
+    start_timer,
+    stop_timer
+};
+
+REGISTER_STEP_ENGINE(RMT_BATCH, &engine);
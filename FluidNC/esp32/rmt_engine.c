@@ -3,21 +3,37 @@
 
 // Stepping engine that uses the ESP32 RMT hardware to time step pulses, thus avoiding
 // the need to wait for the end of step pulses.
+//
+// The engine also takes runs of evenly spaced pulses, which it writes into the channel
+// memory as a sequence of items, so a run of up to RUN_ITEMS pulses costs one interrupt.
+// A run replaces the single pulse item, which the next step pulse puts back.
 
 #include "Driver/step_engine.h"
 #include "Driver/fluidnc_gpio.h"
 #include "Driver/StepTimer.h"
 #include <driver/rmt.h>
+#include <soc/rmt_struct.h>
 #include <esp32-hal-gpio.h>
 #include <esp_attr.h>  // IRAM_ATTR
 
+// Runs use the first memory block of a channel, less one item for the end marker,
+// because the second block of a channel is the first block of the next channel
+#define RUN_ITEMS (SOC_RMT_MEM_WORDS_PER_CHANNEL - 1)
+
+static const uint32_t rmt_ticks_per_us = 4;  // APB 80 MHz / clk_div 20
+
 static uint32_t _pulse_delay_us;
 static uint32_t _dir_delay_us;
+static uint32_t _ticks_per_rmt;  // Stepping timer ticks per RMT tick
+
+static rmt_item32_t _pulse_item[RMT_CHANNEL_MAX];  // The single pulse of a step
+static bool         _in_run[RMT_CHANNEL_MAX];      // The channel memory holds a run
 
 static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_delay_us, uint32_t frequency, bool (*callback)(void)) {
     stepTimerInit(frequency, callback);
     _dir_delay_us   = dir_delay_us;
     _pulse_delay_us = pulse_delay_us;
+    _ticks_per_rmt  = frequency / (rmt_ticks_per_us * 1000000);
     return _pulse_delay_us;
 }
 
@@ -62,6 +78,7 @@ static int init_step_pin(int step_pin, int step_inverted) {
     rmtItem[0].level1 = !rmtConfig.tx_config.idle_level;
     rmt_config(&rmtConfig);
     rmt_fill_tx_items(rmtConfig.channel, &rmtItem[0], rmtConfig.mem_block_num, 0);
+    _pulse_item[rmt_chan_num] = rmtItem[0];
     return (int)rmt_chan_num;
 }
 
@@ -76,21 +93,31 @@ static IRAM_ATTR void finish_dir() {}
 // No need for any common setup before setting step pins
 static IRAM_ATTR void start_step() {}
 
-// Restart the RMT which has already been configured
-// for the desired pulse length, polarity, and direction delay
-static IRAM_ATTR void set_step_pin(int pin, int level) {
+static IRAM_ATTR void start_channel(int ch) {
 #ifdef CONFIG_IDF_TARGET_ESP32
-    RMT.conf_ch[pin].conf1.mem_rd_rst = 1;
-    RMT.conf_ch[pin].conf1.mem_rd_rst = 0;
-    RMT.conf_ch[pin].conf1.tx_start   = 1;
+    RMT.conf_ch[ch].conf1.mem_rd_rst = 1;
+    RMT.conf_ch[ch].conf1.mem_rd_rst = 0;
+    RMT.conf_ch[ch].conf1.tx_start   = 1;
 #endif
 #ifdef CONFIG_IDF_TARGET_ESP32S3
-    RMT.chnconf0[pin].mem_rd_rst_n = 1;
-    RMT.chnconf0[pin].mem_rd_rst_n = 0;
-    RMT.chnconf0[pin].tx_start_n   = 1;
+    RMT.chnconf0[ch].mem_rd_rst_n = 1;
+    RMT.chnconf0[ch].mem_rd_rst_n = 0;
+    RMT.chnconf0[ch].tx_start_n   = 1;
 #endif
 }
 
+// Restart the RMT which has already been configured
+// for the desired pulse length, polarity, and direction delay
+static IRAM_ATTR void set_step_pin(int pin, int level) {
+    if (_in_run[pin]) {
+        volatile rmt_item32_t* mem = RMTMEM.chan[pin].data32;
+        mem[0].val                 = _pulse_item[pin].val;
+        mem[1].val                 = 0;
+        _in_run[pin]               = false;
+    }
+    start_channel(pin);
+}
+
 // This is a noop because the RMT channels do everything
 static IRAM_ATTR void finish_step() {}
 
@@ -127,6 +154,42 @@ static void IRAM_ATTR stop_timer() {
     stepTimerStop();
 }
 
+// The durations of RMT items are 15 bits, and each pulse must end, and the
+// direction delay elapse, before the next pulse starts
+static uint32_t IRAM_ATTR max_run(uint32_t ticks) {
+    uint32_t period = ticks / _ticks_per_rmt;
+    if (period > 32767 || period <= _pulse_delay_us * rmt_ticks_per_us || period < _dir_delay_us * rmt_ticks_per_us) {
+        return 0;
+    }
+    return RUN_ITEMS;
+}
+
+// The run's pulses are rounded down to RMT ticks apart, so the run ends
+// before the step timer's next event
+static void IRAM_ATTR set_run_pin(int pin, uint32_t count, uint32_t ticks) {
+    if (pin < 0) {
+        return;
+    }
+    volatile rmt_item32_t* mem = RMTMEM.chan[pin].data32;
+    if (count == 0) {
+        if (_in_run[pin]) {
+            // Send the end marker next
+            mem[0].val = 0;
+            start_channel(pin);
+        }
+        return;
+    }
+    rmt_item32_t item = _pulse_item[pin];
+    uint32_t     gap  = ticks / _ticks_per_rmt - item.duration1;
+    for (uint32_t i = 0; i < count; i++) {
+        item.duration0 = i ? gap : gap + item.duration1;
+        mem[i].val     = item.val;
+    }
+    mem[count].val = 0;
+    _in_run[pin]   = true;
+    start_channel(pin);
+}
+
 // clang-format off
 static step_engine_t engine = {
     "RMT",
@@ -142,7 +205,9 @@ static step_engine_t engine = {
     max_pulses_per_sec,
     set_timer_ticks,
     start_timer,
-    stop_timer
+    stop_timer,
+    max_run,
+    set_run_pin
 };
 
 REGISTER_STEP_ENGINE(RMT, &engine);
@@ -197,6 +197,11 @@ void sd_unmount() {
     card = NULL;
 }
 
+// cppcheck-suppress unusedFunction
+uint32_t sd_card_id() {
+    return card ? uint32_t(card->cid.serial) : 0;
+}
+
 // cppcheck-suppress unusedFunction
 void sd_deinit_slot() {
     sdspi_host_remove_device(host_config.slot);
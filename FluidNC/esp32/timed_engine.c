@@ -2,12 +2,17 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 // Stepping engine that uses direct GPIO accesses timed by spin loops.
+//
+// Pin changes are collected into per-bank set and clear masks and committed
+// with one write to each of the W1TS/W1TC registers, so all of the step pins
+// of an event change together instead of one after another.
 
 #include "Driver/step_engine.h"
 #include "Driver/fluidnc_gpio.h"
 #include "Driver/delay_usecs.h"
 #include "Driver/StepTimer.h"
 #include <esp32-hal-gpio.h>
+#include <soc/gpio_struct.h>
 #include <esp_attr.h>  // IRAM_ATTR
 
 static uint32_t _pulse_delay_us;
@@ -26,11 +31,43 @@ static int init_step_pin(int step_pin, int step_invert) {
 
 static int _stepPulseEndTime;
 
+// Pending changes for GPIOs 0-31 and 32-39
+static uint32_t _set_mask[2];
+static uint32_t _clear_mask[2];
+
 static void IRAM_ATTR set_pin(int pin, int level) {
-    gpio_write(pin, level);
+    int      bank = pin >> 5;
+    uint32_t mask = 1u << (pin & 31);
+    if (level) {
+        _set_mask[bank] |= mask;
+        _clear_mask[bank] &= ~mask;
+    } else {
+        _clear_mask[bank] |= mask;
+        _set_mask[bank] &= ~mask;
+    }
+}
+
+static void IRAM_ATTR commit_pins() {
+    if (_set_mask[0]) {
+        GPIO.out_w1ts = _set_mask[0];
+        _set_mask[0]  = 0;
+    }
+    if (_clear_mask[0]) {
+        GPIO.out_w1tc  = _clear_mask[0];
+        _clear_mask[0] = 0;
+    }
+    if (_set_mask[1]) {
+        GPIO.out1_w1ts.val = _set_mask[1];
+        _set_mask[1]       = 0;
+    }
+    if (_clear_mask[1]) {
+        GPIO.out1_w1tc.val = _clear_mask[1];
+        _clear_mask[1]     = 0;
+    }
 }
 
 static void IRAM_ATTR finish_dir() {
+    commit_pins();
     delay_us(_dir_delay_us);
 }
 
@@ -41,6 +78,7 @@ static void IRAM_ATTR start_step() {}
 // some work that is overlapped with the pulse time.  The spin loop
 // will happen in start_unstep()
 static void IRAM_ATTR finish_step() {
+    commit_pins();
     _stepPulseEndTime = usToEndTicks(_pulse_delay_us);
 }
 
@@ -49,9 +87,9 @@ static int IRAM_ATTR start_unstep() {
     return 0;
 }
 
-// This is a noop because each gpio_write() takes effect immediately,
-// so there is no need to commit multiple GPIO changes.
-static void IRAM_ATTR finish_unstep() {}
+static void IRAM_ATTR finish_unstep() {
+    commit_pins();
+}
 
 static uint32_t max_pulses_per_sec() {
     return 1000000 / (2 * _pulse_delay_us);
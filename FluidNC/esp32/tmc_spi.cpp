@@ -21,12 +21,12 @@
 // interface, which is basically direct access to the hardware registers
 // wrapped up to look like function calls (implemented as inlines, so
 // the compiler generates very compact code).  There are two downsides
-// to this method, neither of which really matter in our situation.
-// The first is that there is no locking to prevent this code from
-// interfering with SD card access that is already in progress.  That
-// is not a problem because TMC device access and SD Card access never
-// happen simultaneously.  The second is that the code polls for completion
-// without letting other tasks run.  That is not a problem because TMC
+// to this method.  The first is that the driver does not know about these
+// accesses, so they take the bus from it with tmc_spi_bus_acquire(), which
+// waits for an SD card or Ethernet transaction in progress to finish and
+// holds off new ones until tmc_spi_bus_release().  The second is that
+// the code polls for completion without letting other tasks run.  That
+// is not a problem because TMC
 // register access was effectively a blocking operation anyway, so it
 // doesn't matter whether it blocks at a low or high level of abstraction.
 // The time for a register access is less than 70 us for an I2SO CS pin
@@ -38,22 +38,112 @@
 #include "src/Config.h"
 #include "esp32/tmc_spi_support.h"
 #include <TMCStepper.h>  // https://github.com/teemuatlut/TMCStepper
+#include <vector>
+
+// Chain batching.  Every access to a daisy-chained TMC shifts a frame
+// through the whole chain, but only the target device gets a command;
+// the rest see zeros, which read GCONF harmlessly.  Between
+// tmc_spi_chain_begin() and tmc_spi_chain_end(), writes to chained
+// devices are queued per device instead, and the queues are sent as
+// chain-length frames that carry the next write for every device at
+// once.  Setting up six drivers then takes as many frames as the
+// longest queue instead of the sum of all of them.  The writes to each
+// device keep their order.  A read sends the queued writes first, so
+// it always sees their effect.
+//
+// The frame must fit the 64-byte SPI data buffer, so longer chains are
+// not batched.
+static const int max_chain = 12;
+
+struct PendingWrite {
+    uint8_t  reg;
+    uint32_t data;
+};
+
+static bool                      chain_batching = false;
+static int                       chain_devices  = 0;
+static uint16_t                  chain_cs       = 0;
+static std::vector<PendingWrite> chain_pending[max_chain + 1];  // Indexed by link_index
+
+static void put_packet(uint8_t* out, uint8_t cmd, uint32_t data) {
+    out[0] = cmd;
+    out[1] = data >> 24;
+    out[2] = data >> 16;
+    out[3] = data >> 8;
+    out[4] = data >> 0;
+}
+
+void tmc_spi_chain_begin() {
+    chain_batching = true;
+}
+
+static void chain_flush() {
+    size_t slots = 0;
+    for (int index = 1; index <= chain_devices; ++index) {
+        if (chain_pending[index].size() > slots) {
+            slots = chain_pending[index].size();
+        }
+    }
+    if (slots == 0) {
+        return;
+    }
+
+    const size_t packetLen   = 5;
+    size_t       total_bytes = chain_devices * packetLen;
+    uint8_t      out[max_chain * packetLen];
+
+    tmc_spi_bus_acquire();
+    for (size_t slot = 0; slot < slots; ++slot) {
+        // The first packet goes all the way through to the last device,
+        // so device N's packet is N packets from the end of the frame.
+        memset(out, 0, total_bytes);
+        for (int index = 1; index <= chain_devices; ++index) {
+            auto& pending = chain_pending[index];
+            if (slot < pending.size()) {
+                put_packet(&out[(chain_devices - index) * packetLen], pending[slot].reg, pending[slot].data);
+            }
+        }
+        digitalWrite(chain_cs, 0);
+        tmc_spi_transfer_data(out, total_bytes * 8, NULL, 0);
+        digitalWrite(chain_cs, 1);
+    }
+    tmc_spi_bus_release();
+    log_verbose("TMC chain " << int(slots) << " frames for " << chain_devices << " devices");
+
+    for (auto& pending : chain_pending) {
+        pending.clear();
+    }
+}
+
+void tmc_spi_chain_end() {
+    chain_flush();
+    chain_batching = false;
+}
 
 // Replace the library's weak definition of TMC2130Stepper::write()
 // This is executed in the object context so it has access to class
 // data such as the CS pin that switchCSpin() uses
 void TMC2130Stepper::write(uint8_t reg, uint32_t data) {
     log_verbose("TMC reg " << to_hex(reg) << " write " << to_hex(data));
-    tmc_spi_bus_setup();
+    if (chain_batching && link_index > 0 && chain_length <= max_chain) {
+        chain_devices = chain_length;
+        chain_cs      = _pinCS;
+        chain_pending[link_index].push_back({ uint8_t(reg | 0x80), data });
+        return;
+    }
+    tmc_spi_bus_acquire();
 
     switchCSpin(0);
     tmc_spi_rw_reg(reg | 0x80, data, link_index);
     switchCSpin(1);
+
+    tmc_spi_bus_release();
 }
 
 // Replace the library's weak definition of TMC2130Stepper::read()
 uint32_t TMC2130Stepper::read(uint8_t reg) {
-    tmc_spi_bus_setup();
+    chain_flush();
+    tmc_spi_bus_acquire();
 
     switchCSpin(0);
     tmc_spi_rw_reg(reg, 0, link_index);
@@ -88,6 +178,8 @@ uint32_t TMC2130Stepper::read(uint8_t reg) {
     data += (uint32_t)in[dummy_in_bytes + 4];
     switchCSpin(1);
 
+    tmc_spi_bus_release();
+
     log_verbose("TMC reg " << to_hex(reg) << " read " << to_hex(data) << " status " << to_hex(status));
 
     return data;
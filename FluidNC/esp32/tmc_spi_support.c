@@ -7,6 +7,8 @@
 // way that causes compiler error on spi_ll.h
 
 #include "hal/spi_ll.h"
+#include "freertos/FreeRTOS.h"  // portMAX_DELAY
+#include "driver/spi_master.h"
 
 #include <sdkconfig.h>
 #ifdef CONFIG_IDF_TARGET_ESP32S3
@@ -18,6 +20,43 @@ spi_dev_t* hw = &SPI2;
 
 static spi_ll_clock_val_t clk_reg_val = 0;
 
+// The bus is shared with the SD card and Ethernet, whose accesses go through the
+// ESP-IDF SPI master driver and may come from other tasks.  TMC accesses take the
+// bus from that driver as a device of their own, with no CS pin, so a TMC access
+// waits for the SD or Ethernet transaction in progress, never longer than one SD
+// command, and those wait for it in turn.  Taking the bus also tells the driver
+// that its registers were changed, so it sets them up again for its next device.
+static spi_device_handle_t tmc_device  = NULL;
+static bool                tmc_no_lock = false;
+
+// cppcheck-suppress unusedFunction
+void tmc_spi_bus_acquire() {
+    if (!tmc_device && !tmc_no_lock) {
+        spi_device_interface_config_t devcfg = {
+            .mode           = 3,
+            .clock_speed_hz = 2000000,
+            .spics_io_num   = -1,
+            .queue_size     = 1,
+        };
+        if (spi_bus_add_device(HSPI_HOST, &devcfg, &tmc_device) != ESP_OK) {
+            // All the device slots of the bus are taken; access it unlocked as before
+            tmc_device  = NULL;
+            tmc_no_lock = true;
+        }
+    }
+    if (tmc_device) {
+        spi_device_acquire_bus(tmc_device, portMAX_DELAY);
+    }
+    tmc_spi_bus_setup();
+}
+
+// cppcheck-suppress unusedFunction
+void tmc_spi_bus_release() {
+    if (tmc_device) {
+        spi_device_release_bus(tmc_device);
+    }
+}
+
 // Establish the SPI bus configuration needed for TMC device access
 // This should be done one before every TMC read or write operation,
 // to reconfigure the bus from whatever mode the SD card driver used.
@@ -8,9 +8,17 @@ extern "C" {
 #endif
 
 void tmc_spi_bus_setup();
+
+// Take the shared bus for TMC accesses, and set it up for them, then give it back
+void tmc_spi_bus_acquire();
+void tmc_spi_bus_release();
 void tmc_spi_transfer_data(uint8_t* out, int out_bitlen, uint8_t* in, int in_bitlen);
 void tmc_spi_rw_reg(uint8_t cmd, uint32_t data, int index);
 
+// Queue writes to daisy-chained devices and send them as whole-chain frames
+void tmc_spi_chain_begin();
+void tmc_spi_chain_end();
+
 #ifdef __cplusplus
 }
 #endif
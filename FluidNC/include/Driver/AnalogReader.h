@@ -0,0 +1,23 @@
+// Copyright 2024 - FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Analog input driver interface
+
+#include "src/Pin.h"
+
+class AnalogReader {
+public:
+    static const int maxValue = 4095;
+
+    // Returns nullptr if the pin is not on an ADC that can be read while the radio is on
+    static AnalogReader* create(const Pin& pin);
+
+    // One conversion, 0 to maxValue
+    int read();
+
+private:
+    AnalogReader(int channel) : _channel(channel) {}
+    int _channel;
+};
@@ -0,0 +1,42 @@
+// Copyright 2024 - FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Pulse counter driver interface
+
+#include "src/Pin.h"
+
+class PulseCounter {
+public:
+    // The count wraps to 0 after maxCount, so it must be read that often
+    static const uint32_t maxCount = 32767;
+
+    PulseCounter(const Pin& pin);
+    ~PulseCounter();
+
+    // Rising edges since the last call
+    uint32_t take();
+
+private:
+    int _unit;
+};
+
+// Counts all four edges of a quadrature encoder's A and B signals, up for one
+// direction and down for the other.  The hardware count is extended to 32 bits
+// in an interrupt each time it reaches a limit.
+class QuadratureCounter {
+public:
+    QuadratureCounter(const Pin& a, const Pin& b);
+    ~QuadratureCounter();
+
+    // Edges counted since construction, signed by direction.  Safe to call from an ISR.
+    int32_t position();
+
+private:
+    int _unit;
+
+    volatile int32_t _wraps = 0;  // Counts added at each limit
+
+    static void handle_limit(void* arg);
+};
@@ -14,6 +14,8 @@ public:
     uint32_t frequency() { return _frequency; }
     uint32_t period() { return _period; }
 
+    // Called from the stepper ISR at each segment, so it only stores to registers
+    // that were looked up when the channel was set up
     void setDuty(uint32_t duty);
 
 private:
@@ -21,4 +23,10 @@ private:
     int      _channel;
     int      _period;
     int      _gpio;
+
+    volatile uint32_t* _dutyReg;
+    volatile uint32_t* _conf1Reg;
+    uint32_t           _conf1Start;  // The conf1 word that latches a new duty
+    uint32_t           _conf1Stop;
+    int                _on = -1;  // Whether the output is enabled, -1 until set
 };
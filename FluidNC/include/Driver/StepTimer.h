@@ -12,6 +12,9 @@ void stepTimerStop();
 void stepTimerSetTicks(uint32_t ticks);
 void stepTimerStart();
 
+// Timer ticks since the last step timer interrupt
+uint32_t stepTimerGetTicks();
+
 #ifdef __cplusplus
 }
 #endif
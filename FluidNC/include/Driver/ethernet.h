@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Wired Ethernet through the ESP-IDF esp_eth driver, attached to lwIP as its
+// own network interface so that servers listening on all interfaces, like
+// Telnet and HTTP, accept connections from it as well as from WiFi.
+
+// The RMII clock source for the internal EMAC
+enum eth_clock_t {
+    ETH_CLOCK_GPIO0_IN = 0,  // 50 MHz from an external oscillator on GPIO0
+    ETH_CLOCK_GPIO0_OUT,     // generated on GPIO0
+    ETH_CLOCK_GPIO16_OUT,    // generated on GPIO16
+    ETH_CLOCK_GPIO17_OUT,    // generated inverted on GPIO17
+};
+
+// Addresses in network byte order; an ip of 0 selects DHCP
+struct eth_addr_t {
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t netmask;
+};
+
+// Starts a LAN8720 PHY on the internal EMAC.  Only the ESP32 has an EMAC.
+bool eth_start_rmii(int phy_addr, int mdc_pin, int mdio_pin, eth_clock_t clock, const char* hostname, const eth_addr_t* addr);
+
+// Starts a W5500 on the SPI bus, which must already be initialized
+bool eth_start_w5500(int cs_pin, int int_pin, int reset_pin, int mhz, const char* hostname, const eth_addr_t* addr);
+
+void eth_stop();
+
+bool     eth_link_up();
+int      eth_speed_mbps();  // 10 or 100, or 0 when the link is down
+bool     eth_full_duplex();
+uint32_t eth_local_ip();  // 0 until an address is assigned
+void     eth_mac(uint8_t mac[6]);
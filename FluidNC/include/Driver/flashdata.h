@@ -0,0 +1,13 @@
+#pragma once
+#include <string_view>
+
+// Text such as a configuration file can be kept in a raw data partition instead of
+// the local filesystem.  The partition is mapped into the address space, so the
+// text can be parsed in place without being copied to the heap.
+
+// Returns the text in the data partition with the given label, which ends at the
+// first NUL or erased byte.  The view is empty if there is no such partition.
+std::string_view flashdata_map(const char* label);
+
+// Replaces the contents of the partition; returns true on error.
+bool flashdata_write(const char* label, std::string_view text);
@@ -19,10 +19,26 @@ void gpio_write(pinnum_t pin, int value);
 int  gpio_read(pinnum_t pin);
 void gpio_mode(pinnum_t pin, int input, int output, int pullup, int pulldown, int opendrain);
 void gpio_set_interrupt_type(pinnum_t pin, int mode);
+
+// Interrupt modes for gpio_add_interrupt(), with the values of ESP-IDF gpio_int_type_t
+enum { GPIO_EDGE_RISING = 1, GPIO_EDGE_FALLING = 2, GPIO_EDGE_ANY = 3 };
+
 void gpio_add_interrupt(pinnum_t pin, int mode, void (*callback)(void*), void* arg);
 void gpio_remove_interrupt(pinnum_t pin);
 void gpio_route(pinnum_t pin, uint32_t signal);
 
+// Registers for writing and reading a GPIO directly, with the inversion folded
+// into which register turns it on.  See FastPin.
+typedef struct {
+    volatile uint32_t* on;
+    volatile uint32_t* off;
+    volatile uint32_t* in;
+    uint32_t           mask;
+    int                inverted;
+} gpio_fast_t;
+
+void gpio_fast_resolve(pinnum_t pin, int inverted, gpio_fast_t* regs);
+
 typedef void (*gpio_dispatch_t)(int, void*, int);
 
 void gpio_set_action(int gpio_num, gpio_dispatch_t action, void* arg, int invert);
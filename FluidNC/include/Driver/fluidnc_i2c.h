@@ -10,3 +10,6 @@
 bool i2c_master_init(int bus_number, pinnum_t sda_pin, pinnum_t scl_pin, uint32_t frequency);
 int  i2c_write(int bus_number, uint8_t address, const uint8_t* data, size_t count);
 int  i2c_read(int bus_number, uint8_t address, uint8_t* data, size_t count);
+
+// Writes out, then reads into in after a repeated start.  Returns in_count, or -1 on error.
+int i2c_write_read(int bus_number, uint8_t address, const uint8_t* out, size_t out_count, uint8_t* in, size_t in_count);
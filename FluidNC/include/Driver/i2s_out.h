@@ -40,6 +40,8 @@ typedef struct {
     uint32_t pulse_period;  // aka step rate.
     uint32_t init_val;
     uint32_t min_pulse_us;
+    uint32_t dma_buffers;         // Number of buffers in the I2S_STREAM DMA ring
+    uint32_t dma_buffer_samples;  // Samples (frames) per DMA buffer
 } i2s_out_init_t;
 
 /*
@@ -61,6 +63,13 @@ uint8_t i2s_out_read(pinnum_t pin);
 */
 void i2s_out_write(pinnum_t pin, uint8_t val);
 
+/*
+   Set the bits of mask in the internal pin state var to those of value, in one
+   atomic update, so outputs changed together reach the shift register together.
+   Safe to call from an ISR.
+*/
+void i2s_out_write_mask(uint32_t mask, uint32_t value);
+
 /*
   Dynamically delay until the Shift Register Pin changes
   according to the current I2S processing state and mode.
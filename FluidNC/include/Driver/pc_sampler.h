@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A statistical CPU profiler.  A timer interrupt on each core records the
+// program counter and task that the interrupt found running.  The samples
+// of each core go into its half of the buffer; when a half is full, that
+// core stops recording.
+
+struct pc_sample_t {
+    uint32_t pc;
+    void*    task;
+};
+
+// Starts sampling both cores at frequency Hz into buffer, which must stay
+// valid until pc_sampler_stop().  Returns false if the timers are unavailable.
+bool pc_sampler_start(uint32_t frequency, pc_sample_t* buffer, size_t n_samples);
+
+// Stops sampling.  counts[core] receives the number of samples that core
+// recorded; those of core 1 start at buffer[n_samples / 2].
+void pc_sampler_stop(size_t counts[2]);
@@ -1,7 +1,11 @@
+#include <cstdint>
 #include <system_error>
 
 bool sd_init_slot(uint32_t freq_hz, int cs_pin, int cd_pin = -1, int wp_pin = -1);
 void sd_unmount();
+
+// Serial number of the mounted card, used to notice that the card was changed.  0 if no card is mounted.
+uint32_t sd_card_id();
 void sd_deinit_slot();
 
 std::error_code sd_mount(int max_files = 1);
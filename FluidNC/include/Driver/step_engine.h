@@ -62,6 +62,14 @@ typedef struct step_engine {
     // Stop the pulse event timer
     void (*stop_timer)();
 
+    // Optional, NULL if the engine pulses only at step events.  The most step
+    // events, ticks apart, that set_run_pin() can pulse without further calls.
+    uint32_t (*max_run)(uint32_t ticks);
+
+    // Pulse the step pin count times, ticks apart, starting ticks from now.
+    // A count of 0 cancels the pulses that have not been sent.
+    void (*set_run_pin)(int pin, uint32_t count, uint32_t ticks);
+
     // Link to next engine in the list of registered stepping engines
     struct step_engine* link;
 } step_engine_t;
@@ -1,9 +1,28 @@
 Import("env")
 
 import os.path
+import subprocess
 
 env.Prepend(
     LIBPATH=[
         os.path.join("$PROJECT_DIR","FluidNC","ld","$BOARD_MCU","$PIOENV")
     ]
 )
+
+# The ISR audit build places the code and constants that the step ISR can reach in
+# RAM; normal builds get the empty isr_text.ld and isr_rodata.ld.  See README.md.
+isr_placement = "isr_in_iram" if env.GetProjectOption("custom_isr_in_iram", "no") == "yes" else "isr_in_flash"
+env.Prepend(
+    LIBPATH=[
+        os.path.join("$PROJECT_DIR","FluidNC","ld","$BOARD_MCU",isr_placement)
+    ]
+)
+
+def isr_flash_check(source, target, env):
+    prefix = env.subst("$CC")[: -len("gcc")]
+    tools  = dict(env["ENV"], OBJDUMP=prefix + "objdump", NM=prefix + "nm")
+    script = os.path.join(env.subst("$PROJECT_DIR"), "isr-flash-check.py")
+    subprocess.run([env.subst("$PYTHONEXE"), script, str(target[0])], env=tools)
+
+if env.GetProjectOption("custom_isr_check", "no") == "yes":
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", isr_flash_check)
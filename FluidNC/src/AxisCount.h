@@ -0,0 +1,50 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  AxisCount.h - loops over the axes with the configured axis count as a constant
+
+  The number of axes is known only once the machine configuration is loaded,
+  so loops over the axes are bounded by Axes::_numberAxis and cannot be
+  unrolled.  The few that run for every step or every block call
+  with_axis_count() instead, which instantiates the body for each possible
+  count and runs the one for the configured count:
+
+      with_axis_count<MAX_N_AXIS>(n_axis, [&](auto n) {
+          for (size_t axis = 0; axis < n; axis++) {
+              ...
+          }
+      });
+
+  n converts to its value as a constant expression, so a 3-axis machine runs
+  a body unrolled for 3 axes even though MAX_N_AXIS is 9.  The dispatch is
+  forced inline; mark the body __attribute__((always_inline)) as well when
+  it is called from IRAM code.  The maximum is a parameter, rather than
+  MAX_N_AXIS from Config.h, so that this header can be tested on the host.
+*/
+
+#include <cstddef>
+#include <type_traits>
+
+// There are always at least 3 axes; see Axes::afterParse()
+static const size_t MIN_N_AXIS = 3;
+
+template <size_t N, size_t MaxAxes, typename F>
+inline __attribute__((always_inline)) void with_axis_count_from(size_t n_axis, F& body) {
+    if constexpr (N < MaxAxes) {
+        if (n_axis <= N) {
+            body(std::integral_constant<size_t, N>());
+            return;
+        }
+        with_axis_count_from<N + 1, MaxAxes>(n_axis, body);
+    } else {
+        body(std::integral_constant<size_t, MaxAxes>());
+    }
+}
+
+template <size_t MaxAxes, typename F>
+inline __attribute__((always_inline)) void with_axis_count(size_t n_axis, F&& body) {
+    with_axis_count_from<MIN_N_AXIS, MaxAxes>(n_axis, body);
+}
@@ -12,6 +12,7 @@
 #include "esp_bt_main.h"
 
 #include <cstdint>
+#include <cstring>
 
 // SerialBT sends the data over Bluetooth
 namespace WebUI {
@@ -31,14 +32,33 @@ namespace WebUI {
     std::string    BTConfig::_btname   = "";
 
     size_t BTChannel::write(uint8_t data) {
-        static uint8_t lastchar = '\0';
-        if (_addCR && data == '\n' && lastchar != '\r') {
+        if (_addCR && data == '\n' && _lastTx != '\r') {
             SerialBT.write('\r');
         }
-        lastchar = data;
+        _lastTx = data;
         return SerialBT.write(data);
     }
 
+    size_t BTChannel::write(const uint8_t* buffer, size_t length) {
+        // Hand SerialBT whole runs, stopping only at newlines that need a CR
+        size_t written = 0;
+        while (written < length) {
+            const uint8_t* start = buffer + written;
+            auto           nl    = _addCR ? static_cast<const uint8_t*>(memchr(start, '\n', length - written)) : nullptr;
+            size_t         run   = nl ? nl - start : length - written;
+            if (run) {
+                SerialBT.write(start, run);
+                _lastTx = start[run - 1];
+                written += run;
+            }
+            if (nl) {
+                write(uint8_t('\n'));
+                ++written;
+            }
+        }
+        return written;
+    }
+
     BTConfig::BTConfig(const char* name) : Module(name) {
         bt_enable = new EnumSetting("Bluetooth Enable", WEBSET, WA, "ESP141", "Bluetooth/Enable", 1, &onoffOptions);
 
@@ -74,7 +94,7 @@ namespace WebUI {
     }
 
     int BTChannel::available() {
-        return SerialBT.available();
+        return SerialBT.available() + _queue.size();
     }
     int BTChannel::read() {
         return SerialBT.read();
@@ -82,6 +102,11 @@ namespace WebUI {
     int BTChannel::peek() {
         return SerialBT.peek();
     }
+    size_t BTChannel::readBulk(uint8_t* buffer, size_t length) {
+        // Only what is there, so readBytes() does not wait for its timeout
+        size_t n = std::min(length, size_t(SerialBT.available()));
+        return n ? SerialBT.readBytes(buffer, n) : 0;
+    }
 
     bool BTChannel::realtimeOkay(char c) {
         return _lineedit->realtime(c);
@@ -10,6 +10,7 @@
 #include "src/Settings.h"
 
 #include <BluetoothSerial.h>
+#include <algorithm>
 
 const char* const DEFAULT_BT_NAME = "FluidNC";
 
@@ -19,6 +20,10 @@ namespace WebUI {
     class BTChannel : public Channel {
     private:
         Lineedit* _lineedit;
+        uint8_t   _lastTx = '\0';
+
+        // RX_QUEUE_SIZE, which is defined in BluetoothSerial.cpp but not in its .h
+        static const int rxQueueSize = 512;
 
     public:
         // BTChannel(bool addCR = false) : _linelen(0), _addCR(addCR) {}
@@ -30,11 +35,15 @@ namespace WebUI {
         int    peek() override;
         void   flush() override { SerialBT.flush(); }
         size_t write(uint8_t data) override;
-        // 512 is RX_QUEUE_SIZE which is defined in BluetoothSerial.cpp but not in its .h
-        int rx_buffer_available() override { return 512 - SerialBT.available(); }
+        size_t write(const uint8_t* buffer, size_t length) override;
+
+        // Input moved into the queue by readBulk() has not been taken yet either
+        int rx_buffer_available() override { return std::max(0, rxQueueSize - SerialBT.available() - int(_queue.size())); }
 
-        bool realtimeOkay(char c) override;
-        bool lineComplete(char* line, char c) override;
+        bool   realtimeOkay(char c) override;
+        bool   lineComplete(char* line, char c) override;
+        bool   lineIdle() override { return _lineedit->idle(); }
+        size_t readBulk(uint8_t* buffer, size_t length) override;
 
         Error pollLine(char* line) override;
     };
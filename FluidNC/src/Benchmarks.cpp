@@ -0,0 +1,226 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Benchmarks.h"
+
+#include "Settings.h"
+#include "SettingsDefinitions.h"  // config_filename
+#include "Machine/MachineConfig.h"
+#include "GCode.h"     // gc_execute_line(), gc_state
+#include "Planner.h"   // plan_buffer_line()
+#include "Protocol.h"  // drain_messages()
+#include "System.h"    // get_mpos()
+#include "FileStream.h"
+#include "Report.h"  // report_snapshot()
+#include "Driver/delay_usecs.h"  // getCpuTicks()
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    // Adds up the CPU cycles of many timed sections.  Each section must be
+    // shorter than the 32-bit cycle counter's wrap time, about 17 s at 240 MHz.
+    class CycleCounter {
+        uint64_t _cycles = 0;
+        int32_t  _start  = 0;
+
+    public:
+        void     start() { _start = getCpuTicks(); }
+        void     stop() { _cycles += uint32_t(getCpuTicks() - _start); }
+        uint64_t cycles() const { return _cycles; }
+    };
+
+    uint32_t count_arg(const char* value, uint32_t dflt) {
+        int n = value ? atoi(value) : 0;
+        return n > 0 ? n : dflt;
+    }
+
+    void report(Channel& out, const char* name, uint32_t ops, const char* op, const CycleCounter& counter) {
+        uint64_t perOp = counter.cycles() / ops;
+        float    us    = float(perOp) / ticks_per_us;
+        log_stream(out, name << ": " << ops << " " << op << "s, " << perOp << " cycles/" << op << ", " << us << " us/" << op);
+    }
+}
+
+static Error bench_parser(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!state_is(State::Idle)) {
+        return Error::IdleError;
+    }
+    uint32_t count = count_arg(value, 10000);
+
+    // Check mode runs the whole parser but stops short of the planner
+    parser_state_t saved = gc_state;
+    set_state(State::CheckMode);
+
+    CycleCounter counter;
+    uint32_t     errors = 0;
+    char         line[LINE_BUFFER_SIZE];
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "G1X%.3fY%.3fZ-0.5F1500", (i % 200) * 0.25f, (i % 7) * 1.5f);
+        counter.start();
+        Error status = gc_execute_line(line);
+        counter.stop();
+        if (status != Error::Ok) {
+            ++errors;
+        }
+    }
+
+    set_state(State::Idle);
+    gc_state = saved;
+
+    report(out, "Parser", count, "line", counter);
+    if (errors) {
+        log_stream(out, errors << " lines had errors");
+    }
+    return Error::Ok;
+}
+
+static Error bench_planner(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (plan_get_current_block()) {
+        return Error::IdleError;
+    }
+    uint32_t count = count_arg(value, 10000);
+
+    float start[MAX_N_AXIS];
+    config->_kinematics->transform_cartesian_to_motors(start, get_mpos());
+
+    plan_line_data_t plan_data = {};
+    plan_data.spindle          = SpindleState::Disable;
+    plan_data.feed_rate        = 1500;
+
+    // The corners of a small square, so every junction is a right angle.  The
+    // blocks are never executed; the oldest is discarded when the buffer is full.
+    CycleCounter counter;
+    float        target[MAX_N_AXIS];
+    memcpy(target, start, sizeof(target));
+    for (uint32_t i = 0; i < count; i++) {
+        if (plan_check_full_buffer()) {
+            plan_discard_current_block();
+        }
+        target[X_AXIS] = start[X_AXIS] + ((i + 1) % 4 >= 2 ? 0.5f : 0.0f);
+        target[Y_AXIS] = start[Y_AXIS] + ((i + 2) % 4 >= 2 ? 0.5f : 0.0f);
+        counter.start();
+        plan_buffer_line(target, &plan_data);
+        counter.stop();
+    }
+
+    plan_reset();
+    plan_sync_position();
+
+    report(out, "Planner", count, "block", counter);
+    return Error::Ok;
+}
+
+static Error bench_kinematics(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    uint32_t count  = count_arg(value, 10000);
+    auto     kin    = config->_kinematics;
+    auto     n_axis = Axes::_numberAxis;
+
+    float cartesian[MAX_N_AXIS] = {};
+    float motors[MAX_N_AXIS];
+
+    CycleCounter forward, inverse;
+    for (uint32_t i = 0; i < count; i++) {
+        cartesian[X_AXIS] = (i % 100) * 0.5f;
+        cartesian[Y_AXIS] = (i % 37) * 1.25f;
+        forward.start();
+        kin->transform_cartesian_to_motors(motors, cartesian);
+        forward.stop();
+        inverse.start();
+        kin->motors_to_cartesian(cartesian, motors, n_axis);
+        inverse.stop();
+    }
+
+    report(out, "Kinematics to motors", count, "transform", forward);
+    report(out, "Kinematics to cartesian", count, "transform", inverse);
+    return Error::Ok;
+}
+
+static Error bench_fs(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    std::string path = value ? value : config_filename->get();
+
+    const size_t chunk  = 4096;
+    char*        buffer = new char[chunk];
+    CycleCounter opening, reading;
+    uint32_t     reads = 0;
+    size_t       total = 0;
+    try {
+        opening.start();
+        FileStream file(path, "r", "");
+        opening.stop();
+        log_stream(out, "FS open: " << opening.cycles() << " cycles, " << float(opening.cycles()) / ticks_per_us << " us");
+
+        for (;;) {
+            reading.start();
+            size_t len = file.read(buffer, chunk);
+            reading.stop();
+            if (len == 0) {
+                break;
+            }
+            total += len;
+            ++reads;
+        }
+    } catch (Error err) {
+        delete[] buffer;
+        return err;
+    }
+    delete[] buffer;
+
+    if (reads) {
+        report(out, "FS read", reads, "4K read", reading);
+        float seconds = float(reading.cycles()) / ticks_per_us / 1e6f;
+        log_stream(out, "FS read " << int(total) << " bytes at " << int(total / seconds / 1024) << " KiB/s");
+    }
+    return Error::Ok;
+}
+
+static Error bench_net(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    uint32_t count = count_arg(value, 200);
+
+    char line[65];
+    memset(line, '-', 64);
+    line[64] = '\0';
+
+    // Lines go out through the output task, so the time runs until it has sent them all
+    CycleCounter counter;
+    counter.start();
+    for (uint32_t i = 0; i < count; i++) {
+        log_stream(out, line);
+    }
+    drain_messages();
+    out.flush();
+    counter.stop();
+
+    report(out, "Net", count, "line", counter);
+    float seconds = float(counter.cycles()) / ticks_per_us / 1e6f;
+    log_stream(out, "Net sent " << int(count * 65) << " bytes to " << out.name() << " at " << int(count * 65 / seconds / 1024) << " KiB/s");
+    return Error::Ok;
+}
+
+// Formats the fields of a status report without sending it, as a report tick does
+static Error bench_report(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    uint32_t count = count_arg(value, 10000);
+
+    StatusSnapshot snapshot;
+    CycleCounter   counter;
+    for (uint32_t i = 0; i < count; i++) {
+        report_wco_counter = 0;  // Include WCO: in every one
+        counter.start();
+        report_snapshot(snapshot);
+        counter.stop();
+    }
+
+    report(out, "Report", count, "report", counter);
+    float seconds = float(counter.cycles()) / ticks_per_us / 1e6f;
+    log_stream(out, "Report " << int(count / seconds) << " reports/s");
+    return Error::Ok;
+}
+
+void make_bench_commands() {
+    new UserCommand("BP", "Bench/Parser", bench_parser, notIdleOrAlarm);
+    new UserCommand("BPL", "Bench/Planner", bench_planner, notIdleOrAlarm);
+    new UserCommand("BK", "Bench/Kinematics", bench_kinematics, anyState);
+    new UserCommand("BFS", "Bench/FS", bench_fs, anyState);
+    new UserCommand("BN", "Bench/Net", bench_net, anyState);
+    new UserCommand("BR", "Bench/Report", bench_report, anyState);
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Benchmarks.h - $Bench/ commands that time canned workloads on the target
+
+  Host benchmarks (see tests/Bench.h) do not show the effects of the Xtensa
+  FPU, flash cache misses or IRAM placement, so these run the real code on
+  the board and report CPU cycles per operation, for comparing boards and
+  firmware builds.
+
+    $Bench/Parser[=count]      G1 lines through gc_execute_line() in check mode
+    $Bench/Planner[=count]     plan_buffer_line() calls, discarding old blocks
+    $Bench/Kinematics[=count]  cartesian to motor transforms and back
+    $Bench/FS[=path]           reading a file through FileStream
+    $Bench/Net[=count]         64-byte lines to the channel that ran the command
+    $Bench/Report[=count]      status report fields, with WCO:, through report_snapshot()
+
+  The parser and planner benchmarks need an idle machine, and put the
+  parser and planner state back as it was when they finish.
+*/
+
+void make_bench_commands();
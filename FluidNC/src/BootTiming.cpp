@@ -0,0 +1,147 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "BootTiming.h"
+
+#include "Logging.h"
+#include "src/JSONEncoder.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace BootTiming {
+    struct Phase {
+        const char* name;
+        int64_t     start;  // Microseconds since the chip reset
+        int64_t     end;    // 0 while the phase is still running
+        int         depth;  // Number of enclosing phases in the same task
+        int         tid;    // Small number for the task, in order of first appearance
+        char        task[configMAX_TASK_NAME_LEN];
+    };
+
+    // Phases can run in other tasks, e.g. the Trinamic UART bus tasks
+    static std::mutex   _mutex;
+    static TaskHandle_t _tasks[maxPhases];
+    static Phase        _phases[maxPhases];
+    static int          _count   = 0;
+    static int          _dropped = 0;
+    static bool         _done    = false;
+
+    static int begin(const char* name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_done) {
+            return -1;
+        }
+        if (_count == maxPhases) {
+            ++_dropped;
+            return -1;
+        }
+        TaskHandle_t task  = xTaskGetCurrentTaskHandle();
+        int          depth = 0;
+        int          tid   = -1;
+        int          next  = 0;
+        for (int i = 0; i < _count; i++) {
+            if (_tasks[i] == task) {
+                tid = _phases[i].tid;
+                if (!_phases[i].end) {
+                    ++depth;
+                }
+            }
+            next = std::max(next, _phases[i].tid + 1);
+        }
+        if (tid < 0) {
+            tid = next;
+        }
+        Phase& p = _phases[_count];
+        p        = { name, esp_timer_get_time(), 0, depth, tid, "" };
+        strncpy(p.task, pcTaskGetTaskName(nullptr), sizeof(p.task) - 1);
+        _tasks[_count] = task;
+        return _count++;
+    }
+
+    static void end(int index) {
+        if (index >= 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _phases[index].end = esp_timer_get_time();
+        }
+    }
+
+    void done() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done = true;
+    }
+
+    void report(Channel& out, bool chromeTrace) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (chromeTrace) {
+            JSONencoder j(false, &out);
+            j.begin();
+            j.begin_array("traceEvents");
+            for (int i = 0; i < _count; i++) {
+                auto& p = _phases[i];
+                j.begin_object();
+                j.member("name", p.name);
+                j.member("ph", "X");
+                j.member("ts", int(p.start));
+                j.member("dur", int(p.end ? p.end - p.start : 0));
+                j.member("pid", 1);
+                j.member("tid", p.tid);
+                j.end_object();
+            }
+            // Metadata events name the rows after the tasks
+            for (int i = 0; i < _count; i++) {
+                auto& p     = _phases[i];
+                bool  first = true;
+                for (int k = 0; k < i; k++) {
+                    if (_phases[k].tid == p.tid) {
+                        first = false;
+                        break;
+                    }
+                }
+                if (first) {
+                    j.begin_object();
+                    j.member("name", "thread_name");
+                    j.member("ph", "M");
+                    j.member("pid", 1);
+                    j.member("tid", p.tid);
+                    j.begin_member_object("args");
+                    j.member("name", p.task);
+                    j.end_object();
+                    j.end_object();
+                }
+            }
+            j.end_array();
+            j.member("displayTimeUnit", "ms");
+            j.end();
+            return;
+        }
+
+        for (int i = 0; i < _count; i++) {
+            auto&       p = _phases[i];
+            std::string indent(p.depth * 2, ' ');
+            if (p.tid) {
+                // Phases outside the startup task are marked with their task name
+                indent = indent + p.task + ": ";
+            }
+            if (p.end) {
+                log_stream(out, indent << p.name << " at " << int(p.start / 1000) << " ms took " << int(p.end - p.start) << " us");
+            } else {
+                log_stream(out, indent << p.name << " at " << int(p.start / 1000) << " ms did not finish");
+            }
+        }
+        if (_dropped) {
+            log_stream(out, _dropped << " more phases were not recorded");
+        }
+    }
+}
+
+BootPhase::BootPhase(const char* name) : _index(BootTiming::begin(name)) {}
+
+BootPhase::~BootPhase() {
+    BootTiming::end(_index);
+}
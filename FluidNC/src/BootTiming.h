@@ -0,0 +1,42 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  BootTiming.h - records how long each phase of startup takes
+
+  A BootPhase object marks one phase from its construction to its destruction,
+  so phases can nest.  Phases may also run in other tasks, such as the Trinamic
+  UART bus tasks that test motors while the rest of startup goes on; nesting is
+  tracked per task.
+  Up to maxPhases phases are kept in a fixed array; later ones are dropped.
+  Recording stops at done(), so code that also runs after startup, like a
+  WiFi reconnect, does not add entries.  Phase names must be string literals
+  or otherwise outlive the program.
+*/
+
+#include "Channel.h"
+
+#include <cstdint>
+
+namespace BootTiming {
+    const int maxPhases = 40;
+
+    // Stops recording; called when setup() finishes
+    void done();
+
+    // Reports the phases as text, or as Chrome trace JSON that can be
+    // loaded into chrome://tracing or https://ui.perfetto.dev
+    void report(Channel& out, bool chromeTrace);
+}
+
+class BootPhase {
+    int _index;
+
+public:
+    explicit BootPhase(const char* name);
+    BootPhase(const BootPhase&)            = delete;
+    BootPhase& operator=(const BootPhase&) = delete;
+    ~BootPhase();
+};
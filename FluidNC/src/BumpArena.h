@@ -0,0 +1,100 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  BumpArena.h - allocation by bumping a pointer through large chunks
+
+  Many small objects that live and die together can be carved out of a few large
+  heap blocks instead of being allocated one by one, so they do not fragment the
+  heap.  Individual objects are never freed; release() returns all the chunks at
+  once.  A request larger than the chunk size gets a chunk of its own.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+class BumpArena {
+    struct Chunk {
+        Chunk* next;
+        size_t size;  // Bytes of data after the header
+        size_t used;
+    };
+
+    static constexpr size_t align      = alignof(std::max_align_t);
+    static constexpr size_t headerSize = (sizeof(Chunk) + align - 1) & ~(align - 1);
+
+    static char* data(Chunk* c) { return reinterpret_cast<char*>(c) + headerSize; }
+
+    Chunk* _head = nullptr;  // The chunk being filled; older ones follow
+    size_t _chunkSize;
+
+public:
+    explicit BumpArena(size_t chunkSize) : _chunkSize(chunkSize) {}
+    BumpArena(const BumpArena&)            = delete;
+    BumpArena& operator=(const BumpArena&) = delete;
+    ~BumpArena() { release(); }
+
+    // Returns nullptr if a new chunk is needed and cannot be allocated
+    void* allocate(size_t size) {
+        size = (size + align - 1) & ~(align - 1);
+        if (!_head || _head->size - _head->used < size) {
+            size_t dataSize = std::max(size, _chunkSize);
+            auto   c        = static_cast<Chunk*>(malloc(headerSize + dataSize));
+            if (!c) {
+                return nullptr;
+            }
+            *c    = { _head, dataSize, 0 };
+            _head = c;
+        }
+        void* p = data(_head) + _head->used;
+        _head->used += size;
+        return p;
+    }
+
+    bool owns(const void* p) const {
+        auto addr = reinterpret_cast<uintptr_t>(p);
+        for (Chunk* c = _head; c; c = c->next) {
+            auto start = reinterpret_cast<uintptr_t>(data(c));
+            if (addr >= start && addr < start + c->size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release() {
+        while (_head) {
+            Chunk* next = _head->next;
+            free(_head);
+            _head = next;
+        }
+    }
+
+    size_t used() const {
+        size_t n = 0;
+        for (Chunk* c = _head; c; c = c->next) {
+            n += c->used;
+        }
+        return n;
+    }
+
+    size_t reserved() const {
+        size_t n = 0;
+        for (Chunk* c = _head; c; c = c->next) {
+            n += c->size;
+        }
+        return n;
+    }
+
+    size_t chunks() const {
+        size_t n = 0;
+        for (Chunk* c = _head; c; c = c->next) {
+            ++n;
+        }
+        return n;
+    }
+};
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  ByteRing.h - fixed-capacity byte queue for channel input
+
+  The storage is part of the object, so pushing and popping never touch the heap.  Bulk
+  push() copies at most two runs, and data() / consume() give the reader the oldest
+  contiguous run in place, so a line can be scanned without popping it byte by byte.
+  There is no locking; a ring is filled and drained by the same task.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+template <size_t Capacity>
+class ByteRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "ByteRing capacity must be a power of 2");
+
+    uint8_t _data[Capacity];
+    size_t  _head = 0;  // Total bytes pushed; the index is _head & (Capacity - 1)
+    size_t  _tail = 0;  // Total bytes popped
+
+public:
+    static const size_t capacity = Capacity;
+
+    size_t size() const { return _head - _tail; }
+    size_t free() const { return Capacity - size(); }
+    bool   empty() const { return _head == _tail; }
+    void   clear() { _head = _tail = 0; }
+
+    bool push(uint8_t byte) {
+        if (size() == Capacity) {
+            return false;
+        }
+        _data[_head++ & (Capacity - 1)] = byte;
+        return true;
+    }
+
+    // Returns the number of bytes that fit, which may be fewer than length.
+    size_t push(const uint8_t* data, size_t length) {
+        if (length > free()) {
+            length = free();
+        }
+        size_t start = _head & (Capacity - 1);
+        size_t first = Capacity - start;
+        if (first > length) {
+            first = length;
+        }
+        memcpy(_data + start, data, first);
+        memcpy(_data, data + first, length - first);
+        _head += length;
+        return length;
+    }
+
+    int pop() { return empty() ? -1 : _data[_tail++ & (Capacity - 1)]; }
+
+    // The oldest contiguous run of bytes, which is all of them unless they wrap.
+    const uint8_t* data(size_t& length) const {
+        size_t start = _tail & (Capacity - 1);
+        length       = size();
+        if (length > Capacity - start) {
+            length = Capacity - start;
+        }
+        return _data + start;
+    }
+    void consume(size_t length) { _tail += length; }
+
+    // Pops up to length bytes into buffer, returning how many.
+    size_t read(uint8_t* buffer, size_t length) {
+        size_t done = 0;
+        while (done < length && !empty()) {
+            size_t         run;
+            const uint8_t* src = data(run);
+            if (run > length - done) {
+                run = length - done;
+            }
+            memcpy(buffer + done, src, run);
+            consume(run);
+            done += run;
+        }
+        return done;
+    }
+};
@@ -8,15 +8,18 @@
 #include "Limits.h"
 #include "Logging.h"
 #include "Job.h"
+#include "HeapStats.h"
+#include "Stepper.h"  // Stepper::get_realtime_rate
+#include "Protocol.h"  // protocol_wake_polling
+#include "string_util.h"
 #include <string_view>
 #include <algorithm>
+#include <cstring>
 
 void Channel::flushRx() {
     _linelen   = 0;
     _lastWasCR = false;
-    while (_queue.size()) {
-        _queue.pop();
-    }
+    _queue.clear();
 }
 
 bool Channel::lineComplete(char* line, char ch) {
@@ -69,6 +72,21 @@ bool Channel::lineComplete(char* line, char ch) {
     return false;
 }
 
+uint32_t Channel::setAckBatch(uint32_t ms) {
+    flushAcks();
+    _ackBatchMs = ms;
+    return ms;
+}
+
+void Channel::flushAcks() {
+    uint32_t n = _pendingOks.exchange(0);
+    if (n == 1) {
+        sendLine(MsgLevelNone, "ok");
+    } else if (n > 1) {
+        sendLine(MsgLevelNone, "ok:" + std::to_string(n));
+    }
+}
+
 uint32_t Channel::setReportInterval(uint32_t ms) {
     uint32_t actual = ms;
     if (actual) {
@@ -103,6 +121,37 @@ void Channel::autoReportGCodeState() {
         _lastFeedRate     = gc_state.feed_rate;
     }
 }
+// Automatic reports that fall due in the same tick share one snapshot, so the
+// fields are formatted once however many channels are reporting.
+static StatusSnapshot sharedSnapshot;
+static TickType_t     sharedSnapshotTick  = 0;
+static bool           sharedSnapshotValid = false;
+
+void Channel::autoReportStatus() {
+    if (_reportBinary) {
+        // Built from the live values; there is no text to share
+        report_binary_status(*this);
+        return;
+    }
+    TickType_t now = xTaskGetTickCount();
+    if (!sharedSnapshotValid || now != sharedSnapshotTick) {
+        report_snapshot(sharedSnapshot);
+        sharedSnapshotTick  = now;
+        sharedSnapshotValid = true;
+    }
+    report_snapshot_to(sharedSnapshot, *this, _lastReport, _reportFields);
+}
+
+void Channel::setReportDelta(bool on) {
+    delete _lastReport;
+    // Starting from an empty report makes the next one complete
+    _lastReport = on ? new StatusSnapshot() : nullptr;
+}
+
+Channel::~Channel() {
+    delete _lastReport;
+}
+
 void Channel::autoReport() {
     if (_reportInterval) {
         auto thisProbeState = config->_probe->get_state();
@@ -111,20 +160,31 @@ void Channel::autoReport() {
         if (_reportOvr || _reportWco || stateName != _lastStateName || thisProbeState != _lastProbe || _lastPinString != report_pin_string ||
             (motionState() && (int32_t(xTaskGetTickCount()) - _nextReportTime) >= 0) || (_lastJobActive != Job::active())) {
             if (_reportOvr) {
-                report_ovr_counter = 0;
-                _reportOvr         = false;
+                report_ovr_counter  = 0;
+                _reportOvr          = false;
+                sharedSnapshotValid = false;
             }
             if (_reportWco) {
-                report_wco_counter = 0;
-                _reportWco         = false;
+                report_wco_counter  = 0;
+                _reportWco          = false;
+                sharedSnapshotValid = false;
             }
             _lastStateName = stateName;
             _lastProbe     = thisProbeState;
             _lastPinString = report_pin_string;
             _lastJobActive = Job::active();
 
-            _nextReportTime = xTaskGetTickCount() + _reportInterval;
-            report_realtime_status(*this);
+            // Reports slow down while nothing is moving in a motion state, e.g. during a
+            // dwell or at the end of a feed hold deceleration.  The period is aligned to
+            // a multiple of the interval, so channels with the same interval come due in
+            // the same tick and share a snapshot.
+            uint32_t interval = _reportInterval;
+            if (Stepper::get_realtime_rate() == 0) {
+                interval *= 4;
+            }
+            uint32_t now    = xTaskGetTickCount();
+            _nextReportTime = int32_t(now - now % interval + interval);
+            autoReportStatus();
         }
         if (_reportNgc != CoordIndex::End) {
             report_ngc_coord(_reportNgc, *this);
@@ -134,6 +194,10 @@ void Channel::autoReport() {
     }
 }
 
+void Channel::reportStatus() {
+    report_realtime_status(*this);
+}
+
 void Channel::pin_event(uint32_t pinnum, bool active) {
     try {
         auto event_pin       = _events.at(pinnum);
@@ -185,38 +249,118 @@ void Channel::push(uint8_t byte) {
     if (is_realtime_command(byte)) {
         handleRealtimeCharacter(byte);
     } else {
-        _queue.push(byte);
+        push_queue(&byte, 1);
+    }
+}
+
+void Channel::push(const uint8_t* data, size_t length) {
+    // Queue the runs between realtime characters in bulk
+    while (length) {
+        size_t run = 0;
+        while (run < length && !is_realtime_command(data[run])) {
+            ++run;
+        }
+        push_queue(data, run);
+        if (run == length) {
+            break;
+        }
+        handleRealtimeCharacter(data[run]);
+        data += run + 1;
+        length -= run + 1;
+    }
+}
+
+void Channel::push_queue(const uint8_t* data, size_t length) {
+    protocol_wake_polling();
+    if (_queue.push(data, length) == length) {
+        _overflowed = false;
+    } else if (!_overflowed) {
+        // Report once per overflow, not once per lost message
+        _overflowed = true;
+        log_error(name() << " input queue overflow");
+    }
+}
+
+// Takes a line from the start of run if the run holds all of it and it has no control
+// characters, so lineComplete() would have done nothing but copy it.  Otherwise the run
+// is left for lineComplete() to go through a character at a time.
+bool Channel::takeLine(char* line, const uint8_t* data, size_t run) {
+    auto end = static_cast<const uint8_t*>(memchr(data, '\n', run));
+    auto cr  = static_cast<const uint8_t*>(memchr(data, '\r', end ? end - data : run));
+    if (cr) {
+        end = cr;
+    }
+    if (!end || std::any_of(data, end, [](uint8_t c) { return c < ' '; })) {
+        return false;
     }
+    size_t len = std::min(size_t(end - data), size_t(maxLine - 1));
+    memcpy(line, data, len);
+    line[len]  = '\0';
+    _lastWasCR = *end == '\r';
+    _queue.consume(end - data + 1);
+    return true;
 }
 
 Error Channel::pollLine(char* line) {
+    HeapScope heapScope(HeapTag::Channel);
     handle();
-    while (1) {
-        int ch = -1;
-        if (line && _queue.size()) {
-            ch = _queue.front();
-            _queue.pop();
-        } else {
-            ch = read();
-            if (ch < 0) {
-                break;
+    if (line) {
+        if (lineIdle()) {
+            // Nothing that step-by-step line handling would treat specially is pending,
+            // so take what has arrived in bulk, executing realtime characters as push()
+            // finds them.  Under a streaming sender this is usually several lines.
+            uint8_t buffer[128];
+            size_t  length;
+            while (_queue.free() && (length = readBulk(buffer, std::min(sizeof(buffer), _queue.free()))) != 0) {
+                _active = true;
+                push(buffer, length);
             }
-            _active = true;
-            if (realtimeOkay(ch) && is_realtime_command(ch)) {
-                handleRealtimeCharacter((uint8_t)ch);
-                continue;
+        }
+        // Scan the queued input in place, a contiguous run at a time
+        size_t         run;
+        const uint8_t* data;
+        while ((data = _queue.data(run)), run) {
+            if (lineIdle()) {
+                if (_lastWasCR && data[0] == '\n') {
+                    // The LF of a CR-LF; the line was completed at the CR
+                    _lastWasCR = false;
+                    _queue.consume(1);
+                    continue;
+                }
+                if (takeLine(line, data, run)) {
+                    return Error::Ok;
+                }
             }
-            if (!line) {
-                _queue.push(ch);
-                continue;
+            for (size_t i = 0; i < run; ++i) {
+                if (lineComplete(line, data[i])) {
+                    _queue.consume(i + 1);
+                    return Error::Ok;
+                }
             }
-            // Fall through if line is non-null and it is not a realtime character
+            _queue.consume(run);
+        }
+    }
+    while (1) {
+        int ch = read();
+        if (ch < 0) {
+            break;
+        }
+        _active = true;
+        if (realtimeOkay(ch) && is_realtime_command(ch)) {
+            handleRealtimeCharacter((uint8_t)ch);
+            continue;
+        }
+        if (!line) {
+            uint8_t byte = ch;
+            push_queue(&byte, 1);
+            continue;
         }
-
         if (lineComplete(line, ch)) {
             return Error::Ok;
         }
     }
+    // The sender is waiting, so it must not wait for acks too.
+    flushAcks();
     if (_active) {
         autoReport();
     }
@@ -258,9 +402,19 @@ void Channel::registerEvent(uint8_t code, EventPin* obj) {
 
 void Channel::ack(Error status) {
     if (status == Error::Ok) {
+        if (_ackBatchMs) {
+            int32_t now = int32_t(xTaskGetTickCount());
+            if (_pendingOks.fetch_add(1) == 0) {
+                _firstPendingOk = now;
+            } else if (now - _firstPendingOk >= int32_t(pdMS_TO_TICKS(_ackBatchMs))) {
+                flushAcks();
+            }
+            return;
+        }
         sendLine(MsgLevelNone, "ok");
         return;
     }
+    flushAcks();  // Earlier lines succeeded before this one failed
     // With verbose errors, the message text is displayed instead of the number.
     // Grbl 0.9 used to display the text, while Grbl 1.1 switched to the number.
     // Many senders support both formats.
@@ -279,6 +433,23 @@ void Channel::print_msg(MsgLevel level, const char* msg) {
     }
 }
 
+// The output task owns the slot after log_send() and returns it to the pool
+// once the message has gone out.
+static void queue_line(Channel* channel, MsgLevel level, LogMessage::Kind kind, const void* line) {
+    LogMessage* msg = log_acquire(level);
+    if (!msg) {
+        if (kind == LogMessage::String) {
+            delete static_cast<const std::string*>(line);
+        }
+        return;
+    }
+    msg->channel = channel;
+    msg->level   = level;
+    msg->kind    = kind;
+    msg->line    = line;
+    log_send(msg);
+}
+
 // This overload is used primarily with fixed string
 // values.  It sends a pointer to the string whose
 // memory does not need to be reclaimed later.
@@ -286,51 +457,74 @@ void Channel::print_msg(MsgLevel level, const char* msg) {
 // with fixed messages.
 void Channel::sendLine(MsgLevel level, const char* line) {
     if (outputTask) {
-        LogMessage msg { this, (void*)line, level, false };
-        while (!xQueueSend(message_queue, &msg, 10)) {}
+        queue_line(this, level, LogMessage::Fixed, line);
     } else {
         print_msg(level, line);
     }
 }
 
-// This overload is used primarily with log_*() where
-// a std::string is dynamically allocated with "new",
-// and then extended to construct the message.  Its
-// pointer is sent to the output task, which sends
-// the message to the output channel and then "delete"s
-// the pointer to reclaim the memory.
-// This form has intermediate efficiency, as the string
-// is allocated once and freed once.
+// This overload receives a std::string that was dynamically
+// allocated with "new", typically by a LogStream whose line
+// was too long for a message slot.  Its pointer is sent to the
+// output task, which sends the message to the output channel
+// and then "delete"s the pointer to reclaim the memory.
 void Channel::sendLine(MsgLevel level, const std::string* line) {
     if (outputTask) {
-        LogMessage msg { this, (void*)line, level, true };
-        while (!xQueueSend(message_queue, &msg, 10)) {}
+        queue_line(this, level, LogMessage::String, line);
     } else {
         print_msg(level, line->c_str());
         delete line;
     }
 }
 
-// This overload is used for many miscellaneous messages
-// where the std::string is allocated in a code block and
-// then extended with various information.  This send_line()
-// copies that string to a newly allocated one and sends that
-// via the std::string* version of send_line().  The original
-// string is freed by the caller sometime after send_line()
-// returns, while the new string is freed by the output task
-// after the message is forwared to the output channel.
-// This is the least efficient form, requiring two strings
-// to be allocated and freed, with an intermediate copy.
-// It is used only rarely.
-void Channel::sendLine(MsgLevel level, const std::string& line) {
-    if (outputTask) {
+// This overload copies the line into a message slot, so the
+// caller's storage, e.g. a LogStream buffer, can be reused
+// as soon as it returns.  Only lines too long for a slot
+// are copied to the heap.
+void Channel::sendBytes(const uint8_t* data, size_t length) {
+    if (!outputTask || length > LogMessage::maxText) {
+        write(data, length);
+        return;
+    }
+    LogMessage* msg = log_acquire(MsgLevelNone);
+    if (!msg) {
+        return;
+    }
+    msg->channel = this;
+    msg->level   = MsgLevelNone;
+    msg->kind    = LogMessage::Binary;
+    msg->length  = length;
+    memcpy(msg->text, data, length);
+    log_send(msg);
+}
+
+void Channel::sendLine(MsgLevel level, std::string_view line) {
+    if (!outputTask) {
+        print_msg(level, std::string(line).c_str());
+        return;
+    }
+    if (line.length() >= LogMessage::maxText) {
         sendLine(level, new std::string(line));
-    } else {
-        print_msg(level, line.c_str());
+        return;
+    }
+    LogMessage* msg = log_acquire(level);
+    if (!msg) {
+        return;
     }
+    msg->channel = this;
+    msg->level   = level;
+    msg->kind    = LogMessage::Text;
+    msg->length  = line.length();
+    memcpy(msg->text, line.data(), line.length());
+    msg->text[line.length()] = '\0';
+    log_send(msg);
 }
 
-bool Channel::is_visible(const std::string& stem, std::string extension, bool isdir) {
+void Channel::sendLine(MsgLevel level, const std::string& line) {
+    sendLine(level, std::string_view(line));
+}
+
+bool Channel::is_visible(std::string_view stem, std::string_view extension, bool isdir) {
     if (stem.length() && stem[0] == '.') {
         // Exclude hidden files and directories
         return false;
@@ -343,16 +537,13 @@ bool Channel::is_visible(const std::string& stem, std::string extension, bool is
         return true;
     }
 
-    // Convert extension to canonical lower case format
-    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
-
     // common gcode extensions
     std::string_view extensions(".g .gc .gco .gcode .nc .ngc .ncc .txt .cnc .tap");
     int              pos = 0;
     while (extensions.length()) {
         auto             next_pos       = extensions.find_first_of(' ', pos);
         std::string_view next_extension = extensions.substr(0, next_pos);
-        if (extension == next_extension) {
+        if (string_util::equal_ignore_case(extension, next_extension)) {
             return true;
         }
         if (next_pos == extensions.npos) {
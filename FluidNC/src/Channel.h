@@ -24,10 +24,13 @@
 
 #include "src/Pins/PinAttributes.h"
 #include "src/Machine/EventPin.h"
+#include "src/ByteRing.h"
 
 #include <Stream.h>
 #include <freertos/FreeRTOS.h>  // TickType_T
-#include <queue>
+#include <atomic>
+
+struct StatusSnapshot;
 
 class Channel : public Stream {
 private:
@@ -44,7 +47,8 @@ private:
     static constexpr int timeout = 2000;
 
 public:
-    static constexpr int maxLine = 255;
+    static constexpr int    maxLine    = 255;
+    static constexpr size_t rxCapacity = 1024;  // Of the input queue
 
     int _message_level = MsgLevelVerbose;
 
@@ -55,11 +59,29 @@ protected:
     bool        _addCR         = false;
     char        _lastWasCR     = false;
 
-    std::queue<uint8_t> _queue;
+    // Input that was received before it could be used, such as the bytes of a WebSocket
+    // message, or characters read while no line was wanted
+    ByteRing<rxCapacity> _queue;
+    bool                 _overflowed = false;
 
     uint32_t _reportInterval = 0;
     int32_t  _nextReportTime = 0;
 
+    // What this channel last sent, for delta-only automatic reports
+    StatusSnapshot* _lastReport = nullptr;
+
+    // The ReportField bits of the fields that automatic reports include
+    uint8_t _reportFields = 0xff;
+
+    // Status reports are binary frames instead of <...> text, see report_binary_status()
+    bool _reportBinary = false;
+
+    // Acknowledgment coalescing, see setAckBatch()
+    uint32_t              _ackBatchMs     = 0;
+    std::atomic<uint32_t> _pendingOks { 0 };
+    int32_t               _firstPendingOk = 0;
+    void                  flushAcks();
+
     gc_modal_t  _lastModal        = modal_defaults;
     uint8_t     _lastTool         = 0;
     float       _lastSpindleSpeed = 0;
@@ -87,11 +109,14 @@ protected:
 protected:
     bool _active = true;
 
+    void push_queue(const uint8_t* data, size_t length);
+    bool takeLine(char* line, const uint8_t* data, size_t run);
+
 public:
     explicit Channel(const std::string& name, bool addCR = false) : _name(name), _linelen(0), _addCR(addCR) {}
     explicit Channel(const char* name, bool addCR = false) : _name(name), _linelen(0), _addCR(addCR) {}
     Channel(const char* name, int num, bool addCR = false) : _name(name) { _name += std::to_string(num), _linelen = 0, _addCR = addCR; }
-    virtual ~Channel() = default;
+    virtual ~Channel();
 
     bool _ackwait = false;
 
@@ -103,18 +128,23 @@ public:
     virtual void sendLine(MsgLevel level, const char* line);
     virtual void sendLine(MsgLevel level, const std::string* line);
     virtual void sendLine(MsgLevel level, const std::string& line);
+    virtual void sendLine(MsgLevel level, std::string_view line);
+
+    // Sends bytes that are not a line, such as a binary status report, in order with
+    // the lines queued before them
+    void sendBytes(const uint8_t* data, size_t length);
 
     size_t _line_number = 0;
 
     std::string _progress;
+    float       _progressPercent = 0;  // The number in _progress, for MachineStatus
 
     // rx_buffer_available() is the number of bytes that can be sent without overflowing
     // a reception buffer, even if the system is busy.  Channels that can handle external
     // input via an interrupt or other background mechanism should override it to return
-    // the remaining space that mechanism has available.
-    // The queue can handle more than 256 characters but we don't want it to get too
-    // large, so we report a limited size.
-    virtual int rx_buffer_available() { return std::max(0, 256 - int(_queue.size())); }
+    // the remaining space that mechanism has available.  By default it is the free space
+    // in the input queue.
+    virtual int rx_buffer_available() { return int(_queue.free()); }
 
     // flushRx() discards any characters that have already been received.  It is used
     // after a reset, so that anything already sent will not be processed.
@@ -133,12 +163,20 @@ public:
     // end is seen.
     virtual bool lineComplete(char* line, char c);
 
+    // lineIdle() returns true when no line is partly collected and lineComplete() would
+    // only copy characters up to the line end.  While it is true, pollLine() moves input
+    // into the queue with readBulk() and takes whole lines from it with memchr() instead
+    // of passing each character through lineComplete(), which is what a sender streaming
+    // G-code spends most of its input time on.
+    virtual bool   lineIdle() { return _linelen == 0; }
+    virtual size_t readBulk(uint8_t* buffer, size_t length) { return 0; }
+
     virtual size_t timedReadBytes(char* buffer, size_t length, TickType_t timeout) {
         setTimeout(timeout);
         return readBytes(buffer, length);
     }
 
-    virtual bool is_visible(const std::string& stem, std::string extension, bool isdir);
+    virtual bool is_visible(std::string_view stem, std::string_view extension, bool isdir);
 
     size_t timedReadBytes(uint8_t* buffer, size_t length, TickType_t timeout) {
         return timedReadBytes(reinterpret_cast<char*>(buffer), length, timeout);
@@ -164,20 +202,43 @@ public:
 
     uint32_t     setReportInterval(uint32_t ms);
     uint32_t     getReportInterval() { return _reportInterval; }
+
+    // With a nonzero window, the default ack() holds successful acknowledgments for up to
+    // ms milliseconds and sends them as one "ok:N", N being the number of lines.  Pending
+    // acks are sent at once when an error is reported or when no more input is waiting.
+    uint32_t setAckBatch(uint32_t ms);
+    uint32_t getAckBatch() { return _ackBatchMs; }
     virtual void autoReport();
     void         autoReportGCodeState();
 
+    // With delta reports on, automatic status reports include only the fields that
+    // have changed since the channel's previous one.
+    void setReportDelta(bool on);
+    bool getReportDelta() { return _lastReport != nullptr; }
+
+    // Automatic status reports include only the fields in the ReportField mask; the
+    // state is always sent.  Replies to ? are not affected.
+    void    setReportFields(uint8_t fields) { _reportFields = fields; }
+    uint8_t getReportFields() { return _reportFields; }
+
+    // With binary reports on, both replies to ? and automatic reports are sent as
+    // binary frames.  Fields and delta settings apply only to text reports.
+    void setReportBinary(bool on) { _reportBinary = on; }
+    bool getReportBinary() { return _reportBinary; }
+
+    // Sends a status report in reply to ?.  Channels with their own report format
+    // override it.
+    virtual void reportStatus();
+
+    // Sends a status report when autoReport() finds a change, using the snapshot
+    // shared by all channels that report in the same tick.
+    virtual void autoReportStatus();
+
+    // push() queues input, executing realtime characters immediately.  Input that does
+    // not fit in the queue is discarded with an error message.
     void push(uint8_t byte);
-    void push(const uint8_t* data, size_t length) {
-        while (length--) {
-            push(*data++);
-        }
-    }
-    void push(std::string_view data) {
-        for (auto const& c : data) {
-            push((uint8_t)c);
-        }
-    }
+    void push(const uint8_t* data, size_t length);
+    void push(std::string_view data) { push(reinterpret_cast<const uint8_t*>(data.data()), data.length()); }
     void push(const std::string& s) { push(reinterpret_cast<const uint8_t*>(s.c_str()), s.length()); }
 
     void end() { _ended = true; }
@@ -199,4 +260,8 @@ public:
     virtual void   restore() {}
     virtual size_t position() { return 0; }
     virtual void   set_position(size_t pos) {}
+
+    // Hint that set_position() will return to pos, the current position, as at the
+    // start of a loop, so the channel may keep the lines that follow in RAM.
+    virtual void cache_lines(size_t pos) {}
 };
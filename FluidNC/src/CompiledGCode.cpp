@@ -0,0 +1,78 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "CompiledGCode.h"
+#include "Config.h"
+#include "NutsBolts.h"  // read_float()
+
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+namespace CompiledGCode {
+    // Returns false if the line has anything that must be left to the text parser.
+    static bool tokenize(const char* line, Word* words, size_t& n_words) {
+        n_words = 0;
+        std::string collapsed;
+        for (const char* p = line; *p && *p != ';'; ++p) {
+            char c = *p;
+            if (isspace(c)) {
+                continue;
+            }
+            c = toupper(c);
+            if (!(isalpha(c) || isdigit(c) || c == '.' || c == '-' || c == '+') || c == 'O') {
+                return false;
+            }
+            collapsed += c;
+        }
+        size_t pos = 0;
+        while (pos < collapsed.length()) {
+            char letter = collapsed[pos++];
+            if (!isalpha(letter) || n_words == max_words) {
+                return false;
+            }
+            float value;
+            if (!read_float(collapsed.c_str(), pos, value)) {
+                return false;
+            }
+            words[n_words++] = { letter, value };
+        }
+        return true;
+    }
+
+    void compile_line(const char* line, std::string& out) {
+        Word   words[max_words];
+        size_t n_words;
+        if (!tokenize(line, words, n_words) || n_words == 0) {
+            out += line;
+            out += '\n';
+            return;
+        }
+        out += words_record;
+        out += char(n_words);
+        for (size_t i = 0; i < n_words; ++i) {
+            out += words[i].letter;
+            out.append(reinterpret_cast<const char*>(&words[i].value), sizeof(float));
+        }
+    }
+
+    size_t decode(const char* record, Word* words) {
+        size_t      n_words = uint8_t(record[1]);
+        const char* p       = record + 2;
+        for (size_t i = 0; i < n_words; ++i, p += word_size) {
+            words[i].letter = p[0];
+            memcpy(&words[i].value, p + 1, sizeof(float));
+        }
+        return n_words;
+    }
+
+    std::string to_text(const char* record) {
+        Word               words[max_words];
+        size_t             n_words = decode(record, words);
+        std::ostringstream s;
+        for (size_t i = 0; i < n_words; ++i) {
+            s << words[i].letter << words[i].value;
+        }
+        return s.str();
+    }
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Pre-parsed G-code jobs.  A compiled job has one record per line of the source file,
+// so line numbers in messages still refer to the source.  Lines that consist only of
+// letter and number words become a binary record of (letter, float) pairs that
+// gc_execute_line() executes without scanning text:
+//
+//   words_record, word count, then per word: letter, float value (native byte order)
+//
+// Every other line - comments that may be messages, parameters, expressions, O-codes,
+// % and $ commands - is kept as text with its newline, and executes as before.
+// The words record marker cannot begin a line of text.
+
+#include <cstddef>
+#include <string>
+
+namespace CompiledGCode {
+    const char   words_record = '\x01';
+    const size_t max_words    = 40;  // A record fits in a Channel::maxLine buffer
+    const size_t word_size    = 1 + sizeof(float);
+
+    struct Word {
+        char  letter;
+        float value;
+    };
+
+    // Appends the record for one source line (without its newline) to out.
+    void compile_line(const char* line, std::string& out);
+
+    // Size of the record that begins with header, the marker and the count.
+    inline size_t record_size(const char* header) { return 2 + size_t(uint8_t(header[1])) * word_size; }
+
+    // Extracts the words of a record, returning the count.
+    size_t decode(const char* record, Word* words);
+
+    // Renders a record as G-code text for display.
+    std::string to_text(const char* record);
+}
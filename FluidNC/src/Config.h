@@ -23,7 +23,7 @@ Some features should not be changed. See notes below.
 // machine.h is #included below, after some definitions
 // that the machine file might choose to undefine.
 
-const int MAX_N_AXIS = 6;
+const int MAX_N_AXIS = 9;
 
 const int MAX_MESSAGE_LINE = 256;
 
@@ -36,6 +36,9 @@ const int Z_AXIS = 2;
 const int A_AXIS = 3;
 const int B_AXIS = 4;
 const int C_AXIS = 5;
+const int U_AXIS = 6;  // UVW are linear axes parallel to XYZ, as in LinuxCNC
+const int V_AXIS = 7;
+const int W_AXIS = 8;
 
 const int X2_AXIS = (X_AXIS + MAX_N_AXIS);
 const int Y2_AXIS = (Y_AXIS + MAX_N_AXIS);
@@ -43,9 +46,16 @@ const int Z2_AXIS = (Z_AXIS + MAX_N_AXIS);
 const int A2_AXIS = (A_AXIS + MAX_N_AXIS);
 const int B2_AXIS = (B_AXIS + MAX_N_AXIS);
 const int C2_AXIS = (C_AXIS + MAX_N_AXIS);
+const int U2_AXIS = (U_AXIS + MAX_N_AXIS);
+const int V2_AXIS = (V_AXIS + MAX_N_AXIS);
+const int W2_AXIS = (W_AXIS + MAX_N_AXIS);
 
 const int SUPPORT_TASK_CORE = 0;  // Reference: CONFIG_ARDUINO_RUNNING_CORE = 1
 
+// Priority of the segment prep task enabled by stepping/prep_task. It must be above the main
+// loop (1) so that parsing never delays the refill of the step segment buffer.
+const int PREP_TASK_PRIORITY = 3;
+
 // Serial baud rate
 // OK to change, but the ESP32 boot text is 115200, so you will not see that is your
 // serial monitor, sender, etc uses a different value than 115200
@@ -138,13 +148,26 @@ const int REPORT_WCO_REFRESH_IDLE_COUNT = 10;  // (2-255) Must be less than or e
 // NOTE: Changing this value also changes the execution time of a segment in the step segment buffer.
 // When increasing this value, this stores less overall time in the segment buffer and vice versa. Make
 // certain the step segment buffer is increased/decreased to account for these changes.
+// This is the default for stepping/acceleration_ticks_per_sec, which sets it per machine.
 const int ACCELERATION_TICKS_PER_SECOND = 100;
 
+// Damping ratio assumed by the input shapers selected with shaper_type on each axis. The shapers
+// are tuned to the frequency given by shaper_freq_hz; typical machine frames are lightly damped,
+// and the ZVD and MZV shapers tolerate a fair error in this value.
+const float SHAPER_DAMPING_RATIO = 0.1f;
+
 // Sets which axis the tool length offset is applied. Assumes the spindle is always parallel with
 // the selected axis with the tool oriented toward the negative direction. In other words, a positive
 // tool length offset value is subtracted from the current location.
 const int TOOL_LENGTH_OFFSET_AXIS = Z_AXIS;  // Default z-axis. Valid values are X_AXIS, Y_AXIS, or Z_AXIS.
 
+// When a new block is added, the planner normally replans every block after the last optimally
+// planned one. With this option, the reverse pass stops at the first block whose entry speed does
+// not change and the forward pass covers only the replanned window. The resulting plan is the same,
+// but the cost per block no longer grows with stepping/planner_blocks. Disable to use the
+// traditional full replanning.
+const bool PLANNER_OPTIMAL_WINDOW = true;
+
 // Minimum planner junction speed. Sets the default minimum junction speed the planner plans to at
 // every buffer block junction, except for starting from rest and end of the buffer, which are always
 // zero. This value controls how fast the machine moves through junctions with no regard for acceleration
@@ -194,6 +217,8 @@ const double ARC_ANGULAR_TRAVEL_EPSILON = 5E-7;  // Float (radians)
 // NOTE: Most setting changes - $ commands - are blocked when a job is running. Coordinate setting
 // GCode commands (G10,G28/30.1) are not blocked, since they are part of an active streaming job.
 // This option forces a planner buffer sync only with such GCode commands.
+// Coordinate changes are written when the machine is idle, or by $Settings/Flush, so
+// the sync rarely has anything to wait for.
 const bool FORCE_BUFFER_SYNC_DURING_NVS_WRITE = true;  // Default enabled. Comment to disable.
 
 // In old versions of Grbl, v0.9 and prior, there is a bug where the `WPos:` work position reported
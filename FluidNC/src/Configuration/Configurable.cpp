@@ -0,0 +1,55 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Configurable.h"
+
+#include "../BumpArena.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <new>
+
+namespace Configuration {
+    // A typical config fits in a few chunks of this size
+    static const size_t arenaChunkSize = 4096;
+
+    static BumpArena& arena() {
+        static BumpArena instance(arenaChunkSize);
+        return instance;
+    }
+
+    // The task that has an ArenaScope open, if any.  Other tasks keep using the heap.
+    static void* _arenaOwner = nullptr;
+
+    void* Configurable::operator new(size_t size) {
+        if (_arenaOwner && _arenaOwner == xTaskGetCurrentTaskHandle()) {
+            if (void* p = arena().allocate(size)) {
+                return p;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void Configurable::operator delete(void* p) {
+        if (!p || arena().owns(p)) {
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    Configurable::ArenaScope::ArenaScope() : _previousOwner(_arenaOwner) {
+        _arenaOwner = xTaskGetCurrentTaskHandle();
+    }
+
+    Configurable::ArenaScope::~ArenaScope() {
+        _arenaOwner = _previousOwner;
+    }
+
+    size_t Configurable::arena_used() {
+        return arena().used();
+    }
+
+    size_t Configurable::arena_reserved() {
+        return arena().reserved();
+    }
+}
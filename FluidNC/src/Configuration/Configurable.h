@@ -6,6 +6,8 @@
 #include "Generator.h"
 #include "Parser.h"
 
+#include <cstddef>
+
 namespace Configuration {
     class HandlerBase;
 
@@ -25,5 +27,27 @@ namespace Configuration {
         // virtual const char* name() const = 0;
 
         virtual ~Configurable() {}
+
+        // While an ArenaScope is open, configuration objects that its task creates
+        // with new are carved from one shared arena instead of the heap, so the many
+        // small objects built while parsing the config do not fragment the heap.
+        // delete runs the destructor but leaves arena memory in place, since the
+        // objects live as long as the configuration.
+        static void* operator new(size_t size);
+        static void  operator delete(void* p);
+
+        class ArenaScope {
+            void* _previousOwner;
+
+        public:
+            ArenaScope();
+            ArenaScope(const ArenaScope&)            = delete;
+            ArenaScope& operator=(const ArenaScope&) = delete;
+            ~ArenaScope();
+        };
+
+        // Bytes handed out and bytes reserved by the arena
+        static size_t arena_used();
+        static size_t arena_reserved();
     };
 }
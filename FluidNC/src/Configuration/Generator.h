@@ -4,7 +4,8 @@
 #pragma once
 
 #include <vector>
-#include <sstream>
+#include <cstdio>
+#include <cstring>
 
 #include "../Pin.h"
 #include "../Report.h"    // report_gcode_modes()
@@ -41,17 +42,24 @@ namespace Configuration {
     public:
         Generator(Channel& dst, int indent = 0);
 
-        void send_item(const char* name, const std::string& value) {
-            LogStream s(dst_, "");
+        // Each line is formatted straight into a LogStream, whose buffer is on
+        // the stack, and sent before the next one is started, so the size of the
+        // tree does not affect how much memory a dump needs.
+        void start_item(LogStream& s, const char* name) {
             lastIsNewline_ = false;
             for (int i = 0; i < indent_ * 2; ++i) {
                 s << ' ';
             }
             s << name;
             s << ": ";
+        }
+
+        void send_item(const char* name, const char* value) {
+            LogStream s(dst_, "");
+            start_item(s, name);
 
             // If value contains a colon, wrap text as string
-            if (value.find(':') == std::string::npos) {
+            if (!strchr(value, ':')) {
                 s << value;
             } else {
                 s << "'";
@@ -60,30 +68,39 @@ namespace Configuration {
             }
         }
 
+        void send_item(const char* name, const std::string& value) { send_item(name, value.c_str()); }
+
         void item(const char* name, int& value, const int32_t minValue, const int32_t maxValue) override {
-            send_item(name, std::to_string(value));
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%d", value);
+            send_item(name, buf);
         }
 
         void item(const char* name, uint32_t& value, const uint32_t minValue, const uint32_t maxValue) override {
-            send_item(name, std::to_string(value));
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%u", unsigned(value));
+            send_item(name, buf);
         }
 
         void item(const char* name, float& value, const float minValue, const float maxValue) override {
-            send_item(name, std::to_string(value));
+            char buf[48];
+            snprintf(buf, sizeof(buf), "%f", value);  // Same format as std::to_string()
+            send_item(name, buf);
         }
 
         void item(const char* name, std::vector<speedEntry>& value) {
             if (value.size() == 0) {
                 send_item(name, "None");
             } else {
-                std::ostringstream s;
-                s.precision(2);
+                LogStream s(dst_, "");
+                start_item(s, name);
                 const char* separator = "";
                 for (speedEntry n : value) {
-                    s << separator << n.speed << "=" << std::fixed << n.percent << "%";
+                    s << separator << unsigned(n.speed) << "=";
+                    s.print(n.percent, 2);
+                    s << "%";
                     separator = " ";
                 }
-                send_item(name, s.str());
             }
         }
 
@@ -91,44 +108,45 @@ namespace Configuration {
             if (value.size() == 0) {
                 send_item(name, "None");
             } else {
-                std::ostringstream s;
-                s.precision(3);
-                s << std::fixed;
+                LogStream s(dst_, "");
+                start_item(s, name);
                 const char* separator = "";
                 for (float n : value) {
-                    s << separator << n;
+                    s << separator;
+                    s.print(n, 3);
                     separator = " ";
                 }
-                send_item(name, s.str());
             }
         }
 
         void item(const char* name, UartData& wordLength, UartParity& parity, UartStop& stopBits) override {
-            std::string s;
-            s += std::to_string(int(wordLength) - int(UartData::Bits5) + 5);
+            char        parityChar = 'N';
+            const char* stopString = "1";
             switch (parity) {
                 case UartParity::Even:
-                    s += 'E';
+                    parityChar = 'E';
                     break;
                 case UartParity::Odd:
-                    s += 'O';
+                    parityChar = 'O';
                     break;
                 case UartParity::None:
-                    s += 'N';
+                    parityChar = 'N';
                     break;
             }
             switch (stopBits) {
                 case UartStop::Bits1:
-                    s += '1';
+                    stopString = "1";
                     break;
                 case UartStop::Bits1_5:
-                    s += "1.5";
+                    stopString = "1.5";
                     break;
                 case UartStop::Bits2:
-                    s += '2';
+                    stopString = "2";
                     break;
             }
-            send_item(name, s);
+            char buf[8];
+            snprintf(buf, sizeof(buf), "%d%c%s", int(wordLength) - int(UartData::Bits5) + 5, parityChar, stopString);
+            send_item(name, buf);
         }
 
         void item(const char* name, std::string& value, const int minLength, const int maxLength) override { send_item(name, value); }
@@ -15,7 +15,7 @@
 #include <string_view>
 
 namespace Configuration {
-    Parser::Parser(std::string_view yaml_string) : Tokenizer(yaml_string) {}
+    Parser::Parser(std::string_view yaml_string, bool compiled) : Tokenizer(yaml_string, compiled) {}
 
     void Parser::parseError(const char* description) const {
         // Attempt to use the correct position in the parser:
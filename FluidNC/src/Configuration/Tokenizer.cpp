@@ -8,10 +8,64 @@
 #include "parser_logging.h"
 
 #include <cstdlib>
+#include <string>
 
 namespace Configuration {
 
-    Tokenizer::Tokenizer(std::string_view yaml_string) : _remainder(yaml_string), _linenum(0), _token() {}
+    Tokenizer::Tokenizer(std::string_view yaml_string, bool compiled) :
+        _remainder(yaml_string), _compiled(compiled), _linenum(0), _token() {}
+
+    // A compiled record is four little-endian 16-bit fields - indent, line number,
+    // key length and value length - followed by the key and value bytes.
+    static const size_t recordHeaderSize = 8;
+
+    static void put16(std::string& out, size_t value) {
+        out += char(value & 0xff);
+        out += char((value >> 8) & 0xff);
+    }
+
+    static size_t get16(std::string_view in, size_t offset) {
+        return uint8_t(in[offset]) | (uint8_t(in[offset + 1]) << 8);
+    }
+
+    std::string Tokenizer::compile(std::string_view yaml_string) {
+        Tokenizer   tokenizer(yaml_string);
+        std::string out;
+        for (tokenizer.Tokenize(); tokenizer._token._state != TokenState::Eof; tokenizer.Tokenize()) {
+            auto& token = tokenizer._token;
+            if (token._indent > 0xffff || tokenizer._linenum > 0xffff || token._key.size() > 0xffff || token._value.size() > 0xffff) {
+                tokenizer.ParseError("Too large to compile");
+            }
+            put16(out, token._indent);
+            put16(out, tokenizer._linenum);
+            put16(out, token._key.size());
+            put16(out, token._value.size());
+            out += token._key;
+            out += token._value;
+        }
+        return out;
+    }
+
+    // Loads the next compiled record into _token.  Returns false at end of input
+    bool Tokenizer::nextRecord() {
+        if (_remainder.empty()) {
+            return false;
+        }
+        if (_remainder.size() < recordHeaderSize) {
+            ParseError("Truncated compiled configuration");
+        }
+        size_t keyLen   = get16(_remainder, 4);
+        size_t valueLen = get16(_remainder, 6);
+        if (_remainder.size() < recordHeaderSize + keyLen + valueLen) {
+            ParseError("Truncated compiled configuration");
+        }
+        _token._indent = get16(_remainder, 0);
+        _linenum       = get16(_remainder, 2);
+        _token._key    = _remainder.substr(recordHeaderSize, keyLen);
+        _token._value  = _remainder.substr(recordHeaderSize + keyLen, valueLen);
+        _remainder.remove_prefix(recordHeaderSize + keyLen + valueLen);
+        return true;
+    }
 
     bool Tokenizer::isWhiteSpace(char c) {
         return c == ' ' || c == '\t' || c == '\f' || c == '\r';
@@ -150,7 +204,11 @@ namespace Configuration {
         // We parse 1 line at a time. Each time we get here, we can assume that the cursor
         // is at the start of the line.
 
-        if (nextLine()) {
+        if (_compiled) {
+            if (nextRecord()) {
+                return;
+            }
+        } else if (nextLine()) {
             parseKey();
             parseValue();
             return;
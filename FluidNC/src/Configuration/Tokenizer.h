@@ -6,18 +6,21 @@
 
 #include "TokenState.h"
 #include "../Config.h"
+#include <string>
 #include <string_view>
 
 namespace Configuration {
 
     class Tokenizer {
         std::string_view _remainder;
+        bool             _compiled;
 
         bool isWhiteSpace(char c);
         bool isIdentifierChar(char c);
         bool nextLine();
         void parseKey();
         void parseValue();
+        bool nextRecord();
 
     public:
         int              _linenum;
@@ -39,8 +42,14 @@ namespace Configuration {
         void ParseError(const char* description) const;
 
     public:
-        explicit Tokenizer(std::string_view yaml_string);
+        // If compiled is true, the input is the output of compile() rather than YAML text
+        explicit Tokenizer(std::string_view yaml_string, bool compiled = false);
         void                    Tokenize();
+
+        // Tokenizes YAML text into a record per key, holding the indent, line number,
+        // key and value, so a later Tokenizer can replay the tokens without scanning
+        // the text, comments and blank lines again.  Throws ParseException like Tokenize().
+        static std::string compile(std::string_view yaml_string);
         inline std::string_view key() const { return _token._key; }
     };
 }
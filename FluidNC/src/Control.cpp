@@ -8,16 +8,16 @@
 
 Control::Control() {
     // The SafetyDoor pin must be defined first because it is checked explicity in safety_door_ajar()
-    _pins.push_back(new ControlPin(&safetyDoorEvent, "safety_door_pin", 'D'));
-    _pins.push_back(new ControlPin(&rtResetEvent, "reset_pin", 'R'));
-    _pins.push_back(new ControlPin(&feedHoldEvent, "feed_hold_pin", 'H'));
+    _pins.push_back(new ControlPin(&safetyDoorEvent, "safety_door_pin", 'D', ControlPin::Fast::Hold));
+    _pins.push_back(new ControlPin(&rtResetEvent, "reset_pin", 'R', ControlPin::Fast::Halt));
+    _pins.push_back(new ControlPin(&feedHoldEvent, "feed_hold_pin", 'H', ControlPin::Fast::Hold));
     _pins.push_back(new ControlPin(&cycleStartEvent, "cycle_start_pin", 'S'));
     _pins.push_back(new ControlPin(&macro0Event, "macro0_pin", '0'));
     _pins.push_back(new ControlPin(&macro1Event, "macro1_pin", '1'));
     _pins.push_back(new ControlPin(&macro2Event, "macro2_pin", '2'));
     _pins.push_back(new ControlPin(&macro3Event, "macro3_pin", '3'));
-    _pins.push_back(new ControlPin(&faultPinEvent, "fault_pin", 'F'));
-    _pins.push_back(new ControlPin(&faultPinEvent, "estop_pin", 'E'));
+    _pins.push_back(new ControlPin(&faultPinEvent, "fault_pin", 'F', ControlPin::Fast::Halt));
+    _pins.push_back(new ControlPin(&faultPinEvent, "estop_pin", 'E', ControlPin::Fast::Halt));
 }
 
 void Control::init() {
@@ -42,6 +42,16 @@ std::string Control::report_status() {
     return ret;
 }
 
+uint32_t Control::report_bits() {
+    uint32_t bits = 0;
+    for (size_t i = 0; i < _pins.size(); i++) {
+        if (_pins[i]->get()) {
+            bits |= 1 << i;
+        }
+    }
+    return bits;
+}
+
 bool Control::pins_block_unlock() {
     std::string blockers("FE"); // Fault, E-Stop block unlock and homing
     for (auto pin : _pins) {
@@ -26,6 +26,9 @@ public:
 
     std::string report_status();
 
+    // The active pins as bits, in the order of _pins
+    uint32_t report_bits();
+
     bool startup_check();
 
     ~Control() = default;
@@ -1,6 +1,20 @@
 #include "ControlPin.h"
 
+#include "Protocol.h"  // protocol_start_hold_early()
+#include "Stepper.h"   // Stepper::wake_prep_task_from_ISR()
+#include "System.h"    // sys
+#include "Report.h"
+#include "Driver/fluidnc_gpio.h"
+
+#include <esp_timer.h>
+
 namespace Machine {
+    ControlPin* volatile ControlPin::_holdPin = nullptr;
+    ControlPin* volatile ControlPin::_haltPin = nullptr;
+
+    ControlPin* ControlPin::_fastPins[MAX_FAST_PINS];
+    int         ControlPin::_nFastPins = 0;
+
     // cppcheck-suppress unusedFunction
     void ControlPin::init() {
         if (_pin.undefined()) {
@@ -9,5 +23,81 @@ namespace Machine {
         _pin.report(_legend);
         _pin.setAttr(Pin::Attr::Input);
         _pin.registerEvent(static_cast<EventPin*>(this));
+
+        if (_fastAction != Fast::None && _pin.capabilities().has(Pin::Capabilities::Native) && _nFastPins < MAX_FAST_PINS) {
+            _fast.resolve(_pin);
+            _fastPins[_nFastPins++] = this;
+            gpio_add_interrupt(_pin.index(), GPIO_EDGE_ANY, edge_isr, this);
+        }
+    }
+
+    void IRAM_ATTR ControlPin::record_latency(int64_t now) {
+        _lastLatency = uint32_t(now - _edgeUs);
+        if (_lastLatency > _maxLatency) {
+            _maxLatency = _lastLatency;
+        }
+        ++_count;
+    }
+
+    // The polled event path still runs the pin's event, which changes the state, and
+    // does everything else.  The edge only gets the motion stopping sooner, in the
+    // states where the event would stop it.  A hold needs the prep task, because
+    // starting one takes the prep lock.
+    void IRAM_ATTR ControlPin::edge_isr(void* arg) {
+        ControlPin* p = static_cast<ControlPin*>(arg);
+        if (!p->_fast.read()) {
+            return;
+        }
+        p->_edgeUs  = esp_timer_get_time();
+        State state = sys.state;
+
+        if (p->_fastAction == Fast::Hold) {
+            if (state == State::Cycle || state == State::Jog) {
+                _holdPin = p;
+                if (!Stepper::wake_prep_task_from_ISR()) {
+                    _holdPin = nullptr;
+                }
+            }
+        } else {
+            // The states in which protocol_do_rt_reset() stops stepping
+            if (state == State::Cycle || state == State::Jog || sys.step_control.executeHold || sys.step_control.executeSysMotion) {
+                _haltPin = p;
+            }
+        }
+    }
+
+    void ControlPin::start_pending_hold() {
+        ControlPin* p = _holdPin;
+        if (p == nullptr) {
+            return;
+        }
+        _holdPin = nullptr;
+        protocol_start_hold_early();
+        p->record_latency(esp_timer_get_time());
+    }
+
+    bool IRAM_ATTR ControlPin::halt_requested() {
+        ControlPin* p = _haltPin;
+        if (p == nullptr) {
+            return false;
+        }
+        _haltPin = nullptr;
+        p->record_latency(esp_timer_get_time());
+        return true;
+    }
+
+    void ControlPin::cancel_halt() { _haltPin = nullptr; }
+
+    void ControlPin::report_latency(Channel& out) {
+        if (_nFastPins == 0) {
+            log_string(out, "No control pins with fast actions");
+            return;
+        }
+        for (int i = 0; i < _nFastPins; i++) {
+            auto p = _fastPins[i];
+            log_stream(out,
+                       p->_legend << (p->_fastAction == Fast::Hold ? " hold" : " stop") << " latency : " << p->_lastLatency << "us max "
+                                  << p->_maxLatency << "us count " << p->_count);
+        }
     }
 };
@@ -1,15 +1,48 @@
 #pragma once
 
 #include "Pin.h"
+#include "FastPin.h"
 #include "Machine/EventPin.h"
+
+#include <cstdint>
+
+class Channel;
+
 namespace Machine {
     class ControlPin : public EventPin {
+    public:
+        // What a native GPIO pin does from its edge interrupt, before its event
+        // reaches the main loop
+        enum class Fast : uint8_t {
+            None,
+            Hold,  // Start decelerating from the segment prep task
+            Halt,  // Stop the step timer, as a reset during motion does
+        };
+
     private:
         char _letter;  // The name that appears in init() messages and the name of the configuration item
         Pin  _pin;
+        Fast _fastAction;
+
+        FastPin          _fast;
+        volatile int64_t _edgeUs      = 0;  // Time of the last active edge
+        uint32_t         _lastLatency = 0;  // Edge to deceleration or stop, in us
+        uint32_t         _maxLatency  = 0;
+        uint32_t         _count       = 0;  // Fast actions taken
+
+        static ControlPin* volatile _holdPin;  // Waiting for the prep task
+        static ControlPin* volatile _haltPin;  // Waiting for the step ISR
+
+        static const int   MAX_FAST_PINS = 8;
+        static ControlPin* _fastPins[MAX_FAST_PINS];
+        static int         _nFastPins;
+
+        void                  record_latency(int64_t now);
+        static void IRAM_ATTR edge_isr(void* arg);
 
     public:
-        ControlPin(const Event* event, const char* legend, char letter) : EventPin(event, legend), _letter(letter) {}
+        ControlPin(const Event* event, const char* legend, char letter, Fast fast = Fast::None) :
+            EventPin(event, legend), _letter(letter), _fastAction(fast) {}
 
         void init();
 
@@ -19,6 +52,18 @@ namespace Machine {
 
         char letter() { return _letter; };
 
+        // Called by the prep task on each pass to start a hold that a pin asked for
+        static void start_pending_hold();
+
+        // Called from the stepper ISR; true if a pin asked it to stop the step timer
+        static bool halt_requested();
+
+        // Called by Stepper::reset() so that a stop that was not needed is not kept
+        static void cancel_halt();
+
+        // Reports the edge to deceleration or stop latency of the fast pins
+        static void report_latency(Channel& out);
+
         ~ControlPin();
     };
 }
@@ -17,6 +17,17 @@ void CoolantControl::init() {
     _flood.setAttr(Pin::Attr::Output);
     _mist.setAttr(Pin::Attr::Output);
 
+    auto native = [](Pin& pin) { return pin.undefined() || pin.capabilities().has(Pin::Capabilities::Native); };
+    _syncable   = (_flood.defined() || _mist.defined()) && native(_flood) && native(_mist);
+    if (_syncable) {
+        if (_flood.defined()) {
+            _floodFast.resolve(_flood);
+        }
+        if (_mist.defined()) {
+            _mistFast.resolve(_mist);
+        }
+    }
+
     stop();
 }
 
@@ -44,6 +55,11 @@ CoolantState CoolantControl::get_state() {
 }
 
 void CoolantControl::write(CoolantState state) {
+    if (_syncable) {
+        // The stepper writes them too, which Pin::write() would not know about
+        sync_write(state);
+        return;
+    }
     if (_flood.defined()) {
         bool pinState = state.Flood;
         _flood.synchronousWrite(pinState);
@@ -70,6 +86,7 @@ void CoolantControl::stop() {
 // parser program end, and g-code parser CoolantControl::sync().
 
 void CoolantControl::set_state(CoolantState state) {
+    _queued = false;
     if (sys.abort || (_previous_state.Mist == state.Mist && _previous_state.Flood == state.Flood)) {
         return;  // Block during abort or if no change
     }
@@ -79,6 +96,30 @@ void CoolantControl::set_state(CoolantState state) {
         dwell_ms(_delay_ms, DwellMode::SysSuspend);
 }
 
+bool CoolantControl::queue_state(CoolantState from, CoolantState to) {
+    bool turning_on = (to.Mist && !from.Mist) || (to.Flood && !from.Flood);
+    if (!_syncable || (turning_on && _delay_ms)) {
+        return false;
+    }
+    _queued       = true;
+    _queued_state = to;
+    return true;
+}
+
+// The stepper has made the change if a block took it up, so this only writes the pins if not
+void CoolantControl::apply_queued() {
+    if (_queued) {
+        set_state(_queued_state);
+    }
+}
+
+// With a FastPin, a pin that is not defined is not written
+void IRAM_ATTR CoolantControl::sync_write(CoolantState state) {
+    _floodFast.write(state.Flood);
+    _mistFast.write(state.Mist);
+    _previous_state = state;
+}
+
 void CoolantControl::off() {
     CoolantState disable = {};
     set_state(disable);
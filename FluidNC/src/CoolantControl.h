@@ -5,7 +5,8 @@
 
 #include "Configuration/Configurable.h"
 
-#include "GCode.h"  // CoolantState
+#include "GCode.h"    // CoolantState
+#include "FastPin.h"
 
 class CoolantControl : public Configuration::Configurable {
     Pin _mist;
@@ -15,6 +16,13 @@ class CoolantControl : public Configuration::Configurable {
 
     CoolantState _previous_state = {};
 
+    // GPIO pins can be switched by the stepper as a block starts
+    FastPin      _mistFast;
+    FastPin      _floodFast;
+    bool         _syncable = false;
+    bool         _queued   = false;  // A change is left for the stepper, see queue_state()
+    CoolantState _queued_state;
+
     void write(CoolantState state);
 
 public:
@@ -36,6 +44,21 @@ public:
     void off();
     void set_state(CoolantState state);
 
+    // M7, M8 and M9 with motion queued are made by the stepper as the next block of the
+    // program starts, so that the machine does not stop for them.  Returns false if the
+    // change has to wait for the motion to finish instead, because the pins are not GPIOs
+    // or coolant is turning on and delay_ms has to pass before the next motion.
+    bool queue_state(CoolantState from, CoolantState to);
+
+    // Makes a queued change that no block has made, once the motion is done
+    void apply_queued();
+
+    // True if the stepper can switch the pins
+    bool syncable() const { return _syncable; }
+
+    // Called by the stepper as a block with a new coolant state starts
+    void IRAM_ATTR sync_write(CoolantState state);
+
     // Configuration handlers.
     void group(Configuration::HandlerBase& handler) override;
 
@@ -0,0 +1,61 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  CornerCurvature.h - cornering speeds from the curvature of a tessellated path
+
+  The junction deviation model limits the speed at each junction as if the machine rounded
+  that one corner with a circle whose distance from the corner is junction_deviation_mm.
+  A smooth surface that CAM has broken into short lines is not a series of corners, though;
+  the lines are chords of a curve, each within the CAM chord tolerance of it.  Following
+  that curve at speed v needs a centripetal acceleration of v^2/R, so the sustained speed
+  is bounded by sqrt(a * R) however the curve is divided into lines.
+
+  The radius at a junction is that of the circle through the start of the previous line,
+  the junction and the end of the next line.  The junction is treated as part of a curve
+  when both lines are within chord_tolerance of that circle and the radius at the junction
+  before agrees with it to within a factor of two, so a lone corner between two lines, or
+  the first and last junctions of a curve, keep the junction deviation speed.  The smaller
+  of the two radii sets the speed.
+
+  Units are those of the planner: mm, and mm/min^2 for acceleration.
+*/
+
+#include <cmath>
+
+struct CornerCurvature {
+    float _last_radius = 0.0f;  // Radius at the previous junction, 0 when it was not on a curve
+
+    void reset() { _last_radius = 0.0f; }
+
+    // Returns the square of the speed at which the curve through the junction between a line
+    // of prev_mm and a line of next_mm can be followed with the given acceleration, or 0 when
+    // the junction does not look like part of a curve.  cos_deflection is the dot product of
+    // the unit vectors of the two lines.
+    float junction_speed_sqr(float prev_mm, float next_mm, float cos_deflection, float chord_tolerance, float acceleration) {
+        float last   = _last_radius;
+        _last_radius = 0.0f;
+        if (chord_tolerance <= 0.0f || cos_deflection <= 0.0f || cos_deflection >= 1.0f) {
+            return 0.0f;
+        }
+        // The chord from the start of the previous line to the end of the next one faces the
+        // junction's outer angle, whose sine is that of the deflection.
+        float sin_deflection = sqrtf(1.0f - cos_deflection * cos_deflection);
+        float span           = sqrtf(prev_mm * prev_mm + next_mm * next_mm + 2.0f * prev_mm * next_mm * cos_deflection);
+        float radius         = span / (2.0f * sin_deflection);
+
+        // Sagitta of the longer line, the farthest it strays from the circle
+        float chord   = fmaxf(prev_mm, next_mm);
+        float sagitta = radius - sqrtf(fmaxf(0.0f, radius * radius - 0.25f * chord * chord));
+        if (sagitta > chord_tolerance) {
+            return 0.0f;
+        }
+        _last_radius = radius;
+        if (last == 0.0f || radius > 2.0f * last || last > 2.0f * radius) {
+            return 0.0f;
+        }
+        return acceleration * fminf(radius, last);
+    }
+};
@@ -0,0 +1,136 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "CpuProfile.h"
+
+#include "Channel.h"
+#include "Logging.h"
+#include "Protocol.h"  // drain_messages()
+#include "Driver/pc_sampler.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <cstdio>
+#include <cstdlib>
+#include <strings.h>
+#include <map>
+
+namespace CpuProfile {
+    static const uint32_t defaultRate = 1000;
+    static const uint32_t maxRate     = 20000;
+    static const size_t   maxSamples  = 8192;  // 64 KB; fewer if the heap is short
+
+    static pc_sample_t* buffer    = nullptr;
+    static size_t       n_samples = 0;
+    static uint32_t     rate      = defaultRate;
+
+    static void free_buffer() {
+        heap_caps_free(buffer);
+        buffer    = nullptr;
+        n_samples = 0;
+    }
+
+    static const char* task_name(void* task) {
+        // FluidNC tasks are never deleted, so a handle from a sample is still valid
+        return task ? pcTaskGetTaskName(TaskHandle_t(task)) : "?";
+    }
+
+    // The share of each core used by each task, like vTaskGetRunTimeStats(), along with
+    // the stack each task has never used
+    static void report_tasks(Channel& out, const size_t counts[2]) {
+        for (int core = 0; core < 2; core++) {
+            const pc_sample_t* samples = buffer + core * (n_samples / 2);
+
+            std::map<void*, size_t> per_task;
+            for (size_t i = 0; i < counts[core]; i++) {
+                ++per_task[samples[i].task];
+            }
+            log_stream(out, "Core " << core << ": " << counts[core] << " samples");
+            for (auto const& [task, count] : per_task) {
+                char line[80];
+                snprintf(line,
+                         sizeof(line),
+                         "  %-16s %5.1f%% stack free:%u",
+                         task_name(task),
+                         100.0f * count / counts[core],
+                         task ? unsigned(uxTaskGetStackHighWaterMark(TaskHandle_t(task))) : 0);
+                log_stream(out, line);
+            }
+        }
+    }
+
+    static void stream_samples(Channel& out, const size_t counts[2]) {
+        for (int core = 0; core < 2; core++) {
+            const pc_sample_t* samples = buffer + core * (n_samples / 2);
+            for (size_t i = 0; i < counts[core]; i++) {
+                char line[48];
+                snprintf(line, sizeof(line), "PC:%d,%s,%08x", core, task_name(samples[i].task), unsigned(samples[i].pc));
+                log_stream(out, line);
+                if ((i & 0xff) == 0xff) {
+                    drain_messages();  // Keep the output queue from overflowing
+                }
+            }
+        }
+        drain_messages();
+    }
+
+    // $CPU/Profile[=ON|<Hz>|OFF]
+    Error command(const char* value, Channel& out) {
+        if (!value || !*value) {
+            if (buffer) {
+                log_info_to(out, "CPU profile on at " << rate << " Hz, " << n_samples << " sample buffer");
+            } else {
+                log_info_to(out, "CPU profile off");
+            }
+            return Error::Ok;
+        }
+        if (strcasecmp(value, "OFF") == 0) {
+            if (!buffer) {
+                return Error::Ok;
+            }
+            size_t counts[2];
+            pc_sampler_stop(counts);
+            report_tasks(out, counts);
+            stream_samples(out, counts);
+            free_buffer();
+            return Error::Ok;
+        }
+
+        uint32_t hz = defaultRate;
+        if (strcasecmp(value, "ON") != 0) {
+            char* endptr;
+            hz = strtoul(value, &endptr, 10);
+            if (endptr == value || *endptr != '\0') {
+                return Error::InvalidValue;
+            }
+            if (hz == 0 || hz > maxRate) {
+                return Error::NumberRange;
+            }
+        }
+        if (buffer) {
+            size_t counts[2];
+            pc_sampler_stop(counts);
+            free_buffer();
+        }
+
+        // Leave room for the rest of the system
+        size_t n = maxSamples;
+        while (n > 256 && n * sizeof(pc_sample_t) > heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) / 2) {
+            n /= 2;
+        }
+        buffer = static_cast<pc_sample_t*>(heap_caps_malloc(n * sizeof(pc_sample_t), MALLOC_CAP_8BIT));
+        if (!buffer) {
+            log_error_to(out, "Not enough memory for a CPU profile");
+            return Error::InvalidStatement;
+        }
+        n_samples = n;
+        rate      = hz;
+        if (!pc_sampler_start(hz, buffer, n)) {
+            free_buffer();
+            log_error_to(out, "CPU profile timers are unavailable");
+            return Error::InvalidStatement;
+        }
+        return Error::Ok;
+    }
+}
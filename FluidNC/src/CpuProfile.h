@@ -0,0 +1,28 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  CpuProfile.h - statistical profiling of both CPU cores
+
+  $CPU/Profile=ON starts a timer interrupt on each core, at 1 kHz or at the rate
+  given as $CPU/Profile=<Hz>, that records the program counter and task it
+  interrupts, until the buffer is full.  $CPU/Profile=OFF stops the capture,
+  shows the share of each core used by each task, and then streams the samples
+  as lines of PC:<core>,<task>,<pc in hex> to the channel that asked, which may
+  be the WebSocket.  cpu-profile.py at the top of the repository reads a
+  capture, looks up the addresses in firmware.elf, and prints the functions
+  that use the most time.  Without a value, the command shows the progress.
+
+  Since samples are taken by a level 1 interrupt, time spent in higher level
+  interrupts such as the step ISR is charged to the task they interrupted.
+*/
+
+#include "Error.h"
+
+class Channel;
+
+namespace CpuProfile {
+    Error command(const char* value, Channel& out);
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "DirCache.h"
+#include "Driver/sdspi.h"  // sd_card_id()
+#include "PathBuffer.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace {
+    const size_t maxDirs = 8;
+    const size_t maxPath = 300;  // A FAT long name is up to 255 characters
+
+    struct Cached {
+        std::shared_ptr<const DirCache::Listing> listing;
+        uint32_t                                 cardId;
+        uint32_t                                 lastUse;
+    };
+
+    std::map<std::string, Cached> cache;
+    std::mutex                    cacheMutex;  // Listings are requested by both the web server and channels
+    uint32_t                      useCount = 0;
+
+    std::string key(const std::filesystem::path& path) {
+        std::string s(path.c_str());
+        while (s.length() > 1 && s.back() == '/') {
+            s.pop_back();
+        }
+        return s;
+    }
+
+    uint32_t card_id(const std::string& dir) {
+        return (dir.compare(0, 3, "/sd") == 0 && (dir.length() == 3 || dir[3] == '/')) ? sd_card_id() : 0;
+    }
+}
+
+std::shared_ptr<const DirCache::Listing> DirCache::list(const std::filesystem::path& dir, std::error_code& ec) {
+    std::string name = key(dir);
+    uint32_t    id   = card_id(name);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto                        it = cache.find(name);
+        if (it != cache.end()) {
+            if (it->second.cardId == id) {
+                it->second.lastUse = ++useCount;
+                return it->second.listing;
+            }
+            cache.erase(it);
+        }
+    }
+
+    // Read with readdir() and stat() on one PathBuffer, since a directory_iterator
+    // allocates several paths per entry
+    DIR* dirp = opendir(dir.c_str());
+    if (!dirp) {
+        ec.assign(errno, std::generic_category());
+        return nullptr;
+    }
+    ec.clear();
+    auto                 listing = std::make_shared<Listing>();
+    PathBuffer<maxPath>  entryPath(name);
+    size_t               base = entryPath.length();
+    const struct dirent* entp;
+    while ((entp = readdir(dirp)) != nullptr) {
+        if (!strcmp(entp->d_name, ".") || !strcmp(entp->d_name, "..")) {
+            continue;
+        }
+        bool      isDir = entp->d_type == DT_DIR;
+        uintmax_t size  = 0;
+        if (!isDir) {
+            // The size, and the type if readdir() did not give it, need a stat()
+            entryPath.truncate(base);
+            struct stat st;
+            if (entryPath.append(entp->d_name) && stat(entryPath.c_str(), &st) == 0) {
+                isDir = S_ISDIR(st.st_mode);
+                size  = isDir ? 0 : st.st_size;
+            }
+        }
+        listing->push_back({ entp->d_name, isDir, size });
+    }
+    closedir(dirp);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cache.size() == maxDirs) {
+        auto oldest = cache.begin();
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        cache.erase(oldest);
+    }
+    cache[name] = { listing, id, ++useCount };
+    return listing;
+}
+
+void DirCache::invalidate(const std::filesystem::path& path) {
+    std::string name   = key(path);
+    std::string parent = key(path.parent_path());
+    std::string below  = name + "/";
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto it = cache.begin(); it != cache.end();) {
+        const std::string& k = it->first;
+        if (k == name || k == parent || k.compare(0, below.length(), below) == 0) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
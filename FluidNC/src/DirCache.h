@@ -0,0 +1,40 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  DirCache.h - cached directory listings
+
+  Listing a directory with hundreds of files on an SD card takes seconds and competes
+  with a running job for the SPI bus, while WebUI and pendants list the same directory
+  again and again.  The entries of recently listed directories are kept in memory.
+  Every path that changes a directory through FluidNC - FileStream writes, and the
+  deletes and renames that update HashFS - invalidates its listing, and a listing
+  from the SD card is discarded if a different card has been inserted since.
+*/
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+class DirCache {
+public:
+    struct Entry {
+        std::string name;
+        bool        isDir;
+        uintmax_t   size;
+    };
+    using Listing = std::vector<Entry>;
+
+    // Reads the directory only if there is no valid cached listing.  Returns nullptr,
+    // with ec set, if the directory cannot be read.
+    static std::shared_ptr<const Listing> list(const std::filesystem::path& dir, std::error_code& ec);
+
+    // Discards the listings of path, of the directory that contains it, and of
+    // any directory below it.
+    static void invalidate(const std::filesystem::path& path);
+};
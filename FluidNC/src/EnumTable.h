@@ -0,0 +1,38 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  EnumTable.h - compile-time string tables indexed by enum value
+
+  The error and message texts are written as { Enum::Value, "text" } pairs so
+  that the list reads like the enum, but are looked up on every error ack and
+  feedback message.  enum_table() spreads the pairs into an array indexed by
+  the enum value when compiling, so the table is constant data in flash with
+  nothing built on the heap at boot, and a lookup is one index.
+*/
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+template <typename E>
+using EnumText = std::pair<E, const char*>;
+
+// Values with no entry in the list are nullptr; a value >= Size does not compile.
+template <size_t Size, typename E, size_t N>
+constexpr std::array<const char*, Size> enum_table(const EnumText<E> (&list)[N]) {
+    std::array<const char*, Size> table {};
+    for (size_t i = 0; i < N; ++i) {
+        table[size_t(list[i].first)] = list[i].second;
+    }
+    return table;
+}
+
+// The text for value, or nullptr if it has none
+template <size_t Size, typename E>
+inline const char* enum_text(const std::array<const char*, Size>& table, E value) {
+    size_t i = size_t(value);
+    return i < Size ? table[i] : nullptr;
+}
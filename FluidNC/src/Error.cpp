@@ -5,7 +5,7 @@
 
 #include "Error.h"
 
-const std::map<Error, const char*> ErrorNames = {
+static constexpr EnumText<Error> errorList[] = {
     { Error::Ok, "No error" },
     { Error::ExpectedCommandLetter, "Expected GCodecommand letter" },
     { Error::BadNumberFormat, "Bad GCode number format" },
@@ -90,3 +90,5 @@ const std::map<Error, const char*> ErrorNames = {
     { Error::ParameterAssignmentFailed, "Parameter Assignment Failed" },
     { Error::GcodeValueWordInvalid, "Gcode invalid word value" },
 };
+
+constexpr std::array<const char*, 256> ErrorNames = enum_table<256>(errorList);
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include "EnumTable.h"
+
 #include <map>
 #include <cstdint>
 
@@ -98,4 +100,5 @@ enum class Error : uint8_t {
 
 const char* errorString(Error errorNumber);
 
-extern const std::map<Error, const char*> ErrorNames;
+// Indexed by error code; nullptr for codes that are not used
+extern const std::array<const char*, 256> ErrorNames;
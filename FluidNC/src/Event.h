@@ -3,19 +3,39 @@
 
 #pragma once
 
+#include <cstdint>
+#include <mutex>
+
 // Objects derived from the Event base class are placed in the event queue.
 // Protocol dequeues them and calls their run methods.
+//
+// Events that stop or start motion - reset, feed hold, door, alarms and the
+// like - travel in a lane of their own that is emptied first, so they never
+// wait behind other events.  They stay in order among themselves, so a cycle
+// start followed by a hold still ends in a hold.
 class Event {
 public:
-    Event() {}
+    enum Lane : uint8_t {
+        Normal,
+        Motion,
+        Override,  // Coalesced; see OverrideEvent
+        N_LANES,
+    };
+
+    explicit Event(Lane lane = Normal) : _lane(lane) {}
     virtual void run(void* arg) const = 0;
+
+    Lane lane() const { return _lane; }
+
+private:
+    Lane _lane;
 };
 
 class NoArgEvent : public Event {
     void (*_function)() = nullptr;
 
 public:
-    explicit NoArgEvent(void (*function)()) : _function(function) {}
+    explicit NoArgEvent(void (*function)(), Lane lane = Normal) : Event(lane), _function(function) {}
     void run(void* arg) const override {
         if (_function) {
             _function();
@@ -27,10 +47,72 @@ class ArgEvent : public Event {
     void (*_function)(void*) = nullptr;
 
 public:
-    explicit ArgEvent(void (*function)(void*)) : _function(function) {}
+    explicit ArgEvent(void (*function)(void*), Lane lane = Normal) : Event(lane), _function(function) {}
     void run(void* arg) const override {
         if (_function) {
             _function(arg);
         }
     }
 };
+
+// Override changes can arrive much faster than the main loop takes them, for
+// example from a pendant knob.  They are not queued; each send is folded into
+// the pending change, which the main loop applies once when it handles events.
+// Increments add up, and a change to the default value drops the increments
+// before it.  An absolute override, such as the rapid override, takes values
+// rather than increments, and the latest value wins; the function then gets
+// the value in place of the increment.
+class OverrideEvent : public Event {
+    void (*_function)(bool toDefault, int increment) = nullptr;
+    int  _default;
+    bool _absolute;
+
+    mutable std::mutex _mutex;
+    mutable bool       _pending   = false;
+    mutable bool       _toDefault = false;
+    mutable int        _increment = 0;
+
+public:
+    OverrideEvent(void (*function)(bool toDefault, int increment), int dflt, bool absolute = false) :
+        Event(Override), _function(function), _default(dflt), _absolute(absolute) {}
+
+    // Returns true if the change was folded into one that was already pending
+    bool merge(int change) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        bool                        merged = _pending;
+        if (change == _default) {
+            _toDefault = true;
+            _increment = 0;
+        } else if (_absolute) {
+            _toDefault = false;
+            _increment = change;
+        } else {
+            _increment += change;
+        }
+        _pending = true;
+        return merged;
+    }
+
+    bool pending() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pending;
+    }
+
+    // Applies the pending change, if any; arg is not used
+    void run(void* arg) const override {
+        bool toDefault;
+        int  increment;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_pending) {
+                return;
+            }
+            toDefault  = _toDefault;
+            increment  = _increment;
+            _pending   = false;
+            _toDefault = false;
+            _increment = 0;
+        }
+        _function(toDefault, increment);
+    }
+};
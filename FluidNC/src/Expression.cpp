@@ -29,13 +29,15 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define DEGRAD (180 / M_PI)
-#define RADDEG (M_PI / 180)
-#define TOLERANCE_EQUAL 0.00001
+// float, so that the conversions are not done in software double precision
+#define DEGRAD float(180 / M_PI)
+#define RADDEG float(M_PI / 180)
+#define TOLERANCE_EQUAL 0.00001f
 
 #include "Error.h"
 
 #include "Expression.h"
+#include "Job.h"  // Job::source()
 
 #define MAX_STACK 7
 
@@ -129,9 +131,6 @@ static Error execute_binary1(float& lhs, ngc_binary_op_t operation, const float&
             status = Error::ExpressionUnknownOp;
     }
 
-    if (status != Error::Ok)
-        report_param_error(status);
-
     return status;
 }
 
@@ -219,88 +218,119 @@ static Error execute_binary(float& lhs, ngc_binary_op_t operation, const float&
     return execute_binary2(lhs, operation, rhs);
 }
 
-/*! \brief Executes an unary operation: ABS, ACOS, ASIN, COS, EXP, FIX, FUP, LN, ROUND, SIN, SQRT, TAN
+// The unary functions, indexed by ngc_unary_op_t.  All angle measures in the input
+// or output are in degrees.
+static Error unary_abs(float& operand) {
+    operand = fabsf(operand);
+    return Error::Ok;
+}
 
-All angle measures in the input or output are in degrees.
+static Error unary_acos(float& operand) {
+    if (operand < -1.0f || operand > 1.0f) {
+        return Error::ExpressionArgumentOutOfRange;  // Argument to ACOS out of range
+    }
+    operand = acosf(operand) * DEGRAD;
+    return Error::Ok;
+}
 
-\param operand pointer to the operand.
-\param operation \ref ngc_binary_op_t enum value.
-\returns #Error::Ok enum value if processed without error, appropriate \ref Error enum value if not.
-*/
-static Error execute_unary(float& operand, ngc_unary_op_t operation) {
-    Error status = Error::Ok;
+static Error unary_asin(float& operand) {
+    if (operand < -1.0f || operand > 1.0f) {
+        return Error::ExpressionArgumentOutOfRange;  // Argument to ASIN out of range
+    }
+    operand = asinf(operand) * DEGRAD;
+    return Error::Ok;
+}
 
-    switch (operation) {
-        case Unary_ABS:
-            if (operand < 0.0f)
-                operand = (-1.0f * operand);
-            break;
+static Error unary_cos(float& operand) {
+    operand = cosf(operand * RADDEG);
+    return Error::Ok;
+}
 
-        case Unary_ACOS:
-            if (operand < -1.0f || operand > 1.0f)
-                status = Error::ExpressionArgumentOutOfRange;  // Argument to ACOS out of range
-            else
-                operand = acosf(operand) * DEGRAD;
-            break;
+static Error unary_exp(float& operand) {
+    operand = expf(operand);
+    return Error::Ok;
+}
 
-        case Unary_ASIN:
-            if (operand < -1.0f || operand > 1.0f)
-                status = Error::ExpressionArgumentOutOfRange;  // Argument to ASIN out of range
-            else
-                operand = asinf(operand) * DEGRAD;
-            break;
+static Error unary_fix(float& operand) {
+    operand = floorf(operand);
+    return Error::Ok;
+}
 
-        case Unary_COS:
-            operand = cosf(operand * RADDEG);
-            break;
+static Error unary_fup(float& operand) {
+    operand = ceilf(operand);
+    return Error::Ok;
+}
 
-        case Unary_Exists:
-            // do nothing here, result for the EXISTS function is set by read_unary()
-            break;
+static Error unary_ln(float& operand) {
+    if (operand <= 0.0f) {
+        return Error::ExpressionArgumentOutOfRange;  // Argument to LN out of range
+    }
+    operand = logf(operand);
+    return Error::Ok;
+}
 
-        case Unary_EXP:
-            operand = expf(operand);
-            break;
+static Error unary_round(float& operand) {
+    operand = (float)((int)(operand + ((operand < 0.0f) ? -0.5f : 0.5f)));
+    return Error::Ok;
+}
 
-        case Unary_FIX:
-            operand = floorf(operand);
-            break;
+static Error unary_sin(float& operand) {
+    operand = sinf(operand * RADDEG);
+    return Error::Ok;
+}
 
-        case Unary_FUP:
-            operand = ceilf(operand);
-            break;
+static Error unary_sqrt(float& operand) {
+    if (operand < 0.0f) {
+        return Error::ExpressionArgumentOutOfRange;  // Negative argument to SQRT
+    }
+    operand = sqrtf(operand);
+    return Error::Ok;
+}
 
-        case Unary_LN:
-            if (operand <= 0.0f)
-                status = Error::ExpressionArgumentOutOfRange;  // Argument to LN out of range
-            else
-                operand = logf(operand);
-            break;
+static Error unary_tan(float& operand) {
+    operand = tanf(operand * RADDEG);
+    return Error::Ok;
+}
 
-        case Unary_Round:
-            operand = (float)((int)(operand + ((operand < 0.0f) ? -0.5f : 0.5f)));
-            break;
+// The result for the EXISTS function is set by read_unary(), and ATAN takes two
+// arguments, so neither is applied here
+static Error unary_none(float& operand) {
+    return Error::Ok;
+}
 
-        case Unary_SIN:
-            operand = sinf(operand * RADDEG);
-            break;
+typedef Error (*unary_function_t)(float& operand);
+
+static const unary_function_t unary_functions[] = {
+    nullptr,      // 0 is not an operator
+    unary_abs,    // Unary_ABS
+    unary_acos,   // Unary_ACOS
+    unary_asin,   // Unary_ASIN
+    nullptr,      // Unary_ATAN
+    unary_cos,    // Unary_COS
+    unary_exp,    // Unary_EXP
+    unary_fix,    // Unary_FIX
+    unary_fup,    // Unary_FUP
+    unary_ln,     // Unary_LN
+    unary_round,  // Unary_Round
+    unary_sin,    // Unary_SIN
+    unary_sqrt,   // Unary_SQRT
+    unary_tan,    // Unary_TAN
+    unary_none,   // Unary_Exists
+};
 
-        case Unary_SQRT:
-            if (operand < 0.0f)
-                status = Error::ExpressionArgumentOutOfRange;  // Negative argument to SQRT
-            else
-                operand = sqrtf(operand);
-            break;
+/*! \brief Executes an unary operation: ABS, ACOS, ASIN, COS, EXP, FIX, FUP, LN, ROUND, SIN, SQRT, TAN
 
-        case Unary_TAN:
-            operand = tanf(operand * RADDEG);
-            break;
+All angle measures in the input or output are in degrees.
 
-        default:
-            status = Error::ExpressionUnknownOp;
+\param operand pointer to the operand.
+\param operation \ref ngc_binary_op_t enum value.
+\returns #Error::Ok enum value if processed without error, appropriate \ref Error enum value if not.
+*/
+static Error execute_unary(float& operand, ngc_unary_op_t operation) {
+    if (size_t(operation) >= sizeof(unary_functions) / sizeof(unary_functions[0]) || !unary_functions[operation]) {
+        return Error::ExpressionUnknownOp;
     }
-
-    return status;
+    return unary_functions[operation](operand);
 }
 
 /*! \brief Returns an integer representing the precedence level of an operator.
@@ -716,8 +746,10 @@ Error expression(const char* line, size_t& pos, float& value) {
             stack_index++;
         else {  // precedence of latest operator is <= previous precedence
             for (; precedence(operators[stack_index]) <= precedence(operators[stack_index - 1]);) {
-                if ((status = execute_binary(values[stack_index - 1], operators[stack_index - 1], values[stack_index])) != Error::Ok)
+                if ((status = execute_binary(values[stack_index - 1], operators[stack_index - 1], values[stack_index])) != Error::Ok) {
+                    report_param_error(status);
                     return status;
+                }
 
                 operators[stack_index - 1] = operators[stack_index];
                 // auto o1 = operators[stack_index - 1];
@@ -737,3 +769,375 @@ Error expression(const char* line, size_t& pos, float& value) {
 
     return Error::Ok;
 }
+
+// Compiled expressions.  The compiler follows the text evaluator above step for step,
+// emitting an operation where the evaluator computes something, so the code leaves on
+// the stack the same values that the evaluator holds in values[].
+
+typedef enum {
+    Code_Constant = 0,   // Push value
+    Code_NumberedParam,  // Push parameter number value
+    Code_NamedParam,     // Push parameter names[arg]
+    Code_IndirectParam,  // Replace the top with the parameter that it numbers
+    Code_Exists,         // Push whether parameter names[arg] exists
+    Code_Negate,         // Negate the top
+    Code_Unary,          // Apply unary operator arg to the top
+    Code_Atan,           // Replace the top two with their ATAN
+    Code_Binary,         // Replace the top two with binary operator arg applied to them
+} ngc_expr_code_t;
+
+struct ExpressionCompiler {
+    ExpressionCode& code;
+    size_t          depth = 0;
+
+    explicit ExpressionCompiler(ExpressionCode& c) : code(c) {}
+
+    // True if the last n ops are all constants, so the top n values are known now
+    bool constants(size_t n) {
+        if (code.ops.size() < n) {
+            return false;
+        }
+        for (size_t i = code.ops.size() - n; i < code.ops.size(); i++) {
+            if (code.ops[i].code != Code_Constant) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Applies an operator to constant operands now instead of at each evaluation,
+    // leaving its result as a constant.  An operator that would fail is left for
+    // the evaluator to fail on.
+    bool fold(ngc_expr_code_t op, uint8_t arg) {
+        auto& ops = code.ops;
+        switch (op) {
+            case Code_Negate:
+                if (constants(1)) {
+                    ops.back().value = -ops.back().value;
+                    return true;
+                }
+                break;
+            case Code_Unary:
+                if (constants(1)) {
+                    float value = ops.back().value;
+                    if (execute_unary(value, ngc_unary_op_t(arg)) == Error::Ok) {
+                        ops.back().value = value;
+                        return true;
+                    }
+                }
+                break;
+            case Code_Atan:
+                if (constants(2)) {
+                    float value = atan2f(ops[ops.size() - 2].value, ops.back().value) * DEGRAD;
+                    ops.pop_back();
+                    ops.back().value = value;
+                    return true;
+                }
+                break;
+            case Code_Binary:
+                if (constants(2)) {
+                    float value = ops[ops.size() - 2].value;
+                    if (execute_binary(value, ngc_binary_op_t(arg), ops.back().value) == Error::Ok) {
+                        ops.pop_back();
+                        ops.back().value = value;
+                        return true;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+        return false;
+    }
+
+    Error emit(ngc_expr_code_t op, uint8_t arg = 0, float value = 0.0f) {
+        if (fold(op, arg)) {
+            if (op == Code_Atan || op == Code_Binary) {
+                --depth;
+            }
+            return Error::Ok;
+        }
+        code.ops.push_back({ uint8_t(op), arg, value });
+        switch (op) {
+            case Code_Constant:
+            case Code_NumberedParam:
+            case Code_NamedParam:
+            case Code_Exists:
+                if (++depth > ExpressionCode::max_depth) {
+                    return Error::ExpressionSyntaxError;
+                }
+                break;
+            case Code_Atan:
+            case Code_Binary:
+                --depth;
+                break;
+            default:
+                break;
+        }
+        return Error::Ok;
+    }
+
+    Error emit_name(ngc_expr_code_t op, const std::string& name) {
+        if (code.names.size() > UINT8_MAX) {
+            return Error::ExpressionSyntaxError;
+        }
+        code.names.push_back(name);
+        return emit(op, uint8_t(code.names.size() - 1));
+    }
+
+    // As get_param_ref() followed by get_param(), with the initial # already consumed
+    Error param(const char* line, size_t& pos) {
+        char  c = line[pos];
+        float id;
+        Error status;
+        switch (c) {
+            case '#':
+                ++pos;
+                if ((status = param(line, pos)) != Error::Ok) {
+                    return status;
+                }
+                return emit(Code_IndirectParam);
+            case '<': {
+                std::string name;
+                ++pos;
+                while ((c = line[pos]) && c != '>') {
+                    ++pos;
+                    if (!isspace(c)) {
+                        name += toupper(c);
+                    }
+                }
+                if (!c) {
+                    return Error::BadNumberFormat;
+                }
+                ++pos;
+                return emit_name(Code_NamedParam, name);
+            }
+            case '[':
+                if ((status = expression(line, pos)) != Error::Ok) {
+                    return status;
+                }
+                return emit(Code_IndirectParam);
+            default:
+                if (!read_float(line, pos, id)) {
+                    return Error::BadNumberFormat;
+                }
+                return emit(Code_NumberedParam, 0, id);
+        }
+    }
+
+    // As read_unary()
+    Error unary(const char* line, size_t& pos) {
+        ngc_unary_op_t operation;
+        Error          status;
+        if ((status = read_operation_unary(line, pos, operation)) != Error::Ok) {
+            return status;
+        }
+        if (line[pos] != '[') {
+            return Error::ExpressionSyntaxError;
+        }
+        if (operation == Unary_Exists) {
+            ++pos;
+            std::string arg;
+            char        c;
+            while ((c = line[pos]) && c != ']') {
+                ++pos;
+                arg += c;
+            }
+            if (!c) {
+                return Error::ExpressionSyntaxError;
+            }
+            ++pos;
+            return emit_name(Code_Exists, arg);
+        }
+        if ((status = expression(line, pos)) != Error::Ok) {
+            return status;
+        }
+        if (operation == Unary_ATAN) {
+            if (line[pos] != '/') {
+                return Error::ExpressionSyntaxError;
+            }
+            pos++;
+            if (line[pos] != '[') {
+                return Error::ExpressionSyntaxError;
+            }
+            if ((status = expression(line, pos)) != Error::Ok) {
+                return status;
+            }
+            return emit(Code_Atan);
+        }
+        return emit(Code_Unary, uint8_t(operation));
+    }
+
+    // As read_number() with in_expression
+    Error number(const char* line, size_t& pos) {
+        char  c = line[pos];
+        float value;
+        Error status;
+        switch (c) {
+            case '#':
+                ++pos;
+                return param(line, pos);
+            case '[':
+                return expression(line, pos);
+            case '-':
+                ++pos;
+                if ((status = number(line, pos)) != Error::Ok) {
+                    return status;
+                }
+                return emit(Code_Negate);
+            case '+':
+                ++pos;
+                return number(line, pos);
+            default:
+                if (isalpha(c)) {
+                    return unary(line, pos);
+                }
+                if (!read_float(line, pos, value)) {
+                    return Error::BadNumberFormat;
+                }
+                return emit(Code_Constant, 0, value);
+        }
+    }
+
+    // As expression()
+    Error expression(const char* line, size_t& pos) {
+        ngc_binary_op_t operators[MAX_STACK];
+        uint_fast8_t    stack_index = 1;
+        Error           status;
+
+        if (line[pos] != '[') {
+            return Error::GcodeUnsupportedCommand;
+        }
+        pos++;
+
+        if ((status = number(line, pos)) != Error::Ok) {
+            return status;
+        }
+        if ((status = read_operation(line, pos, operators[0])) != Error::Ok) {
+            return status;
+        }
+        while (operators[0] != Binary_RightBracket) {
+            if (stack_index == MAX_STACK) {
+                return Error::ExpressionSyntaxError;
+            }
+            if ((status = number(line, pos)) != Error::Ok) {
+                return status;
+            }
+            if ((status = read_operation(line, pos, operators[stack_index])) != Error::Ok) {
+                return status;
+            }
+            if (precedence(operators[stack_index]) > precedence(operators[stack_index - 1])) {
+                stack_index++;
+            } else {
+                for (; precedence(operators[stack_index]) <= precedence(operators[stack_index - 1]);) {
+                    if ((status = emit(Code_Binary, uint8_t(operators[stack_index - 1]))) != Error::Ok) {
+                        return status;
+                    }
+                    operators[stack_index - 1] = operators[stack_index];
+                    if ((stack_index > 1) && precedence(operators[stack_index - 1]) <= precedence(operators[stack_index - 2])) {
+                        stack_index--;
+                    } else {
+                        break;
+                    }
+                }
+            }
+        }
+        return Error::Ok;
+    }
+};
+
+Error compile_expression(const char* line, size_t& pos, ExpressionCode& code) {
+    size_t             start = pos;
+    ExpressionCompiler compiler(code);
+    Error              status = compiler.expression(line, pos);
+    if (status == Error::Ok) {
+        code.text.assign(line + start, pos - start);
+    }
+    return status;
+}
+
+Error evaluate_expression(const ExpressionCode& code, float& value) {
+    float  stack[ExpressionCode::max_depth];
+    size_t sp = 0;
+    Error  status;
+    for (auto const& op : code.ops) {
+        switch (op.code) {
+            case Code_Constant:
+                stack[sp++] = op.value;
+                break;
+            case Code_NumberedParam:
+                if (!get_numbered_param(ngc_param_id_t(op.value), stack[sp++])) {
+                    return Error::BadNumberFormat;
+                }
+                break;
+            case Code_NamedParam:
+                if (!get_named_param(code.names[op.arg], stack[sp++])) {
+                    return Error::BadNumberFormat;
+                }
+                break;
+            case Code_IndirectParam:
+                if (!get_numbered_param(ngc_param_id_t(stack[sp - 1]), stack[sp - 1])) {
+                    return Error::BadNumberFormat;
+                }
+                break;
+            case Code_Exists: {
+                std::string name = code.names[op.arg];
+                stack[sp++]      = named_param_exists(name) ? 1.0 : 0.0;
+            } break;
+            case Code_Negate:
+                stack[sp - 1] = -stack[sp - 1];
+                break;
+            case Code_Unary:
+                if (execute_unary(stack[sp - 1], ngc_unary_op_t(op.arg)) != Error::Ok) {
+                    return Error::BadNumberFormat;
+                }
+                break;
+            case Code_Atan:
+                --sp;
+                stack[sp - 1] = atan2f(stack[sp - 1], stack[sp]) * DEGRAD;
+                break;
+            case Code_Binary:
+                --sp;
+                if ((status = execute_binary(stack[sp - 1], ngc_binary_op_t(op.arg), stack[sp])) != Error::Ok) {
+                    return status;
+                }
+                break;
+        }
+    }
+    value = stack[0];
+    return Error::Ok;
+}
+
+Error cached_expression(const char* line, size_t& pos, float& value) {
+    JobSource* source = Job::source();
+    if (!source) {
+        return expression(line, pos, value);
+    }
+    // The position of the source is that of the next line, so with the offset in the
+    // line it identifies the expression.  The text check covers sources that are not
+    // files, whose position does not change.
+    auto&  cache = source->expressions();
+    size_t key   = source->position() * Channel::maxLine + pos;
+    auto   it    = cache.find(key);
+    if (it == cache.end() || strncmp(line + pos, it->second.text.c_str(), it->second.text.length())) {
+        if (it == cache.end() && cache.size() == JobSource::max_expressions) {
+            return expression(line, pos, value);
+        }
+        ExpressionCode code;
+        size_t         end = pos;
+        if (compile_expression(line, end, code) != Error::Ok) {
+            return expression(line, pos, value);
+        }
+        if (it == cache.end()) {
+            it = cache.emplace(key, std::move(code)).first;
+        } else {
+            it->second = std::move(code);
+        }
+    }
+    if (evaluate_expression(it->second, value) != Error::Ok) {
+        // Let the text evaluator find and report the error
+        return expression(line, pos, value);
+    }
+    pos += it->second.text.length();
+    return Error::Ok;
+}
@@ -1,3 +1,36 @@
 #pragma once
+
+#include "Error.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 Error expression(const char* line, size_t& pos, float& value);
 Error read_unary(const char* line, size_t& pos, float& value);
+
+// An expression compiled to a sequence of stack operations, so an expression that
+// is executed repeatedly, as in the body of an O-code loop, is parsed only once.
+struct ExpressionCode {
+    static const size_t max_depth = 16;  // Of the evaluation stack
+
+    struct Op {
+        uint8_t code;
+        uint8_t arg;    // Operator, or index of a name
+        float   value;  // Constant, or parameter number
+    };
+    std::vector<Op>          ops;
+    std::vector<std::string> names;  // Of named parameters
+    std::string              text;   // The source, from [ to the matching ]
+};
+
+// Compiles the expression at line[pos], advancing pos past it.
+Error compile_expression(const char* line, size_t& pos, ExpressionCode& code);
+
+// Evaluates compiled code.  It is silent on errors; the text evaluator reports them.
+Error evaluate_expression(const ExpressionCode& code, float& value);
+
+// Like expression(), but while a job is running, it compiles the expression on first
+// use and evaluates the copy cached in the job source thereafter.
+Error cached_expression(const char* line, size_t& pos, float& value);
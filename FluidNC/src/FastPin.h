@@ -0,0 +1,51 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "Pin.h"
+#include "Driver/fluidnc_gpio.h"
+
+// A pin that is written from an ISR, resolved once to what a write has to touch.
+// For a native GPIO that is the set or clear register with the pin's bit, so a
+// write is one store with no virtual call, no dedup check and no attribute Assert.
+// Other pins, like I2SO, fall back to Pin::synchronousWrite().
+//
+// The registers are captured from the pin as it is when resolve() is called, so
+// it must be called after setAttr() has made the pin an output.  A pin that has
+// a FastPin should not also be written through Pin::write(), since GPIOPinDetail
+// would skip writes that match the value it saw last.
+class FastPin {
+    gpio_fast_t _regs {};
+    const Pin*  _pin    = nullptr;
+    bool        _native = false;
+
+public:
+    void resolve(Pin& pin) {
+        _pin    = &pin;
+        _native = pin.defined() && pin.capabilities().has(Pin::Capabilities::Native);
+        if (_native) {
+            gpio_fast_resolve(pin.index(), pin.inverted(), &_regs);
+        }
+    }
+
+    inline void IRAM_ATTR write(bool high) const {
+        if (_native) {
+            *(high ? _regs.on : _regs.off) = _regs.mask;
+        } else if (_pin) {
+            _pin->synchronousWrite(high);
+        }
+    }
+
+    // For a native GPIO, the registers that a write touches, so that Axes can write
+    // several pins that share a register with one store
+    bool               native() const { return _native; }
+    const gpio_fast_t& regs() const { return _regs; }
+
+    inline bool IRAM_ATTR read() const {
+        if (_native) {
+            return ((*_regs.in & _regs.mask) != 0) ^ _regs.inverted;
+        }
+        return _pin && _pin->read();
+    }
+};
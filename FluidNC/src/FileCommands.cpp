@@ -7,11 +7,22 @@
 #include "src/Configuration/JsonGenerator.h"
 #include "src/InputFile.h"  // InputFile
 #include "src/Job.h"        // Job::
-#include "src/xmodem.h"     // xmodemReceive(), xmodemTransmit()
+#include "src/JobStats.h"   // JobStats::set_file()
+#include "src/xmodem.h"     // xmodemReceive(), xmodemTransmit(), ymodemReceive()
 #include "src/Protocol.h"   // pollingPaused
+#include "src/CompiledGCode.h"  // CompiledGCode::compile_line()
+#include "src/GCode.h"          // gc_execute_line(), gc_state
+#include "src/PathBuffer.h"     // path_split_name()
+#include "src/System.h"         // set_state(), sys
+#include "src/Machine/MachineConfig.h"
+#include "src/JobEstimate.h"  // JobEstimate::begin()
 
 #include "src/HashFS.h"
+#include "src/DirCache.h"
+#include "src/SettingsDefinitions.h"  // config_filename
+#include "Driver/flashdata.h"
 
+#include <algorithm>
 #include <charconv>
 
 static Error localFSSize(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP720
@@ -70,7 +81,11 @@ static Error showFile(const char* fs, const char* parameter, AuthenticationLevel
         // task has a chance to forward the line to the output channel.
         // The 3-argument form works because it copies the line to a
         // temporary string.
-        log_stream(out, fileLine);
+        if (fileLine[0] == CompiledGCode::words_record) {
+            log_stream(out, CompiledGCode::to_text(fileLine));
+        } else {
+            log_stream(out, fileLine);
+        }
     }
     if (res != Error::Eof) {
         log_string(out, errorString(res));
@@ -151,7 +166,11 @@ static Error fileShowSome(const char* parameter, AuthenticationLevel auth_level,
         Error res;
         for (int linenum = 0; linenum < lastline && (res = theFile->readLine(fileLine, 255)) == Error::Ok; ++linenum) {
             if (linenum >= firstline) {
-                j.string(fileLine);
+                if (fileLine[0] == CompiledGCode::words_record) {
+                    j.string(CompiledGCode::to_text(fileLine).c_str());
+                } else {
+                    j.string(fileLine);
+                }
             }
         }
         delete theFile;
@@ -261,10 +280,186 @@ static Error runFile(const char* fs, const char* parameter, AuthenticationLevel
         return err;
     }
     Job::nest(theFile, &out);
+    JobStats::set_file(theFile->path());
 
     return Error::Ok;
 }
 
+// $Job/Queue=<file>[,<file>...] runs the files one after another as one job.  With
+// no job active the first file starts at once; otherwise they run after the job.
+// Without a value the queue is shown.
+static Error queueFiles(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+    if (!parameter || !*parameter) {
+        Job::show_queue(out);
+        return Error::Ok;
+    }
+    for (std::string_view rest(parameter); !rest.empty();) {
+        auto        comma = rest.find(',');
+        std::string path(rest.substr(0, comma));
+        rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+        if (path.empty()) {
+            continue;
+        }
+        if (path[0] != '/') {
+            path = "/" + path;
+        }
+        if (!Job::active()) {
+            Error err = runFile(sdName, path.c_str(), auth_level, out);
+            if (err != Error::Ok) {
+                return err;
+            }
+            continue;
+        }
+        // Check now, rather than when the job is running, that the file is there
+        std::error_code ec;
+        FluidPath       fpath { path, sdName, ec };
+        if (ec || !stdfs::is_regular_file(fpath, ec)) {
+            log_error_to(out, "No file " << path);
+            return Error::FsFileNotFound;
+        }
+        Job::enqueue(sdName, path);
+    }
+    return Error::Ok;
+}
+
+// Writes a pre-parsed copy of a G-code file, with the extension .gcb, that $SD/Run
+// and $LocalFS/Run execute without parsing the text of plain motion lines.
+static Error compileFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+    if (notIdleOrAlarm()) {
+        return Error::IdleError;
+    }
+    InputFile* theFile;
+    Error      err;
+    if ((err = openFile(sdName, parameter, out, theFile)) != Error::Ok) {
+        return err;
+    }
+    std::string outPath(theFile->path());
+    auto        dot = outPath.rfind('.');
+    if (dot != std::string::npos && outPath.find('/', dot) == std::string::npos) {
+        outPath.erase(dot);
+    }
+    outPath += ".gcb";
+
+    FileStream* outFile;
+    try {
+        outFile = new FileStream(outPath, "w");
+    } catch (Error err) {
+        delete theFile;
+        return err;
+    }
+
+    char        fileLine[Channel::maxLine];
+    std::string record;
+    size_t      lines    = 0;
+    size_t      compiled = 0;
+    Error       res;
+    while ((res = theFile->readLine(fileLine, Channel::maxLine)) == Error::Ok) {
+        record.clear();
+        CompiledGCode::compile_line(fileLine, record);
+        if (record[0] == CompiledGCode::words_record) {
+            ++compiled;
+        }
+        ++lines;
+        if (outFile->write(reinterpret_cast<const uint8_t*>(record.data()), record.length()) != record.length()) {
+            res = Error::FsFailedCreateFile;
+            break;
+        }
+    }
+    delete outFile;
+    delete theFile;
+    if (res != Error::Eof) {
+        log_error_to(out, errorString(res));
+        return res;
+    }
+    log_info_to(out, outPath << ": " << compiled << " of " << lines << " lines compiled");
+    return Error::Ok;
+}
+
+// Runs every line of a G-code file through the parser in check mode, without
+// acking each line or going through the protocol loop, and reports the errors,
+// the machine position bounds and the run time.  The moves go through the
+// planner to time them, see JobEstimate.h, and the estimate is kept for the
+// job progress report when the file is run.  Lines that need the file to be a
+// running job, like O-word loops, are errors.
+static Error checkFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+    if (!state_is(State::Idle)) {
+        return Error::IdleError;
+    }
+    InputFile* theFile;
+    Error      err;
+    if ((err = openFile(sdName, parameter, out, theFile)) != Error::Ok) {
+        return err;
+    }
+
+    const size_t maxErrors    = 10;    // Errors listed; the rest are only counted
+    const size_t pollInterval = 1000;  // Lines between checks for reset and status requests
+    auto         n_axis       = Axes::_numberAxis;
+
+    parser_state_t saved = gc_state;
+    set_state(State::CheckMode);
+    JobEstimate::begin(theFile->path(), theFile->size());
+
+    float  lo[MAX_N_AXIS];
+    float  hi[MAX_N_AXIS];
+    size_t lines  = 0;
+    size_t errors = 0;
+    copyAxes(lo, gc_state.position);
+    copyAxes(hi, gc_state.position);
+
+    char fileLine[Channel::maxLine];
+    while ((err = theFile->readLine(fileLine, Channel::maxLine)) == Error::Ok) {
+        if (++lines % pollInterval == 0) {
+            protocol_execute_realtime();
+            if (sys.abort) {
+                err = Error::Reset;
+                break;
+            }
+        }
+        char* line = fileLine;
+        while (isspace(*line)) {
+            ++line;
+        }
+        if (*line == '\0' || *line == '$' || *line == '[' || *line == '%') {
+            continue;
+        }
+        Error status = gc_execute_line(line);
+        JobEstimate::mark(theFile->position());
+        if (status != Error::Ok) {
+            if (errors++ < maxErrors) {
+                auto lineNumber = theFile->lineNumber();
+                log_error_to(out, "Line " << lineNumber << ": " << static_cast<int>(status) << " (" << errorString(status) << ")");
+            }
+            continue;
+        }
+        for (size_t axis = 0; axis < n_axis; axis++) {
+            lo[axis] = std::min(lo[axis], gc_state.position[axis]);
+            hi[axis] = std::max(hi[axis], gc_state.position[axis]);
+        }
+    }
+    delete theFile;
+
+    float minutes = 0;
+    if (err == Error::Eof) {
+        minutes = JobEstimate::end();
+    } else {
+        JobEstimate::abort();
+    }
+    set_state(State::Idle);
+    gc_state = saved;
+
+    if (err != Error::Eof) {
+        log_error_to(out, errorString(err));
+        return err;
+    }
+    log_info_to(out, lines << " lines, " << errors << " errors");
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        log_info_to(out, Axes::_names[axis] << " MPos " << lo[axis] << " to " << hi[axis]);
+    }
+    uint32_t seconds = uint32_t(minutes * 60.0f);
+    log_info_to(out, "Run time " << seconds / 3600 << "h " << seconds / 60 % 60 << "m " << seconds % 60 << "s");
+    return Error::Ok;
+}
+
 static Error runSDFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP220
     return runFile("sd", parameter, auth_level, out);
 }
@@ -346,16 +541,21 @@ static Error listFilesystemJSON(const char* fs, const char* value, Authenticatio
     try {
         FluidPath fpath { value, fs };
         auto      space = stdfs::space(fpath);
-        auto      iter  = stdfs::directory_iterator { fpath };
+
+        std::error_code ec;
+        auto            listing = DirCache::list(fpath, ec);
+        if (!listing) {
+            throw stdfs::filesystem_error { "Cannot list directory", fpath, ec };
+        }
 
         JSONencoder j(false, &out);
         j.begin();
 
         j.begin_array("files");
-        for (auto const& dir_entry : iter) {
+        for (auto const& entry : *listing) {
             j.begin_object();
-            j.member("name", dir_entry.path().filename());
-            j.member("size", dir_entry.is_directory() ? -1 : dir_entry.file_size());
+            j.member("name", entry.name);
+            j.member("size", entry.isDir ? -1 : int(entry.size));
             j.end_object();
         }
         j.end_array();
@@ -403,18 +603,18 @@ static Error listGCodeFiles(const char* parameter, AuthenticationLevel auth_leve
 
     j.begin_array("files");
     if (!*error) {  // Array is empty for failure to open the volume
-        auto iter = stdfs::directory_iterator { fpath, ec };
-        if (ec) {
+        auto listing = DirCache::list(fpath, ec);
+        if (!listing) {
             // Array is empty for failure to open the path
             error = "Bad path";
         } else {
-            for (auto const& dir_entry : iter) {
-                auto fn     = dir_entry.path().filename();
-                auto is_dir = dir_entry.is_directory();
-                if (out.is_visible(fn.stem(), fn.extension(), is_dir)) {
+            for (auto const& entry : *listing) {
+                std::string_view stem, extension;
+                path_split_name(entry.name, stem, extension);
+                if (out.is_visible(stem, extension, entry.isDir)) {
                     j.begin_object();
-                    j.member("name", dir_entry.path().filename());
-                    j.member("size", is_dir ? -1 : dir_entry.file_size());
+                    j.member("name", entry.name);
+                    j.member("size", entry.isDir ? -1 : int(entry.size));
                     j.end_object();
                 }
             }
@@ -511,6 +711,7 @@ static Error copyDir(const char* iDir, const char* oDir, Channel& out) {  // No
                 log_error_to(out, "Cannot create " << oDir);
                 return Error::FsFailedOpenDir;
             }
+            DirCache::invalidate(outDir);
         }
     }
 
@@ -546,8 +747,8 @@ static Error copyDir(const char* iDir, const char* oDir, Channel& out) {  // No
     return err;
 }
 static Error showLocalFSHashes(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
-    for (const auto& [name, hash] : HashFS::localFsHashes) {
-        log_info_to(out, name << ": " << hash);
+    for (const auto& [name, entry] : HashFS::localFsHashes) {
+        log_info_to(out, name << ": " << (entry.hash.length() ? entry.hash : "(not yet hashed)"));
     }
     return Error::Ok;
 }
@@ -620,6 +821,42 @@ static Error xmodem_receive(const char* value, AuthenticationLevel auth_level, C
     return size < 0 ? Error::UploadFailed : Error::Ok;
 }
 
+static Error ymodem_receive_files(const char* value, Channel& out, bool streaming) {
+    if (!value) {
+        value = "";
+    }
+    pollingPaused = true;
+    bool oldCr    = out.setCr(false);
+    delay_ms(1000);
+    int files = 0;
+    int size  = ymodemReceive(&out, value, streaming, [&files](FileStream* file, int len) {
+        std::filesystem::path fname = file->fpath();
+        if (len >= 0) {
+            ++files;
+        }
+        delete file;
+        HashFS::rehash_file(fname);
+    });
+    out.setCr(oldCr);
+    pollingPaused = false;
+    if (size >= 0) {
+        log_info("Received " << size << " bytes in " << files << " files");
+    } else {
+        log_info("Reception failed or was canceled");
+    }
+    return size < 0 ? Error::UploadFailed : Error::Ok;
+}
+
+static Error ymodem_receive(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return ymodem_receive_files(value, out, false);
+}
+
+// YMODEM-g streams blocks without waiting for acknowledgments, so it
+// can run at the full line rate, but any error aborts the transfer.
+static Error ymodem_receive_streaming(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return ymodem_receive_files(value, out, true);
+}
+
 static Error xmodem_send(const char* value, AuthenticationLevel auth_level, Channel& out) {
     if (!value || !*value) {
         value = "config.yaml";
@@ -645,6 +882,43 @@ static Error xmodem_send(const char* value, AuthenticationLevel auth_level, Chan
     return size < 0 ? Error::DownloadFailed : Error::Ok;
 }
 
+// Copies a configuration file, by default the current one, into a data partition
+// from which it can be loaded with $Config/Filename=@<label>
+static Error flashConfig(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // No ESP command
+    if (notIdleOrAlarm()) {
+        return Error::IdleError;
+    }
+    if (!parameter || !*parameter) {
+        log_error_to(out, "Missing partition label");
+        return Error::InvalidValue;
+    }
+    std::string_view args(parameter);
+    auto             comma = args.find(',');
+    std::string      lbl(args.substr(0, comma));
+    std::string      filename(comma == std::string_view::npos ? config_filename->get() : std::string(args.substr(comma + 1)));
+    if (filename.empty() || filename[0] == '@') {
+        log_error_to(out, "Name a configuration file");
+        return Error::InvalidValue;
+    }
+
+    std::string text;
+    try {
+        FileStream file(filename, "r", "");
+        text.resize(file.size());
+        if (file.read(text.data(), text.length()) != text.length()) {
+            return Error::FsFailedRead;
+        }
+    } catch (const Error err) {
+        log_error_to(out, "Cannot open " << filename);
+        return err;
+    }
+    if (flashdata_write(lbl.c_str(), text)) {
+        return Error::FsFailedCreateFile;
+    }
+    log_info_to(out, filename << " copied to partition " << lbl << "; use $Config/Filename=@" << lbl << " to load it");
+    return Error::Ok;
+}
+
 static Error restart(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
     log_info("Restarting");
     protocol_send_event(&fullResetEvent);
@@ -668,8 +942,11 @@ void make_file_commands() {
     new WebCommand("path", WEBCMD, WU, NULL, "File/SendJSON", fileSendJson);
     new WebCommand("path", WEBCMD, WU, NULL, "File/ShowSome", fileShowSome);
     new WebCommand("path", WEBCMD, WU, NULL, "File/ShowHash", fileShowHash);
+    new WebCommand("path", WEBCMD, WU, NULL, "File/Compile", compileFile);
+    new WebCommand("path", WEBCMD, WU, NULL, "File/Check", checkFile);
     new WebCommand("path", WEBCMD, WU, "ESP221", "SD/Show", showSDFile);
     new WebCommand("path", WEBCMD, WU, "ESP220", "SD/Run", runSDFile, nullptr);
+    new WebCommand("path[,path...]", WEBCMD, WU, NULL, "Job/Queue", queueFiles, nullptr);
     new WebCommand("file_or_directory_path", WEBCMD, WU, "ESP215", "SD/Delete", deleteSDObject);
     new WebCommand("path", WEBCMD, WU, NULL, "SD/Rename", renameSDObject);
     new WebCommand(NULL, WEBCMD, WU, "ESP210", "SD/List", listSDFiles);
@@ -678,6 +955,10 @@ void make_file_commands() {
     new WebCommand("path", WEBCMD, WU, NULL, "Files/ListGCode", listGCodeFiles);
     new UserCommand("XR", "Xmodem/Receive", xmodem_receive, allowConfigStates);
     new UserCommand("XS", "Xmodem/Send", xmodem_send, notIdleOrAlarm);
+    new UserCommand("YR", "Ymodem/Receive", ymodem_receive, allowConfigStates);
+    new UserCommand("YG", "Ymodem/ReceiveG", ymodem_receive_streaming, allowConfigStates);
+
+    new WebCommand("label[,file]", WEBCMD, WA, NULL, "Config/Flash", flashConfig);
 
     new WebCommand("RESTART", WEBCMD, WA, NULL, "Bye", restart);
 }
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "FileStream.h"
+#include "DirCache.h"
 #include "Machine/MachineConfig.h"  // config->
 
 std::string FileStream::path() {
@@ -17,6 +18,9 @@ int FileStream::available() {
 }
 
 int FileStream::read() {
+    if (_readAhead) {
+        return _readAhead->read();
+    }
     char   data;
     size_t res = fread(&data, 1, 1, _fd);
     return res == 1 ? data : -1;
@@ -29,6 +33,9 @@ int FileStream::peek() {
 void FileStream::flush() {}
 
 size_t FileStream::read(char* buffer, size_t length) {
+    if (_readAhead) {
+        return _readAhead->read((uint8_t*)buffer, length);
+    }
     return fread(buffer, 1, length, _fd);
 }
 
@@ -45,6 +52,9 @@ size_t FileStream::size() {
 }
 
 size_t FileStream::position() {
+    if (_readAhead) {
+        return _readAhead->position();
+    }
     return ftell(_fd);
 }
 
@@ -57,6 +67,9 @@ void FileStream::setup(const char* mode) {
         throw opening ? Error::FsFailedOpenFile : Error::FsFailedCreateFile;
     }
     _size = stdfs::file_size(_fpath);
+    if (*mode != 'r') {
+        DirCache::invalidate(_fpath);
+    }
 }
 
 FileStream::FileStream(const char* filename, const char* mode, const char* fs) : Channel(filename), _fpath(filename, fs), _mode(mode) {
@@ -68,12 +81,25 @@ FileStream::FileStream(FluidPath fpath, const char* mode) : Channel("file"), _mo
     setup(mode);
 }
 
+void FileStream::readAhead() {
+    _wantReadAhead = true;
+    if (!_readAhead && _fd) {
+        _readAhead = ReadAhead::create(_fd, ftell(_fd), _readStats);
+    }
+}
+
 void FileStream::set_position(size_t pos) {
+    if (_readAhead) {
+        _readAhead->seek(pos);
+        return;
+    }
     fseek(_fd, pos, SEEK_SET);
 }
 
 void FileStream::save() {
     _saved_position = position();
+    delete _readAhead;
+    _readAhead = nullptr;
     fclose(_fd);
     _fd = nullptr;
 }
@@ -82,13 +108,27 @@ void FileStream::restore() {
     _fd = fopen(_fpath.c_str(), _mode);
     if (_fd) {
         fseek(_fd, _saved_position, SEEK_SET);
+        if (_wantReadAhead) {
+            readAhead();
+        }
     } else {
         // XXX need to unwind the job stack somehow
     }
 }
 
 FileStream::~FileStream() {
+    if (_readAhead) {
+        delete _readAhead;
+        if (_readStats.fills) {
+            log_debug(_fpath.c_str() << " read: " << _readStats.fills << " fills, max " << _readStats.maxFillUs << "us, "
+                                     << _readStats.stalls << " stalls, max " << _readStats.maxStallUs << "us, total "
+                                     << uint32_t(_readStats.totalStallUs / 1000) << "ms");
+        }
+    }
     if (_fd) {
         fclose(_fd);
+        if (*_mode != 'r') {
+            DirCache::invalidate(_fpath);
+        }
     }
 }
@@ -12,6 +12,7 @@
 
 #include "Channel.h"
 #include "FluidPath.h"
+#include "ReadAhead.h"
 
 extern "C" {
 #include <stdio.h>
@@ -22,6 +23,11 @@ class FileStream : public Channel {
     FILE*     _fd;
     size_t    _size;
 
+    // Reads go through _readAhead when it is enabled and its buffers could be allocated
+    ReadAhead*       _readAhead     = nullptr;
+    bool             _wantReadAhead = false;
+    ReadAhead::Stats _readStats;
+
     // When another subordinate file is being run, we close the
     // current file to free up its file descriptor, saving the
     // position so we can reopen later and restore the position
@@ -38,6 +44,10 @@ public:
 
     FluidPath fpath() { return _fpath; }
 
+    // Reads the file through large double buffers filled in the background,
+    // for files that are read sequentially such as GCode jobs.
+    void readAhead();
+
     std::string path();
     std::string name();
     int         available() override;
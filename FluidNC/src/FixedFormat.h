@@ -0,0 +1,60 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  FixedFormat.h - decimal formatting of floats without iostreams
+
+  Status reports print every axis position, and often the work offsets, several
+  times a second on every channel.  Formatting them with std::fixed and
+  std::setprecision goes through the iostream locale machinery and allocates a
+  std::ostringstream each time.  format_fixed() scales the value to an integer
+  and writes the digits into the caller's buffer instead.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Room for any output of format_fixed(), including the terminating NUL
+const size_t fixedStringLen = 24;
+
+// Writes value with decimals (0 to 6) digits after the point, rounded half away
+// from zero, and returns the length.  Values too large to scale, and NaN and
+// infinity, go through snprintf().
+inline size_t format_fixed(char* buf, float value, int decimals) {
+    static const uint32_t scale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+    if (!(fabsf(value) < 1e12f)) {
+        return size_t(snprintf(buf, fixedStringLen, "%.*f", decimals, value));
+    }
+
+    uint64_t scaled = uint64_t(fabsf(value) * scale[decimals] + 0.5f);
+    char     digits[fixedStringLen];
+    size_t   n = 0;
+    for (int i = 0; i < decimals; i++) {
+        digits[n++] = '0' + scaled % 10;
+        scaled /= 10;
+    }
+    do {
+        digits[n++] = '0' + scaled % 10;
+        scaled /= 10;
+    } while (scaled);
+
+    char* p = buf;
+    if (value < 0.0f) {
+        *p++ = '-';
+    }
+    while (n > size_t(decimals)) {
+        *p++ = digits[--n];
+    }
+    if (decimals) {
+        *p++ = '.';
+        while (n) {
+            *p++ = digits[--n];
+        }
+    }
+    *p = '\0';
+    return p - buf;
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  FlightRecorder.h - the last seconds before an alarm or a reset
+
+  Fixed-size records of the machine state, line number, motor positions,
+  free planner blocks and step segments, and the last error are kept in a
+  ring in RAM that a reset or panic does not clear.  There are two rings,
+  and each boot records into the one that the boot before did not, so the
+  previous run survives until the next reset.  Records are claimed with an
+  atomic increment, so any task may record without a lock, and a record
+  cut short by a reset is recognized and skipped.
+
+  The polling task records a sample every 100 ms while the machine is
+  not idle; state changes, alarms and errors are recorded as they happen.
+  $Recorder/Dump shows the previous run, and $Recorder/Dump=current the
+  running one.
+*/
+
+#include "Channel.h"
+#include "Error.h"
+#include "Protocol.h"  // ExecAlarm
+
+namespace FlightRecorder {
+    // Called at boot, after StartupLog::init()
+    void init();
+
+    // Called by the polling task on each pass
+    void sample();
+
+    // Called by set_state() after the state has changed
+    void state_changed();
+    void alarm(ExecAlarm alarm);
+    void error(Error error);
+
+    void dump(Channel& out, bool previous);
+}
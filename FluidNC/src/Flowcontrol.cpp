@@ -125,7 +125,7 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
 
     switch (operation) {
         case Op_If:
-            if (!skipping && (status = expression(line, pos, value)) == Error::Ok) {
+            if (!skipping && (status = cached_expression(line, pos, value)) == Error::Ok) {
                 stack_push(o_label, operation, !value);
                 context.top().handled = value;
             }
@@ -134,7 +134,7 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
         case Op_ElseIf:
             if (last_op == Op_If || last_op == Op_ElseIf) {
                 if (o_label == context.top().o_label && !(context.top().skip = context.top().handled) && !context.top().handled &&
-                    (status = expression(line, pos, value)) == Error::Ok) {
+                    (status = cached_expression(line, pos, value)) == Error::Ok) {
                     if (!(context.top().skip = !value)) {
                         context.top().operation = operation;
                         context.top().handled   = true;
@@ -172,6 +172,7 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
                 if (!skipping) {
                     stack_push(o_label, operation, false);
                     context.top().file_pos = context.top().file->position();
+                    context.top().file->cache_lines(context.top().file_pos);
                 }
             } else {
                 status = Error::FlowControlNotExecutingMacro;
@@ -185,7 +186,7 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
                     if (last_op == Op_Do && o_label == context.top().o_label) {
                         stack_pull();
                     }
-                } else if (!skipping && (status = expression(line, pos, value)) == Error::Ok) {
+                } else if (!skipping && (status = cached_expression(line, pos, value)) == Error::Ok) {
                     if (last_op == Op_Do) {
                         if (o_label == context.top().o_label) {
                             if (value) {
@@ -200,6 +201,7 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
                             context.top().expr     = expr;
                             context.top().file     = Job::source();
                             context.top().file_pos = context.top().file->position();
+                            context.top().file->cache_lines(context.top().file_pos);
                         }
                     }
                 }
@@ -212,8 +214,8 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
             if (Job::active()) {
                 if (last_op == Op_While) {
                     if (!skipping && o_label == context.top().o_label) {
-                        uint_fast8_t pos = 0;
-                        if (!context.top().skip && (status = expression(context.top().expr.c_str(), pos, value)) == Error::Ok) {
+                        size_t pos = 0;
+                        if (!context.top().skip && (status = cached_expression(context.top().expr.c_str(), pos, value)) == Error::Ok) {
                             if (!(context.top().skip = value == 0)) {
                                 context.top().file->set_position(context.top().file_pos);
                             }
@@ -232,12 +234,13 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
 
         case Op_Repeat:
             if (Job::active()) {
-                if (!skipping && (status = expression(line, pos, value)) == Error::Ok) {
+                if (!skipping && (status = cached_expression(line, pos, value)) == Error::Ok) {
                     stack_push(o_label, operation, !value);
                     if (value) {
                         context.top().file     = Job::source();
                         context.top().file_pos = context.top().file->position();
                         context.top().repeats  = (uint32_t)value;
+                        context.top().file->cache_lines(context.top().file_pos);
                     }
                 }
             } else {
@@ -303,8 +306,8 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
                                 break;
 
                             case Op_While: {
-                                uint_fast8_t pos = 0;
-                                if (!context.top().skip && (status = expression(context.top().expr.c_str(), pos, value)) == Error::Ok) {
+                                size_t pos = 0;
+                                if (!context.top().skip && (status = cached_expression(context.top().expr.c_str(), pos, value)) == Error::Ok) {
                                     if (!(context.top().skip = value == 0)) {
                                         context.top().file->set_position(context.top().file_pos);
                                     }
@@ -328,13 +331,13 @@ Error flowcontrol(uint32_t o_label, char* line, size_t& pos, bool& skip) {
             break;
 
         case Op_RaiseAlarm:
-            if (!skipping && expression(line, pos, value) == Error::Ok) {
+            if (!skipping && cached_expression(line, pos, value) == Error::Ok) {
                 send_alarm((ExecAlarm)value);
             }
             break;
 
         case Op_RaiseError:
-            if (!skipping && expression(line, pos, value) == Error::Ok) {
+            if (!skipping && cached_expression(line, pos, value) == Error::Ok) {
                 status = (Error)value;
             }
             break;
@@ -8,12 +8,12 @@
 #include "Machine/MachineConfig.h"
 #include "FluidError.hpp"
 #include "HashFS.h"
+#include "PathBuffer.h"
 
 int FluidPath::_refcnt = 0;
 
 FluidPath::FluidPath(const char* name, const char* fs, std::error_code* ecptr) : std::filesystem::path(canonicalPath(name, fs)) {
-    auto mount = *(++begin());  // Use the path iterator to get the first component
-    _isSD      = mount == "sd";
+    _isSD = path_mount(native()) == sdName;
 
     if (_isSD) {
         if (!config->_sdCard->config_ok) {
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <string>
 #include "Driver/localfs.h"
+#include "PathBuffer.h"
 
 namespace stdfs = std::filesystem;
 
@@ -25,7 +26,7 @@ public:
 
     // true if there is something after the mount name.
     // /localfs/foo -> true,  /localfs -> false
-    bool hasTail() { return ++(++begin()) != end(); }
+    bool hasTail() { return path_has_tail(native()); }
 
 private:
     FluidPath(const char* name, const char* fs, std::error_code*);
@@ -10,6 +10,7 @@
 #include "Config.h"
 #include "Report.h"
 #include "Jog.h"
+#include "HeapStats.h"
 #include "Protocol.h"             // protocol_buffer_synchronize
 #include "MotionControl.h"        // mc_override_ctrl_update
 #include "Machine/UserOutputs.h"  // setAnalogPercent
@@ -20,6 +21,8 @@
 #include "Machine/MachineConfig.h"
 #include "Parameters.h"
 #include "Flowcontrol.h"
+#include "CompiledGCode.h"
+#include "Trace.h"
 
 #include <string.h>  // memset
 #include <math.h>    // sqrt etc.
@@ -39,6 +42,9 @@ static const int32_t MaxLineNumber = 10000000;
 parser_state_t gc_state;
 parser_block_t gc_block;
 
+// The P,Q offsets of the last G5, in mm.  A following G5 without I,J starts in that direction.
+static float spline_exit[2] = { 0.0f, 0.0f };
+
 // clang-format off
 gc_modal_t modal_defaults = {
     Motion::Seek,
@@ -56,7 +62,10 @@ gc_modal_t modal_defaults = {
     ToolChange::Disable,
     SetToolNumber::Disable,
     IoControl::None,
-    Override::ParkingMotion
+    Override::ParkingMotion,
+    RetractMode::OldZ,  // G98
+    Scaling::Disable,   // G50
+    Rotation::Disable   // G69
 };
 // clang-format on
 
@@ -67,6 +76,7 @@ void gc_init() {
     auto save_tlo = gc_state.tool_length_offset;  // we want TLO to persist until reboot.
     memset(&gc_state, 0, sizeof(parser_state_t));
     gc_state.tool_length_offset = save_tlo;
+    report_ngc_invalidate();  // G92 is cleared
 
     // Load default G54 coordinate system.
     gc_state.modal          = modal_defaults;
@@ -218,6 +228,7 @@ void collapseGCode(char* line) {
 }
 
 void gc_ngc_changed(CoordIndex coord) {
+    gc_offsets_changed();
     allChannels.notifyNgc(coord);
 }
 
@@ -226,12 +237,262 @@ void gc_ovr_changed() {
 }
 
 void gc_wco_changed() {
+    gc_offsets_changed();
     if (FORCE_BUFFER_SYNC_DURING_WCO_CHANGE) {
         protocol_buffer_synchronize();
     }
     allChannels.notifyWco();
 }
 
+void gc_offsets_changed() {
+    gc_state.program_map.valid = false;
+    report_ngc_invalidate();
+}
+
+static const gc_program_map_t& gc_program_map() {
+    auto& m = gc_state.program_map;
+    if (!m.valid || m.units != gc_state.modal.units) {
+        auto n_axis = Axes::_numberAxis;
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            bool linear   = idx < A_AXIS || idx > C_AXIS;
+            m.scale[idx]  = linear && gc_state.modal.units == Units::Inches ? MM_PER_INCH : 1.0f;
+            m.offset[idx] = gc_state.coord_system[idx] + gc_state.coord_offset[idx];
+        }
+        m.offset[TOOL_LENGTH_OFFSET_AXIS] += gc_state.tool_length_offset;
+        m.units = gc_state.modal.units;
+        m.valid = true;
+    }
+    return m;
+}
+
+// Recomputes the map of the programmed XYZ through G51 scaling and then G68 rotation, as
+// modal enables them, from the centers, factor and angle in t
+static void gc_update_transform(gc_transform_t& t, const gc_modal_t& modal) {
+    bool  scale  = modal.scaling == Scaling::Enable;
+    bool  rotate = modal.rotation == Rotation::Enable;
+    float k      = scale ? t.scale : 1.0f;
+    float c      = 1.0f;
+    float s      = 0.0f;
+    if (rotate) {
+        float angle = t.rotation * float(M_PI / 180.0);
+        c           = cosf(angle);
+        s           = sinf(angle);
+    }
+
+    // Scaling about its center leaves cs * (1 - k), and rotation turns that about its center
+    float v[3];
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            t.matrix[i][j] = i == j ? k : 0.0f;
+        }
+        v[i]        = scale ? t.scale_center[i] * (1.0f - k) : 0.0f;
+        t.offset[i] = v[i];
+    }
+    t.mapped = 0;
+    if (rotate) {
+        size_t a0 = t.axis_0;
+        size_t a1 = t.axis_1;
+
+        t.matrix[a0][a0] = k * c;
+        t.matrix[a0][a1] = -k * s;
+        t.matrix[a1][a0] = k * s;
+        t.matrix[a1][a1] = k * c;
+
+        v[a0] -= t.rotation_center[0];
+        v[a1] -= t.rotation_center[1];
+        t.offset[a0] = c * v[a0] - s * v[a1] + t.rotation_center[0];
+        t.offset[a1] = s * v[a0] + c * v[a1] + t.rotation_center[1];
+        t.mapped     = bitnum_to_mask(a0) | bitnum_to_mask(a1);
+    }
+    if (scale) {
+        t.mapped = bitnum_to_mask(X_AXIS) | bitnum_to_mask(Y_AXIS) | bitnum_to_mask(Z_AXIS);
+    }
+
+    // The linear part is k times a rotation, so its inverse is its transpose over k squared
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            t.inverse[i][j] = t.matrix[j][i] / (k * k);
+        }
+    }
+}
+
+// Scales and rotates a vector, like the IJK of an arc, without moving it
+static void transform_vector(const gc_transform_t& t, float* v) {
+    float p[3] = { v[0], v[1], v[2] };
+    for (size_t i = 0; i < 3; i++) {
+        v[i] = t.matrix[i][0] * p[0] + t.matrix[i][1] * p[1] + t.matrix[i][2] * p[2];
+    }
+}
+
+// Maps the programmed XYZ of a block.  Given work, where the tool is in the work coordinate
+// system, the words are positions (G90) and the axes left out stay where the tool is in the
+// program; otherwise they are increments (G91).  Returns the axes whose values it set.
+static AxisMask transform_words(const gc_transform_t& t, float* xyz, AxisMask words, const float* work) {
+    if (!(words & t.mapped)) {
+        return 0;
+    }
+    float p[3];
+    for (size_t i = 0; i < 3; i++) {
+        p[i] = bitnum_is_true(words, i) ? xyz[i] : 0.0f;
+    }
+    if (work) {
+        for (size_t i = 0; i < 3; i++) {
+            if (bitnum_is_false(words, i)) {
+                for (size_t j = 0; j < 3; j++) {
+                    p[i] += t.inverse[i][j] * (work[j] - t.offset[j]);
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < 3; i++) {
+        if (bitnum_is_true(t.mapped, i)) {
+            xyz[i] = (work ? t.offset[i] : 0.0f) + t.matrix[i][0] * p[0] + t.matrix[i][1] * p[1] + t.matrix[i][2] * p[2];
+        }
+    }
+    return t.mapped;
+}
+
+// Where the tool is in the work coordinate system, for XYZ
+static void work_position(float* work, const float* coord_system) {
+    for (size_t idx = 0; idx < 3; idx++) {
+        work[idx] = gc_state.position[idx] - coord_system[idx] - gc_state.coord_offset[idx];
+    }
+    work[TOOL_LENGTH_OFFSET_AXIS] -= gc_state.tool_length_offset;
+}
+
+// Fast path for the common CAM line of axis words with optional G0/G1, F, S and N, in
+// G90 and G94, without G51 or G68, with no parameters or expressions.  Such a line
+// needs none of the modal bookkeeping or error checks of the general parser, so it goes
+// straight from the words to mc_linear().  Returns false without changing any state if the
+// line is not of that form, or if the general parser would report an error, in which case
+// the general parser handles it.
+static bool gc_fast_linear(char* line, const CompiledGCode::Word* words, size_t n_words, Error& status) {
+    if (gc_state.skip_blocks || gc_state.modal.distance != Distance::Absolute || gc_state.modal.feed_rate != FeedRate::UnitsPerMin ||
+        gc_state.transform.mapped) {
+        return false;
+    }
+    if (gc_state.modal.motion != Motion::Seek && gc_state.modal.motion != Motion::Linear) {
+        return false;
+    }
+
+    auto     n_axis     = Axes::_numberAxis;
+    Motion   motion     = gc_state.modal.motion;
+    float    target[MAX_N_AXIS];
+    size_t   axis_words = 0;
+    uint32_t seen       = 0;  // Letters present, to find repeats
+    float    f          = gc_state.feed_rate;
+    float    s          = gc_state.spindle_speed;
+    int32_t  n          = 0;
+
+    const auto& map   = gc_program_map();
+    float       to_mm = gc_state.modal.units == Units::Inches ? MM_PER_INCH : 1.0f;
+
+    size_t pos = 0;
+    for (size_t i = 0; words ? i < n_words : line[pos] != '\0'; ++i) {
+        char  letter;
+        float value;
+        if (words) {
+            letter = words[i].letter;
+            value  = words[i].value;
+        } else {
+            letter = line[pos++];
+            if (letter < 'A' || letter > 'Z' || !read_float(line, pos, value)) {
+                return false;
+            }
+        }
+        uint32_t bit = bitnum_to_mask(letter - 'A');
+        if (seen & bit) {
+            return false;
+        }
+        seen |= bit;
+
+        const char* axis = strchr(Axes::_names, letter);
+        if (axis) {
+            size_t idx = axis - Axes::_names;
+            if (idx >= n_axis) {
+                return false;
+            }
+            // WPos = MPos - WCS - G92 - TLO, after conversion from inches
+            target[idx] = fmaf(value, map.scale[idx], map.offset[idx]);
+            set_bitnum(axis_words, idx);
+            continue;
+        }
+        switch (letter) {
+            case 'G':
+                if (value == 0.0f) {
+                    motion = Motion::Seek;
+                } else if (value == 1.0f) {
+                    motion = Motion::Linear;
+                } else {
+                    return false;
+                }
+                break;
+            case 'F':
+                f = value * to_mm;
+                break;
+            case 'S':
+                s = value;
+                break;
+            case 'N':
+                n = int32_t(truncf(value));
+                if (n > MaxLineNumber) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+        }
+        if (value < 0.0f) {
+            return false;
+        }
+    }
+    if (!axis_words || (motion == Motion::Linear && f == 0.0f)) {
+        return false;
+    }
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        if (bitnum_is_false(axis_words, idx)) {
+            target[idx] = gc_state.position[idx];
+        }
+    }
+
+    // With axis words in the line, a laser needs no sync; only G0 turns it off.
+    bool rateAdjusted = spindle->isRateAdjusted();
+    bool disableLaser = rateAdjusted && motion == Motion::Seek;
+
+    plan_line_data_t plan_data;
+    memset(&plan_data, 0, sizeof(plan_line_data_t));
+    gc_state.line_number  = n;
+    plan_data.line_number = n;
+    gc_state.feed_rate    = f;
+    plan_data.feed_rate   = f;
+    if (gc_state.spindle_speed != s) {
+        if (gc_state.modal.spindle != SpindleState::Disable && !rateAdjusted && !state_is(State::CheckMode)) {
+            protocol_buffer_synchronize();
+            spindle->setState(gc_state.modal.spindle, (uint32_t)s);
+            gc_ovr_changed();
+        }
+        gc_state.spindle_speed = s;
+    }
+    if (!disableLaser) {
+        plan_data.spindle_speed = gc_state.spindle_speed;
+    }
+    plan_data.spindle = gc_state.modal.spindle;
+    plan_data.coolant = gc_state.modal.coolant;
+
+    gc_state.modal.motion = motion;
+    if (motion == Motion::Seek) {
+        plan_data.motion.rapidMotion = 1;
+    }
+    mc_linear(target, &plan_data, gc_state.position);
+    if (sys.abort) {
+        status = Error::Reset;
+        return true;
+    }
+    copyAxes(gc_state.position, target);
+    status = Error::Ok;
+    return true;
+}
+
 // Executes one line of NUL-terminated G-Code.
 // The line may contain whitespace and comments, which are first removed,
 // and lower case characters, which are converted to upper case.
@@ -239,8 +500,23 @@ void gc_wco_changed() {
 // exported to internal functions in terms of (mm, mm/min) and absolute machine
 // coordinates, respectively.
 Error gc_execute_line(char* line) {
-    // Step 0 - remove whitespace and comments and convert to upper case
-    collapseGCode(line);
+    HeapScope heapScope(HeapTag::GCode);
+
+    // Step 0 - remove whitespace and comments and convert to upper case,
+    // unless the line was pre-parsed by $File/Compile
+    CompiledGCode::Word  compiled_words[CompiledGCode::max_words];
+    CompiledGCode::Word* words   = nullptr;
+    size_t               n_words = 0;
+    if (line[0] == CompiledGCode::words_record) {
+        n_words = CompiledGCode::decode(line, compiled_words);
+        words   = compiled_words;
+    } else {
+        collapseGCode(line);
+    }
+    Error fast_status;
+    if (gc_fast_linear(line, words, n_words, fast_status)) {
+        return fast_status;
+    }
 
     /* -------------------------------------------------------------------------------------
        STEP 1: Initialize parser block struct and copy current g-code state modes. The parser
@@ -272,6 +548,18 @@ Error gc_execute_line(char* line) {
     bool nonmodalG38          = false;  // Used for G38.6-9
     bool isWaitOnInputDigital = false;
 
+    float      outputDistance = 0.0f;              // M62/M63 Q
+    ProbeInput probeInput     = ProbeInput::Any;  // G38.n Q
+
+    // Canned cycles.  The words they carry over go to gc_state once the block executes.
+    CannedCycle cycle        = {};
+    uint32_t    cycleRepeats = 1;  // L
+    float       cycleR       = gc_state.cycle_r;
+    float       cycleZ       = gc_state.cycle_z;
+    float       cycleQ       = gc_state.cycle_q;
+    float       cycleP       = gc_state.cycle_p;
+    float       cycleClear   = gc_state.cycle_clear;
+
     auto    n_axis = Axes::_numberAxis;
     float   coord_data[MAX_N_AXIS];  // Used by WCO-related commands
     uint8_t pValue;                  // Integer value of P word
@@ -297,33 +585,42 @@ Error gc_execute_line(char* line) {
     size_t     pos;
     char       letter;
     float      value;
-    int32_t    int_value = 0;
-    int32_t    mantissa  = 0;
-    pos                  = jogMotion ? 3 : 0;  // Start parsing after `$J=` if jogging
-    while ((letter = line[pos]) != '\0') {     // Loop until no more g-code words in line.
-        if (letter == '#') {
-            if (gc_state.skip_blocks) {
-                return Error::Ok;
-            }
-            pos++;
-            if (!assign_param(line, pos)) {
-                FAIL(Error::BadNumberFormat);
+    int32_t    int_value  = 0;
+    int32_t    mantissa   = 0;
+    size_t     word_index = 0;                  // Next of the compiled words
+    pos                   = jogMotion ? 3 : 0;  // Start parsing after `$J=` if jogging
+    // Loop until no more g-code words in line.
+    while (words ? word_index < n_words : (letter = line[pos]) != '\0') {
+        if (words) {
+            // Compiled words are plain letter/number pairs, so there are no
+            // parameters, expressions or O-codes to handle.
+            letter = words[word_index].letter;
+            value  = words[word_index++].value;
+        } else {
+            if (letter == '#') {
+                if (gc_state.skip_blocks) {
+                    return Error::Ok;
+                }
+                pos++;
+                if (!assign_param(line, pos)) {
+                    FAIL(Error::BadNumberFormat);
+                }
+                continue;
             }
-            continue;
-        }
 
-        // XXX Should check that no other words are also present
-        if (bitnum_is_true(value_words, GCodeWord::O)) {
-            return flowcontrol(gc_block.values.o, line, pos, gc_state.skip_blocks);
-        }
+            // XXX Should check that no other words are also present
+            if (bitnum_is_true(value_words, GCodeWord::O)) {
+                return flowcontrol(gc_block.values.o, line, pos, gc_state.skip_blocks);
+            }
 
-        // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
-        if ((letter < 'A') || (letter > 'Z')) {
-            FAIL(Error::ExpectedCommandLetter);  // [Expected word letter]
-        }
-        pos++;
-        if (!read_number(line, pos, value)) {
-            FAIL(Error::BadNumberFormat);  // [Expected word value]
+            // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
+            if ((letter < 'A') || (letter > 'Z')) {
+                FAIL(Error::ExpectedCommandLetter);  // [Expected word letter]
+            }
+            pos++;
+            if (!read_number(line, pos, value)) {
+                FAIL(Error::BadNumberFormat);  // [Expected word value]
+            }
         }
         if (gc_state.skip_blocks && letter != 'O') {
             return Error::Ok;
@@ -418,6 +715,36 @@ Error gc_execute_line(char* line) {
                         gc_block.modal.motion = Motion::CcwArc;
                         mg_word_bit           = ModalGroup::MG1;
                         break;
+                    case 5:  // G5 - cubic spline, G5.1 - quadratic spline
+                        axis_command = AxisCommand::MotionMode;
+                        switch (mantissa) {
+                            case 0:
+                                gc_block.modal.motion = Motion::CubicSpline;
+                                break;
+                            case 10:
+                                gc_block.modal.motion = Motion::QuadSpline;
+                                break;
+                            default:
+                                FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G5.x command]
+                        }
+                        mantissa    = 0;  // Set to zero to indicate valid non-integer G command.
+                        mg_word_bit = ModalGroup::MG1;
+                        break;
+                    case 33:  // G33 - spindle synchronized motion, G33.1 - rigid tapping
+                        axis_command = AxisCommand::MotionMode;
+                        switch (mantissa) {
+                            case 0:
+                                gc_block.modal.motion = Motion::SpindleSync;
+                                break;
+                            case 10:
+                                gc_block.modal.motion = Motion::RigidTap;
+                                break;
+                            default:
+                                FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G33.x command]
+                        }
+                        mantissa    = 0;  // Set to zero to indicate valid non-integer G command.
+                        mg_word_bit = ModalGroup::MG1;
+                        break;
                     case 38:  // G38 - probe
                         //only allow G38 "Probe" commands if a probe pin is defined.
                         if (!config->_probe->exists()) {
@@ -467,6 +794,49 @@ Error gc_execute_line(char* line) {
                         gc_block.modal.motion = Motion::None;
                         mg_word_bit           = ModalGroup::MG1;
                         break;
+                    case 73:  // G73 - drilling with chip breaking
+                    case 81:  // G81 - drilling
+                    case 82:  // G82 - drilling with dwell
+                    case 83:  // G83 - peck drilling
+                    case 84:  // G84 - tapping
+                    case 85:  // G85 - boring, feed out
+                    case 86:  // G86 - boring, spindle stop, rapid out
+                    case 89:  // G89 - boring, dwell, feed out
+                        axis_command          = AxisCommand::MotionMode;
+                        gc_block.modal.motion = Motion(int_value * 10);
+                        mg_word_bit           = ModalGroup::MG1;
+                        break;
+                    case 50:  // G50 - cancel scaling
+                        gc_block.modal.scaling = Scaling::Disable;
+                        mg_word_bit            = ModalGroup::MG11;
+                        break;
+                    case 69:  // G69 - cancel rotation
+                        gc_block.modal.rotation = Rotation::Disable;
+                        mg_word_bit             = ModalGroup::MG16;
+                        break;
+                    case 51:  // G51 - scaling
+                    case 68:  // G68 - coordinate system rotation
+                        // The axis words of the block are the center
+                        if (axis_command != AxisCommand::None) {
+                            FAIL(Error::GcodeAxisCommandConflict);  // [Axis word/command conflict]
+                        }
+                        axis_command = AxisCommand::NonModal;
+                        if (int_value == 51) {
+                            gc_block.modal.scaling = Scaling::Enable;
+                            mg_word_bit            = ModalGroup::MG11;
+                        } else {
+                            gc_block.modal.rotation = Rotation::Enable;
+                            mg_word_bit             = ModalGroup::MG16;
+                        }
+                        break;
+                    case 98:
+                        gc_block.modal.retract_mode = RetractMode::OldZ;
+                        mg_word_bit                 = ModalGroup::MG10;
+                        break;
+                    case 99:
+                        gc_block.modal.retract_mode = RetractMode::RPlane;
+                        mg_word_bit                 = ModalGroup::MG10;
+                        break;
                     case 17:
                         gc_block.modal.plane_select = Plane::XY;
                         mg_word_bit                 = ModalGroup::MG2;
@@ -546,8 +916,12 @@ Error gc_execute_line(char* line) {
                         axis_command = AxisCommand::ToolLengthOffset;
                         if (int_value == 49) {  // G49
                             gc_block.modal.tool_length = ToolLengthOffset::Cancel;
+                        } else if (mantissa == 0) {  // G43
+                            gc_block.modal.tool_length = ToolLengthOffset::EnableTable;
                         } else if (mantissa == 10) {  // G43.1
                             gc_block.modal.tool_length = ToolLengthOffset::EnableDynamic;
+                        } else if (mantissa == 40) {  // G43.4
+                            gc_block.modal.tool_length = ToolLengthOffset::EnableTcp;
                         } else {
                             FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G43.x command]
                         }
@@ -775,7 +1149,13 @@ Error gc_execute_line(char* line) {
                         axis_word_bit     = GCodeWord::F;
                         gc_block.values.f = value;
                         break;
-                    // case 'H': // Not supported
+                    case 'H':
+                        axis_word_bit = GCodeWord::H;
+                        if (value < 0 || value > ToolTable::maxTool) {
+                            FAIL(Error::GcodeMaxValueExceeded);
+                        }
+                        gc_block.values.h = int_value;
+                        break;
                     case 'I':
                         axis_word_bit               = GCodeWord::I;
                         gc_block.values.ijk[X_AXIS] = value;
@@ -830,6 +1210,33 @@ Error gc_execute_line(char* line) {
                         }
                         gc_state.selected_tool = int_value;
                         break;
+                    case 'U':
+                        if (n_axis > U_AXIS) {
+                            axis_word_bit               = GCodeWord::U;
+                            gc_block.values.xyz[U_AXIS] = value;
+                            set_bitnum(axis_words, U_AXIS);
+                        } else {
+                            FAIL(Error::GcodeUnsupportedCommand);
+                        }
+                        break;
+                    case 'V':
+                        if (n_axis > V_AXIS) {
+                            axis_word_bit               = GCodeWord::V;
+                            gc_block.values.xyz[V_AXIS] = value;
+                            set_bitnum(axis_words, V_AXIS);
+                        } else {
+                            FAIL(Error::GcodeUnsupportedCommand);
+                        }
+                        break;
+                    case 'W':
+                        if (n_axis > W_AXIS) {
+                            axis_word_bit               = GCodeWord::W;
+                            gc_block.values.xyz[W_AXIS] = value;
+                            set_bitnum(axis_words, W_AXIS);
+                        } else {
+                            FAIL(Error::GcodeUnsupportedCommand);
+                        }
+                        break;
                     case 'X':
                         if (n_axis > X_AXIS) {
                             axis_word_bit               = GCodeWord::X;
@@ -1005,6 +1412,18 @@ Error gc_execute_line(char* line) {
             FAIL(Error::GcodeValueWordMissing);  // [P word missing]
         }
         clear_bitnum(value_words, GCodeWord::P);
+        if (bitnum_is_true(value_words, GCodeWord::Q)) {
+            // M62/M63 Q<distance> switches the output that far into the next motion
+            if ((gc_block.modal.io_control != IoControl::DigitalOnSync && gc_block.modal.io_control != IoControl::DigitalOffSync) ||
+                gc_block.values.q < 0.0f) {
+                FAIL(Error::GcodeValueWordInvalid);
+            }
+            outputDistance = gc_block.values.q;
+            if (gc_block.modal.units == Units::Inches) {
+                outputDistance *= MM_PER_INCH;
+            }
+            clear_bitnum(value_words, GCodeWord::Q);
+        }
     }
     if ((gc_block.modal.io_control == IoControl::SetAnalogSync) || (gc_block.modal.io_control == IoControl::SetAnalogImmediate)) {
         if (bitnum_is_false(value_words, GCodeWord::E) || bitnum_is_false(value_words, GCodeWord::Q)) {
@@ -1044,7 +1463,7 @@ Error gc_execute_line(char* line) {
         //  - Ignored if L is 0 (Immediate).
         //  - Error if value 0 seconds, and L is not 0 (Immediate).
         if (bitnum_is_true(value_words, GCodeWord::Q)) {
-            if (gc_block.values.q != 0.0) {
+            if (gc_block.values.q <= 0.0) {
                 if (wait_mode != WaitOnInputMode::Immediate) {
                     // Non-immediate waits must have a non-zero timeout
                     FAIL(Error::GcodeValueWordInvalid);
@@ -1097,7 +1516,8 @@ Error gc_execute_line(char* line) {
     // [G40 Errors]: G2/3 arc is programmed after a G40. The linear move after disabling is less than tool diameter.
     //   NOTE: Since cutter radius compensation is never enabled, these G40 errors don't apply. G40 is supported
     //   only for the purpose of not erroring when G40 is sent with a g-code program header to setup the default modes.
-    // [14. Cutter length compensation ]: G43 NOT SUPPORTED, but G43.1 and G49 are.
+    // [14. Cutter length compensation ]: G43 from the tool table, G43.1, G43.4 and G49.
+    // [G43 Errors]: Axis words. H missing with no tool in the spindle.
     // [G43.1 Errors]: Motion command in same line.
     //   NOTE: Although not explicitly stated so, G43.1 should be applied to only one valid
     //   axis that is configured (in config.h). There should be an error if the configured axis
@@ -1109,6 +1529,28 @@ Error gc_execute_line(char* line) {
                 FAIL(Error::GcodeG43DynamicAxisError);
             }
         }
+        if (gc_block.modal.tool_length == ToolLengthOffset::EnableTcp && axis_words) {
+            FAIL(Error::GcodeAxisWordsExist);
+        }
+        if (gc_block.modal.tool_length == ToolLengthOffset::EnableTable) {
+            if (axis_words) {
+                FAIL(Error::GcodeAxisWordsExist);
+            }
+            // Without H, G43 uses the entry of the tool in the spindle
+            uint32_t tool = gc_block.values.h;
+            if (bitnum_is_true(value_words, GCodeWord::H)) {
+                clear_bitnum(value_words, GCodeWord::H);
+            } else if (gc_state.current_tool > 0) {
+                tool = gc_state.current_tool;
+            } else {
+                FAIL(Error::GcodeValueWordMissing);
+            }
+            if (tool > ToolTable::maxTool) {
+                FAIL(Error::GcodeMaxValueExceeded);
+            }
+            // Loaded as if G43.1 had given it
+            gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = ToolTable::get(tool);
+        }
     }
     // [15. Coordinate system selection ]: *N/A. Error, if cutter radius comp is active.
     // TODO: Reading the coordinate data may require a buffer sync when the cycle
@@ -1130,6 +1572,54 @@ Error gc_execute_line(char* line) {
     // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
     // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
     // [18. Set retract mode ]: NOT SUPPORTED.
+    // [Scaling and rotation ]: G51 P missing or not positive. G68 R missing. G51 and G68 in one block, or
+    //   with another command that uses axis words. Axis words other than XYZ for G51, or outside the plane for G68.
+    // NOTE: The centers are in the work coordinate system, always absolute, and where the tool is for the
+    //   axes left out.  G68 rotates in the plane in effect when it is programmed.
+    gc_transform_t transform = gc_state.transform;
+    AxisMask       mapped    = 0;  // Axes whose target the map set, see below
+    bool           newScale  = bitnum_is_true(command_words, ModalGroup::MG11) && gc_block.modal.scaling == Scaling::Enable;
+    bool           newRotate = bitnum_is_true(command_words, ModalGroup::MG16) && gc_block.modal.rotation == Rotation::Enable;
+    if (newScale || newRotate) {
+        if ((newScale && newRotate) || gc_block.non_modal_command != NonModal::NoAction) {
+            FAIL(Error::GcodeAxisCommandConflict);  // [Axis word/command conflict]
+        }
+        float work[3];
+        work_position(work, block_coord_system);
+        if (newScale) {
+            if (bitnum_is_false(value_words, GCodeWord::P)) {
+                FAIL(Error::GcodeValueWordMissing);  // [P word missing]
+            }
+            if (gc_block.values.p <= 0.0f) {
+                FAIL(Error::GcodeValueWordInvalid);  // [Scale not positive]
+            }
+            if (axis_words & ~(bitnum_to_mask(X_AXIS) | bitnum_to_mask(Y_AXIS) | bitnum_to_mask(Z_AXIS))) {
+                FAIL(Error::GcodeUnusedWords);  // [Axis words other than XYZ]
+            }
+            for (size_t idx = 0; idx < 3; idx++) {
+                transform.scale_center[idx] = bitnum_is_true(axis_words, idx) ? gc_block.values.xyz[idx] : work[idx];
+            }
+            transform.scale = gc_block.values.p;
+            clear_bitnum(value_words, GCodeWord::P);
+        } else {
+            if (bitnum_is_false(value_words, GCodeWord::R)) {
+                FAIL(Error::GcodeValueWordMissing);  // [R word missing]
+            }
+            if (axis_words & ~(bitnum_to_mask(axis_0) | bitnum_to_mask(axis_1))) {
+                FAIL(Error::GcodeUnusedWords);  // [Axis words outside the plane]
+            }
+            transform.axis_0             = axis_0;
+            transform.axis_1             = axis_1;
+            transform.rotation_center[0] = bitnum_is_true(axis_words, axis_0) ? gc_block.values.xyz[axis_0] : work[axis_0];
+            transform.rotation_center[1] = bitnum_is_true(axis_words, axis_1) ? gc_block.values.xyz[axis_1] : work[axis_1];
+            transform.rotation           = gc_block.values.r;
+            clear_bitnum(value_words, GCodeWord::R);
+        }
+        axis_words = 0;  // Used as the center
+    }
+    if (bitnum_is_true(command_words, ModalGroup::MG11) || bitnum_is_true(command_words, ModalGroup::MG16)) {
+        gc_update_transform(transform, gc_block.modal);
+    }
     // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
     // NOTE: We need to separate the non-modal commands that are axis word-using (G10/G28/G30/G92), as these
     // commands all treat axis words differently. G10 as absolute offsets or computes current position as
@@ -1137,7 +1627,8 @@ Error gc_execute_line(char* line) {
     // all the current coordinate system and G92 offsets.
     switch (gc_block.non_modal_command) {
         case NonModal::SetCoordinateData:
-            // [G10 Errors]: L missing and is not 2 or 20. P word missing. (Negative P value done.)
+            // [G10 Errors]: L missing and is not 1, 2 or 20. P word missing. (Negative P value done.)
+            // [G10 L1 Errors]: P not a tool table entry. Axis words other than the tool length axis.
             // [G10 L2 Errors]: R word NOT SUPPORTED. P value not 0 to nCoordSys(max 9). Axis words missing.
             // [G10 L20 Errors]: P must be 0 to nCoordSys(max 9). Axis words missing.
             if (!axis_words) {
@@ -1146,6 +1637,20 @@ Error gc_execute_line(char* line) {
             if (bits_are_false(value_words, (bitnum_to_mask(GCodeWord::P) | bitnum_to_mask(GCodeWord::L)))) {
                 FAIL(Error::GcodeValueWordMissing);  // [P/L word missing]
             }
+            if (gc_block.values.l == 1) {
+                // Sets the length of tool P in the tool table
+                if (axis_words ^ bitnum_to_mask(TOOL_LENGTH_OFFSET_AXIS)) {
+                    FAIL(Error::GcodeUnsupportedCommand);  // [Only the tool length axis]
+                }
+                if (gc_block.values.p < 1 || gc_block.values.p > ToolTable::maxTool) {
+                    FAIL(Error::GcodeMaxValueExceeded);
+                }
+                clear_bits(value_words, (bitnum_to_mask(GCodeWord::L) | bitnum_to_mask(GCodeWord::P)));
+                break;
+            }
+            if (gc_block.values.l == 20 && transform.mapped) {
+                FAIL(Error::GcodeUnsupportedCommand);  // [G10 L20 while scaled or rotated]
+            }
             if (gc_block.values.l != 20) {
                 if (gc_block.values.l == 2) {
                     if (bitnum_is_true(value_words, GCodeWord::R)) {
@@ -1190,10 +1695,13 @@ Error gc_execute_line(char* line) {
             gc_ngc_changed(static_cast<CoordIndex>(coord_select));
             break;
         case NonModal::SetCoordinateOffset:
-            // [G92 Errors]: No axis words.
+            // [G92 Errors]: No axis words. Scaling or rotation in effect.
             if (!axis_words) {
                 FAIL(Error::GcodeNoAxisWords);  // [No axis words]
             }
+            if (transform.mapped) {
+                FAIL(Error::GcodeUnsupportedCommand);  // [G92 while scaled or rotated]
+            }
             // Update axes defined only in block. Offsets current system to defined value. Does not update when
             // active coordinate system is selected, but is still active unless G92.1 disables it.
             for (size_t idx = 0; idx < n_axis; idx++) {  // Axes indices are consistent, so loop may be used.
@@ -1216,8 +1724,18 @@ Error gc_execute_line(char* line) {
             // NOTE: Tool offsets may be appended to these conversions when/if this feature is added.
             if (axis_command != AxisCommand::ToolLengthOffset) {  // TLO block any axis command.
                 if (axis_words) {
+                    // G51 and G68 map the programmed XYZ before the offsets are added.  Jogs and G53 are in machine axes.
+                    if (transform.mapped && !jogMotion && !nonmodalG38 && gc_block.non_modal_command != NonModal::AbsoluteOverride) {
+                        float  work[3];
+                        float* from = nullptr;
+                        if (gc_block.modal.distance == Distance::Absolute) {
+                            work_position(work, block_coord_system);
+                            from = work;
+                        }
+                        mapped = transform_words(transform, gc_block.values.xyz, axis_words, from);
+                    }
                     for (size_t idx = 0; idx < n_axis; idx++) {  // Axes indices are consistent, so loop may be used to save flash space.
-                        if (bitnum_is_false(axis_words, idx)) {
+                        if (bitnum_is_false(axis_words | mapped, idx)) {
                             gc_block.values.xyz[idx] = gc_state.position[idx];  // No axis word in block. Keep same axis position.
                         } else {
                             // Update specified value according to distance mode or ignore if absolute override is active.
@@ -1298,7 +1816,9 @@ Error gc_execute_line(char* line) {
             // the value must be positive. In inverse time mode, a positive value must be passed with each block.
         } else {
             // Check if feed rate is defined for the motion modes that require it.
-            if (gc_block.values.f == 0.0) {
+            // The spindle sets the feed rate of G33 and G33.1.
+            bool spindleSync = gc_block.modal.motion == Motion::SpindleSync || gc_block.modal.motion == Motion::RigidTap;
+            if (gc_block.values.f == 0.0 && !spindleSync) {
                 FAIL(Error::GcodeUndefinedFeedRate);  // [Feed rate undefined]
             }
             switch (gc_block.modal.motion) {
@@ -1331,6 +1851,9 @@ Error gc_execute_line(char* line) {
                     if (gc_block.values.p != truncf(gc_block.values.p) || gc_block.values.p < 0.0) {
                         FAIL(Error::GcodeCommandValueNotInteger);  // [P word is not an integer]
                     }
+                    if (gc_block.modal.rotation == Rotation::Enable && (transform.axis_0 != axis_0 || transform.axis_1 != axis_1)) {
+                        FAIL(Error::GcodeUnsupportedCommand);  // [Rotated out of the plane of the arc]
+                    }
 
                     // Calculate the change in position along each selected axis
                     float x, y;
@@ -1345,6 +1868,9 @@ Error gc_execute_line(char* line) {
                         if (!nonmodalG38 && gc_block.modal.units == Units::Inches) {
                             gc_block.values.r *= MM_PER_INCH;
                         }
+                        if (mapped && gc_block.modal.scaling == Scaling::Enable) {
+                            gc_block.values.r *= transform.scale;
+                        }
                         /*  We need to calculate the center of the circle that has the designated radius and passes
                         through both the current position and the target position. This method calculates the following
                         set of equations where [x,y] is the vector from current to target position, d == magnitude of
@@ -1443,6 +1969,9 @@ Error gc_execute_line(char* line) {
                                 }
                             }
                         }
+                        if (mapped) {
+                            transform_vector(transform, gc_block.values.ijk);
+                        }
                         // Arc radius from center to target
                         x -= gc_block.values.ijk[axis_0];  // Delta x between circle center and target
                         y -= gc_block.values.ijk[axis_1];  // Delta y between circle center and target
@@ -1462,6 +1991,67 @@ Error gc_execute_line(char* line) {
                     }
                     clear_bitnum(value_words, GCodeWord::P);
                     break;
+                case Motion::CubicSpline:
+                case Motion::QuadSpline:
+                    // [G5/G5.1 Errors]: Feed rate undefined. Plane is not G17. No axis words in plane.
+                    //   G5: P,Q missing, or only one of I,J, or I,J omitted when the last motion was not G5.
+                    //   G5.1: I,J missing.
+                    // I,J is the offset from the current point to the first control point, P,Q the offset
+                    // from the target to the second control point of a cubic spline.  G5.1 has only I,J.
+                    if (gc_block.modal.plane_select != Plane::XY ||
+                        (gc_block.modal.rotation == Rotation::Enable && transform.axis_0 != X_AXIS)) {
+                        FAIL(Error::GcodeUnsupportedCommand);  // [Splines only in G17]
+                    }
+                    if (!(axis_words & (bitnum_to_mask(X_AXIS) | bitnum_to_mask(Y_AXIS)))) {
+                        FAIL(Error::GcodeNoAxisWordsInPlane);  // [No axis words in plane]
+                    }
+                    if (ijk_words & bitnum_to_mask(Z_AXIS)) {
+                        FAIL(Error::GcodeUnusedWords);  // [K is not used by splines]
+                    }
+                    if (gc_block.modal.motion == Motion::CubicSpline) {
+                        if (!(bitnum_is_true(value_words, GCodeWord::P) && bitnum_is_true(value_words, GCodeWord::Q))) {
+                            FAIL(Error::GcodeValueWordMissing);  // [P and Q are required]
+                        }
+                        if (!ijk_words) {
+                            if (gc_state.modal.motion != Motion::CubicSpline) {
+                                FAIL(Error::GcodeValueWordMissing);  // [I and J are required after a non-G5 motion]
+                            }
+                            // Continue smoothly from the previous G5.  spline_exit is already in mm.
+                            gc_block.values.ijk[X_AXIS] = -spline_exit[0];
+                            gc_block.values.ijk[Y_AXIS] = -spline_exit[1];
+                        }
+                    } else if (bitnum_is_true(value_words, GCodeWord::P) || bitnum_is_true(value_words, GCodeWord::Q)) {
+                        FAIL(Error::GcodeUnusedWords);  // [G5.1 takes no P or Q]
+                    }
+                    if (ijk_words && ijk_words != (bitnum_to_mask(X_AXIS) | bitnum_to_mask(Y_AXIS))) {
+                        FAIL(Error::GcodeValueWordMissing);  // [I and J must be given together]
+                    }
+                    if (gc_block.modal.motion == Motion::QuadSpline && !ijk_words) {
+                        FAIL(Error::GcodeValueWordMissing);  // [I and J are required]
+                    }
+                    // Convert offsets to proper units.
+                    if (gc_block.modal.units == Units::Inches) {
+                        if (ijk_words) {
+                            gc_block.values.ijk[X_AXIS] *= MM_PER_INCH;
+                            gc_block.values.ijk[Y_AXIS] *= MM_PER_INCH;
+                        }
+                        gc_block.values.p *= MM_PER_INCH;
+                        gc_block.values.q *= MM_PER_INCH;
+                    }
+                    if (mapped) {
+                        // The continuation from the previous G5 is already mapped
+                        if (ijk_words) {
+                            transform_vector(transform, gc_block.values.ijk);
+                        }
+                        float pq[3] = { gc_block.values.p, gc_block.values.q, 0.0f };
+                        transform_vector(transform, pq);
+                        gc_block.values.p = pq[0];
+                        gc_block.values.q = pq[1];
+                    }
+                    clear_bits(value_words,
+                               (bitnum_to_mask(GCodeWord::I) | bitnum_to_mask(GCodeWord::J) | bitnum_to_mask(GCodeWord::P) |
+                                bitnum_to_mask(GCodeWord::Q)));
+                    break;
                 case Motion::ProbeTowardNoError:
                 case Motion::ProbeAwayNoError:
                     probeNoError = true;  // No break intentional.
@@ -1482,7 +2072,151 @@ Error gc_execute_line(char* line) {
                         gc_block.values.p = __FLT_MAX__;  // This is a hack to signal the probe cycle that not to auto offset.
                     }
                     clear_bitnum(value_words, GCodeWord::P);  // allow P to be used
+                    // Q selects the input to watch, 1 for the probe pin and 2 for the toolsetter
+                    if (bitnum_is_true(value_words, GCodeWord::Q)) {
+                        if (gc_block.values.q != truncf(gc_block.values.q) || gc_block.values.q < 0.0f || gc_block.values.q > 2.0f) {
+                            FAIL(Error::GcodeValueWordInvalid);
+                        }
+                        probeInput = ProbeInput(int(gc_block.values.q));
+                        if (!config->_probe->exists(probeInput)) {
+                            log_info("No such probe pin defined");
+                            FAIL(Error::GcodeValueWordInvalid);
+                        }
+                        clear_bitnum(value_words, GCodeWord::Q);
+                    }
 
+                    if (!axis_words) {
+                        FAIL(Error::GcodeNoAxisWords);  // [No axis words]
+                    }
+                    if (isequal_position_vector(gc_state.position, gc_block.values.xyz)) {
+                        FAIL(Error::GcodeInvalidTarget);  // [Invalid target]
+                    }
+                    break;
+                case Motion::DrillChipBreak:
+                case Motion::Drill:
+                case Motion::DrillDwell:
+                case Motion::DrillPeck:
+                case Motion::Tap:
+                case Motion::Bore:
+                case Motion::BoreSpindleStop:
+                case Motion::BoreDwell: {
+                    // [Canned cycle Errors]: Inverse time feed. Axis words other than those of the plane and
+                    //   the drilling axis. R or Z missing in the first block of a run of cycles. Q missing or not
+                    //   positive for G73 and G83. P negative. L less than 1. Z above R. Spindle not running or
+                    //   not reversible for G84.
+                    // NOTE: R, Z, Q and P carry over to the following blocks while the motion mode is a cycle.
+                    //   In G91, R is from the starting height and Z is from R.
+                    if (gc_block.modal.feed_rate == FeedRate::InverseTime) {
+                        FAIL(Error::GcodeUnsupportedCommand);  // [G93 canned cycle]
+                    }
+                    if (gc_block.modal.scaling == Scaling::Enable ||
+                        (gc_block.modal.rotation == Rotation::Enable && (transform.axis_0 != axis_0 || transform.axis_1 != axis_1))) {
+                        FAIL(Error::GcodeUnsupportedCommand);  // [Scaled, or rotated out of the plane of the holes]
+                    }
+                    if (axis_words & ~(bitnum_to_mask(axis_0) | bitnum_to_mask(axis_1) | bitnum_to_mask(axis_linear))) {
+                        FAIL(Error::GcodeUnusedWords);  // [Axis words outside the plane and drilling axis]
+                    }
+                    bool  continued = is_canned_cycle(gc_state.modal.motion);
+                    float to_mm     = gc_block.modal.units == Units::Inches ? MM_PER_INCH : 1.0f;
+                    if (bitnum_is_true(value_words, GCodeWord::R)) {
+                        cycleR = gc_block.values.r * to_mm;
+                    } else if (!continued) {
+                        FAIL(Error::GcodeValueWordMissing);  // [R word missing]
+                    }
+                    if (bitnum_is_true(value_words, GCodeWord::Q)) {
+                        cycleQ = gc_block.values.q * to_mm;
+                    }
+                    if ((gc_block.modal.motion == Motion::DrillChipBreak || gc_block.modal.motion == Motion::DrillPeck) && cycleQ <= 0.0f) {
+                        FAIL(bitnum_is_true(value_words, GCodeWord::Q) ? Error::NegativeValue : Error::GcodeValueWordMissing);
+                    }
+                    if (bitnum_is_true(value_words, GCodeWord::P)) {
+                        if (gc_block.values.p < 0.0f) {
+                            FAIL(Error::NegativeValue);  // [P word negative]
+                        }
+                        cycleP = gc_block.values.p;
+                    }
+                    if (bitnum_is_true(value_words, GCodeWord::L)) {
+                        if (gc_block.values.l < 1) {
+                            FAIL(Error::GcodeValueWordInvalid);  // [L less than 1]
+                        }
+                        cycleRepeats = gc_block.values.l;
+                    }
+                    clear_bits(value_words,
+                               (bitnum_to_mask(GCodeWord::R) | bitnum_to_mask(GCodeWord::Q) | bitnum_to_mask(GCodeWord::P) |
+                                bitnum_to_mask(GCodeWord::L)));
+                    if (gc_block.modal.motion == Motion::Tap) {
+                        if (gc_block.modal.spindle == SpindleState::Disable || gc_block.values.s <= 0.0f) {
+                            log_info("Spindle is not running");
+                            FAIL(Error::InvalidStatement);
+                        }
+                        if (!spindle->is_reversable) {
+                            log_info("Spindle is not reversible");
+                            FAIL(Error::InvalidStatement);
+                        }
+                    }
+                    // The drilling height the words are measured from, in machine coordinates
+                    float base = gc_state.position[axis_linear];
+                    if (gc_block.modal.distance == Distance::Absolute) {
+                        base = block_coord_system[axis_linear] + gc_state.coord_offset[axis_linear];
+                        if (axis_linear == TOOL_LENGTH_OFFSET_AXIS) {
+                            base += gc_state.tool_length_offset;
+                        }
+                    }
+                    if (bitnum_is_true(axis_words, axis_linear)) {
+                        cycleZ = gc_block.values.xyz[axis_linear] - base;
+                    } else if (!continued && axis_words) {
+                        FAIL(Error::GcodeValueWordMissing);  // [Z word missing]
+                    }
+                    if (!continued) {
+                        cycleClear = gc_state.position[axis_linear];
+                    }
+                    if (!axis_words) {
+                        axis_command = AxisCommand::None;  // Only sets the words for the blocks that follow
+                        break;
+                    }
+                    cycle.mode   = gc_block.modal.motion;
+                    cycle.axis   = axis_linear;
+                    cycle.r      = base + cycleR;
+                    cycle.bottom = (gc_block.modal.distance == Distance::Absolute ? base : cycle.r) + cycleZ;
+                    cycle.clear  = cycle.r;
+                    if (gc_block.modal.retract_mode == RetractMode::OldZ && cycleClear > cycle.r) {
+                        cycle.clear = cycleClear;
+                    }
+                    cycle.peck  = cycleQ;
+                    cycle.dwell = cycleP;
+                    if (cycle.mode == Motion::Tap && spindle->_encoder && spindle->_encoder->start()) {
+                        cycle.pitch = gc_block.values.f / gc_block.values.s;  // Rigid tapping, as G33.1
+                    }
+                    if (cycle.bottom > cycle.r) {
+                        FAIL(Error::GcodeInvalidTarget);  // [Z above R]
+                    }
+                } break;
+                case Motion::SpindleSync:
+                case Motion::RigidTap:
+                    // [G33/G33.1 Errors]: No spindle encoder. Spindle not running. K word missing or not
+                    //   positive. No axis words. Target is same current.
+                    if (!spindle->_encoder || !spindle->_encoder->start()) {
+                        log_info("No spindle encoder defined");
+                        FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G command]
+                    }
+                    if (gc_block.modal.spindle == SpindleState::Disable || gc_block.values.s <= 0.0f) {
+                        log_info("Spindle is not running");
+                        FAIL(Error::InvalidStatement);
+                    }
+                    if (gc_block.modal.motion == Motion::RigidTap && !spindle->is_reversable) {
+                        log_info("Spindle is not reversible");
+                        FAIL(Error::InvalidStatement);
+                    }
+                    if (!bitnum_is_true(value_words, GCodeWord::K)) {
+                        FAIL(Error::GcodeValueWordMissing);  // [K word missing]
+                    }
+                    if (gc_block.values.ijk[Z_AXIS] <= 0.0f) {
+                        FAIL(Error::NegativeValue);  // [K word not positive]
+                    }
+                    if (gc_block.modal.units == Units::Inches) {
+                        gc_block.values.ijk[Z_AXIS] *= MM_PER_INCH;
+                    }
+                    clear_bitnum(value_words, GCodeWord::K);
                     if (!axis_words) {
                         FAIL(Error::GcodeNoAxisWords);  // [No axis words]
                     }
@@ -1507,7 +2241,8 @@ Error gc_execute_line(char* line) {
     if (axis_command != AxisCommand::None) {
         clear_bits(value_words,
                    (bitnum_to_mask(GCodeWord::X) | bitnum_to_mask(GCodeWord::Y) | bitnum_to_mask(GCodeWord::Z) |
-                    bitnum_to_mask(GCodeWord::A) | bitnum_to_mask(GCodeWord::B) | bitnum_to_mask(GCodeWord::C)));  // Remove axis words.
+                    bitnum_to_mask(GCodeWord::A) | bitnum_to_mask(GCodeWord::B) | bitnum_to_mask(GCodeWord::C) |
+                    bitnum_to_mask(GCodeWord::U) | bitnum_to_mask(GCodeWord::V) | bitnum_to_mask(GCodeWord::W)));  // Remove axis words.
     }
     clear_bits(value_words, (bitnum_to_mask(GCodeWord::D) | bitnum_to_mask(GCodeWord::O)));
     if (value_words) {
@@ -1518,6 +2253,8 @@ Error gc_execute_line(char* line) {
        Assumes that all error-checking has been completed and no failure modes exist. We just
        need to update the state and execute the block according to the order-of-execution.
     */
+    TRACE_POINT(Parsed, Trace::current);
+
     // Initialize planner data struct for motion blocks.
     plan_line_data_t  plan_data;
     plan_line_data_t* pl_data = &plan_data;
@@ -1550,9 +2287,11 @@ Error gc_execute_line(char* line) {
     // If in laser mode, setup laser power based on current and past parser conditions.
     if (spindle->isRateAdjusted()) {
         bool blockIsFeedrateMotion = (gc_block.modal.motion == Motion::Linear) || (gc_block.modal.motion == Motion::CwArc) ||
-                                     (gc_block.modal.motion == Motion::CcwArc);
+                                     (gc_block.modal.motion == Motion::CcwArc) || (gc_block.modal.motion == Motion::CubicSpline) ||
+                                     (gc_block.modal.motion == Motion::QuadSpline);
         bool stateIsFeedrateMotion = (gc_state.modal.motion == Motion::Linear) || (gc_state.modal.motion == Motion::CwArc) ||
-                                     (gc_state.modal.motion == Motion::CcwArc);
+                                     (gc_state.modal.motion == Motion::CcwArc) || (gc_state.modal.motion == Motion::CubicSpline) ||
+                                     (gc_state.modal.motion == Motion::QuadSpline);
 
         if (!blockIsFeedrateMotion) {
             // If the new mode is not a feedrate move (G1/2/3) we want the laser off
@@ -1597,8 +2336,13 @@ Error gc_execute_line(char* line) {
     // [4. Set spindle speed ]:
     if ((gc_state.spindle_speed != gc_block.values.s) || syncLaser) {
         if (gc_state.modal.spindle != SpindleState::Disable && !laserIsMotion && !state_is(State::CheckMode)) {
-            protocol_buffer_synchronize();
-            spindle->setState(gc_state.modal.spindle, disableLaser ? 0 : (uint32_t)gc_block.values.s);
+            // With motion queued, a small change is made by the stepper as the blocks that
+            // carry the new speed start, so the machine does not stop for it.
+            uint32_t speed = disableLaser ? 0 : (uint32_t)gc_block.values.s;
+            if (!plan_get_current_block() || !spindle->queueSpeed(speed)) {
+                protocol_buffer_synchronize();
+                spindle->setState(gc_state.modal.spindle, speed);
+            }
             gc_ovr_changed();
         }
         gc_state.spindle_speed = gc_block.values.s;  // Update spindle speed state.
@@ -1672,6 +2416,7 @@ Error gc_execute_line(char* line) {
     // you can turn them off simultaneously with M9.  You can turn them off separately
     // with real-time overrides, but that is out of the scope of GCode.
     if (gc_block.coolant != GCodeCoolant::None) {
+        CoolantState previous = gc_state.modal.coolant;
         switch (gc_block.coolant) {
             case GCodeCoolant::None:
                 break;
@@ -1685,9 +2430,13 @@ Error gc_execute_line(char* line) {
                 gc_state.modal.coolant = {};
                 break;
         }
+        // With motion queued, the stepper makes the change as the next block starts, like
+        // M62/M63, so the machine does not stop for it.  The planner blocks carry the state.
         if (!state_is(State::CheckMode)) {
-            protocol_buffer_synchronize();
-            config->_coolant->set_state(gc_state.modal.coolant);
+            if (!plan_get_current_block() || !config->_coolant->queue_state(previous, gc_state.modal.coolant)) {
+                protocol_buffer_synchronize();
+                config->_coolant->set_state(gc_state.modal.coolant);
+            }
             gc_ovr_changed();
         }
     }
@@ -1697,12 +2446,24 @@ Error gc_execute_line(char* line) {
     if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync) ||
         (gc_block.modal.io_control == IoControl::DigitalOnImmediate) || (gc_block.modal.io_control == IoControl::DigitalOffImmediate)) {
         if (gc_block.values.p < MaxUserDigitalPin) {
-            if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync)) {
-                protocol_buffer_synchronize();
-            }
             bool turnOn = gc_block.modal.io_control == IoControl::DigitalOnSync || gc_block.modal.io_control == IoControl::DigitalOnImmediate;
-            if (!config->_userOutputs->setDigital((int)gc_block.values.p, turnOn)) {
-                FAIL(Error::PParamMaxExceeded);
+            bool isSync = (gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync);
+            // M62/M63 on an output that the stepper can switch is queued for the start of the
+            // next motion, so the machine does not stop for it, as in LinuxCNC.  If no motion
+            // is queued, or the output is on an expander, the motion so far finishes first.
+            // With Q, it is queued for that distance into the next motion, or fails.
+            if (outputDistance > 0.0f) {
+                if (!config->_userOutputs->queueDigital((int)gc_block.values.p, turnOn, outputDistance)) {
+                    FAIL(Error::GcodeValueWordInvalid);
+                }
+            } else {
+                if (isSync && (!plan_get_current_block() || !config->_userOutputs->queueDigital((int)gc_block.values.p, turnOn))) {
+                    protocol_buffer_synchronize();
+                    isSync = false;
+                }
+                if (!isSync && !config->_userOutputs->setDigital((int)gc_block.values.p, turnOn)) {
+                    FAIL(Error::PParamMaxExceeded);
+                }
             }
         } else {
             FAIL(Error::PParamMaxExceeded);
@@ -1746,7 +2507,10 @@ Error gc_execute_line(char* line) {
         auto const input_number = *maybe_input_number;
         auto const wait_mode    = *validate_wait_on_input_mode_value(gc_block.values.l);
         auto const timeout      = gc_block.values.q;
-        gc_wait_on_input(isWaitOnInputDigital, input_number, wait_mode, timeout);
+        auto const err          = gc_wait_on_input(isWaitOnInputDigital, input_number, wait_mode, timeout);
+        if (err != Error::Ok) {
+            FAIL(err);
+        }
     }
 
     // [9. Override control ]: NOT SUPPORTED. Always enabled, except for parking control.
@@ -1759,7 +2523,11 @@ Error gc_execute_line(char* line) {
 
     // [10. Dwell ]:
     if (gc_block.non_modal_command == NonModal::Dwell) {
-        mc_dwell(int32_t(gc_block.values.p * 1000.0f));
+        // A laser in constant power mode (M3) stays on through a dwell, as for dot and pulse work.
+        plan_line_data_t dwell_data = *pl_data;
+        dwell_data.spindle_speed    = gc_state.spindle_speed;
+        float usecs                 = gc_block.values.p * 1000000.0f;
+        mc_dwell(usecs < float(UINT32_MAX) ? uint32_t(usecs + 0.5f) : UINT32_MAX, &dwell_data);
     }
     // [11. Set active plane ]:
     gc_state.modal.plane_select = gc_block.modal.plane_select;
@@ -1767,18 +2535,26 @@ Error gc_execute_line(char* line) {
     gc_state.modal.units = gc_block.modal.units;
     // [13. Cutter radius compensation ]: G41/42 NOT SUPPORTED
     // gc_state.modal.cutter_comp = gc_block.modal.cutter_comp; // NOTE: Not needed since always disabled.
-    // [14. Cutter length compensation ]: G43.1 and G49 supported. G43 NOT SUPPORTED.
-    // NOTE: If G43 were supported, its operation wouldn't be any different from G43.1 in terms
-    // of execution. The error-checking step would simply load the offset value into the correct
-    // axis of the block XYZ value array.
+    // [14. Cutter length compensation ]: G43, G43.1, G43.4 and G49 supported.
+    // NOTE: G43 executes as G43.1 does.  The error-checking step loaded the tool table
+    // entry into the correct axis of the block XYZ value array.
     if (axis_command == AxisCommand::ToolLengthOffset) {  // Indicates a change.
+        bool tcp_changed = (gc_state.modal.tool_length == ToolLengthOffset::EnableTcp) !=
+                           (gc_block.modal.tool_length == ToolLengthOffset::EnableTcp);
         gc_state.modal.tool_length = gc_block.modal.tool_length;
         if (gc_state.modal.tool_length == ToolLengthOffset::Cancel) {  // G49
             gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = 0.0;
         }
-        // else G43.1
-        if (gc_state.tool_length_offset != gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS]) {
+        // else G43.1; G43.4 keeps the offset
+        if (gc_state.modal.tool_length != ToolLengthOffset::EnableTcp &&
+            gc_state.tool_length_offset != gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS]) {
             gc_state.tool_length_offset = gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS];
+            gc_offsets_changed();
+        }
+        if (tcp_changed) {
+            // The kinematics now map a different frame to the same motor positions
+            protocol_buffer_synchronize();
+            gc_sync_position();
         }
     }
     // [15. Coordinate system selection ]:
@@ -1792,9 +2568,17 @@ Error gc_execute_line(char* line) {
     // [17. Set distance mode ]:
     gc_state.modal.distance = gc_block.modal.distance;
     // [18. Set retract mode ]: NOT SUPPORTED
+    // [Scaling and rotation ]:
+    gc_state.modal.scaling  = gc_block.modal.scaling;
+    gc_state.modal.rotation = gc_block.modal.rotation;
+    gc_state.transform      = transform;
     // [19. Go to predefined position, Set G10, or Set axis offsets ]:
     switch (gc_block.non_modal_command) {
         case NonModal::SetCoordinateData:
+            if (gc_block.values.l == 1) {
+                ToolTable::set(uint32_t(truncf(gc_block.values.p)), gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS]);
+                break;
+            }
             coords[coord_select]->set(coord_data);
             gc_wco_changed();
             // Update system coordinate system if currently active.
@@ -1837,10 +2621,17 @@ Error gc_execute_line(char* line) {
     // [20. Motion modes ]:
     // NOTE: Commands G10,G28,G30,G92 lock out and prevent axis words from use in motion modes.
     // Enter motion modes only if there are axis words or a motion mode command word in the block.
-    gc_state.modal.motion = gc_block.modal.motion;
+    gc_state.modal.motion       = gc_block.modal.motion;
+    gc_state.modal.retract_mode = gc_block.modal.retract_mode;
+    gc_state.cycle_r            = cycleR;
+    gc_state.cycle_z            = cycleZ;
+    gc_state.cycle_q            = cycleQ;
+    gc_state.cycle_p            = cycleP;
+    gc_state.cycle_clear        = cycleClear;
     if (gc_state.modal.motion != Motion::None) {
         if (axis_command == AxisCommand::MotionMode) {
             GCUpdatePos gc_update_pos = GCUpdatePos::Target;
+            config->_userOutputs->takeQueued(pl_data->outputs_mask, pl_data->outputs_on, pl_data->output_changes);
             if (gc_state.modal.motion == Motion::Linear) {
                 mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
             } else if (gc_state.modal.motion == Motion::Seek) {
@@ -1857,13 +2648,49 @@ Error gc_execute_line(char* line) {
                        axis_linear,
                        clockwiseArc,
                        int(gc_block.values.p));
+            } else if (gc_state.modal.motion == Motion::SpindleSync) {
+                mc_spindle_sync(gc_block.values.xyz, pl_data, gc_state.position, gc_block.values.ijk[Z_AXIS]);
+            } else if (gc_state.modal.motion == Motion::RigidTap) {
+                mc_rigid_tap(gc_block.values.xyz, pl_data, gc_state.position, gc_block.values.ijk[Z_AXIS]);
+            } else if (is_canned_cycle(gc_state.modal.motion)) {
+                // In G91, L repeats the hole at the same increments in the plane
+                float step[2] = { gc_block.values.xyz[axis_0] - gc_state.position[axis_0],
+                                  gc_block.values.xyz[axis_1] - gc_state.position[axis_1] };
+                for (uint32_t i = 0; i < cycleRepeats && !sys.abort; i++) {
+                    if (i) {
+                        copyAxes(gc_state.position, gc_block.values.xyz);
+                        gc_block.values.xyz[axis_0] += step[0];
+                        gc_block.values.xyz[axis_1] += step[1];
+                    }
+                    mc_canned_cycle(gc_block.values.xyz, pl_data, gc_state.position, cycle);
+                }
+            } else if ((gc_state.modal.motion == Motion::CubicSpline) || (gc_state.modal.motion == Motion::QuadSpline)) {
+                // Both kinds are planned as cubics; a quadratic's control point is raised to two.
+                float control[2][2];
+                if (gc_state.modal.motion == Motion::CubicSpline) {
+                    control[0][0]  = gc_state.position[X_AXIS] + gc_block.values.ijk[X_AXIS];
+                    control[0][1]  = gc_state.position[Y_AXIS] + gc_block.values.ijk[Y_AXIS];
+                    control[1][0]  = gc_block.values.xyz[X_AXIS] + gc_block.values.p;
+                    control[1][1]  = gc_block.values.xyz[Y_AXIS] + gc_block.values.q;
+                    spline_exit[0] = gc_block.values.p;
+                    spline_exit[1] = gc_block.values.q;
+                } else {
+                    float qx      = gc_state.position[X_AXIS] + gc_block.values.ijk[X_AXIS];
+                    float qy      = gc_state.position[Y_AXIS] + gc_block.values.ijk[Y_AXIS];
+                    control[0][0] = gc_state.position[X_AXIS] + (2.0f / 3.0f) * (qx - gc_state.position[X_AXIS]);
+                    control[0][1] = gc_state.position[Y_AXIS] + (2.0f / 3.0f) * (qy - gc_state.position[Y_AXIS]);
+                    control[1][0] = gc_block.values.xyz[X_AXIS] + (2.0f / 3.0f) * (qx - gc_block.values.xyz[X_AXIS]);
+                    control[1][1] = gc_block.values.xyz[Y_AXIS] + (2.0f / 3.0f) * (qy - gc_block.values.xyz[Y_AXIS]);
+                }
+                mc_spline(gc_block.values.xyz, pl_data, gc_state.position, control[0], control[1]);
             } else {
                 // NOTE: gc_block.values.xyz is returned from mc_probe_cycle with the updated position value. So
                 // upon a successful probing cycle, the machine position and the returned value should be the same.
                 if (!ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES) {
                     pl_data->motion.noFeedOverride = 1;
                 }
-                gc_update_pos = mc_probe_cycle(gc_block.values.xyz, pl_data, probeAway, probeNoError, axis_words, gc_block.values.p);
+                gc_update_pos = mc_probe_cycle(
+                    gc_block.values.xyz, pl_data, probeAway, probeNoError, axis_words, gc_block.values.p, probeInput);
             }
             // As far as the parser is concerned, the position is now == target. In reality the
             // motion control system might still be processing the action and the real tool position
@@ -1871,6 +2698,15 @@ Error gc_execute_line(char* line) {
             if (sys.abort) {
                 return Error::Reset;
             }
+            if (pl_data->outputs_mask) {
+                // The motion was too short to make a block, so it cannot carry them
+                protocol_buffer_synchronize();
+                Machine::UserOutputs::writeMask(pl_data->outputs_mask, pl_data->outputs_on);
+            }
+            if (pl_data->output_changes.count) {
+                // Past the end of the motion
+                config->_userOutputs->requeue(pl_data->output_changes);
+            }
             if (gc_update_pos == GCUpdatePos::Target) {
                 copyAxes(gc_state.position, gc_block.values.xyz);
             } else if (gc_update_pos == GCUpdatePos::System) {
@@ -1891,6 +2727,7 @@ Error gc_execute_line(char* line) {
             break;
         case ProgramFlow::Paused:
             protocol_buffer_synchronize();  // Sync and finish all remaining buffered motions before moving on.
+            spindle->finishDelay();
             if (!state_is(State::CheckMode)) {
                 protocol_send_event(&feedHoldEvent);
                 protocol_execute_realtime();  // Execute suspend.
@@ -1915,6 +2752,10 @@ Error gc_execute_line(char* line) {
             gc_state.modal.coord_select = CoordIndex::G54;
             gc_state.modal.spindle      = SpindleState::Disable;
             gc_state.modal.coolant      = {};
+            // Like a reset on most controls, the end of the program also cancels G51 and G68
+            gc_state.modal.scaling  = Scaling::Disable;
+            gc_state.modal.rotation = Rotation::Disable;
+            gc_update_transform(gc_state.transform, gc_state.modal);
             if (config->_enableParkingOverrideControl) {
                 if (config->_start->_deactivateParking) {
                     gc_state.modal.override = Override::Disabled;
@@ -2002,7 +2843,7 @@ void gc_exec_linef(bool sync_after, Channel& out, const char* format, ...) {
    group 4 = {M1} (Optional stop, ignored)
    group 6 = {M6} (Tool change)
    group 7 = {G41, G42} cutter radius compensation (G40 is supported)
-   group 8 = {G43} tool length offset (G43.1/G49 are supported)
+   group 8 = {G43} tool length offset (G43, G43.1, G43.4 and G49 are supported)
    group 8 = {M7*} enable mist coolant (* Compile-option)
    group 9 = {M48, M49} enable/disable feed and speed override switches
    group 10 = {G98, G99} return mode canned cycles
@@ -2034,22 +2875,35 @@ template <class... Ts>
 overloaded(Ts...) -> overloaded<Ts...>;
 
 static Error gc_wait_on_input(bool is_digital, uint8_t input_number, WaitOnInputMode mode, float timeout) {
-    // TODO - only Immediate read mode is supported
+    auto const on_error = [&](Error error) {
+        log_error("M66: " << (is_digital ? "digital" : "analog") << "_input" << input_number << " failed");
+        return error;
+    };
+
     if (mode == WaitOnInputMode::Immediate) {
-        auto const result = is_digital ? config->_userInputs->readDigitalInput(input_number) :
-                                         config->_userInputs->readAnalogInput(input_number);
-        auto const on_ok  = [&](bool result) {
-            log_debug("M66: " << (is_digital ? "digital" : "analog") << "_input" << input_number << " result=" << result);
-            set_numbered_param(5399, result ? 1.0 : 0.0);
+        if (is_digital) {
+            auto const on_ok = [&](bool result) {
+                log_debug("M66: digital_input" << input_number << " result=" << result);
+                set_numbered_param(5399, result ? 1.0 : 0.0);
+                return Error::Ok;
+            };
+            return std::visit(overloaded { on_ok, on_error }, config->_userInputs->readDigitalInput(input_number));
+        }
+        auto const on_ok = [&](float result) {
+            log_debug("M66: analog_input" << input_number << " result=" << result);
+            set_numbered_param(5399, result);
             return Error::Ok;
         };
-        auto const on_error = [&](Error error) {
-            log_error("M66: " << (is_digital ? "digital" : "analog") << "_input" << input_number << " failed");
-            return error;
-        };
-        return std::visit(overloaded { on_ok, on_error }, result);
+        return std::visit(overloaded { on_ok, on_error }, config->_userInputs->readAnalogInput(input_number));
     }
 
-    // TODO - implement rest of modes
-    return Error::GcodeValueWordInvalid;
+    // The wait starts when the motion before it has finished
+    protocol_buffer_synchronize();
+    auto const on_ok = [&](std::optional<bool> result) {
+        log_debug("M66: digital_input" << input_number << " result=" << (result ? int(*result) : -1));
+        set_numbered_param(5399, result ? (*result ? 1.0 : 0.0) : -1.0);  // -1 on timeout
+        return Error::Ok;
+    };
+    uint32_t timeout_ms = timeout > 0 ? uint32_t(timeout * 1000) : 0;
+    return std::visit(overloaded { on_ok, on_error }, config->_userInputs->waitDigitalInput(input_number, mode, timeout_ms));
 }
@@ -8,6 +8,7 @@
 #include "Config.h"
 #include "Error.h"
 #include "SpindleDatatypes.h"
+#include "Types.h"  // AxisMask
 
 #include <cstdint>
 #include <optional>
@@ -30,7 +31,7 @@ enum class Override : uint8_t {
 enum class ModalGroup : uint8_t {
     // Table 5. G-code Modal Groups
     MG0  = 0,   // [G4,G10,G28,G28.1,G30,G30.1,G53,G92,G92.1] Non-modal
-    MG1  = 1,   // [G0,G1,G2,G3,G38.2,G38.3,G38.4,G38.5,G80] Motion
+    MG1  = 1,   // [G0,G1,G2,G3,G38.2,G38.3,G38.4,G38.5,G73,G80-G86,G89] Motion
     MG2  = 2,   // [G17,G18,G19] Plane selection
     MG3  = 3,   // [G90,G91] Distance mode
     MG4  = 4,   // [G91.1] Arc IJK distance mode
@@ -48,6 +49,9 @@ enum class ModalGroup : uint8_t {
     MM8  = 15,  // [M7,M8,M9] Coolant control
     MM9  = 16,  // [M56] Override control
     MM10 = 17,  // [M100-M199] User Defined
+    MG10 = 18,  // [G98,G99] Canned cycle return mode
+    MG11 = 19,  // [G50,G51] Scaling
+    MG16 = 20,  // [G68,G69] Coordinate system rotation
 };
 
 // Command actions for within execution-type modal groups (motion, stopping, non-modal). Used
@@ -78,13 +82,30 @@ enum class Motion : gcodenum_t {
     Linear             = 10,   // G1
     CwArc              = 20,   // G2
     CcwArc             = 30,   // G3
+    CubicSpline        = 50,   // G5
+    QuadSpline         = 51,   // G5.1
+    SpindleSync        = 330,  // G33
+    RigidTap           = 331,  // G33.1
     ProbeToward        = 382,  // G38.2
     ProbeTowardNoError = 383,  // G38.3
     ProbeAway          = 384,  // G38.4
     ProbeAwayNoError   = 385,  // G38.5
+    DrillChipBreak     = 730,  // G73
     None               = 800,  // G80
+    Drill              = 810,  // G81
+    DrillDwell         = 820,  // G82
+    DrillPeck          = 830,  // G83
+    Tap                = 840,  // G84
+    Bore               = 850,  // G85
+    BoreSpindleStop    = 860,  // G86
+    BoreDwell          = 890,  // G89
 };
 
+// True for the canned cycles, G73 and G81-G89
+inline bool is_canned_cycle(Motion motion) {
+    return motion == Motion::DrillChipBreak || (motion >= Motion::Drill && motion <= Motion::BoreDwell);
+}
+
 // Modal Group G2: Plane select
 enum class Plane : gcodenum_t {
     XY = 170,  // G17
@@ -131,6 +152,24 @@ enum class CutterCompensation : gcodenum_t {
     Enable  = 410,
 };
 
+// Modal Group G10: Canned cycle return mode
+enum class RetractMode : gcodenum_t {
+    OldZ   = 980,  // G98 Default - to the height before the cycles began, or R if that is lower
+    RPlane = 990,  // G99
+};
+
+// Modal Group G11: Scaling
+enum class Scaling : gcodenum_t {
+    Disable = 500,  // G50 Default
+    Enable  = 510,  // G51
+};
+
+// Modal Group G16: Coordinate system rotation
+enum class Rotation : gcodenum_t {
+    Disable = 690,  // G69 Default
+    Enable  = 680,  // G68
+};
+
 // Modal Group G13: Control mode
 enum class ControlMode : gcodenum_t {
     ExactPath = 610,  // G61
@@ -183,7 +222,9 @@ static const int MaxUserAnalogPin  = 4;
 // Modal Group G8: Tool length offset
 enum class ToolLengthOffset : gcodenum_t {
     Cancel        = 490,  // G49 Default
+    EnableTable   = 430,  // G43 - from the tool table, see ToolTable in Settings.h
     EnableDynamic = 431,  // G43.1
+    EnableTcp     = 434,  // G43.4 - tool center point control, for kinematics that support it
 };
 
 static const uint32_t MaxToolNumber = 99999999;
@@ -223,7 +264,10 @@ enum class GCodeWord : uint8_t {
     C = 17,
     O = 18,
     D = 19,  // For debugging
-
+    U = 20,
+    V = 21,
+    W = 22,
+    H = 23,
 };
 
 // GCode parser position updating flags
@@ -261,7 +305,7 @@ CoordIndex& operator++(CoordIndex& i);
 
 // NOTE: When this struct is zeroed, the 0 values in the above types set the system defaults.
 struct gc_modal_t {
-    Motion   motion;     // {G0,G1,G2,G3,G38.2,G80}
+    Motion   motion;     // {G0,G1,G2,G3,G38.2,G80,G81}
     FeedRate feed_rate;  // {G93,G94}
     Units    units;      // {G20,G21}
     Distance distance;   // {G90,G91}
@@ -276,13 +320,17 @@ struct gc_modal_t {
     SpindleState  spindle;       // {M3,M4,M5}
     ToolChange    tool_change;   // {M6}
     SetToolNumber set_tool_number;
-    IoControl     io_control;  // {M62, M63, M67}
-    Override      override;    // {M56}
+    IoControl     io_control;    // {M62, M63, M67}
+    Override      override;      // {M56}
+    RetractMode   retract_mode;  // {G98,G99}
+    Scaling       scaling;       // {G50,G51}
+    Rotation      rotation;      // {G68,G69}
 };
 
 struct gc_values_t {
     uint8_t  e;                // {M66,M67}
     float    f;                // Feed
+    uint32_t h;                // Tool table entry {G43}
     float    ijk[3];           // I,J,K Axis arc offsets - only 3 are possible
     uint8_t  l;                // {M66,G10}, or canned cycles parameters
     int32_t  n;                // Line number
@@ -295,6 +343,33 @@ struct gc_values_t {
     float    xyz[MAX_N_AXIS];  // X,Y,Z Translational axes
 };
 
+// G51 scaling and G68 rotation of the programmed XYZ, about centers in the work coordinate
+// system.  Together they are one affine map, matrix * xyz + offset, that is recomputed only
+// when G50, G51, G68 or G69 change them, so a block costs one 3x3 multiply.  The map is in
+// work coordinates, so changing the work offsets does not change it.
+struct gc_transform_t {
+    float    scale_center[3];
+    float    scale;               // G51 P
+    float    rotation_center[2];  // In the plane of the rotation
+    float    rotation;            // G68 R, in degrees
+    size_t   axis_0;              // The plane of the rotation
+    size_t   axis_1;
+    float    matrix[3][3];
+    float    offset[3];
+    float    inverse[3][3];  // Maps back to find the programmed position of the tool
+    AxisMask mapped;         // The axes the map moves, none when G50 and G69 are in effect
+};
+
+// Program coordinates in G90 to machine mm, value * scale + offset per axis, where the scale
+// converts inches and the offset is the sum of the work offset, G92 and the tool length
+// offset.  It is rebuilt on use after gc_offsets_changed() or a change of units.
+struct gc_program_map_t {
+    float scale[MAX_N_AXIS];
+    float offset[MAX_N_AXIS];
+    Units units;  // Those it was built for
+    bool  valid;
+};
+
 struct parser_state_t {
     gc_modal_t modal;
 
@@ -312,6 +387,18 @@ struct parser_state_t {
     // machine zero in mm. Non-persistent. Cleared upon reset and boot.
     float tool_length_offset;  // Tracks tool length offset value when enabled.
     bool  skip_blocks;         // Skipping due to flow control
+
+    // Canned cycle words, which carry over to the following blocks of the cycle, as programmed
+    // but in mm.  cycle_clear is the machine position, along the drilling axis, that G98 returns
+    // to, the one before the first of a run of cycles.
+    float cycle_r;
+    float cycle_z;
+    float cycle_q;
+    float cycle_p;
+    float cycle_clear;
+
+    gc_transform_t   transform;
+    gc_program_map_t program_map;
 };
 
 extern parser_state_t gc_state;
@@ -344,4 +431,8 @@ void gc_ngc_changed(CoordIndex coord);
 void gc_wco_changed();
 void gc_ovr_changed();
 
+// Called when the work offset, G92 or the tool length offset change without one of the
+// hooks above, so that gc_state.program_map is rebuilt
+void gc_offsets_changed();
+
 extern gc_modal_t modal_defaults;
@@ -1,37 +1,41 @@
 #include "HashFS.h"
 #include "FileStream.h"
+#include "DirCache.h"
 
 #include <mbedtls/md.h>
 
-std::map<std::string, std::string> HashFS::localFsHashes;
+std::map<std::string, HashFS::Entry> HashFS::localFsHashes;
+std::map<std::string, HashFS::Entry> HashFS::otherHashes;
+
+const char* HashFS::indexName = ".hashes";
 
 static char hexNibble(int i) {
     return "0123456789ABCDEF"[i & 0xf];
 }
 
-static Error hashFile(const std::filesystem::path& ipath, std::string& str) {  // No ESP command
-    mbedtls_md_context_t ctx;
+HashFS::Hasher::Hasher() {
+    auto ctx = new mbedtls_md_context_t;
+    mbedtls_md_init(ctx);
+    mbedtls_md_setup(ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+    mbedtls_md_starts(ctx);
+    _ctx = ctx;
+}
 
-    uint8_t shaResult[32];
+HashFS::Hasher::~Hasher() {
+    auto ctx = static_cast<mbedtls_md_context_t*>(_ctx);
+    mbedtls_md_free(ctx);
+    delete ctx;
+}
 
-    try {
-        FileStream inFile { ipath, "r" };
-        uint8_t    buf[512];
-        size_t     len;
+void HashFS::Hasher::update(const uint8_t* data, size_t length) {
+    mbedtls_md_update(static_cast<mbedtls_md_context_t*>(_ctx), data, length);
+}
 
-        mbedtls_md_init(&ctx);
-        mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
-        mbedtls_md_starts(&ctx);
-        while ((len = inFile.read(buf, 512)) > 0) {
-            mbedtls_md_update(&ctx, buf, len);
-        }
-        mbedtls_md_finish(&ctx, shaResult);
-        mbedtls_md_free(&ctx);
-    } catch (const Error err) {
-        log_debug("Cannot hash file " << ipath);
-        return Error::FsFailedOpenFile;
-    }
+std::string HashFS::Hasher::finish() {
+    uint8_t shaResult[32];
+    mbedtls_md_finish(static_cast<mbedtls_md_context_t*>(_ctx), shaResult);
 
+    std::string str;
     str = '"';
     for (int i = 0; i < 32; i++) {
         uint8_t b = shaResult[i];
@@ -39,6 +43,24 @@ static Error hashFile(const std::filesystem::path& ipath, std::string& str) {  /
         str += hexNibble(b);
     }
     str += '"';
+    return str;
+}
+
+static Error hashFile(const std::filesystem::path& ipath, std::string& str) {  // No ESP command
+    try {
+        FileStream     inFile { ipath, "r" };
+        HashFS::Hasher hasher;
+        uint8_t        buf[512];
+        size_t         len;
+
+        while ((len = inFile.read(buf, 512)) > 0) {
+            hasher.update(buf, len);
+        }
+        str = hasher.finish();
+    } catch (const Error err) {
+        log_debug("Cannot hash file " << ipath);
+        return Error::FsFailedOpenFile;
+    }
 
     return Error::Ok;
 }
@@ -47,8 +69,69 @@ void HashFS::report_change() {
     log_msg("Files changed");
 }
 
+// Hashing every file at startup delays WebUI noticeably, so the hashes are kept in
+// an index file with one "name<TAB>size<TAB>mtime<TAB>hash" line per file.
+void HashFS::load_index(std::map<std::string, Entry>& index) {
+    try {
+        FileStream  inFile { indexName, "r", localfsName };
+        std::string line;
+        int         c;
+        while ((c = inFile.read()) != -1) {
+            if (c != '\n') {
+                line += char(c);
+                continue;
+            }
+            auto tab1 = line.find('\t');
+            auto tab2 = line.find('\t', tab1 + 1);
+            auto tab3 = line.find('\t', tab2 + 1);
+            if (tab1 != std::string::npos && tab2 != std::string::npos && tab3 != std::string::npos) {
+                Entry& entry = index[line.substr(0, tab1)];
+                entry.size   = strtoull(line.c_str() + tab1 + 1, nullptr, 10);
+                entry.mtime  = strtoll(line.c_str() + tab2 + 1, nullptr, 10);
+                entry.hash   = line.substr(tab3 + 1);
+            }
+            line.clear();
+        }
+    } catch (const Error err) {
+        // No index yet
+    }
+}
+
+void HashFS::save_index() {
+    try {
+        FileStream outFile { indexName, "w", localfsName };
+        for (const auto& [name, entry] : localFsHashes) {
+            if (entry.hash.length()) {
+                std::string line(name);
+                line += '\t';
+                line += std::to_string(entry.size);
+                line += '\t';
+                line += std::to_string(entry.mtime);
+                line += '\t';
+                line += entry.hash;
+                line += '\n';
+                outFile.write((const uint8_t*)line.c_str(), line.length());
+            }
+        }
+    } catch (const Error err) { log_debug("Cannot save file hashes"); }
+}
+
+bool HashFS::stamp(const std::filesystem::path& path, Entry& entry) {
+    std::error_code ec;
+    entry.size = stdfs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    entry.mtime = stdfs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
 void HashFS::delete_file(const std::filesystem::path& path, bool report) {
-    localFsHashes.erase(path.filename());
+    DirCache::invalidate(path);
+    otherHashes.erase(path);
+    if (localFsHashes.erase(path.filename())) {
+        save_index();
+    }
     if (report) {
         report_change();
     }
@@ -62,20 +145,23 @@ bool HashFS::file_is_hashable(const std::filesystem::path& path) {
     // The first component is "/", then e.g. "littlefs", then
     // the filename.  If there are more components, there is
     // a subdirectory and we do not hash it.
-    if (count != 3) {
+    if (count != 3 || path.filename() == indexName) {
         return false;
     }
     auto fsname = *++path.begin();
     return fsname == "littlefs" || fsname == "spiffs" || fsname == "localfs";
 }
 
+// The file is hashed when its hash is next requested
 void HashFS::rehash_file(const std::filesystem::path& path, bool report) {
+    DirCache::invalidate(path);
+    otherHashes.erase(path);
     if (file_is_hashable(path)) {
-        std::string hash;
-        if (hashFile(path, hash) != Error::Ok) {
+        Entry entry;
+        if (!stamp(path, entry)) {
             delete_file(path, false);
         } else {
-            localFsHashes[path.filename()] = hash;
+            localFsHashes[path.filename()] = entry;
         }
     }
     if (report) {
@@ -96,28 +182,97 @@ void HashFS::hash_all() {
         return;
     }
 
+    std::map<std::string, Entry> index;
+    load_index(index);
+
     auto iter = stdfs::directory_iterator { lfspath, ec };
     if (ec) {
         log_error(lfspath << " " << ec.message());
         return;
     }
+    size_t stale = 0;
     for (auto const& dir_entry : iter) {
-        if (!dir_entry.is_directory()) {
-            rehash_file(dir_entry, false);
+        if (!dir_entry.is_directory() && file_is_hashable(dir_entry)) {
+            Entry entry;
+            if (!stamp(dir_entry, entry)) {
+                continue;
+            }
+            auto it = index.find(dir_entry.path().filename());
+            if (it != index.end() && it->second.size == entry.size && it->second.mtime == entry.mtime) {
+                entry.hash = it->second.hash;
+            } else {
+                ++stale;
+            }
+            localFsHashes[dir_entry.path().filename()] = entry;
         }
     }
+    if (stale || index.size() != localFsHashes.size() - stale) {
+        save_index();
+    }
 }
 std::string HashFS::hash(const std::filesystem::path& path, bool useCacheOnly /*= false*/) {
     if (file_is_hashable(path)) {
-        std::map<std::string, std::string>::const_iterator it;
-        it = localFsHashes.find(path.filename());
-        if (it != localFsHashes.end()) {
-            return it->second;
+        auto it = localFsHashes.find(path.filename());
+        if (it == localFsHashes.end()) {
+            return std::string();
+        }
+        Entry& entry = it->second;
+        if (entry.hash.empty() && !useCacheOnly) {
+            if (hashFile(path, entry.hash) == Error::Ok && stamp(path, entry)) {
+                save_index();
+            } else {
+                entry.hash.clear();
+            }
         }
+        return entry.hash;
     } else if (!useCacheOnly) {
-        std::string theHash;
-        hashFile(path, theHash);
-        return theHash;
+        Entry current;
+        if (!stamp(path, current)) {
+            return std::string();
+        }
+        auto it = otherHashes.find(path);
+        if (it != otherHashes.end() && it->second.size == current.size && it->second.mtime == current.mtime) {
+            return it->second.hash;
+        }
+        if (hashFile(path, current.hash) != Error::Ok) {
+            return std::string();
+        }
+        otherHashes[path] = current;
+        return current.hash;
     }
     return std::string();
 }
+
+void HashFS::set_hash(const std::filesystem::path& path, const std::string& hash) {
+    Entry entry;
+    if (!stamp(path, entry)) {
+        return;
+    }
+    entry.hash = hash;
+    if (file_is_hashable(path)) {
+        localFsHashes[path.filename()] = entry;
+        save_index();
+    } else {
+        otherHashes[path] = entry;
+    }
+}
+
+std::filesystem::path HashFS::find(const std::string& hash, uintmax_t size) {
+    for (auto it = otherHashes.begin(); it != otherHashes.end();) {
+        Entry current;
+        if (!stamp(it->first, current) || current.size != it->second.size || current.mtime != it->second.mtime) {
+            it = otherHashes.erase(it);  // Changed or removed behind our back
+            continue;
+        }
+        if (it->second.size == size && it->second.hash == hash) {
+            return it->first;
+        }
+        ++it;
+    }
+    for (auto const& [name, entry] : localFsHashes) {
+        if (entry.size == size && entry.hash == hash) {
+            return FluidPath { name.c_str(), localfsName };
+        }
+    }
+    return {};
+}
@@ -1,11 +1,35 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <map>
 #include <filesystem>
 
 class HashFS {
 public:
-    static std::map<std::string, std::string> localFsHashes;
+    // Computes a hash, in the same format that hash() returns, from data that is
+    // supplied in pieces, e.g. while a file is being uploaded.
+    class Hasher {
+        void* _ctx;
+
+    public:
+        Hasher();
+        Hasher(const Hasher&)            = delete;
+        Hasher& operator=(const Hasher&) = delete;
+        ~Hasher();
+
+        void        update(const uint8_t* data, size_t length);
+        std::string finish();
+    };
+
+    // The size and modification time identify the file contents that were hashed.
+    // An empty hash means that the file has changed and will be hashed when the
+    // hash is next requested.
+    struct Entry {
+        std::string hash;
+        uintmax_t   size  = 0;
+        int64_t     mtime = 0;
+    };
+    static std::map<std::string, Entry> localFsHashes;
 
     static bool file_is_hashable(const std::filesystem::path& path);
     static void delete_file(const std::filesystem::path& path, bool report = true);
@@ -16,5 +40,20 @@ public:
 
     static std::string hash(const std::filesystem::path& path, bool useCacheOnly = false);
 
+    // Records a hash that was computed while the file was written
+    static void set_hash(const std::filesystem::path& path, const std::string& hash);
+
+    // A file known to have the given hash and size, or an empty path
+    static std::filesystem::path find(const std::string& hash, uintmax_t size);
+
 private:
+    static const char* indexName;  // Sidecar file that keeps the hashes across restarts
+
+    // Hashes of files outside LocalFS, such as jobs on the SD card, keyed by path.
+    // They are computed on request and are not saved.
+    static std::map<std::string, Entry> otherHashes;
+
+    static bool stamp(const std::filesystem::path& path, Entry& entry);
+    static void load_index(std::map<std::string, Entry>& index);
+    static void save_index();
 };
@@ -0,0 +1,172 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "HeapStats.h"
+#include "Logging.h"
+#include "Memory.h"
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace HeapStats {
+#ifdef HEAP_STATS
+    static const char* tagNames[] = { "other", "logging", "channel", "gcode", "settings", "report", "config", "json" };
+    static_assert(sizeof(tagNames) / sizeof(tagNames[0]) == size_t(HeapTag::Count), "A HeapTag has no name");
+
+    struct Counters {
+        std::atomic<uint32_t> allocs { 0 };
+        std::atomic<uint32_t> bytes { 0 };
+    };
+    static Counters              _counters[size_t(HeapTag::Count)];
+    static std::atomic<uint32_t> _frees { 0 };
+
+    // The current tag of each task that has opened a HeapScope.  thread_local cannot
+    // be used because allocations happen in static constructors before the scheduler
+    // starts.  A slot is claimed by its task and written only by that task.
+    struct TaskTag {
+        std::atomic<void*> task { nullptr };
+        HeapTag            tag = HeapTag::Other;
+    };
+    static const int maxTaggedTasks = 8;
+    static TaskTag   _taskTags[maxTaggedTasks];
+
+    static TaskTag* task_tag(bool claim) {
+        void* me = xTaskGetCurrentTaskHandle();
+        if (!me) {
+            return nullptr;
+        }
+        for (auto& t : _taskTags) {
+            if (t.task.load(std::memory_order_relaxed) == me) {
+                return &t;
+            }
+        }
+        if (claim) {
+            for (auto& t : _taskTags) {
+                void* expected = nullptr;
+                if (t.task.compare_exchange_strong(expected, me)) {
+                    return &t;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    HeapTag swap_tag(HeapTag tag) {
+        TaskTag* t = task_tag(true);
+        if (!t) {
+            return HeapTag::Other;
+        }
+        HeapTag previous = t->tag;
+        t->tag           = tag;
+        return previous;
+    }
+
+    static void* counted_alloc(size_t size) {
+        TaskTag* t = task_tag(false);
+        auto&    c = _counters[size_t(t ? t->tag : HeapTag::Other)];
+        c.allocs.fetch_add(1, std::memory_order_relaxed);
+        c.bytes.fetch_add(size, std::memory_order_relaxed);
+        return malloc(size ? size : 1);
+    }
+
+    static void counted_free(void* p) {
+        if (p) {
+            _frees.fetch_add(1, std::memory_order_relaxed);
+            free(p);
+        }
+    }
+
+    Totals totals() {
+        Totals t = { 0, 0, _frees.load() };
+        for (auto& c : _counters) {
+            t.allocs += c.allocs.load();
+            t.bytes += c.bytes.load();
+        }
+        return t;
+    }
+
+    void reset() {
+        for (auto& c : _counters) {
+            c.allocs = 0;
+            c.bytes  = 0;
+        }
+        _frees = 0;
+    }
+
+    static Totals _jobStart;
+
+    void job_start() { _jobStart = totals(); }
+
+    void job_end() {
+        Totals t = totals();
+        log_info("Job heap use: " << (t.allocs - _jobStart.allocs) << " allocations of " << (t.bytes - _jobStart.bytes) << " bytes, "
+                                  << (t.frees - _jobStart.frees) << " frees, largest free block "
+                                  << heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    }
+#else
+    Totals totals() { return { 0, 0, 0 }; }
+    void   reset() {}
+    void   job_start() {}
+    void   job_end() {}
+#endif
+
+    static void report_region(Channel& out, const char* name, uint32_t caps) {
+        size_t free    = heap_caps_get_free_size(caps);
+        size_t largest = heap_caps_get_largest_free_block(caps);
+        log_stream(out,
+                   name << " free:" << free << " min:" << heap_caps_get_minimum_free_size(caps) << " largest block:" << largest
+                        << " fragmentation:" << (free ? int(100 - (largest * 100) / free) : 0) << "%");
+    }
+
+    void report(Channel& out) {
+        // Internal RAM, then the PSRAM that Bulk buffers go to, see Memory.h
+        report_region(out, "Heap", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (Memory::has_psram()) {
+            report_region(out, "PSRAM", MALLOC_CAP_SPIRAM);
+        }
+#ifdef HEAP_STATS
+        for (size_t i = 0; i < size_t(HeapTag::Count); i++) {
+            auto& c = _counters[i];
+            log_stream(out, tagNames[i] << " allocations:" << c.allocs.load() << " bytes:" << c.bytes.load());
+        }
+        log_stream(out, "frees:" << _frees.load());
+#else
+        log_stream(out, "Allocation counts need a build with -DHEAP_STATS");
+#endif
+    }
+}
+
+#ifdef HEAP_STATS
+void* operator new(size_t size) {
+    void* p = HeapStats::counted_alloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return HeapStats::counted_alloc(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return HeapStats::counted_alloc(size);
+}
+void operator delete(void* p) noexcept {
+    HeapStats::counted_free(p);
+}
+void operator delete[](void* p) noexcept {
+    HeapStats::counted_free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    HeapStats::counted_free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+    HeapStats::counted_free(p);
+}
+#endif
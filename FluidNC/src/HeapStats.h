@@ -0,0 +1,71 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  HeapStats.h - counts C++ heap allocations by subsystem
+
+  When the firmware is built with -DHEAP_STATS, the global operator new and
+  delete are replaced by versions that count allocations, bytes and frees.
+  Each allocation is charged to the tag of the innermost HeapScope open in
+  the allocating task, or to Other.  $Heap/Stats shows the counts along with
+  the free heap, its low-water mark and the largest free block, which together
+  show how fragmented the heap is.  Without HEAP_STATS, HeapScope compiles to
+  nothing and only the heap figures are shown.
+
+  Only C++ allocations are counted; malloc() calls from C code are not.
+*/
+
+#include "Channel.h"
+
+#include <cstdint>
+
+enum class HeapTag : uint8_t {
+    Other = 0,
+    Logging,
+    Channel,
+    GCode,
+    Settings,
+    Report,
+    Config,
+    Json,
+    Count,
+};
+
+namespace HeapStats {
+    struct Totals {
+        uint32_t allocs;
+        uint32_t bytes;
+        uint32_t frees;
+    };
+
+    // The sum over all tags, for before-and-after comparisons
+    Totals totals();
+
+    void report(Channel& out);
+    void reset();
+
+    // Called at the start and end of the outermost job, to report its allocations
+    void job_start();
+    void job_end();
+
+#ifdef HEAP_STATS
+    HeapTag swap_tag(HeapTag tag);
+#endif
+}
+
+class HeapScope {
+#ifdef HEAP_STATS
+    HeapTag _previous;
+
+public:
+    explicit HeapScope(HeapTag tag) : _previous(HeapStats::swap_tag(tag)) {}
+    ~HeapScope() { HeapStats::swap_tag(_previous); }
+#else
+public:
+    explicit HeapScope(HeapTag tag) {}
+#endif
+    HeapScope(const HeapScope&)            = delete;
+    HeapScope& operator=(const HeapScope&) = delete;
+};
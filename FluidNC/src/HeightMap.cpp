@@ -0,0 +1,329 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "HeightMap.h"
+
+#include "Settings.h"
+#include "Machine/MachineConfig.h"
+#include "MotionControl.h"  // probe_succeeded
+#include "GCode.h"          // gc_execute_line(), gc_sync_position()
+#include "Protocol.h"       // protocol_buffer_synchronize(), LINE_BUFFER_SIZE
+#include "System.h"         // probe_steps, invalidate_mpos()
+#include "FileStream.h"
+
+#include <cstring>
+#include <functional>
+
+HeightMap heightMap;
+
+static const char* heightMapFile = "heightmap.txt";
+
+// Changing the map changes the relation between motor and cartesian positions, so
+// the motion in flight has to finish first and the parser position is recomputed after.
+static void change_map(bool enable) {
+    protocol_buffer_synchronize();
+    heightMap.enable(enable);
+    invalidate_mpos();
+    gc_sync_position();
+}
+
+static Error save_map() {
+    std::string text = heightMap.to_text();
+    try {
+        FileStream file(heightMapFile, "w", "");
+        if (file.write(reinterpret_cast<const uint8_t*>(text.data()), text.length()) != text.length()) {
+            return Error::FsFailedCreateFile;
+        }
+    } catch (const Error err) {
+        return Error::FsFailedCreateFile;
+    }
+    return Error::Ok;
+}
+
+static Error load_map() {
+    std::string text;
+    try {
+        FileStream file(heightMapFile, "r", "");
+        text.resize(file.size());
+        if (file.read(text.data(), text.length()) != text.length()) {
+            return Error::FsFailedRead;
+        }
+    } catch (const Error err) {
+        return Error::FsFileNotFound;
+    }
+    return heightMap.from_text(text.c_str()) ? Error::Ok : Error::InvalidValue;
+}
+
+static Error run_line(const char* line) {
+    char buf[LINE_BUFFER_SIZE];
+    strncpy(buf, line, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    log_debug("HeightMap: " << buf);
+    return gc_execute_line(buf);
+}
+
+// Speed for the protected moves between nodes, at which the machine stops within the
+// clearance, the probe's overtravel, when the probe touches something on the way.
+static float travel_rate(float clearance) {
+    auto  x    = Axes::_axis[X_AXIS];
+    auto  y    = Axes::_axis[Y_AXIS];
+    float rate = 60.0f * sqrtf(2.0f * std::fmin(x->_acceleration, y->_acceleration) * clearance);
+    return std::fmin(rate, std::fmin(x->_maxRate, y->_maxRate));
+}
+
+using ContactFn = std::function<Error(int i, int j, float x, float y, float z)>;
+
+// Probes down from safe_z, the height it starts at, at each node of an nx by ny grid over
+// x0..x1, y0..y1 in machine coordinates, visiting the nodes in serpentine order to shorten
+// the travel, and calls contact() with the height found at each.  With no clearance, the
+// probe returns to safe_z between nodes.  Otherwise it only rises to clearance above the
+// higher of the last contact and the one at the next node in the row before, and moves
+// across with G38.3 so that it stops if it touches on the way; it then finishes the move
+// at safe_z.
+static Error probe_grid(float            x0,
+                        float            y0,
+                        float            x1,
+                        float            y1,
+                        int              nx,
+                        int              ny,
+                        float            depth,
+                        float            feed,
+                        float            clearance,
+                        const ContactFn& contact) {
+    char  line[LINE_BUFFER_SIZE];
+    float safe_z = get_mpos()[Z_AXIS];
+    float dx     = (x1 - x0) / (nx - 1);
+    float dy     = (y1 - y0) / (ny - 1);
+    float rate   = travel_rate(clearance);
+    float last   = safe_z;
+
+    std::vector<float> row(nx, -INFINITY), last_row(nx, -INFINITY);
+    for (int j = 0; j < ny; ++j) {
+        for (int k = 0; k < nx; ++k) {
+            int   i = (j & 1) ? nx - 1 - k : k;
+            float x = x0 + i * dx;
+            float y = y0 + j * dy;
+
+            float travel_z = safe_z;
+            if (clearance > 0.0f && (j || k)) {
+                travel_z = std::fmin(safe_z, std::fmax(last, last_row[i]) + clearance);
+            }
+            snprintf(line, sizeof(line), "G21 G53 G0 Z%.3f", travel_z);
+            Error err = run_line(line);
+            if (err == Error::Ok && travel_z < safe_z) {
+                snprintf(line, sizeof(line), "G53 G38.3 X%.3f Y%.3f F%.1f", x, y, rate);
+                err = run_line(line);
+                if (err == Error::Ok && probe_succeeded) {
+                    log_debug("Probe touched between nodes, moving at Z" << safe_z);
+                    snprintf(line, sizeof(line), "G53 G0 Z%.3f", safe_z);
+                    err      = run_line(line);
+                    travel_z = safe_z;
+                }
+            }
+            if (err == Error::Ok && travel_z == safe_z) {
+                snprintf(line, sizeof(line), "G53 G0 X%.3f Y%.3f", x, y);
+                err = run_line(line);
+            }
+            if (err == Error::Ok) {
+                snprintf(line, sizeof(line), "G53 G38.2 Z%.3f F%.1f", safe_z - depth, feed);
+                err = run_line(line);
+            }
+            if (err != Error::Ok) {
+                return err;
+            }
+            if (!probe_succeeded || sys.abort) {
+                log_error("Probe failed at X" << x << " Y" << y);
+                return Error::IdleError;
+            }
+            float position[MAX_N_AXIS];
+            probe_steps_to_mpos(position);
+            last   = position[Z_AXIS];
+            row[i] = last;
+            if ((err = contact(i, j, x, y, last)) != Error::Ok) {
+                return err;
+            }
+        }
+        row.swap(last_row);
+    }
+    snprintf(line, sizeof(line), "G53 G0 Z%.3f", safe_z);
+    return run_line(line);
+}
+
+// Parses up to max_args comma-separated numbers, returning in rest whatever follows them
+static Error parse_args(const char* value, float* args, int max_args, int& n, const char** rest) {
+    n = 0;
+    if (!value) {
+        return Error::Ok;
+    }
+    const char* p = value;
+    while (n < max_args && *p) {
+        char* end;
+        args[n] = strtof(p, &end);
+        if (end == p) {
+            break;
+        }
+        ++n;
+        p = end;
+        if (*p == ',') {
+            ++p;
+        }
+    }
+    if (rest) {
+        *rest = p;
+    } else if (*p) {
+        return Error::BadNumberFormat;
+    }
+    return Error::Ok;
+}
+
+// $HeightMap/Probe=x0,y0,x1,y1,nx,ny[,depth,feed]
+// Probes down from the current Z at each node of the grid, returning to that height
+// between nodes.  The nodes are visited in serpentine order to shorten the travel.
+static Error probe_map(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!state_is(State::Idle)) {
+        return Error::IdleError;
+    }
+    float args[8] = { 0, 0, 0, 0, 0, 0, 10.0f, 100.0f };
+    int   n;
+    Error err = parse_args(value, args, 8, n, nullptr);
+    if (err != Error::Ok) {
+        return err;
+    }
+    if (n < 6 || args[6] <= 0.0f || args[7] <= 0.0f) {
+        return Error::InvalidValue;
+    }
+
+    change_map(false);
+    if (!heightMap.resize(args[0], args[1], args[2], args[3], int(args[4]), int(args[5]))) {
+        return Error::InvalidValue;
+    }
+
+    // The probe lines set the units, motion mode and feed rate, which belong to the job
+    auto  modal = gc_state.modal;
+    float feed  = gc_state.feed_rate;
+    auto  store = [](int i, int j, float x, float y, float z) {
+        heightMap.set(i, j, z);
+        return Error::Ok;
+    };
+    err = probe_grid(args[0], args[1], args[2], args[3], heightMap.nx(), heightMap.ny(), args[6], args[7], 0.0f, store);
+
+    gc_state.modal     = modal;
+    gc_state.feed_rate = feed;
+    if (err != Error::Ok) {
+        heightMap.clear();
+        return err;
+    }
+
+    heightMap.normalize();
+    log_info("HeightMap: " << heightMap.nx() << "x" << heightMap.ny() << " nodes probed");
+    return save_map();
+}
+
+// $Probe/Grid=x0,y0,x1,y1,nx,ny[,depth,feed,clearance][,file]
+// Digitizes a surface, reporting x,y,z of each contact in machine coordinates as it is
+// found, and also writing them to file if one is named.  The probe starts at the current
+// Z and keeps clearance, default 2 mm, above the surface between nodes; a clearance of 0
+// returns it to the starting Z each time.  Unlike $HeightMap/Probe, the grid is not kept,
+// so it can be as large as the job needs.
+static Error probe_surface(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!state_is(State::Idle)) {
+        return Error::IdleError;
+    }
+    float       args[9] = { 0, 0, 0, 0, 0, 0, 10.0f, 100.0f, 2.0f };
+    int         n;
+    const char* filename = "";
+    Error       err      = parse_args(value, args, 9, n, &filename);
+    if (err != Error::Ok) {
+        return err;
+    }
+    int nx = int(args[4]);
+    int ny = int(args[5]);
+    if (n < 6 || nx < 2 || ny < 2 || !(args[2] > args[0]) || !(args[3] > args[1]) || args[6] <= 0.0f || args[7] <= 0.0f ||
+        args[8] < 0.0f) {
+        return Error::InvalidValue;
+    }
+
+    FileStream* file = nullptr;
+    if (*filename) {
+        try {
+            file = new FileStream(filename, "w", "sd");
+        } catch (const Error err) {
+            return Error::FsFailedCreateFile;
+        }
+    }
+
+    auto  modal  = gc_state.modal;
+    float feed   = gc_state.feed_rate;
+    auto  report = [&](int i, int j, float x, float y, float z) {
+        char csv[48];
+        int  len = snprintf(csv, sizeof(csv), "%.3f,%.3f,%.4f", x, y, z);
+        log_stream(out, csv);
+        if (file) {
+            csv[len++] = '\n';
+            if (file->write(reinterpret_cast<const uint8_t*>(csv), len) != size_t(len)) {
+                return Error::FsFailedCreateFile;
+            }
+        }
+        return Error::Ok;
+    };
+    log_stream(out, "[GRID:" << nx << "," << ny << "]");
+    err = probe_grid(args[0], args[1], args[2], args[3], nx, ny, args[6], args[7], args[8], report);
+
+    gc_state.modal     = modal;
+    gc_state.feed_rate = feed;
+    delete file;
+    return err;
+}
+
+static Error show_map(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (heightMap.empty()) {
+        log_stream(out, "HeightMap empty");
+        return Error::Ok;
+    }
+    log_stream(out, "HeightMap " << (heightMap.active() ? "enabled" : "disabled"));
+    std::string text = heightMap.to_text();
+    size_t      pos  = 0;
+    size_t      eol;
+    while ((eol = text.find('\n', pos)) != std::string::npos) {
+        log_stream(out, text.substr(pos, eol - pos));
+        pos = eol + 1;
+    }
+    return Error::Ok;
+}
+
+static Error clear_map(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    change_map(false);
+    heightMap.clear();
+    return Error::Ok;
+}
+
+// $HeightMap/Enable[=ON|OFF] - loads the saved map if none is in memory
+static Error enable_map(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    bool on = true;
+    if (value && *value) {
+        if (strcasecmp(value, "ON") == 0) {
+            on = true;
+        } else if (strcasecmp(value, "OFF") == 0) {
+            on = false;
+        } else {
+            return Error::InvalidValue;
+        }
+    }
+    if (on && !heightMap.complete()) {
+        Error err = load_map();
+        if (err != Error::Ok) {
+            return err;
+        }
+    }
+    change_map(on);
+    log_info("HeightMap " << (heightMap.active() ? "enabled" : "disabled"));
+    return Error::Ok;
+}
+
+void make_heightmap_commands() {
+    new UserCommand("HMP", "HeightMap/Probe", probe_map, notIdleOrAlarm);
+    new UserCommand("HMS", "HeightMap/Show", show_map, anyState);
+    new UserCommand("HMC", "HeightMap/Clear", clear_map, notIdleOrAlarm);
+    new UserCommand("HME", "HeightMap/Enable", enable_map, notIdleOrAlarm);
+    new UserCommand("PRG", "Probe/Grid", probe_surface, notIdleOrAlarm);
+}
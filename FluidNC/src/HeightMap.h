@@ -0,0 +1,167 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  HeightMap.h - probed surface heights for bed leveling
+
+  The map is a regular grid of Z offsets over a rectangle of the XY plane in machine
+  coordinates.  offset() interpolates bilinearly within a cell and holds the edge values
+  outside the grid.  The offsets are relative to the first node, so the surface is
+  followed from wherever Z was zeroed on it.
+
+  The text form, as saved on the local filesystem, is one header line
+
+    x0 y0 dx dy nx ny
+
+  followed by ny lines of nx heights each, starting at y0.  The math and the text form
+  have no dependencies so that they can be checked on the host.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+class HeightMap {
+    float              _x0 = 0.0f, _y0 = 0.0f;
+    float              _dx = 0.0f, _dy = 0.0f;
+    int                _nx = 0, _ny = 0;
+    std::vector<float> _z;  // _nx per row, x varying fastest; NaN until probed
+    bool               _enabled = false;
+
+public:
+    static const int max_nodes = 4096;
+
+    int   nx() const { return _nx; }
+    int   ny() const { return _ny; }
+    float x(int i) const { return _x0 + i * _dx; }
+    float y(int j) const { return _y0 + j * _dy; }
+    float z(int i, int j) const { return _z[j * _nx + i]; }
+    void  set(int i, int j, float z) { _z[j * _nx + i] = z; }
+
+    // The shorter cell side, for splitting moves
+    float spacing() const { return std::fmin(_dx, _dy); }
+
+    bool empty() const { return _z.empty(); }
+    bool complete() const {
+        if (_z.empty()) {
+            return false;
+        }
+        for (float z : _z) {
+            if (std::isnan(z)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Compensation is applied only when it has been turned on for a complete map
+    bool active() const { return _enabled; }
+    bool enable(bool on) {
+        _enabled = on && complete();
+        return _enabled == on;
+    }
+
+    void clear() {
+        _enabled = false;
+        _nx = _ny = 0;
+        std::vector<float>().swap(_z);
+    }
+
+    // Sizes the grid over x0..x1, y0..y1, with every node unprobed
+    bool resize(float x0, float y0, float x1, float y1, int nx, int ny) {
+        clear();
+        if (nx < 2 || ny < 2 || nx > max_nodes || ny > max_nodes || nx * ny > max_nodes || !(x1 > x0) || !(y1 > y0)) {
+            return false;
+        }
+        _x0 = x0;
+        _y0 = y0;
+        _dx = (x1 - x0) / (nx - 1);
+        _dy = (y1 - y0) / (ny - 1);
+        _nx = nx;
+        _ny = ny;
+        _z.assign(nx * ny, NAN);
+        return true;
+    }
+
+    // Makes the heights relative to the first node
+    void normalize() {
+        float base = _z[0];
+        for (float& z : _z) {
+            z -= base;
+        }
+    }
+
+    float offset(float x, float y) const {
+        float u = (x - _x0) / _dx;
+        float v = (y - _y0) / _dy;
+        u       = std::fmin(std::fmax(u, 0.0f), float(_nx - 1));
+        v       = std::fmin(std::fmax(v, 0.0f), float(_ny - 1));
+
+        int i = std::min(int(u), _nx - 2);
+        int j = std::min(int(v), _ny - 2);
+        u -= i;
+        v -= j;
+
+        const float* row0 = &_z[j * _nx + i];
+        const float* row1 = row0 + _nx;
+        float        z0   = row0[0] + (row0[1] - row0[0]) * u;
+        float        z1   = row1[0] + (row1[1] - row1[0]) * u;
+        return z0 + (z1 - z0) * v;
+    }
+
+    std::string to_text() const {
+        std::string text;
+        char        buf[80];
+        snprintf(buf, sizeof(buf), "%.3f %.3f %.4f %.4f %d %d\n", _x0, _y0, _dx, _dy, _nx, _ny);
+        text += buf;
+        for (int j = 0; j < _ny; ++j) {
+            for (int i = 0; i < _nx; ++i) {
+                snprintf(buf, sizeof(buf), i ? " %.4f" : "%.4f", z(i, j));
+                text += buf;
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    // Replaces the map with the one in text, leaving it empty and disabled on error
+    bool from_text(const char* text) {
+        clear();
+        char* end;
+        float header[4];
+        for (float& value : header) {
+            value = strtof(text, &end);
+            if (end == text) {
+                return false;
+            }
+            text = end;
+        }
+        long nx = strtol(text, &end, 10);
+        text    = end;
+        long ny = strtol(text, &end, 10);
+        if (end == text || !(header[2] > 0.0f) || !(header[3] > 0.0f) ||
+            !resize(header[0], header[1], header[0] + header[2] * (nx - 1), header[1] + header[3] * (ny - 1), int(nx), int(ny))) {
+            clear();
+            return false;
+        }
+        text = end;
+        for (float& z : _z) {
+            z = strtof(text, &end);
+            if (end == text) {
+                clear();
+                return false;
+            }
+            text = end;
+        }
+        return true;
+    }
+};
+
+extern HeightMap heightMap;
+
+void make_heightmap_commands();
@@ -4,8 +4,14 @@
 #include "InputFile.h"
 
 #include "Report.h"
+#include "CompiledGCode.h"
+#include "JobEstimate.h"  // JobEstimate::remaining()
 
-InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path, "r", defaultFs) {}
+#include <cstring>
+
+InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path, "r", defaultFs) {
+    readAhead();
+}
 /*
   Read a line from the file
   Returns Error::Ok if a line was read, even if the line was empty.
@@ -13,9 +19,97 @@ InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path,
   Returns other Error code on error, after displaying a message.
 */
 Error InputFile::readLine(char* line, int maxlen) {
+    if (_replaying) {
+        auto& cached = _cache[_replay++];
+        if (int(cached.text.length()) >= maxlen) {
+            return Error::LineLengthExceeded;
+        }
+        memcpy(line, cached.text.data(), cached.text.length());
+        line[cached.text.length()] = '\0';
+        ++_line_number;
+        if (cached.text.empty()) {
+            ++_blank_lines;
+        }
+        _position = cached.end;
+        if (_replay == _cache.size()) {
+            // Continue from the file after the cached lines, extending the cache if still recording
+            _replaying = false;
+            FileStream::set_position(_position);
+        }
+        return Error::Ok;
+    }
+    Error err = readFileLine(line, maxlen);
+    if (_recording && err == Error::Ok) {
+        size_t len = line[0] == CompiledGCode::words_record ? CompiledGCode::record_size(line) : strlen(line);
+        if (_cache_bytes + len > max_cache_bytes) {
+            // The body is too big; later passes read the rest from the file
+            _recording = false;
+        } else {
+            _cache.push_back({ FileStream::position(), std::string(line, len) });
+            _cache_bytes += len;
+        }
+    }
+    return err;
+}
+
+size_t InputFile::position() {
+    return _replaying ? _position : FileStream::position();
+}
+
+void InputFile::set_position(size_t pos) {
+    if (pos >= _cache_start && pos < cache_end()) {
+        // Replay from the cached line that begins at pos
+        size_t start = _cache_start;
+        for (size_t i = 0; i < _cache.size(); start = _cache[i++].end) {
+            if (start == pos) {
+                _replaying = true;
+                _replay    = i;
+                _position  = pos;
+                return;
+            }
+        }
+    }
+    if (pos != cache_end()) {
+        // The cache no longer ends where reading resumes
+        _recording = false;
+    }
+    _replaying = false;
+    FileStream::set_position(pos);
+}
+
+void InputFile::cache_lines(size_t pos) {
+    if (!_cache.empty() && pos >= _cache_start && pos <= cache_end()) {
+        // Already cached, as for a loop nested in a loop
+        return;
+    }
+    _cache.clear();
+    _cache_start = pos;
+    _cache_bytes = 0;
+    _recording   = true;
+    _replaying   = false;
+}
+
+Error InputFile::readFileLine(char* line, int maxlen) {
     int len = 0;
-    int c;
-    while ((c = read()) >= 0) {
+    int c   = read();
+    if (c == CompiledGCode::words_record) {
+        // A pre-parsed line from $File/Compile; copy the record as is
+        line[0] = c;
+        if (read(&line[1], 1) != 1) {
+            return Error::FsFailedRead;
+        }
+        size_t size = CompiledGCode::record_size(line);
+        if (int(size) >= maxlen) {
+            return Error::LineLengthExceeded;
+        }
+        if (read(&line[2], size - 2) != size - 2) {
+            return Error::FsFailedRead;
+        }
+        line[size] = '\0';
+        ++_line_number;
+        return Error::Ok;
+    }
+    for (; c >= 0; c = read()) {
         if (len >= maxlen) {
             return Error::LineLengthExceeded;
         }
@@ -54,6 +148,7 @@ void InputFile::end_message() {
     _progress = "SD: ";
     _progress += name();
     _progress += ": Sent";
+    _progressPercent = 100;
 }
 
 Error InputFile::pollLine(char* line) {
@@ -86,7 +181,13 @@ Error InputFile::pollLine(char* line) {
 
             std::ostringstream s;
             s << "SD:" << std::fixed << std::setprecision(2) << percent_complete << "," << path().c_str();
-            _progress = s.str();
+            float minutes;
+            if (JobEstimate::remaining(path(), size(), position(), minutes)) {
+                // Seconds left, from the $File/Check of this file
+                s << "|ETA:" << int(minutes * 60.0f + 0.5f);
+            }
+            _progress        = s.str();
+            _progressPercent = percent_complete;
         }
             return Error::Ok;
         case Error::Eof:
@@ -18,6 +18,8 @@
 #include "Error.h"
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 class InputFile : public FileStream {
 private:
@@ -26,6 +28,25 @@ private:
 
     size_t _blank_lines = 0;
 
+    // Lines of a loop body, kept so that later passes are replayed from RAM
+    // instead of being read from the file again.  See cache_lines().
+    static const size_t max_cache_bytes = 4096;
+
+    struct CachedLine {
+        size_t      end;  // File position after the line
+        std::string text;
+    };
+    std::vector<CachedLine> _cache;              // Consecutive lines from _cache_start
+    size_t                  _cache_start = 0;    // File position of the first cached line
+    size_t                  _cache_bytes = 0;    // Total length of the cached lines
+    bool                    _recording   = false;  // Lines read from the file extend the cache
+    bool                    _replaying   = false;  // Lines come from the cache
+    size_t                  _replay      = 0;      // Index of the next line to replay
+    size_t                  _position    = 0;      // Position while replaying
+
+    size_t cache_end() { return _cache.empty() ? _cache_start : _cache.back().end; }
+    Error  readFileLine(char* line, int len);
+
 public:
     // fsname is the default file system on which the file is located, in case the path does not specify
     // path is the full path to the file
@@ -51,6 +72,9 @@ public:
     size_t write(uint8_t c) override { return 0; }
     void   ack(Error status) override;
     Error  pollLine(char* line) override;
+    size_t position() override;
+    void   set_position(size_t pos) override;
+    void   cache_lines(size_t pos) override;
 
     ~InputFile();
 };
@@ -0,0 +1,138 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  InputShaper.h - resonance compensation for the step segment stream
+
+  An input shaper replaces every change of speed with a few smaller changes spread over about
+  one period of the machine's resonance, timed so that the vibrations they excite cancel.
+  Here the shaper is applied to the path speed of the segments that Stepper::prep_buffer()
+  emits: the speed of each new segment is the weighted sum of the unshaped speeds of the
+  recent segments at the impulse delays, and the segment time is rescaled to match.  The
+  steps of every segment are unchanged, so positions stay exact and the Bresenham line
+  tracing and AMASS in pulse_func() are unaffected.
+
+  Units are those of the prep engine: mm/min for speed, minutes for time.
+*/
+
+#include <cmath>
+#include <cstddef>
+
+namespace InputShaper {
+    enum Type : int {
+        None = 0,
+        ZV,   // Zero vibration: two impulses, shortest delay, least robust to frequency error
+        ZVD,  // Zero vibration and derivative: three impulses, robust, twice the delay of ZV
+        MZV,  // Modified ZV: three impulses, nearly as robust as ZVD with 3/4 of its delay
+    };
+
+    const int max_impulses = 3;
+
+    struct Impulses {
+        int   count = 0;
+        float amplitude[max_impulses];
+        float time[max_impulses];  // Delay of each impulse (min)
+    };
+
+    // The impulse sequences as given by Singhose et al., normalized to unit gain.
+    inline Impulses impulses(int type, float freq_hz, float damping_ratio) {
+        Impulses s;
+        if (type == None || freq_hz <= 0.0f) {
+            return s;
+        }
+        float root       = sqrtf(1.0f - damping_ratio * damping_ratio);
+        float damped_min = 1.0f / (freq_hz * root * 60.0f);  // Damped period in minutes
+        float k          = expf(-damping_ratio * float(M_PI) / root);
+        switch (type) {
+            case ZV:
+                s.count        = 2;
+                s.amplitude[0] = 1.0f;
+                s.amplitude[1] = k;
+                s.time[0]      = 0.0f;
+                s.time[1]      = 0.5f * damped_min;
+                break;
+            case ZVD:
+                s.count        = 3;
+                s.amplitude[0] = 1.0f;
+                s.amplitude[1] = 2.0f * k;
+                s.amplitude[2] = k * k;
+                s.time[0]      = 0.0f;
+                s.time[1]      = 0.5f * damped_min;
+                s.time[2]      = damped_min;
+                break;
+            default:  // MZV
+                k              = expf(-0.75f * damping_ratio * float(M_PI) / root);
+                s.count        = 3;
+                s.amplitude[0] = 1.0f - float(M_SQRT1_2);
+                s.amplitude[1] = (float(M_SQRT2) - 1.0f) * k;
+                s.amplitude[2] = s.amplitude[0] * k * k;
+                s.time[0]      = 0.0f;
+                s.time[1]      = 0.375f * damped_min;
+                s.time[2]      = 0.75f * damped_min;
+                break;
+        }
+        float sum = 0.0f;
+        for (int i = 0; i < s.count; ++i) {
+            sum += s.amplitude[i];
+        }
+        for (int i = 0; i < s.count; ++i) {
+            s.amplitude[i] /= sum;
+        }
+        return s;
+    }
+
+    // The unshaped speeds of the most recent segments.  It must cover the longest impulse delay;
+    // at 100 segments per second, 32 segments do so for shaper frequencies down to 5 Hz (ZVD).
+    class SpeedHistory {
+        static const size_t history_size = 32;
+
+        struct Sample {
+            float duration;
+            float speed;
+        };
+        Sample _samples[history_size];
+        size_t _newest = 0;
+        size_t _count  = 0;
+
+    public:
+        // Forget the history, as at the start of a motion from rest.
+        void reset() { _count = 0; }
+
+        // Unshaped speed age minutes before the end of the newest segment. Before the history
+        // starts the machine was at rest.
+        float speed_at(float age) const {
+            size_t index = _newest;
+            for (size_t n = 0; n < _count; ++n) {
+                age -= _samples[index].duration;
+                if (age < 0.0f) {
+                    return _samples[index].speed;
+                }
+                index = index == 0 ? history_size - 1 : index - 1;
+            }
+            return _count == history_size ? _samples[_newest == history_size - 1 ? 0 : _newest + 1].speed : 0.0f;
+        }
+
+        // Records a segment that the unshaped profile covers in dt minutes and returns the
+        // time it takes at the shaped speed.
+        float shape(const Impulses& shaper, float dt, float mm) {
+            if (dt <= 0.0f || mm <= 0.0f) {
+                return dt;
+            }
+            _newest           = _count == 0 ? 0 : (_newest == history_size - 1 ? 0 : _newest + 1);
+            _samples[_newest] = { dt, mm / dt };
+            if (_count < history_size) {
+                ++_count;
+            }
+            if (shaper.count == 0) {
+                return dt;
+            }
+            float speed = 0.0f;
+            for (int i = 0; i < shaper.count; ++i) {
+                speed += shaper.amplitude[i] * speed_at(0.5f * dt + shaper.time[i]);
+            }
+            return mm / speed;
+        }
+    };
+}
@@ -4,6 +4,7 @@
 #include "src/Report.h"
 #include "src/Protocol.h"  // send_line()
 #include "src/UartChannel.h"
+#include "src/HeapStats.h"
 
 // Constructor.  If _encapsulate is true, the output is
 // encapsulated in [MSG:JSON: ...] lines
@@ -16,7 +17,17 @@ JSONencoder::JSONencoder(std::string* str) : level(0), _str(str), category("nvs"
     count[level] = 0;
 }
 
+JSONencoder::JSONencoder(std::function<void(const char*, size_t)> sink, size_t chunk) :
+    level(0), _str(&linebuf), _sink(sink), _chunk(chunk), category("nvs") {
+    count[level] = 0;
+    linebuf.reserve(chunk);
+}
+
 void JSONencoder::flush() {
+    if (_sink && linebuf.length()) {
+        _sink(linebuf.c_str(), linebuf.length());
+        linebuf.clear();
+    }
     if (_channel && (*_str).length()) {
         if (_encapsulate) {
             // Output to channels is encapsulated in [MSG:JSON:...]
@@ -28,9 +39,12 @@ void JSONencoder::flush() {
     }
 }
 void JSONencoder::add(char c) {
+    HeapScope scope(HeapTag::Json);
     (*_str) += c;
     if (_channel && (*_str).length() >= 100) {
         flush();
+    } else if (_sink && linebuf.length() >= _chunk) {
+        flush();
     }
 }
 
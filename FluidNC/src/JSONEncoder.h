@@ -1,6 +1,7 @@
 #pragma once
 
 #include "src/Channel.h"
+#include <functional>
 #include <string>
 
 // Class for creating JSON-encoded strings.
@@ -27,6 +28,9 @@ private:
     std::string* _str     = nullptr;
     Channel*     _channel = nullptr;
 
+    std::function<void(const char*, size_t)> _sink;
+    size_t                                   _chunk = 0;
+
     std::string category;
 
     void flush();
@@ -36,6 +40,11 @@ public:
     JSONencoder(bool encapsulate, Channel* channel);
     explicit JSONencoder(std::string* str);
 
+    // Sends the output to sink in pieces of about chunk bytes, so a large document
+    // such as a directory listing never has to be held in memory.  The last piece
+    // is sent by end().
+    JSONencoder(std::function<void(const char*, size_t)> sink, size_t chunk);
+
     // begin() starts the encoding process.
     void begin();
 
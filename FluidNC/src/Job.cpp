@@ -2,13 +2,26 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Job.h"
+#include "HeapStats.h"
+#include "JobStats.h"
+#include "InputFile.h"
+#include <deque>
 #include <map>
+#include <mutex>
 #include <stack>
 
 std::stack<JobSource*> job;
 
 Channel* Job::leader = nullptr;
 
+struct QueuedFile {
+    std::string fs;
+    std::string path;
+};
+// Added to by commands and taken from by the polling task
+static std::deque<QueuedFile> file_queue;
+static std::mutex             file_queue_mutex;
+
 bool Job::active() {
     return !job.empty();
 }
@@ -35,19 +48,25 @@ void Job::nest(Channel* in_channel, Channel* out_channel) {
     if (out_channel && job.empty()) {
         leader = out_channel;
     }
+    if (job.empty()) {
+        HeapStats::job_start();
+        JobStats::job_start();
+    }
     job.push(source);
 }
-void Job::pop() {
+void Job::pop(bool completed) {
     auto source = job.top();
     job.pop();
     delete source;
     if (!active()) {
+        JobStats::job_end(completed, leader);
         leader = nullptr;
+        HeapStats::job_end();
     }
 }
 void Job::unnest() {
     if (active()) {
-        pop();
+        pop(true);
         restore();
     }
 }
@@ -55,17 +74,70 @@ void Job::unnest() {
 void Job::abort() {
     // Kill all active jobs
     while (active()) {
-        pop();
+        pop(false);
+    }
+    clear_queue();
+}
+
+void Job::enqueue(const char* fs, const std::string& path) {
+    std::lock_guard<std::mutex> lock(file_queue_mutex);
+    file_queue.push_back({ fs, path });
+}
+
+void Job::clear_queue() {
+    std::lock_guard<std::mutex> lock(file_queue_mutex);
+    file_queue.clear();
+}
+
+void Job::show_queue(Channel& out) {
+    std::lock_guard<std::mutex> lock(file_queue_mutex);
+    if (file_queue.empty()) {
+        log_info_to(out, "Job queue is empty");
+    }
+    for (auto const& file : file_queue) {
+        log_info_to(out, "Queued " << file.path);
+    }
+}
+
+// Called at the end of a job file.  Returns false if the job should end.
+bool Job::next_file() {
+    if (job.size() != 1) {
+        // A file nested in the job returns to its caller
+        return false;
+    }
+    QueuedFile next;
+    {
+        std::lock_guard<std::mutex> lock(file_queue_mutex);
+        if (file_queue.empty()) {
+            return false;
+        }
+        next = std::move(file_queue.front());
+        file_queue.pop_front();
+    }
+    // The finished file is closed first because the SD card allows one open file
+    delete job.top();
+    job.top() = nullptr;
+    InputFile* file;
+    try {
+        file = new InputFile(next.fs.c_str(), next.path.c_str());
+    } catch (Error err) {
+        log_error("Cannot open queued file " << next.path << "; clearing the job queue");
+        clear_queue();
+        job.top() = new JobSource(nullptr);
+        return false;
     }
+    job.top() = new JobSource(file);
+    JobStats::set_file(file->path());
+    return true;
 }
 
-bool Job::get_param(const std::string& name, float& value) {
+bool Job::get_param(std::string_view name, float& value) {
     return job.top()->get_param(name, value);
 }
-bool Job::set_param(const std::string& name, float value) {
+bool Job::set_param(std::string_view name, float value) {
     return job.top()->set_param(name, value);
 }
-bool Job::param_exists(const std::string& name) {
+bool Job::param_exists(std::string_view name) {
     return job.top()->param_exists(name);
 }
 Channel* Job::channel() {
@@ -2,42 +2,43 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Channel.h"
+#include "Expression.h"
+#include "ParamTable.h"
+#include <map>
 #include <stack>
+#include <string>
 
 class JobSource {
 private:
     Channel*                     _channel;
-    std::map<std::string, float> _local_params;
+    ParamTable<64>               _local_params;
+
+    std::map<size_t, ExpressionCode> _expressions;  // See cached_expression()
 
 public:
+    static const size_t max_expressions = 64;
+
     JobSource(Channel* channel) : _channel(channel) {}
-    bool get_param(const std::string& name, float& value) {
-        auto it = _local_params.find(name);
-        if (it == _local_params.end()) {
-            return false;
-        }
-        value = it->second;
-        return true;
-    }
-    bool set_param(const std::string& name, float value) {
-        _local_params[name] = value;
-        return true;
-    }
-    bool param_exists(const std::string& name) { return _local_params.count(name) != 0; }
+    bool get_param(std::string_view name, float& value) { return _local_params.get(name, value); }
+    bool set_param(std::string_view name, float value) { return _local_params.set(name, value); }
+    bool param_exists(std::string_view name) { return _local_params.exists(name); }
 
     void   save() { _channel->save(); }
     void   restore() { _channel->restore(); }
     size_t position() { return _channel->position(); }
     void   set_position(size_t pos) { _channel->set_position(pos); }
+    void   cache_lines(size_t pos) { _channel->cache_lines(pos); }
 
     Channel* channel() { return _channel; }
 
+    std::map<size_t, ExpressionCode>& expressions() { return _expressions; }
+
     ~JobSource() { delete _channel; }
 };
 
 class Job {
 private:
-    static void pop();
+    static void pop(bool completed);
 
 public:
     static Channel* leader;
@@ -51,8 +52,16 @@ public:
     static void       abort();
     static JobSource* source();
 
-    static bool     get_param(const std::string& name, float& value);
-    static bool     set_param(const std::string& name, float value);
-    static bool     param_exists(const std::string& name);
+    // Files queued with $Job/Queue run after the outermost job, as part of it.  At
+    // the end of one, the next replaces it on the job stack without the job ending,
+    // so lines flow on from the next file while the planner is still busy.
+    static void enqueue(const char* fs, const std::string& path);
+    static bool next_file();
+    static void clear_queue();
+    static void show_queue(Channel& out);
+
+    static bool     get_param(std::string_view name, float& value);
+    static bool     set_param(std::string_view name, float value);
+    static bool     param_exists(std::string_view name);
     static Channel* channel();
 };
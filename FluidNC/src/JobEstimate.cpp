@@ -0,0 +1,121 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JobEstimate.h"
+
+#include "Planner.h"
+
+#include <algorithm>
+
+namespace JobEstimate {
+    static const size_t n_marks = 101;  // At each percent of the file, from 0 to 100
+
+    static bool        _active = false;
+    static bool        _valid  = false;  // The marks hold a finished estimate of _path
+    static std::string _path;
+    static size_t      _size;
+
+    static float    _minutes;   // Time of the blocks timed so far
+    static uint32_t _timed;     // Number of blocks timed so far
+    static size_t   _n_marked;  // Marks given a block count
+    static size_t   _n_timed;   // Marks given a time
+
+    // A mark first holds the number of blocks planned when the file reached it, then, once
+    // those blocks have been timed, the elapsed time at the end of the last of them.
+    static uint32_t _mark_blocks[n_marks];
+    static float    _mark_minutes[n_marks];
+
+    static uint32_t buffered() { return plan_get_block_buffer_size() - 1 - plan_get_block_buffer_available(); }
+
+    // Times the oldest block in the planner, as the stepper would run it, and discards it
+    static void time_block() {
+        plan_block_t* block = plan_get_current_block();
+        if (block->dwell_us) {
+            _minutes += block->dwell_us / 60e6f;
+        } else {
+            plan_speed_t* speed   = plan_get_block_speed(block);
+            float         entry   = sqrtf(speed->entry_speed_sqr);
+            float         exit    = sqrtf(plan_get_exec_block_exit_speed_sqr());
+            float         nominal = plan_compute_profile_nominal_speed(block);
+            _minutes += block_minutes(entry, nominal, exit, speed->acceleration, speed->millimeters);
+        }
+        plan_discard_current_block();
+        ++_timed;
+        while (_n_timed < _n_marked && _mark_blocks[_n_timed] <= _timed) {
+            _mark_minutes[_n_timed++] = _minutes;
+        }
+    }
+
+    static void make_room() {
+        if (plan_check_full_buffer()) {
+            time_block();
+        }
+    }
+
+    bool active() { return _active; }
+
+    void begin(const std::string& path, size_t size) {
+        plan_reset();
+        plan_sync_position();
+        _path     = path;
+        _size     = size ? size : 1;
+        _minutes  = 0.0f;
+        _timed    = 0;
+        _n_marked = 0;
+        _n_timed  = 0;
+        _valid    = false;
+        _active   = true;
+        mark(0);
+    }
+
+    void line(float* target, plan_line_data_t* pl_data) {
+        make_room();
+        plan_buffer_line(target, pl_data);
+    }
+
+    void dwell(uint32_t microseconds, plan_line_data_t* pl_data) {
+        make_room();
+        plan_buffer_dwell(microseconds, pl_data);
+    }
+
+    void mark(size_t position) {
+        size_t percent = std::min(position * (n_marks - 1) / _size, n_marks - 1);
+        while (_n_marked <= percent) {
+            _mark_blocks[_n_marked++] = _timed + buffered();
+        }
+    }
+
+    float end() {
+        mark(_size);
+        while (plan_get_current_block()) {
+            time_block();
+        }
+        while (_n_timed < n_marks) {
+            _mark_minutes[_n_timed++] = _minutes;
+        }
+        plan_reset();
+        plan_sync_position();
+        _active = false;
+        _valid  = true;
+        return _minutes;
+    }
+
+    void abort() {
+        plan_reset();
+        plan_sync_position();
+        _active = false;
+        _valid  = false;
+    }
+
+    bool remaining(const std::string& path, size_t size, size_t position, float& minutes) {
+        if (!_valid || path != _path || size != _size || position > _size) {
+            return false;
+        }
+        // Interpolate between the marks on either side of position
+        float  at   = float(position) * (n_marks - 1) / _size;
+        size_t i    = std::min(size_t(at), n_marks - 2);
+        float  frac = at - i;
+        minutes     = _minutes - (_mark_minutes[i] + frac * (_mark_minutes[i + 1] - _mark_minutes[i]));
+        return true;
+    }
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  JobEstimate.h - run time of a G-code file from the planner's own profile
+
+  $File/Check runs a file through the parser in check mode.  While it does,
+  the moves that check mode would drop go to the real planner instead, with
+  the machine's acceleration, max rates and junction deviation, and each block
+  is timed as it would execute: a trapezoid from its entry speed through its
+  nominal speed to the next block's entry speed.  Blocks are timed and
+  discarded when the buffer fills, so the look-ahead is the same as in a real
+  run.  S-curve ramps keep the duration of the trapezoid, so the time is the
+  same with or without jerk limiting.  No steps are generated.
+
+  The elapsed time at each percent of the file is kept, so while that file
+  runs as a job its progress report can give the time remaining.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct plan_line_data_t;
+
+// Time in minutes to travel mm from entry to exit speed, cruising at nominal if there
+// is room, with speeds in mm/min and accel in mm/min^2
+inline float block_minutes(float entry, float nominal, float exit, float accel, float mm) {
+    if (mm <= 0.0f) {
+        return 0.0f;
+    }
+    float d_entry = fabsf(nominal * nominal - entry * entry) / (2.0f * accel);
+    float d_exit  = fabsf(nominal * nominal - exit * exit) / (2.0f * accel);
+    if (d_entry + d_exit <= mm) {
+        return (fabsf(nominal - entry) + fabsf(nominal - exit)) / accel + (mm - d_entry - d_exit) / nominal;
+    }
+    if (nominal < entry || nominal < exit) {
+        // A single ramp, as when an override lowered the nominal speed below the entry speed
+        return 2.0f * mm / (entry + exit);
+    }
+    // No cruise; accelerate to where the ramps meet
+    float peak = sqrtf(accel * mm + 0.5f * (entry * entry + exit * exit));
+    return (2.0f * peak - entry - exit) / accel;
+}
+
+namespace JobEstimate {
+    // True while a file is being estimated
+    bool active();
+
+    // Starts an estimate of path, of size bytes.  The planner must be empty.
+    void begin(const std::string& path, size_t size);
+
+    // Called by mc_move_motors() and mc_dwell() in check mode, in place of planning for motion
+    void line(float* target, plan_line_data_t* pl_data);
+    void dwell(uint32_t microseconds, plan_line_data_t* pl_data);
+
+    // Called after each line, with the file position after it
+    void mark(size_t position);
+
+    // Times the blocks left in the planner, empties it, and returns the total in minutes
+    float end();
+
+    // Discards the estimate in progress
+    void abort();
+
+    // The estimated minutes left in a job running path, of size bytes, at position in
+    // the file, if there is an estimate for it
+    bool remaining(const std::string& path, size_t size, size_t position, float& minutes);
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JobStats.h"
+
+#include "Settings.h"
+#include "SettingsDefinitions.h"  // job_report
+#include "JSONEncoder.h"
+#include "FileStream.h"
+#include "Planner.h"  // plan_get_current_block(), plan_get_block_buffer_low_water()
+#include "Stepper.h"  // Stepper::get_realtime_rate(), Stepper::segment_underruns()
+#include "System.h"   // state_is()
+#include "Serial.h"   // allChannels
+#include "Metrics.h"
+
+#include <esp_timer.h>
+
+namespace JobStats {
+    // A read that takes longer than this holds up the planner at high line rates
+    static const int64_t stallUsecs = 20000;
+
+    // Sampling more often than this adds cost without changing the averages
+    static const int64_t sampleUsecs = 20000;
+
+    static bool        _active = false;
+    static std::string _file;
+
+    static int64_t  _startTime;
+    static int64_t  _lastSample;
+    static int64_t  _movingUsecs;
+    static int64_t  _holdUsecs;
+    static uint32_t _lines;
+    static uint32_t _stalls;
+    static int64_t  _longestRead;
+    static uint32_t _startUnderruns;
+    static bool     _starved;  // The planner was empty at the last sample
+
+    // Speeds times microseconds while moving, for time-weighted averages
+    static double _speedSum;
+    static double _programmedSum;
+    static float  _peakSpeed;
+
+    void job_start() {
+        _file.clear();
+        _active         = true;
+        _startTime      = esp_timer_get_time();
+        _lastSample     = _startTime;
+        _movingUsecs    = 0;
+        _holdUsecs      = 0;
+        _lines          = 0;
+        _stalls         = 0;
+        _longestRead    = 0;
+        _startUnderruns = Stepper::segment_underruns();
+        _starved        = false;
+        _speedSum       = 0;
+        _programmedSum  = 0;
+        _peakSpeed      = 0;
+        plan_reset_block_buffer_low_water();
+    }
+
+    void set_file(const std::string& path) {
+        if (_active && _file.empty()) {
+            _file = path;
+        }
+    }
+
+    void read_done(bool gotLine, int64_t usecs) {
+        if (gotLine) {
+            ++_lines;
+        }
+        if (usecs > stallUsecs) {
+            ++_stalls;
+        }
+        if (usecs > _longestRead) {
+            _longestRead = usecs;
+        }
+    }
+
+    void sample() {
+        int64_t now = esp_timer_get_time();
+        int64_t dt  = now - _lastSample;
+        if (dt < sampleUsecs) {
+            return;
+        }
+        _lastSample = now;
+
+        if (state_is(State::Cycle)) {
+            _movingUsecs += dt;
+            float speed = Stepper::get_realtime_rate();
+            _speedSum += double(speed) * dt;
+            if (speed > _peakSpeed) {
+                _peakSpeed = speed;
+            }
+            // Read without a lock; a block discarded meanwhile still holds its old rate
+            auto block = plan_get_current_block();
+            if (block) {
+                _programmedSum += double(block->programmed_rate) * dt;
+                _starved = false;
+            } else if (!_starved) {
+                _starved = true;
+                Metrics::planner_underrun();
+            }
+        } else if (state_is(State::Hold) || state_is(State::SafetyDoor)) {
+            _holdUsecs += dt;
+        }
+    }
+
+    static void encode(JSONencoder& j, bool completed) {
+        int64_t wall = esp_timer_get_time() - _startTime;
+
+        j.begin();
+        j.begin_member_object("job");
+        j.member("completed", completed ? "yes" : "no");
+        j.member("wall_ms", int(wall / 1000));
+        j.member("moving_ms", int(_movingUsecs / 1000));
+        j.member("hold_ms", int(_holdUsecs / 1000));
+        j.member("lines", int(_lines));
+        j.member("lines_per_sec", wall ? int(_lines * 1000000LL / wall) : 0);
+        j.member("planner_free_min", int(plan_get_block_buffer_low_water()));
+        j.member("segment_underruns", int(Stepper::segment_underruns() - _startUnderruns));
+        j.member("avg_speed", _movingUsecs ? int(_speedSum / _movingUsecs) : 0);
+        j.member("peak_speed", int(_peakSpeed));
+        j.member("avg_programmed_speed", _movingUsecs ? int(_programmedSum / _movingUsecs) : 0);
+        j.member("read_stalls", int(_stalls));
+        j.member("longest_read_ms", int(_longestRead / 1000));
+        if (!_file.empty()) {
+            j.member("file", _file);
+        }
+        j.end_object();
+        j.end();
+    }
+
+    void job_end(bool completed, Channel* leader) {
+        if (!_active) {
+            return;
+        }
+        _active = false;
+        Metrics::job_done(uint32_t((esp_timer_get_time() - _startTime) / 1000));
+        if (!job_report->get()) {
+            return;
+        }
+
+        JSONencoder j(true, leader ? leader : &allChannels);
+        encode(j, completed);
+
+        if (job_report->get() == 2 && !_file.empty()) {
+            std::string s;
+            JSONencoder f(&s);
+            encode(f, completed);
+            try {
+                FileStream out(_file + ".json", "w");
+                out.write(reinterpret_cast<const uint8_t*>(s.c_str()), s.length());
+            } catch (Error err) {
+                log_warn("Cannot write the job report " << _file << ".json");
+            }
+        }
+    }
+}
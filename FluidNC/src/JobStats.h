@@ -0,0 +1,38 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  JobStats.h - a performance report for each job
+
+  While a job runs, the polling task times the reads of its lines and samples
+  the machine state and speed.  When the outermost job ends, a JSON summary
+  goes to the channel that started it: the wall time, the time spent moving
+  and in holds, the lines read per second, the fewest free planner blocks,
+  segment buffer underruns, the average and peak speed against the programmed
+  speed, and the file reads slow enough to stall the stream.  With
+  $Job/Report=File, the summary is also written next to the job file, with
+  .json appended to its name.  It shows whether a job was limited by the
+  controller rather than by the machine.
+*/
+
+#include "Channel.h"
+
+#include <cstdint>
+#include <string>
+
+namespace JobStats {
+    // Called by Job when the outermost job starts and ends
+    void job_start();
+    void job_end(bool completed, Channel* leader);
+
+    // The file that the job runs, if it is one, for $Job/Report=File
+    void set_file(const std::string& path);
+
+    // Called by the polling task after each read from the job channel
+    void read_done(bool gotLine, int64_t usecs);
+
+    // Called by the polling task while a job is active
+    void sample();
+}
@@ -8,6 +8,14 @@
 #include "MotionControl.h"  // mc_linear
 #include "Stepper.h"        // st_prep_buffer, st_wake_up
 #include "Limits.h"         // constrainToSoftLimits()
+#include "Protocol.h"       // motionCancelEvent
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>  // xTaskGetTickCount
+#include <cctype>
+#include <cmath>
+#include <cstdlib>  // strtof
+#include <cstring>  // memcmp
 
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 // cancelledInflight will be set to true if was not added to parser due to a cancelJog.
@@ -28,3 +36,183 @@ Error jog_execute(plan_line_data_t* pl_data, parser_block_t* gc_block, bool* can
     // The motion will be initiated by the cycle start mechanism
     return Error::Ok;
 }
+
+// A velocity jog is a run of short relative $J= moves.  JOG_QUEUED_BLOCKS of them are
+// kept in the planner, each long enough that the ones after the executing block cover
+// the stopping distance, so the planner never has to slow down for the end of the run.
+// A stop is a jog cancel, which decelerates at once regardless of what is queued.
+static const uint32_t JOG_KEEPALIVE_MS  = 250;
+static const uint32_t JOG_BLOCK_MS      = 50;
+static const size_t   JOG_QUEUED_BLOCKS = 4;
+
+static bool       jv_active = false;
+static bool       jv_moving = false;  // Blocks from the current vector have been queued
+static float      jv_block[MAX_N_AXIS];
+static float      jv_feed;
+static float      jv_reach;  // Blocks left before the soft limits
+static TickType_t jv_deadline;
+
+// How many blocks fit along the vector from the current position before the soft limits or
+// the workspace.  The kinematics clip one jog to the far end of the travel, once for the
+// whole run.  The clip may shorten each axis separately, so the reach is the smallest
+// of the per-axis fractions.  The blocks are then queued without ever being cut short,
+// and the last one ends at the limit.  With nothing clipped, the run is unlimited.
+static float jog_velocity_reach() {
+    auto  n_axis = Axes::_numberAxis;
+    float span   = 0;
+    float length = 0;
+    for (int axis = 0; axis < n_axis; axis++) {
+        span += fabsf(limitsMaxPosition(axis) - limitsMinPosition(axis));
+        length += jv_block[axis] * jv_block[axis];
+    }
+    float scale = (span + 1.0f) / sqrtf(length);  // Blocks to reach past any limit
+
+    float            target[MAX_N_AXIS];
+    plan_line_data_t pl_data = {};
+    copyAxes(target, gc_state.position);
+    for (int axis = 0; axis < n_axis; axis++) {
+        target[axis] += jv_block[axis] * scale;
+    }
+    config->_kinematics->constrain_jog(target, &pl_data, gc_state.position);
+
+    float reach = scale;
+    for (int axis = 0; axis < n_axis; axis++) {
+        if (jv_block[axis] != 0) {
+            reach = std::min(reach, (target[axis] - gc_state.position[axis]) / jv_block[axis]);
+        }
+    }
+    return reach >= scale ? HUGE_VALF : std::max(reach, 0.0f);
+}
+
+static void jog_velocity_stop() {
+    if (jv_moving && state_is(State::Jog)) {
+        protocol_send_event(&motionCancelEvent);
+    }
+    jv_active = false;
+    jv_moving = false;
+}
+
+bool jog_velocity_active() {
+    return jv_active;
+}
+
+Error jog_velocity(const char* value) {
+    if (!value) {
+        return Error::InvalidStatement;
+    }
+    auto  n_axis             = Axes::_numberAxis;
+    float vector[MAX_N_AXIS] = { 0 };
+    float feed               = 0;
+
+    const char* p = value;
+    while (*p) {
+        if (isspace(*p)) {
+            ++p;
+            continue;
+        }
+        char  letter = toupper(*p++);
+        char* end;
+        float number = strtof(p, &end);
+        if (end == p) {
+            return Error::BadNumberFormat;
+        }
+        p = end;
+        if (letter == 'F') {
+            feed = number;
+            continue;
+        }
+        const char* axis = strchr(Axes::_names, letter);
+        if (!axis || (axis - Axes::_names) >= n_axis) {
+            return Error::InvalidStatement;
+        }
+        vector[axis - Axes::_names] = number;
+    }
+
+    float length = 0;
+    for (int axis = 0; axis < n_axis; axis++) {
+        length += vector[axis] * vector[axis];
+    }
+    length = sqrtf(length);
+    if (length == 0 || feed <= 0) {
+        jog_velocity_stop();
+        return Error::Ok;
+    }
+
+    // Make the block long enough that JOG_QUEUED_BLOCKS - 1 of them cover the
+    // stopping distance at the lowest acceleration along the vector.
+    float accel = INFINITY;
+    for (int axis = 0; axis < n_axis; axis++) {
+        if (vector[axis] != 0) {
+            accel = std::min(accel, Axes::_axis[axis]->_acceleration * length / fabsf(vector[axis]));
+        }
+    }
+    float speed             = feed / 60.0f;  // mm/sec
+    float stopping          = speed * speed / (2 * accel);
+    float blockLen          = std::max(speed * JOG_BLOCK_MS / 1000.0f, stopping / (JOG_QUEUED_BLOCKS - 1));
+    float block[MAX_N_AXIS] = { 0 };
+    for (int axis = 0; axis < n_axis; axis++) {
+        block[axis] = vector[axis] / length * blockLen;
+    }
+
+    if (jv_active && (feed != jv_feed || memcmp(block, jv_block, sizeof(block)))) {
+        // A new vector starts over from a stop
+        jog_velocity_stop();
+    }
+    if (!jv_active) {
+        memcpy(jv_block, block, sizeof(block));
+        jv_feed   = feed;
+        jv_active = true;
+    }
+    jv_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(JOG_KEEPALIVE_MS);
+    return Error::Ok;
+}
+
+void jog_velocity_poll() {
+    if (!jv_active) {
+        return;
+    }
+    if (int32_t(xTaskGetTickCount() - jv_deadline) > 0) {
+        jog_velocity_stop();
+        return;
+    }
+    if (jv_moving && !state_is(State::Jog)) {
+        // Cancelled or stopped by something else, like a limit or an alarm
+        jv_active = false;
+        jv_moving = false;
+        return;
+    }
+    if (!jv_moving && !state_is(State::Idle)) {
+        // Wait for the previous motion to stop
+        return;
+    }
+
+    auto n_axis = Axes::_numberAxis;
+    if (!jv_moving) {
+        jv_reach = jog_velocity_reach();
+    }
+    while (plan_get_block_buffer_size() - plan_get_block_buffer_available() < JOG_QUEUED_BLOCKS) {
+        if (jv_reach < 0.001f) {
+            // At the soft limits; the moves already queued run out
+            jv_active = false;
+            break;
+        }
+        float fraction = std::min(jv_reach, 1.0f);
+        jv_reach -= fraction;
+
+        char  line[LINE_BUFFER_SIZE];
+        char* p = line;
+        p += sprintf(p, "$J=G91G21");
+        for (int axis = 0; axis < n_axis; axis++) {
+            if (jv_block[axis] != 0) {
+                p += sprintf(p, "%c%.4f", Axes::_names[axis], jv_block[axis] * fraction);
+            }
+        }
+        sprintf(p, "F%.1f", jv_feed);
+        if (gc_execute_line(line) != Error::Ok) {
+            // The moves already queued run out
+            jv_active = false;
+            break;
+        }
+        jv_moving = true;
+    }
+}
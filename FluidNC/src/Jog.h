@@ -14,3 +14,14 @@ const int JOG_LINE_NUMBER = 0;
 // Sets up valid jog motion received from g-code parser, checks for soft-limits, and executes the jog.
 // cancelledInflight will be set to true if was not added to parser due to a cancelJog.
 Error jog_execute(plan_line_data_t* pl_data, parser_block_t* gc_block, bool* cancelledInflight);
+
+// Velocity jogging, for pendants that stream jog commands while a key is held.
+// $Jog/Velocity=X<v> Y<v> ... F<mm/min> moves along the vector (X,Y,...) at the
+// feed rate until the command stops being repeated for JOG_KEEPALIVE_MS, or it
+// is sent with a zero vector or feed, or the jog is cancelled.  A change of the
+// vector or feed cancels the motion in progress and starts the new one.
+Error jog_velocity(const char* value);
+
+// Keeps a short run of jog blocks queued ahead of a velocity jog.  Called from the main loop.
+void jog_velocity_poll();
+bool jog_velocity_active();
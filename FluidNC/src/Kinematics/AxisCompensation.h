@@ -0,0 +1,89 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  AxisCompensation.h - lead screw error tables and axis skew
+
+  A PitchTable holds the measured error of an axis at evenly spaced positions, so that
+  the motor is sent to position + error(position).  The errors are stored in nanometres
+  and the position is converted once to a 16.16 fixed point table index, so a lookup is
+  integer interpolation between two entries.  Outside the table the end values hold.
+
+  Skew corrects for axes that are not square to each other: X leans by xy mm per mm of
+  Y and by xz mm per mm of Z, and Y leans by yz mm per mm of Z.
+
+  The math has no dependencies so that it can be checked on the host.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Kinematics {
+    class PitchTable {
+        std::vector<int32_t> _errors;  // Nanometres
+        float                _start       = 0.0f;
+        float                _inv_spacing = 0.0f;
+        int32_t              _last        = 0;  // Index of the last entry, in 16.16
+
+    public:
+        bool empty() const { return _errors.empty(); }
+
+        // errors in mm at start, start + spacing, ...; a single entry is a constant offset
+        bool set(float start, float spacing, const std::vector<float>& errors) {
+            _errors.clear();
+            if (errors.empty() || !(spacing > 0.0f) || errors.size() > 32767) {
+                return false;
+            }
+            _start       = start;
+            _inv_spacing = 1.0f / spacing;
+            _last        = int32_t(errors.size() - 1) << 16;
+            for (float e : errors) {
+                _errors.push_back(int32_t(lroundf(e * 1e6f)));
+            }
+            return true;
+        }
+
+        float error(float position) const {
+            if (_errors.empty()) {
+                return 0.0f;
+            }
+            float   t = (position - _start) * _inv_spacing;
+            int32_t q = t <= 0.0f ? 0 : t >= float(_last >> 16) ? _last : int32_t(t * 65536.0f);
+            if (q >= _last) {
+                return _errors.back() * 1e-6f;
+            }
+            int32_t i    = q >> 16;
+            int32_t frac = q & 0xffff;
+            int32_t a    = _errors[i];
+            int32_t nm   = a + int32_t((int64_t(_errors[i + 1] - a) * frac) >> 16);
+            return nm * 1e-6f;
+        }
+
+        // The position that error() sends to motor.  The error changes slowly with
+        // position, so a couple of fixed point iterations converge.
+        float invert(float motor) const {
+            float position = motor - error(motor);
+            return motor - error(position);
+        }
+    };
+
+    struct Skew {
+        float xy = 0.0f;
+        float xz = 0.0f;
+        float yz = 0.0f;
+
+        bool empty() const { return xy == 0.0f && xz == 0.0f && yz == 0.0f; }
+
+        void apply(float* p) const {
+            p[0] += xy * p[1] + xz * p[2];
+            p[1] += yz * p[2];
+        }
+        void remove(float* p) const {
+            p[1] -= yz * p[2];
+            p[0] -= xy * p[1] + xz * p[2];
+        }
+    };
+}
@@ -3,10 +3,87 @@
 #include "src/Machine/MachineConfig.h"
 #include "src/Machine/Axes.h"  // ambiguousLimit()
 #include "src/Limits.h"
+#include "src/HeightMap.h"
+
+#include <cmath>
 
 namespace Kinematics {
+    // Homing sets the motor positions from the machine position of the switches, which
+    // are not on the probed surface
+    static bool leveling() {
+        return heightMap.active() && !state_is(State::Homing);
+    }
+
+    void Cartesian::group(Configuration::HandlerBase& handler) {
+        static const char* pitchNames[MAX_N_AXIS] = { "pitch_x", "pitch_y", "pitch_z", "pitch_a", "pitch_b",
+                                                      "pitch_c", "pitch_u", "pitch_v", "pitch_w" };
+
+        handler.item("skew_xy", _skew.xy, -0.1, 0.1);
+        handler.item("skew_xz", _skew.xz, -0.1, 0.1);
+        handler.item("skew_yz", _skew.yz, -0.1, 0.1);
+        for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+            handler.section(pitchNames[axis], _pitch[axis]);
+        }
+        handler.section("workspace", _workspace);
+    }
+
+    void Cartesian::afterParse() {
+        _compensated = !_skew.empty();
+        for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+            if (_pitch[axis] && !_pitch[axis]->_table.empty()) {
+                _compensated = true;
+            }
+        }
+    }
+
+    // cartesian -> height map -> skew -> lead screw errors -> motors
+    void Cartesian::to_motors(const float* cartesian, float* motors) {
+        auto n_axis = Axes::_numberAxis;
+        for (size_t axis = 0; axis < n_axis; axis++) {
+            motors[axis] = cartesian[axis];
+        }
+        if (leveling()) {
+            motors[Z_AXIS] += heightMap.offset(cartesian[X_AXIS], cartesian[Y_AXIS]);
+        }
+        if (_compensated) {
+            _skew.apply(motors);
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                if (_pitch[axis]) {
+                    motors[axis] += _pitch[axis]->_table.error(motors[axis]);
+                }
+            }
+        }
+    }
+
+    void Cartesian::to_cartesian(const float* motors, float* cartesian) {
+        auto n_axis = Axes::_numberAxis;
+        for (size_t axis = 0; axis < n_axis; axis++) {
+            cartesian[axis] = motors[axis];
+        }
+        if (_compensated) {
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                if (_pitch[axis]) {
+                    cartesian[axis] = _pitch[axis]->_table.invert(cartesian[axis]);
+                }
+            }
+            _skew.remove(cartesian);
+        }
+        if (leveling()) {
+            cartesian[Z_AXIS] -= heightMap.offset(cartesian[X_AXIS], cartesian[Y_AXIS]);
+        }
+    }
+
     void Cartesian::init() {
         log_info("Kinematic system: " << name());
+        if (_workspace) {
+            float lo[3], hi[3];
+            for (size_t axis = X_AXIS; axis <= Z_AXIS; axis++) {
+                bool limited = axis < Axes::_numberAxis && Axes::_axis[axis]->_softLimits;
+                lo[axis]     = limited ? limitsMinPosition(axis) : -HUGE_VALF;
+                hi[axis]     = limited ? limitsMaxPosition(axis) : HUGE_VALF;
+            }
+            _workspace->_volume.set_box(lo, hi);
+        }
         init_position();
     }
 
@@ -24,6 +101,23 @@ namespace Kinematics {
     // circle plane axis, caxes[1] is the second circle plane axis, and caxes[2] is the
     // orthogonal plane.  So for G17 mode, caxes[] is { 0, 1, 2} for { X, Y, Z}.  G18 is {2, 0, 1} i.e. {Z, X, Y}, and G19 is {1, 2, 0} i.e. {Y, Z, X}
     bool Cartesian::invalid_arc(
+        float* target, plan_line_data_t* pl_data, float* position, float center[3], float radius, size_t caxes[3], bool is_clockwise_arc) {
+        if (invalid_arc_box(target, pl_data, position, center, radius, caxes, is_clockwise_arc)) {
+            return true;
+        }
+        if (_workspace) {
+            float lo = std::min(position[caxes[2]], target[caxes[2]]);
+            float hi = std::max(position[caxes[2]], target[caxes[2]]);
+            if (!_workspace->_volume.contains_arc(center, radius, lo, hi, caxes)) {
+                // The arc might leave the workspace, so each segment is checked instead
+                pl_data->limits_checked = false;
+            }
+        }
+        return false;
+    }
+
+    // The axis soft limits part of invalid_arc()
+    bool Cartesian::invalid_arc_box(
         float* target, plan_line_data_t* pl_data, float* position, float center[3], float radius, size_t caxes[3], bool is_clockwise_arc) {
         pl_data->limits_checked = true;
 
@@ -180,8 +274,7 @@ namespace Kinematics {
         auto axes   = config->_axes;
         auto n_axis = Axes::_numberAxis;
 
-        float*    current_position = get_mpos();
-        MotorMask lim_pin_state    = limits_get_state();
+        float* current_position = get_mpos();
 
         for (int axis = 0; axis < n_axis; axis++) {
             auto axisSetting = axes->_axis[axis];
@@ -191,7 +284,9 @@ namespace Kinematics {
                 bool move_positive = target[axis] > current_position[axis];
                 if ((!move_positive && (current_position[axis] < limitsMinPosition(axis))) ||
                     (move_positive && (current_position[axis] > limitsMaxPosition(axis)))) {
-                    // only allow a nudge if a switch is active
+                    // only allow a nudge if a switch is active.  The switches are read only
+                    // here, so a jog within the range does not read them.
+                    MotorMask lim_pin_state = limits_get_state();
                     if (bitnum_is_false(lim_pin_state, Machine::Axes::motor_bit(axis, 0)) &&
                         bitnum_is_false(lim_pin_state, Machine::Axes::motor_bit(axis, 1))) {
                         target[axis] = current_position[axis];  // cancel the move on this axis
@@ -232,6 +327,15 @@ namespace Kinematics {
                 log_debug("Jog constrained to axis range");
             }
         }
+        if (_workspace) {
+            float fraction = _workspace->_volume.clip(position, target);
+            if (fraction < 1.0f) {
+                for (size_t axis = X_AXIS; axis <= Z_AXIS; axis++) {
+                    target[axis] = position[axis] + (target[axis] - position[axis]) * fraction;
+                }
+                log_debug("Jog constrained to workspace");
+            }
+        }
         pl_data->limits_checked = true;
     }
 
@@ -246,22 +350,91 @@ namespace Kinematics {
                 return true;
             }
         }
+        if (_workspace && !_workspace->_volume.contains(cartesian)) {
+            limit_error();
+            return true;
+        }
         return false;
     }
 
+    // With a height map, Z follows the probed surface.  The offset is bilinear within
+    // a map cell, so moves are split into pieces a quarter of a cell long.  Skew is
+    // linear and the lead screw errors change slowly, so they need no splitting.
     bool Cartesian::cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) {
-        // Motor space is cartesian space, so we do no transform.
-        return mc_move_motors(target, pl_data);
+        if (!leveling()) {
+            if (!_compensated) {
+                // Motor space is cartesian space, so we do no transform.
+                return mc_move_motors(target, pl_data);
+            }
+            float motors[MAX_N_AXIS];
+            to_motors(target, motors);
+            return mc_move_motors(motors, pl_data);
+        }
+
+        auto n_axis = Axes::_numberAxis;
+
+        float delta[MAX_N_AXIS];
+        for (size_t axis = 0; axis < n_axis; axis++) {
+            delta[axis] = target[axis] - position[axis];
+        }
+        float    travel        = sqrtf(delta[X_AXIS] * delta[X_AXIS] + delta[Y_AXIS] * delta[Y_AXIS]);
+        float    count         = ceilf(travel * 4.0f / heightMap.spacing());
+        uint32_t segment_count = count < 1.0f ? 1 : uint32_t(count);
+
+        // An inverse time feed applies to the whole move, so each piece gets its share
+        plan_line_data_t segment_data = *pl_data;
+        pl_data->outputs_mask         = 0;  // The first segment carries the M62/M63 outputs
+        pl_data->output_changes.count = 0;  // and the segments carry the Q changes along
+        if (pl_data->motion.inverseTime) {
+            segment_data.feed_rate = pl_data->feed_rate * segment_count;
+        }
+
+        float cartesian[MAX_N_AXIS];
+        float motors[MAX_N_AXIS];
+        for (uint32_t segment = 1; segment <= segment_count; segment++) {
+            if (sys.abort) {
+                return true;
+            }
+            float fraction = float(segment) / segment_count;
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                cartesian[axis] = segment == segment_count ? target[axis] : position[axis] + delta[axis] * fraction;
+            }
+            to_motors(cartesian, motors);
+
+            // mc_move_motors() returns false if a jog is cancelled.
+            // In that case we stop sending segments to the planner.
+            if (!mc_move_motors(motors, &segment_data)) {
+                return false;
+            }
+        }
+        pl_data->output_changes = segment_data.output_changes;  // Those past the end
+        return true;
     }
 
     void Cartesian::motors_to_cartesian(float* cartesian, float* motors, int n_axis) {
-        // Motor space is cartesian space, so we do no transform.
-        copyAxes(cartesian, motors);
+        to_cartesian(motors, cartesian);
+    }
+
+    // Leveling splits lines to follow the height map
+    bool Cartesian::single_block_lines() {
+        return !leveling();
+    }
+
+    // Skew and pitch compensation move the motors off the circle
+    bool Cartesian::native_arcs() {
+        return !leveling() && !_compensated;
     }
 
     bool Cartesian::transform_cartesian_to_motors(float* motors, float* cartesian) {
-        // Motor space is cartesian space, so we do no transform.
-        copyAxes(motors, cartesian);
+        to_motors(cartesian, motors);
+        return true;
+    }
+
+    bool Cartesian::transform_n(const float* cartesian, float* motors, size_t n) {
+        if (_compensated || leveling()) {
+            return KinematicSystem::transform_n(cartesian, motors, n);
+        }
+        memcpy(motors, cartesian, n * MAX_N_AXIS * sizeof(float));
         return true;
     }
 
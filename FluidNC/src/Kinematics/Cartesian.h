@@ -7,11 +7,56 @@
 	Cartesian.h
 
 	This is a kinematic system for where the motors operate in the cartesian space.
+	The motor positions can be corrected for lead screw errors, axis skew and
+	the height map, and the soft limits can be narrowed to a convex workspace.
 */
 
 #include "Kinematics.h"
+#include "AxisCompensation.h"
+#include "Workspace.h"
 
 namespace Kinematics {
+    // The pitch_<axis> section of the Cartesian kinematics
+    class PitchCompensation : public Configuration::Configurable {
+    public:
+        float              _start   = 0.0f;
+        float              _spacing = 10.0f;
+        std::vector<float> _errors;
+        PitchTable         _table;
+
+        void group(Configuration::HandlerBase& handler) override {
+            handler.item("start_mm", _start);
+            handler.item("spacing_mm", _spacing, 0.1, 1000.0);
+            handler.item("errors_mm", _errors);
+        }
+        void afterParse() override { _table.set(_start, _spacing, _errors); }
+    };
+
+    // The workspace section of the Cartesian kinematics.  The box is the soft limits
+    // of the X, Y and Z axes; the cylinder and the planes cut it down further.
+    class WorkspaceLimits : public Configuration::Configurable {
+    public:
+        float              _radius   = 0.0f;  // 0 for no cylinder
+        float              _center_x = 0.0f;
+        float              _center_y = 0.0f;
+        std::vector<float> _planes;  // nx ny nz d for each plane, keeping n . p <= d
+        Workspace          _volume;
+
+        void group(Configuration::HandlerBase& handler) override {
+            handler.item("cylinder_radius_mm", _radius, 0.0, 10000.0);
+            handler.item("cylinder_x_mm", _center_x);
+            handler.item("cylinder_y_mm", _center_y);
+            handler.item("planes", _planes);
+        }
+        void validate() override { Assert(_planes.size() % 4 == 0, "workspace planes need 4 numbers each"); }
+        void afterParse() override {
+            _volume.set_cylinder(_center_x, _center_y, _radius);
+            for (size_t i = 0; i + 3 < _planes.size(); i += 4) {
+                _volume.add_plane(_planes[i], _planes[i + 1], _planes[i + 2], _planes[i + 3]);
+            }
+        }
+    };
+
     class Cartesian : public KinematicSystem {
     public:
         Cartesian(const char* name) : KinematicSystem(name) {}
@@ -38,6 +83,9 @@ namespace Kinematics {
         virtual void init_position() override;
         void         motors_to_cartesian(float* cartesian, float* motors, int n_axis) override;
         bool         transform_cartesian_to_motors(float* cartesian, float* motors) override;
+        bool         transform_n(const float* cartesian, float* motors, size_t n) override;
+        bool         single_block_lines() override;
+        bool         native_arcs() override;
 
         bool         canHome(AxisMask axisMask) override;
         void         releaseMotors(AxisMask axisMask, MotorMask motors) override;
@@ -45,11 +93,26 @@ namespace Kinematics {
         virtual bool kinematics_homing(AxisMask& axisMask) override;
 
         // Configuration handlers:
-        void afterParse() override {}
-        void group(Configuration::HandlerBase& handler) override {}
+        void afterParse() override;
+        void group(Configuration::HandlerBase& handler) override;
         void validate() override {}
 
     protected:
+        Skew               _skew;
+        PitchCompensation* _pitch[MAX_N_AXIS] = { nullptr };
+        bool               _compensated       = false;  // Skew or a pitch table is set
+        WorkspaceLimits*   _workspace         = nullptr;
+
+        bool invalid_arc_box(float*            target,
+                             plan_line_data_t* pl_data,
+                             float*            position,
+                             float             center[3],
+                             float             radius,
+                             size_t            caxes[3],
+                             bool              is_clockwise_arc);
+        void to_motors(const float* cartesian, float* motors);
+        void to_cartesian(const float* motors, float* cartesian);
+
         ~Cartesian() {}
     };
 }  //  namespace Kinematics
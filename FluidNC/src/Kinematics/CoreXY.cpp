@@ -95,23 +95,25 @@ namespace Kinematics {
 
         auto n_axis = Axes::_numberAxis;
 
-        float motors[n_axis];
-        transform_cartesian_to_motors(motors, target);
+        // The target and the start are converted together
+        float points[2][MAX_N_AXIS];
+        float motors[2][MAX_N_AXIS];
+        copyAxes(points[0], target);
+        copyAxes(points[1], position);
+        transform_n(points[0], motors[0], pl_data->motion.rapidMotion ? 1 : 2);
 
         if (!pl_data->motion.rapidMotion) {
             // Calculate vector distance of the motion in cartesian coordinates
             float cartesian_distance = vector_distance(target, position, n_axis);
 
             // Calculate vector distance of the motion in motor coordinates
-            float last_motors[n_axis];
-            transform_cartesian_to_motors(last_motors, position);
-            float motor_distance = vector_distance(motors, last_motors, n_axis);
+            float motor_distance = vector_distance(motors[0], motors[1], n_axis);
 
             // Scale the feed rate by the motor/cartesian ratio
             pl_data->feed_rate *= motor_distance / cartesian_distance;
         }
 
-        return mc_move_motors(motors, pl_data);
+        return mc_move_motors(motors[0], pl_data);
     }
 
     /*
@@ -143,6 +145,17 @@ namespace Kinematics {
         return true;
     }
 
+    bool CoreXY::transform_n(const float* cartesian, float* motors, size_t n) {
+        auto n_axis = Axes::_numberAxis;
+        for (size_t i = 0; i < n; i++, cartesian += MAX_N_AXIS, motors += MAX_N_AXIS) {
+            float x        = _x_scaler * cartesian[X_AXIS];
+            motors[X_AXIS] = x + cartesian[Y_AXIS];
+            motors[Y_AXIS] = x - cartesian[Y_AXIS];
+            memcpy(motors + Z_AXIS, cartesian + Z_AXIS, (n_axis - Z_AXIS) * sizeof(float));
+        }
+        return true;
+    }
+
     // Configuration registration
     namespace {
         KinematicsFactory::InstanceBuilder<CoreXY> registration("CoreXY");
@@ -30,6 +30,8 @@ namespace Kinematics {
         virtual void init() override;
         bool         cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) override;
         void         motors_to_cartesian(float* cartesian, float* motors, int n_axis) override;
+        bool         single_block_lines() override { return true; }
+        bool         native_arcs() override { return false; }
 
         bool canHome(AxisMask axisMask) override;
         void releaseMotors(AxisMask axisMask, MotorMask motors) override;
@@ -41,6 +43,7 @@ namespace Kinematics {
         void         afterParse() override {}
 
         bool transform_cartesian_to_motors(float* motors, float* cartesian) override;
+        bool transform_n(const float* cartesian, float* motors, size_t n) override;
 
         ~CoreXY() {}
 
@@ -0,0 +1,254 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  DeltaMath.h - inverse and forward kinematics of a rotary parallel delta
+
+  The ESP32 FPU handles single precision only, so everything here is float: the
+  constants are float literals and the math calls are the f-suffixed versions.  Mixing
+  in a double constant such as M_PI promotes the whole expression to software-emulated
+  double, which costs far more than the trig itself.  The math has no dependencies so
+  that it can be checked and timed on the host.
+
+  See http://hypertriangle.com/~alex/delta-robot-tutorial/ for the derivation.
+
+  DeltaGrid is an optional table of the inverse solution at the nodes of a regular grid
+  over the workspace.  A lookup interpolates trilinearly between the eight nodes around
+  the point, which costs a few dozen multiplies instead of three square roots and three
+  arctangents.  Near the edge of the workspace the solution bends sharply, so each cell
+  is checked at its center, where interpolation is least accurate, when the grid is
+  built.  Points outside the grid, or in a cell that touches an unreachable node or
+  misses the error limit, are left to the exact math.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Kinematics {
+    struct DeltaGeometry {
+        // Using geometry names from the published kinematics to make the math easier to compare
+        float rf = 70.0f;     // The length of the crank arm on the motor
+        float f  = 179.437f;  // Side of the fixed triangle
+        float re = 133.50f;   // The length of the linkages
+        float e  = 86.603f;   // Side of the end effector triangle
+    };
+
+    namespace DeltaMath {
+        const float pi     = 3.14159265f;
+        const float sqrt3  = 1.73205081f;
+        const float sin120 = sqrt3 / 2.0f;
+        const float cos120 = -0.5f;
+        const float tan60  = sqrt3;
+        const float sin30  = 0.5f;
+        const float tan30  = 1.0f / sqrt3;
+
+        // The angle theta of the arm in the YZ plane, false if the point cannot be reached
+        inline bool calcAngleYZ(const DeltaGeometry& g, float x0, float y0, float z0, float& theta) {
+            float y1 = -0.5f * tan30 * g.f;  // f/2 * tg 30
+            y0 -= 0.5f * tan30 * g.e;        // shift center to edge
+            // z = a + b*y
+            float a = (x0 * x0 + y0 * y0 + z0 * z0 + g.rf * g.rf - g.re * g.re - y1 * y1) / (2.0f * z0);
+            float b = (y1 - y0) / z0;
+            // discriminant
+            float d = -(a + b * y1) * (a + b * y1) + g.rf * (b * b * g.rf + g.rf);
+            if (d < 0.0f) {
+                return false;  // non-existing point
+            }
+            float yj = (y1 - a * b - sqrtf(d)) / (b * b + 1.0f);  // choosing outer point
+            float zj = a + b * yj;
+
+            theta = atanf(-zj / (y1 - yj)) + ((yj > y1) ? pi : 0.0f);
+            return true;
+        }
+
+        inline bool inverse(const DeltaGeometry& g, const float* cartesian, float* motors) {
+            float x = cartesian[0];
+            float y = cartesian[1];
+            float z = cartesian[2];
+            return calcAngleYZ(g, x, y, z, motors[0]) &&
+                   calcAngleYZ(g, x * cos120 + y * sin120, y * cos120 - x * sin120, z, motors[1]) &&  // rotate coords to +120 deg
+                   calcAngleYZ(g, x * cos120 - y * sin120, y * cos120 + x * sin120, z, motors[2]);    // rotate coords to -120 deg
+        }
+
+        inline bool forward(const DeltaGeometry& g, const float* motors, float* cartesian) {
+            float t = (g.f - g.e) * tan30 / 2.0f;
+
+            float y1 = -(t + g.rf * cosf(motors[0]));
+            float z1 = -g.rf * sinf(motors[0]);
+
+            float y2 = (t + g.rf * cosf(motors[1])) * sin30;
+            float x2 = y2 * tan60;
+            float z2 = -g.rf * sinf(motors[1]);
+
+            float y3 = (t + g.rf * cosf(motors[2])) * sin30;
+            float x3 = -y3 * tan60;
+            float z3 = -g.rf * sinf(motors[2]);
+
+            float dnm = (y2 - y1) * x3 - (y3 - y1) * x2;
+
+            float w1 = y1 * y1 + z1 * z1;
+            float w2 = x2 * x2 + y2 * y2 + z2 * z2;
+            float w3 = x3 * x3 + y3 * y3 + z3 * z3;
+
+            // x = (a1*z + b1)/dnm
+            float a1 = (z2 - z1) * (y3 - y1) - (z3 - z1) * (y2 - y1);
+            float b1 = -((w2 - w1) * (y3 - y1) - (w3 - w1) * (y2 - y1)) / 2.0f;
+
+            // y = (a2*z + b2)/dnm;
+            float a2 = -(z2 - z1) * x3 + (z3 - z1) * x2;
+            float b2 = ((w2 - w1) * x3 - (w3 - w1) * x2) / 2.0f;
+
+            // a*z^2 + b*z + c = 0
+            float a = a1 * a1 + a2 * a2 + dnm * dnm;
+            float b = 2.0f * (a1 * b1 + a2 * (b2 - y1 * dnm) - z1 * dnm * dnm);
+            float c = (b2 - y1 * dnm) * (b2 - y1 * dnm) + b1 * b1 + dnm * dnm * (z1 * z1 - g.re * g.re);
+
+            // discriminant
+            float d = b * b - 4.0f * a * c;
+            if (d < 0.0f) {
+                return false;
+            }
+            cartesian[2] = -0.5f * (b + sqrtf(d)) / a;
+            cartesian[0] = (a1 * cartesian[2] + b1) / dnm;
+            cartesian[1] = (a2 * cartesian[2] + b2) / dnm;
+            return true;
+        }
+    }
+
+    class DeltaGrid {
+        std::vector<float> _angles;  // 3 per node, x varying fastest; NaN if unreachable
+        std::vector<bool>  _usable;  // Per cell
+        float              _error     = 0.0f;  // The largest in a usable cell
+        float              _origin[3] = { 0.0f, 0.0f, 0.0f };
+        float              _step      = 0.0f;
+        int                _n[3]      = { 0, 0, 0 };
+
+        const float* node(int i, int j, int k) const { return &_angles[3 * ((k * _n[1] + j) * _n[0] + i)]; }
+        size_t       cell(int i, int j, int k) const { return (k * (_n[1] - 1) + j) * (_n[0] - 1) + i; }
+
+        bool interpolate(const int* c, const float* frac, float* motors) const {
+            float result[3] = { 0.0f, 0.0f, 0.0f };
+            for (int corner = 0; corner < 8; ++corner) {
+                int          di = corner & 1, dj = (corner >> 1) & 1, dk = corner >> 2;
+                const float* a  = node(c[0] + di, c[1] + dj, c[2] + dk);
+                if (std::isnan(a[0])) {
+                    return false;
+                }
+                float w = (di ? frac[0] : 1.0f - frac[0]) * (dj ? frac[1] : 1.0f - frac[1]) * (dk ? frac[2] : 1.0f - frac[2]);
+                result[0] += w * a[0];
+                result[1] += w * a[1];
+                result[2] += w * a[2];
+            }
+            motors[0] = result[0];
+            motors[1] = result[1];
+            motors[2] = result[2];
+            return true;
+        }
+
+    public:
+        bool   active() const { return !_angles.empty(); }
+        size_t bytes() const { return _angles.size() * sizeof(float) + _usable.size() / 8; }
+        size_t nodes() const { return _angles.size() / 3; }
+        float  max_error() const { return _error; }  // In radians
+
+        // The fraction of the cells that are used
+        float coverage() const {
+            size_t used = 0;
+            for (bool u : _usable) {
+                used += u;
+            }
+            return _usable.empty() ? 0.0f : float(used) / _usable.size();
+        }
+
+        void clear() {
+            std::vector<float>().swap(_angles);
+            std::vector<bool>().swap(_usable);
+            _error = 0.0f;
+        }
+
+        // Builds a grid with the given spacing over the box lo..hi, using only the cells
+        // whose error is within error_limit radians.  Returns false, leaving the grid
+        // empty, if it would need more than max_nodes nodes.
+        bool build(const DeltaGeometry& g, const float* lo, const float* hi, float step, size_t max_nodes, float error_limit) {
+            clear();
+            if (step <= 0.0f) {
+                return false;
+            }
+            size_t total = 1;
+            for (int axis = 0; axis < 3; ++axis) {
+                _origin[axis] = lo[axis];
+                _n[axis]      = int(ceilf((hi[axis] - lo[axis]) / step)) + 1;
+                if (_n[axis] < 2) {
+                    return false;
+                }
+                total *= _n[axis];
+            }
+            if (total > max_nodes) {
+                return false;
+            }
+            _step = step;
+            _angles.resize(3 * total);
+            float* out = _angles.data();
+            for (int k = 0; k < _n[2]; ++k) {
+                for (int j = 0; j < _n[1]; ++j) {
+                    for (int i = 0; i < _n[0]; ++i, out += 3) {
+                        float cart[3] = { lo[0] + i * step, lo[1] + j * step, lo[2] + k * step };
+                        if (!DeltaMath::inverse(g, cart, out)) {
+                            out[0] = out[1] = out[2] = NAN;
+                        }
+                    }
+                }
+            }
+            _usable.resize((_n[0] - 1) * (_n[1] - 1) * (_n[2] - 1));
+            for (int k = 0; k < _n[2] - 1; ++k) {
+                for (int j = 0; j < _n[1] - 1; ++j) {
+                    for (int i = 0; i < _n[0] - 1; ++i) {
+                        int   c[3]    = { i, j, k };
+                        float frac[3] = { 0.5f, 0.5f, 0.5f };
+                        float cart[3] = { lo[0] + (i + 0.5f) * step, lo[1] + (j + 0.5f) * step, lo[2] + (k + 0.5f) * step };
+                        float exact[3], approx[3];
+                        if (interpolate(c, frac, approx) && DeltaMath::inverse(g, cart, exact)) {
+                            float error = 0.0f;
+                            for (int m = 0; m < 3; ++m) {
+                                error = std::fmax(error, fabsf(approx[m] - exact[m]));
+                            }
+                            if (error <= error_limit) {
+                                _usable[cell(i, j, k)] = true;
+                                _error                 = std::fmax(_error, error);
+                            }
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Interpolated inverse; false if the exact math must be used instead
+        bool inverse(const float* cartesian, float* motors) const {
+            if (!active()) {
+                return false;
+            }
+            int   c[3];
+            float frac[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                float pos = (cartesian[axis] - _origin[axis]) / _step;
+                if (!(pos >= 0.0f)) {  // Also rejects NaN
+                    return false;
+                }
+                int index = int(pos);
+                if (index >= _n[axis] - 1) {
+                    if (index > _n[axis] - 1 || pos > float(index)) {
+                        return false;
+                    }
+                    index = _n[axis] - 2;  // On the far face
+                }
+                c[axis]    = index;
+                frac[axis] = pos - index;
+            }
+            return _usable[cell(c[0], c[1], c[2])] && interpolate(c, frac, motors);
+        }
+    };
+}
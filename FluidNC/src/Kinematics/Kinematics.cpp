@@ -5,9 +5,56 @@
 #include "Kinematics.h"
 
 #include "src/Config.h"
+#include "src/Machine/MachineConfig.h"
+#include "src/NutsBolts.h"  // limit_rate_by_axis_maximum()
 #include "Cartesian.h"
 
+#include <cmath>
+
 namespace Kinematics {
+    uint32_t segment_count(float                   distance,
+                           float                   max_length,
+                           float                   min_length,
+                           float                   segments_per_second,
+                           const float*            target,
+                           const float*            position,
+                           const plan_line_data_t* pl_data) {
+        if (distance <= 0.0f) {
+            return 1;
+        }
+        float count = ceilf(distance / max_length);
+        if (segments_per_second > 0.0f) {
+            float seconds;
+            if (pl_data->motion.inverseTime) {
+                seconds = 60.0f / pl_data->feed_rate;
+            } else {
+                float rate = pl_data->feed_rate;
+                if (pl_data->motion.rapidMotion) {
+                    // Rapids run at the axis limits. This is an estimate, since the
+                    // limits apply to the motors, not to cartesian space.
+                    float unit_vec[MAX_N_AXIS];
+                    auto  n_axis = Axes::_numberAxis;
+                    for (size_t axis = 0; axis < n_axis; axis++) {
+                        unit_vec[axis] = (target[axis] - position[axis]) / distance;
+                    }
+                    rate = limit_rate_by_axis_maximum(unit_vec);
+                }
+                seconds = rate > 0.0f ? distance * 60.0f / rate : 0.0f;
+            }
+            float by_time = ceilf(seconds * segments_per_second);
+            if (by_time > count) {
+                count = by_time;
+            }
+            if (min_length > 0.0f) {
+                float most = floorf(distance / min_length);
+                if (count > most) {
+                    count = most;
+                }
+            }
+        }
+        return count < 1.0f ? 1 : uint32_t(count);
+    }
+
     void Kinematics::constrain_jog(float* target, plan_line_data_t* pl_data, float* position) {
         Assert(_system != nullptr, "No kinematic system");
         return _system->constrain_jog(target, pl_data, position);
@@ -34,6 +81,16 @@ namespace Kinematics {
         return _system->motors_to_cartesian(cartesian, motors, n_axis);
     }
 
+    bool Kinematics::single_block_lines() {
+        Assert(_system != nullptr, "No kinematic system");
+        return _system->single_block_lines();
+    }
+
+    bool Kinematics::native_arcs() {
+        Assert(_system != nullptr, "No kinematic system");
+        return _system->native_arcs();
+    }
+
     bool Kinematics::canHome(AxisMask axisMask) {
         Assert(_system != nullptr, "No kinematic system");
         return _system->canHome(axisMask);
@@ -59,6 +116,19 @@ namespace Kinematics {
         return _system->transform_cartesian_to_motors(motors, cartesian);
     }
 
+    bool Kinematics::transform_n(const float* cartesian, float* motors, size_t n) {
+        Assert(_system != nullptr, "No kinematics system.");
+        return _system->transform_n(cartesian, motors, n);
+    }
+
+    bool KinematicSystem::transform_n(const float* cartesian, float* motors, size_t n) {
+        bool ok = true;
+        for (size_t i = 0; i < n; i++, cartesian += MAX_N_AXIS, motors += MAX_N_AXIS) {
+            ok = transform_cartesian_to_motors(motors, const_cast<float*>(cartesian)) && ok;
+        }
+        return ok;
+    }
+
     void Kinematics::group(Configuration::HandlerBase& handler) {
         ::Kinematics::KinematicsFactory::factory(handler, _system);
     }
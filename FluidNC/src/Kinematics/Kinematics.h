@@ -24,6 +24,20 @@ You will be able to add your kinematics using the config file.
 namespace Kinematics {
     class KinematicSystem;
 
+    // The number of segments into which a non-linear kinematic system splits a straight
+    // move of the given cartesian distance.  Segments are sized by time, so that the
+    // planner receives about segments_per_second of them at the move's speed, but are
+    // never longer than max_length, which bounds the deviation from a straight line, nor
+    // shorter than min_length, below which the motors cannot resolve the difference.
+    // With segments_per_second 0, moves are split by max_length alone.
+    uint32_t segment_count(float                   distance,
+                           float                   max_length,
+                           float                   min_length,
+                           float                   segments_per_second,
+                           const float*            target,
+                           const float*            position,
+                           const plan_line_data_t* pl_data);
+
     class Kinematics : public Configuration::Configurable {
     public:
         Kinematics() {}
@@ -39,12 +53,15 @@ namespace Kinematics {
         bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position);
         void motors_to_cartesian(float* cartesian, float* motors, int n_axis);
         bool transform_cartesian_to_motors(float* motors, float* cartesian);
+        bool transform_n(const float* cartesian, float* motors, size_t n);
 
         void constrain_jog(float* target, plan_line_data_t* pl_data, float* position);
         bool invalid_line(float* target);
         bool invalid_arc(
             float* target, plan_line_data_t* pl_data, float* position, float center[3], float radius, size_t caxes[3], bool is_clockwise_arc);
 
+        bool single_block_lines();
+        bool native_arcs();
         bool canHome(AxisMask axisMask);
         bool kinematics_homing(AxisMask axisMask);
         void releaseMotors(AxisMask axisMask, MotorMask motors);
@@ -81,6 +98,18 @@ namespace Kinematics {
 
         virtual bool transform_cartesian_to_motors(float* motors, float* cartesian) = 0;
 
+        // Converts n points, each an array of MAX_N_AXIS floats, returning false if any is
+        // unreachable.  Systems with a cheap transform override it to avoid a virtual
+        // call, and the axis loop, per point.
+        virtual bool transform_n(const float* cartesian, float* motors, size_t n);
+
+        // True if cartesian_to_motors() plans a straight move as one planner block
+        virtual bool single_block_lines() { return false; }
+
+        // True if motor space is cartesian space, so that the planner can take an arc as one
+        // block that the stepper follows directly.  See plan_buffer_arc().
+        virtual bool native_arcs() { return false; }
+
         virtual bool canHome(AxisMask axisMask) { return false; }
         virtual void releaseMotors(AxisMask axisMask, MotorMask motors) {}
         virtual bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited) { return false; }
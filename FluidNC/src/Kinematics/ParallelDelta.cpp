@@ -1,4 +1,5 @@
 #include "ParallelDelta.h"
+#include "SegmentPipeline.h"
 
 #include "../Machine/MachineConfig.h"
 #include "../Limits.h"  // ambiguousLimit()
@@ -50,34 +51,26 @@ kinematics:
 
 namespace Kinematics {
 
-    // trigonometric constants to speed up calculations
-    const float sqrt3  = 1.732050807;
-    const float dtr    = M_PI / (float)180.0;  // degrees to radians
-    const float sin120 = sqrt3 / 2.0;
-    const float cos120 = -0.5;
-    const float tan60  = sqrt3;
-    const float sin30  = 0.5;
-    const float tan30  = 1.0 / sqrt3;
-
-    // the geometry of the delta
-    float rf;  // radius of the fixed side (length of motor cranks)
-    float re;  // radius of end effector side (length of linkages)
-    float f;   // sized of fixed side triangel
-    float e;   // size of end effector side triangle
-
     static float last_angle[MAX_N_AXIS]     = { 0.0 };  // A place to save the previous motor angles for distance/feed rate calcs
     static float last_cartesian[MAX_N_AXIS] = { 0.0 };  // A place to save the previous motor angles for distance/feed rate calcs
 
     void ParallelDelta::group(Configuration::HandlerBase& handler) {
-        handler.item("crank_mm", rf, 50.0, 500.0);
-        handler.item("base_triangle_mm", f, 20.0, 500.0);
-        handler.item("linkage_mm", re, 20.0, 500.0);
-        handler.item("end_effector_triangle_mm", e, 20.0, 500.0);
+        handler.item("crank_mm", _geometry.rf, 50.0, 500.0);
+        handler.item("base_triangle_mm", _geometry.f, 20.0, 500.0);
+        handler.item("linkage_mm", _geometry.re, 20.0, 500.0);
+        handler.item("end_effector_triangle_mm", _geometry.e, 20.0, 500.0);
         handler.item("kinematic_segment_len_mm", _kinematic_segment_len_mm, 0.05, 20.0);  //
+        handler.item("min_segment_len_mm", _min_segment_len_mm, 0.0, 20.0);
+        handler.item("segments_per_second", _segments_per_second, 0.0, 1000.0);
         handler.item("homing_mpos_radians", _homing_mpos);
         handler.item("soft_limits", _softLimits);
         handler.item("max_z_mm", _max_z, -10000.0, 0.0);  //
         handler.item("use_servos", _use_servos);
+        handler.item("kinematics_task", _kinematics_task);
+        handler.item("ik_grid_mm", _ik_grid_mm, 0.0, 50.0);
+        handler.item("ik_grid_max_error_deg", _ik_grid_max_error, 0.0001, 1.0);
+        handler.item("workspace_radius_mm", _workspace_radius, 1.0, 1000.0);
+        handler.item("workspace_height_mm", _workspace_height, 1.0, 1000.0);
     }
 
     void ParallelDelta::init() {
@@ -95,9 +88,35 @@ namespace Kinematics {
             }
         }
 
+        if (_ik_grid_mm > 0) {
+            build_grid();
+        }
+
+        // The soft limits are a cylinder of the workspace radius and height below max_z,
+        // which is convex, unlike the full reach of the arms
+        float lo[3] = { -HUGE_VALF, -HUGE_VALF, _max_z - _workspace_height };
+        float hi[3] = { HUGE_VALF, HUGE_VALF, _max_z };
+        _envelope.set_box(lo, hi);
+        _envelope.set_cylinder(0.0f, 0.0f, _workspace_radius);
+
         init_position();
     }
 
+    // The grid covers a box of the workspace radius around the axis and the workspace
+    // height below max_z.  Cells that are unreachable or not accurate enough are left to
+    // the exact math.
+    void ParallelDelta::build_grid() {
+        float lo[3] = { -_workspace_radius, -_workspace_radius, _max_z - _workspace_height };
+        float hi[3] = { _workspace_radius, _workspace_radius, _max_z };
+        if (!_grid.build(_geometry, lo, hi, _ik_grid_mm, max_grid_nodes, _ik_grid_max_error * DeltaMath::pi / 180.0f)) {
+            log_config_error("ik_grid_mm " << _ik_grid_mm << " needs more than " << max_grid_nodes << " grid nodes");
+            return;
+        }
+        float error_deg = _grid.max_error() * 180.0f / DeltaMath::pi;
+        log_info("  IK grid:" << _grid.nodes() << " nodes " << (_grid.bytes() / 1024) << "KB coverage:" << int(_grid.coverage() * 100)
+                              << "% max error:" << error_deg << " deg");
+    }
+
     void ParallelDelta::init_position() {
         float angles[MAX_N_AXIS]    = { 0.0, 0.0, 0.0 };
         float cartesian[MAX_N_AXIS] = { 0.0, 0.0, 0.0 };
@@ -113,7 +132,7 @@ namespace Kinematics {
 
         float motors[MAX_N_AXIS] = { 0.0, 0.0, 0.0 };
 
-        if (!transform_cartesian_to_motors(motors, cartesian)) {
+        if (!_envelope.contains(cartesian) || !transform_cartesian_to_motors(motors, cartesian)) {
             limit_error();
             return true;
         }
@@ -121,33 +140,37 @@ namespace Kinematics {
         return false;
     }
 
-    // TO DO. This is not supported yet. Other levels of protection will prevent "damage"
+    // An arc whose bounding box is inside the envelope needs no further checks.
+    // Otherwise each segment is checked by invalid_line().
     bool ParallelDelta::invalid_arc(
         float* target, plan_line_data_t* pl_data, float* position, float center[3], float radius, size_t caxes[3], bool is_clockwise_arc) {
+        if (_softLimits) {
+            float lo                = std::min(position[caxes[2]], target[caxes[2]]);
+            float hi                = std::max(position[caxes[2]], target[caxes[2]]);
+            pl_data->limits_checked = _envelope.contains_arc(center, radius, lo, hi, caxes);
+        }
         return false;
     }
 
-    // copied from Cartesian . Needs to be optimized for parallel delta.
+    // The jog is cut short where it leaves the envelope
     void ParallelDelta::constrain_jog(float* target, plan_line_data_t* pl_data, float* position) {
-        // log_debug("Jog Test: from(" << position[X_AXIS] << ")"
-        //                             << " to(" << target[X_AXIS] << ")");
         if (!_softLimits)
             return;
 
-        float motors[MAX_N_AXIS] = { 0.0, 0.0, 0.0 };
+        float fraction = _envelope.clip(position, target);
+        if (fraction < 1.0f) {
+            for (size_t axis = X_AXIS; axis <= Z_AXIS; axis++) {
+                target[axis] = position[axis] + (target[axis] - position[axis]) * fraction;
+            }
+            log_debug("Jog constrained to workspace");
+        }
 
-        // Temp fix
-        // If the target is reachable do nothing
-        if (transform_cartesian_to_motors(motors, target)) {
-            return;
-        } else {
+        float motors[MAX_N_AXIS] = { 0.0, 0.0, 0.0 };
+        if (!transform_cartesian_to_motors(motors, target)) {
             log_warn("Kinematics soft limit jog rejection");
             copyAxes(target, position);
         }
-
-        // TO DO better idea
-        // loop back from the target in increments of  kinematic_segment_len_mm unitl the position is valid.
-        // constrain to that target.
+        pl_data->limits_checked = true;
     }
 
     bool ParallelDelta::cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) {
@@ -188,13 +211,29 @@ namespace Kinematics {
         dx         = target[X_AXIS] - position[X_AXIS];
         dy         = target[Y_AXIS] - position[Y_AXIS];
         dz         = target[Z_AXIS] - position[Z_AXIS];
-        float dist = sqrt((dx * dx) + (dy * dy) + (dz * dz));
+        float dist = sqrtf((dx * dx) + (dy * dy) + (dz * dz));
 
         // determine the number of segments we need	... round up so there is at least 1 (except when dist is 0)
-        uint32_t segment_count = ceil(dist / _kinematic_segment_len_mm);
+        uint32_t segment_count = 0;
+        if (dist > 0) {
+            segment_count = ::Kinematics::segment_count(
+                dist, _kinematic_segment_len_mm, _min_segment_len_mm, _segments_per_second, target, position, pl_data);
+        }
 
         float segment_dist = dist / ((float)segment_count);  // distance of each segment...will be used for feedrate conversion
 
+        // With the kinematics task, the motor angles of the segments are computed ahead on the other core
+        float seg_delta[3] = { dx / float(segment_count), dy / float(segment_count), dz / float(segment_count) };
+        struct PipelineGuard {
+            bool active;
+            ~PipelineGuard() {
+                if (active) {
+                    SegmentPipeline::end();
+                }
+            }
+        } pipeline { _kinematics_task && segment_count > 1 &&
+                     SegmentPipeline::begin(segment_transform, this, position, seg_delta, segment_count) };
+
         for (uint32_t segment = 1; segment <= segment_count; segment++) {
             if (sys.abort) {
                 return true;
@@ -208,7 +247,7 @@ namespace Kinematics {
             //log_debug("Segment target (" << seg_target[0] << "," << seg_target[1] << "," << seg_target[2] << ")");
 
             // calculate the delta motor angles
-            bool calc_ok = transform_cartesian_to_motors(motor_angles, seg_target);
+            bool calc_ok = pipeline.active ? SegmentPipeline::next(motor_angles) : transform_cartesian_to_motors(motor_angles, seg_target);
 
             if (!calc_ok) {
                 if (show_error) {
@@ -242,47 +281,9 @@ namespace Kinematics {
         //log_debug("motors_to_cartesian motors: (" << motors[0] << "," << motors[1] << "," << motors[2] << ")");
         //log_info("motors_to_cartesian rf:" << rf << " re:" << re << " f:" << f << " e:" << e);
 
-        float t = (f - e) * tan30 / 2;
-
-        float y1 = -(t + rf * cos(motors[0]));
-        float z1 = -rf * sin(motors[0]);
-
-        float y2 = (t + rf * cos(motors[1])) * sin30;
-        float x2 = y2 * tan60;
-        float z2 = -rf * sin(motors[1]);
-
-        float y3 = (t + rf * cos(motors[2])) * sin30;
-        float x3 = -y3 * tan60;
-        float z3 = -rf * sin(motors[2]);
-
-        float dnm = (y2 - y1) * x3 - (y3 - y1) * x2;
-
-        float w1 = y1 * y1 + z1 * z1;
-        float w2 = x2 * x2 + y2 * y2 + z2 * z2;
-        float w3 = x3 * x3 + y3 * y3 + z3 * z3;
-
-        // x = (a1*z + b1)/dnm
-        float a1 = (z2 - z1) * (y3 - y1) - (z3 - z1) * (y2 - y1);
-        float b1 = -((w2 - w1) * (y3 - y1) - (w3 - w1) * (y2 - y1)) / 2.0;
-
-        // y = (a2*z + b2)/dnm;
-        float a2 = -(z2 - z1) * x3 + (z3 - z1) * x2;
-        float b2 = ((w2 - w1) * x3 - (w3 - w1) * x2) / 2.0;
-
-        // a*z^2 + b*z + c = 0
-        float a = a1 * a1 + a2 * a2 + dnm * dnm;
-        float b = 2 * (a1 * b1 + a2 * (b2 - y1 * dnm) - z1 * dnm * dnm);
-        float c = (b2 - y1 * dnm) * (b2 - y1 * dnm) + b1 * b1 + dnm * dnm * (z1 * z1 - re * re);
-
-        // discriminant
-        float d = b * b - (float)4.0 * a * c;
-        if (d < 0) {
+        if (!DeltaMath::forward(_geometry, motors, cartesian)) {
             log_warn("Forward Kinematics Error");
-            return;
         }
-        cartesian[Z_AXIS] = -(float)0.5 * (b + sqrt(d)) / a;
-        cartesian[X_AXIS] = (a1 * cartesian[Z_AXIS] + b1) / dnm;
-        cartesian[Y_AXIS] = (a2 * cartesian[Z_AXIS] + b2) / dnm;
     }
 
     bool ParallelDelta::kinematics_homing(AxisMask& axisMask) {
@@ -305,62 +306,44 @@ namespace Kinematics {
         return true;  // signal main code that this handled all homing
     }
 
-    // helper functions, calculates angle theta1 (for YZ-pane)
-    bool ParallelDelta::delta_calcAngleYZ(float x0, float y0, float z0, float& theta) {
-        float y1 = -0.5 * 0.57735 * f;  // f/2 * tg 30
-        y0 -= 0.5 * 0.57735 * e;        // shift center to edge
-        // z = a + b*y
-        float a = (x0 * x0 + y0 * y0 + z0 * z0 + rf * rf - re * re - y1 * y1) / (2 * z0);
-        float b = (y1 - y0) / z0;
-        // discriminant
-        float d = -(a + b * y1) * (a + b * y1) + rf * (b * b * rf + rf);
-        if (d < 0) {
-            //log_warn("Kinematics: Target unreachable");
-            return false;
-        }                                                 // non-existing point
-        float yj = (y1 - a * b - sqrt(d)) / (b * b + 1);  // choosing outer point
-        float zj = a + b * yj;
-
-        theta = atan(-zj / (y1 - yj)) + ((yj > y1) ? M_PI : 0.0);
+    void ParallelDelta::releaseMotors(AxisMask axisMask, MotorMask motors) {}
 
-        return true;
+    // transform_cartesian_to_motors() without logging, for the kinematics task
+    bool ParallelDelta::segment_transform(void* arg, const float* cartesian, float* motors) {
+        auto delta = static_cast<ParallelDelta*>(arg);
+        if (cartesian[Z_AXIS] > delta->_max_z) {
+            return false;
+        }
+        return delta->_grid.inverse(cartesian, motors) || DeltaMath::inverse(delta->_geometry, cartesian, motors);
     }
 
-    void ParallelDelta::releaseMotors(AxisMask axisMask, MotorMask motors) {}
-
     bool ParallelDelta::transform_cartesian_to_motors(float* motors, float* cartesian) {
         motors[0] = motors[1] = motors[2] = 0;
-        bool calc_ok                      = false;
 
         if (cartesian[Z_AXIS] > _max_z) {
             log_debug("Kinematics transform error. Target:" << cartesian[Z_AXIS] << " exceeds max_z:" << _max_z);
             return false;
         }
 
-        calc_ok = delta_calcAngleYZ(cartesian[X_AXIS], cartesian[Y_AXIS], cartesian[Z_AXIS], motors[0]);
-        if (!calc_ok) {
-            return calc_ok;
-        }
-
-        calc_ok = delta_calcAngleYZ(cartesian[X_AXIS] * cos120 + cartesian[Y_AXIS] * sin120,
-                                    cartesian[Y_AXIS] * cos120 - cartesian[X_AXIS] * sin120,
-                                    cartesian[Z_AXIS],
-                                    motors[1]);  // rotate coords to +120 deg
-        if (!calc_ok) {
-            return calc_ok;
+        if (_grid.inverse(cartesian, motors)) {
+            return true;
         }
 
-        calc_ok = delta_calcAngleYZ(cartesian[X_AXIS] * cos120 - cartesian[Y_AXIS] * sin120,
-                                    cartesian[Y_AXIS] * cos120 + cartesian[X_AXIS] * sin120,
-                                    cartesian[Z_AXIS],
-                                    motors[2]);  // rotate coords to -120 deg
+        return DeltaMath::inverse(_geometry, cartesian, motors);
+    }
 
-        return calc_ok;
+    bool ParallelDelta::transform_n(const float* cartesian, float* motors, size_t n) {
+        bool ok = true;
+        for (size_t i = 0; i < n; i++, cartesian += MAX_N_AXIS, motors += MAX_N_AXIS) {
+            motors[0] = motors[1] = motors[2] = 0;
+            ok                                = segment_transform(this, cartesian, motors) && ok;
+        }
+        return ok;
     }
 
     // Determine the unit distance between (2) 3D points
     float ParallelDelta::three_axis_dist(float* point1, float* point2) {
-        return sqrt(((point1[0] - point2[0]) * (point1[0] - point2[0])) + ((point1[1] - point2[1]) * (point1[1] - point2[1])) +
+        return sqrtf(((point1[0] - point2[0]) * (point1[0] - point2[0])) + ((point1[1] - point2[1]) * (point1[1] - point2[1])) +
                     ((point1[2] - point2[2]) * (point1[2] - point2[2])));
     }
 
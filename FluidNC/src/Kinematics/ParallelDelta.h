@@ -11,6 +11,7 @@
 
 #include "Kinematics.h"
 #include "Cartesian.h"
+#include "DeltaMath.h"
 
 // M_PI is not defined in standard C/C++ but some compilers
 // support it anyway.  The following suppresses Intellisense
@@ -37,6 +38,8 @@ namespace Kinematics {
         bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) override;
         void motors_to_cartesian(float* cartesian, float* motors, int n_axis) override;
         bool transform_cartesian_to_motors(float* motors, float* cartesian) override;
+        bool transform_n(const float* cartesian, float* motors, size_t n) override;
+        bool native_arcs() override { return false; }
         //bool soft_limit_error_exists(float* cartesian) override;
         bool         kinematics_homing(AxisMask& axisMask) override;
         virtual void constrain_jog(float* cartesian, plan_line_data_t* pl_data, float* position) override;
@@ -59,20 +62,31 @@ namespace Kinematics {
         ~ParallelDelta() {}
 
     private:
-        //  Config items Using geometry names from the published kinematics rather than typical Fluid Style
-        // To make the math easier to compare with the code
-        float rf = 70.0;  // The length of the crank arm on the motor
-        float f  = 179.437;
-        float re = 133.50;
-        float e  = 86.603;
+        DeltaGeometry _geometry;
 
         float _kinematic_segment_len_mm = 1.0;  // the maximun segment length the move is broken into
+        float _min_segment_len_mm       = 0.1;  // with _segments_per_second, the shortest segment
+        float _segments_per_second      = 0.0;  // 0 splits by length only
         bool  _softLimits               = false;
         float _homing_mpos              = 0.0;
         float _max_z                    = 0.0;
-        bool  _use_servos               = true;  // servo use a special homing
+        bool  _use_servos               = true;   // servo use a special homing
+        bool  _kinematics_task          = false;  // compute segments ahead on the support core
+
+        // Optional interpolated inverse kinematics, with the node spacing in mm; 0 disables it
+        float     _ik_grid_mm        = 0.0;
+        float     _ik_grid_max_error = 0.01;  // Degrees of arm angle
+        float     _workspace_radius  = 100.0;
+        float     _workspace_height  = 150.0;
+        DeltaGrid _grid;
+        Workspace _envelope;  // The soft limits
+
+        static const size_t max_grid_nodes = 8192;  // 96KB of angles
+
+        void build_grid();
+
+        static bool segment_transform(void* arg, const float* cartesian, float* motors);
 
-        bool  delta_calcAngleYZ(float x0, float y0, float z0, float& theta);
         float three_axis_dist(float* point1, float* point2);
 
     protected:
@@ -0,0 +1,100 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SegmentPipeline.h"
+#include "src/Machine/Tasks.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <atomic>
+
+namespace Kinematics {
+    struct SegmentJob {
+        SegmentPipeline::Transform transform;
+        void*                      arg;
+        float                      start[3];
+        float                      delta[3];
+        uint32_t                   count;
+    };
+
+    struct SegmentResult {
+        float   motors[3];
+        uint8_t status;
+    };
+
+    enum : uint8_t { SegmentOk, SegmentUnreachable, SegmentDone };
+
+    // The depth of the result queue is how far the worker can run ahead
+    static const int         resultDepth = 8;
+    static QueueHandle_t     jobQueue    = nullptr;
+    static QueueHandle_t     resultQueue = nullptr;
+    static std::atomic<bool> stopJob { false };
+    static uint32_t          remaining = 0;      // Segments the consumer has yet to take
+    static bool              finished  = false;  // The consumer has seen the end marker
+
+    void SegmentPipeline::worker(void* unused) {
+        while (true) {
+            SegmentJob job;
+            if (!xQueueReceive(jobQueue, &job, portMAX_DELAY)) {
+                continue;
+            }
+            SegmentResult result;
+            for (uint32_t segment = 1; segment <= job.count && !stopJob; segment++) {
+                float seg_target[3];
+                for (int axis = 0; axis < 3; axis++) {
+                    seg_target[axis] = job.start[axis] + job.delta[axis] * segment;
+                }
+                result.status = job.transform(job.arg, seg_target, result.motors) ? SegmentOk : SegmentUnreachable;
+                xQueueSend(resultQueue, &result, portMAX_DELAY);
+                if (result.status == SegmentUnreachable) {
+                    break;
+                }
+            }
+            result.status = SegmentDone;
+            xQueueSend(resultQueue, &result, portMAX_DELAY);
+        }
+    }
+
+    bool SegmentPipeline::begin(Transform transform, void* arg, const float* start, const float* delta, uint32_t count) {
+        if (!jobQueue) {
+            jobQueue    = xQueueCreate(1, sizeof(SegmentJob));
+            resultQueue = xQueueCreate(resultDepth, sizeof(SegmentResult));
+            if (!jobQueue || !resultQueue || Machine::Tasks::create("kinematics", worker, nullptr) != pdPASS) {
+                return false;
+            }
+        }
+        SegmentJob job { transform, arg, { start[0], start[1], start[2] }, { delta[0], delta[1], delta[2] }, count };
+        stopJob   = false;
+        remaining = count;
+        finished  = false;
+        xQueueSend(jobQueue, &job, portMAX_DELAY);
+        return true;
+    }
+
+    bool SegmentPipeline::next(float* motors) {
+        SegmentResult result;
+        if (!remaining || !xQueueReceive(resultQueue, &result, portMAX_DELAY)) {
+            return false;
+        }
+        if (result.status != SegmentOk) {
+            finished  = result.status == SegmentDone;
+            remaining = 0;
+            return false;
+        }
+        --remaining;
+        motors[0] = result.motors[0];
+        motors[1] = result.motors[1];
+        motors[2] = result.motors[2];
+        return true;
+    }
+
+    void SegmentPipeline::end() {
+        // Unblock the worker and discard what it computed ahead, up to the end marker
+        stopJob = true;
+        SegmentResult result;
+        while (!finished && xQueueReceive(resultQueue, &result, portMAX_DELAY)) {
+            finished = result.status == SegmentDone;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SegmentPipeline.h - inverse kinematics of move segments on the support core
+
+  A kinematic system that splits moves into many segments can hand the inverse
+  transform of the segments to a worker task on the other core.  The worker runs a few
+  segments ahead, so while the GCode task is planning one segment, or waiting for room
+  in the planner, the motor positions of the next ones are being computed.  Segments
+  are delivered in order, and the GCode task still submits every segment itself, so
+  jog cancellation, aborts and the planner see exactly what they did before.
+
+  The transform runs on the worker, so it must not log or touch shared state.
+*/
+
+#include <cstdint>
+
+namespace Kinematics {
+    class SegmentPipeline {
+    public:
+        // Computes the motor positions of the 3-axis cartesian point, false if unreachable
+        using Transform = bool (*)(void* arg, const float* cartesian, float* motors);
+
+        // Starts computing segments 1..count of the move from start in steps of
+        // delta.  Returns false, in which case the caller does the work itself, if the
+        // worker cannot be started.
+        static bool begin(Transform transform, void* arg, const float* start, const float* delta, uint32_t count);
+
+        // The motor positions of the next segment.  The result is false if the segment is
+        // unreachable, after which no more segments are computed.
+        static bool next(float* motors);
+
+        // Must follow every successful begin(), whether or not all segments were taken,
+        // before the next begin().
+        static void end();
+
+    private:
+        static void worker(void* unused);
+    };
+}
@@ -0,0 +1,216 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Trunnion.h"
+
+#include "../Machine/MachineConfig.h"
+#include "../GCode.h"  // gc_state.modal.tool_length
+
+#include <cmath>
+
+/*
+Default configuration
+
+kinematics:
+  Trunnion:
+    tilt_axis: 3
+    rotary_axis: 5
+    pivot_x_mm: 0
+    pivot_y_mm: 0
+    pivot_z_mm: 0
+    segment_length_mm: 1
+    segment_degrees: 1
+
+The pivot is the machine position where the rotary axis crosses the tilt axis.  The
+rotary axes are in degrees.  A point p on the part is at
+
+  m = pivot + Rx(tilt) * Rz(rotary) * (p - pivot)
+
+in machine coordinates, so with both angles at zero the part frame is the machine frame.
+
+Moves under G43.4 are interpolated in the part frame, split so that no segment is
+longer than segment_length_mm of tool path or segment_degrees of rotation, and each
+segment is sent to the planner in inverse time so the tool moves over the part at the
+programmed feed rate however far the linear axes have to travel to follow it.
+*/
+
+namespace Kinematics {
+    static const float degreesToRadians = 3.14159265f / 180.0f;
+
+    void Trunnion::group(Configuration::HandlerBase& handler) {
+        handler.item("tilt_axis", _tilt_axis, 3, 5);
+        handler.item("rotary_axis", _rotary_axis, 3, 5);
+        handler.item("pivot_x_mm", _pivot[X_AXIS]);
+        handler.item("pivot_y_mm", _pivot[Y_AXIS]);
+        handler.item("pivot_z_mm", _pivot[Z_AXIS]);
+        handler.item("segment_length_mm", _segment_length, 0.01, 100.0);
+        handler.item("segment_degrees", _segment_degrees, 0.01, 90.0);
+    }
+
+    void Trunnion::validate() {
+        Assert(_tilt_axis != _rotary_axis, "tilt_axis and rotary_axis must differ");
+    }
+
+    void Trunnion::init() {
+        log_info("Kinematic system: " << name() << " tilt axis:" << Machine::Axes::axisName(_tilt_axis)
+                                      << " rotary axis:" << Machine::Axes::axisName(_rotary_axis));
+        if (Axes::_numberAxis <= std::max(_tilt_axis, _rotary_axis)) {
+            log_config_error("Trunnion needs the tilt and rotary axes to be configured");
+        }
+        init_position();
+    }
+
+    // Homing always runs in machine coordinates
+    bool Trunnion::tcp_active() {
+        return gc_state.modal.tool_length == ToolLengthOffset::EnableTcp && !state_is(State::Homing);
+    }
+
+    void Trunnion::part_to_machine(const float* part, float* machine) {
+        float c = part[_rotary_axis] * degreesToRadians;
+        float a = part[_tilt_axis] * degreesToRadians;
+        float x = part[X_AXIS] - _pivot[X_AXIS];
+        float y = part[Y_AXIS] - _pivot[Y_AXIS];
+        float z = part[Z_AXIS] - _pivot[Z_AXIS];
+
+        // Turn the table, then tilt it
+        float cc = cosf(c), sc = sinf(c);
+        float x1 = x * cc - y * sc;
+        float y1 = x * sc + y * cc;
+        float ca = cosf(a), sa = sinf(a);
+
+        auto n_axis = Axes::_numberAxis;
+        for (size_t axis = A_AXIS; axis < n_axis; axis++) {
+            machine[axis] = part[axis];
+        }
+        machine[X_AXIS] = _pivot[X_AXIS] + x1;
+        machine[Y_AXIS] = _pivot[Y_AXIS] + y1 * ca - z * sa;
+        machine[Z_AXIS] = _pivot[Z_AXIS] + y1 * sa + z * ca;
+    }
+
+    void Trunnion::machine_to_part(const float* machine, float* part) {
+        float c = machine[_rotary_axis] * degreesToRadians;
+        float a = machine[_tilt_axis] * degreesToRadians;
+        float x = machine[X_AXIS] - _pivot[X_AXIS];
+        float y = machine[Y_AXIS] - _pivot[Y_AXIS];
+        float z = machine[Z_AXIS] - _pivot[Z_AXIS];
+
+        // Untilt the table, then unturn it
+        float ca = cosf(a), sa = sinf(a);
+        float y1 = y * ca + z * sa;
+        float z1 = z * ca - y * sa;
+        float cc = cosf(c), sc = sinf(c);
+
+        auto n_axis = Axes::_numberAxis;
+        for (size_t axis = A_AXIS; axis < n_axis; axis++) {
+            part[axis] = machine[axis];
+        }
+        part[X_AXIS] = _pivot[X_AXIS] + x * cc + y1 * sc;
+        part[Y_AXIS] = _pivot[Y_AXIS] - x * sc + y1 * cc;
+        part[Z_AXIS] = _pivot[Z_AXIS] + z1;
+    }
+
+    bool Trunnion::transform_cartesian_to_motors(float* motors, float* cartesian) {
+        if (tcp_active()) {
+            part_to_machine(cartesian, motors);
+        } else {
+            copyAxes(motors, cartesian);
+        }
+        return true;
+    }
+
+    // Not Cartesian's copy, since the transform depends on the mode
+    bool Trunnion::transform_n(const float* cartesian, float* motors, size_t n) {
+        return KinematicSystem::transform_n(cartesian, motors, n);
+    }
+
+    void Trunnion::motors_to_cartesian(float* cartesian, float* motors, int n_axis) {
+        if (tcp_active()) {
+            machine_to_part(motors, cartesian);
+        } else {
+            copyAxes(cartesian, motors);
+        }
+    }
+
+    // The soft limits apply to the machine position
+    bool Trunnion::invalid_line(float* cartesian) {
+        if (!tcp_active()) {
+            return Cartesian::invalid_line(cartesian);
+        }
+        float motors[MAX_N_AXIS];
+        part_to_machine(cartesian, motors);
+        return Cartesian::invalid_line(motors);
+    }
+
+    // The fast arc check works in machine coordinates.  Under G43.4 each arc segment
+    // is checked by invalid_line() instead.
+    bool Trunnion::invalid_arc(
+        float* target, plan_line_data_t* pl_data, float* position, float center[3], float radius, size_t caxes[3], bool is_clockwise_arc) {
+        if (!tcp_active()) {
+            return Cartesian::invalid_arc(target, pl_data, position, center, radius, caxes, is_clockwise_arc);
+        }
+        return false;
+    }
+
+    bool Trunnion::cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) {
+        if (!tcp_active()) {
+            return mc_move_motors(target, pl_data);
+        }
+
+        auto n_axis = Axes::_numberAxis;
+
+        float delta[MAX_N_AXIS];
+        for (size_t axis = 0; axis < n_axis; axis++) {
+            delta[axis] = target[axis] - position[axis];
+        }
+        float    path          = sqrtf(delta[X_AXIS] * delta[X_AXIS] + delta[Y_AXIS] * delta[Y_AXIS] + delta[Z_AXIS] * delta[Z_AXIS]);
+        float    rotary        = fabsf(delta[_rotary_axis]);
+        float    tilt          = fabsf(delta[_tilt_axis]);
+        float    count         = std::max(ceilf(path / _segment_length), ceilf(std::max(rotary, tilt) / _segment_degrees));
+        uint32_t segment_count = count < 1.0f ? 1 : uint32_t(count);
+
+        // The programmed feed applies to the tool path over the part.  A move of the
+        // rotary axes alone is fed in degrees per minute.
+        plan_line_data_t segment_data = *pl_data;
+        pl_data->outputs_mask         = 0;  // The first segment carries the M62/M63 outputs
+        pl_data->output_changes.count = 0;  // and the segments carry the Q changes along
+        if (!pl_data->motion.rapidMotion) {
+            float minutes;
+            if (pl_data->motion.inverseTime) {
+                minutes = 1.0f / pl_data->feed_rate;
+            } else {
+                float distance = path > 0.0f ? path : sqrtf(rotary * rotary + tilt * tilt);
+                minutes        = distance / pl_data->feed_rate;
+            }
+            if (minutes > 0.0f) {
+                segment_data.motion.inverseTime = 1;
+                segment_data.feed_rate          = segment_count / minutes;
+            }
+        }
+
+        float part[MAX_N_AXIS];
+        float motors[MAX_N_AXIS];
+        for (uint32_t segment = 1; segment <= segment_count; segment++) {
+            if (sys.abort) {
+                return true;
+            }
+            float fraction = float(segment) / segment_count;
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                part[axis] = segment == segment_count ? target[axis] : position[axis] + delta[axis] * fraction;
+            }
+            part_to_machine(part, motors);
+
+            // mc_move_motors() returns false if a jog is cancelled.
+            // In that case we stop sending segments to the planner.
+            if (!mc_move_motors(motors, &segment_data)) {
+                return false;
+            }
+        }
+        pl_data->output_changes = segment_data.output_changes;  // Those past the end
+        return true;
+    }
+
+    // Configuration registration
+    namespace {
+        KinematicsFactory::InstanceBuilder<Trunnion> registration("Trunnion");
+    }
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+	Trunnion.h
+
+	Tool center point control (RTCP) for a table-table five axis machine: a table that
+	turns about its own Z axis (the rotary axis, usually C) carried by a trunnion that
+	tilts about the machine X axis (the tilt axis, usually A).
+
+	With G43.4 active, X, Y and Z are the tool position in the frame of the part on the
+	table and the kinematics move the linear axes to follow the part as it turns.
+	Otherwise the machine is Cartesian.
+*/
+
+#include "Cartesian.h"
+
+namespace Kinematics {
+    class Trunnion : public Cartesian {
+    public:
+        Trunnion(const char* name) : Cartesian(name) {}
+
+        Trunnion(const Trunnion&)            = delete;
+        Trunnion(Trunnion&&)                 = delete;
+        Trunnion& operator=(const Trunnion&) = delete;
+        Trunnion& operator=(Trunnion&&)      = delete;
+
+        // Kinematic Interface
+        void init() override;
+        bool cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) override;
+        void motors_to_cartesian(float* cartesian, float* motors, int n_axis) override;
+        bool transform_cartesian_to_motors(float* motors, float* cartesian) override;
+        bool transform_n(const float* cartesian, float* motors, size_t n) override;
+        bool native_arcs() override { return false; }
+        bool invalid_line(float* cartesian) override;
+        bool invalid_arc(float*            target,
+                         plan_line_data_t* pl_data,
+                         float*            position,
+                         float             center[3],
+                         float             radius,
+                         size_t            caxes[3],
+                         bool              is_clockwise_arc) override;
+
+        // Configuration handlers:
+        void group(Configuration::HandlerBase& handler) override;
+        void validate() override;
+
+        ~Trunnion() {}
+
+    private:
+        bool tcp_active();
+        void part_to_machine(const float* part, float* machine);
+        void machine_to_part(const float* machine, float* part);
+
+        int   _tilt_axis   = 3;  // A, about X
+        int   _rotary_axis = 5;  // C, about the table Z
+        float _pivot[3]    = { 0.0, 0.0, 0.0 };  // Machine position where the two axes cross
+
+        float _segment_length  = 1.0;  // mm of tool path per segment
+        float _segment_degrees = 1.0;  // of either rotary axis per segment
+    };
+}  //  namespace Kinematics
@@ -15,6 +15,8 @@ namespace Kinematics {
         handler.item("right_anchor_y", _right_anchor_y);
 
         handler.item("segment_length", _segment_length);
+        handler.item("min_segment_length", _min_segment_length);
+        handler.item("segments_per_second", _segments_per_second, 0.0, 1000.0);
     }
 
     void WallPlotter::init() {
@@ -80,12 +82,10 @@ namespace Kinematics {
         // Z axis is the same in both coord systems, so it does not undergo conversion
         float xydist = vector_distance(target, position, 2);  // Only compute distance for both axes. X and Y
         // Segment our G1 and G0 moves based on yaml file. If we choose a small enough _segment_length we can hide the nonlinearity
-        segment_count = xydist / _segment_length;
-        if (segment_count < 1) {  // Make sure there is at least one segment, even if there is no movement
-            // We need to do this to make sure other things like S and M codes get updated properly by
-            // the planner even if there is no movement??
-            segment_count = 1;
-        }
+        // There is always at least one segment, even if there is no movement, so that other things
+        // like S and M codes get updated properly by the planner.
+        segment_count =
+            ::Kinematics::segment_count(xydist, _segment_length, _min_segment_length, _segments_per_second, target, position, pl_data);
         float cartesian_segment_length = total_cartesian_distance / segment_count;
 
         // Calc length of each cartesian segment - the same for all segments
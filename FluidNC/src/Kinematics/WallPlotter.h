@@ -56,5 +56,8 @@ namespace Kinematics {
         float _right_anchor_x = 100;
         float _right_anchor_y = 100;
         float _segment_length = 10;
+
+        float _min_segment_length  = 1;  // With _segments_per_second, the shortest segment
+        float _segments_per_second = 0;  // 0 splits by length only
     };
 }  //  namespace Kinematics
@@ -0,0 +1,152 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Workspace.h - a convex XYZ volume for soft limits
+
+  The volume is the intersection of a box, an optional vertical cylinder and any number
+  of half spaces n . p <= d.  Because it is convex, a straight line is inside exactly
+  when both of its ends are, so a programmed move costs two point tests, and a jog is
+  clipped to the volume in one pass over the faces instead of by stepping back from the
+  target.  The bounding box of the whole volume is computed when the shape is set, so
+  most points far outside are rejected by the first comparisons.
+
+  The math has no dependencies so that it can be checked on the host.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Kinematics {
+    class Workspace {
+        struct Plane {
+            float n[3];
+            float d;
+        };
+
+        float              _lo[3]     = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };  // The box
+        float              _hi[3]     = { HUGE_VALF, HUGE_VALF, HUGE_VALF };
+        float              _bLo[3]    = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };  // The bounding box of the volume
+        float              _bHi[3]    = { HUGE_VALF, HUGE_VALF, HUGE_VALF };
+        float              _center[2] = { 0.0f, 0.0f };
+        float              _radius    = 0.0f;  // 0 for no cylinder
+        std::vector<Plane> _planes;
+
+        void bound() {
+            for (int axis = 0; axis < 3; ++axis) {
+                _bLo[axis] = _lo[axis];
+                _bHi[axis] = _hi[axis];
+            }
+            if (_radius > 0.0f) {
+                for (int axis = 0; axis < 2; ++axis) {
+                    _bLo[axis] = std::fmax(_bLo[axis], _center[axis] - _radius);
+                    _bHi[axis] = std::fmin(_bHi[axis], _center[axis] + _radius);
+                }
+            }
+        }
+
+    public:
+        // Axes that are not limited hold +-HUGE_VALF
+        void set_box(const float* lo, const float* hi) {
+            for (int axis = 0; axis < 3; ++axis) {
+                _lo[axis] = lo[axis];
+                _hi[axis] = hi[axis];
+            }
+            bound();
+        }
+
+        void set_cylinder(float x, float y, float radius) {
+            _center[0] = x;
+            _center[1] = y;
+            _radius    = radius;
+            bound();
+        }
+
+        // Keeps the side where n . p <= d; false if n is zero
+        bool add_plane(float nx, float ny, float nz, float d) {
+            float length = sqrtf(nx * nx + ny * ny + nz * nz);
+            if (!(length > 0.0f)) {
+                return false;
+            }
+            _planes.push_back({ { nx / length, ny / length, nz / length }, d / length });
+            return true;
+        }
+
+        bool contains(const float* p) const {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (!(p[axis] >= _bLo[axis] && p[axis] <= _bHi[axis])) {
+                    return false;
+                }
+            }
+            if (_radius > 0.0f) {
+                float dx = p[0] - _center[0];
+                float dy = p[1] - _center[1];
+                if (dx * dx + dy * dy > _radius * _radius) {
+                    return false;
+                }
+            }
+            for (const Plane& plane : _planes) {
+                if (plane.n[0] * p[0] + plane.n[1] * p[1] + plane.n[2] * p[2] > plane.d) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // The fraction of the line from start toward end that is inside.  From a start
+        // outside the volume, only a line that ends inside is allowed, so that a machine
+        // that is out of bounds can be brought back.
+        float clip(const float* start, const float* end) const {
+            if (!contains(start)) {
+                return contains(end) ? 1.0f : 0.0f;
+            }
+            float d[3] = { end[0] - start[0], end[1] - start[1], end[2] - start[2] };
+            float t    = 1.0f;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (d[axis] > 0.0f) {
+                    t = std::fmin(t, (_bHi[axis] - start[axis]) / d[axis]);
+                } else if (d[axis] < 0.0f) {
+                    t = std::fmin(t, (_bLo[axis] - start[axis]) / d[axis]);
+                }
+            }
+            if (_radius > 0.0f) {
+                float sx = start[0] - _center[0];
+                float sy = start[1] - _center[1];
+                float a  = d[0] * d[0] + d[1] * d[1];
+                if (a > 0.0f) {
+                    // |s + t d| = r at the positive root, since s is inside
+                    float b    = sx * d[0] + sy * d[1];
+                    float c    = sx * sx + sy * sy - _radius * _radius;
+                    float disc = std::fmax(b * b - a * c, 0.0f);
+                    t          = std::fmin(t, (-b + sqrtf(disc)) / a);
+                }
+            }
+            for (const Plane& plane : _planes) {
+                float rate = plane.n[0] * d[0] + plane.n[1] * d[1] + plane.n[2] * d[2];
+                if (rate > 0.0f) {
+                    float room = plane.d - (plane.n[0] * start[0] + plane.n[1] * start[1] + plane.n[2] * start[2]);
+                    t          = std::fmin(t, room / rate);
+                }
+            }
+            return std::fmax(t, 0.0f);
+        }
+
+        // Whether the box around an arc, center +-radius in the circle plane and spanning
+        // lo..hi along the third axis, is inside.  If so the arc is too.
+        bool contains_arc(const float* center, float radius, float lo, float hi, const size_t* caxes) const {
+            for (int corner = 0; corner < 8; ++corner) {
+                float p[3];
+                p[caxes[0]] = center[0] + ((corner & 1) ? radius : -radius);
+                p[caxes[1]] = center[1] + ((corner & 2) ? radius : -radius);
+                p[caxes[2]] = (corner & 4) ? hi : lo;
+                if (!contains(p)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
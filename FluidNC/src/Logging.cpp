@@ -6,19 +6,62 @@
 #include "Serial.h"
 #include "SettingsDefinitions.h"
 #include "Channel.h"
+#include "HeapStats.h"
 
 const EnumItem messageLevels2[] = { { MsgLevelNone, "None" }, { MsgLevelError, "Error" }, { MsgLevelWarning, "Warn" },
                                     { MsgLevelInfo, "Info" }, { MsgLevelDebug, "Debug" }, { MsgLevelVerbose, "Verbose" },
                                     EnumItem(MsgLevelNone) };
 
+#include <atomic>
+
 bool atMsgLevel(MsgLevel level) {
     return message_level == nullptr || message_level->get() >= level;
 }
 
-LogStream::LogStream(Channel& channel, MsgLevel level) : _channel(channel), _level(level) {
-    _line = new std::string();
+bool atMsgLevel(Channel& out, MsgLevel level) {
+    return out._message_level >= level && atMsgLevel(level);
+}
+
+static LogMessage            log_slots[LogMessage::slots];
+static xQueueHandle          free_slots;
+static std::atomic<uint32_t> dropped { 0 };
+
+void log_init() {
+    message_queue = xQueueCreate(LogMessage::slots, sizeof(LogMessage*));
+    free_slots    = xQueueCreate(LogMessage::slots, sizeof(LogMessage*));
+    for (auto& slot : log_slots) {
+        LogMessage* p = &slot;
+        xQueueSend(free_slots, &p, 0);
+    }
+}
+
+LogMessage* log_acquire(MsgLevel level) {
+    LogMessage* message;
+    if (!xQueueReceive(free_slots, &message, level == MsgLevelNone ? portMAX_DELAY : 0)) {
+        ++dropped;
+        return nullptr;
+    }
+    return message;
+}
+
+void log_send(LogMessage* message) {
+    // Cannot block; the queue has room for every slot
+    xQueueSend(message_queue, &message, portMAX_DELAY);
 }
 
+void log_release(LogMessage* message) {
+    if (message->kind == LogMessage::String) {
+        delete static_cast<const std::string*>(message->line);
+    }
+    xQueueSend(free_slots, &message, 0);
+}
+
+uint32_t log_dropped() {
+    return dropped;
+}
+
+LogStream::LogStream(Channel& channel, MsgLevel level) : _channel(channel), _level(level) {}
+
 LogStream::LogStream(Channel& channel, MsgLevel level, const char* name) : LogStream(channel, level) {
     print(name);
 }
@@ -27,13 +70,26 @@ LogStream::LogStream(Channel& channel, const char* name) : LogStream(channel, Ms
 LogStream::LogStream(MsgLevel level, const char* name) : LogStream(allChannels, level, name) {}
 
 size_t LogStream::write(uint8_t c) {
-    *_line += (char)c;
+    if (_line) {
+        *_line += (char)c;
+    } else if (_length < LogMessage::maxText - 1) {
+        _text[_length++] = c;
+    } else {
+        HeapScope scope(HeapTag::Logging);
+        _line = new std::string(_text, _length);
+        *_line += (char)c;
+    }
     return 1;
 }
 
 LogStream::~LogStream() {
-    if ((*_line).length() && (*_line)[0] == '[') {
-        *_line += ']';
+    HeapScope scope(HeapTag::Logging);
+    if (_length && _text[0] == '[') {
+        write(']');
+    }
+    if (_line) {
+        _channel.sendLine(_level, _line);
+    } else {
+        _channel.sendLine(_level, std::string_view(_text, _length));
     }
-    _channel.sendLine(_level, _line);
 }
@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <string_view>
 #include "EnumItem.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
@@ -20,17 +23,48 @@ enum MsgLevel {
     MsgLevelVerbose = 5,
 };
 
+// Output for the output task travels in a fixed pool of slots, so sending a
+// message does not allocate.  Short lines are copied into the slot; a fixed string
+// or a long heap string is passed by pointer.  message_queue carries full slots to
+// the output task in order, and free slots return to a second queue.
 struct LogMessage {
-    Channel* channel;
-    void*    line;
-    MsgLevel level;
-    bool     isString;
+    static const size_t maxText = 128;
+    static const size_t slots   = 32;
+
+    enum Kind : uint8_t {
+        Text,    // In text[]
+        Fixed,   // line is a const char* that need not be freed
+        String,  // line is a std::string* that the output task deletes
+        Binary,  // length bytes in text[], written as they are, not as a line
+    };
+
+    Channel*    channel;
+    const void* line;
+    MsgLevel    level;
+    Kind        kind;
+    uint16_t    length;  // Of Text
+    char        text[maxText];
+
+    const char* c_str() const {
+        return kind == Text ? text : kind == Fixed ? static_cast<const char*>(line) : static_cast<const std::string*>(line)->c_str();
+    }
 };
 
 extern TaskHandle_t outputTask;
 
 extern xQueueHandle message_queue;
 
+void log_init();
+
+// Returns a free slot, or nullptr if there is none.  Log messages are dropped when
+// the pool is exhausted, rather than stalling the caller, and counted in
+// log_dropped(); protocol output (MsgLevelNone) such as "ok" waits for a slot,
+// because a sender cannot recover from losing it.
+LogMessage* log_acquire(MsgLevel level);
+void        log_send(LogMessage* message);
+void        log_release(LogMessage* message);
+uint32_t    log_dropped();
+
 extern const EnumItem messageLevels2[];
 
 // How to use logging? Well, the basics are pretty simple:
@@ -58,12 +92,29 @@ public:
     ~LogStream();
 
 private:
-    Channel&     _channel;
-    std::string* _line;
-    MsgLevel     _level;
+    Channel& _channel;
+    MsgLevel _level;
+
+    // The line is built in place and moves to the heap only if it outgrows _text.
+    char         _text[LogMessage::maxText];
+    size_t       _length = 0;
+    std::string* _line   = nullptr;
 };
 
+// Messages more verbose than LOG_MIN_LEVEL are compiled out, so their
+// formatting code and string literals do not take up flash.  The default
+// keeps every level; e.g. -DLOG_MIN_LEVEL=3 drops debug and verbose messages.
+#ifndef LOG_MIN_LEVEL
+#    define LOG_MIN_LEVEL MsgLevelVerbose
+#endif
+
+// The level checks come before a LogStream is constructed, so a filtered
+// message costs neither formatting nor a message slot.
 extern bool atMsgLevel(MsgLevel level);
+extern bool atMsgLevel(Channel& out, MsgLevel level);  // Also honors the channel's own level
+
+#define log_enabled(level) ((level) <= LOG_MIN_LEVEL && atMsgLevel(level))
+#define log_enabled_to(out, level) ((level) <= LOG_MIN_LEVEL && atMsgLevel(out, level))
 
 // clang-format off
 
@@ -71,20 +122,20 @@ extern bool atMsgLevel(MsgLevel level);
 
 // #define log_bare(prefix, x) { LogStream ss(prefix); ss << x; }
 #define log_msg(x) { LogStream ss(MsgLevelNone, "[MSG:"); ss << x; }
-#define log_verbose(x) if (atMsgLevel(MsgLevelVerbose)) { LogStream ss(MsgLevelVerbose, "[MSG:VRB: "); ss << x; }
-#define log_debug(x) if (atMsgLevel(MsgLevelDebug)) { LogStream ss(MsgLevelDebug, "[MSG:DBG: "); ss << x; }
-#define log_info(x) if (atMsgLevel(MsgLevelInfo)) { LogStream ss(MsgLevelInfo, "[MSG:INFO: "); ss << x; }
-#define log_warn(x) if (atMsgLevel(MsgLevelWarning)) { LogStream ss(MsgLevelWarning, "[MSG:WARN: "); ss << x; }
-#define log_error(x) if (atMsgLevel(MsgLevelError)) { LogStream ss(MsgLevelError, "[MSG:ERR: "); ss << x; }
-#define log_config_error(x) if (atMsgLevel(MsgLevelError)) { LogStream ss(MsgLevelError, "[MSG:ERR: "); ss << x; set_state(State::ConfigAlarm); }
+#define log_verbose(x) if (log_enabled(MsgLevelVerbose)) { LogStream ss(MsgLevelVerbose, "[MSG:VRB: "); ss << x; }
+#define log_debug(x) if (log_enabled(MsgLevelDebug)) { LogStream ss(MsgLevelDebug, "[MSG:DBG: "); ss << x; }
+#define log_info(x) if (log_enabled(MsgLevelInfo)) { LogStream ss(MsgLevelInfo, "[MSG:INFO: "); ss << x; }
+#define log_warn(x) if (log_enabled(MsgLevelWarning)) { LogStream ss(MsgLevelWarning, "[MSG:WARN: "); ss << x; }
+#define log_error(x) if (log_enabled(MsgLevelError)) { LogStream ss(MsgLevelError, "[MSG:ERR: "); ss << x; }
+#define log_config_error(x) if (log_enabled(MsgLevelError)) { LogStream ss(MsgLevelError, "[MSG:ERR: "); ss << x; set_state(State::ConfigAlarm); }
 #define log_fatal(x) { LogStream ss(MsgLevelNone, "[MSG:FATAL: "); ss << x;  Assert(false, "A fatal error occurred."); }
 
 #define log_msg_to(out, x) { LogStream ss(out, MsgLevelNone, "[MSG:"); ss << x; }
-#define log_verbose_to(out, x) if (atMsgLevel(MsgLevelVerbose)) { LogStream ss(out, MsgLevelVerbose, "[MSG:VRB: "); ss << x; }
-#define log_debug_to(out, x) if (atMsgLevel(MsgLevelDebug)) { LogStream ss(out, MsgLevelDebug, "[MSG:DBG: "); ss << x; }
-#define log_info_to(out, x) if (atMsgLevel(MsgLevelInfo)) { LogStream ss(out, MsgLevelInfo, "[MSG:INFO: "); ss << x; }
-#define log_warn_to(out, x) if (atMsgLevel(MsgLevelWarning)) { LogStream ss(out, MsgLevelWarning, "[MSG:WARN: "); ss << x; }
-#define log_error_to(out, x) if (atMsgLevel(MsgLevelError)) { LogStream ss(out, MsgLevelError, "[MSG:ERR: "); ss << x; }
+#define log_verbose_to(out, x) if (log_enabled_to(out, MsgLevelVerbose)) { LogStream ss(out, MsgLevelVerbose, "[MSG:VRB: "); ss << x; }
+#define log_debug_to(out, x) if (log_enabled_to(out, MsgLevelDebug)) { LogStream ss(out, MsgLevelDebug, "[MSG:DBG: "); ss << x; }
+#define log_info_to(out, x) if (log_enabled_to(out, MsgLevelInfo)) { LogStream ss(out, MsgLevelInfo, "[MSG:INFO: "); ss << x; }
+#define log_warn_to(out, x) if (log_enabled_to(out, MsgLevelWarning)) { LogStream ss(out, MsgLevelWarning, "[MSG:WARN: "); ss << x; }
+#define log_error_to(out, x) if (log_enabled_to(out, MsgLevelError)) { LogStream ss(out, MsgLevelError, "[MSG:ERR: "); ss << x; }
 #define log_fatal_to(out, x) { LogStream ss(out, MsgLevelNone, "[MSG:FATAL: "); ss << x;  Assert(false, "A fatal error occurred."); }
 
 // #define log_to(out, prefix, x) { LogStream ss(out, MsgLevelNone, prefix); ss << x; }
@@ -1,6 +1,7 @@
 #include "Axes.h"
 
 #include "../Motors/MotorDriver.h"
+#include "../FastPin.h"
 #include "../Motors/NullMotor.h"
 #include "../Config.h"
 #include "../MotionControl.h"
@@ -23,14 +24,84 @@ namespace Machine {
     Pin Axes::_sharedStepperDisable;
     Pin Axes::_sharedStepperReset;
 
-    uint32_t Axes::_homing_runs = 2;  // Number of Approach/Pulloff cycles
+    uint32_t Axes::_homing_runs     = 2;  // Number of Approach/Pulloff cycles
+    uint32_t Axes::_limitDebounceUs = 0;
 
     int Axes::_numberAxis = 0;
 
     Axis* Axes::_axis[MAX_N_AXIS] = { nullptr };
 
+    namespace {
+        // The set or clear registers, and the bits in each, that switch a group of
+        // disable pins.  Pins on the same GPIO bank share a register, so a write to
+        // all of the motors is usually one or two stores.
+        struct PinGroupWrite {
+            static const int   maxRegs = 4;
+            volatile uint32_t* reg[maxRegs];
+            uint32_t           mask[maxRegs];
+            int                count = 0;
+
+            bool add(volatile uint32_t* r, uint32_t m) {
+                for (int i = 0; i < count; i++) {
+                    if (reg[i] == r) {
+                        mask[i] |= m;
+                        return true;
+                    }
+                }
+                if (count == maxRegs) {
+                    return false;
+                }
+                reg[count]  = r;
+                mask[count] = m;
+                count++;
+                return true;
+            }
+
+            void IRAM_ATTR write() const {
+                for (int i = 0; i < count; i++) {
+                    *reg[i] = mask[i];
+                }
+            }
+        };
+
+        PinGroupWrite enableWrites[MAX_N_AXIS];
+        PinGroupWrite disableWrites[MAX_N_AXIS];
+        PinGroupWrite allEnable;
+        PinGroupWrite allDisable;
+        MotorMask     groupedMotors = 0;  // Motors whose disable pin is in the writes above
+    }
+
     Axes::Axes() {}
 
+    void Axes::group_disable_pins() {
+        for (size_t axis = X_AXIS; axis < _numberAxis; axis++) {
+            enableWrites[axis]  = PinGroupWrite();
+            disableWrites[axis] = PinGroupWrite();
+        }
+        allEnable     = PinGroupWrite();
+        allDisable    = PinGroupWrite();
+        groupedMotors = 0;
+
+        for (size_t axis = X_AXIS; axis < _numberAxis; axis++) {
+            for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
+                auto m = _axis[axis] ? _axis[axis]->_motors[motor] : nullptr;
+                if (!m) {
+                    continue;
+                }
+                auto pin = m->_driver->disable_pin();
+                if (!pin) {
+                    continue;
+                }
+                auto& regs = pin->regs();
+                // A pin that does not fit in either group stays with its driver
+                if (enableWrites[axis].add(regs.off, regs.mask) && disableWrites[axis].add(regs.on, regs.mask) &&
+                    allEnable.add(regs.off, regs.mask) && allDisable.add(regs.on, regs.mask)) {
+                    set_bitnum(groupedMotors, motor_bit(axis, motor));
+                }
+            }
+        }
+    }
+
     void Axes::init() {
         log_info("Axis count " << Axes::_numberAxis);
 
@@ -58,23 +129,44 @@ namespace Machine {
             }
         }
 
-        config_motors();
+        group_disable_pins();
+
+        start_config_motors();
     }
 
-    void IRAM_ATTR Axes::set_disable(int axis, bool disable) {
+    void IRAM_ATTR Axes::set_disable_ungrouped(int axis, bool disable) {
         for (int motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
             auto m = _axis[axis]->_motors[motor];
-            if (m) {
+            if (m && !bitnum_is_true(groupedMotors, motor_bit(axis, motor))) {
                 m->_driver->set_disable(disable);
             }
         }
+    }
+
+    void IRAM_ATTR Axes::set_disable(int axis, bool disable) {
+        (disable ? disableWrites : enableWrites)[axis].write();
+        set_disable_ungrouped(axis, disable);
         if (disable)  // any disable, !disable does not change anything here
             disabled = true;
     }
 
     void IRAM_ATTR Axes::set_disable(bool disable) {
-        for (int axis = 0; axis < _numberAxis; axis++) {
-            set_disable(axis, disable);
+        if (!disable && disabled && Stepping::_enableStaggerUsecs) {
+            for (int axis = 0; axis < _numberAxis; axis++) {
+                if (axis) {
+                    delay_us(Stepping::_enableStaggerUsecs);
+                }
+                enableWrites[axis].write();
+                set_disable_ungrouped(axis, false);
+            }
+        } else {
+            (disable ? allDisable : allEnable).write();
+            for (int axis = 0; axis < _numberAxis; axis++) {
+                set_disable_ungrouped(axis, disable);
+            }
+            if (disable) {
+                disabled = true;
+            }
         }
 
         _sharedStepperDisable.synchronousWrite(disable);
@@ -113,11 +205,22 @@ namespace Machine {
     }
 
     void Axes::config_motors() {
+        start_config_motors();
+        wait_config_motors();
+    }
+
+    void Axes::start_config_motors() {
         for (int axis = 0; axis < _numberAxis; ++axis) {
             _axis[axis]->config_motors();
         }
     }
 
+    void Axes::wait_config_motors() {
+        for (int axis = 0; axis < _numberAxis; ++axis) {
+            _axis[axis]->wait_config_motors();
+        }
+    }
+
     // Some small helpers to find the axis index and axis motor index for a given motor. This
     // is helpful for some motors that need this info, as well as debug information.
     size_t Axes::findAxisIndex(const MotorDrivers::MotorDriver* const driver) {
@@ -155,8 +258,9 @@ namespace Machine {
         handler.item("shared_stepper_disable_pin", _sharedStepperDisable);
         handler.item("shared_stepper_reset_pin", _sharedStepperReset);
         handler.item("homing_runs", _homing_runs, 1, 5);
+        handler.item("limit_debounce_us", _limitDebounceUs, 0, 20000);
 
-        // Handle axis names xyzabc.  handler.section is inferred
+        // Handle axis names xyzabcuvw.  handler.section is inferred
         // from a template.
         char tmp[3];
         tmp[2] = '\0';
@@ -17,7 +17,7 @@ namespace Machine {
         bool _switchedStepper = false;
 
     public:
-        static constexpr const char* _names = "XYZABC";
+        static constexpr const char* _names = "XYZABCUVW";
 
         Axes();
 
@@ -34,7 +34,8 @@ namespace Machine {
         static Pin _sharedStepperDisable;
         static Pin _sharedStepperReset;
 
-        static uint32_t _homing_runs;  // Number of Approach/Pulloff cycles
+        static uint32_t _homing_runs;      // Number of Approach/Pulloff cycles
+        static uint32_t _limitDebounceUs;  // Time a limit switch must stay active before it stops a motor
 
         static inline char axisName(int index) { return index < MAX_N_AXIS ? _names[index] : '?'; }  // returns axis letter
 
@@ -72,12 +73,24 @@ namespace Machine {
         // The return value is a bitmask of axes that can home
         static MotorMask set_homing_mode(AxisMask homing_mask, bool isHoming);
 
+        // Disable pins that are native GPIOs are written together, one store per GPIO
+        // register, and other motors through their drivers.  With enable_stagger_us,
+        // enabling the motors after they were disabled goes one axis at a time, that far
+        // apart, to spread the inrush current; motion then starts at most
+        // (axes - 1) * enable_stagger_us + disable_delay_us later.
         static void set_disable(int axis, bool disable);
         static void set_disable(bool disable);
-        static void step(uint8_t step_mask, uint8_t dir_mask);
+        static void set_disable_ungrouped(int axis, bool disable);
+        static void group_disable_pins();
+        static void step(AxisMask step_mask, AxisMask dir_mask);
         static void unstep();
         static void config_motors();
 
+        // At startup, the motors are configured while the other subsystems start,
+        // and setup() waits for them before motion can begin
+        static void start_config_motors();
+        static void wait_config_motors();
+
         static std::string maskToNames(AxisMask mask);
 
         static bool namesToMask(const char* names, AxisMask& mask);
@@ -5,13 +5,24 @@
 #include <cstring>
 
 namespace Machine {
+    static const EnumItem shaperTypes[] = { { InputShaper::None, "None" },
+                                            { InputShaper::ZV, "ZV" },
+                                            { InputShaper::ZVD, "ZVD" },
+                                            { InputShaper::MZV, "MZV" },
+                                            EnumItem(InputShaper::None) };
+
     void Axis::group(Configuration::HandlerBase& handler) {
         handler.item("steps_per_mm", _stepsPerMm, 0.001, 100000.0);
         handler.item("max_rate_mm_per_min", _maxRate, 0.001, 250000.0);
         handler.item("acceleration_mm_per_sec2", _acceleration, 0.001, 100000.0);
+        handler.item("max_jerk_mm_per_sec3", _maxJerk, 0.0, 100000000.0);
+        handler.item("shaper_type", _shaperType, shaperTypes);
+        handler.item("shaper_freq_hz", _shaperFreq, 5.0, 200.0);
         handler.item("max_travel_mm", _maxTravel, 0.1, 10000000.0);
         handler.item("soft_limits", _softLimits);
+        handler.item("backlash_mm", _backlash, 0.0, 10.0);
         handler.section("homing", _homing);
+        handler.section("encoder", _encoder, _axis);
 
         char tmp[7];
         tmp[0] = 0;
@@ -46,6 +57,9 @@ namespace Machine {
             _homing->init();
             set_bitnum(Axes::homingMask, _axis);
         }
+        if (_encoder) {
+            _encoder->init();
+        }
 
         if (!_motors[0] && _motors[1]) {
             log_config_error("motor1 defined without motor0");
@@ -67,6 +81,14 @@ namespace Machine {
         }
     }
 
+    void Axis::wait_config_motors() {
+        for (int motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; ++motor) {
+            auto mot = _motors[motor];
+            if (mot)
+                mot->wait_config();
+        }
+    }
+
     // Checks if a motor matches this axis:
     bool Axis::hasMotor(const MotorDrivers::MotorDriver* const driver) const {
         for (size_t i = 0; i < MAX_MOTORS_PER_AXIS; i++) {
@@ -121,5 +143,6 @@ namespace Machine {
                 delete _motors[i];
             }
         }
+        delete _encoder;
     }
 }
@@ -8,6 +8,8 @@
 // #include "Axes.h"
 #include "Motor.h"
 #include "Homing.h"
+#include "Encoder.h"
+#include "../InputShaper.h"
 
 namespace MotorDrivers {
     class MotorDriver;
@@ -28,13 +30,18 @@ namespace Machine {
         static const int MAX_MOTORS_PER_AXIS = 2;
 
         Motor*  _motors[MAX_MOTORS_PER_AXIS];
-        Homing* _homing = nullptr;
+        Homing*  _homing  = nullptr;
+        Encoder* _encoder = nullptr;
 
         float _stepsPerMm   = 80.0f;
         float _maxRate      = 1000.0f;
         float _acceleration = 25.0f;
+        float _maxJerk      = 0.0f;
+        int   _shaperType   = InputShaper::None;
+        float _shaperFreq   = 40.0f;
         float _maxTravel    = 1000.0f;
         bool  _softLimits   = false;
+        float _backlash     = 0.0f;  // mm of slack taken up when the axis reverses
 
         // Configuration system helpers:
         void group(Configuration::HandlerBase& handler) override;
@@ -49,6 +56,7 @@ namespace Machine {
 
         void init();
         void config_motors();
+        void wait_config_motors();
 
         ~Axis();
     };
@@ -0,0 +1,165 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Encoder.h"
+
+#include "Axes.h"
+#include "MachineConfig.h"  // config
+#include "src/Module.h"
+#include "src/MotionControl.h"  // mc_critical
+#include "src/Planner.h"
+#include "src/Protocol.h"
+#include "src/System.h"
+
+#include "Driver/PulseCounter.h"
+
+#include <atomic>
+#include <cmath>
+
+namespace Machine {
+    void Encoder::group(Configuration::HandlerBase& handler) {
+        handler.item("a_pin", _a_pin);
+        handler.item("b_pin", _b_pin);
+        handler.item("counts_per_mm", _countsPerMm, 0.001, 1000000.0);
+        handler.item("max_error_mm", _maxErrorMm, 0.001, 100.0);
+        handler.item("max_correction_mm", _maxCorrectionMm, 0.0, 100.0);
+    }
+
+    void Encoder::init() {
+        if (_a_pin.undefined() || _b_pin.undefined()) {
+            log_config_error("Encoder on axis " << Axes::axisName(_axis) << " needs a_pin and b_pin");
+            return;
+        }
+        _a_pin.setAttr(Pin::Attr::Input);
+        _b_pin.setAttr(Pin::Attr::Input);
+        _counter = new QuadratureCounter(_a_pin, _b_pin);
+        rereference();
+        log_info("    Encoder A:" << _a_pin.name() << " B:" << _b_pin.name() << " counts/mm:" << _countsPerMm);
+    }
+
+    void Encoder::rereference() {
+        if (_counter) {
+            _refSteps  = get_axis_motor_steps(_axis);
+            _refCounts = _counter->position();
+            _exceeded  = false;
+        }
+    }
+
+    float Encoder::error_mm() {
+        // Read the steps first; the count is the later one if the axis moves between them
+        int32_t steps      = get_axis_motor_steps(_axis);
+        int32_t counts     = _counter->position();
+        float   stepsPerMm = config->_axes->_axis[_axis]->_stepsPerMm;
+        return (counts - _refCounts) / _countsPerMm - (steps - _refSteps) / stepsPerMm;
+    }
+
+    int32_t Encoder::encoder_steps() {
+        float stepsPerMm = config->_axes->_axis[_axis]->_stepsPerMm;
+        return _refSteps + int32_t(lroundf((_counter->position() - _refCounts) * stepsPerMm / _countsPerMm));
+    }
+
+    bool Encoder::correctable() {
+        if (!_counter || !state_is(State::Idle)) {
+            return false;
+        }
+        float error = fabsf(error_mm());
+        return error > _maxErrorMm && error <= _maxCorrectionMm;
+    }
+
+    bool Encoder::check() {
+        // Homing stops against switches, and sets the position when it is done
+        if (!_counter || !(state_is(State::Idle) || state_is(State::Cycle) || state_is(State::Hold) || state_is(State::Jog))) {
+            _exceeded = false;
+            return false;
+        }
+        float error = error_mm();
+        if (fabsf(error) <= _maxErrorMm) {
+            _exceeded = false;
+            return false;
+        }
+
+        // The count can be read just after the counter reaches a limit and before the
+        // interrupt that carries it, so act only on an error seen twice in a row.
+        if (!_exceeded) {
+            _exceeded = true;
+            return false;
+        }
+        _exceeded = false;
+
+        if (state_is(State::Idle) && fabsf(error) <= _maxCorrectionMm) {
+            return true;
+        }
+        log_error(Axes::axisName(_axis) << " axis encoder is " << error << "mm from the commanded position");
+        mc_critical(ExecAlarm::StepLoss);
+        Homing::set_axis_unhomed(_axis);
+        rereference();
+        return false;
+    }
+
+    Encoder::~Encoder() {
+        delete _counter;
+    }
+
+    // Runs in the protocol task, which owns the planner
+    static std::atomic<bool> correctionPending;
+
+    static void correct_positions() {
+        auto n_axis = Axes::_numberAxis;
+
+        if (state_is(State::Idle) && !plan_get_current_block()) {
+            float target[MAX_N_AXIS];
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                target[axis] = steps_to_mpos(get_axis_motor_steps(axis), axis);
+            }
+
+            // Take each axis to be where its encoder puts it, then move back to the
+            // commanded position.  A system motion leaves the planner position alone.
+            bool corrected = false;
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                auto encoder = config->_axes->_axis[axis]->_encoder;
+                if (encoder && encoder->correctable()) {
+                    log_info("Correcting " << Axes::axisName(axis) << " axis by " << -encoder->error_mm() << "mm");
+                    set_motor_steps(axis, encoder->encoder_steps());
+                    corrected = true;
+                }
+            }
+            if (corrected) {
+                plan_line_data_t plan_data      = {};
+                plan_data.motion.rapidMotion    = 1;
+                plan_data.motion.systemMotion   = 1;
+                plan_data.motion.noFeedOverride = 1;
+                if (plan_buffer_line(target, &plan_data)) {
+                    protocol_send_event(&cycleStartEvent);
+                }
+            }
+        }
+        correctionPending = false;
+    }
+
+    static const NoArgEvent correctEvent { correct_positions, Event::Motion };
+
+    // Checks the encoders each time the polling loop runs
+    class EncoderMonitor : public Module {
+    public:
+        EncoderMonitor(const char* name) : Module(name) {}
+
+        void poll() override {
+            if (!config || !config->_axes) {
+                return;
+            }
+            bool correct = false;
+            auto n_axis  = Axes::_numberAxis;
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                auto encoder = config->_axes->_axis[axis]->_encoder;
+                if (encoder && encoder->check()) {
+                    correct = true;
+                }
+            }
+            if (correct && !correctionPending.exchange(true)) {
+                protocol_send_event(&correctEvent);
+            }
+        }
+    };
+
+    ModuleFactory::InstanceBuilder<EncoderMonitor> encoder_module("encoders", true);
+}
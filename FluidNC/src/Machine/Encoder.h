@@ -0,0 +1,66 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Encoder.h - a quadrature encoder that checks an axis for lost steps
+
+  The commanded step count is otherwise the only record of an axis position.  An
+  encoder on the motor or the carriage is counted in hardware, and the count is
+  compared with the commanded position as the machine runs.  When they differ by
+  more than max_error_mm, the axis is corrected with a short move if the machine
+  is idle and the error is no more than max_correction_mm, and otherwise an alarm
+  stops the machine.  Swap a_pin and b_pin if the count runs the wrong way.
+*/
+
+#include "src/Configuration/Configurable.h"
+#include "src/Pin.h"
+
+class QuadratureCounter;
+
+namespace Machine {
+    class Encoder : public Configuration::Configurable {
+        int _axis;
+
+        Pin   _a_pin;
+        Pin   _b_pin;
+        float _countsPerMm     = 400.0f;  // Edges of A and B per mm of axis travel
+        float _maxErrorMm      = 0.1f;
+        float _maxCorrectionMm = 0.0f;  // 0 raises an alarm for every error
+
+        QuadratureCounter* _counter = nullptr;
+
+        // The encoder count and the commanded steps when they last agreed
+        int32_t _refCounts = 0;
+        int32_t _refSteps  = 0;
+
+        bool _exceeded = false;  // The last check found an error
+
+    public:
+        Encoder(int axis) : _axis(axis) {}
+
+        void init();
+
+        // Takes the current encoder count to be at the commanded position.  Call
+        // when the commanded position is set other than by stepping.
+        void rereference();
+
+        // The encoder position less the commanded position
+        float error_mm();
+
+        // The commanded step count at the encoder position
+        int32_t encoder_steps();
+
+        // Compares the positions, correcting or raising an alarm.  Returns true
+        // if a correction is needed.
+        bool check();
+
+        // True when an idle axis is far enough off, and near enough, to be corrected
+        bool correctable();
+
+        void group(Configuration::HandlerBase& handler) override;
+
+        ~Encoder();
+    };
+}
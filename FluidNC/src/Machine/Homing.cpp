@@ -35,6 +35,7 @@ namespace Machine {
     Homing::Phase   Homing::_phase         = Phase::None;
     AxisMask        Homing::_cycleAxes     = 0;
     AxisMask        Homing::_phaseAxes     = 0;
+    AxisMask        Homing::_rapidAxes     = 0;
     AxisMask        Homing::direction_mask = 0;
     MotorMask       Homing::_cycleMotors   = 0;
     MotorMask       Homing::_phaseMotors;
@@ -43,7 +44,8 @@ namespace Machine {
 
     uint32_t Homing::_runs;
 
-    AxisMask Homing::_unhomed_axes = 0;  // Bitmap of axes whose position is unknown
+    AxisMask Homing::_unhomed_axes    = 0;  // Bitmap of axes whose position is unknown
+    AxisMask Homing::_remembered_axes = 0;
 
     bool Homing::axis_is_homed(size_t axis) {
         return bitnum_is_false(_unhomed_axes, axis);
@@ -53,8 +55,11 @@ namespace Machine {
     }
     void Homing::set_axis_unhomed(size_t axis) {
         set_bitnum(_unhomed_axes, axis);
+        clear_bitnum(_remembered_axes, axis);
     }
     void Homing::set_all_axes_unhomed() {
+        // Startup, reset and hard limits can lose the position even when homing is not required
+        _remembered_axes = 0;
         if (config->_start->_mustHome) {
             _unhomed_axes = Machine::Axes::homingMask;
         }
@@ -68,7 +73,7 @@ namespace Machine {
     }
 
     const char* Homing::_phaseNames[] = {
-        "None", "PrePulloff", "FastApproach", "Pulloff0", "SlowApproach", "Pulloff1", "Pulloff2", "CycleDone",
+        "None", "PrePulloff", "RapidApproach", "FastApproach", "Pulloff0", "SlowApproach", "Pulloff1", "Pulloff2", "CycleDone",
     };
 
     void Homing::startMove(AxisMask axisMask, MotorMask motors, Phase phase, uint32_t& settle_ms) {
@@ -99,6 +104,12 @@ namespace Machine {
 
     void Homing::cycleStop() {
         log_debug("CycleStop " << phaseName(_phase));
+        if (_phase == RapidApproach) {
+            // Reached the point short of the remembered position without touching a switch
+            Stepper::reset();
+            nextPhase();
+            return;
+        }
         if (approach()) {
             // Cycle stop while approaching means that we did not hit
             // a limit switch in the programmed distance
@@ -186,6 +197,13 @@ namespace Machine {
             float axis_rate;
             float travel;
             switch (phase) {
+                case Machine::Homing::Phase::RapidApproach:
+                    if (bitnum_is_false(_rapidAxes, axis)) {
+                        continue;
+                    }
+                    axis_rate = axisConfig->_maxRate;
+                    travel    = homing->rapidDistance(target[axis]);
+                    break;
                 case Machine::Homing::Phase::FastApproach:
                     axis_rate = homing->_seekRate;
                     travel    = axisConfig->_maxTravel;
@@ -233,6 +251,7 @@ namespace Machine {
                     }
                 } break;
 
+                case Machine::Homing::Phase::RapidApproach:
                 case Machine::Homing::Phase::FastApproach:
                 case Machine::Homing::Phase::SlowApproach:
                     distance[axis] = homing->_positiveDirection ? travel : -travel;
@@ -306,6 +325,23 @@ namespace Machine {
             }
         }
 
+        if (_phase == Phase::RapidApproach) {
+            // Drop the axes that are already within rapid_approach_mm of the remembered position
+            float* mpos = get_mpos();
+            for (int axis = 0; axis < Axes::_numberAxis; axis++) {
+                if (bitnum_is_true(_rapidAxes, axis)) {
+                    float distance = Axes::_axis[axis]->_homing->rapidDistance(mpos[axis]);
+                    if (mpos_to_steps(distance, axis) <= 0) {
+                        clear_bitnum(_rapidAxes, axis);
+                    }
+                }
+            }
+            if (!_rapidAxes) {
+                nextPhase();
+                return;
+            }
+        }
+
         config->_kinematics->releaseMotors(_phaseAxes, _phaseMotors);
 
         startMove(_phaseAxes, _phaseMotors, _phase, _settling_ms);
@@ -321,6 +357,18 @@ namespace Machine {
             return;
         }
 
+        if (_phase == RapidApproach) {
+            // A switch tripped short of the remembered position, so the position was
+            // wrong.  Forget it and home these axes with a full seek.
+            log_info("Homing switch tripped during rapid approach");
+            Stepper::reset();
+            _remembered_axes &= ~_cycleAxes;
+            _rapidAxes = 0;
+            _phase     = PrePulloff;
+            runPhase();
+            return;
+        }
+
         log_debug("Homing limited" << Axes::motorMaskToNames(limited));
 
         bool stop = config->_kinematics->limitReached(_phaseAxes, _phaseMotors, limited);
@@ -356,14 +404,16 @@ namespace Machine {
         }
         // Homing cycle complete! Setup system for normal operation.
         // -------------------------------------------------------------------------------------
-        // Sync gcode parser and planner positions to homed position.
-        gc_sync_position();
-        plan_sync_position();
-
         Stepping::endLowLatency();
 
         if (!sys.abort) {
+            // Sync gcode parser and planner positions to homed position.  This is done
+            // after leaving the Homing state, which kinematics such as a height map use
+            // to tell the homed position from the ordinary one.
             set_state(unhomed_axes() ? State::Alarm : State::Idle);
+            invalidate_mpos();
+            gc_sync_position();
+            plan_sync_position();
             Stepper::go_idle();  // Set steppers to the settings idle state before returning.
         }
     }
@@ -388,6 +438,15 @@ namespace Machine {
         _cycleAxes &= Machine::Axes::homingMask;
         _cycleMotors = Axes::set_homing_mode(_cycleAxes, true);
 
+        _rapidAxes  = 0;
+        auto n_axis = Axes::_numberAxis;
+        for (int axis = 0; axis < n_axis; axis++) {
+            auto homing = Axes::_axis[axis]->_homing;
+            if (bitnum_is_true(_cycleAxes & _remembered_axes, axis) && homing && homing->_rapid_approach_mm > 0) {
+                set_bitnum(_rapidAxes, axis);
+            }
+        }
+
         _phase = Phase::PrePulloff;
         _runs  = Axes::_homing_runs;
         runPhase();
@@ -436,6 +495,7 @@ namespace Machine {
                 auto homing = axes->_axis[axis]->_homing;
                 if (homing) {
                     set_axis_homed(axis);
+                    set_bitnum(_remembered_axes, axis);
                     mpos[axis] = homing->_mpos;
                     homedAxes += axes->axisName(axis);
                 }
@@ -514,7 +574,12 @@ namespace Machine {
                 axisMask = axis_mask_from_cycle(cycle);
 
                 if (axisMask) {  // if there are some axes in this cycle
-                    _remainingCycles.push(axisMask);
+                    if (!_remainingCycles.empty() && overlaps(axisMask)) {
+                        // Home these axes together with the previous cycle
+                        _remainingCycles.back() |= axisMask;
+                    } else {
+                        _remainingCycles.push(axisMask);
+                    }
                 }
             }
         }
@@ -530,6 +595,24 @@ namespace Machine {
         nextCycle();
     }
 
+    // A cycle can overlap the previous one if all of its axes allow it
+    bool Homing::overlaps(AxisMask axisMask) {
+        auto n_axis = Axes::_numberAxis;
+        for (int axis = 0; axis < n_axis; axis++) {
+            if (bitnum_is_true(axisMask, axis) && !Axes::_axis[axis]->_homing->_overlap) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    float Homing::rapidDistance(float mpos) {
+        // The homed position is where the pulloff left the axis, so the switch
+        // is beyond it and the rapid stops short of it
+        float stop = _positiveDirection ? _mpos - _rapid_approach_mm : _mpos + _rapid_approach_mm;
+        return _positiveDirection ? stop - mpos : mpos - stop;
+    }
+
     AxisMask Homing::axis_mask_from_cycle(int cycle) {
         AxisMask axisMask = 0;
         auto     n_axis   = Axes::_numberAxis;
@@ -12,17 +12,19 @@
 namespace Machine {
     class Homing : public Configuration::Configurable {
         static AxisMask _unhomed_axes;
+        static AxisMask _remembered_axes;  // Axes whose switch position is known from an earlier homing
 
     public:
         static enum Phase {
-            None         = 0,
-            PrePulloff   = 1,
-            FastApproach = 2,
-            Pulloff0     = 3,
-            SlowApproach = 4,
-            Pulloff1     = 5,
-            Pulloff2     = 6,
-            CycleDone    = 7,
+            None          = 0,
+            PrePulloff    = 1,
+            RapidApproach = 2,
+            FastApproach  = 3,
+            Pulloff0      = 4,
+            SlowApproach  = 5,
+            Pulloff1      = 6,
+            Pulloff2      = 7,
+            CycleDone     = 8,
         } _phase;
         static uint32_t _runs;
 
@@ -40,7 +42,8 @@ namespace Machine {
         static const int AllCycles     = 0;   // Must be zero.
         static const int set_mpos_only = -1;  // If homing cycle is this value then don't move, just set mpos
 
-        static bool approach() { return _phase == FastApproach || _phase == SlowApproach; }
+        // RapidApproach counts as an approach so that a switch that trips early stops the motor
+        static bool approach() { return _phase == RapidApproach || _phase == FastApproach || _phase == SlowApproach; }
 
         static void fail(ExecAlarm alarm);
         static void cycleStop();
@@ -65,6 +68,8 @@ namespace Machine {
         uint32_t _settle_ms         = 250;     // ms settling time for homing switches after motion
         float    _seek_scaler       = 1.1f;    // multiplied by max travel for max homing distance on first touch
         float    _feed_scaler       = 1.1f;    // multiplier to pulloff for moving to switch after pulloff
+        float    _rapid_approach_mm = 0.0f;    // If nonzero and the position is known, rapid to this far short of _mpos first
+        bool     _overlap           = false;   // Run this cycle together with the previous one when homing all axes
 
         // Configuration system helpers:
         void validate() override { Assert(_cycle >= set_mpos_only, "Homing cycle must be defined"); }
@@ -79,6 +84,8 @@ namespace Machine {
             handler.item("settle_ms", _settle_ms, 0, 1000);
             handler.item("seek_scaler", _seek_scaler, 1.0, 100.0);
             handler.item("feed_scaler", _feed_scaler, 1.0, 100.0);
+            handler.item("rapid_approach_mm", _rapid_approach_mm, 0.0, 100000.0);
+            handler.item("overlap_previous_cycle", _overlap);
         }
 
         void init() {}
@@ -89,6 +96,9 @@ namespace Machine {
 
         static bool needsPulloff2(MotorMask motors);
 
+        // Distance from mpos toward the switch to the point where the rapid approach stops
+        float rapidDistance(float mpos);
+
         static void limitReached();
 
     private:
@@ -98,11 +108,13 @@ namespace Machine {
         static void runPhase();
         static void nextPhase();
         static void nextCycle();
+        static bool overlaps(AxisMask axisMask);
 
         static MotorMask _cycleMotors;  // Motors for this cycle
         static MotorMask _phaseMotors;  // Motors still running in this phase
         static AxisMask  _cycleAxes;    // Axes for this cycle
         static AxisMask  _phaseAxes;    // Axes still active in this phase
+        static AxisMask  _rapidAxes;    // Axes in this cycle that do the RapidApproach phase
 
         static std::queue<int> _remainingCycles;
 
@@ -3,6 +3,7 @@
 
 #include "I2CBus.h"
 #include "Driver/fluidnc_i2c.h"
+#include "Tasks.h"
 
 namespace Machine {
     I2CBus::I2CBus(int busNumber) : _busNumber(busNumber) {}
@@ -30,7 +31,43 @@ namespace Machine {
         _error = i2c_master_init(_busNumber, sdaPin, sclPin, _frequency);
         if (_error) {
             log_error("I2C init failed");
+            return;
         }
+
+        _queue = xQueueCreate(queueDepth, sizeof(I2CTransaction));
+        if (_queue) {
+            Machine::Tasks::create("i2c", busTask, this, &_task);
+        }
+    }
+
+    void I2CBus::busTask(void* arg) {
+        auto           bus = static_cast<I2CBus*>(arg);
+        I2CTransaction transaction;
+        while (true) {
+            if (xQueueReceive(bus->_queue, &transaction, portMAX_DELAY) == pdTRUE) {
+                int result = bus->transfer(transaction);
+                if (transaction.done) {
+                    transaction.done(transaction.arg, result);
+                }
+            }
+        }
+    }
+
+    int I2CBus::transfer(const I2CTransaction& t) {
+        if (t.in_count == 0) {
+            return write(t.address, t.out, t.out_count);
+        }
+        if (t.out_count == 0) {
+            return read(t.address, t.in, t.in_count);
+        }
+        return _error ? -1 : i2c_write_read(_busNumber, t.address, t.out, t.out_count, t.in, t.in_count);
+    }
+
+    bool I2CBus::submit(const I2CTransaction& transaction) {
+        if (_error || !_task) {
+            return false;
+        }
+        return xQueueSend(_queue, &transaction, 0) == pdTRUE;
     }
 
     int I2CBus::write(uint8_t address, const uint8_t* data, size_t count) {
@@ -6,14 +6,39 @@
 #include "../Configuration/Configurable.h"
 
 #include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 class TwoWire;
 
 namespace Machine {
+    // A transfer for I2CBus::submit().  It writes out_count bytes from out, then, if in_count is
+    // not zero, reads in_count bytes into in after a repeated start.  The buffers must stay valid
+    // until done, if set, is called from the bus task with the number of bytes transferred, or -1.
+    struct I2CTransaction {
+        uint8_t        address;
+        const uint8_t* out;
+        size_t         out_count;
+        uint8_t*       in;
+        size_t         in_count;
+        void (*done)(void* arg, int result);
+        void* arg;
+    };
+
     class I2CBus : public Configuration::Configurable {
     private:
         bool _error = false;
 
+        // Submitted transactions, run in order by a low-priority task, so that the devices on the
+        // bus share it without any of their callers waiting for a transfer
+        static const int queueDepth = 24;
+        QueueHandle_t    _queue     = nullptr;
+        TaskHandle_t     _task      = nullptr;
+
+        static void busTask(void* arg);
+        int         transfer(const I2CTransaction& transaction);
+
     public:
         I2CBus(int busNumber);
 
@@ -29,6 +54,10 @@ namespace Machine {
         int write(uint8_t address, const uint8_t* data, size_t count);
         int read(uint8_t address, uint8_t* data, size_t count);
 
+        // Queues a transaction and returns at once.  Returns false, without queueing it, if the
+        // bus failed to start or the queue is full.
+        bool submit(const I2CTransaction& transaction);
+
         ~I2CBus() = default;
     };
 }
@@ -20,6 +20,8 @@ namespace Machine {
         handler.item("data_pin", _data);
         handler.item("ws_pin", _ws);
         handler.item("min_pulse_us", _min_pulse_us);
+        handler.item("dma_buffers", _dma_buffers, 2, 16);
+        handler.item("dma_buffer_samples", _dma_buffer_samples, 16, 1000);
     }
 
     void I2SOBus::init() {
@@ -42,7 +44,9 @@ namespace Machine {
             params.data_pin = _data.getNative(Pin::Capabilities::Output | Pin::Capabilities::Native);
             params.init_val = 0;
 
-            params.min_pulse_us = _min_pulse_us;
+            params.min_pulse_us       = _min_pulse_us;
+            params.dma_buffers        = _dma_buffers;
+            params.dma_buffer_samples = _dma_buffer_samples;
 
             i2s_out_init(&params);
         }
@@ -5,6 +5,9 @@
 #pragma once
 
 #include "../Configuration/Configurable.h"
+#include "Driver/i2s_out.h"  // i2s_out_write_mask
+
+#include <esp_attr.h>  // IRAM_ATTR
 
 namespace Machine {
     class I2SOBus : public Configuration::Configurable {
@@ -17,11 +20,20 @@ namespace Machine {
 
         uint32_t _min_pulse_us = 2;
 
+        // DMA ring for the I2S_STREAM stepping engine.  Deeper rings tolerate more
+        // interrupt latency but delay step pulses by up to the whole ring.
+        uint32_t _dma_buffers        = 4;
+        uint32_t _dma_buffer_samples = 64;
+
         void validate() override;
         void group(Configuration::HandlerBase& handler) override;
 
         void init();
 
+        // Sets the I2SO outputs selected by mask, by I2SO pin number, to the bits of value
+        // in one update of the shift register word.  Safe to call from an ISR.
+        static inline void IRAM_ATTR write_mask(uint32_t mask, uint32_t value) { i2s_out_write_mask(mask, value); }
+
         ~I2SOBus() = default;
     };
 }
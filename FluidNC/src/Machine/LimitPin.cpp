@@ -4,8 +4,20 @@
 
 #include "src/Limits.h"
 #include "src/Protocol.h"  // protocol_send_event_from_ISR()
+#include "src/Report.h"
+#include "Driver/fluidnc_gpio.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>  // portMUX_TYPE
 
 namespace Machine {
+    LimitPin*         LimitPin::_isrPins[MAX_ISR_PINS];
+    int               LimitPin::_nIsrPins = 0;
+    volatile uint32_t LimitPin::_pending  = 0;
+
+    // Serializes the edge interrupts with the stepper ISR, which can preempt them
+    static portMUX_TYPE limit_mux = portMUX_INITIALIZER_UNLOCKED;
+
     LimitPin::LimitPin(Pin& pin, int axis, int motor, int direction, bool& pHardLimits) :
         EventPin(&limitEvent, "Limit"), _axis(axis), _motorNum(motor), _value(false), _pHardLimits(pHardLimits), _pin(&pin) {
         const char* sDir;
@@ -52,6 +64,86 @@ namespace Machine {
         _pin->setAttr(Pin::Attr::Input);
         _pin->registerEvent(static_cast<EventPin*>(this));
         update(get());
+
+        if (_pin->capabilities().has(Pin::Capabilities::Native) && _nIsrPins < MAX_ISR_PINS) {
+            _fast.resolve(*_pin);
+            _isrIndex           = _nIsrPins++;
+            _isrPins[_isrIndex] = this;
+            gpio_add_interrupt(_pin->index(), GPIO_EDGE_ANY, edge_isr, this);
+        }
+    }
+
+    // The polled event path still maintains the limit masks and sends limitEvent.
+    // The interrupt path only sets the limited flags, which is what stops the motor.
+    void IRAM_ATTR LimitPin::limit_from_isr(int64_t now) {
+        if (Homing::approach() || (sys.state != State::Homing && _pHardLimits)) {
+            if (_pLimited != nullptr) {
+                *_pLimited = true;
+            }
+            if (_pExtraLimited != nullptr) {
+                *_pExtraLimited = true;
+            }
+            _lastLatency = uint32_t(now - _edgeUs);
+            if (_lastLatency > _maxLatency) {
+                _maxLatency = _lastLatency;
+            }
+        }
+    }
+
+    // An active edge starts the debounce time over, and an inactive edge cancels it,
+    // so the switch must stay active for the whole time.  With no debounce time, the
+    // switch acts right away.
+    void IRAM_ATTR LimitPin::edge_isr(void* arg) {
+        int64_t   now = esp_timer_get_time();
+        LimitPin* p   = static_cast<LimitPin*>(arg);
+        uint32_t  bit = 1u << p->_isrIndex;
+
+        portENTER_CRITICAL_ISR(&limit_mux);
+        if (p->_fast.read()) {
+            p->_edgeUs = now;
+            if (Axes::_limitDebounceUs == 0) {
+                p->limit_from_isr(esp_timer_get_time());
+            } else {
+                _pending |= bit;
+            }
+        } else {
+            _pending &= ~bit;
+        }
+        portEXIT_CRITICAL_ISR(&limit_mux);
+    }
+
+    void IRAM_ATTR LimitPin::debounce() {
+        if (!_pending) {
+            return;
+        }
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL_ISR(&limit_mux);
+        uint32_t pending = _pending;
+        while (pending) {
+            int i = __builtin_ctz(pending);
+            pending &= pending - 1;
+
+            LimitPin* p = _isrPins[i];
+            if ((now - p->_edgeUs) >= Axes::_limitDebounceUs) {
+                _pending &= ~(1u << i);
+                if (p->_fast.read()) {
+                    p->limit_from_isr(now);
+                }
+            }
+        }
+        portEXIT_CRITICAL_ISR(&limit_mux);
+    }
+
+    void LimitPin::report_latency(Channel& out) {
+        if (_nIsrPins == 0) {
+            return;
+        }
+        log_stream(out, "Limit debounce : " << Axes::_limitDebounceUs << "us");
+        for (int i = 0; i < _nIsrPins; i++) {
+            auto p = _isrPins[i];
+            log_stream(out, p->_legend << " stop latency : " << p->_lastLatency << "us max " << p->_maxLatency << "us");
+        }
     }
 
     void LimitPin::update(bool value) {
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "EventPin.h"
+#include "src/FastPin.h"
+
+#include <cstdint>
+
+class Channel;
 
 namespace Machine {
     class LimitPin : public EventPin {
@@ -27,6 +32,22 @@ namespace Machine {
 
         Pin* _pin;
 
+        // A native GPIO switch also has an edge interrupt that sets the
+        // limited flags without waiting for the pin to be polled.
+        FastPin          _fast;
+        int              _isrIndex    = -1;
+        volatile int64_t _edgeUs      = 0;  // Time of the last active edge
+        uint32_t         _lastLatency = 0;  // Edge to limited flag, in us
+        uint32_t         _maxLatency  = 0;
+
+        static const int         MAX_ISR_PINS = 32;
+        static LimitPin*         _isrPins[MAX_ISR_PINS];
+        static int               _nIsrPins;
+        static volatile uint32_t _pending;  // Bits of _isrPins waiting out the debounce time
+
+        void                  limit_from_isr(int64_t now);
+        static void IRAM_ATTR edge_isr(void* arg);
+
     public:
         LimitPin(Pin& pin, int axis, int motorNum, int direction, bool& phardLimits);
 
@@ -40,6 +61,12 @@ namespace Machine {
 
         bool get() { return _pin->read(); }
 
+        // Called from the stepper ISR to apply switches whose debounce time is up
+        static void debounce();
+
+        // Reports the edge to limit latency of the interrupt-driven switches
+        static void report_latency(Channel& out);
+
         int _axis;
         int _motorNum;
     };
@@ -15,6 +15,10 @@
 
 #include "src/SettingsDefinitions.h"  // config_filename
 #include "src/FileStream.h"
+#include "src/FluidPath.h"
+#include "src/HashFS.h"
+#include "src/System.h"  // sys.state
+#include "src/HeapStats.h"
 
 #include "src/Configuration/Parser.h"
 #include "src/Configuration/ParserHandler.h"
@@ -24,6 +28,7 @@
 #include "src/Config.h"  // ENABLE_*
 
 #include "Driver/restart.h"
+#include "Driver/flashdata.h"
 
 #include <cstdio>
 #include <cstring>
@@ -65,6 +70,7 @@ namespace Machine {
         handler.section("macros", _macros);
         handler.section("start", _start);
         handler.section("parking", _parking);
+        handler.section("tasks", _tasks);
 
         handler.section("user_outputs", _userOutputs);
         handler.section("user_inputs", _userInputs);
@@ -75,12 +81,21 @@ namespace Machine {
 
         // TODO: Consider putting these under a gcode: hierarchy level? Or motion control?
         handler.item("arc_tolerance_mm", _arcTolerance, 0.001, 1.0);
+        handler.item("native_arcs", _nativeArcs);
         handler.item("junction_deviation_mm", _junctionDeviation, 0.01, 1.0);
+        handler.item("merge_tolerance_mm", _mergeTolerance, 0.0, 0.1);
+        handler.item("chord_tolerance_mm", _chordTolerance, 0.0, 0.1);
         handler.item("verbose_errors", _verboseErrors);
         handler.item("report_inches", _reportInches);
         handler.item("enable_parking_override_control", _enableParkingOverrideControl);
         handler.item("use_line_numbers", _useLineNumbers);
-        handler.item("planner_blocks", _planner_blocks, 10, 120);
+        handler.item("uart0_rx_buffer_size", _uart0RxBufferSize, 256, 16384);
+
+        // planner_blocks used to live at the top level; it is now stepping/planner_blocks.
+        // Accept the old location so existing config files keep working, but do not emit it.
+        if (handler.handlerType() != Configuration::HandlerType::Generator) {
+            handler.item("planner_blocks", Stepping::_planner_blocks, 10, 1024);
+        }
     }
 
     void MachineConfig::afterParse() {
@@ -136,6 +151,10 @@ namespace Machine {
             _parking = new Parking();
         }
 
+        if (_tasks == nullptr) {
+            _tasks = new Tasks();
+        }
+
         auto spindles = Spindles::SpindleFactory::objects();
         if (spindles.size() == 0) {
             spindles.push_back(new Spindles::Null("NoSpindle"));
@@ -174,6 +193,25 @@ namespace Machine {
     }
 
     void MachineConfig::load_file(const std::string_view filename) {
+        if (filename.length() > 1 && filename[0] == '@') {
+            // @label names a data partition that holds the configuration.  It is parsed
+            // directly from the flash mapping.
+            std::string      label { filename.substr(1) };
+            std::string_view text = flashdata_map(label.c_str());
+            if (text.empty()) {
+                log_config_error("Configuration partition " << label << " is missing or empty");
+                log_info("Using default configuration");
+                load_yaml(defaultConfig);
+                set_state(State::ConfigAlarm);
+                return;
+            }
+            log_info("Configuration partition:" << label);
+            load_yaml(text);
+            return;
+        }
+        if (load_cache(filename)) {
+            return;
+        }
         try {
             FileStream file(std::string { filename }, "r", "");
 
@@ -192,6 +230,9 @@ namespace Machine {
             }
             log_info("Configuration file:" << filename);
             load_yaml(std::string_view { buffer.get(), filesize });
+            if (!state_is(State::ConfigAlarm)) {
+                save_cache(filename, std::string_view { buffer.get(), filesize });
+            }
         } catch (...) {
             log_config_error("Cannot open configuration file:" << filename);
             log_info("Using default configuration");
@@ -200,10 +241,97 @@ namespace Machine {
         }
     }
 
-    void MachineConfig::load_yaml(std::string_view input) {
+    // The cache starts with a "FNCC1<TAB>name<TAB>size<TAB>mtime<TAB>hash" line identifying the
+    // config file it was compiled from, followed by the output of Tokenizer::compile().
+    // It is used only while the file's size and modification time still match, the same
+    // test HashFS uses to decide whether a stored hash is current.
+    const char* MachineConfig::cacheName = ".configcache";
+
+    static const char* cacheMagic = "FNCC1";
+
+    static bool stamp_config(const std::string_view filename, uintmax_t& size, int64_t& mtime) {
+        std::error_code ec;
+        FluidPath       path { std::string { filename }, "", ec };
+        if (ec) {
+            return false;
+        }
+        size = stdfs::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        mtime = stdfs::last_write_time(path, ec).time_since_epoch().count();
+        return !ec;
+    }
+
+    bool MachineConfig::load_cache(const std::string_view filename) {
+        uintmax_t size;
+        int64_t   mtime;
+        if (!stamp_config(filename, size, mtime)) {
+            return false;
+        }
+        std::unique_ptr<char[]> buffer;
+        size_t                  cachesize;
+        try {
+            FileStream file(cacheName, "r", localfsName);
+            cachesize = file.size();
+            buffer    = std::make_unique<char[]>(cachesize);
+            if (file.read(buffer.get(), cachesize) != cachesize) {
+                return false;
+            }
+        } catch (...) { return false; }
+
+        std::string_view cache { buffer.get(), cachesize };
+        auto             eol = cache.find('\n');
+        if (eol == std::string_view::npos) {
+            return false;
+        }
+        std::string header { cache.substr(0, eol) };
+        std::string expected = std::string(cacheMagic) + "\t" + std::string(filename) + "\t" + std::to_string(size) + "\t" +
+                               std::to_string(mtime) + "\t";
+        if (header.compare(0, expected.size(), expected)) {
+            return false;
+        }
+
+        log_info("Configuration file:" << filename << " compiled " << header.substr(expected.size()));
+        State before = sys.state;
+        load_yaml(cache.substr(eol + 1), true);
+        if (state_is(State::ConfigAlarm)) {
+            // The cache is damaged; parsing the file will report any real problem
+            log_info("Reloading from configuration file");
+            set_state(before);
+            return false;
+        }
+        return true;
+    }
+
+    void MachineConfig::save_cache(const std::string_view filename, std::string_view yaml) {
+        uintmax_t size;
+        int64_t   mtime;
+        if (!stamp_config(filename, size, mtime)) {
+            return;
+        }
+        try {
+            std::string compiled = Configuration::Tokenizer::compile(yaml);
+
+            HashFS::Hasher hasher;
+            hasher.update(reinterpret_cast<const uint8_t*>(yaml.data()), yaml.size());
+
+            FileStream  file(cacheName, "w", localfsName);
+            std::string header = std::string(cacheMagic) + "\t" + std::string(filename) + "\t" + std::to_string(size) + "\t" +
+                                 std::to_string(mtime) + "\t" + hasher.finish() + "\n";
+            file.write(reinterpret_cast<const uint8_t*>(header.data()), header.size());
+            file.write(reinterpret_cast<const uint8_t*>(compiled.data()), compiled.size());
+        } catch (...) { log_debug("Cannot save compiled configuration"); }
+    }
+
+    void MachineConfig::load_yaml(std::string_view input, bool compiled) {
         bool successful = false;
         try {
-            Configuration::Parser        parser(input);
+            // The configuration objects live until the next load, so they come from the arena
+            Configuration::Configurable::ArenaScope arenaScope;
+            HeapScope                               heapScope(HeapTag::Config);
+
+            Configuration::Parser        parser(input, compiled);
             Configuration::ParserHandler handler(parser);
 
             // instance() is by reference, so we can just get rid of an old instance and
@@ -235,6 +363,8 @@ namespace Machine {
                 config->group(validator);
             } catch (std::exception& ex) { log_config_error("Validation error: " << ex.what()); }
 
+            log_debug("Configuration arena " << Configuration::Configurable::arena_used() << " of "
+                                             << Configuration::Configurable::arena_reserved() << " bytes used");
             // log_info("Heap size after configuation load is " << uint32_t(xPortGetFreeHeapSize()));
 
         } catch (const Configuration::ParseException& ex) {
@@ -262,5 +392,6 @@ namespace Machine {
         delete _spi;
         delete _control;
         delete _macros;
+        delete _tasks;
     }
 }
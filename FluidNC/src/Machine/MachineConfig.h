@@ -27,6 +27,7 @@
 #include "UserOutputs.h"
 #include "UserInputs.h"
 #include "Macros.h"
+#include "Tasks.h"
 
 #include <string_view>
 
@@ -75,16 +76,19 @@ namespace Machine {
         Macros*         _macros         = nullptr;
         Start*          _start          = nullptr;
         Parking*        _parking        = nullptr;
+        Tasks*          _tasks          = nullptr;
 
         UartChannel* _uart_channels[MAX_N_UARTS] = { nullptr };
         Uart*        _uarts[MAX_N_UARTS]         = { nullptr };
 
         float _arcTolerance      = 0.002f;
         float _junctionDeviation = 0.01f;
+        float _mergeTolerance    = 0.0f;  // Collinear line merging in the planner; 0 disables it
+        float _chordTolerance    = 0.0f;  // Cornering by path curvature in the planner; 0 disables it
+        int   _uart0RxBufferSize = 256;   // The console UART is set up before the config is loaded
         bool  _verboseErrors     = true;
         bool  _reportInches      = false;
-
-        size_t _planner_blocks = 16;
+        bool  _nativeArcs        = false;  // G2/G3 as one planner block each instead of many lines
 
         // Enables a special set of M-code commands that enables and disables the parking motion.
         // These are controlled by `M56`, `M56 P1`, or `M56 Px` to enable and `M56 P0` to disable.
@@ -110,9 +114,14 @@ namespace Machine {
 
         static void load();
         static void load_file(std::string_view file);
-        static void load_yaml(std::string_view yaml_string);
+        static void load_yaml(std::string_view yaml_string, bool compiled = false);
 
         ~MachineConfig();
+
+    private:
+        static const char* cacheName;  // Compiled tokens of the last good config file
+        static bool        load_cache(const std::string_view filename);
+        static void        save_cache(const std::string_view filename, std::string_view yaml);
     };
 }
 
@@ -6,8 +6,9 @@
 #include "src/System.h"                 // sys
 #include "src/Machine/MachineConfig.h"  // config
 #include "src/Job.h"                    // Job::
-#include <sstream>
-#include <iomanip>
+#include "src/CompiledGCode.h"          // CompiledGCode::compile_line()
+
+#include <cstring>  // memcpy
 
 void MacroEvent::run(void* arg) const {
     config->_macros->_macro[_num].run(nullptr);
@@ -58,6 +59,22 @@ Cmd findOverride(std::string name) {
     return it == overrideCodes.end() ? Cmd::None : it->second;
 }
 
+// Lines of only letter and number words become records that gc_execute_line() executes
+// without scanning text, as for $File/Compile.  Lines with #xx realtime escapes, parameters,
+// comments and $ commands stay text, with a newline after each.
+void Macro::compile() {
+    _compiled.clear();
+    size_t start = 0;
+    while (start < _gcode.length()) {
+        size_t end = _gcode.find_first_of("&\n", start);
+        if (end == std::string::npos) {
+            end = _gcode.length();
+        }
+        CompiledGCode::compile_line(_gcode.substr(start, end - start).c_str(), _compiled);
+        start = end + 1;
+    }
+}
+
 bool Macro::run(Channel* channel) {
     if (_gcode.length()) {
         if (channel) {
@@ -72,8 +89,20 @@ bool Macro::run(Channel* channel) {
 
 Error MacroChannel::readLine(char* line, int maxlen) {
     int                len       = 0;
-    const std::string& gcode     = _macro->_gcode;
+    const std::string& gcode     = _macro->compiled();
     const int          gcode_len = gcode.length();
+    if (_position < gcode_len && gcode[_position] == CompiledGCode::words_record) {
+        // A pre-parsed line; copy the record as is
+        size_t size = CompiledGCode::record_size(&gcode[_position]);
+        if (int(size) >= maxlen) {
+            return Error::LineLengthExceeded;
+        }
+        memcpy(line, &gcode[_position], size);
+        line[size] = '\0';
+        _position += size;
+        ++_line_number;
+        return Error::Ok;
+    }
     while (_position < gcode_len) {
         if (len >= maxlen) {
             return Error::LineLengthExceeded;
@@ -124,6 +153,7 @@ MacroChannel::MacroChannel(Macro* macro) : Channel(macro->name(), false), _macro
 void MacroChannel::end_message() {
     _progress += name();
     _progress += ": Sent";
+    _progressPercent = 100;
 }
 
 Error MacroChannel::pollLine(char* line) {
@@ -151,12 +181,14 @@ Error MacroChannel::pollLine(char* line) {
     }
     switch (auto err = readLine(line, Channel::maxLine)) {
         case Error::Ok: {
-            log_debug("Macro line: " << line);
-            float percent_complete = (float)_position * 100.0f / _macro->get().length();
-
-            std::ostringstream s;
-            s << "SD:" << std::fixed << std::setprecision(2) << percent_complete << "," << name();
-            _progress = s.str();
+            log_debug("Macro line: " << (line[0] == CompiledGCode::words_record ? CompiledGCode::to_text(line) : std::string(line)));
+            float percent_complete = (float)_position * 100.0f / _macro->compiled().length();
+
+            char progress[48];
+            snprintf(progress, sizeof(progress), "SD:%.2f,", percent_complete);
+            _progress = progress;
+            _progress += name();
+            _progressPercent = percent_complete;
         }
             return Error::Ok;
         case Error::Eof:
@@ -46,6 +46,12 @@ namespace Machine {
         }
     }
 
+    void Motor::wait_config() {
+        if (_driver != nullptr) {
+            _driver->wait_config();
+        }
+    }
+
     // true if there is at least one switch for this motor
     bool Motor::hasSwitches() {
         return (_negPin.defined() || _posPin.defined() || _allPin.defined());
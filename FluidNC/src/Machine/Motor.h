@@ -44,6 +44,7 @@ namespace Machine {
         void limitOtherAxis(int axis);
         void init();
         void config_motor();
+        void wait_config();
         ~Motor();
     };
 }
@@ -0,0 +1,135 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Tasks.h"
+#include "MachineConfig.h"  // config
+#include "../Config.h"      // SUPPORT_TASK_CORE, PREP_TASK_PRIORITY
+#include "../Logging.h"
+
+#include <cstring>
+
+namespace Machine {
+    struct TaskDefault {
+        const char* name;
+        int32_t     core;
+        int32_t     priority;
+        int32_t     stack;
+    };
+
+    static const TaskDefault defaults[] = {
+        { "poller", SUPPORT_TASK_CORE, 1, 8192 },
+        { "output", SUPPORT_TASK_CORE, 2, 16000 },
+        { "prep", -1, PREP_TASK_PRIORITY, 4096 },  // Started by the main loop, on the core of the step timer
+        { "kinematics", SUPPORT_TASK_CORE, 2, 2048 },
+        { "readahead", SUPPORT_TASK_CORE, 1, 4096 },
+        { "webserver", SUPPORT_TASK_CORE, 1, 8192 },
+        { "notify", SUPPORT_TASK_CORE, 1, 8192 },  // Enough for a TLS handshake
+        { "vfd", SUPPORT_TASK_CORE, 1, 2048 },
+        { "tmc_uart", SUPPORT_TASK_CORE, 2, 3072 },
+        { "tmc_telemetry", SUPPORT_TASK_CORE, 2, 3072 },
+        { "i2c", SUPPORT_TASK_CORE, 0, 2048 },  // Below the polling task
+        { "sync_link", SUPPORT_TASK_CORE, 2, 4096 },
+        { "analog_inputs", SUPPORT_TASK_CORE, 1, 2048 },
+        { "uart_events", SUPPORT_TASK_CORE, 2, 2048 },  // One per UART channel
+    };
+    static_assert(sizeof(defaults) / sizeof(defaults[0]) == Tasks::n_tasks, "One default per task");
+
+    // The latest instance of each task and where it was started, for the report.  Tasks
+    // like tmc_uart run once per bus.
+    static TaskHandle_t handles[Tasks::n_tasks] = { nullptr };
+    static int32_t      cores[Tasks::n_tasks];
+    static uint32_t     stacks[Tasks::n_tasks];
+
+    TaskConfig::TaskConfig(size_t index) :
+        _name(defaults[index].name), _core(defaults[index].core), _priority(defaults[index].priority), _stack(defaults[index].stack) {}
+
+    void TaskConfig::validate() {
+        if (strcmp(_name, "prep") == 0) {
+            Assert(_priority > 1, "The prep task priority must be above the main loop's 1");
+        }
+    }
+
+    void TaskConfig::group(Configuration::HandlerBase& handler) {
+        handler.item("core", _core, -1, portNUM_PROCESSORS - 1);
+        handler.item("priority", _priority, 0, configMAX_PRIORITIES - 1);
+        handler.item("stack", _stack, 1024, 65536);
+    }
+
+    void Tasks::group(Configuration::HandlerBase& handler) {
+        for (size_t i = 0; i < n_tasks; i++) {
+            handler.section(defaults[i].name, _task[i], i);
+        }
+    }
+
+    void Tasks::afterParse() {
+        for (size_t i = 0; i < n_tasks; i++) {
+            if (_task[i] == nullptr) {
+                _task[i] = new TaskConfig(i);
+            }
+        }
+    }
+
+    static size_t find(const char* name) {
+        size_t i;
+        for (i = 0; i < Tasks::n_tasks && strcmp(defaults[i].name, name) != 0; i++) {}
+        Assert(i < Tasks::n_tasks, "Unknown task %s", name);
+        return i;
+    }
+
+    BaseType_t Tasks::create(const char* name, TaskFunction_t fn, void* arg, TaskHandle_t* handle) {
+        size_t   i        = find(name);
+        int32_t  core     = defaults[i].core;
+        int32_t  priority = defaults[i].priority;
+        uint32_t stack    = defaults[i].stack;
+        if (config && config->_tasks && config->_tasks->_task[i]) {
+            auto task = config->_tasks->_task[i];
+            core      = task->_core;
+            priority  = task->_priority;
+            stack     = task->_stack;
+        }
+        if (core < 0) {
+            core = xPortGetCoreID();
+        }
+        TaskHandle_t task;
+        BaseType_t   result = xTaskCreatePinnedToCore(fn, name, stack, arg, priority, &task, core);
+        if (result != pdPASS) {
+            log_error("Cannot start task " << name << " with a stack of " << stack);
+            return result;
+        }
+        handles[i] = task;
+        cores[i]   = core;
+        stacks[i]  = stack;
+        if (handle) {
+            *handle = task;
+        }
+        return result;
+    }
+
+    void Tasks::exiting() {
+        TaskHandle_t self = xTaskGetCurrentTaskHandle();
+        for (size_t i = 0; i < n_tasks; i++) {
+            if (handles[i] == self) {
+                handles[i] = nullptr;
+            }
+        }
+    }
+
+    void Tasks::report(Channel& out) {
+        for (size_t i = 0; i < n_tasks; i++) {
+            const char* name = defaults[i].name;
+            if (!handles[i]) {
+                log_stream(out, name << " not running");
+                continue;
+            }
+            log_stream(out,
+                       name << " core:" << cores[i] << " priority:" << uxTaskPriorityGet(handles[i]) << " stack:" << stacks[i]
+                            << " min free:" << uxTaskGetStackHighWaterMark(handles[i]));
+        }
+    }
+
+    Tasks::~Tasks() {
+        for (size_t i = 0; i < n_tasks; i++) {
+            delete _task[i];
+        }
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "../Configuration/Configurable.h"
+#include "../Channel.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace Machine {
+    // Where one of the firmware's tasks runs.  A core of -1 runs it on the core of the
+    // task that starts it.
+    class TaskConfig : public Configuration::Configurable {
+    public:
+        const char* _name;
+        int32_t     _core;
+        int32_t     _priority;
+        int32_t     _stack;  // Bytes
+
+        TaskConfig(size_t index);
+
+        void validate() override;
+        void group(Configuration::HandlerBase& handler) override;
+    };
+
+    // The tasks: section places the firmware's tasks, so that network work can be kept on
+    // one core and motion on the other without a rebuild.  Each task has a subsection of
+    // its own name, and those left out keep their defaults:
+    //
+    //   tasks:
+    //     webserver:
+    //       core: 1
+    //       stack: 12288
+    class Tasks : public Configuration::Configurable {
+    public:
+        static const size_t n_tasks = 14;
+
+        TaskConfig* _task[n_tasks] = { nullptr };
+
+        Tasks() = default;
+
+        void group(Configuration::HandlerBase& handler) override;
+        void afterParse() override;
+
+        // Starts the task called name where it is configured to run, or where it runs by
+        // default if the configuration is not loaded yet.  Returns pdPASS on success.
+        static BaseType_t create(const char* name, TaskFunction_t fn, void* arg, TaskHandle_t* handle = nullptr);
+
+        // Called by a task just before it deletes itself, so that the report leaves it out
+        static void exiting();
+
+        // Shows where each task runs and the least free stack it has had
+        static void report(Channel& out);
+
+        ~Tasks();
+    };
+}
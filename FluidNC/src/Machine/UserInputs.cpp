@@ -2,6 +2,16 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "UserInputs.h"
+#include "Tasks.h"
+
+#include "Driver/AnalogReader.h"
+#include "Driver/fluidnc_gpio.h"  // gpio_add_interrupt
+#include "../Protocol.h"          // protocol_execute_realtime, protocol_wake_main_from_ISR
+#include "../System.h"            // sys.abort
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 namespace Machine {
     UserInputs::UserInputs() {}
@@ -19,21 +29,68 @@ namespace Machine {
             handler.item(item_name, _digitalInput[i].pin);
             _digitalInput[i].name = item_name;
         }
+        handler.item("analog_sample_hz", _analogSampleHz, 1, 1000);
+        handler.item("analog_average", _analogAverage, 1, AnalogHistory);
+    }
+
+    void IRAM_ATTR UserInputs::edge_isr(void* arg) {
+        auto c = static_cast<DigitalCapture*>(arg);
+        if (c->fast.read()) {
+            c->rises = c->rises + 1;
+        } else {
+            c->falls = c->falls + 1;
+        }
+        c->edgeUs = esp_timer_get_time();
+        protocol_wake_main_from_ISR();
+    }
+
+    void UserInputs::sample() {
+        for (auto& s : _analogSampler) {
+            if (s.adc) {
+                s.ring[s.count % AnalogHistory] = s.adc->read();
+                s.count                         = s.count + 1;
+            }
+        }
+    }
+
+    void UserInputs::sampleTask(void* arg) {
+        auto       inputs = static_cast<UserInputs*>(arg);
+        TickType_t wake   = xTaskGetTickCount();
+        while (true) {
+            TickType_t period = pdMS_TO_TICKS(1000 / inputs->_analogSampleHz);
+            vTaskDelayUntil(&wake, period ? period : 1);
+            inputs->sample();
+        }
     }
 
     void UserInputs::init() {
-        for (auto& input : _analogInput) {
+        bool sampling = false;
+        for (size_t i = 0; i < MaxUserAnalogPin; i++) {
+            auto& input = _analogInput[i];
             if (input.pin.defined()) {
                 input.pin.setAttr(Pin::Attr::Input);
-                log_info("User Analog Input: " << input.name << " on Pin " << input.pin.name());
+                _analogSampler[i].adc = AnalogReader::create(input.pin);
+                sampling |= _analogSampler[i].adc != nullptr;
+                log_info("User Analog Input: " << input.name << " on Pin " << input.pin.name()
+                                               << (_analogSampler[i].adc ? "" : " (no ADC, read as digital)"));
             }
         }
-        for (auto& input : _digitalInput) {
+        for (size_t i = 0; i < MaxUserDigitalPin; i++) {
+            auto& input = _digitalInput[i];
             if (input.pin.defined()) {
                 input.pin.setAttr(Pin::Attr::Input);
                 log_info("User Digital Input: " << input.name << " on Pin " << input.pin.name());
+                if (input.pin.capabilities().has(Pin::Capabilities::Native | Pin::Capabilities::ISR)) {
+                    auto& capture = _digitalCapture[i];
+                    capture.fast.resolve(input.pin);
+                    capture.hasIsr = true;
+                    gpio_add_interrupt(input.pin.index(), GPIO_EDGE_ANY, edge_isr, &capture);
+                }
             }
         }
+        if (sampling) {
+            Machine::Tasks::create("analog_inputs", sampleTask, this);
+        }
     }
 
     UserInputs::ReadInputResult UserInputs::readDigitalInput(uint8_t input_number) {
@@ -47,8 +104,7 @@ namespace Machine {
         return input.pin.read();
     }
 
-    UserInputs::ReadInputResult UserInputs::readAnalogInput(uint8_t input_number) {
-        // TODO - analog pins are read the same as digital.
+    UserInputs::ReadAnalogResult UserInputs::readAnalogInput(uint8_t input_number) {
         if (input_number >= MaxUserAnalogPin) {
             return Error::PParamMaxExceeded;
         }
@@ -56,7 +112,71 @@ namespace Machine {
         if (!input.pin.defined()) {
             return Error::InvalidValue;
         }
-        return input.pin.read();
+        auto& s = _analogSampler[input_number];
+        if (!s.adc) {
+            return input.pin.read() ? 1.0f : 0.0f;
+        }
+        uint32_t count = s.count;
+        if (count == 0) {
+            return float(s.adc->read());  // Before the first sample
+        }
+        uint32_t n   = std::min(count, _analogAverage);
+        uint32_t sum = 0;
+        for (uint32_t i = 1; i <= n; i++) {
+            sum += s.ring[(count - i) % AnalogHistory];
+        }
+        return float(sum) / n;
+    }
+
+    std::variant<std::optional<bool>, Error> UserInputs::waitDigitalInput(uint8_t input_number, WaitOnInputMode mode, uint32_t timeout_ms) {
+        if (input_number >= MaxUserDigitalPin) {
+            return Error::PParamMaxExceeded;
+        }
+        auto& input = _digitalInput[input_number];
+        if (!input.pin.defined()) {
+            return Error::InvalidValue;
+        }
+        auto&    capture = _digitalCapture[input_number];
+        uint32_t rises   = capture.rises;
+        uint32_t falls   = capture.falls;
+        bool     last    = input.pin.read();
+        int64_t  end     = esp_timer_get_time() + int64_t(timeout_ms) * 1000;
+
+        while (true) {
+            bool level = input.pin.read();
+            bool done  = false;
+            switch (mode) {
+                case WaitOnInputMode::High:
+                    done = level;
+                    break;
+                case WaitOnInputMode::Low:
+                    done = !level;
+                    break;
+                case WaitOnInputMode::Rise:
+                    // Without an ISR, an edge is seen only if it lasts until the next poll
+                    done = capture.hasIsr ? capture.rises != rises : (level && !last);
+                    break;
+                case WaitOnInputMode::Fall:
+                    done = capture.hasIsr ? capture.falls != falls : (!level && last);
+                    break;
+                default:
+                    done = true;
+                    break;
+            }
+            if (done) {
+                return level;
+            }
+            last = level;
+            if (esp_timer_get_time() >= end) {
+                return std::nullopt;
+            }
+            protocol_execute_realtime();
+            if (sys.abort) {
+                return std::nullopt;
+            }
+            // The edge ISR wakes the main task, so this returns as soon as the input changes
+            ulTaskNotifyTake(pdTRUE, capture.hasIsr ? pdMS_TO_TICKS(10) : 1);
+        }
     }
 
 }  // namespace Machine
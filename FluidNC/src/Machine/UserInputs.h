@@ -5,9 +5,13 @@
 
 #include "../Configuration/Configurable.h"
 #include "../GCode.h"
+#include "../FastPin.h"
 
 #include <variant>
 #include <array>
+#include <optional>
+
+class AnalogReader;
 
 namespace Machine {
 
@@ -17,12 +21,37 @@ namespace Machine {
             Pin         pin;
         };
 
-        std::array<PinAndName, MaxUserDigitalPin> _digitalInput;
+        // Edges on a native digital input are counted by an ISR, so a short pulse
+        // between two polls is not missed and M66 can wait without polling.
+        struct DigitalCapture {
+            FastPin           fast;
+            bool              hasIsr = false;
+            volatile uint32_t rises  = 0;
+            volatile uint32_t falls  = 0;
+            volatile int64_t  edgeUs = 0;  // esp_timer time of the latest edge
+        };
+
+        // Analog inputs on an ADC are sampled in the background at _analogSampleHz
+        // into a ring, and read back as the average of the newest _analogAverage samples.
+        static const size_t AnalogHistory = 32;
+        struct AnalogSampler {
+            AnalogReader*     adc = nullptr;
+            uint16_t          ring[AnalogHistory];
+            volatile uint32_t count = 0;  // Total samples taken
+        };
+
+        std::array<PinAndName, MaxUserDigitalPin>     _digitalInput;
+        std::array<DigitalCapture, MaxUserDigitalPin> _digitalCapture;
 
-        // TODO - analog pins are read the same as digital. The Pin
-        // API should either be extended to support analog reads, or
-        // a new AnalogPin class should be created.
-        std::array<PinAndName, MaxUserAnalogPin> _analogInput;
+        std::array<PinAndName, MaxUserAnalogPin>    _analogInput;
+        std::array<AnalogSampler, MaxUserAnalogPin> _analogSampler;
+
+        uint32_t _analogSampleHz = 100;
+        uint32_t _analogAverage  = 8;
+
+        static void IRAM_ATTR edge_isr(void* arg);
+        static void           sampleTask(void* arg);
+        void                  sample();
 
     public:
         UserInputs();
@@ -33,7 +62,14 @@ namespace Machine {
 
         using ReadInputResult = std::variant<bool, Error>;
         ReadInputResult readDigitalInput(uint8_t input_number);
-        ReadInputResult readAnalogInput(uint8_t input_number);
+
+        // The filtered ADC count for an input on the ADC, otherwise 0 or 1 from the pin
+        using ReadAnalogResult = std::variant<float, Error>;
+        ReadAnalogResult readAnalogInput(uint8_t input_number);
+
+        // Waits until a digital input meets the M66 condition or timeout_ms has passed.
+        // Returns the input level, or std::nullopt on timeout or abort.
+        std::variant<std::optional<bool>, Error> waitDigitalInput(uint8_t input_number, WaitOnInputMode mode, uint32_t timeout_ms);
     };
 
 }  // namespace Machine
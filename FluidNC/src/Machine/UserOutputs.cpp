@@ -4,9 +4,15 @@
 
 #include "UserOutputs.h"
 #include "../Config.h"      // log_*
+#include "I2SOBus.h"        // I2SOBus::write_mask
 #include <esp32-hal-cpu.h>  // getApbFrequency()
 
 namespace Machine {
+    FastPin  UserOutputs::_fast[MaxUserDigitalPin];
+    uint32_t UserOutputs::_i2soBit[MaxUserDigitalPin] = { 0 };
+    uint32_t UserOutputs::_i2soInverted               = 0;
+    uint8_t  UserOutputs::_syncable                   = 0;
+
     UserOutputs::UserOutputs() {
         for (int i = 0; i < MaxUserAnalogPin; ++i) {
             _analogFrequency[i] = 5000;
@@ -21,6 +27,16 @@ namespace Machine {
                 pin.setAttr(Pin::Attr::Output);
                 pin.off();
                 log_info("User Digital Output: " << i << " on Pin:" << pin.name());
+                if (pin.capabilities().has(Pin::Capabilities::Native)) {
+                    _fast[i].resolve(pin);
+                    set_bitnum(_syncable, i);
+                } else if (pin.capabilities().has(Pin::Capabilities::I2S)) {
+                    _i2soBit[i] = bitnum_to_mask(pin.index());
+                    if (pin.inverted()) {
+                        _i2soInverted |= _i2soBit[i];
+                    }
+                    set_bitnum(_syncable, i);
+                }
             }
         }
         // determine the highest resolution (number of precision bits) allowed by frequency
@@ -38,6 +54,7 @@ namespace Machine {
     }
 
     void UserOutputs::all_off() {
+        _queuedMask = 0;
         for (size_t io_num = 0; io_num < MaxUserDigitalPin; io_num++) {
             setDigital(io_num, false);
         }
@@ -51,10 +68,95 @@ namespace Machine {
         if (pin.undefined()) {
             return !isOn;  // It is okay to turn off an undefined pin, for safety
         }
-        pin.synchronousWrite(isOn);
+        if (bitnum_is_true(_syncable, io_num)) {
+            uint8_t bit = bitnum_to_mask(io_num);
+            writeMask(bit, isOn ? bit : 0);
+            if (_i2soBit[io_num]) {
+                i2s_out_delay();  // Wait until it is shifted out, like synchronousWrite()
+            }
+        } else {
+            pin.synchronousWrite(isOn);
+        }
         return true;
     }
 
+    void IRAM_ATTR UserOutputs::writeMask(uint8_t mask, uint8_t on) {
+        uint32_t i2soMask  = 0;
+        uint32_t i2soValue = 0;
+        for (size_t io_num = 0; io_num < MaxUserDigitalPin; io_num++) {
+            if (!bitnum_is_true(mask, io_num)) {
+                continue;
+            }
+            bool isOn = bitnum_is_true(on, io_num);
+            if (_i2soBit[io_num]) {
+                i2soMask |= _i2soBit[io_num];
+                if (isOn) {
+                    i2soValue |= _i2soBit[io_num];
+                }
+            } else {
+                _fast[io_num].write(isOn);
+            }
+        }
+        if (i2soMask) {
+            I2SOBus::write_mask(i2soMask, i2soValue ^ _i2soInverted);
+        }
+    }
+
+    bool UserOutputs::queueDigital(size_t io_num, bool isOn, float distance) {
+        if (!bitnum_is_true(_syncable, io_num)) {
+            return false;
+        }
+        uint8_t bit = bitnum_to_mask(io_num);
+        if (distance > 0.0f) {
+            if (_queuedChanges.count == maxOutputEvents) {
+                return false;
+            }
+            // Keep them in order of distance, the order in which the planner takes them
+            size_t i = _queuedChanges.count++;
+            for (; i > 0 && _queuedChanges.change[i - 1].distance > distance; i--) {
+                _queuedChanges.change[i] = _queuedChanges.change[i - 1];
+            }
+            _queuedChanges.change[i] = { distance, bit, uint8_t(isOn ? bit : 0) };
+            return true;
+        }
+        _queuedMask |= bit;
+        if (isOn) {
+            _queuedOn |= bit;
+        } else {
+            _queuedOn &= ~bit;
+        }
+        return true;
+    }
+
+    void UserOutputs::takeQueued(uint8_t& mask, uint8_t& on, OutputChanges& changes) {
+        mask                 = _queuedMask;
+        on                   = _queuedOn;
+        changes              = _queuedChanges;
+        _queuedMask          = 0;
+        _queuedOn            = 0;
+        _queuedChanges.count = 0;
+    }
+
+    void UserOutputs::requeue(const OutputChanges& changes) {
+        for (size_t i = 0; i < changes.count; i++) {
+            const OutputChange& change = changes.change[i];
+            _queuedMask |= change.mask;
+            _queuedOn = (_queuedOn & ~change.mask) | change.on;
+        }
+    }
+
+    void UserOutputs::applyQueued() {
+        requeue(_queuedChanges);  // In order, after the changes for the start
+        _queuedChanges.count = 0;
+
+        uint8_t       mask, on;
+        OutputChanges changes;
+        takeQueued(mask, on, changes);
+        if (mask) {
+            writeMask(mask, on);
+        }
+    }
+
     bool UserOutputs::setAnalogPercent(size_t io_num, float percent) {
         Pin& pin = _analogOutput[io_num];
 
@@ -7,12 +7,27 @@
 #include "../Configuration/Configurable.h"
 #include "../GCode.h"       // MaxUserDigitalPin MaxUserAnalogPin
 #include "Driver/PwmPin.h"  // pwm_chan_t
+#include "../FastPin.h"
+#include "../Planner.h"  // OutputChanges
 
 namespace Machine {
     class UserOutputs : public Configuration::Configurable {
         PwmPin*  _pwm[MaxUserAnalogPin];
         uint32_t _current_value[MaxUserAnalogPin];
 
+        // Digital outputs on native GPIOs or I2SO can be switched from the stepper ISR,
+        // so M62/M63 take effect as the next motion starts instead of stopping the
+        // machine.  They are always written through writeMask().
+        static FastPin  _fast[MaxUserDigitalPin];     // For native GPIOs
+        static uint32_t _i2soBit[MaxUserDigitalPin];  // For I2SO pins, else 0
+        static uint32_t _i2soInverted;                // I2SO bits of active-low pins
+        static uint8_t  _syncable;                    // Outputs that writeMask() can switch
+
+        // M62/M63 changes waiting for the next motion, by output number
+        uint8_t       _queuedMask    = 0;
+        uint8_t       _queuedOn      = 0;
+        OutputChanges _queuedChanges = {};  // M62/M63 Q, a distance into it
+
     public:
         UserOutputs();
 
@@ -25,6 +40,25 @@ namespace Machine {
 
         void group(Configuration::HandlerBase& handler) override;
         bool setDigital(size_t io_num, bool isOn);
+
+        // Switches the outputs in mask, by output number, to the bits of on.  The I2SO
+        // outputs change in one shift register update.  Safe to call from an ISR, for
+        // outputs in _syncable.
+        static void IRAM_ATTR writeMask(uint8_t mask, uint8_t on);
+
+        // Queues an M62/M63 change for the start of the next motion, or for distance mm
+        // into it.  Returns false if the output cannot be switched from the stepper ISR, or
+        // if too many changes are waiting.
+        bool queueDigital(size_t io_num, bool isOn, float distance = 0.0f);
+
+        // Hands the queued changes to a motion, which applies them as it goes
+        void takeQueued(uint8_t& mask, uint8_t& on, OutputChanges& changes);
+
+        // Takes back the changes past the end of a motion, for the start of the next one
+        void requeue(const OutputChanges& changes);
+
+        // Applies the queued changes now, when no motion is left to carry them
+        void applyQueued();
         bool setAnalogPercent(size_t io_num, float percent);
 
         virtual ~UserOutputs();
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "MachineStatus.h"
+
+#include "SeqLock.h"
+#include "Report.h"  // state_name
+#include "System.h"  // sys, get_mpos, get_wco
+#include "Limits.h"  // limits_get_state
+#include "Planner.h"
+#include "Stepper.h"  // get_realtime_rate
+#include "Job.h"
+#include "Machine/MachineConfig.h"
+
+#include <freertos/task.h>
+#include <cstring>
+
+static SeqLock<MachineStatus> published;
+static TickType_t             lastPublish = 0;
+
+void machine_status_publish() {
+    TickType_t now = xTaskGetTickCount();
+    if (published.writes() && (now - lastPublish) < pdMS_TO_TICKS(STATUS_PUBLISH_MS)) {
+        return;
+    }
+    lastPublish = now;
+
+    MachineStatus s;
+    s.state      = sys.state;
+    s.state_name = state_name();
+    memcpy(s.mpos, get_mpos(), sizeof(s.mpos));
+    memcpy(s.wco, get_wco(), sizeof(s.wco));
+    s.feed_rate     = Stepper::get_realtime_rate();
+    s.spindle_speed = sys.spindle_speed;
+    s.feed_ovr      = sys.f_override;
+    s.rapid_ovr     = sys.r_override;
+    s.spindle_ovr   = sys.spindle_speed_ovr;
+    s.spindle       = spindle->get_state();
+    s.coolant       = config->_coolant->get_state();
+    s.probe         = config->_probe->get_state();
+
+    s.limits            = 0;
+    MotorMask lim_state = limits_get_state();
+    auto      n_axis    = Axes::_numberAxis;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        if (bitnum_is_true(lim_state, Machine::Axes::motor_bit(axis, 0)) ||
+            bitnum_is_true(lim_state, Machine::Axes::motor_bit(axis, 1))) {
+            set_bitnum(s.limits, axis);
+        }
+    }
+
+    plan_block_t* cur_block = plan_get_current_block();
+    s.line_number           = cur_block ? cur_block->line_number : 0;
+
+    s.job_active  = Job::active();
+    s.job_percent = 0;
+    s.job_name[0] = '\0';
+    if (s.job_active) {
+        Channel* job  = Job::channel();
+        s.job_percent = job->_progressPercent;
+        strncpy(s.job_name, job->name().c_str(), sizeof(s.job_name) - 1);
+        s.job_name[sizeof(s.job_name) - 1] = '\0';
+    }
+
+    published.write(s);
+}
+
+uint32_t machine_status_read(MachineStatus& status) {
+    return published.read(status);
+}
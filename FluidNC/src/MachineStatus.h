@@ -0,0 +1,48 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  MachineStatus.h - the realtime status as numbers, for consumers inside FluidNC
+
+  The <...> status report is text for hosts.  Displays and status outputs read this
+  instead, so they do not have to parse the report back into numbers.  The polling task
+  publishes it through a SeqLock at most every STATUS_PUBLISH_MS, and any task can read it.
+*/
+
+#include "Config.h"            // MAX_N_AXIS
+#include "Types.h"             // State, Percent, AxisMask
+#include "GCode.h"             // CoolantState
+#include "SpindleDatatypes.h"  // SpindleState, SpindleSpeed
+
+#include <cstdint>
+
+const uint32_t STATUS_PUBLISH_MS = 20;
+
+struct MachineStatus {
+    State        state;
+    const char*  state_name;  // As in the report, e.g. "Hold:0"
+    float        mpos[MAX_N_AXIS];
+    float        wco[MAX_N_AXIS];  // wpos = mpos - wco
+    float        feed_rate;        // mm/min
+    SpindleSpeed spindle_speed;
+    Percent      feed_ovr;
+    Percent      rapid_ovr;
+    Percent      spindle_ovr;
+    SpindleState spindle;
+    CoolantState coolant;
+    AxisMask     limits;  // Axes with an active limit switch
+    bool         probe;
+    uint32_t     line_number;  // Of the block being executed, 0 if none
+    bool         job_active;
+    float        job_percent;
+    char         job_name[64];
+};
+
+// Called from the polling task; does nothing until STATUS_PUBLISH_MS has passed.
+void machine_status_publish();
+
+// Returns the number of snapshots published so far, so a reader can skip work when
+// nothing is new.
+uint32_t machine_status_read(MachineStatus& status);
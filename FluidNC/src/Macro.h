@@ -4,14 +4,20 @@
 class Macro {
     std::string _name;
 
+    // The lines of _gcode as CompiledGCode records, made when it is set, see compile()
+    std::string _compiled;
+
+    void compile();
+
 public:
     std::string        _gcode;
     bool               run(Channel* channel);
-    void               set(const char* value) { _gcode = value; }
-    void               set(const std::string& value) { _gcode = value; }
-    void               set(const std::string_view value) { _gcode = value; }
-    void               erase() { _gcode = ""; }
+    void               set(const char* value) { _gcode = value; compile(); }
+    void               set(const std::string& value) { _gcode = value; compile(); }
+    void               set(const std::string_view value) { _gcode = value; compile(); }
+    void               erase() { _gcode.clear(); _compiled.clear(); }
     const std::string& get() { return _gcode; }
+    const std::string& compiled() { return _compiled; }
     const char*        name() { return _name.c_str(); }
 
     // add to _gcode using a printf style formatting like _macro.addf("G53G0Z%0.3f", _safe_z);
@@ -38,6 +44,7 @@ public:
         }
 
         _gcode += std::string(temp);
+        compile();
     }
 
     explicit Macro(const std::string& name) : _name(name) {}
@@ -15,13 +15,17 @@
 #    include "Protocol.h"
 #    include "System.h"
 #    include "UartChannel.h"
+#    include "UsbCdcChannel.h"
 #    include "MotionControl.h"
 #    include "Platform.h"
 #    include "StartupLog.h"
+#    include "FlightRecorder.h"
+#    include "BootTiming.h"
 #    include "Module.h"
 
 #    include "Driver/localfs.h"
 #    include "esp32-hal.h"  // disableCore0WDT
+#    include <esp_timer.h>  // esp_timer_get_time
 
 #    include "src/ToolChangers/atc.h"
 
@@ -31,9 +35,11 @@ void setup() {
     disableCore0WDT();
     try {
         timing_init();
-        uartInit();  // Setup serial port
+        uartInit();    // Setup serial port
+        usbCdcInit();  // and the native USB port, if any
 
         StartupLog::init();
+        FlightRecorder::init();
 
         // Setup input polling loop after loading the configuration,
         // because the polling may depend on the config
@@ -44,61 +50,92 @@ void setup() {
         protocol_init();
 
         // Load settings from non-volatile storage
-        settings_init();  // requires config
+        {
+            BootPhase phase("Settings");
+            settings_init();  // requires config
+        }
 
         log_info("FluidNC " << git_info << " " << git_url);
         log_info("Compiled with ESP32 SDK:" << esp_get_idf_version());
 
-        if (localfs_mount()) {
-            log_error("Cannot mount a local filesystem");
-        } else {
-            log_info("Local filesystem type is " << localfsName);
+        {
+            BootPhase phase("Filesystem mount");
+            if (localfs_mount()) {
+                log_error("Cannot mount a local filesystem");
+            } else {
+                log_info("Local filesystem type is " << localfsName);
+            }
+        }
+
+        {
+            BootPhase phase("Config load");
+            config->load();
         }
 
-        config->load();
+        {
+            BootPhase phase("Commands");
+            make_user_commands();
 
-        make_user_commands();
+            int64_t indexStart = esp_timer_get_time();
+            size_t  names      = Setting::buildIndexes();
+            log_info("Indexed " << names << " command and setting names in " << int(esp_timer_get_time() - indexStart) << " us");
+        }
 
         log_info("Machine " << config->_name);
         log_info("Board " << config->_board);
 
         // The initialization order reflects dependencies between the subsystems
-        for (size_t i = 1; i < MAX_N_UARTS; i++) {
-            if (config->_uarts[i]) {
-                config->_uarts[i]->begin();
+        {
+            BootPhase phase("Buses");
+            Uart0.setRxBufferSize(config->_uart0RxBufferSize);
+            for (size_t i = 1; i < MAX_N_UARTS; i++) {
+                if (config->_uarts[i]) {
+                    config->_uarts[i]->begin();
+                }
             }
-        }
-        for (size_t i = 1; i < MAX_N_UARTS; i++) {
-            if (config->_uart_channels[i]) {
-                config->_uart_channels[i]->init();
+            for (size_t i = 1; i < MAX_N_UARTS; i++) {
+                if (config->_uart_channels[i]) {
+                    config->_uart_channels[i]->init();
+                }
             }
-        }
 
-        if (config->_i2so) {
-            config->_i2so->init();
-        }
-        if (config->_spi) {
-            config->_spi->init();
+            if (config->_i2so) {
+                config->_i2so->init();
+            }
+            if (config->_spi) {
+                config->_spi->init();
 
-            if (config->_sdCard != nullptr) {
-                config->_sdCard->init();
+                if (config->_sdCard != nullptr) {
+                    config->_sdCard->init();
+                }
             }
-        }
-        for (size_t i = 0; i < MAX_N_I2C; i++) {
-            if (config->_i2c[i]) {
-                config->_i2c[i]->init();
+            for (size_t i = 0; i < MAX_N_I2C; i++) {
+                if (config->_i2c[i]) {
+                    config->_i2c[i]->init();
+                }
             }
         }
 
-        Stepping::init();  // Configure stepper interrupt timers
+        {
+            BootPhase phase("Motion");
+            Stepping::init();  // Configure stepper interrupt timers
 
-        plan_init();
+            plan_init();
+
+            Stepper::start_prep_task();  // After plan_init(), on the core that runs the step timer
+        }
 
-        config->_userOutputs->init();
+        {
+            BootPhase phase("User I/O");
+            config->_userOutputs->init();
 
-        config->_userInputs->init();
+            config->_userInputs->init();
+        }
 
-        Axes::init();
+        {
+            BootPhase phase("Axes");
+            Axes::init();
+        }
 
         config->_control->init();
 
@@ -108,9 +145,11 @@ void setup() {
 
         // Initialize system state.
         for (auto const& module : Modules()) {
+            BootPhase phase(module->name());
             module->init();
         }
         for (auto const& module : ConfigurableModules()) {
+            BootPhase phase(module->name());
             module->init();
         }
 
@@ -120,6 +159,7 @@ void setup() {
         }
 
         if (!state_is(State::ConfigAlarm)) {
+            BootPhase phase("Spindles");
             auto spindles = Spindles::SpindleFactory::objects();
             for (auto const& spindle : spindles) {
                 spindle->init();
@@ -131,11 +171,18 @@ void setup() {
             config->_probe->init();
         }
 
+        {
+            BootPhase phase("Motor config wait");
+            Axes::wait_config_motors();
+        }
+
     } catch (const AssertionFailed& ex) {
         // This means something is terribly broken:
         log_config_error("Critical error in main_init: " << ex.what());
     }
 
+    BootTiming::done();
+    Setting::endBootLoad();
     allChannels.ready();
     allChannels.deregistration(&startupLog);
     protocol_send_event(&startEvent);
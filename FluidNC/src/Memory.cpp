@@ -0,0 +1,25 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Memory.h"
+
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>  // esp_ptr_external_ram
+
+namespace Memory {
+    void* alloc(size_t size, Region region) {
+        if (region == Region::Bulk) {
+            void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (p) {
+                return p;
+            }
+        }
+        return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+
+    void free(void* p) { heap_caps_free(p); }
+
+    bool has_psram() { return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) != 0; }
+
+    bool in_psram(const void* p) { return esp_ptr_external_ram(p); }
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Memory.h - where large buffers are allocated
+
+  Modules with PSRAM have much more of it than internal RAM, but it is slower,
+  it is reached through the cache, and it cannot be touched while the cache is
+  off, as it is in an ISR during a flash write.  Large buffers that only tasks
+  use and that can stand the slower access, like file read-ahead, uploads and
+  the planner ring, ask for Bulk memory, which comes from PSRAM if there is any
+  and from internal RAM otherwise, leaving internal RAM for the network stacks.
+  Anything an ISR or DMA touches, or that is walked in a hot loop, asks for
+  Internal.  $Heap/Stats shows how much of each is free.
+*/
+
+#include <cstddef>
+
+namespace Memory {
+    enum class Region {
+        Internal,  // ISRs, DMA and hot data
+        Bulk,      // PSRAM if the module has it
+    };
+
+    // Returns nullptr if there is not enough memory
+    void* alloc(size_t size, Region region);
+    void  free(void* p);
+
+    bool has_psram();
+    bool in_psram(const void* p);
+}
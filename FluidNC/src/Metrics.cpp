@@ -0,0 +1,99 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Metrics.h"
+
+#include "Planner.h"  // plan_get_block_buffer_low_water()
+#include "Stepper.h"  // Stepper::segment_underruns()
+
+#include <esp_heap_caps.h>
+#include <atomic>
+#include <cstdio>
+
+namespace Metrics {
+    static const size_t maxAlarm = 32;
+
+    static std::atomic<uint32_t> _lines { 0 };
+    static std::atomic<uint32_t> _plannerUnderruns { 0 };
+    static std::atomic<uint32_t> _vfdErrors { 0 };
+    static std::atomic<uint32_t> _tmcErrors { 0 };
+    static std::atomic<uint32_t> _jobs { 0 };
+    static std::atomic<uint32_t> _jobMs { 0 };
+    static std::atomic<uint32_t> _alarms[maxAlarm];
+
+    void line_executed() { _lines.fetch_add(1, std::memory_order_relaxed); }
+    void planner_underrun() { _plannerUnderruns.fetch_add(1, std::memory_order_relaxed); }
+    void vfd_error() { _vfdErrors.fetch_add(1, std::memory_order_relaxed); }
+    void tmc_error() { _tmcErrors.fetch_add(1, std::memory_order_relaxed); }
+
+    void alarm(ExecAlarm alarm) {
+        size_t code = size_t(alarm);
+        if (code < maxAlarm) {
+            _alarms[code].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void job_done(uint32_t ms) {
+        _jobs.fetch_add(1, std::memory_order_relaxed);
+        _jobMs.fetch_add(ms, std::memory_order_relaxed);
+    }
+
+    static void header(std::string& out, const char* name, const char* help, const char* type) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    void counter(std::string& out, const char* name, const char* help, uint32_t value) {
+        char line[80];
+        header(out, name, help, "counter");
+        snprintf(line, sizeof(line), "%s %u\n", name, unsigned(value));
+        out += line;
+    }
+
+    void gauge(std::string& out, const char* name, const char* help, int32_t value) {
+        char line[80];
+        header(out, name, help, "gauge");
+        snprintf(line, sizeof(line), "%s %d\n", name, int(value));
+        out += line;
+    }
+
+    void write(std::string& out) {
+        char line[100];
+
+        counter(out, "fluidnc_lines_executed_total", "G-code and $ lines executed", _lines);
+        counter(out, "fluidnc_planner_underruns_total", "Times the planner ran empty while a job was moving", _plannerUnderruns);
+        counter(out, "fluidnc_segment_underruns_total", "Times the step segment buffer ran empty mid-motion", Stepper::segment_underruns());
+        gauge(out, "fluidnc_planner_free_min_blocks", "Fewest free planner blocks since a job started", plan_get_block_buffer_low_water());
+
+        header(out, "fluidnc_alarms_total", "Alarms by code", "counter");
+        for (auto const& [code, name] : AlarmNames) {
+            size_t i = size_t(code);
+            if (i && i < maxAlarm) {
+                unsigned count = _alarms[i];
+                snprintf(line, sizeof(line), "fluidnc_alarms_total{code=\"%u\",alarm=\"%s\"} %u\n", unsigned(i), name, count);
+                out += line;
+            }
+        }
+
+        gauge(out, "fluidnc_heap_free_bytes", "Free internal heap", heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+        gauge(out,
+              "fluidnc_heap_free_min_bytes",
+              "Low-water mark of the free internal heap",
+              heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+
+        counter(out, "fluidnc_jobs_total", "Jobs finished or stopped", _jobs);
+        header(out, "fluidnc_job_seconds_total", "Wall time spent in jobs", "counter");
+        snprintf(line, sizeof(line), "fluidnc_job_seconds_total %.3f\n", _jobMs / 1000.0);
+        out += line;
+
+        counter(out, "fluidnc_vfd_errors_total", "VFD exchanges without a valid response", _vfdErrors);
+        counter(out, "fluidnc_tmc_errors_total", "Faults reported by Trinamic drivers", _tmcErrors);
+    }
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Metrics.h - counters for monitoring many machines
+
+  The counters are bumped by the code that sees each event, in task context
+  and never in the step ISR, and the gauges are read from state that is kept
+  anyway, so nothing is formatted until /metrics is fetched.  write() renders
+  them in the Prometheus text exposition format.
+*/
+
+#include "Protocol.h"  // ExecAlarm
+
+#include <cstdint>
+#include <string>
+
+namespace Metrics {
+    void line_executed();
+    void alarm(ExecAlarm alarm);
+    void job_done(uint32_t ms);
+
+    // The planner ran empty while a job was moving, so the machine slowed for lack of lines
+    void planner_underrun();
+
+    // A VFD exchange that got no valid response
+    void vfd_error();
+
+    // A fault reported by a Trinamic driver
+    void tmc_error();
+
+    // Appends all metrics to out
+    void write(std::string& out);
+
+    // Append one metric, for those, like the Wi-Fi signal, that belong to other modules
+    void counter(std::string& out, const char* name, const char* help, uint32_t value);
+    void gauge(std::string& out, const char* name, const char* help, int32_t value);
+}
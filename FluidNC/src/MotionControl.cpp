@@ -13,8 +13,11 @@
 #include "Planner.h"         // plan_reset, etc
 #include "Platform.h"        // WEAK_LINK
 #include "Settings.h"        // coords
+#include "JobEstimate.h"     // JobEstimate::line()
 
+#include <algorithm>  // std::min, std::max
 #include <cmath>
+#include <cstring>  // memset
 
 // M_PI is not defined in standard C/C++ but some compilers
 // support it anyway.  The following suppresses Intellisense
@@ -51,22 +54,15 @@ bool mc_move_motors(float* target, plan_line_data_t* pl_data) {
 
     // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
     if (state_is(State::CheckMode)) {
+        if (JobEstimate::active()) {
+            JobEstimate::line(target, pl_data);
+        }
         mc_pl_data_inflight = NULL;
         return submitted_result;  // Bail, if system abort.
     }
-    // NOTE: Backlash compensation may be installed here. It will need direction info to track when
-    // to insert a backlash line motion(s) before the intended line motion and will require its own
-    // plan_check_full_buffer() and check for system abort loop. Also for position reporting
-    // backlash steps will need to be also tracked, which will need to be kept at a system level.
-    // There are likely some other things that will need to be tracked as well. However, we feel
-    // that backlash compensation should NOT be handled by the firmware itself, because there are a myriad
-    // of ways to implement it and can be effective or ineffective for different CNC machines. This
-    // would be better handled by the interface as a post-processor task, where the original g-code
-    // is translated and inserts backlash motions that best suits the machine.
-    // NOTE: Perhaps as a middle-ground, all that needs to be sent is a flag or special command that
-    // indicates to the firmware what is a backlash compensation motion, so that the move is executed
-    // without updating the machine position values. Since the position values used by the g-code
-    // parser and planner are separate from the system machine positions, this is doable.
+    // NOTE: Backlash compensation is done by the stepper, which adds uncounted take-up pulses
+    // to the first steps of a block that reverses an axis, so the planned lines and the
+    // machine position are those of the program.
     // If the buffer is full: good! That means we are well ahead of the robot.
     // Remain in this loop until there is room in the buffer.
 
@@ -119,9 +115,10 @@ bool mc_linear(float* target, plan_line_data_t* pl_data, float* position) {
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
 // for vector transformation direction.
-// The arc is approximated by generating a huge number of tiny, linear segments. The chordal tolerance
-// of each segment is configured in the arc_tolerance setting, which is defined to be the maximum normal
-// distance from segment to the circle when the end points both lie on the circle.
+// Unless it is planned as a native arc, the arc is approximated by generating a huge number of tiny,
+// linear segments. The chordal tolerance of each segment is configured in the arc_tolerance setting,
+// which is defined to be the maximum normal distance from segment to the circle when the end points
+// both lie on the circle.
 void mc_arc(float*            target,
             plan_line_data_t* pl_data,
             float*            position,
@@ -176,8 +173,42 @@ void mc_arc(float*            target,
     // (2x) arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
     // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
     // For most uses, this value should not exceed 2000.
-    uint16_t segments =
-        uint16_t(floorf(fabsf(0.5 * angular_travel * radius) / sqrtf(config->_arcTolerance * (2 * radius - config->_arcTolerance))));
+    float segments_f = floorf(fabsf(0.5 * angular_travel * radius) / sqrtf(config->_arcTolerance * (2 * radius - config->_arcTolerance)));
+    // Segments shorter than a couple of steps of the coarser plane axis follow the circle no more
+    // closely, they only add planner blocks; tight and helical arcs often reach that limit.
+    float min_segment_mm = 2.0f / std::min(Axes::_axis[axis_0]->_stepsPerMm, Axes::_axis[axis_1]->_stepsPerMm);
+    segments_f           = std::min(segments_f, floorf(fabsf(angular_travel * radius) / min_segment_mm));
+    uint16_t segments    = segments_f >= 1.0f ? uint16_t(std::min(segments_f, float(UINT16_MAX))) : 0;
+
+    // With native_arcs, an arc that would be several segments is one planner block instead.
+    // The stepper needs the circle to be a few steps across, and mostly in the plane, to get a
+    // step from every segment it preps.  M62/M63 Q changes are placed by distance along lines,
+    // and check mode only looks at lines, so those arcs are split into lines as before.
+    if (segments > 1 && plan_native_arcs() && config->_kinematics->native_arcs() && !pl_data->output_changes.count &&
+        !state_is(State::CheckMode)) {
+        float circular = angular_travel * radius;
+        float helix_sq = 0.0f;
+        for (size_t i = 0; i < n_axis; i++) {
+            if (i != axis_0 && i != axis_1) {
+                helix_sq += (target[i] - position[i]) * (target[i] - position[i]);
+            }
+        }
+        float steps_per_mm = std::min(Axes::_axis[axis_0]->_stepsPerMm, Axes::_axis[axis_1]->_stepsPerMm);
+        if (radius * steps_per_mm >= 2.0f && helix_sq <= 3.0f * circular * circular) {
+            while (plan_check_full_buffer()) {
+                protocol_auto_cycle_start();
+                protocol_execute_realtime();
+                if (sys.abort) {
+                    return;
+                }
+            }
+            plan_buffer_arc(target, pl_data, position, center, angular_travel, axis_0, axis_1);
+            return;
+        }
+    }
+
+    // Plan the whole arc at once rather than after every segment
+    PlanBatch batch;
     if (segments) {
         // Multiply inverse feed_rate to compensate for the fact that this movement is approximated
         // by a number of discrete segments. The inverse feed_rate should be correct for the sum of
@@ -264,13 +295,259 @@ void mc_arc(float*            target,
     mc_linear(target, pl_data, previous_position);
 }
 
-// Execute dwell in seconds.
-bool mc_dwell(int32_t milliseconds) {
-    if (milliseconds <= 0 || state_is(State::CheckMode)) {
+// Execute a cubic Bezier spline. The number of segments follows from the arc_tolerance setting:
+// for n equal steps of the curve parameter, no chord strays from the curve by more than
+// 3/4 * D / n^2, where D is the larger second difference of the control points.  That bound
+// is computed once, so the segment count is known before the first one is planned.
+void mc_spline(float* target, plan_line_data_t* pl_data, float* position, const float* control_1, const float* control_2) {
+    auto n_axis = Axes::_numberAxis;
+
+    float p0[2] = { position[X_AXIS], position[Y_AXIS] };
+    float d0    = hypot_f(p0[0] - 2 * control_1[0] + control_2[0], p0[1] - 2 * control_1[1] + control_2[1]);
+    float d1    = hypot_f(control_1[0] - 2 * control_2[0] + target[X_AXIS], control_1[1] - 2 * control_2[1] + target[Y_AXIS]);
+    float segments_f = ceilf(sqrtf(0.75f * std::max(d0, d1) / config->_arcTolerance));
+
+    // As for arcs, segments shorter than a couple of steps only add planner blocks.  The control
+    // polygon is never shorter than the curve.
+    float polygon = hypot_f(control_1[0] - p0[0], control_1[1] - p0[1]) +
+                    hypot_f(control_2[0] - control_1[0], control_2[1] - control_1[1]) +
+                    hypot_f(target[X_AXIS] - control_2[0], target[Y_AXIS] - control_2[1]);
+    float min_segment_mm = 2.0f / std::min(Axes::_axis[X_AXIS]->_stepsPerMm, Axes::_axis[Y_AXIS]->_stepsPerMm);
+    segments_f           = std::min(segments_f, floorf(polygon / min_segment_mm));
+    uint16_t segments    = segments_f >= 1.0f ? uint16_t(std::min(segments_f, float(UINT16_MAX))) : 0;
+
+    PlanBatch batch;
+    if (segments > 1) {
+        // The inverse feed rate applies to the sum of all segments, as in mc_arc().
+        if (pl_data->motion.inverseTime) {
+            pl_data->feed_rate *= segments;
+            pl_data->motion.inverseTime = 0;
+        }
+        float start[n_axis];
+        float previous_position[n_axis];
+        for (size_t i = 0; i < n_axis; i++) {
+            start[i]             = position[i];
+            previous_position[i] = position[i];
+        }
+        float original_feedrate = pl_data->feed_rate;  // Kinematics may alter the feedrate, so save an original copy
+        for (uint16_t i = 1; i < segments; i++) {
+            float t  = float(i) / segments;
+            float u  = 1.0f - t;
+            float b0 = u * u * u;
+            float b1 = 3 * u * u * t;
+            float b2 = 3 * u * t * t;
+            float b3 = t * t * t;
+            position[X_AXIS] = b0 * p0[0] + b1 * control_1[0] + b2 * control_2[0] + b3 * target[X_AXIS];
+            position[Y_AXIS] = b0 * p0[1] + b1 * control_1[1] + b2 * control_2[1] + b3 * target[Y_AXIS];
+            for (size_t axis = Z_AXIS; axis < n_axis; axis++) {
+                position[axis] = start[axis] + t * (target[axis] - start[axis]);
+            }
+            pl_data->feed_rate = original_feedrate;  // This restores the feedrate kinematics may have altered
+            mc_linear(position, pl_data, previous_position);
+            copyAxes(previous_position, position);
+            // Bail mid-curve on system abort. Runtime command check already performed by mc_linear.
+            if (sys.abort) {
+                return;
+            }
+        }
+    }
+    // Ensure last segment arrives at target location.
+    mc_linear(target, pl_data, position);
+}
+
+// Queue a dwell in the planner, so it executes in sequence with motion, timed by the stepper.
+// The stepper sets the speed of a synchronized move from the spindle encoder, so the
+// feed rate here, the speed at the programmed spindle speed, only guides the planner.
+bool mc_spindle_sync(float* target, plan_line_data_t* pl_data, float* position, float pitch) {
+    pl_data->motion.spindleSync    = 1;
+    pl_data->motion.noFeedOverride = 1;
+    pl_data->motion.inverseTime    = 0;
+    pl_data->sync_pitch            = pitch;
+    pl_data->feed_rate             = pitch * pl_data->spindle_speed;
+    return mc_linear(target, pl_data, position);
+}
+
+// The return move is queued right behind the feed, continuing its synchronized run, so
+// the tap backs out following the spindle as it reverses.  The spindle is reversed when
+// the tap reaches the bottom; what it turns while stopping is not followed, so the tap
+// holder needs a little axial float.
+void mc_rigid_tap(float* target, plan_line_data_t* pl_data, float* position, float pitch) {
+    float start[MAX_N_AXIS];
+    copyAxes(start, position);
+    mc_spindle_sync(target, pl_data, position, pitch);
+    pl_data->motion.syncReverse = 1;
+    mc_spindle_sync(start, pl_data, target, pitch);
+    if (state_is(State::CheckMode)) {
+        return;
+    }
+
+    // Wait for the bottom, along the axis that moves the farthest
+    size_t axis    = 0;
+    float  longest = 0.0f;
+    for (size_t idx = 0; idx < Axes::_numberAxis; idx++) {
+        float distance = fabsf(target[idx] - start[idx]);
+        if (distance > longest) {
+            longest = distance;
+            axis    = idx;
+        }
+    }
+    float tolerance = 1.0f / Axes::_axis[axis]->_stepsPerMm;
+    while (fabsf(get_mpos()[axis] - target[axis]) > tolerance) {
+        protocol_auto_cycle_start();
+        protocol_execute_realtime();
+        if (sys.abort) {
+            return;
+        }
+    }
+
+    SpindleState direction = pl_data->spindle;
+    spindle->deferDelay();  // The return move must run while the spindle reverses
+    spindle->setState(direction == SpindleState::Cw ? SpindleState::Ccw : SpindleState::Cw, pl_data->spindle_speed);
+    protocol_buffer_synchronize();
+    if (sys.abort) {
+        return;
+    }
+    spindle->setState(direction, pl_data->spindle_speed);
+}
+
+bool mc_dwell(uint32_t microseconds, plan_line_data_t* pl_data) {
+    if (microseconds == 0) {
         return false;
     }
+    if (state_is(State::CheckMode)) {
+        if (JobEstimate::active()) {
+            JobEstimate::dwell(microseconds, pl_data);
+        }
+        return false;
+    }
+    while (plan_check_full_buffer()) {
+        protocol_auto_cycle_start();  // Auto-cycle start when buffer is full.
+        protocol_execute_realtime();
+        if (sys.abort) {
+            return false;
+        }
+    }
+    return plan_buffer_dwell(microseconds, pl_data);
+}
+
+// How far G73 backs off to break the chip, and how far above the last peck G83 goes back to
+static const float peck_clearance = 0.25f;  // mm
+
+// Moves along the drilling axis only, updating position
+static void cycle_move(float height, plan_line_data_t* pl_data, float* position, size_t axis) {
+    if (position[axis] == height) {
+        return;
+    }
+    float target[MAX_N_AXIS];
+    copyAxes(target, position);
+    target[axis] = height;
+    mc_linear(target, pl_data, position);
+    copyAxes(position, target);
+}
+
+static void cycle_dwell(float seconds, plan_line_data_t* pl_data) {
+    if (seconds > 0.0f) {
+        mc_dwell(uint32_t(seconds * 1000000.0f), pl_data);
+    }
+}
+
+// Sets the spindle once the motion queued so far is done.  The change must be made at the bottom
+// of the hole, so unlike M3-M5 it is not left to the stepper.
+static void cycle_spindle(SpindleState state, SpindleSpeed speed) {
+    if (state_is(State::CheckMode)) {
+        return;
+    }
     protocol_buffer_synchronize();
-    return dwell_ms(milliseconds, DwellMode::Dwell);
+    if (!sys.abort) {
+        spindle->setState(state, speed);
+    }
+}
+
+void mc_canned_cycle(float* hole, plan_line_data_t* pl_data, float* position, const CannedCycle& cycle) {
+    // M62/M63 outputs switch as the first feed move starts
+    plan_line_data_t rapid     = *pl_data;
+    rapid.motion.rapidMotion   = 1;
+    rapid.outputs_mask         = 0;
+    rapid.output_changes.count = 0;
+
+    size_t       axis      = cycle.axis;
+    SpindleState direction = pl_data->spindle;
+    float        p[MAX_N_AXIS];
+    copyAxes(p, position);
+
+    // Up to R if below it, over the hole, and down to R
+    if (p[axis] < cycle.r) {
+        cycle_move(cycle.r, &rapid, p, axis);
+    }
+    float over[MAX_N_AXIS];
+    copyAxes(over, hole);
+    over[axis] = p[axis];
+    mc_linear(over, &rapid, p);
+    copyAxes(p, over);
+    cycle_move(cycle.r, &rapid, p, axis);
+
+    switch (cycle.mode) {
+        case Motion::DrillChipBreak:
+        case Motion::DrillPeck:
+            for (float depth = cycle.r; depth > cycle.bottom && !sys.abort;) {
+                depth = std::max(depth - cycle.peck, cycle.bottom);
+                cycle_move(depth, pl_data, p, axis);
+                if (depth > cycle.bottom) {
+                    if (cycle.mode == Motion::DrillPeck) {
+                        cycle_move(cycle.r, &rapid, p, axis);  // Clear the chips
+                    }
+                    cycle_move(std::min(depth + peck_clearance, cycle.r), &rapid, p, axis);
+                }
+            }
+            break;
+        case Motion::Drill:
+            cycle_move(cycle.bottom, pl_data, p, axis);
+            break;
+        case Motion::DrillDwell:
+            cycle_move(cycle.bottom, pl_data, p, axis);
+            cycle_dwell(cycle.dwell, pl_data);
+            break;
+        case Motion::Tap:
+            if (cycle.pitch > 0.0f) {
+                plan_line_data_t tap_data = *pl_data;  // mc_rigid_tap() sets the sync fields
+                float            bottom[MAX_N_AXIS];
+                copyAxes(bottom, p);
+                bottom[axis] = cycle.bottom;
+                mc_rigid_tap(bottom, &tap_data, p, cycle.pitch);
+            } else {
+                // A floating tap holder takes up the spindle stopping and reversing at the bottom
+                cycle_move(cycle.bottom, pl_data, p, axis);
+                cycle_dwell(cycle.dwell, pl_data);
+                cycle_spindle(direction == SpindleState::Cw ? SpindleState::Ccw : SpindleState::Cw, pl_data->spindle_speed);
+                cycle_move(cycle.r, pl_data, p, axis);
+                cycle_spindle(direction, pl_data->spindle_speed);
+            }
+            break;
+        case Motion::Bore:
+            cycle_move(cycle.bottom, pl_data, p, axis);
+            cycle_move(cycle.r, pl_data, p, axis);
+            break;
+        case Motion::BoreSpindleStop: {
+            cycle_move(cycle.bottom, pl_data, p, axis);
+            cycle_dwell(cycle.dwell, pl_data);
+            cycle_spindle(SpindleState::Disable, 0);
+            // The stepper sets the spindle speed of each block, so the way out must carry the stop
+            plan_line_data_t stopped = rapid;
+            stopped.spindle          = SpindleState::Disable;
+            stopped.spindle_speed    = 0;
+            cycle_move(cycle.clear, &stopped, p, axis);
+            cycle_spindle(direction, pl_data->spindle_speed);
+        } break;
+        case Motion::BoreDwell:
+            cycle_move(cycle.bottom, pl_data, p, axis);
+            cycle_dwell(cycle.dwell, pl_data);
+            cycle_move(cycle.r, pl_data, p, axis);
+            break;
+        default:
+            break;
+    }
+    cycle_move(cycle.clear, &rapid, p, axis);
+    copyAxes(hole, p);
 }
 
 volatile bool probing;
@@ -279,8 +556,14 @@ bool probe_succeeded = false;
 
 // Perform tool length probe cycle. Requires probe switch.
 // NOTE: Upon probe failure, the program will be stopped and placed into ALARM state.
-GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away, bool no_error, uint8_t offsetAxis, float offset) {
-    if (!config->_probe->exists()) {
+GCUpdatePos mc_probe_cycle(float*            target,
+                           plan_line_data_t* pl_data,
+                           bool              away,
+                           bool              no_error,
+                           uint8_t           offsetAxis,
+                           float             offset,
+                           ProbeInput        input) {
+    if (!config->_probe->exists(input)) {
         log_error("Probe pin is not configured");
         return GCUpdatePos::None;
     }
@@ -290,6 +573,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     }
     // Finish all queued commands and empty planner buffer before starting probe cycle.
     protocol_buffer_synchronize();
+    spindle->finishDelay();
     if (sys.abort) {
         return GCUpdatePos::None;  // Return if system reset has been issued.
     }
@@ -298,7 +582,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
 
     // Initialize probing control variables
     probe_succeeded = false;  // Re-initialize probe history before beginning cycle.
-    config->_probe->set_direction(away);
+    config->_probe->set_direction(away, input);
     // After syncing, check if probe is already triggered. If so, halt and issue alarm.
     // NOTE: This probe initialization error applies to all probing cycles.
     if (config->_probe->tripped()) {
@@ -328,6 +612,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     if (probing) {
         if (no_error) {
             get_motor_steps(probe_steps);
+            memset(probe_substeps, 0, sizeof(probe_substeps));
         } else {
             send_alarm(ExecAlarm::ProbeFailContact);
         }
@@ -352,7 +637,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
             float coord_data[MAX_N_AXIS];
             float probe_contact[MAX_N_AXIS];
 
-            motor_steps_to_mpos(probe_contact, probe_steps);
+            probe_steps_to_mpos(probe_contact);
             coords[gc_state.modal.coord_select]->get(coord_data);  // get a copy of the current coordinate offsets
             auto n_axis = Axes::_numberAxis;
             for (int axis = 0; axis < n_axis; axis++) {  // find the axis specified. There should only be one.
@@ -364,6 +649,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
             log_info("Probe offset applied:");
             coords[gc_state.modal.coord_select]->set(coord_data);  // save it
             copyAxes(gc_state.coord_system, coord_data);
+            gc_offsets_changed();
             report_wco_counter = 0;
         }
 
@@ -40,11 +40,45 @@ void mc_arc(float*            target,
             bool              is_clockwise_arc,
             int               pword_rotations);
 
-// Dwell for a specific number of seconds
-bool mc_dwell(int32_t milliseconds);
+// Execute a cubic Bezier spline in the XY plane from position to target, with control points
+// control_1 and control_2. Other axes move linearly. Used for G5 and, after degree elevation, G5.1.
+void mc_spline(float* target, plan_line_data_t* pl_data, float* position, const float* control_1, const float* control_2);
+
+// Execute a linear motion whose feed follows the spindle encoder, pitch mm per revolution. G33.
+bool mc_spindle_sync(float* target, plan_line_data_t* pl_data, float* position, float pitch);
+
+// Tap to target with the feed following the spindle, reverse the spindle, and return. G33.1.
+void mc_rigid_tap(float* target, plan_line_data_t* pl_data, float* position, float pitch);
+
+// Dwell for a specific number of microseconds, queued in the planner like a motion
+bool mc_dwell(uint32_t microseconds, plan_line_data_t* pl_data);
+
+// A canned cycle, G73 and G81-G89, as the parser resolves it.  Heights are machine mm along
+// the drilling axis, the one normal to the plane, and drilling goes toward lower values.
+struct CannedCycle {
+    Motion mode;
+    size_t axis;    // The drilling axis
+    float  r;       // The R plane, where feeding starts
+    float  bottom;  // The bottom of the hole
+    float  clear;   // Where the tool goes after the hole: R, or the starting height for G98
+    float  peck;    // Q, the depth of each peck of G73 and G83
+    float  dwell;   // P, seconds at the bottom for G82, G84, G86 and G89
+    float  pitch;   // mm per spindle revolution for G84 with a spindle encoder, else 0
+};
+
+// Drill one hole at the position of hole in the plane, starting from position.  The moves are
+// planned like any others, so the holes of a program run back to back.  hole is returned as
+// the position at the end of the cycle.
+void mc_canned_cycle(float* hole, plan_line_data_t* pl_data, float* position, const CannedCycle& cycle);
 
 // Perform tool length probe cycle. Requires probe switch.
-GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away, bool no_error, uint8_t offsetAxis, float offset);
+GCUpdatePos mc_probe_cycle(float*            target,
+                           plan_line_data_t* pl_data,
+                           bool              away,
+                           bool              no_error,
+                           uint8_t           offsetAxis,
+                           float             offset,
+                           ProbeInput        input = ProbeInput::Any);
 
 // Handles updating the override control state.
 void mc_override_ctrl_update(Override override_state);
@@ -125,12 +125,20 @@ namespace MotorDrivers {
         finish_write();
     }
 
-    // This is static; it updates the positions of all the Dynamixels on the UART bus
+    // This is static; it updates the positions of all the Dynamixels on the UART bus.
+    // Each cycle is one Sync Write for the servos that have torque and one Sync Read
+    // for those that do not, however many servos there are.
     void Dynamixel2::update_all() {
         if (_has_errors) {
             return;
         }
 
+        sync_write_goals();
+        sync_read_positions();
+    }
+
+    // Sync Write is a broadcast, so the servos do not answer it
+    void Dynamixel2::sync_write_goals() {
         start_message(DXL_BROADCAST_ID, DXL_SYNC_WRITE);
         add_uint16(DXL_GOAL_POSITION);
         add_uint16(4);  // data length
@@ -139,7 +147,11 @@ namespace MotorDrivers {
         float  motors[MAX_N_AXIS];
         config->_kinematics->transform_cartesian_to_motors(motors, mpos);
 
+        size_t count = 0;
         for (const auto& instance : _instances) {
+            if (instance->_disabled) {
+                continue;  // Its position is read instead
+            }
             float    dxl_count_min, dxl_count_max;
             uint32_t dxl_position;
 
@@ -153,8 +165,47 @@ namespace MotorDrivers {
 
             add_uint8(instance->_id);  // ID of the servo
             add_uint32(dxl_position);
+            ++count;
+        }
+        if (count) {
+            finish_message();
+        }
+    }
+
+    // A servo without torque can be moved by hand, so the machine position follows it.
+    // One Sync Read asks all of them, and they answer in the order of the IDs.
+    void Dynamixel2::sync_read_positions() {
+        start_message(DXL_BROADCAST_ID, DXL_SYNC_READ);
+        add_uint16(DXL_PRESENT_POSITION);
+        add_uint16(4);  // data length
+
+        size_t count = 0;
+        for (const auto& instance : _instances) {
+            if (instance->_disabled) {
+                add_uint8(instance->_id);
+                ++count;
+            }
+        }
+        if (!count) {
+            return;
         }
         finish_message();
+
+        bool moved = false;
+        for (const auto& instance : _instances) {
+            if (!instance->_disabled) {
+                continue;
+            }
+            if (dxl_get_response(POSITION_RSP_LEN) != POSITION_RSP_LEN || _rx_message[DXL_MSG_ID] != instance->_id) {
+                log_warn(instance->axisName() << " ID " << int(instance->_id) << " no position");
+                break;  // The rest of the answers are out of step
+            }
+            instance->set_position(_rx_message[9] | (_rx_message[10] << 8) | (_rx_message[11] << 16) | (_rx_message[12] << 24));
+            moved = true;
+        }
+        if (moved) {
+            plan_sync_position();
+        }
     }
     void Dynamixel2::update() {
         update_all();
@@ -206,7 +257,7 @@ namespace MotorDrivers {
         uint16_t msg_len = _msg_index - DXL_MSG_INSTR + 2;
 
         _tx_message[DXL_MSG_LEN_L] = msg_len & 0xff;
-        _tx_message[DXL_MSG_LEN_H] = (msg_len >> 8) * 0xff;
+        _tx_message[DXL_MSG_LEN_H] = (msg_len >> 8) & 0xff;
 
         uint16_t crc = 0;
         crc          = dxl_update_crc(crc, _tx_message, _msg_index);
@@ -230,19 +281,12 @@ namespace MotorDrivers {
 
         dxl_read(DXL_PRESENT_POSITION, data_len);
 
-        data_len = dxl_get_response(15);
+        data_len = dxl_get_response(POSITION_RSP_LEN);
 
-        if (data_len == 15) {
+        if (data_len == POSITION_RSP_LEN) {
             uint32_t dxl_position = _rx_message[9] | (_rx_message[10] << 8) | (_rx_message[11] << 16) | (_rx_message[12] << 24);
 
-            auto axis = Axes::_axis[_axis_index];
-
-            uint32_t pos_min_steps = mpos_to_steps(limitsMinPosition(_axis_index), _axis_index);
-            uint32_t pos_max_steps = mpos_to_steps(limitsMaxPosition(_axis_index), _axis_index);
-
-            uint32_t temp = myMap(dxl_position, _countMin, _countMax, pos_min_steps, pos_max_steps);
-
-            set_motor_steps(_axis_index, temp);
+            set_position(dxl_position);
 
             plan_sync_position();
 
@@ -252,6 +296,15 @@ namespace MotorDrivers {
         }
     }
 
+    void Dynamixel2::set_position(uint32_t dxl_position) {
+        uint32_t pos_min_steps = mpos_to_steps(limitsMinPosition(_axis_index), _axis_index);
+        uint32_t pos_max_steps = mpos_to_steps(limitsMaxPosition(_axis_index), _axis_index);
+
+        uint32_t temp = myMap(dxl_position, _countMin, _countMax, pos_min_steps, pos_max_steps);
+
+        set_motor_steps(_axis_index, temp);
+    }
+
     void Dynamixel2::dxl_read(uint16_t address, uint16_t data_len) {
         start_message(_id, DXL_READ);
         add_uint16(address);
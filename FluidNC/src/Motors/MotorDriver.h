@@ -26,6 +26,8 @@
 
 #include <cstdint>
 
+class FastPin;
+
 namespace MotorDrivers {
     class MotorDriver : public Configuration::Configurable {
         const char* _name;
@@ -59,9 +61,19 @@ namespace MotorDrivers {
         // make a motor transition between idle and non-idle states.
         virtual void set_disable(bool disable);
 
+        // A driver whose set_disable() does nothing but write a pin returns that pin, so
+        // that Axes can write the ones that share a GPIO register together.  Axes then
+        // writes the pin instead of calling set_disable().
+        virtual const FastPin* disable_pin() const { return nullptr; }
+
         // this is used to configure and test motors. This would be used for Trinamic
         virtual void config_motor() {}
 
+        // config_motor() may leave the work running on another task, so that motors
+        // on separate buses are configured at the same time.  wait_config() returns
+        // when that work is finished.
+        virtual void wait_config() {}
+
         // test(), called from init(), checks to see if a motor is
         // responsive, returning true on failure.  Typical
         // implementations also display messages to show the result.
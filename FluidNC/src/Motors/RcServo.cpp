@@ -21,6 +21,7 @@
 #include "../System.h"  // mpos_to_steps() etc
 #include "../Pin.h"
 #include "../Limits.h"  // limitsMaxPosition
+#include "../Stepping.h"
 #include "RcServoSettings.h"
 
 namespace MotorDrivers {
@@ -46,6 +47,9 @@ namespace MotorDrivers {
         _disabled = true;
 
         schedule_update(this, _timer_ms);
+        if (_segment_updates) {
+            schedule_segment_update(this);
+        }
     }
 
     void RcServo::config_message() {
@@ -53,7 +57,7 @@ namespace MotorDrivers {
                         << " period:" << _pwm->period() << ")");
     }
 
-    void RcServo::_write_pwm(uint32_t duty) {
+    void IRAM_ATTR RcServo::_write_pwm(uint32_t duty) {
         // to prevent excessive calls to pwmSetDuty, make sure duty has changed
         if (duty == _current_pwm_duty) {
             return;
@@ -97,6 +101,9 @@ namespace MotorDrivers {
     }
 
     void RcServo::update() {
+        if (_segment_updates && inMotionState()) {
+            return;  // update_from_ISR() keeps up with the motion
+        }
         set_location();
     }
 
@@ -122,9 +129,31 @@ namespace MotorDrivers {
         _write_pwm(servo_pulse_len);
     }
 
+    // The same mapping as set_location(), in integers because the ISR cannot
+    // use floating point.  Segments start every few milliseconds during motion,
+    // so the servo follows the motion more closely than the timer alone lets it.
+    void IRAM_ATTR RcServo::update_from_ISR() {
+        if (_disabled || _has_errors || _max_steps <= _min_steps) {
+            return;
+        }
+
+        int32_t steps = int32_t(Stepping::getSteps(_axis_index));
+        if (steps < _min_steps) {
+            steps = _min_steps;
+        } else if (steps > _max_steps) {
+            steps = _max_steps;
+        }
+
+        int64_t span = int64_t(_max_pulse_cnt) - int64_t(_min_pulse_cnt);  // Negative if inverted
+        _write_pwm(uint32_t(_min_pulse_cnt + (steps - _min_steps) * span / (_max_steps - _min_steps)));
+    }
+
     void RcServo::read_settings() {
         _min_pulse_cnt = (_min_pulse_us * ((_pwm_freq * _pwm->period()) / 1000)) / 1000;  // play some math games to prevent overflowing 32 bit
         _max_pulse_cnt = (_max_pulse_us * ((_pwm_freq * _pwm->period()) / 1000)) / 1000;
+
+        _min_steps = mpos_to_steps(limitsMinPosition(_axis_index), _axis_index);
+        _max_steps = mpos_to_steps(limitsMaxPosition(_axis_index), _axis_index);
     }
 
     // Configuration registration
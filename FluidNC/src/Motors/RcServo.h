@@ -29,6 +29,12 @@ namespace MotorDrivers {
         uint32_t _min_pulse_cnt = 0;  // microseconds
         uint32_t _max_pulse_cnt = 0;  // microseconds
 
+        // The travel in steps, for the integer math of update_from_ISR()
+        int32_t _min_steps = 0;
+        int32_t _max_steps = 0;
+
+        bool _segment_updates = false;  // Also update as each step segment starts
+
         int _axis_index = -1;
 
         bool _has_errors = false;
@@ -48,6 +54,7 @@ namespace MotorDrivers {
         bool set_homing_mode(bool isHoming) override;
         void set_disable(bool disable) override;
         void update() override;
+        void update_from_ISR() override;
 
         void _write_pwm(uint32_t duty);
 
@@ -58,6 +65,7 @@ namespace MotorDrivers {
             handler.item("min_pulse_us", _min_pulse_us, SERVO_PULSE_US_MIN, SERVO_PULSE_US_MAX);
             handler.item("max_pulse_us", _max_pulse_us, SERVO_PULSE_US_MIN, SERVO_PULSE_US_MAX);
             handler.item("timer_ms", _timer_ms);
+            handler.item("segment_updates", _segment_updates);
 
             Servo::group(handler);
         }
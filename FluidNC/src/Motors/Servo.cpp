@@ -21,24 +21,70 @@
 #include <atomic>
 
 namespace MotorDrivers {
-    void Servo::update_servo(TimerHandle_t timer) {
-        Servo* servo = static_cast<Servo*>(pvTimerGetTimerID(timer));
-        servo->update();
+    std::vector<Servo::Scheduled> Servo::_scheduled;
+    TimerHandle_t                 Servo::_timer   = nullptr;
+    int                           Servo::_tick_ms = 0;
+
+    Servo* Servo::_segment_servos[max_segment_servos];
+    int    Servo::_n_segment_servos = 0;
+
+    void Servo::update_servos(TimerHandle_t timer) {
+        for (auto& s : _scheduled) {
+            s.elapsed += _tick_ms;
+            if (s.elapsed >= s.interval) {
+                s.elapsed = 0;
+                s.servo->update();
+            }
+        }
+    }
+
+    static int gcd(int a, int b) {
+        while (b) {
+            int t = a % b;
+            a     = b;
+            b     = t;
+        }
+        return a;
     }
 
     void Servo::schedule_update(Servo* object, int interval) {
-        auto timer = xTimerCreate("",
-                                  interval,
+        if (interval < 1) {
+            interval = 1;
+        }
+        _scheduled.push_back({ object, interval, 0 });
+
+        int tick = _tick_ms ? gcd(_tick_ms, interval) : interval;
+        if (!_timer) {
+            _timer = xTimerCreate("Servos",
+                                  pdMS_TO_TICKS(tick),
                                   true,  // auto reload
-                                  (void*)object,
-                                  update_servo);
-        if (!timer) {
-            log_error("Failed to create timer for " << object->name());
+                                  nullptr,
+                                  update_servos);
+            if (!_timer) {
+                log_error("Failed to create the servo update timer");
+                return;
+            }
+            if (xTimerStart(_timer, 0) == pdFAIL) {
+                log_error("Failed to start the servo update timer");
+            }
+        } else if (tick != _tick_ms) {
+            xTimerChangePeriod(_timer, pdMS_TO_TICKS(tick), 0);
+        }
+        _tick_ms = tick;
+        log_info("    Update for " << object->name() << " every " << interval << " ms");
+    }
+
+    void Servo::schedule_segment_update(Servo* object) {
+        if (_n_segment_servos == max_segment_servos) {
+            log_error("Too many servos for segment updates; " << object->name() << " uses the timer only");
             return;
         }
-        if (xTimerStart(timer, 0) == pdFAIL) {
-            log_error("Failed to start timer for " << object->name());
+        _segment_servos[_n_segment_servos++] = object;
+    }
+
+    void IRAM_ATTR Servo::update_segment() {
+        for (int i = 0; i < _n_segment_servos; ++i) {
+            _segment_servos[i]->update_from_ISR();
         }
-        log_info("    Update timer for " << object->name() << " at " << interval << " ms");
     }
 }
@@ -4,15 +4,22 @@
 #pragma once
 #include <freertos/FreeRTOS.h>
 #include <freertos/timers.h>  // TimerHandle_t
+#include <esp_attr.h>         // IRAM_ATTR
 
 /*
     This is a base class for servo-type motors - ones that autonomously
     move to a specified position, instead of being moved incrementally
     by stepping.  Specific kinds of servo motors inherit from it.
+
+    All servos share one update timer.  Its period is the greatest common
+    divisor of the intervals the servos ask for, and each tick updates, in
+    one pass, the servos whose interval has come around.
 */
 
 #include "MotorDriver.h"
 
+#include <vector>
+
 namespace MotorDrivers {
     class Servo : public MotorDriver {
     public:
@@ -21,8 +28,30 @@ namespace MotorDrivers {
         virtual void update() = 0;  // This must be implemented by derived classes
         void         group(Configuration::HandlerBase& handler) override {}
 
+        // Called by the stepping ISR as each segment is loaded, for the servos
+        // that asked with schedule_segment_update().  No floating point here.
+        virtual void IRAM_ATTR update_from_ISR() {}
+        static void IRAM_ATTR  update_segment();
+
     protected:
-        static void update_servo(TimerHandle_t timer);
         static void schedule_update(Servo* object, int interval);
+        static void schedule_segment_update(Servo* object);
+
+    private:
+        struct Scheduled {
+            Servo* servo;
+            int    interval;  // ms
+            int    elapsed;   // ms since the last update
+        };
+
+        static std::vector<Scheduled> _scheduled;
+        static TimerHandle_t          _timer;
+        static int                    _tick_ms;
+
+        static const int max_segment_servos = 8;
+        static Servo*    _segment_servos[max_segment_servos];
+        static int       _n_segment_servos;
+
+        static void update_servos(TimerHandle_t timer);
     };
 }
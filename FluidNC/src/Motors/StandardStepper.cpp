@@ -33,6 +33,7 @@ namespace MotorDrivers {
         if (_disable_pin.defined()) {
             _disable_pin.setAttr(Pin::Attr::Output);
         }
+        _fast_disable.resolve(_disable_pin);
 
         if (_step_pin.canStep()) {
             Stepping::assignMotor(axisIndex, dualAxisIndex, _step_pin.index(), _step_pin.inverted(), _dir_pin.index(), _dir_pin.inverted());
@@ -44,7 +45,7 @@ namespace MotorDrivers {
     }
 
     void IRAM_ATTR StandardStepper::set_disable(bool disable) {
-        _disable_pin.synchronousWrite(disable);
+        _fast_disable.write(disable);
     }
 
     // Configuration registration
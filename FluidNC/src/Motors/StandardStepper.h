@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MotorDriver.h"
+#include "../FastPin.h"
 
 namespace MotorDrivers {
     class StandardStepper : public MotorDriver {
@@ -16,6 +17,8 @@ namespace MotorDrivers {
         bool set_homing_mode(bool isHoming) override { return true; }
         void set_disable(bool) override;
 
+        const FastPin* disable_pin() const override { return _fast_disable.native() ? &_fast_disable : nullptr; }
+
         void init_step_dir_pins();
 
     protected:
@@ -23,7 +26,8 @@ namespace MotorDrivers {
 
         Pin _step_pin;
         Pin _dir_pin;
-        Pin _disable_pin;
+        Pin     _disable_pin;
+        FastPin _fast_disable;  // Written from the stepper ISR
 
         // Configuration handlers:
         void validate() override;
@@ -26,9 +26,8 @@ namespace MotorDrivers {
         registration();
     }
 
-    void TMC2130Driver::config_motor() {
+    void TMC2130Driver::begin() {
         tmc2130->begin();
-        TrinamicBase::config_motor();
     }
 
     bool TMC2130Driver::test() {
@@ -99,6 +98,14 @@ namespace MotorDrivers {
                             << " mm/min SG_Setting:" << constrain(_stallguard, -64, 63));
     }
 
+    // SG_RESULT is DRV_STATUS bits 0-9 and CS_ACTUAL bits 16-20
+    bool TMC2130Driver::read_load(uint16_t& sg_result, uint8_t& cs_actual) {
+        uint32_t status = tmc2130->DRV_STATUS();
+        sg_result       = status & 0x3ff;
+        cs_actual       = (status >> 16) & 0x1f;
+        return true;
+    }
+
     void TMC2130Driver::set_disable(bool disable) {
         if (TrinamicSpiDriver::startDisable(disable)) {
             if (_use_enable) {
@@ -20,14 +20,15 @@ namespace MotorDrivers {
         // Overrides for inherited methods
         void init() override;
         void set_disable(bool disable);
-        void config_motor() override;
         void debug_message() override;
         void validate() override { StandardStepper::validate(); }
 
     private:
         TMC2130Stepper* tmc2130 = nullptr;
 
+        void begin() override;
         bool test();
+        bool read_load(uint16_t& sg_result, uint8_t& cs_actual) override;
         void set_registers(bool isHoming) override;
     };
 }
@@ -25,10 +25,10 @@ namespace MotorDrivers {
         registration();
     }
 
-    void TMC2208Driver::config_motor() {
+    void TMC2208Driver::configure() {
         _cs_pin.synchronousWrite(true);
         tmc2208->begin();
-        TrinamicBase::config_motor();
+        TrinamicUartDriver::configure();
         _cs_pin.synchronousWrite(false);
     }
 
@@ -62,14 +62,21 @@ namespace MotorDrivers {
 
     void TMC2208Driver::debug_message() {}
 
+    // The toff write is queued, not waited for
     void TMC2208Driver::set_disable(bool disable) {
-        _cs_pin.synchronousWrite(true);
         if (TrinamicUartDriver::startDisable(disable)) {
             if (_use_enable) {
-                tmc2208->toff(TrinamicUartDriver::toffValue());
+                _bus->post(
+                    [](TrinamicUartDriver* d, uint32_t toff) {
+                        auto tmc = static_cast<TMC2208Driver*>(d);
+                        tmc->_cs_pin.synchronousWrite(true);
+                        tmc->tmc2208->toff(toff);
+                        tmc->_cs_pin.synchronousWrite(false);
+                    },
+                    this,
+                    TrinamicUartDriver::toffValue());
             }
         }
-        _cs_pin.synchronousWrite(false);
     }
 
     bool TMC2208Driver::test() {
@@ -20,7 +20,7 @@ namespace MotorDrivers {
         // Overrides for inherited methods
         void init() override;
         void set_disable(bool disable);
-        void config_motor() override;
+        void configure() override;
         void debug_message() override;
         void validate() override { StandardStepper::validate(); }
 
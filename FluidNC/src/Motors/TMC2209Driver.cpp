@@ -26,10 +26,10 @@ namespace MotorDrivers {
         registration();
     }
 
-    void TMC2209Driver::config_motor() {
+    void TMC2209Driver::configure() {
         _cs_pin.synchronousWrite(true);
         tmc2209->begin();
-        TrinamicBase::config_motor();
+        TrinamicUartDriver::configure();
         _cs_pin.synchronousWrite(false);
     }
 
@@ -112,12 +112,28 @@ namespace MotorDrivers {
         _cs_pin.synchronousWrite(false);
     }
 
+    // CS_ACTUAL is DRV_STATUS bits 16-20
+    bool TMC2209Driver::read_chip_load(uint16_t& sg_result, uint8_t& cs_actual) {
+        _cs_pin.synchronousWrite(true);
+        sg_result = tmc2209->SG_RESULT();
+        cs_actual = (tmc2209->DRV_STATUS() >> 16) & 0x1f;
+        _cs_pin.synchronousWrite(false);
+        return true;
+    }
+
+    // The toff write is queued, not waited for
     void TMC2209Driver::set_disable(bool disable) {
         if (TrinamicUartDriver::startDisable(disable)) {
             if (_use_enable) {
-                _cs_pin.synchronousWrite(true);
-                tmc2209->toff(TrinamicUartDriver::toffValue());
-                _cs_pin.synchronousWrite(false);
+                _bus->post(
+                    [](TrinamicUartDriver* d, uint32_t toff) {
+                        auto tmc = static_cast<TMC2209Driver*>(d);
+                        tmc->_cs_pin.synchronousWrite(true);
+                        tmc->tmc2209->toff(toff);
+                        tmc->_cs_pin.synchronousWrite(false);
+                    },
+                    this,
+                    TrinamicUartDriver::toffValue());
             }
         }
     }
@@ -20,7 +20,7 @@ namespace MotorDrivers {
         // Overrides for inherited methods
         void init() override;
         void set_disable(bool disable);
-        void config_motor() override;
+        void configure() override;
         void debug_message() override;
         void validate() override { StandardStepper::validate(); }
 
@@ -48,5 +48,6 @@ namespace MotorDrivers {
 
         bool test();
         void set_registers(bool isHoming);
+        bool read_chip_load(uint16_t& sg_result, uint8_t& cs_actual) override;
     };
 }
@@ -26,9 +26,8 @@ namespace MotorDrivers {
         registration();
     }
 
-    void TMC5160Driver::config_motor() {
+    void TMC5160Driver::begin() {
         tmc5160->begin();
-        TrinamicBase::config_motor();
     }
 
     bool TMC5160Driver::test() {
@@ -108,6 +107,14 @@ namespace MotorDrivers {
                             << " mm/min SG_Setting:" << constrain(_stallguard, -64, 63));
     }
 
+    // SG_RESULT is DRV_STATUS bits 0-9 and CS_ACTUAL bits 16-20
+    bool TMC5160Driver::read_load(uint16_t& sg_result, uint8_t& cs_actual) {
+        uint32_t status = tmc5160->DRV_STATUS();
+        sg_result       = status & 0x3ff;
+        cs_actual       = (status >> 16) & 0x1f;
+        return true;
+    }
+
     void TMC5160Driver::set_disable(bool disable) {
         if (TrinamicSpiDriver::startDisable(disable)) {
             if (_use_enable) {
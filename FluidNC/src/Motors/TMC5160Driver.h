@@ -19,7 +19,6 @@ namespace MotorDrivers {
         // Overrides for inherited methods
         void init() override;
         void set_disable(bool disable);
-        void config_motor() override;
         void debug_message() override;
         void validate() override { StandardStepper::validate(); }
 
@@ -33,7 +32,9 @@ namespace MotorDrivers {
 
         uint8_t _tpfd = 4;
 
+        void begin() override;
         bool test();
+        bool read_load(uint16_t& sg_result, uint8_t& cs_actual) override;
         void set_registers(bool isHoming);
         void trinamic_test_response();
         void trinamic_stepper_enable(bool enable);
@@ -23,9 +23,8 @@ namespace MotorDrivers {
         registration();
     }
 
-    void TMC5160ProDriver::config_motor() {
+    void TMC5160ProDriver::begin() {
         tmc5160->begin();
-        TrinamicBase::config_motor();
     }
 
     bool TMC5160ProDriver::test() {
@@ -63,6 +62,14 @@ namespace MotorDrivers {
                             << " mm/min SG_Setting:" << constrain(_stallguard, -64, 63));
     }
 
+    // SG_RESULT is DRV_STATUS bits 0-9 and CS_ACTUAL bits 16-20
+    bool TMC5160ProDriver::read_load(uint16_t& sg_result, uint8_t& cs_actual) {
+        uint32_t status = tmc5160->DRV_STATUS();
+        sg_result       = status & 0x3ff;
+        cs_actual       = (status >> 16) & 0x1f;
+        return true;
+    }
+
     void TMC5160ProDriver::set_disable(bool disable) {
         if (TrinamicSpiDriver::startDisable(disable)) {
             if (_use_enable) {  // use the register to disable the driver
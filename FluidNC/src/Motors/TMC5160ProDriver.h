@@ -32,7 +32,6 @@ namespace MotorDrivers {
         // Overrides for inherited methods
         void init() override;
         void set_disable(bool disable);
-        void config_motor() override;
         void debug_message() override;
         void validate() override { StandardStepper::validate(); }
 
@@ -63,7 +62,9 @@ namespace MotorDrivers {
         uint32_t PWMCONF    = 3289120798;
         uint32_t IHOLD_IRUN = 7948;
 
+        void begin() override;
         bool test();
+        bool read_load(uint16_t& sg_result, uint8_t& cs_actual) override;
         void set_registers(bool isHoming);
     };
 }
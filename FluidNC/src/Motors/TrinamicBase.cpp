@@ -3,6 +3,8 @@
 
 #include "TrinamicBase.h"
 #include "../Machine/MachineConfig.h"
+#include "../BootTiming.h"
+#include "../Metrics.h"
 
 #include <atomic>
 
@@ -21,7 +23,7 @@ namespace MotorDrivers {
             for (TrinamicBase* t : _instances) {
                 if (t->_stallguardDebugMode) {
                     //log_info("SG:" << t->_stallguardDebugMode);
-                    t->debug_message();
+                    t->poll_stallguard();
                 }
             }
         }
@@ -46,6 +48,7 @@ namespace MotorDrivers {
 
     bool TrinamicBase::report_open_load(bool ola, bool olb) {
         if (ola || olb) {
+            Metrics::tmc_error();
             log_warn("    Driver Open Load a:" << yn(ola) << " b:" << yn(olb));
             return true;
         }
@@ -54,6 +57,7 @@ namespace MotorDrivers {
 
     bool TrinamicBase::report_short_to_ground(bool s2ga, bool s2gb) {
         if (s2ga || s2gb) {
+            Metrics::tmc_error();
             log_warn("    Driver Short Coil a:" << yn(s2ga) << " b:" << yn(s2gb));
         }
         return false;  // no error
@@ -61,6 +65,7 @@ namespace MotorDrivers {
 
     bool TrinamicBase::report_over_temp(bool ot, bool otpw) {
         if (ot || otpw) {
+            Metrics::tmc_error();
             log_warn("    Driver Temp Warning:" << yn(otpw) << " Fault:" << yn(ot));
             return true;
         }
@@ -70,6 +75,7 @@ namespace MotorDrivers {
     bool TrinamicBase::report_short_to_ps(bool vsa, bool vsb) {
         // check for short to power supply
         if (vsa || vsb) {
+            Metrics::tmc_error();
             log_warn("    Driver Short vsa:" << yn(vsa) << " vsb:" << yn(vsb));
             return true;
         }
@@ -95,6 +101,9 @@ namespace MotorDrivers {
     }
 
     bool TrinamicBase::reportTest(uint8_t result) {
+        if (result == 1 || result == 2) {
+            Metrics::tmc_error();
+        }
         switch (result) {
             case 1:
                 log_error(axisName() << " driver test failed. Check connection");
@@ -110,6 +119,7 @@ namespace MotorDrivers {
 
     bool TrinamicBase::checkVersion(uint8_t expected, uint8_t got) {
         if (expected != got) {
+            Metrics::tmc_error();
             log_error(axisName() << " TMC driver not detected - expected " << to_hex(expected) << " got " << to_hex(got));
             return false;
         }
@@ -142,6 +152,7 @@ namespace MotorDrivers {
     }
 
     void TrinamicBase::config_motor() {
+        BootPhase phase("Trinamic config");
         _has_errors = !test();  // Try communicating with motor. Prints an error if there is a problem.
 
         if (_has_errors) {
@@ -165,6 +176,9 @@ namespace MotorDrivers {
         }
 
         _instances.push_back(this);
+        if (_loadLimitSg) {
+            TrinamicTelemetry::start();
+        }
 
         config_message();
     }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "StandardStepper.h"
+#include "TrinamicTelemetry.h"
 #include "../EnumItem.h"
 #include <TMCStepper.h>  // https://github.com/teemuatlut/TMCStepper
 #include <cstdint>
@@ -20,6 +21,8 @@ namespace MotorDrivers {
 
     class TrinamicBase : public StandardStepper {
     private:
+        friend class TrinamicTelemetry;
+
         static void read_sg(TimerHandle_t);
 
         static std::vector<TrinamicBase*> _instances;
@@ -45,6 +48,9 @@ namespace MotorDrivers {
         int   _microsteps          = 16;
         int   _stallguard          = 0;
         bool  _stallguardDebugMode = false;
+        int   _loadLimitSg         = 0;  // SG_RESULT below which the feed is reduced
+
+        LoadLimiter _loadLimiter;
 
         uint8_t _toff_disable     = 0;
         uint8_t _toff_stealthchop = 5;
@@ -65,6 +71,10 @@ namespace MotorDrivers {
         bool         startDisable(bool disable);
         void         init() override;
         virtual void config_motor();
+        virtual void poll_stallguard() { debug_message(); }
+
+        // SG_RESULT and CS_ACTUAL for telemetry, or false if the driver cannot report them
+        virtual bool read_load(uint16_t& sg_result, uint8_t& cs_actual) { return false; }
 
         const char* yn(bool v) { return v ? "Y" : "N"; }
 
@@ -73,6 +83,9 @@ namespace MotorDrivers {
     public:
         TrinamicBase(const char* name) : StandardStepper(name) {}
 
+        // set_disable() also tracks the state and may write TOFF over the bus
+        const FastPin* disable_pin() const override { return nullptr; }
+
         void group(Configuration::HandlerBase& handler) override {
             StandardStepper::group(handler);
 
@@ -83,6 +96,7 @@ namespace MotorDrivers {
             handler.item("toff_disable", _toff_disable, 0, 15);
             handler.item("toff_stealthchop", _toff_stealthchop, 2, 15);
             handler.item("use_enable", _use_enable);
+            handler.item("load_limit_sg", _loadLimitSg, 0, 1023);
         }
     };
 
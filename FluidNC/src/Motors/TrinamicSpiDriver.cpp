@@ -8,6 +8,7 @@
 #include "TrinamicSpiDriver.h"
 #include "../Machine/MachineConfig.h"
 #include <TMCStepper.h>  // https://github.com/teemuatlut/TMCStepper
+#include "esp32/tmc_spi_support.h"
 #include <atomic>
 
 namespace MotorDrivers {
@@ -15,8 +16,52 @@ namespace MotorDrivers {
     pinnum_t TrinamicSpiDriver::daisy_chain_cs_id = 255;
     uint8_t  TrinamicSpiDriver::spi_index_mask    = 0;
 
+    std::vector<TrinamicSpiDriver*> TrinamicSpiDriver::_chain;
+    size_t                          TrinamicSpiDriver::_chain_waiting = 0;
+
     void TrinamicSpiDriver::init() {
         TrinamicBase::init();
+        if (_spi_index != -1) {
+            _chain.push_back(this);
+        }
+    }
+
+    void TrinamicSpiDriver::config_motor() {
+        if (_spi_index == -1) {
+            begin();
+            TrinamicBase::config_motor();
+            return;
+        }
+
+        // The daisy-chained drivers are configured together, when the
+        // last of them is reached, so that their register writes can
+        // share SPI frames.
+        if (++_chain_waiting < _chain.size()) {
+            return;
+        }
+        _chain_waiting = 0;
+        config_chain();
+    }
+
+    void TrinamicSpiDriver::config_chain() {
+        tmc_spi_chain_begin();
+        for (auto driver : _chain) {
+            driver->begin();
+        }
+        tmc_spi_chain_end();
+
+        // Reads cannot share frames, so the drivers are tested one by one
+        for (auto driver : _chain) {
+            driver->_has_errors = !driver->test();
+        }
+
+        tmc_spi_chain_begin();
+        for (auto driver : _chain) {
+            if (!driver->_has_errors) {
+                driver->set_registers(false);
+            }
+        }
+        tmc_spi_chain_end();
     }
 
     uint8_t TrinamicSpiDriver::setupSPI() {
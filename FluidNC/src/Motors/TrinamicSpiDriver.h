@@ -8,6 +8,7 @@
 #include "../PinMapper.h"
 
 #include <cstdint>
+#include <vector>
 
 const int NORMAL_TCOOLTHRS = 0xFFFFF;  // 20 bit is max
 const int NORMAL_THIGH     = 0;
@@ -21,6 +22,7 @@ namespace MotorDrivers {
 
         // Overrides for inherited methods
         virtual void init() override;
+        void         config_motor() override;
         //bool         set_homing_mode(bool ishoming) override;
 
         // Configuration handlers:
@@ -74,6 +76,9 @@ namespace MotorDrivers {
 
         void config_message() override;
 
+        // Resets the chip and loads the library's register defaults
+        virtual void begin() = 0;
+
         uint8_t setupSPI();
 
         bool    reportTest(uint8_t result);
@@ -83,6 +88,11 @@ namespace MotorDrivers {
         static pinnum_t daisy_chain_cs_id;
         static uint8_t  spi_index_mask;
 
+        static std::vector<TrinamicSpiDriver*> _chain;  // The daisy-chained drivers
+        static size_t                          _chain_waiting;
+
+        static void config_chain();
+
         PinMapper _cs_mapping;
     };
 
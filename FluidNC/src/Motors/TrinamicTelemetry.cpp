@@ -0,0 +1,155 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "TrinamicTelemetry.h"
+#include "TrinamicBase.h"
+
+#include "../Config.h"  // FeedOverride
+#include "../Channel.h"
+#include "../Logging.h"
+#include "../Machine/Tasks.h"
+#include "../Protocol.h"  // protocol_send_event(), loadOverrideEvent
+#include "../Stepper.h"   // Stepper::get_realtime_rate()
+#include "../System.h"    // sys, inMotionState()
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace MotorDrivers {
+    static SampleRing<TrinamicTelemetry::ringSize> ring;
+
+    static bool     started   = false;
+    static bool     capturing = false;
+    static uint32_t rate      = TrinamicTelemetry::defaultRate;
+
+    // Smaller changes of the load limit are not worth replanning for
+    static const int loadStep = 5;
+
+    static void publish(int percent) {
+        int current = sys.load_override;
+        if (percent != current && (percent == FeedOverride::Default || std::abs(percent - current) >= loadStep)) {
+            protocol_send_event(&loadOverrideEvent, percent);
+        }
+    }
+
+    void TrinamicTelemetry::sample() {
+        auto& drivers = TrinamicBase::_instances;
+        if (!inMotionState()) {
+            for (auto driver : drivers) {
+                driver->_loadLimiter.reset();
+            }
+            publish(FeedOverride::Default);
+            return;
+        }
+
+        uint32_t now     = uint32_t(esp_timer_get_time());
+        float    feed    = Stepper::get_realtime_rate();
+        int      percent = FeedOverride::Default;
+        for (size_t i = 0; i < drivers.size(); ++i) {
+            auto driver = drivers[i];
+            if (driver->_has_errors || !(capturing || driver->_loadLimitSg)) {
+                continue;
+            }
+            uint16_t sg_result;
+            uint8_t  cs_actual;
+            if (!driver->read_load(sg_result, cs_actual)) {
+                continue;
+            }
+            if (capturing) {
+                ring.push({ now, feed, sg_result, cs_actual, uint8_t(i) });
+            }
+            if (driver->_loadLimitSg) {
+                int limit = driver->_loadLimiter.update(sg_result, driver->_loadLimitSg, FeedOverride::Min);
+                if (limit < percent) {
+                    percent = limit;
+                }
+            }
+        }
+        publish(percent);
+    }
+
+    void TrinamicTelemetry::task(void* arg) {
+        TickType_t wake = xTaskGetTickCount();
+        while (true) {
+            TickType_t period = pdMS_TO_TICKS(1000 / rate);
+            vTaskDelayUntil(&wake, period ? period : 1);
+            sample();
+        }
+    }
+
+    void TrinamicTelemetry::start() {
+        if (started) {
+            return;
+        }
+        started = true;
+        if (Machine::Tasks::create("tmc_telemetry", task, nullptr) != pdPASS) {
+            log_error("Failed to start the Trinamic telemetry task");
+        }
+    }
+
+    void TrinamicTelemetry::drain_csv(Channel& out) {
+        auto&           drivers = TrinamicBase::_instances;
+        TelemetrySample s;
+        log_stream(out, "time_us,axis,sg_result,cs_actual,rate");
+        while (ring.pop(s)) {
+            std::string axis = s.motor < drivers.size() ? drivers[s.motor]->axisName() : "?";
+            log_stream(out, s.time_us << "," << axis << "," << int(s.sg_result) << "," << int(s.cs_actual) << "," << s.rate);
+        }
+    }
+
+    // A header line with the byte count, then the samples as they are in memory,
+    // which is little-endian with the layout of TelemetrySample
+    void TrinamicTelemetry::drain_binary(Channel& out) {
+        size_t count = ring.size();
+        log_stream(out, "[TLM:" << count << "*" << sizeof(TelemetrySample) << "]");
+        TelemetrySample s;
+        while (count-- && ring.pop(s)) {
+            out.write(reinterpret_cast<const uint8_t*>(&s), sizeof(s));
+        }
+    }
+
+    // $Motors/Telemetry[=ON|<Hz>|OFF|CSV|BIN]
+    Error TrinamicTelemetry::command(const char* value, Channel& out) {
+        if (!value || !*value) {
+            log_info_to(out,
+                        "Telemetry " << (capturing ? "on" : "off") << " at " << rate << " Hz samples:" << ring.size()
+                                     << " dropped:" << ring.dropped() << " load limit:" << int(sys.load_override) << "%");
+            return Error::Ok;
+        }
+        if (strcasecmp(value, "CSV") == 0) {
+            drain_csv(out);
+            return Error::Ok;
+        }
+        if (strcasecmp(value, "BIN") == 0) {
+            drain_binary(out);
+            return Error::Ok;
+        }
+        if (strcasecmp(value, "OFF") == 0) {
+            capturing = false;
+            return Error::Ok;
+        }
+
+        uint32_t hz = defaultRate;
+        if (strcasecmp(value, "ON") != 0) {
+            char* endptr;
+            hz = strtoul(value, &endptr, 10);
+            if (endptr == value || *endptr != '\0') {
+                return Error::InvalidValue;
+            }
+            if (hz == 0 || hz > maxRate) {
+                return Error::NumberRange;
+            }
+        }
+        capturing = false;
+        vTaskDelay(pdMS_TO_TICKS(1000 / rate + 1));  // Let a sample in progress finish
+        ring.clear();
+        rate      = hz;
+        capturing = true;
+        start();
+        return Error::Ok;
+    }
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  TrinamicTelemetry.h - load capture from Trinamic drivers
+
+  While a capture is on, a task reads SG_RESULT and CS_ACTUAL from every Trinamic
+  driver that can report them, at 100 Hz or more, and queues timestamped samples in a
+  ring.  $Motors/Telemetry=CSV or =BIN drains the ring to the channel that asks, so a
+  host can collect the trace of a homing run for tuning the stallguard thresholds.
+
+  The same samples drive a feed limit.  A motor with load_limit_sg set reduces the feed
+  in proportion as its filtered SG_RESULT drops below that value, which is how the
+  driver reports a rising load.  The limit is applied in the planner with the feed
+  override, and goes back to 100% when the load does.
+
+  The ring and the limiter have no dependencies so that they can be checked on the host.
+*/
+
+#include "../Error.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class Channel;
+
+namespace MotorDrivers {
+    struct TelemetrySample {
+        uint32_t time_us;    // esp_timer_get_time(), wrapped
+        float    rate;       // Feed rate in mm/min
+        uint16_t sg_result;  // 0 for drivers without stallguard
+        uint8_t  cs_actual;  // Current scale 0..31
+        uint8_t  motor;      // Index in the list of Trinamic drivers
+    };
+
+    // One task fills the ring and another drains it, so there is no locking.
+    // Samples that arrive while the ring is full are counted and dropped.
+    template <size_t Capacity>
+    class SampleRing {
+        static_assert((Capacity & (Capacity - 1)) == 0, "SampleRing capacity must be a power of 2");
+
+        TelemetrySample     _data[Capacity];
+        std::atomic<size_t> _head { 0 };  // Total samples pushed
+        std::atomic<size_t> _tail { 0 };  // Total samples popped
+        uint32_t            _dropped = 0;
+
+    public:
+        static const size_t capacity = Capacity;
+
+        size_t   size() const { return _head - _tail; }
+        bool     empty() const { return _head == _tail; }
+        uint32_t dropped() const { return _dropped; }
+
+        // Only while neither task is using the ring
+        void clear() {
+            _head    = 0;
+            _tail    = 0;
+            _dropped = 0;
+        }
+
+        bool push(const TelemetrySample& sample) {
+            size_t head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) == Capacity) {
+                ++_dropped;
+                return false;
+            }
+            _data[head & (Capacity - 1)] = sample;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(TelemetrySample& sample) {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail == _head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            sample = _data[tail & (Capacity - 1)];
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    // Feed percent from SG_RESULT.  Stallguard readings are noisy, so they are
+    // filtered first; the feed then follows filtered / limit down to min_percent.
+    class LoadLimiter {
+        float _filtered = -1.0f;  // Negative until the first reading
+
+    public:
+        static constexpr float smoothing = 0.2f;  // Weight of each new reading
+
+        void reset() { _filtered = -1.0f; }
+
+        int update(uint16_t sg_result, uint16_t limit, int min_percent) {
+            if (_filtered < 0.0f) {
+                _filtered = sg_result;
+            } else {
+                _filtered += smoothing * (sg_result - _filtered);
+            }
+            if (limit == 0 || _filtered >= limit) {
+                return 100;
+            }
+            int percent = int(100.0f * _filtered / limit);
+            return percent < min_percent ? min_percent : percent;
+        }
+    };
+
+    class TrinamicTelemetry {
+    public:
+        static const size_t ringSize = 1024;
+
+        static const uint32_t defaultRate = 100;  // Hz
+        static const uint32_t maxRate     = 500;
+
+        // Starts the sampling task if it is not running
+        static void start();
+
+        static Error command(const char* value, Channel& out);
+
+    private:
+        static void sample();
+        static void task(void* arg);
+        static void drain_csv(Channel& out);
+        static void drain_binary(Channel& out);
+    };
+}
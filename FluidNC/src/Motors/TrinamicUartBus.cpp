@@ -0,0 +1,129 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "TrinamicUartBus.h"
+#include "TrinamicUartDriver.h"
+
+#include "../Logging.h"
+#include "../Machine/Tasks.h"
+
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+namespace MotorDrivers {
+    std::vector<TrinamicUartBus*> TrinamicUartBus::_buses;
+
+    TrinamicUartBus::TrinamicUartBus(int uart_num) : _uart_num(uart_num) {
+        _queue   = xQueueCreate(queueDepth, sizeof(Job));
+        _done    = xSemaphoreCreateBinary();
+        _waiting = xSemaphoreCreateMutex();
+        if (!_queue || !_done || !_waiting || Machine::Tasks::create("tmc_uart", task, this) != pdPASS) {
+            log_error("Failed to start the Trinamic task for UART" << uart_num);
+        }
+    }
+
+    TrinamicUartBus* TrinamicUartBus::get(int uart_num) {
+        for (auto bus : _buses) {
+            if (bus->_uart_num == uart_num) {
+                return bus;
+            }
+        }
+        auto bus = new TrinamicUartBus(uart_num);
+        _buses.push_back(bus);
+        return bus;
+    }
+
+    void TrinamicUartBus::add(TrinamicUartDriver* driver) {
+        _stats.push_back({ driver, 0, 0, 0 });
+    }
+
+    TrinamicUartBus::Stats* TrinamicUartBus::stats(TrinamicUartDriver* driver) {
+        for (auto& s : _stats) {
+            if (s.driver == driver) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    void TrinamicUartBus::post(Action action, TrinamicUartDriver* driver, uint32_t arg) {
+        Job job { action, driver, arg, esp_timer_get_time(), false };
+        xQueueSend(_queue, &job, portMAX_DELAY);
+    }
+
+    void TrinamicUartBus::run(Action action, TrinamicUartDriver* driver, uint32_t arg) {
+        xSemaphoreTake(_waiting, portMAX_DELAY);
+        Job job { action, driver, arg, esp_timer_get_time(), true };
+        xQueueSend(_queue, &job, portMAX_DELAY);
+        xSemaphoreTake(_done, portMAX_DELAY);
+        xSemaphoreGive(_waiting);
+    }
+
+    // Jobs run in order, so an empty job finishes after every job queued before it
+    void TrinamicUartBus::sync() {
+        run([](TrinamicUartDriver*, uint32_t) {}, nullptr);
+    }
+
+    // Called from the timer task, so it must not wait
+    void TrinamicUartBus::poll_stallguard() {
+        if (_pollQueued.exchange(true)) {
+            return;  // The one already queued will do
+        }
+        Job job { nullptr, nullptr, 0, esp_timer_get_time(), false };
+        if (xQueueSend(_queue, &job, 0) != pdTRUE) {
+            _pollQueued = false;
+        }
+    }
+
+    void TrinamicUartBus::record(Stats& s, int64_t queued) {
+        uint32_t us = uint32_t(esp_timer_get_time() - queued);
+        ++s.count;
+        s.last_us = us;
+        if (us > s.max_us) {
+            s.max_us = us;
+        }
+    }
+
+    void TrinamicUartBus::execute(const Job& job) {
+        if (job.action) {
+            job.action(job.driver, job.arg);
+            Stats* s = stats(job.driver);
+            if (s) {
+                record(*s, job.queued);
+            }
+            return;
+        }
+
+        _pollQueued = false;
+        for (auto& s : _stats) {
+            if (s.driver->_stallguardDebugMode) {
+                s.driver->debug_message();
+                record(s, job.queued);
+            }
+        }
+    }
+
+    void TrinamicUartBus::task(void* arg) {
+        auto bus = static_cast<TrinamicUartBus*>(arg);
+        while (true) {
+            Job job;
+            if (!xQueueReceive(bus->_queue, &job, portMAX_DELAY)) {
+                continue;
+            }
+            bus->execute(job);
+            if (job.wait) {
+                xSemaphoreGive(bus->_done);
+            }
+        }
+    }
+
+    void TrinamicUartBus::report(Channel& out) {
+        for (auto bus : _buses) {
+            for (auto& s : bus->_stats) {
+                log_stream(out,
+                           "UART" << bus->_uart_num << " " << s.driver->axisName() << " addr:" << int(s.driver->_addr)
+                                  << " transactions:" << s.count << " last:" << s.last_us << "us max:" << s.max_us << "us");
+            }
+        }
+    }
+}
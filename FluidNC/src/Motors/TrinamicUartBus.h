@@ -0,0 +1,85 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  TrinamicUartBus.h - one task per UART for the register traffic of Trinamic drivers
+
+  Several drivers can share a UART by address, and every register access is a round
+  trip on that wire.  A bus serializes the accesses for all the drivers on its UART in
+  a task of its own, so the callers only queue them.  Writes, such as the toff change
+  on enable and disable, are queued and not waited for, so a run of them goes out back
+  to back.  Stallguard polls are coalesced: however many are requested while one is
+  waiting, it reads every driver on the bus that reports stallguard in a single pass.
+  Calls that must finish before the caller can go on, like the homing mode change,
+  wait for their turn.
+
+  The time from queueing to completion is kept per driver for $TrinamicUart/Stats.
+*/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class Channel;
+
+namespace MotorDrivers {
+    class TrinamicUartDriver;
+
+    class TrinamicUartBus {
+    public:
+        using Action = void (*)(TrinamicUartDriver* driver, uint32_t arg);
+
+        // The bus for a UART, created with its task on first use
+        static TrinamicUartBus* get(int uart_num);
+
+        void add(TrinamicUartDriver* driver);
+
+        void post(Action action, TrinamicUartDriver* driver, uint32_t arg = 0);  // Does not wait
+        void run(Action action, TrinamicUartDriver* driver, uint32_t arg = 0);   // Waits until done
+        void sync();                                                             // Waits for all queued jobs
+        void poll_stallguard();
+
+        static void report(Channel& out);
+
+    private:
+        struct Job {
+            Action              action;  // nullptr for a stallguard poll
+            TrinamicUartDriver* driver;
+            uint32_t            arg;
+            int64_t             queued;  // esp_timer_get_time()
+            bool                wait;
+        };
+
+        struct Stats {
+            TrinamicUartDriver* driver;
+            uint32_t            count;
+            uint32_t            last_us;
+            uint32_t            max_us;
+        };
+
+        static const int queueDepth = 16;
+
+        static std::vector<TrinamicUartBus*> _buses;
+
+        int                _uart_num;
+        QueueHandle_t      _queue;
+        SemaphoreHandle_t  _done;     // Given when a waited-for job finishes
+        SemaphoreHandle_t  _waiting;  // Held by the caller of run()
+        std::vector<Stats> _stats;
+        std::atomic<bool>  _pollQueued { false };
+
+        TrinamicUartBus(int uart_num);
+
+        void   execute(const Job& job);
+        Stats* stats(TrinamicUartDriver* driver);
+        void   record(Stats& s, int64_t queued);
+
+        static void task(void* arg);
+    };
+}
@@ -24,9 +24,33 @@ namespace MotorDrivers {
         Assert(_uart, "TMC Driver missing uart%d section", _uart_num);
 
         _cs_pin.setAttr(Pin::Attr::Output);
+        _bus = TrinamicUartBus::get(_uart_num);
+        _bus->add(this);
         TrinamicBase::init();
     }
 
+    void TrinamicUartDriver::config_motor() {
+        _bus->post([](TrinamicUartDriver* d, uint32_t) { d->configure(); }, this);
+    }
+
+    void TrinamicUartDriver::wait_config() {
+        _bus->sync();
+    }
+
+    // Homing must not start until the drivers are in homing mode
+    bool TrinamicUartDriver::set_homing_mode(bool isHoming) {
+        _bus->run([](TrinamicUartDriver* d, uint32_t homing) { d->TrinamicBase::set_homing_mode(homing); }, this, isHoming);
+        return true;
+    }
+
+    bool TrinamicUartDriver::read_load(uint16_t& sg_result, uint8_t& cs_actual) {
+        _bus->run(
+            [](TrinamicUartDriver* d, uint32_t) { d->_loadValid = d->read_chip_load(d->_loadSgResult, d->_loadCsActual); }, this);
+        sg_result = _loadSgResult;
+        cs_actual = _loadCsActual;
+        return _loadValid;
+    }
+
     /*
         This is the startup message showing the basic definition. 
 
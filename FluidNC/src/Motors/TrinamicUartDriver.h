@@ -5,6 +5,7 @@
 #pragma once
 
 #include "TrinamicBase.h"
+#include "TrinamicUartBus.h"
 #include "../Pin.h"
 #include "../Uart.h"
 
@@ -36,8 +37,18 @@ namespace MotorDrivers {
             TrinamicBase::group(handler);
         }
 
+        // Register access goes through the bus task after init().  config_motor()
+        // only queues the work, so the drivers on each UART are configured in parallel
+        // with those on other UARTs and with the rest of startup.
+        void config_motor() override;
+        void wait_config() override;
+        bool set_homing_mode(bool isHoming) override;
+
     protected:
-        Uart* _uart = nullptr;
+        friend class TrinamicUartBus;
+
+        Uart*            _uart = nullptr;
+        TrinamicUartBus* _bus  = nullptr;
 
         Pin _cs_pin;
 
@@ -48,7 +59,18 @@ namespace MotorDrivers {
 
         uint8_t toffValue();  // TO DO move to Base?
 
+        // configure() does the work of config_motor() on the bus task
+        virtual void configure() { TrinamicBase::config_motor(); }
+        void         poll_stallguard() override { _bus->poll_stallguard(); }
+
+        // read_chip_load() does the work of read_load() on the bus task
+        bool         read_load(uint16_t& sg_result, uint8_t& cs_actual) override;
+        virtual bool read_chip_load(uint16_t& sg_result, uint8_t& cs_actual) { return false; }
+
     private:
+        bool     _loadValid    = false;
+        uint16_t _loadSgResult = 0;
+        uint8_t  _loadCsActual = 0;
     };
 
 }
@@ -0,0 +1,68 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  NameIndex.h - case-insensitive name lookup by hash
+
+  Entries are kept sorted by a case-folded FNV-1a hash of the name, so a lookup is a
+  binary search plus a strcasecmp on the (almost always single) entry with that hash.
+  When several entries share a name, the one added first wins, matching a linear
+  scan over the original list.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <strings.h>  // strcasecmp
+#include <vector>
+
+template <typename T>
+class NameIndex {
+    struct Entry {
+        uint32_t    hash;
+        const char* name;
+        T*          item;
+    };
+
+    std::vector<Entry> _entries;
+
+public:
+    static uint32_t hash(const char* name) {
+        uint32_t h = 2166136261u;
+        for (; *name; ++name) {
+            h ^= uint8_t(::tolower(uint8_t(*name)));
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    void clear() { _entries.clear(); }
+
+    // Null names are ignored so callers can pass optional aliases directly
+    void add(const char* name, T* item) {
+        if (name) {
+            _entries.push_back({ hash(name), name, item });
+        }
+    }
+
+    // Call after the last add(); stable so the first of several equal names stays first
+    void sort() {
+        std::stable_sort(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+        _entries.shrink_to_fit();
+    }
+
+    T* find(const char* name) const {
+        uint32_t h  = hash(name);
+        auto     it = std::lower_bound(_entries.begin(), _entries.end(), h, [](const Entry& e, uint32_t v) { return e.hash < v; });
+        for (; it != _entries.end() && it->hash == h; ++it) {
+            if (strcasecmp(it->name, name) == 0) {
+                return it->item;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const { return _entries.size(); }
+};
@@ -175,6 +175,24 @@ float limit_acceleration_by_axis_maximum(float* unit_vec) {
     return limit_value * secPerMinSq;
 }
 
+// Axes with a zero jerk setting do not limit the jerk. If none of the moving axes has a
+// limit, the result is zero and the block keeps its trapezoidal ramps.
+float limit_jerk_by_axis_maximum(float* unit_vec) {
+    float limit_value = SOME_LARGE_VALUE;
+    auto  n_axis      = Axes::_numberAxis;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        auto axisSetting = Axes::_axis[idx];
+        if (unit_vec[idx] != 0 && axisSetting->_maxJerk > 0) {
+            limit_value = MIN(limit_value, fabsf(axisSetting->_maxJerk / unit_vec[idx]));
+        }
+    }
+    if (limit_value == SOME_LARGE_VALUE) {
+        return 0.0f;
+    }
+    // Stored in mm/sec^3, used in mm/min^3.
+    return limit_value * secPerMinSq * 60.0f;
+}
+
 float limit_rate_by_axis_maximum(float* unit_vec) {
     float limit_value = SOME_LARGE_VALUE;
     auto  n_axis      = Axes::_numberAxis;
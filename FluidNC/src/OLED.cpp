@@ -1,6 +1,8 @@
 #include "OLED.h"
 
 #include "Machine/MachineConfig.h"
+#include "SettingsDefinitions.h"  // status_mask
+#include "Report.h"               // RtStatus
 
 void OLED::show(Layout& layout, const char* msg) {
     if (_width < layout._width_required) {
@@ -85,12 +87,24 @@ void OLED::init() {
 
     _oled->display();
 
+    // Registered to receive the radio messages; the status comes from MachineStatus
     allChannels.registration(this);
-    setReportInterval(_report_interval_ms);
 }
 
+// The display is redrawn from the published MachineStatus, at most once per
+// report_interval_ms and only when a new snapshot has been published.
 Error OLED::pollLine(char* line) {
-    autoReport();
+    TickType_t now = xTaskGetTickCount();
+    if ((now - _lastDraw) < pdMS_TO_TICKS(_report_interval_ms)) {
+        return Error::NoData;
+    }
+    MachineStatus status;
+    uint32_t      seq = machine_status_read(status);
+    if (seq != _lastSeq) {
+        _lastSeq  = seq;
+        _lastDraw = now;
+        show_status(status);
+    }
     return Error::NoData;
 }
 
@@ -173,7 +187,6 @@ void OLED::show_dro(const float* axes, bool isMpos, bool* limits) {
         snprintf(axisVal, 20 - 1, "%.3f", axes[axis]);
         _oled->drawString((_width == 128) ? 60 : 63, oled_y_pos, axisVal);
     }
-    _oled->display();
 }
 
 void OLED::show_radio_info() {
@@ -195,164 +208,27 @@ void OLED::show_radio_info() {
     }
 }
 
-void OLED::parse_numbers(std::string s, float* nums, int maxnums) {
-    size_t pos     = 0;
-    size_t nextpos = -1;
-    size_t i       = 0;
-    do {
-        if (i >= maxnums) {
-            return;
-        }
-        nextpos   = s.find_first_of(",", pos);
-        auto num  = s.substr(pos, nextpos - pos);
-        nums[i++] = std::strtof(num.c_str(), nullptr);
-        pos       = nextpos + 1;
-    } while (nextpos != std::string::npos);
-}
-
-void OLED::parse_axes(std::string s, float* axes) {
-    size_t pos     = 0;
-    size_t nextpos = -1;
-    size_t axis    = 0;
-    do {
-        nextpos  = s.find_first_of(",", pos);
-        auto num = s.substr(pos, nextpos - pos);
-        if (axis < MAX_N_AXIS) {
-            axes[axis++] = std::strtof(num.c_str(), nullptr);
-        }
-        pos = nextpos + 1;
-    } while (nextpos != std::string::npos);
-}
+void OLED::show_status(const MachineStatus& status) {
+    _state    = status.state_name;
+    _filename = status.job_active ? status.job_name : "";
+    _percent  = status.job_percent;
 
-void OLED::parse_status_report() {
-    if (_report.back() == '>') {
-        _report.pop_back();
+    bool limits[MAX_N_AXIS];
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        limits[axis] = bitnum_is_true(status.limits, axis);
     }
-    // Now the string is a sequence of field|field|field
-    size_t pos     = 0;
-    auto   nextpos = _report.find_first_of("|", pos);
-    _state         = _report.substr(pos + 1, nextpos - pos - 1);
-
-    bool probe              = false;
-    bool limits[MAX_N_AXIS] = { false };
 
+    // The DROs show whichever position the status reports show
     float axes[MAX_N_AXIS];
-    bool  isMpos = false;
-    _filename    = "";
-
-    // ... handle it
-    while (nextpos != std::string::npos) {
-        pos        = nextpos + 1;
-        nextpos    = _report.find_first_of("|", pos);
-        auto field = _report.substr(pos, nextpos - pos);
-        // MPos:, WPos:, Bf:, Ln:, FS:, Pn:, WCO:, Ov:, A:, SD: (ISRs:, Heap:)
-        auto colon = field.find_first_of(":");
-        auto tag   = field.substr(0, colon);
-        auto value = field.substr(colon + 1);
-        if (tag == "MPos") {
-            // x,y,z,...
-            parse_axes(value, axes);
-            isMpos = true;
-            continue;
-        }
-        if (tag == "WPos") {
-            // x,y,z...
-            parse_axes(value, axes);
-            isMpos = false;
-            continue;
-        }
-        if (tag == "Bf") {
-            // buf_avail,rx_avail
-            continue;
-        }
-        if (tag == "Ln") {
-            // n
-            auto linenum = std::strtol(value.c_str(), nullptr, 10);
-            continue;
-        }
-        if (tag == "FS") {
-            // feedrate,spindle_speed
-            float fs[2];
-            parse_numbers(value, fs, 2);  // feed in [0], spindle in [1]
-            continue;
-        }
-        if (tag == "Pn") {
-            // PXxYy etc
-            for (char const& c : value) {
-                switch (c) {
-                    case 'P':
-                        probe = true;
-                        break;
-                    case 'X':
-                        limits[X_AXIS] = true;
-                        break;
-                    case 'Y':
-                        limits[Y_AXIS] = true;
-                        break;
-                    case 'Z':
-                        limits[Z_AXIS] = true;
-                        break;
-                    case 'A':
-                        limits[A_AXIS] = true;
-                        break;
-                    case 'B':
-                        limits[B_AXIS] = true;
-                        break;
-                    case 'C':
-                        limits[C_AXIS] = true;
-                        break;
-                }
-                continue;
-            }
-        }
-        if (tag == "WCO") {
-            // x,y,z,...
-            // We do not use the WCO values because the DROs show whichever
-            // position is in the status report
-            // float wcos[MAX_N_AXIS];
-            // auto  wcos = parse_axes(value, wcos);
-            continue;
-        }
-        if (tag == "Ov") {
-            // feed_ovr,rapid_ovr,spindle_ovr
-            float frs[3];
-            parse_numbers(value, frs, 3);  // feed in [0], rapid in [1], spindle in [2]
-            continue;
-        }
-        if (tag == "A") {
-            // SCFM
-            int  spindle = 0;
-            bool flood   = false;
-            bool mist    = false;
-            for (char const& c : value) {
-                switch (c) {
-                    case 'S':
-                        spindle = 1;
-                        break;
-                    case 'C':
-                        spindle = 2;
-                        break;
-                    case 'F':
-                        flood = true;
-                        break;
-                    case 'M':
-                        mist = true;
-                        break;
-                }
-            }
-            continue;
-        }
-        if (tag == "SD") {
-            auto commaPos = value.find_first_of(",");
-            _percent      = std::strtof(value.substr(0, commaPos).c_str(), nullptr);
-            _filename     = value.substr(commaPos + 1);
-            continue;
-        }
+    bool  isMpos = bits_are_true(status_mask->get(), RtStatus::Position);
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        axes[axis] = isMpos ? status.mpos[axis] : status.mpos[axis] - status.wco[axis];
     }
+
     _oled->clear();
     show_state();
     show_file();
-    show_limits(probe, limits);
+    show_limits(status.probe, limits);
     show_dro(axes, isMpos, limits);
     show_radio_info();
     _oled->display();
@@ -459,10 +335,6 @@ void OLED::parse_report() {
     if (_report.length() == 0) {
         return;
     }
-    if (_report.rfind("<", 0) == 0) {
-        parse_status_report();
-        return;
-    }
     if (_report.rfind("[GC:", 0) == 0) {
         parse_gcode_report();
         return;
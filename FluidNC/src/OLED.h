@@ -6,6 +6,7 @@
 
 #include "src/Channel.h"
 #include "src/Module.h"
+#include "src/MachineStatus.h"
 #include "SSD1306_I2C.h"
 
 typedef const uint8_t* font_t;
@@ -48,8 +49,11 @@ private:
 
     uint8_t _i2c_num = 0;
 
+    uint32_t   _lastSeq  = 0;
+    TickType_t _lastDraw = 0;
+
     void parse_report();
-    void parse_status_report();
+    void show_status(const MachineStatus& status);
     void parse_gcode_report();
     void parse_STA();
     void parse_IP();
@@ -57,9 +61,6 @@ private:
     void parse_BT();
     void parse_WebUI();
 
-    void parse_axes(std::string s, float* axes);
-    void parse_numbers(std::string s, float* nums, int maxnums);
-
     void show_limits(bool probe, const bool* limits);
     void show_state();
     void show_file();
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  ParamTable.h - storage for named parameters
+
+  A fixed-capacity open-addressing hash table from parameter names to values.  Names are
+  case-insensitive, as in LinuxCNC; each is stored once, upper-cased, when it is first
+  assigned.  Lookups take a string_view and hash it in place, so reading or testing a
+  parameter never allocates.  Entries are never removed, which keeps linear probing
+  simple: a probe sequence ends at the first empty slot.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+template <size_t Capacity>
+class ParamTable {
+    static_assert((Capacity & (Capacity - 1)) == 0, "ParamTable capacity must be a power of 2");
+
+    struct Slot {
+        uint32_t    hash = 0;
+        std::string name;  // Empty if the slot is unused
+        float       value = 0.0f;
+    };
+    Slot   _slots[Capacity];
+    size_t _count = 0;
+
+    static char fold(char c) { return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c; }
+
+    static uint32_t hash(std::string_view name) {
+        uint32_t h = 2166136261u;  // FNV-1a
+        for (char c : name) {
+            h = (h ^ uint8_t(fold(c))) * 16777619u;
+        }
+        return h;
+    }
+
+    static bool same(const std::string& key, std::string_view name) {
+        if (key.length() != name.length()) {
+            return false;
+        }
+        for (size_t i = 0; i < key.length(); ++i) {
+            if (key[i] != fold(name[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The slot holding name, or the empty slot where it would go; nullptr if the table
+    // is full and name is not in it.
+    Slot* find(std::string_view name, uint32_t h) {
+        for (size_t n = 0, i = h & (Capacity - 1); n < Capacity; ++n, i = (i + 1) & (Capacity - 1)) {
+            Slot& slot = _slots[i];
+            if (slot.name.empty() || (slot.hash == h && same(slot.name, name))) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+    const Slot* find(std::string_view name) const { return const_cast<ParamTable*>(this)->find(name, hash(name)); }
+
+public:
+    static const size_t capacity = Capacity;
+
+    bool get(std::string_view name, float& value) const {
+        const Slot* slot = find(name);
+        if (!slot || slot->name.empty()) {
+            return false;
+        }
+        value = slot->value;
+        return true;
+    }
+
+    bool exists(std::string_view name) const {
+        const Slot* slot = find(name);
+        return slot && !slot->name.empty();
+    }
+
+    // Returns false if name is new and the table is full.
+    bool set(std::string_view name, float value) {
+        if (name.empty()) {
+            return false;
+        }
+        uint32_t h    = hash(name);
+        Slot*    slot = find(name, h);
+        if (!slot) {
+            return false;
+        }
+        if (slot->name.empty()) {
+            // Keep one slot empty so that unsuccessful lookups terminate quickly
+            if (_count == Capacity - 1) {
+                return false;
+            }
+            slot->hash = h;
+            slot->name.reserve(name.length());
+            for (char c : name) {
+                slot->name += fold(c);
+            }
+            ++_count;
+        }
+        slot->value = value;
+        return true;
+    }
+
+    size_t size() const { return _count; }
+};
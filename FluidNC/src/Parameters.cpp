@@ -11,9 +11,12 @@
 #include "MotionControl.h"
 #include "GCode.h"
 #include "Job.h"
+#include "ParamTable.h"
 
 #include <string>
 #include <map>
+#include <algorithm>
+#include <cmath>
 
 #include "Expression.h"
 
@@ -27,16 +30,20 @@ const std::map<const int, bool *> bool_params = {
     { 5070, &probe_succeeded },
 };
 
-std::map<const ngc_param_id_t, float> float_params = {
-    { 5399, 0.0 }, // M66 last immediate read input result
-};
+// User parameters #1-#5000 are indexed directly.  The array is allocated on the first
+// assignment, so programs that do not use them do not pay for the RAM; NAN marks the
+// parameters that have not been set.
+const ngc_param_id_t max_user_param = 5000;
+static float*        user_params    = nullptr;
+
+static float last_input_result = 0.0;  // #5399, M66 last immediate read input result
 
 static bool can_write_float_param(ngc_param_id_t id) {
     if (id == 5399) {
         // M66 last immediate read input result
         return true;
     }
-    if(id >= 1 && id <= 5000) {
+    if(id >= 1 && id <= max_user_param) {
         // User parameters
         return true;
     }
@@ -48,27 +55,30 @@ static bool can_read_float_param(ngc_param_id_t id) {
         // M66
         return true;
     }
-    if (id >= 31 && id <= 5000) {
+    if (id >= 31 && id <= max_user_param) {
         // User parameters
         return true;
     }
     return false;
 }
 
-const std::map<const ngc_param_id_t, CoordIndex> axis_params = {
-    { 5161, CoordIndex::G28 },
-    { 5181, CoordIndex::G30 },
-    // { 5211, CoordIndex::G92 },  // Non-persisent, handled specially
-    { 5221, CoordIndex::G54 },
-    { 5241, CoordIndex::G55 },
-    { 5261, CoordIndex::G56 },
-    { 5281, CoordIndex::G57 },
-    { 5301, CoordIndex::G58 },
-    { 5321, CoordIndex::G59 },
-    // { 5341, CoordIndex::G59_1 },  // Not implemented
-    // { 5361, CoordIndex::G59_2 },  // Not implemented
-    // { 5381, CoordIndex::G59_3 },  // Not implemented
-    // { 5401, CoordIndex::TLO },
+// The persistent coordinate systems are blocks of 20 parameters from 5161, with the
+// axis values at the start of each block.
+const ngc_param_id_t coord_param_base  = 5161;
+const int            coord_param_block = 20;
+const CoordIndex     coord_param_blocks[] = {
+    CoordIndex::G28,  // 5161
+    CoordIndex::G30,  // 5181
+    CoordIndex::End,  // 5201, G92 at 5211 is non-persistent, handled specially
+    CoordIndex::G54,  // 5221
+    CoordIndex::G55,  // 5241
+    CoordIndex::G56,  // 5261
+    CoordIndex::G57,  // 5281
+    CoordIndex::G58,  // 5301
+    CoordIndex::G59,  // 5321
+    // CoordIndex::G59_1,  // 5341, Not implemented
+    // CoordIndex::G59_2,  // 5361, Not implemented
+    // CoordIndex::G59_3,  // 5381, Not implemented
 };
 
 const std::map<const std::string, int> work_positions = {
@@ -78,9 +88,9 @@ const std::map<const std::string, int> work_positions = {
     { "_a", 3 },
     { "_b", 4 },
     { "_c", 5 },
-    //    { "_u", 0},
-    //    { "_v", 0},
-    //    { "_w", 0},
+    { "_u", 6 },
+    { "_v", 7 },
+    { "_w", 8 },
 };
 const std::map<const std::string, int> machine_positions = {
     { "_abs_x", 0 },
@@ -89,9 +99,9 @@ const std::map<const std::string, int> machine_positions = {
     { "_abs_a", 3 },
     { "_abs_b", 4 },
     { "_abs_c", 5 },
-    //    { "_abs_u", 0},
-    //    { "_abs_v", 0},
-    //    { "_abs_w", 0},
+    { "_abs_u", 6 },
+    { "_abs_v", 7 },
+    { "_abs_w", 8 },
 };
 
 const std::array<const std::string, 6> unsupported_sys = {
@@ -105,7 +115,7 @@ const std::array<const std::string, 6> unsupported_sys = {
 
 // clang-format on
 
-std::map<std::string, float> global_named_params;
+ParamTable<128> global_named_params;
 
 bool ngc_param_is_rw(ngc_param_id_t id) {
     return true;
@@ -114,6 +124,17 @@ bool ngc_param_is_rw(ngc_param_id_t id) {
 static bool is_axis(int axis) {
     return axis >= 0 && axis < MAX_N_AXIS;
 }
+
+// Maps id onto a coordinate system and axis, if it is a persistent coordinate parameter.
+static bool coord_param(ngc_param_id_t id, CoordIndex& coord_index, int& axis) {
+    int offset = id - coord_param_base;
+    if (offset < 0 || offset >= coord_param_block * int(sizeof(coord_param_blocks) / sizeof(coord_param_blocks[0]))) {
+        return false;
+    }
+    coord_index = coord_param_blocks[offset / coord_param_block];
+    axis        = offset % coord_param_block;
+    return coord_index != CoordIndex::End && is_axis(axis);
+}
 static bool is_rotary(int axis) {
     return axis >= A_AXIS && axis <= C_AXIS;
 }
@@ -131,22 +152,18 @@ static float to_mm(int axis, float value) {
 }
 
 bool get_numbered_param(ngc_param_id_t id, float& result) {
-    int axis;
-    for (auto const& [key, coord_index] : axis_params) {
-        axis = id - key;
-        if (is_axis(axis)) {
-            const float* p = coords[coord_index]->get();
-
-            result = to_inches(axis, coords[coord_index]->get(axis));
-            return true;
-        }
+    int        axis;
+    CoordIndex coord_index;
+    if (coord_param(id, coord_index, axis)) {
+        result = to_inches(axis, coords[coord_index]->get(axis));
+        return true;
     }
 
     // last probe
     axis = id - 5061;
     if (is_axis(axis)) {
         float probe_position[MAX_N_AXIS];
-        motor_steps_to_mpos(probe_position, probe_steps);
+        probe_steps_to_mpos(probe_position);
         result = to_inches(axis, probe_position[axis]);
         return true;
     }
@@ -155,6 +172,7 @@ bool get_numbered_param(ngc_param_id_t id, float& result) {
     axis = id - 5211;
     if (is_axis(axis)) {
         result = to_inches(axis, gc_state.coord_offset[axis]);
+        return true;
     }
 
     if (id == 5220) {
@@ -181,13 +199,16 @@ bool get_numbered_param(ngc_param_id_t id, float& result) {
     }
 
     if (can_read_float_param(id)) {
-        if (auto param = float_params.find(id); param != float_params.end()) {
-            result = param->second;
+        if (id == 5399) {
+            result = last_input_result;
             return true;
-        } else {
-            log_info("param #" << id << " is not found");
-            return false;
         }
+        if (user_params && !std::isnan(user_params[id])) {
+            result = user_params[id];
+            return true;
+        }
+        log_info("param #" << id << " is not found");
+        return false;
     }
 
     return false;
@@ -378,54 +399,50 @@ bool system_param_exists(const std::string& name) {
 // The LinuxCNC doc says that the EXISTS syntax is like EXISTS[#<_foo>]
 // For convenience, we also allow EXISTS[_foo]
 bool named_param_exists(std::string& name) {
-    std::string search;
+    std::string_view search(name);
     if (name.length() > 3 && name[0] == '#' && name[1] == '<' && name.back() == '>') {
-        search = name.substr(2, name.length() - 3);
-    } else {
-        search = name;
+        search = search.substr(2, name.length() - 3);
     }
     if (search.length() == 0) {
         return false;
     }
     if (search[0] == '/') {
         float dummy;
-        return get_config_item(search, dummy);
+        return get_config_item(std::string(search), dummy);
     }
     if (search[0] == '_') {
         float dummy;
-        bool  got = get_system_param(search, dummy);
+        bool  got = get_system_param(std::string(search), dummy);
         if (got) {
             return true;
         }
-        return global_named_params.count(search) != 0;
+        return global_named_params.exists(search);
     }
     // If the name does not start with _ it is local so we look for a job-local parameter
     // If no job is active, we treat the interpretive context like a local context
-    return Job::active() ? Job::param_exists(search) : global_named_params.count(search) != 0;
+    return Job::active() ? Job::param_exists(search) : global_named_params.exists(search);
 }
 
 bool get_global_named_param(const std::string& name, float& value) {
-    auto it = global_named_params.find(name);
-    if (it == global_named_params.end()) {
-        return false;
+    return global_named_params.get(name, value);
+}
+
+bool get_named_param(const std::string& name, float& value) {
+    if (name[0] == '/') {
+        return get_config_item(name, value);
     }
-    value = it->second;
-    return true;
+    if (name[0] == '_') {
+        if (get_system_param(name, value)) {
+            return true;
+        }
+        return get_global_named_param(name, value);
+    }
+    return Job::active() ? Job::get_param(name, value) : get_global_named_param(name, value);
 }
 
 bool get_param(const param_ref_t& param_ref, float& value) {
-    auto name = param_ref.name;
-    if (name.length()) {
-        if (name[0] == '/') {
-            return get_config_item(name, value);
-        }
-        if (name[0] == '_') {
-            if (get_system_param(name, value)) {
-                return true;
-            }
-            return get_global_named_param(name, value);
-        }
-        return Job::active() ? Job::get_param(name, value) : get_global_named_param(name, value);
+    if (param_ref.name.length()) {
+        return get_named_param(param_ref.name, value);
     }
     return get_numbered_param(param_ref.id, value);
 }
@@ -486,19 +503,20 @@ bool get_param_ref(const char* line, size_t& pos, param_ref_t& param_ref) {
 }
 
 bool set_named_param(const std::string& name, float value) {
-    global_named_params[name] = value;
+    if (!global_named_params.set(name, value)) {
+        log_error("No room for parameter " << name);
+        return false;
+    }
     return true;
 }
 
 bool set_numbered_param(ngc_param_id_t id, float value) {
-    int axis;
-    for (auto const& [key, coord_index] : axis_params) {
-        axis = id - key;
-        if (is_axis(axis)) {
-            coords[coord_index]->set(axis, to_mm(axis, value));
-            gc_ngc_changed(coord_index);
-            return true;
-        }
+    int        axis;
+    CoordIndex coord_index;
+    if (coord_param(id, coord_index, axis)) {
+        coords[coord_index]->set(axis, to_mm(axis, value));
+        gc_ngc_changed(coord_index);
+        return true;
     }
     // Non-volatile G92
     axis = id - 5211;
@@ -516,7 +534,15 @@ bool set_numbered_param(ngc_param_id_t id, float value) {
         return true;
     }
     if (can_write_float_param(id)) {
-        float_params[id] = value;
+        if (id == 5399) {
+            last_input_result = value;
+            return true;
+        }
+        if (!user_params) {
+            user_params = new float[max_user_param + 1];
+            std::fill_n(user_params, max_user_param + 1, NAN);
+        }
+        user_params[id] = value;
         return true;
     }
     log_info("param #" << id << " is not found");
@@ -530,7 +556,11 @@ bool set_param(const param_ref_t& param_ref, float value) {
             return set_config_item(param_ref.name, value);
         }
         if (name[0] != '_' && Job::active()) {
-            return Job::set_param(name, value);
+            if (!Job::set_param(name, value)) {
+                log_error("No room for parameter " << name);
+                return false;
+            }
+            return true;
         }
         if (name[0] == '_' && system_param_exists(name)) {
             log_debug("Attempt to set read-only parameter " << name);
@@ -562,7 +592,8 @@ bool read_number(const char* line, size_t& pos, float& result, bool in_expressio
         return false;
     }
     if (c == '[') {
-        Error status = expression(line, pos, result);
+        // Nested expressions are part of the compiled code of the outermost one
+        Error status = in_expression ? expression(line, pos, result) : cached_expression(line, pos, result);
         if (status != Error::Ok) {
             log_debug(errorString(status));
             return false;
@@ -14,5 +14,7 @@ bool assign_param(const char* line, size_t& pos);
 bool read_number(const char* line, size_t& pos, float& value, bool in_expression = false);
 bool perform_assignments();
 bool named_param_exists(std::string& name);
+bool get_numbered_param(ngc_param_id_t id, float& value);
+bool get_named_param(const std::string& name, float& value);
 bool set_named_param(const char* name, float value);
 bool set_numbered_param(ngc_param_id_t, float value);
@@ -14,22 +14,39 @@ void Parking::moveto(float* target) {
         return;  // Block during abort.
     }
     if (plan_buffer_line(target, &plan_data)) {
+        run(false);
+    } else {
+        sys.step_control.executeSysMotion = false;
+        protocol_exec_rt_system();
+    }
+}
+
+// Executes the planned parking motion, and any motion chained to it.  With spin_down, the
+// spindle is turned off once the parking axis reaches the retract waypoint, without waiting
+// for it to stop, so that it spins down while the motion goes on.
+void Parking::run(bool spin_down) {
+    {
+        Stepper::PrepLock lock;
         sys.step_control.executeSysMotion = true;
         sys.step_control.endMotion        = false;  // Allow parking motion to execute, if feed hold is active.
         Stepper::parking_setup_buffer();            // Setup step segment buffer for special parking motion case
         Stepper::prep_buffer();
-        Stepper::wake_up();
-        do {
-            protocol_exec_rt_system();
-            if (sys.abort) {
-                return;
-            }
-        } while (sys.step_control.executeSysMotion);
-        Stepper::parking_restore_buffer();  // Restore step segment buffer to normal run state.
-    } else {
-        sys.step_control.executeSysMotion = false;
-        protocol_exec_rt_system();
     }
+    Stepper::wake_up();
+    do {
+        protocol_exec_rt_system();
+        if (sys.abort) {
+            return;
+        }
+        if (spin_down && steps_to_mpos(get_axis_motor_steps(_axis), _axis) >= retract_waypoint) {
+            spin_down = false;
+            log_debug("Spin down");
+            spindle->deferDelay();
+            spindle->spinDown();
+            gc_ovr_changed();
+        }
+    } while (sys.step_control.executeSysMotion);
+    Stepper::parking_restore_buffer();  // Restore step segment buffer to normal run state.
 }
 
 bool Parking::can_park() {
@@ -93,6 +110,7 @@ void Parking::park(bool restart) {
     if (can_park() && parking_target[_axis] < _target_mpos) {
         // Retract spindle by pullout distance. Ensure retraction motion moves away from
         // the workpiece and waypoint motion doesn't exceed the parking target location.
+        bool pullout = false;
         if (parking_target[_axis] < retract_waypoint) {
             log_debug("Parking pullout");
             parking_target[_axis]   = retract_waypoint;
@@ -100,7 +118,7 @@ void Parking::park(bool restart) {
             plan_data.coolant       = saved_coolant;
             plan_data.spindle       = saved_spindle;
             plan_data.spindle_speed = saved_spindle_speed;
-            moveto(parking_target);
+            pullout                 = !sys.abort && plan_buffer_line(parking_target, &plan_data);
         }
 
         // NOTE: Clear accessory state after retract and after an aborted restore motion.
@@ -111,17 +129,37 @@ void Parking::park(bool restart) {
         plan_data.motion.noFeedOverride = 1;
         plan_data.spindle_speed         = 0.0;
 
-        log_debug("Spin down");
-        spindle->spinDown();
-        gc_ovr_changed();
-
-        // Execute fast parking retract motion to parking target location.
-        if (parking_target[_axis] < _target_mpos) {
+        // The fast parking motion is chained to the pullout, so the axis speeds up at the
+        // waypoint instead of stopping there, and the spindle spins down on the way.
+        bool park = parking_target[_axis] < _target_mpos;
+        if (park) {
             log_debug("Parking motion");
             parking_target[_axis] = _target_mpos;
             plan_data.feed_rate   = _rate;
+        }
+        bool chained = false;
+        if (pullout) {
+            chained = park && plan_chain_system_motion(parking_target, &plan_data);
+            run(chained);
+        } else {
+            sys.step_control.executeSysMotion = false;
+            protocol_exec_rt_system();
+        }
+        if (sys.abort) {
+            return;
+        }
+        if (spindle->get_state() != SpindleState::Disable) {
+            log_debug("Spin down");
+            spindle->deferDelay();
+            spindle->spinDown();
+            gc_ovr_changed();
+        }
+
+        // Execute fast parking retract motion to parking target location, if it was not chained.
+        if (park && !chained) {
             moveto(parking_target);
         }
+        spindle->finishDelay();
     } else {
         log_debug("Spin down only");
         // Parking motion not possible. Just disable the spindle and coolant.
@@ -36,6 +36,7 @@ private:
     plan_block_t* block;
 
     void moveto(float* target);
+    void run(bool spin_down);
 
     bool can_park();
 
@@ -0,0 +1,100 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  PathBuffer.h - file paths without the heap
+
+  A std::filesystem::path allocates its string and a list of its components,
+  and every / or filename() makes another one.  A directory listing that stats
+  each entry through paths allocates several per entry.  A PathBuffer holds
+  the directory once, in a fixed buffer, and swaps each entry's name in and
+  out at its end.  The free functions take apart the canonical paths that
+  FluidPath makes, such as /sd/jobs/part.nc, as string_views.
+
+  Everything here is plain C++ so that it can be tested on the host.
+*/
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+template <size_t N>
+class PathBuffer {
+    char   _data[N];
+    size_t _length = 0;
+
+    bool append_raw(std::string_view s) {
+        if (_length + s.length() >= N) {
+            return false;
+        }
+        memcpy(_data + _length, s.data(), s.length());
+        _length += s.length();
+        _data[_length] = '\0';
+        return true;
+    }
+
+public:
+    PathBuffer() { _data[0] = '\0'; }
+    explicit PathBuffer(std::string_view path) : PathBuffer() { assign(path); }
+
+    // Returns false, leaving the path empty, if path does not fit
+    bool assign(std::string_view path) {
+        truncate(0);
+        return append_raw(path);
+    }
+
+    // Adds a component after a '/', unless the path is empty or already ends with one.
+    // Returns false, leaving the path as it was, if the result would not fit.
+    bool append(std::string_view name) {
+        size_t saved = _length;
+        if (_length && _data[_length - 1] != '/' && !append_raw("/")) {
+            return false;
+        }
+        if (!append_raw(name)) {
+            truncate(saved);
+            return false;
+        }
+        return true;
+    }
+
+    // Shortens the path to length characters, e.g. to remove a name added by append()
+    void truncate(size_t length) {
+        if (length <= _length) {
+            _length        = length;
+            _data[_length] = '\0';
+        }
+    }
+
+    size_t           length() const { return _length; }
+    const char*      c_str() const { return _data; }
+    std::string_view view() const { return std::string_view(_data, _length); }
+};
+
+// The first component of an absolute path, "sd" in /sd/jobs/part.nc
+inline std::string_view path_mount(std::string_view path) {
+    if (path.empty() || path[0] != '/') {
+        return std::string_view();
+    }
+    path.remove_prefix(1);
+    return path.substr(0, path.find('/'));
+}
+
+// True if anything, even a '/', follows the first component: /sd/jobs and /sd/ but not /sd
+inline bool path_has_tail(std::string_view path) {
+    return path.length() > 1 && path.find('/', 1) != std::string_view::npos;
+}
+
+// Splits a file name as std::filesystem::path::stem() and extension() do: the extension
+// starts at the last '.', except in names like .hidden, "." and ".." that have none.
+inline void path_split_name(std::string_view name, std::string_view& stem, std::string_view& extension) {
+    size_t dot = name.rfind('.');
+    if (dot == std::string_view::npos || dot == 0 || name == "..") {
+        stem      = name;
+        extension = std::string_view();
+        return;
+    }
+    stem      = name.substr(0, dot);
+    extension = name.substr(dot);
+}
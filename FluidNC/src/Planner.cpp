@@ -9,22 +9,83 @@
 */
 
 #include "Planner.h"
+#include "PlannerRecalculate.h"
+#include "CornerCurvature.h"
+#include "AxisCount.h"
 #include "Machine/MachineConfig.h"
+#include "Trace.h"
+#include "Memory.h"
 
 #include <cstdlib>  // PSoc Required for labs
 #include <cmath>
 
 static plan_block_t* block_buffer = nullptr;  // A ring buffer for motion instructions
-static uint8_t       block_buffer_tail;       // Index of the block to process now
-static uint8_t       block_buffer_head;       // Index of the next block to be pushed
-static uint8_t       next_buffer_head;        // Index of the next buffer head
-static uint8_t       block_buffer_planned;    // Index of the optimally planned block
-
+static plan_speed_t* block_speed  = nullptr;  // The speed fields of block_buffer, by the same index
+static PlanArc*      block_arc    = nullptr;  // Arc geometry of block_buffer, by the same index, with native_arcs
+static size_t        block_buffer_size;       // Number of blocks in the ring, from stepping/planner_blocks
+static size_t        block_buffer_tail;       // Index of the block to process now
+static size_t        block_buffer_head;       // Index of the next block to be pushed
+static size_t        next_buffer_head;        // Index of the next buffer head
+static size_t        block_buffer_planned;    // Index of the optimally planned block
+static size_t        batch_depth   = 0;       // Number of PlanBatch objects in existence
+static bool          batch_pending = false;   // Blocks have been added without replanning
+static size_t        free_low_water;          // Fewest free blocks after a block was added
+
+// A system motion is planned in the free block at the head of the ring.  A second one that
+// continues it goes in a spare block allocated after the ring.
+static bool    system_chained   = false;  // The spare block holds a system motion that continues the first
+static bool    system_continued = false;  // The stepper has moved on to it
+static int32_t system_end[MAX_N_AXIS];    // Where the last system motion ends, in steps
+static float   system_exit_vec[MAX_N_AXIS];
+
+// The ring is allocated once at boot, as Bulk memory (see Memory.h); the planner is only
+// touched from the main loop, never from the step ISR, so PSRAM is acceptable here.
+// The speed fields, which every replan walks, are always in internal DRAM; at 16 bytes a
+// block, even a ring of hundreds of blocks costs only a few KB of it.  If the requested
+// size cannot be allocated, the ring is shrunk until it fits.  One more block than the ring
+// holds is allocated, for chained system motions.
 void plan_init() {
-    if (block_buffer) {
-        delete[] block_buffer;
+    Memory::free(block_buffer);
+    block_buffer = nullptr;
+    Memory::free(block_speed);
+    block_speed = nullptr;
+    Memory::free(block_arc);
+    block_arc = nullptr;
+
+    size_t n_blocks = Stepping::_planner_blocks;
+    while (true) {
+        size_t bytes = (n_blocks + 1) * sizeof(plan_block_t);
+        block_buffer = static_cast<plan_block_t*>(Memory::alloc(bytes, Memory::Region::Bulk));
+        if (block_buffer) {
+            bytes       = (n_blocks + 1) * sizeof(plan_speed_t);
+            block_speed = static_cast<plan_speed_t*>(Memory::alloc(bytes, Memory::Region::Internal));
+            if (!block_speed) {
+                Memory::free(block_buffer);
+                block_buffer = nullptr;
+            }
+        }
+        if (block_buffer || n_blocks <= 10) {
+            break;
+        }
+        n_blocks /= 2;
+    }
+    Assert(block_buffer, "Cannot allocate planner blocks");
+    if (n_blocks != Stepping::_planner_blocks) {
+        log_warn("stepping/planner_blocks reduced to " << n_blocks);
     }
-    block_buffer = new plan_block_t[config->_planner_blocks];
+    block_buffer_size = n_blocks;
+    log_info("Planner blocks:" << block_buffer_size << " in " << (Memory::in_psram(block_buffer) ? "PSRAM" : "DRAM"));
+
+    // Arcs are only read by the segment prep, never by the step ISR, so PSRAM will do
+    if (config->_nativeArcs) {
+        size_t bytes = n_blocks * sizeof(PlanArc);
+        block_arc    = static_cast<PlanArc*>(Memory::alloc(bytes, Memory::Region::Bulk));
+        if (!block_arc) {
+            log_warn("No memory for native arcs; arcs will be split into lines");
+        }
+    }
+    plan_reset_buffer();
+    plan_reset_block_buffer_low_water();
 }
 
 // Define planner variables
@@ -34,22 +95,29 @@ typedef struct {
     // i.e. arcs, canned cycles, and backlash compensation.
     float previous_unit_vec[MAX_N_AXIS];  // Unit vector of previous path line segment
     float previous_nominal_speed;         // Nominal speed of previous path line segment
+    float previous_millimeters;           // Length of previous path line segment
+    // Collinear merging, see plan_merge_line().
+    bool    last_mergeable;              // The newest block may be extended
+    int32_t last_start[MAX_N_AXIS];      // Start of the newest block in absolute steps
+    float   last_deviation;              // Distance by which earlier merges have moved the newest block off its path
 } planner_t;
 static planner_t pl;
 
+static CornerCurvature curvature;  // Cornering speeds on tessellated curves, see CornerCurvature.h
+
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
-static uint8_t plan_next_block_index(uint8_t block_index) {
+static size_t plan_next_block_index(size_t block_index) {
     block_index++;
-    if (block_index == config->_planner_blocks) {
+    if (block_index == block_buffer_size) {
         block_index = 0;
     }
     return block_index;
 }
 
 // Returns the index of the previous block in the ring buffer
-static uint8_t plan_prev_block_index(uint8_t block_index) {
+static size_t plan_prev_block_index(size_t block_index) {
     if (block_index == 0) {
-        block_index = config->_planner_blocks;
+        block_index = block_buffer_size;
     }
     block_index--;
     return block_index;
@@ -82,6 +150,8 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   are possible. If a new block is added to the buffer, the plan is recomputed according to the said
   guidelines for a new optimal plan.
 
+  The passes themselves are in PlannerRecalculate.h.
+
   To increase computational efficiency of these guidelines, a set of planner block pointers have been
   created to indicate stop-compute points for when the planner guidelines cannot logically make any further
   changes or improvements to the plan when in normal operation and new blocks are streamed and added to the
@@ -120,96 +190,42 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
 */
-static void planner_recalculate() {
-    if (block_buffer_head == block_buffer_tail) {
-        // Nothing to do; planner buffer is empty.
-        return;
-    }
-    // Initialize block index to the last block in the planner buffer.
-    uint8_t block_index = plan_prev_block_index(block_buffer_head);
-    // Bail. Can't do anything with one only one plan-able block.
-    if (block_index == block_buffer_planned) {
-        return;
-    }
-    // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
-    // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
-    // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
-    float         entry_speed_sqr;
-    plan_block_t* next;
-    plan_block_t* current = &block_buffer[block_index];
-    // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
-    current->entry_speed_sqr = MIN(current->max_entry_speed_sqr, 2 * current->acceleration * current->millimeters);
-    block_index              = plan_prev_block_index(block_index);
-    if (block_index == block_buffer_planned) {  // Only two plannable blocks in buffer. Reverse pass complete.
-        // Check if the first block is the tail. If so, notify stepper to update its current parameters.
-        if (block_index == block_buffer_tail) {
-            Stepper::update_plan_block_parameters();
-        }
-    } else {  // Three or more plan-able blocks
-        while (block_index != block_buffer_planned) {
-            next        = current;
-            current     = &block_buffer[block_index];
-            block_index = plan_prev_block_index(block_index);
-            // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
-            if (block_index == block_buffer_tail) {
-                Stepper::update_plan_block_parameters();
-            }
-            // Compute maximum entry speed decelerating over the current block from its exit speed.
-            if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
-                entry_speed_sqr = next->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
-                if (entry_speed_sqr < current->max_entry_speed_sqr) {
-                    current->entry_speed_sqr = entry_speed_sqr;
-                } else {
-                    current->entry_speed_sqr = current->max_entry_speed_sqr;
-                }
-            }
-        }
-    }
-    // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
-    // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
-    next        = &block_buffer[block_buffer_planned];  // Begin at buffer planned pointer
-    block_index = plan_next_block_index(block_buffer_planned);
-    while (block_index != block_buffer_head) {
-        current = next;
-        next    = &block_buffer[block_index];
-        // Any acceleration detected in the forward pass automatically moves the optimal planned
-        // pointer forward, since everything before this is all optimal. In other words, nothing
-        // can improve the plan from the buffer tail to the planned pointer by logic.
-        if (current->entry_speed_sqr < next->entry_speed_sqr) {
-            entry_speed_sqr = current->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
-            // If true, current block is full-acceleration and we can move the planned pointer forward.
-            if (entry_speed_sqr < next->entry_speed_sqr) {
-                next->entry_speed_sqr = entry_speed_sqr;  // Always <= max_entry_speed_sqr. Backward pass sets this.
-                block_buffer_planned  = block_index;      // Set optimal plan pointer.
-            }
-        }
-        // Any block set at its maximum entry speed also creates an optimal plan up to this
-        // point in the buffer. When the plan is bracketed by either the beginning of the
-        // buffer and a maximum entry speed or two maximum entry speeds, every block in between
-        // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-        if (next->entry_speed_sqr == next->max_entry_speed_sqr) {
-            block_buffer_planned = block_index;
-        }
-        block_index = plan_next_block_index(block_index);
-    }
+// optimal_window may only be used when a block has been appended to an otherwise unchanged plan.
+// Overrides and feed holds change the speed limits of blocks already in the buffer, so they
+// must replan the whole buffer.
+static void planner_recalculate(bool optimal_window) {
+    Planner::recalculate(block_speed,
+                         block_buffer_size,
+                         block_buffer_tail,
+                         block_buffer_head,
+                         block_buffer_planned,
+                         optimal_window,
+                         [] { Stepper::update_plan_block_parameters(); });
 }
 
 void plan_reset() {
+    Stepper::PrepLock lock;
     memset(&pl, 0, sizeof(planner_t));  // Clear planner struct
     plan_reset_buffer();
+    Raster::reset();
 }
 
 void plan_reset_buffer() {
+    batch_pending        = false;
+    pl.last_mergeable    = false;
     block_buffer_tail    = 0;
     block_buffer_head    = 0;  // Empty = tail
     next_buffer_head     = 1;  // plan_next_block_index(block_buffer_head)
     block_buffer_planned = 0;  // = block_buffer_tail;
+    system_chained       = false;
+    system_continued     = false;
+    curvature.reset();
 }
 
 // Called from stepper pulse function when the block is complete
 void plan_discard_current_block() {
     if (block_buffer_head != block_buffer_tail) {  // Discard non-empty buffer.
-        uint8_t block_index = plan_next_block_index(block_buffer_tail);
+        size_t block_index = plan_next_block_index(block_buffer_tail);
         // Push block_buffer_planned pointer, if encountered.
         if (block_buffer_tail == block_buffer_planned) {
             block_buffer_planned = block_index;
@@ -220,7 +236,19 @@ void plan_discard_current_block() {
 
 // Returns address of planner buffer block used by system motions. Called by segment generator.
 plan_block_t* plan_get_system_motion_block() {
-    return &block_buffer[block_buffer_head];
+    return &block_buffer[system_continued ? block_buffer_size : block_buffer_head];
+}
+
+float plan_get_system_motion_exit_speed_sqr() {
+    return (system_chained && !system_continued) ? block_speed[block_buffer_size].entry_speed_sqr : 0.0f;
+}
+
+bool plan_next_system_motion() {
+    if (!system_chained || system_continued) {
+        return false;
+    }
+    system_continued = true;
+    return true;
 }
 
 // Returns address of first planner block, if available. Called by various main program functions.
@@ -231,12 +259,16 @@ plan_block_t* plan_get_current_block() {
     return &block_buffer[block_buffer_tail];
 }
 
+plan_speed_t* plan_get_block_speed(const plan_block_t* block) {
+    return &block_speed[block - block_buffer];
+}
+
 float plan_get_exec_block_exit_speed_sqr() {
-    uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    size_t block_index = plan_next_block_index(block_buffer_tail);
     if (block_index == block_buffer_head) {
         return 0.0f;
     }
-    return block_buffer[block_index].entry_speed_sqr;
+    return block_speed[block_index].entry_speed_sqr;
 }
 
 // Returns the availability status of the block ring buffer. True, if full.
@@ -252,7 +284,7 @@ float plan_compute_profile_nominal_speed(plan_block_t* block) {
         nominal_speed *= (0.01f * sys.r_override);
     } else {
         if (!(block->motion.noFeedOverride)) {
-            nominal_speed *= (0.01f * sys.f_override);
+            nominal_speed *= (0.01f * sys.f_override) * (0.01f * sys.load_override);
         }
         if (nominal_speed > block->rapid_rate) {
             nominal_speed = block->rapid_rate;
@@ -267,21 +299,23 @@ float plan_compute_profile_nominal_speed(plan_block_t* block) {
 // Computes and updates the max entry speed (sqr) of the block, based on the minimum of the junction's
 // previous and current nominal speeds and max junction speed.
 static void plan_compute_profile_parameters(plan_block_t* block, float nominal_speed, float prev_nominal_speed) {
+    plan_speed_t* speed = plan_get_block_speed(block);
     // Compute the junction maximum entry based on the minimum of the junction speed and neighboring nominal speeds.
     if (nominal_speed > prev_nominal_speed) {
-        block->max_entry_speed_sqr = prev_nominal_speed * prev_nominal_speed;
+        speed->max_entry_speed_sqr = prev_nominal_speed * prev_nominal_speed;
     } else {
-        block->max_entry_speed_sqr = nominal_speed * nominal_speed;
+        speed->max_entry_speed_sqr = nominal_speed * nominal_speed;
     }
 
-    if (block->max_entry_speed_sqr > block->max_junction_speed_sqr) {
-        block->max_entry_speed_sqr = block->max_junction_speed_sqr;
+    if (speed->max_entry_speed_sqr > block->max_junction_speed_sqr) {
+        speed->max_entry_speed_sqr = block->max_junction_speed_sqr;
     }
 }
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters() {
-    uint8_t       block_index = block_buffer_tail;
+    Stepper::PrepLock lock;
+    size_t        block_index = block_buffer_tail;
     plan_block_t* block;
     float         nominal_speed;
     float         prev_nominal_speed = SOME_LARGE_VALUE;  // Set high for first block nominal speed calculation.
@@ -289,7 +323,7 @@ void plan_update_velocity_profile_parameters() {
         block         = &block_buffer[block_index];
         nominal_speed = plan_compute_profile_nominal_speed(block);
         plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
-        prev_nominal_speed = nominal_speed;
+        prev_nominal_speed = block->dwell_us ? 0.0f : nominal_speed;  // Motion after a dwell starts from rest
         block_index        = plan_next_block_index(block_index);
     }
     pl.previous_nominal_speed = prev_nominal_speed;  // Update prev nominal speed for next incoming block.
@@ -298,22 +332,263 @@ void plan_update_velocity_profile_parameters() {
     }
 }
 
+// Finish up a new or extended newest block by recalculating the plan, unless batched.  A
+// full buffer is planned at once, since the stepper may soon need its blocks.
+static void plan_recalculate_appended() {
+    TRACE_POINT(Planned, block_buffer[plan_prev_block_index(block_buffer_head)].trace_id);
+    size_t available = plan_get_block_buffer_available();
+    if (available < free_low_water) {
+        free_low_water = available;
+    }
+    if (batch_depth && !plan_check_full_buffer()) {
+        batch_pending = true;
+    } else {
+        // The optimal window only covers one new block
+        planner_recalculate(batch_pending ? false : PLANNER_OPTIMAL_WINDOW);
+        batch_pending = false;
+    }
+}
+
+// Turns the M62/M63 Q changes that fall within the block into its step events, and leaves
+// the rest for the blocks that follow
+static void plan_output_events(plan_block_t* block, plan_line_data_t* pl_data) {
+    OutputChanges& changes     = pl_data->output_changes;
+    float          millimeters = plan_get_block_speed(block)->millimeters;
+    size_t         taken       = 0;
+    for (; taken < changes.count && changes.change[taken].distance <= millimeters; taken++) {
+        const OutputChange& change = changes.change[taken];
+        OutputEvent&        event  = block->output_events[taken];
+        float               part   = change.distance > 0.0f ? change.distance / millimeters : 0.0f;
+        event.step                 = uint32_t(part * block->step_event_count);
+        event.mask                 = change.mask;
+        event.on                   = change.on;
+    }
+    block->n_output_events = taken;
+    for (size_t i = taken; i < changes.count; i++) {
+        changes.change[i - taken] = changes.change[i];
+        changes.change[i - taken].distance -= millimeters;
+    }
+    changes.count -= taken;
+}
+
+// Dense CAM output is often a run of nearly collinear short lines.  Rather than appending
+// another block, extend the newest one to the new target when the corner it would remove
+// is within merge_tolerance_mm of the straight line, and the two blocks would otherwise
+// execute identically.  Each merge adds the corner's distance to last_deviation, which
+// bounds how far every point merged so far is from the path, so the total stays within
+// the tolerance.  The newest block must not be the one the stepper is executing.
+static bool plan_merge_line(const plan_block_t* block, int32_t* target_steps, float feed_rate) {
+    if (config->_mergeTolerance <= 0.0f || !pl.last_mergeable || block->motion.systemMotion || block->is_jog ||
+        block->motion.inverseTime || block->motion.spindleSync || block->raster || block->outputs_mask) {
+        return false;
+    }
+    size_t last_index = plan_prev_block_index(block_buffer_head);
+    if (block_buffer_head == block_buffer_tail || last_index == block_buffer_tail) {
+        return false;
+    }
+    plan_block_t* last = &block_buffer[last_index];
+    if (block->direction_bits != last->direction_bits || block->motion.rapidMotion != last->motion.rapidMotion ||
+        block->motion.noFeedOverride != last->motion.noFeedOverride || block->spindle != last->spindle ||
+        block->spindle_speed != last->spindle_speed || block->coolant.Mist != last->coolant.Mist ||
+        block->coolant.Flood != last->coolant.Flood || block->line_number != last->line_number) {
+        return false;
+    }
+    if (!block->motion.rapidMotion && feed_rate != last->programmed_rate) {
+        return false;
+    }
+
+    // Distance of the corner at pl.position from the line from the start of the newest block to target
+    auto  n_axis     = Axes::_numberAxis;
+    float corner[MAX_N_AXIS], chord[MAX_N_AXIS];
+    float corner_sq = 0, chord_sq = 0, along = 0;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        corner[idx] = steps_to_mpos(pl.position[idx] - pl.last_start[idx], idx);
+        chord[idx]  = steps_to_mpos(target_steps[idx] - pl.last_start[idx], idx);
+        corner_sq += corner[idx] * corner[idx];
+        chord_sq += chord[idx] * chord[idx];
+        along += corner[idx] * chord[idx];
+    }
+    float deviation = pl.last_deviation + sqrtf(std::max(0.0f, corner_sq - along * along / chord_sq));
+    if (deviation > config->_mergeTolerance) {
+        return false;
+    }
+
+    // Replace the newest block's geometry.  Its junction with the block before it is kept.
+    last->step_event_count = 0;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        last->steps[idx]       = labs(target_steps[idx] - pl.last_start[idx]);
+        last->step_event_count = MAX(last->step_event_count, last->steps[idx]);
+    }
+    plan_speed_t* last_speed = &block_speed[last_index];
+    last_speed->millimeters  = convert_delta_vector_to_unit_vector(chord);
+    last_speed->acceleration = limit_acceleration_by_axis_maximum(chord);
+    last->jerk               = limit_jerk_by_axis_maximum(chord);
+    last->rapid_rate         = limit_rate_by_axis_maximum(chord);
+    if (last->motion.rapidMotion) {
+        last->programmed_rate = last->rapid_rate;
+    }
+    float nominal_speed = plan_compute_profile_nominal_speed(last);
+    plan_block_t* prev               = &block_buffer[plan_prev_block_index(last_index)];
+    float         prev_nominal_speed = prev->dwell_us ? 0.0f : plan_compute_profile_nominal_speed(prev);
+    plan_compute_profile_parameters(last, nominal_speed, prev_nominal_speed);
+    pl.previous_nominal_speed = nominal_speed;
+    pl.previous_millimeters   = last_speed->millimeters;
+    pl.last_deviation         = deviation;
+    copyAxes(pl.previous_unit_vec, chord);
+    copyAxes(pl.position, target_steps);
+    return true;
+}
+
+// The least of two axis limits, where zero, as from limit_jerk_by_axis_maximum(), is no limit
+static float least_limit(float a, float b) {
+    return a == 0.0f ? b : (b == 0.0f ? a : MIN(a, b));
+}
+
+// An arc's direction turns through its plane, so its axis limits are the least of those with
+// the plane part of the direction along either plane axis.  helix is the direction without the
+// plane part, whose length is plane.
+static float arc_limit(float (*limit)(float*), const float* helix, float plane, const PlanArc* arc) {
+    float vec[MAX_N_AXIS];
+    for (size_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        vec[idx] = helix[idx];
+    }
+    vec[arc->axis_0] = plane;
+    float value      = limit(vec);
+    vec[arc->axis_0] = 0.0f;
+    vec[arc->axis_1] = plane;
+    return least_limit(value, limit(vec));
+}
+
+// The unit vector of the direction of travel at the given angle along an arc
+static void arc_direction(const PlanArc* arc, float angle, const float* helix, float plane, float* unit_vec) {
+    float r0     = arc->start[arc->axis_0] - arc->center[0];
+    float r1     = arc->start[arc->axis_1] - arc->center[1];
+    float radius = hypot_f(r0, r1);
+    float c      = cosf(angle);
+    float s      = sinf(angle);
+    float t      = (arc->angular_travel < 0.0f ? -plane : plane) / radius;
+    for (size_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        unit_vec[idx] = helix[idx];
+    }
+    // The radius vector turned by angle, turned a further quarter turn in the direction of travel
+    unit_vec[arc->axis_0] = -(r0 * s + r1 * c) * t;
+    unit_vec[arc->axis_1] = (r0 * c - r1 * s) * t;
+}
+
+void plan_arc_point(const PlanArc* arc, float fraction, float* mpos) {
+    auto n_axis = Axes::_numberAxis;
+    if (fraction <= 0.0f || fraction >= 1.0f) {
+        const float* end = fraction <= 0.0f ? arc->start : arc->target;
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            mpos[idx] = end[idx];
+        }
+        return;
+    }
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        mpos[idx] = arc->start[idx] + fraction * (arc->target[idx] - arc->start[idx]);
+    }
+    float r0          = arc->start[arc->axis_0] - arc->center[0];
+    float r1          = arc->start[arc->axis_1] - arc->center[1];
+    float angle       = fraction * arc->angular_travel;
+    float c           = cosf(angle);
+    float s           = sinf(angle);
+    mpos[arc->axis_0] = arc->center[0] + r0 * c - r1 * s;
+    mpos[arc->axis_1] = arc->center[1] + r0 * s + r1 * c;
+}
+
+static bool plan_buffer_block(float* target, plan_line_data_t* pl_data, const PlanArc* arc, size_t index);
+
 bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+    return plan_buffer_block(target, pl_data, nullptr, block_buffer_head);
+}
+
+// The speed at the junction is as high as both blocks allow, given that the first starts
+// from rest and the second ends at rest.
+bool plan_chain_system_motion(float* target, plan_line_data_t* pl_data) {
+    if (system_chained || !plan_buffer_block(target, pl_data, nullptr, block_buffer_size)) {
+        return false;
+    }
+    Stepper::PrepLock lock;
+
+    plan_block_t* first       = &block_buffer[block_buffer_head];
+    plan_speed_t* first_speed = &block_speed[block_buffer_head];
+    plan_block_t* next        = &block_buffer[block_buffer_size];
+    plan_speed_t* next_speed  = &block_speed[block_buffer_size];
+    float         nominal     = MIN(plan_compute_profile_nominal_speed(first), plan_compute_profile_nominal_speed(next));
+    float         speed_sqr   = MIN(next->max_junction_speed_sqr, nominal * nominal);
+    speed_sqr                 = MIN(speed_sqr, 2.0f * first_speed->acceleration * first_speed->millimeters);
+    speed_sqr                 = MIN(speed_sqr, 2.0f * next_speed->acceleration * next_speed->millimeters);
+
+    next_speed->entry_speed_sqr = speed_sqr;
+    system_chained              = true;
+    return true;
+}
+
+bool plan_native_arcs() {
+    return block_arc != nullptr;
+}
+
+// The arc is kept in the slot of block_arc that goes with the block.  Until the block is
+// added, nothing else looks at that slot.
+bool plan_buffer_arc(float*            target,
+                     plan_line_data_t* pl_data,
+                     const float*      position,
+                     const float*      center,
+                     float             angular_travel,
+                     size_t            axis_0,
+                     size_t            axis_1) {
+    PlanArc* arc    = &block_arc[block_buffer_head];
+    auto     n_axis = Axes::_numberAxis;
+    float    helix  = 0.0f;
+    for (size_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        arc->start[idx]  = idx < n_axis ? position[idx] : 0.0f;
+        arc->target[idx] = idx < n_axis ? target[idx] : 0.0f;
+        if (idx != axis_0 && idx != axis_1) {
+            float delta = arc->target[idx] - arc->start[idx];
+            helix += delta * delta;
+        }
+    }
+    arc->center[0]      = center[0];
+    arc->center[1]      = center[1];
+    arc->angular_travel = angular_travel;
+    arc->axis_0         = axis_0;
+    arc->axis_1         = axis_1;
+    float radius        = hypot_f(position[axis_0] - center[0], position[axis_1] - center[1]);
+    float circular      = angular_travel * radius;
+    arc->millimeters    = sqrtf(circular * circular + helix);
+    return plan_buffer_block(target, pl_data, arc);
+}
+
+// index is block_buffer_head, or the spare block for a system motion that continues another
+static bool plan_buffer_block(float* target, plan_line_data_t* pl_data, const PlanArc* arc, size_t index) {
+    Stepper::PrepLock lock;
+    bool              chained = index != block_buffer_head;
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
-    plan_block_t* block = &block_buffer[block_buffer_head];
+    plan_block_t* block = &block_buffer[index];
+    plan_speed_t* speed = &block_speed[index];
     memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
+    *speed = {};
     block->motion        = pl_data->motion;
     block->coolant       = pl_data->coolant;
     block->spindle       = pl_data->spindle;
     block->spindle_speed = pl_data->spindle_speed;
     block->line_number   = pl_data->line_number;
     block->is_jog        = pl_data->is_jog;
+    block->sync_pitch    = pl_data->sync_pitch;
+#ifdef TRACE_POINTS
+    block->trace_id = Trace::current;
+#endif
+    block->raster        = pl_data->raster;
+    block->outputs_mask  = pl_data->outputs_mask;
+    block->outputs_on    = pl_data->outputs_on;
 
     // Compute and store initial move distance data.
     int32_t target_steps[MAX_N_AXIS], position_steps[MAX_N_AXIS];
     float   unit_vec[MAX_N_AXIS], delta_mm;
     // Copy position data based on type of motion being planned.
-    if (block->motion.systemMotion) {
+    if (chained) {
+        copyAxes(position_steps, system_end);
+    } else if (block->motion.systemMotion) {
         get_motor_steps(position_steps);
     } else {
         if (!block->is_jog && Homing::unhomed_axes()) {
@@ -324,47 +599,105 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         copyAxes(position_steps, pl.position);
     }
     auto n_axis = Axes::_numberAxis;
-    for (size_t idx = 0; idx < n_axis; idx++) {
-        // Calculate target position in absolute steps, number of steps for each axis, and determine max step events.
-        // Also, compute individual axes distance for move and prep unit vector calculations.
-        // NOTE: Computes true distance from converted step values.
-        target_steps[idx]       = mpos_to_steps(target[idx], idx);
-        block->steps[idx]       = labs(target_steps[idx] - position_steps[idx]);
-        block->step_event_count = MAX(block->step_event_count, block->steps[idx]);
-        delta_mm                = steps_to_mpos((target_steps[idx] - position_steps[idx]), idx);
-        unit_vec[idx]           = delta_mm;  // Store unit vector numerator
-        // Set direction bits. Bit enabled always means direction is negative.
-        if (delta_mm < 0.0) {
-            block->direction_bits |= bitnum_to_mask(idx);
+    with_axis_count<MAX_N_AXIS>(n_axis, [&](auto n) {
+        for (size_t idx = 0; idx < n; idx++) {
+            // Calculate target position in absolute steps, number of steps for each axis, and determine max step events.
+            // Also, compute individual axes distance for move and prep unit vector calculations.
+            // NOTE: Computes true distance from converted step values.
+            target_steps[idx]       = mpos_to_steps(target[idx], idx);
+            block->steps[idx]       = labs(target_steps[idx] - position_steps[idx]);
+            block->step_event_count = MAX(block->step_event_count, block->steps[idx]);
+            delta_mm                = steps_to_mpos((target_steps[idx] - position_steps[idx]), idx);
+            unit_vec[idx]           = delta_mm;  // Store unit vector numerator
+            // Set direction bits. Bit enabled always means direction is negative.
+            if (delta_mm < 0.0) {
+                block->direction_bits |= bitnum_to_mask(idx);
+            }
         }
-    }
-    // Bail if this is a zero-length block. Highly unlikely to occur.
-    if (block->step_event_count == 0) {
+    });
+    // Bail if this is a zero-length block. Highly unlikely to occur.  A full circle ends where it started.
+    if (block->step_event_count == 0 && !arc) {
         return false;
     }
+    if (!arc && !pl_data->output_changes.count && plan_merge_line(block, target_steps, pl_data->feed_rate)) {
+        plan_recalculate_appended();
+        return true;
+    }
+    pl_data->outputs_mask = 0;  // They are in this block
 
     // Calculate the unit vector of the line move and the block maximum feed rate and acceleration scaled
     // down such that no individual axes maximum values are exceeded with respect to the line direction.
     // NOTE: This calculation assumes all axes are orthogonal (Cartesian) and works with ABC-axes,
     // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
-    block->millimeters  = convert_delta_vector_to_unit_vector(unit_vec);
-    block->acceleration = limit_acceleration_by_axis_maximum(unit_vec);
-    block->rapid_rate   = limit_rate_by_axis_maximum(unit_vec);
+    float exit_vec[MAX_N_AXIS];  // Direction at the end of the block, for the next junction
+    if (arc) {
+        // The limits hold wherever the direction points in the plane.  On top of them, the
+        // centripetal acceleration of the motion in the plane must be within what the plane
+        // axes can do.
+        float helix[MAX_N_AXIS] = { 0.0f };
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            if (idx != arc->axis_0 && idx != arc->axis_1) {
+                helix[idx] = (arc->target[idx] - arc->start[idx]) / arc->millimeters;
+            }
+        }
+        float radius           = hypot_f(arc->start[arc->axis_0] - arc->center[0], arc->start[arc->axis_1] - arc->center[1]);
+        float plane            = fabsf(arc->angular_travel) * radius / arc->millimeters;
+        float none[MAX_N_AXIS] = { 0.0f };
+
+        block->arc          = arc;
+        speed->millimeters  = arc->millimeters;
+        speed->acceleration = arc_limit(limit_acceleration_by_axis_maximum, helix, plane, arc);
+        block->jerk         = arc_limit(limit_jerk_by_axis_maximum, helix, plane, arc);
+        block->rapid_rate   = arc_limit(limit_rate_by_axis_maximum, helix, plane, arc);
+        float centripetal   = arc_limit(limit_acceleration_by_axis_maximum, none, 1.0f, arc);
+        block->rapid_rate   = MIN(block->rapid_rate, sqrtf(centripetal * radius) / plane);
+        arc_direction(arc, 0.0f, helix, plane, unit_vec);
+        arc_direction(arc, arc->angular_travel, helix, plane, exit_vec);
+        curvature.reset();
+    } else {
+        speed->millimeters  = convert_delta_vector_to_unit_vector(unit_vec);
+        speed->acceleration = limit_acceleration_by_axis_maximum(unit_vec);
+        block->jerk         = limit_jerk_by_axis_maximum(unit_vec);
+        block->rapid_rate   = limit_rate_by_axis_maximum(unit_vec);
+        copyAxes(exit_vec, unit_vec);
+    }
+    plan_output_events(block, pl_data);
     // Store programmed rate.
     if (block->motion.rapidMotion) {
         block->programmed_rate = block->rapid_rate;
     } else {
         block->programmed_rate = pl_data->feed_rate;
         if (block->motion.inverseTime) {
-            block->programmed_rate *= block->millimeters;
+            block->programmed_rate *= speed->millimeters;
         }
     }
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
-    if ((block_buffer_head == block_buffer_tail) || (block->motion.systemMotion)) {
+    if (block->motion.systemMotion) {
+        // A system motion starts from rest and ends at a complete stop, unless it is chained to
+        // another that goes on in the same direction; plan_chain_system_motion() then sets the
+        // speed at the junction.
+        speed->entry_speed_sqr        = 0.0;
+        block->max_junction_speed_sqr = 0.0;
+        if (chained) {
+            float cos_theta = 0.0f;
+            for (size_t idx = 0; idx < n_axis; idx++) {
+                cos_theta += system_exit_vec[idx] * unit_vec[idx];
+            }
+            if (cos_theta > 0.999999) {
+                block->max_junction_speed_sqr = SOME_LARGE_VALUE;
+            }
+        } else {
+            system_chained   = false;
+            system_continued = false;
+        }
+        copyAxes(system_end, target_steps);
+        copyAxes(system_exit_vec, exit_vec);
+        curvature.reset();
+    } else if (block_buffer_head == block_buffer_tail) {
         // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
-        // If system motion, the system motion block always is assumed to start from rest and end at a complete stop.
-        block->entry_speed_sqr        = 0.0;
+        speed->entry_speed_sqr        = 0.0;
         block->max_junction_speed_sqr = 0.0;  // Starting from rest. Enforce start from zero velocity.
+        curvature.reset();
     } else {
         // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
         // Let a circle be tangent to both previous and current path line segments, where the junction
@@ -389,18 +722,22 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         // change the overall maximum entry speed conditions of all blocks.
         float junction_unit_vec[MAX_N_AXIS];
         float junction_cos_theta = 0.0;
-        for (size_t idx = 0; idx < n_axis; idx++) {
-            junction_cos_theta -= pl.previous_unit_vec[idx] * unit_vec[idx];
-            junction_unit_vec[idx] = unit_vec[idx] - pl.previous_unit_vec[idx];
-        }
+        with_axis_count<MAX_N_AXIS>(n_axis, [&](auto n) {
+            for (size_t idx = 0; idx < n; idx++) {
+                junction_cos_theta -= pl.previous_unit_vec[idx] * unit_vec[idx];
+                junction_unit_vec[idx] = unit_vec[idx] - pl.previous_unit_vec[idx];
+            }
+        });
         // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
         if (junction_cos_theta > 0.999999) {
             //  For a 0 degree acute junction, just set minimum junction speed.
             block->max_junction_speed_sqr = MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED;
+            curvature.reset();
         } else {
             if (junction_cos_theta < -0.999999) {
                 // Junction is a straight line or 180 degrees. Junction speed is infinite.
                 block->max_junction_speed_sqr = SOME_LARGE_VALUE;
+                curvature.reset();
             } else {
                 convert_delta_vector_to_unit_vector(junction_unit_vec);
                 float junction_acceleration = limit_acceleration_by_axis_maximum(junction_unit_vec);
@@ -408,6 +745,15 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
                 block->max_junction_speed_sqr =
                     MAX(MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED,
                         (junction_acceleration * config->_junctionDeviation * sin_theta_d2) / (1.0f - sin_theta_d2));
+                // On a curve that CAM has broken into short lines, the centripetal acceleration of
+                // the curve, not the corner at each junction, limits the speed.
+                float curve_speed_sqr = arc ? 0.0f
+                                            : curvature.junction_speed_sqr(pl.previous_millimeters,
+                                                                           speed->millimeters,
+                                                                           -junction_cos_theta,
+                                                                           config->_chordTolerance,
+                                                                           junction_acceleration);
+                block->max_junction_speed_sqr = MAX(block->max_junction_speed_sqr, curve_speed_sqr);
             }
         }
     }
@@ -416,18 +762,75 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         float nominal_speed = plan_compute_profile_nominal_speed(block);
         plan_compute_profile_parameters(block, nominal_speed, pl.previous_nominal_speed);
         pl.previous_nominal_speed = nominal_speed;
+        pl.previous_millimeters   = speed->millimeters;
+        // Remember where the block starts, in case the next one can be merged into it.
+        pl.last_mergeable =
+            !block->is_jog && !block->motion.inverseTime && !block->motion.spindleSync && !block->raster && !block->arc;
+        pl.last_deviation = 0.0f;
+        copyAxes(pl.last_start, pl.position);
         // Update previous path unit_vector and planner position.
-        copyAxes(pl.previous_unit_vec, unit_vec);
+        copyAxes(pl.previous_unit_vec, exit_vec);
         copyAxes(pl.position, target_steps);
+        if (block->raster) {
+            block->raster->busy.store(true, std::memory_order_relaxed);  // Released by the stepper
+        }
         // New block is all set. Update buffer head and next buffer head indices.
         block_buffer_head = next_buffer_head;
         next_buffer_head  = plan_next_block_index(block_buffer_head);
-        // Finish up by recalculating the plan with the new block.
-        planner_recalculate();
+        plan_recalculate_appended();
+    }
+    return true;
+}
+
+bool plan_buffer_dwell(uint32_t microseconds, plan_line_data_t* pl_data) {
+    if (microseconds == 0) {
+        return false;
     }
+    Stepper::PrepLock lock;
+    plan_block_t* block = &block_buffer[block_buffer_head];
+    plan_speed_t* speed = &block_speed[block_buffer_head];
+    memset(block, 0, sizeof(plan_block_t));
+    *speed = {};
+    block->coolant       = pl_data->coolant;
+    block->spindle       = pl_data->spindle;
+    block->spindle_speed = pl_data->spindle_speed;
+    block->line_number   = pl_data->line_number;
+    block->dwell_us      = microseconds;
+#ifdef TRACE_POINTS
+    block->trace_id = Trace::current;
+#endif
+    block->outputs_mask  = pl_data->outputs_mask;
+    block->outputs_on    = pl_data->outputs_on;
+
+    pl_data->outputs_mask = 0;
+    // With no length and no entry speed, the block needs only a nonzero acceleration to keep
+    // the planner passes and the segment prep finite.  The zero entry speed stops the motion
+    // before it, and a zero previous nominal speed makes the next block start from rest.
+    speed->acceleration       = 1.0f;
+    block->programmed_rate    = MINIMUM_FEED_RATE;
+    block->rapid_rate         = MINIMUM_FEED_RATE;
+    pl.previous_nominal_speed = 0.0f;
+    pl.last_mergeable         = false;
+    curvature.reset();
+
+    block_buffer_head = next_buffer_head;
+    next_buffer_head  = plan_next_block_index(block_buffer_head);
+    plan_recalculate_appended();
     return true;
 }
 
+PlanBatch::PlanBatch() {
+    ++batch_depth;
+}
+
+PlanBatch::~PlanBatch() {
+    if (--batch_depth == 0 && batch_pending) {
+        Stepper::PrepLock lock;
+        planner_recalculate(false);
+        batch_pending = false;
+    }
+}
+
 // Reset the planner position vectors. Called by the system abort/initialization routine.
 void plan_sync_position() {
     // TODO: For motor configurations not in the same coordinate frame as the machine position,
@@ -435,23 +838,53 @@ void plan_sync_position() {
     if (config->_axes) {
         get_motor_steps(pl.position);
     }
+    pl.last_mergeable = false;
+    curvature.reset();
 }
 
 // Returns the number of available blocks are in the planner buffer.
 // Called from report_realtime_status
-uint8_t plan_get_block_buffer_available() {
+size_t plan_get_block_buffer_available() {
     if (block_buffer_head >= block_buffer_tail) {
-        return (config->_planner_blocks - 1) - (block_buffer_head - block_buffer_tail);
+        return (block_buffer_size - 1) - (block_buffer_head - block_buffer_tail);
     } else {
         return block_buffer_tail - block_buffer_head - 1;
     }
 }
 
+size_t plan_get_block_buffer_low_water() {
+    return free_low_water;
+}
+
+void plan_reset_block_buffer_low_water() {
+    free_low_water = plan_get_block_buffer_size();
+}
+
+// Returns the number of usable blocks in the planner ring buffer.
+// One block is always kept empty to distinguish a full ring from an empty one.
+size_t plan_get_block_buffer_size() {
+    return block_buffer_size - 1;
+}
+
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize() {
+    Stepper::PrepLock lock;
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     Stepper::update_plan_block_parameters();
     block_buffer_planned = block_buffer_tail;
-    planner_recalculate();
+    planner_recalculate(false);
+}
+
+// Re-plan after the steppers have come to a stop for a feed hold, ready to resume.  Only the
+// block at the tail has changed, so the rest of the plan is kept, unless a batch left it unplanned.
+void plan_hold_complete() {
+    Stepper::PrepLock lock;
+    if (batch_pending) {
+        plan_cycle_reinitialize();
+        batch_pending = false;
+        return;
+    }
+    Stepper::update_plan_block_parameters();
+    Planner::replan_from_stop(block_speed, block_buffer_size, block_buffer_tail, block_buffer_head, block_buffer_planned);
 }
@@ -13,6 +13,7 @@
 #include "SpindleDatatypes.h"  // SpindleState
 #include "GCode.h"             // CoolantState
 #include "Types.h"             // AxisMask
+#include "Raster.h"            // Raster::Scanline
 
 #include <cstdint>
 
@@ -22,6 +23,55 @@ struct PlMotion {
     uint8_t systemMotion : 1;    // Single motion. Circumvents planner state. Used by home/park.
     uint8_t noFeedOverride : 1;  // Motion does not honor feed override.
     uint8_t inverseTime : 1;     // Interprets feed rate value as inverse time when set.
+    uint8_t spindleSync : 1;     // Feed follows the spindle encoder, sync_pitch per revolution. G33.
+    uint8_t syncReverse : 1;     // Continues the synchronized run with the spindle reversed. G33.1.
+};
+
+// M62/M63 Q switches user outputs, by output number, a distance into the next motion.  The
+// changes travel with the motion by distance, and the planner turns those that fall within
+// a block into step events of that block, for the stepper to fire.
+const size_t maxOutputEvents = 4;
+
+struct OutputChange {
+    float   distance;  // From the start of the motion, mm
+    uint8_t mask;
+    uint8_t on;
+};
+
+struct OutputChanges {
+    uint8_t      count;
+    OutputChange change[maxOutputEvents];  // In order of distance
+};
+
+struct OutputEvent {
+    uint32_t step;  // Step events from the start of the block
+    uint8_t  mask;
+    uint8_t  on;
+};
+
+// The geometry of a block that is a circular arc, see plan_buffer_arc().  Positions are in
+// machine mm.  Axes other than the two of the plane move linearly with the distance along it.
+struct PlanArc {
+    float   start[MAX_N_AXIS];   // Position at the start of the arc
+    float   target[MAX_N_AXIS];  // Position at the end of the arc
+    float   center[2];           // Center of the circle in the plane
+    float   angular_travel;      // Radians, positive counterclockwise
+    float   millimeters;         // Length of the arc, helical travel included
+    uint8_t axis_0;              // The plane of the circle
+    uint8_t axis_1;
+};
+
+// The speed fields of a block, the only ones the reverse and forward planning passes touch.
+// They are kept in an array of their own, parallel to the block ring, so that replanning a
+// long ring walks a few contiguous cache lines in internal memory rather than one line of
+// every block.  See plan_get_block_speed().
+struct plan_speed_t {
+    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
+    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
+    //   neighboring nominal speeds with overrides in (mm/min)^2
+    float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+    float millimeters;   // The remaining distance for this block to be executed in (mm).
+    // NOTE: This value may be altered by stepper algorithm during execution.
 };
 
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
@@ -32,22 +82,24 @@ struct plan_block_t {
 
     uint32_t steps[MAX_N_AXIS];  // Step count along each axis
     uint32_t step_event_count;   // The maximum step axis count and number of steps required to complete this block.
-    uint8_t  direction_bits;     // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
+    AxisMask direction_bits;     // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
 
     // Block condition data to ensure correct execution depending on states and overrides.
-    PlMotion     motion;       // Block bitflag motion conditions. Copied from pl_line_data.
-    SpindleState spindle;      // Spindle enable state
-    CoolantState coolant;      // Coolant state
-    int32_t      line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
+    PlMotion     motion;   // Block bitflag motion conditions. Copied from pl_line_data.
+    SpindleState spindle;  // Spindle enable state
+    CoolantState coolant;  // Coolant state
+    uint8_t      is_jog : 1;
 
-    // Fields used by the motion planner to manage acceleration. Some of these values may be updated
-    // by the stepper module during execution of special motion cases for replanning purposes.
-    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
-    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
-    //   neighboring nominal speeds with overrides in (mm/min)^2
-    float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
-    float millimeters;   // The remaining distance for this block to be executed in (mm).
-    // NOTE: This value may be altered by stepper algorithm during execution.
+    uint8_t outputs_mask;  // M62/M63 user outputs switched as the block starts
+    uint8_t outputs_on;
+
+    int32_t line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
+#ifdef TRACE_POINTS
+    uint32_t trace_id;  // Of the line that made the block, for Trace
+#endif
+
+    // Fields used by the stepper, with the speed fields in plan_speed_t, to shape the ramps.
+    float jerk;  // Axis-limit adjusted line jerk in (mm/min^3). Zero for trapezoidal ramps.
 
     // Stored rate limiting data used by planner when changes occur.
     float max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
@@ -57,7 +109,15 @@ struct plan_block_t {
     // Stored spindle speed data used by spindle overrides and resuming methods.
     SpindleSpeed spindle_speed;  // Block spindle speed. Copied from pl_line_data.
 
-    bool is_jog;
+    uint32_t dwell_us;  // Nonzero for a timed pause with no motion, see plan_buffer_dwell()
+
+    float sync_pitch;  // Travel per spindle revolution of a spindleSync block (mm)
+
+    Raster::Scanline* raster;  // Laser pixels along the block, see Raster.h
+    const PlanArc*    arc;     // Arc geometry, or nullptr for a straight line
+
+    uint8_t     n_output_events;  // M62/M63 Q user outputs switched along the block
+    OutputEvent output_events[maxOutputEvents];
 };
 
 // Planner data prototype. Must be used when passing new motions to the planner.
@@ -70,6 +130,18 @@ struct plan_line_data_t {
     int32_t      line_number;     // Desired line number to report when executing.
     bool         is_jog;          // true if this was generated due to a jog command
     bool         limits_checked;  // true if soft limits already checked
+    float        sync_pitch;      // Travel per spindle revolution (mm), for spindleSync
+
+    Raster::Scanline* raster;  // Laser pixels along the line, or nullptr
+
+    // M62/M63 user outputs to switch as the motion starts, by output number.  The planner
+    // clears them once they are in a block, so a move split into many lines switches once.
+    uint8_t outputs_mask;
+    uint8_t outputs_on;
+
+    // M62/M63 Q changes not yet in a block.  Each block takes those within its length and
+    // takes its length off the rest, so they apply along a move split into many lines.
+    OutputChanges output_changes;
 };
 
 void plan_init();
@@ -84,6 +156,39 @@ void plan_reset_buffer();  // Reset buffer only.
 // Returns true on success.
 bool plan_buffer_line(float* target, plan_line_data_t* pl_data);
 
+// Add a circular arc, in machine mm, as a single block.  The arc goes from position around
+// center, in the plane of axis_0 and axis_1, through angular_travel radians to target, and the
+// other axes move linearly to target along it.  Its speed is limited by the centripetal
+// acceleration of the circle, and the stepper follows the circle as it preps the segments.
+// Returns true on success.
+bool plan_buffer_arc(float*            target,
+                     plan_line_data_t* pl_data,
+                     const float*      position,
+                     const float*      center,
+                     float             angular_travel,
+                     size_t            axis_0,
+                     size_t            axis_1);
+
+// True if plan_buffer_arc() is available, i.e. native_arcs is set and its storage was allocated
+bool plan_native_arcs();
+
+// The position at a fraction, from 0 to 1, of the way along an arc
+void plan_arc_point(const PlanArc* arc, float fraction, float* mpos);
+
+// Add a pause of the given length to the buffer.  It executes in sequence with the motion
+// around it, which comes to a stop before it and starts from rest after it, with the spindle
+// and coolant states of pl_data.  Returns true on success.
+bool plan_buffer_dwell(uint32_t microseconds, plan_line_data_t* pl_data);
+
+// While a PlanBatch exists, plan_buffer_line() defers replanning until the batch ends or
+// the buffer fills, so a move made of many short lines, like an arc, is planned once
+// instead of once per line.  Batches may nest.
+class PlanBatch {
+public:
+    PlanBatch();
+    ~PlanBatch();
+};
+
 // Called when the current block is no longer needed. Discards the block and makes the memory
 // availible for new blocks.
 void plan_discard_current_block();
@@ -91,11 +196,25 @@ void plan_discard_current_block();
 // Gets the planner block for the special system motion cases. (Parking/Homing)
 plan_block_t* plan_get_system_motion_block();
 
+// Adds a system motion that starts where the one just planned with plan_buffer_line() ends.
+// The stepper runs the two back to back, without stopping between them if the second goes on
+// in the same direction.  Only one can be chained.  Returns true on success.
+bool plan_chain_system_motion(float* target, plan_line_data_t* pl_data);
+
+// The speed squared at the end of the system motion being prepped; 0 unless another is chained to it
+float plan_get_system_motion_exit_speed_sqr();
+
+// Moves on to the chained system motion, if there is one that has not been started
+bool plan_next_system_motion();
+
 // Gets the current block. Returns NULL if buffer empty
 plan_block_t* plan_get_current_block();
 
+// Gets the speed fields of a block in the ring
+plan_speed_t* plan_get_block_speed(const plan_block_t* block);
+
 // Increment block index with wrap-around
-static uint8_t plan_next_block_index(uint8_t block_index);
+static size_t plan_next_block_index(size_t block_index);
 
 // Called by step segment buffer when computing executing block velocity profile.
 float plan_get_exec_block_exit_speed_sqr();
@@ -112,8 +231,19 @@ void plan_sync_position();
 // Reinitialize plan with a partially completed block
 void plan_cycle_reinitialize();
 
+// Reinitialize plan after a feed hold has stopped the steppers, keeping the look-ahead
+void plan_hold_complete();
+
 // Returns the number of available blocks are in the planner buffer.
-uint8_t plan_get_block_buffer_available();
+size_t plan_get_block_buffer_available();
+
+// The fewest available blocks there have been since the last reset.  Near zero, the planner
+// had its full look-ahead; a high value while moving means lines did not arrive fast enough.
+size_t plan_get_block_buffer_low_water();
+void   plan_reset_block_buffer_low_water();
+
+// Returns the number of usable blocks in the planner buffer, i.e. its configured capacity.
+size_t plan_get_block_buffer_size();
 
 // Returns the status of the block ring buffer. True, if buffer is full.
 uint8_t plan_check_full_buffer();
@@ -0,0 +1,142 @@
+// Copyright (c) 2011-2016 Sungeun K. Jeon for Gnea Research LLC
+// Copyright (c) 2009-2011 Simen Svale Skogsrud
+// Copyright (c) 2011 Jens Geisler
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  PlannerRecalculate.h - the reverse and forward velocity planning passes of Planner.cpp
+
+  The passes only look at the speed fields of the blocks and the ring indices, so they are
+  kept here, free of any machine dependencies, where the native tests can exercise and
+  benchmark them.  See the PLANNER SPEED DEFINITION comment in Planner.cpp for the algorithm.
+*/
+
+#include <cstddef>
+
+namespace Planner {
+    // Forward plans the acceleration curve from the block at start to the head.  Also scans for
+    // optimal plan breakpoints and appropriately updates the planned pointer.
+    template <typename Block>
+    void forward_pass(Block* ring, size_t ring_size, size_t start, size_t head, size_t& planned) {
+        Block* current;
+        Block* next        = &ring[start];
+        size_t block_index = start + 1 == ring_size ? 0 : start + 1;
+        while (block_index != head) {
+            current = next;
+            next    = &ring[block_index];
+            // Any acceleration detected in the forward pass automatically moves the optimal planned
+            // pointer forward, since everything before this is all optimal. In other words, nothing
+            // can improve the plan from the buffer tail to the planned pointer by logic.
+            if (current->entry_speed_sqr < next->entry_speed_sqr) {
+                float entry_speed_sqr = current->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
+                // If true, current block is full-acceleration and we can move the planned pointer forward.
+                if (entry_speed_sqr < next->entry_speed_sqr) {
+                    next->entry_speed_sqr = entry_speed_sqr;  // Always <= max_entry_speed_sqr. Backward pass sets this.
+                    planned               = block_index;      // Set optimal plan pointer.
+                }
+            }
+            // Any block set at its maximum entry speed also creates an optimal plan up to this
+            // point in the buffer. When the plan is bracketed by either the beginning of the
+            // buffer and a maximum entry speed or two maximum entry speeds, every block in between
+            // cannot logically be further improved. Hence, we don't have to recompute them anymore.
+            if (next->entry_speed_sqr == next->max_entry_speed_sqr) {
+                planned = block_index;
+            }
+            block_index = block_index + 1 == ring_size ? 0 : block_index + 1;
+        }
+    }
+
+    // Block must have float members entry_speed_sqr, max_entry_speed_sqr, acceleration and
+    // millimeters.  tail_changed() is called when the exit speed of the block at the tail,
+    // which the stepper may already be executing, has been changed by the plan.
+    //
+    // With optimal_window false, every block after the planned index is replanned, as Grbl does.
+    // With optimal_window true, the reverse pass stops at the first block whose entry speed does
+    // not change, since no block before it can change either, and the forward pass starts just
+    // before the earliest changed block instead of at the planned index.  While streaming, the
+    // work per new block is then proportional to the number of blocks the new block affects,
+    // not to the number of blocks in the ring.
+    template <typename Block, typename TailChanged>
+    void recalculate(Block*        ring,
+                     size_t        ring_size,
+                     size_t        tail,
+                     size_t        head,
+                     size_t&       planned,
+                     bool          optimal_window,
+                     TailChanged&& tail_changed) {
+        auto prev_index = [ring_size](size_t index) { return (index == 0 ? ring_size : index) - 1; };
+
+        if (head == tail) {
+            // Nothing to do; planner buffer is empty.
+            return;
+        }
+        // Initialize block index to the last block in the planner buffer.
+        size_t block_index = prev_index(head);
+        // Bail. Can't do anything with one only one plan-able block.
+        if (block_index == planned) {
+            return;
+        }
+
+        // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
+        // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
+        // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
+        float  entry_speed_sqr;
+        Block* next;
+        Block* current = &ring[block_index];
+        // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
+        entry_speed_sqr          = 2 * current->acceleration * current->millimeters;
+        current->entry_speed_sqr = entry_speed_sqr < current->max_entry_speed_sqr ? entry_speed_sqr : current->max_entry_speed_sqr;
+        size_t first_changed     = block_index;  // Earliest block whose entry speed was replanned
+        block_index              = prev_index(block_index);
+        if (block_index == planned) {  // Only two plannable blocks in buffer. Reverse pass complete.
+            // Check if the first block is the tail. If so, notify stepper to update its current parameters.
+            if (block_index == tail) {
+                tail_changed();
+            }
+        } else {  // Three or more plan-able blocks
+            while (block_index != planned) {
+                next                 = current;
+                current              = &ring[block_index];
+                size_t current_index = block_index;
+                block_index          = prev_index(block_index);
+                // Compute maximum entry speed decelerating over the current block from its exit speed.
+                bool changed = false;
+                if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
+                    entry_speed_sqr = next->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
+                    if (entry_speed_sqr > current->max_entry_speed_sqr) {
+                        entry_speed_sqr = current->max_entry_speed_sqr;
+                    }
+                    changed                  = entry_speed_sqr != current->entry_speed_sqr;
+                    current->entry_speed_sqr = entry_speed_sqr;
+                }
+                if (optimal_window && !changed) {
+                    // Every earlier entry speed was planned against this unchanged one.
+                    break;
+                }
+                first_changed = current_index;
+                // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
+                if (block_index == tail) {
+                    tail_changed();
+                }
+            }
+        }
+
+        // Forward Pass: Forward plan the acceleration curve from just before the earliest replanned
+        // block onward, which is the planned pointer unless the reverse pass stopped early.
+        forward_pass(ring, ring_size, prev_index(first_changed), head, planned);
+    }
+
+    // Replans after the block at the tail has come to a stop, as at the end of a feed hold, when
+    // nothing else has changed since the last plan.  Lowering the entry speed of the tail cannot
+    // raise any maximum that the reverse pass found, so only the forward pass is needed, and the
+    // entry speeds of the rest of the plan are kept.
+    template <typename Block>
+    void replan_from_stop(Block* ring, size_t ring_size, size_t tail, size_t head, size_t& planned) {
+        planned = tail;
+        if (head != tail) {
+            forward_pass(ring, ring_size, tail, head, planned);
+        }
+    }
+}
@@ -6,9 +6,17 @@
 #include "Pin.h"
 #include "Machine/EventPin.h"
 #include "Machine/MachineConfig.h"
+#include "MotionControl.h"  // probing
+#include "Stepper.h"        // Stepper::latch_position()
+#include "Stepping.h"
+#include "Driver/StepTimer.h"
+#include "Driver/fluidnc_gpio.h"
+
+#include <freertos/FreeRTOS.h>  // portMUX_TYPE
+#include <cstring>             // memset
 
 extern void protocol_do_probe(void* arg);
-const ArgEvent probeEvent { protocol_do_probe };
+const ArgEvent probeEvent { protocol_do_probe, Event::Motion };
 
 class ProbeEventPin : public EventPin {
 private:
@@ -41,21 +49,70 @@ public:
     bool get() { return _value; }
 };
 
+// Keeps the stepper ISR from advancing the position while the edge ISR latches it
+static portMUX_TYPE latch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// The polled event pins see a probe contact only when the main loop gets to it, by which time
+// the motion has gone on.  On a native GPIO, an edge interrupt timestamps the contact against
+// the step timer and latches the position at that instant, to a fraction of a step.
+void IRAM_ATTR Probe::edge_isr(void* arg) {
+    uint32_t ticks = stepTimerGetTicks();  // First, so the timestamp is close to the edge
+
+    Probe* p     = static_cast<Probe*>(arg);
+    bool   state = (p->_watchProbe && p->_probeFast.read()) || (p->_watchToolsetter && p->_toolsetterFast.read());
+    if (probing && !p->_latched && (state ^ p->_away)) {
+        portENTER_CRITICAL_ISR(&latch_mux);
+        Stepper::latch_position(ticks, probe_steps, probe_substeps);
+        portEXIT_CRITICAL_ISR(&latch_mux);
+        p->_latched = true;
+    }
+}
+
+void Probe::attach_edge_isr(Pin& pin, FastPin& fast) {
+    // The batching engines run the stepper ISR ahead of the pulses, so its
+    // position does not match the time of the edge.
+    if (Stepping::_engine == Stepping::RMT_BATCH || Stepping::_engine == Stepping::I2S_STREAM ||
+        Stepping::_engine == Stepping::MCPWM_ENGINE) {
+        return;
+    }
+    if (!pin.capabilities().has(Pin::Capabilities::Native)) {
+        return;
+    }
+    fast.resolve(pin);
+    gpio_add_interrupt(pin.index(), GPIO_EDGE_ANY, edge_isr, this);
+}
+
 // Probe pin initialization routine.
 void Probe::init() {
     if (_probePin.defined()) {
         _probeEventPin = new ProbeEventPin("Probe", _probePin);
         _probeEventPin->init();
+        attach_edge_isr(_probePin, _probeFast);
     }
 
     if (_toolsetterPin.defined()) {
         _toolsetterEventPin = new ProbeEventPin("Toolsetter", _toolsetterPin);
         _toolsetterEventPin->init();
+        attach_edge_isr(_toolsetterPin, _toolsetterFast);
     }
 }
 
-void Probe::set_direction(bool away) {
-    _away = away;
+bool Probe::exists(ProbeInput input) const {
+    switch (input) {
+        case ProbeInput::Probe:
+            return _probePin.defined();
+        case ProbeInput::Toolsetter:
+            return _toolsetterPin.defined();
+        default:
+            return exists();
+    }
+}
+
+void Probe::set_direction(bool away, ProbeInput input) {
+    _away            = away;
+    _watchProbe      = input != ProbeInput::Toolsetter;
+    _watchToolsetter = input != ProbeInput::Probe;
+    _latched         = false;
 }
 
 // Returns the probe pin state. Triggered = true. Called by gcode parser.
@@ -63,9 +120,11 @@ bool Probe::get_state() {
     return ((_probeEventPin && _probeEventPin->get()) || (_toolsetterEventPin && _toolsetterEventPin->get()));
 }
 
-// Returns true if the probe pin is tripped, accounting for the direction (away or not).
+// Returns true if a watched probe pin is tripped, accounting for the direction (away or not).
 bool Probe::tripped() {
-    return get_state() ^ _away;
+    bool state = (_watchProbe && _probeEventPin && _probeEventPin->get()) ||
+                 (_watchToolsetter && _toolsetterEventPin && _toolsetterEventPin->get());
+    return state ^ _away;
 }
 
 void Probe::validate() {}
@@ -80,7 +139,11 @@ void protocol_do_probe(void* arg) {
     Probe* p =config->_probe;
     if (p->tripped() && probing) {
         probing = false;
-        get_motor_steps(probe_steps);
+        if (!p->latched()) {
+            // No edge interrupt, so the position is as of now
+            get_motor_steps(probe_steps);
+            memset(probe_substeps, 0, sizeof(probe_substeps));
+        }
         if (p->_hard_stop) {
             Stepper::reset();
             plan_reset();
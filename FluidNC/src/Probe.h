@@ -6,16 +6,36 @@
 
 #include "Configuration/HandlerBase.h"
 #include "Configuration/Configurable.h"
+#include "FastPin.h"
 
 #include <cstdint>
 class ProbeEventPin;
 
+// The inputs a probing cycle watches, selected by the Q word of G38.n.  Any, the default,
+// stops on either, so the probe and the toolsetter can each be used without reconfiguring.
+enum class ProbeInput : uint8_t {
+    Any        = 0,
+    Probe      = 1,
+    Toolsetter = 2,
+};
+
 class Probe : public Configuration::Configurable {
     // Inverts the probe pin state depending on user settings and probing cycle mode.
     bool _away = false;
+    // The inputs of the current cycle, see set_direction()
+    bool _watchProbe      = true;
+    bool _watchToolsetter = true;
     ProbeEventPin* _probeEventPin;
     ProbeEventPin* _toolsetterEventPin;
 
+    // Native GPIO probe inputs, which latch the position from an edge interrupt
+    FastPin       _probeFast;
+    FastPin       _toolsetterFast;
+    volatile bool _latched = false;
+
+    void                  attach_edge_isr(Pin& pin, FastPin& fast);
+    static void IRAM_ATTR edge_isr(void* arg);
+
 public:
     bool _hard_stop = false;
     // Configurable
@@ -31,16 +51,21 @@ public:
     Pin _toolsetterPin;
 
     bool exists() const { return _probePin.defined() || _toolsetterPin.defined(); }
+    bool exists(ProbeInput input) const;
     // Probe pin initialization routine.
     void init();
 
-    // setup probing direction G38.2 vs. G38.4
-    void set_direction(bool away);
+    // setup probing direction G38.2 vs. G38.4 and the inputs to watch, and rearm the edge latch
+    void set_direction(bool away, ProbeInput input = ProbeInput::Any);
+
+    // True if the edge interrupt has latched probe_steps and probe_substeps
+    // since set_direction().
+    bool latched() const { return _latched; }
 
     // Returns probe pin state. Triggered = true. Called by gcode parser and probe state monitor.
     bool get_state();
 
-    // Returns true if the probe pin is tripped, depending on the direction (away or not)
+    // Returns true if a watched probe pin is tripped, depending on the direction (away or not)
     bool IRAM_ATTR tripped();
 
     // Configuration handlers.
@@ -9,6 +9,8 @@
 #include "Configuration/Validator.h"
 #include "Configuration/ParseException.h"
 #include "Machine/Axes.h"
+#include "Machine/LimitPin.h"  // report_latency
+#include "ControlPin.h"        // report_latency
 #include "Regex.h"
 #include "WebUI/Authentication.h"
 #include "Report.h"
@@ -20,12 +22,29 @@
 #include "UartChannel.h"          // Uart0.write()
 #include "FileStream.h"           // FileStream()
 #include "StartupLog.h"           // startupLog
+#include "FlightRecorder.h"       // FlightRecorder::dump()
+#include "BootTiming.h"           // BootTiming::report()
+#include "HeapStats.h"            // HeapStats::report()
 #include "Driver/gpio_dump.h"     // gpio_dump()
 #include "FileCommands.h"         // make_file_commands()
+#include "Stepper.h"              // segment_underruns()
+#include "StepProfile.h"          // StepProfile::report()
+#include "CpuProfile.h"           // CpuProfile::command()
+#include "Trace.h"                // Trace::command()
+#include "CompiledGCode.h"        // CompiledGCode::to_text()
+#include "HeightMap.h"            // make_heightmap_commands()
+#include "Benchmarks.h"           // make_bench_commands()
+#include "Jog.h"                  // jog_velocity()
 
 #include "FluidPath.h"
 #include "HashFS.h"
+#include "Motors/TrinamicUartBus.h"
+#include "Motors/TrinamicTelemetry.h"
+#include "Raster.h"
+#include "Trochoid.h"
+#include "string_util.h"
 
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <filesystem>
@@ -158,7 +177,9 @@ void settings_restore(uint8_t restore_flag) {
         for (auto idx = CoordIndex::Begin; idx < CoordIndex::End; ++idx) {
             coords[idx]->setDefault();
         }
+        ToolTable::setDefault();
         coords[gc_state.modal.coord_select]->get(gc_state.coord_system);
+        gc_offsets_changed();
         report_wco_counter = 0;  // force next report to include WCO
     }
     log_info("Position offsets reset done");
@@ -177,6 +198,8 @@ extern void make_user_commands();
 void settings_init() {
     make_settings();
     make_file_commands();
+    make_heightmap_commands();
+    make_bench_commands();
 }
 
 static Error show_help(const char* value, AuthenticationLevel auth_level, Channel& out) {
@@ -487,13 +510,22 @@ static Error home_b(const char* value, AuthenticationLevel auth_level, Channel&
 static Error home_c(const char* value, AuthenticationLevel auth_level, Channel& out) {
     return home(bitnum_to_mask(C_AXIS), out);
 }
+static Error home_u(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return home(bitnum_to_mask(U_AXIS), out);
+}
+static Error home_v(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return home(bitnum_to_mask(V_AXIS), out);
+}
+static Error home_w(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return home(bitnum_to_mask(W_AXIS), out);
+}
 static std::string limit_set(uint32_t mask) {
-    const char* motor0AxisName = "xyzabc";
+    const char* motor0AxisName = "xyzabcuvw";
     std::string s;
     for (int axis = 0; axis < MAX_N_AXIS; axis++) {
         s += bitnum_is_true(mask, Machine::Axes::motor_bit(axis, 0)) ? char(motor0AxisName[axis]) : ' ';
     }
-    const char* motor1AxisName = "XYZABC";
+    const char* motor1AxisName = "XYZABCUVW";
     for (int axis = 0; axis < MAX_N_AXIS; axis++) {
         s += bitnum_is_true(mask, Machine::Axes::motor_bit(axis, 1)) ? char(motor1AxisName[axis]) : ' ';
     }
@@ -503,6 +535,7 @@ static Error show_limits(const char* value, AuthenticationLevel auth_level, Chan
     log_string(out, "Send ! to exit");
     log_stream(out, "Homing Axes : " << limit_set(Machine::Axes::homingMask));
     log_stream(out, "Limit Axes : " << limit_set(Machine::Axes::limitMask));
+    Machine::LimitPin::report_latency(out);
     log_string(out, "  PosLimitPins NegLimitPins Probe");
 
     const TickType_t interval = 500;
@@ -580,6 +613,13 @@ static Error doJog(const char* value, AuthenticationLevel auth_level, Channel& o
     return gc_execute_line(jogLine);
 }
 
+static Error doJogVelocity(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (state_is(State::ConfigAlarm)) {
+        return Error::ConfigurationInvalid;
+    }
+    return jog_velocity(value);
+}
+
 static Error listAlarms(const char* value, AuthenticationLevel auth_level, Channel& out) {
     if (state_is(State::ConfigAlarm)) {
         log_string(out, "Configuration alarm is active. Check the boot messages for 'ERR'.");
@@ -610,8 +650,7 @@ static Error listAlarms(const char* value, AuthenticationLevel auth_level, Chann
 }
 
 const char* errorString(Error errorNumber) {
-    auto it = ErrorNames.find(errorNumber);
-    return it == ErrorNames.end() ? NULL : it->second;
+    return enum_text(ErrorNames, errorNumber);
 }
 
 static Error listErrors(const char* value, AuthenticationLevel auth_level, Channel& out) {
@@ -632,8 +671,10 @@ static Error listErrors(const char* value, AuthenticationLevel auth_level, Chann
         }
     }
 
-    for (auto it = ErrorNames.begin(); it != ErrorNames.end(); it++) {
-        log_stream(out, static_cast<int>(it->first) << ": " << it->second);
+    for (int errorNumber = 0; errorNumber < int(ErrorNames.size()); errorNumber++) {
+        if (ErrorNames[errorNumber]) {
+            log_stream(out, errorNumber << ": " << ErrorNames[errorNumber]);
+        }
     }
     return Error::Ok;
 }
@@ -695,6 +736,20 @@ static Error macros_run(const char* value, AuthenticationLevel auth_level, Chann
 
 static Error dump_config(const char* value, AuthenticationLevel auth_level, Channel& out) {
     Channel* ss;
+    if (value && *value == '/') {
+        // $CD=/axes/x dumps only that part of the tree; a value that does not
+        // name a config section is taken as a file name, like /sd/config.yaml
+        try {
+            Configuration::RuntimeSetting rts(value, nullptr, out);
+            config->group(rts);
+            if (rts.isHandled_) {
+                return Error::Ok;
+            }
+        } catch (std::exception& ex) {
+            log_info("Config dump error: " << ex.what());
+            return Error::Ok;
+        }
+    }
     if (value) {
         // Use a file on the local file system unless there is an explicit prefix like /sd/
         std::error_code ec;
@@ -717,6 +772,11 @@ static Error dump_config(const char* value, AuthenticationLevel auth_level, Chan
     return Error::Ok;
 }
 
+static Error flush_settings(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    log_info_to(out, "Wrote " << flush_coordinates() << " coordinate systems and tools");
+    return Error::Ok;
+}
+
 static Error report_init_message_cmd(const char* value, AuthenticationLevel auth_level, Channel& out) {
     report_init_message(out);
 
@@ -757,6 +817,17 @@ static Error showStartupLog(const char* value, AuthenticationLevel auth_level, C
     return Error::Ok;
 }
 
+// $Startup/Timing shows how long each startup phase took; $Startup/Timing=json
+// emits the same data as a Chrome trace
+static Error showStartupTiming(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    bool json = value && strcasecmp(value, "json") == 0;
+    if (value && *value && !json) {
+        return Error::InvalidValue;
+    }
+    BootTiming::report(out, json);
+    return Error::Ok;
+}
+
 static Error showGPIOs(const char* value, AuthenticationLevel auth_level, Channel& out) {
     gpio_dump(out);
     return Error::Ok;
@@ -793,6 +864,125 @@ static Error setReportInterval(const char* value, AuthenticationLevel auth_level
     return Error::Ok;
 }
 
+// Names of the ReportField bits for $Report/Subscribe
+static const std::pair<const char*, uint8_t> reportFieldNames[] = {
+    { "Pos", ReportField::Position }, { "Bf", ReportField::Buffer }, { "Ln", ReportField::Line },
+    { "FS", ReportField::Feed },      { "Pn", ReportField::Pins },   { "WCO", ReportField::Wco },
+    { "Ov", ReportField::Overrides }, { "Ext", ReportField::Extra },
+};
+
+// $Report/Subscribe=<ms>[,<field>...][,Delta] sets up automatic status reports for the
+// channel in one command: the interval, the fields to include, and whether only changed
+// fields are sent.  Without fields, all are included.  0 unsubscribes.  The reports are
+// formatted from the snapshot shared by all subscribers, so a client need not poll with ?.
+static Error subscribeReports(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        char*    endptr;
+        uint32_t interval = strtol(value, &endptr, 10);
+        if (endptr == value || (*endptr != '\0' && *endptr != ',')) {
+            return Error::BadNumberFormat;
+        }
+        uint8_t fields = 0;
+        bool    delta  = false;
+        for (std::string_view rest(endptr); !rest.empty();) {
+            rest.remove_prefix(1);  // The comma
+            auto             comma = rest.find(',');
+            std::string_view name  = rest.substr(0, comma);
+            rest                   = comma == std::string_view::npos ? std::string_view() : rest.substr(comma);
+            if (string_util::equal_ignore_case(name, "Delta")) {
+                delta = true;
+                continue;
+            }
+            auto it = std::find_if(std::begin(reportFieldNames), std::end(reportFieldNames), [&](const auto& field) {
+                return string_util::equal_ignore_case(name, field.first);
+            });
+            if (it == std::end(reportFieldNames)) {
+                log_error_to(out, "Unknown report field " << name);
+                return Error::InvalidValue;
+            }
+            fields |= it->second;
+        }
+        out.setReportFields(fields ? fields : ReportField::All);
+        out.setReportDelta(interval && delta);
+        out.setReportInterval(interval);
+        // Start with a complete report
+        out.notifyWco();
+        out.notifyOvr();
+    }
+    if (!out.getReportInterval()) {
+        log_info_to(out, out.name() << " is not subscribed to status reports");
+        return Error::Ok;
+    }
+    LogStream msg(out, MsgLevelInfo, "[MSG:INFO: ");
+    msg << out.name() << " status reports every " << out.getReportInterval() << " ms with";
+    for (const auto& field : reportFieldNames) {
+        if (out.getReportFields() & field.second) {
+            msg << " " << field.first;
+        }
+    }
+    msg << (out.getReportDelta() ? ", changes only" : "");
+    return Error::Ok;
+}
+
+static Error setReportDelta(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (!strcasecmp(value, "on") || !strcmp(value, "1")) {
+            out.setReportDelta(true);
+        } else if (!strcasecmp(value, "off") || !strcmp(value, "0")) {
+            out.setReportDelta(false);
+        } else {
+            return Error::InvalidValue;
+        }
+    }
+    log_info_to(out, out.name() << " delta auto reports are " << (out.getReportDelta() ? "on" : "off"));
+    return Error::Ok;
+}
+
+// $Report/Format=binary sends the channel's status reports as binary frames, see
+// report_binary_status(); $Report/Format=text restores <...> reports.
+static Error setReportFormat(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (!strcasecmp(value, "binary")) {
+            out.setReportBinary(true);
+        } else if (!strcasecmp(value, "text")) {
+            out.setReportBinary(false);
+            // Start with a complete report
+            out.notifyWco();
+            out.notifyOvr();
+        } else {
+            return Error::InvalidValue;
+        }
+    }
+    log_info_to(out, out.name() << " status report format is " << (out.getReportBinary() ? "binary" : "text"));
+    return Error::Ok;
+}
+
+static Error setAckBatch(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!value) {
+        uint32_t actual = out.getAckBatch();
+        if (actual) {
+            log_info_to(out, out.name() << " ack batch window is " << actual << " ms");
+        } else {
+            log_info_to(out, out.name() << " ack batching is off");
+        }
+        return Error::Ok;
+    }
+    char*    endptr;
+    uint32_t intValue = strtol(value, &endptr, 10);
+
+    if (endptr == value || *endptr != '\0') {
+        return Error::BadNumberFormat;
+    }
+
+    uint32_t actual = out.setAckBatch(intValue);
+    if (actual) {
+        log_info_to(out, out.name() << " ack batch window set to " << actual << " ms");
+    } else {
+        log_info_to(out, out.name() << " ack batching turned off");
+    }
+    return Error::Ok;
+}
+
 static Error sendAlarm(const char* value, AuthenticationLevel auth_level, Channel& out) {
     int       intValue = value ? atoi(value) : 0;
     ExecAlarm alarm    = static_cast<ExecAlarm>(intValue);
@@ -806,6 +996,103 @@ static Error showHeap(const char* value, AuthenticationLevel auth_level, Channel
     return Error::Ok;
 }
 
+// $Heap/Stats shows free heap, fragmentation and allocation counts; =reset clears the counts
+static Error showHeapStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value && *value) {
+        if (strcasecmp(value, "reset") != 0) {
+            return Error::InvalidValue;
+        }
+        HeapStats::reset();
+        return Error::Ok;
+    }
+    HeapStats::report(out);
+    return Error::Ok;
+}
+
+// $Recorder/Dump shows the flight recorder's records from before the last reset, and
+// $Recorder/Dump=current those of this run
+static Error dumpRecorder(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    bool previous = true;
+    if (value && *value) {
+        if (strcasecmp(value, "current") != 0) {
+            return Error::InvalidValue;
+        }
+        previous = false;
+    }
+    FlightRecorder::dump(out, previous);
+    return Error::Ok;
+}
+
+// $Tasks/Show shows where each task runs, as set in the tasks: config section, and the least
+// free stack it has had
+static Error showTasks(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    Machine::Tasks::report(out);
+    return Error::Ok;
+}
+
+// $Stepping/Profile shows the ISR cycle histograms; =on starts a fresh profile, =off stops it,
+// and =reset clears it.
+static Error stepping_profile(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (strcasecmp(value, "on") == 0) {
+            StepProfile::reset();
+            StepProfile::enabled = true;
+        } else if (strcasecmp(value, "off") == 0) {
+            StepProfile::enabled = false;
+        } else if (strcasecmp(value, "reset") == 0) {
+            StepProfile::reset();
+        } else {
+            log_error_to(out, "$Stepping/Profile takes on, off, or reset");
+            return Error::InvalidValue;
+        }
+        return Error::Ok;
+    }
+    StepProfile::report(out);
+    return Error::Ok;
+}
+
+static Error cpuProfile(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return CpuProfile::command(value, out);
+}
+
+static Error showTrace(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return Trace::command(value, out);
+}
+
+static Error showTrinamicUartStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    MotorDrivers::TrinamicUartBus::report(out);
+    return Error::Ok;
+}
+
+static Error motorTelemetry(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return MotorDrivers::TrinamicTelemetry::command(value, out);
+}
+
+static Error rasterLine(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return Raster::line(value, out);
+}
+
+static Error trochoidSlot(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    return Trochoid::slot(value, out);
+}
+
+static Error showSegmentStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    log_info("Segments: " << Machine::Stepping::_segments << " low water: " << Stepper::segment_low_water()
+                          << " underruns: " << Stepper::segment_underruns());
+    return Error::Ok;
+}
+
+static Error showEventStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    log_info("Events dropped: " << protocol_event_overflows(Event::Motion) << " motion, " << protocol_event_overflows(Event::Normal)
+                                << " other; override changes merged: " << protocol_event_overflows(Event::Override));
+    return Error::Ok;
+}
+
+static Error showControlLatency(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    Machine::ControlPin::report_latency(out);
+    return Error::Ok;
+}
+
 // Commands use the same syntax as Settings, but instead of setting or
 // displaying a persistent value, a command causes some action to occur.
 // That action could be anything, from displaying a run-time parameter
@@ -831,12 +1118,16 @@ void make_user_commands() {
     new UserCommand("X", "Alarm/Disable", disable_alarm_lock, anyState);
     new UserCommand("NVX", "Settings/Erase", Setting::eraseNVS, notIdleOrAlarm, WA);
     new UserCommand("V", "Settings/Stats", Setting::report_nvs_stats, notIdleOrAlarm);
+    new UserCommand("SF", "Settings/Flush", flush_settings, notIdleOrAlarm);
     new UserCommand("#", "GCode/Offsets", report_ngc, notIdleOrAlarm);
     new UserCommand("MD", "Motor/Disable", motor_disable, notIdleOrAlarm);
     new UserCommand("ME", "Motor/Enable", motor_enable, notIdleOrAlarm);
     new UserCommand("MI", "Motors/Init", motors_init, notIdleOrAlarm);
+    new UserCommand("MTL", "Motors/Telemetry", motorTelemetry, anyState);
 
     new UserCommand("RM", "Macros/Run", macros_run, nullptr);
+    new UserCommand("RL", "Raster/Line", rasterLine, nullptr, WG, false);  // Queued like a G1 line
+    new UserCommand("GT", "Gen/Trochoid", trochoidSlot, nullptr, WG, false);
 
     new UserCommand("H", "Home", home_all, allowConfigStates);
     new UserCommand("HX", "Home/X", home_x, allowConfigStates);
@@ -845,6 +1136,9 @@ void make_user_commands() {
     new UserCommand("HA", "Home/A", home_a, allowConfigStates);
     new UserCommand("HB", "Home/B", home_b, allowConfigStates);
     new UserCommand("HC", "Home/C", home_c, allowConfigStates);
+    new UserCommand("HU", "Home/U", home_u, allowConfigStates);
+    new UserCommand("HV", "Home/V", home_v, allowConfigStates);
+    new UserCommand("HW", "Home/W", home_w, allowConfigStates);
 
     new UserCommand("MU0", "Msg/Uart0", msg_to_uart0, anyState);
     new UserCommand("MU1", "Msg/Uart1", msg_to_uart1, anyState);
@@ -861,9 +1155,24 @@ void make_user_commands() {
 
     new UserCommand("SA", "Alarm/Send", sendAlarm, anyState);
     new UserCommand("Heap", "Heap/Show", showHeap, anyState);
+    new UserCommand("HS", "Heap/Stats", showHeapStats, anyState);
+    new UserCommand("TS", "Tasks/Show", showTasks, anyState);
+    new UserCommand("EVS", "Events/Stats", showEventStats, anyState);
+    new UserCommand("CTL", "Control/Latency", showControlLatency, anyState);
+    new UserCommand("SEG", "Segments/Show", showSegmentStats, anyState);
+    new UserCommand("TUS", "TrinamicUart/Stats", showTrinamicUartStats, anyState);
+    new UserCommand("SP", "Stepping/Profile", stepping_profile, anyState);
+    new UserCommand("CPU", "CPU/Profile", cpuProfile, anyState);
+    new UserCommand("TR", "Trace", showTrace, anyState);
     new UserCommand("SS", "Startup/Show", showStartupLog, anyState);
+    new UserCommand("FR", "Recorder/Dump", dumpRecorder, anyState);
+    new UserCommand("ST", "Startup/Timing", showStartupTiming, anyState);
 
     new UserCommand("RI", "Report/Interval", setReportInterval, anyState);
+    new UserCommand("RD", "Report/Delta", setReportDelta, anyState);
+    new UserCommand("RS", "Report/Subscribe", subscribeReports, anyState);
+    new UserCommand("RF", "Report/Format", setReportFormat, anyState);
+    new UserCommand("AB", "Ack/Batch", setAckBatch, anyState);
 
     new UserCommand("13", "Report/Inches", switchInchMM, notIdleOrAlarm);
     new UserCommand("30", "FakeMaxSpindleSpeed", fakeMaxSpindleSpeed, notIdleOrAlarm);
@@ -872,6 +1181,7 @@ void make_user_commands() {
     new UserCommand("GS", "GRBL/Show", report_init_message_cmd, notIdleOrAlarm);
 
     new AsyncUserCommand("J", "Jog", doJog, notIdleOrJog);
+    new AsyncUserCommand("JV", "Jog/Velocity", doJogVelocity, notIdleOrJog);
     new AsyncUserCommand("G", "GCode/Modes", report_gcode, anyState);
 };
 
@@ -910,6 +1220,8 @@ char* normalize_key(char* start) {
 // This is the handler for all forms of settings commands,
 // $..= and [..], with and without a value.
 Error do_command_or_setting(const char* key, const char* value, AuthenticationLevel auth_level, Channel& out) {
+    HeapScope heapScope(HeapTag::Settings);
+
     // If value is NULL, it means that there was no value string, i.e.
     // $key without =, or [key] with nothing following.
     // If value is not NULL, but the string is empty, that is the form
@@ -918,16 +1230,14 @@ Error do_command_or_setting(const char* key, const char* value, AuthenticationLe
     // Try to execute a command.  Commands handle values internally;
     // you cannot determine whether to set or display solely based on
     // the presence of a value.
-    for (Command* cp : Command::List) {
-        if ((strcasecmp(cp->getName(), key) == 0) || (cp->getGrblName() && strcasecmp(cp->getGrblName(), key) == 0)) {
-            if (auth_failed(cp, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (cp->synchronous()) {
-                protocol_buffer_synchronize();
-            }
-            return cp->action(value, auth_level, out);
+    if (Command* cp = Command::find(key)) {
+        if (auth_failed(cp, value, auth_level)) {
+            return Error::AuthenticationFailed;
         }
+        if (cp->synchronous()) {
+            protocol_buffer_synchronize();
+        }
+        return cp->action(value, auth_level, out);
     }
 
     // First search the yaml settings by name. If found, set a new
@@ -947,6 +1257,7 @@ Error do_command_or_setting(const char* key, const char* value, AuthenticationLe
                     log_error("Validation error: " << ex.what());
                     return Error::ConfigurationInvalid;
                 }
+                invalidate_mpos();
 
                 Configuration::AfterParse afterParseHandler;
                 config->afterParse();
@@ -964,33 +1275,29 @@ Error do_command_or_setting(const char* key, const char* value, AuthenticationLe
 
     // Next search the settings list by text name. If found, set a new
     // value if one is given, otherwise display the current value
-    for (Setting* s : Setting::List) {
-        if (strcasecmp(s->getName(), key) == 0) {
-            if (auth_failed(s, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (value) {
-                return s->setStringValue(uriDecode(value));
-            } else {
-                show_setting(s->getName(), s->getStringValue(), NULL, out);
-                return Error::Ok;
-            }
+    if (Setting* s = Setting::findByName(key)) {
+        if (auth_failed(s, value, auth_level)) {
+            return Error::AuthenticationFailed;
+        }
+        if (value) {
+            return s->setStringValue(uriDecode(value));
+        } else {
+            show_setting(s->getName(), s->getStringValue(), NULL, out);
+            return Error::Ok;
         }
     }
 
     // Then search the setting list by compatible name.  If found, set a new
     // value if one is given, otherwise display the current value in compatible mode
-    for (Setting* s : Setting::List) {
-        if (s->getGrblName() && strcasecmp(s->getGrblName(), key) == 0) {
-            if (auth_failed(s, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (value) {
-                return s->setStringValue(uriDecode(value));
-            } else {
-                show_setting(s->getGrblName(), s->getCompatibleValue(), NULL, out);
-                return Error::Ok;
-            }
+    if (Setting* s = Setting::findByGrblName(key)) {
+        if (auth_failed(s, value, auth_level)) {
+            return Error::AuthenticationFailed;
+        }
+        if (value) {
+            return s->setStringValue(uriDecode(value));
+        } else {
+            show_setting(s->getGrblName(), s->getCompatibleValue(), NULL, out);
+            return Error::Ok;
         }
     }
 
@@ -1001,13 +1308,14 @@ Error do_command_or_setting(const char* key, const char* value, AuthenticationLe
     Error retval = Error::InvalidStatement;
     if (!value) {
         bool found = false;
+        // The C++ standard regular expression library supports many more
+        // regular expression forms than the simple one in Regex.cpp, but
+        // consumes a lot of FLASH.  The extra capability is rarely useful
+        // especially now that there are only a few NVS settings.
+        Regex pattern(key, false);
         for (Setting* s : Setting::List) {
             auto test = s->getName();
-            // The C++ standard regular expression library supports many more
-            // regular expression forms than the simple one in Regex.cpp, but
-            // consumes a lot of FLASH.  The extra capability is rarely useful
-            // especially now that there are only a few NVS settings.
-            if (regexMatch(key, test, false)) {
+            if (pattern.match(test)) {
                 const char* displayValue = auth_failed(s, value, auth_level) ? "<Authentication required>" : s->getStringValue();
                 show_setting(test, displayValue, NULL, out);
                 found = true;
@@ -1077,7 +1385,7 @@ Error execute_line(char* line, Channel& channel, AuthenticationLevel auth_level)
     }
     Error result = gc_execute_line(line);
     if (result != Error::Ok && result != Error::Reset) {
-        log_debug_to(channel, "Bad GCode: " << line);
+        log_debug_to(channel, "Bad GCode: " << (line[0] == CompiledGCode::words_record ? CompiledGCode::to_text(line) : std::string(line)));
     }
     return result;
 }
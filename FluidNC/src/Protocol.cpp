@@ -20,8 +20,17 @@
 #include "SettingsDefinitions.h"  // gcode_echo
 #include "Machine/LimitPin.h"
 #include "Job.h"
+#include "JobStats.h"
+#include "Metrics.h"
+#include "FlightRecorder.h"
+#include "Trace.h"
+#include "Jog.h"  // jog_velocity_poll
+#include "MachineStatus.h"  // machine_status_publish
 #include "Driver/restart.h"
 
+#include <esp_timer.h>
+#include <atomic>
+
 volatile ExecAlarm lastAlarm;  // The most recent alarm code
 
 volatile const char* unwind_cause = nullptr;
@@ -43,6 +52,7 @@ const std::map<ExecAlarm, const char*> AlarmNames = {
     { ExecAlarm::HardStop, "Hard Stop" },
     { ExecAlarm::Unhomed, "Unhomed" },
     { ExecAlarm::Init, "Init" },
+    { ExecAlarm::StepLoss, "Step Loss" },
 };
 
 const char* alarmString(ExecAlarm alarmNumber) {
@@ -99,33 +109,158 @@ void drain_messages() {
     }
 }
 
+// Consecutive messages to the same channel at the same level are joined and
+// written with one print_msg() call, so a burst costs one channel write, not one
+// per line.  Channels that buffer output, like telnet, send it on flush().
+static void flush_batch(Channel* channel, MsgLevel level, char* batch, size_t& length) {
+    if (length) {
+        batch[length] = '\0';
+        channel->print_msg(level, batch);
+        length = 0;
+    }
+    channel->flush();
+}
+
 void output_loop(void* unused) {
+    static char batch[1024];
+    uint32_t    reported = 0;
     while (true) {
         // Block until a message is received
-        LogMessage message;
-        if (xQueueReceive(message_queue, &message, portMAX_DELAY)) {
-            if (message.isString) {
-                std::string* s = static_cast<std::string*>(message.line);
-                message.channel->print_msg(message.level, s->c_str());
-                delete s;
+        LogMessage* message;
+        if (!xQueueReceive(message_queue, &message, portMAX_DELAY)) {
+            continue;
+        }
+        Channel* channel = message->channel;
+        MsgLevel level   = message->level;
+        if (message->kind == LogMessage::Binary) {
+            channel->write(reinterpret_cast<const uint8_t*>(message->text), message->length);
+            channel->flush();
+            log_release(message);
+            continue;
+        }
+        size_t length = 0;
+        while (true) {
+            const char* line = message->c_str();
+            size_t      len  = strlen(line);
+            if (length && length + 2 + len >= sizeof(batch)) {
+                flush_batch(channel, level, batch, length);
+            }
+            if (len >= sizeof(batch)) {
+                channel->print_msg(level, line);
             } else {
-                const char* cp = static_cast<const char*>(message.line);
-                message.channel->print_msg(message.level, cp);
+                if (length) {
+                    batch[length++] = '\r';
+                    batch[length++] = '\n';
+                }
+                memcpy(batch + length, line, len);
+                length += len;
+            }
+            log_release(message);
+
+            LogMessage* next;
+            if (!xQueuePeek(message_queue, &next, 0) || next->channel != channel || next->level != level ||
+                next->kind == LogMessage::Binary) {
+                break;
             }
+            xQueueReceive(message_queue, &message, 0);
+        }
+        flush_batch(channel, level, batch, length);
+
+        uint32_t dropped = log_dropped();
+        if (dropped != reported) {
+            log_warn(dropped - reported << " log messages dropped");
+            reported = dropped;
         }
     }
 }
 
-Channel* activeChannel = nullptr;  // Channel associated with the input line
+// Complete lines pass from the polling task to the main loop through a small
+// single-producer, single-consumer ring, so the poller can assemble the next
+// line while the main loop is executing the current one.  A slot is released
+// only after its line has been executed and acknowledged.
+struct ReadyLine {
+    Channel* channel;  // Source of the line, to be acknowledged
+    char     line[Channel::maxLine];
+#ifdef TRACE_POINTS
+    uint32_t trace_id;
+#endif
+};
+static const size_t        readyCapacity = 4;
+static ReadyLine           readyLines[readyCapacity];
+static std::atomic<size_t> readyHead { 0 };  // Advanced by the poller
+static std::atomic<size_t> readyTail { 0 };  // Advanced by the main loop
+
+static bool lines_ready() {
+    return readyHead != readyTail;
+}
+
+// Discards lines that were read ahead, e.g. on reset, when the channel
+// input queues are flushed too.
+static void discard_ready_lines() {
+    readyTail = size_t(readyHead);
+}
+
+// Whether the line after this one may be read before this one executes.
+// Anything that could start a job, e.g. a $ or [ command, an O-code call or
+// an M code such as M6 that runs a macro, or a % may change where the next
+// line comes from, so it must execute first.
+static bool allows_read_ahead(const char* line) {
+    while (isspace(*line)) {
+        ++line;
+    }
+    if (*line == '$' || *line == '[') {
+        return false;
+    }
+    for (; *line; ++line) {
+        char c = toupper(*line);
+        if (c == 'M' || c == 'O' || c == '%') {
+            return false;
+        }
+    }
+    return true;
+}
 
 TaskHandle_t pollingTask = nullptr;
+TaskHandle_t mainTask    = nullptr;
+
+// An idle loop sleeps for at most this long, so sources that cannot wake it,
+// such as module sockets, are still polled with bounded latency.
+static const TickType_t idleWaitTicks = 1;
+
+// Polling does not sleep while lines keep arriving, so that streaming throughput
+// does not depend on the tick rate.
+static const TickType_t streamingTicks = pdMS_TO_TICKS(50);
+
+void protocol_wake_polling() {
+    if (pollingTask) {
+        xTaskNotifyGive(pollingTask);
+    }
+}
 
-char activeLine[Channel::maxLine];
+void protocol_wake_main() {
+    if (mainTask) {
+        xTaskNotifyGive(mainTask);
+    }
+}
+
+void IRAM_ATTR protocol_wake_main_from_ISR() {
+    if (mainTask) {
+        vTaskNotifyGiveFromISR(mainTask, NULL);
+    }
+}
 
 bool pollingPaused = false;
 void polling_loop(void* unused) {
+    TickType_t lastLine = xTaskGetTickCount();
+
     // Poll the input sources waiting for a complete line to arrive
-    for (; true; /*feedLoopWDT(), */ vTaskDelay(0)) {
+    for (; true; /*feedLoopWDT(), */) {
+        if ((xTaskGetTickCount() - lastLine) < streamingTicks) {
+            vTaskDelay(0);
+        } else {
+            ulTaskNotifyTake(pdTRUE, idleWaitTicks);
+        }
+
         // Polling is paused when xmodem is using a channel for binary upload
         if (pollingPaused) {
             vTaskDelay(100);
@@ -135,17 +270,27 @@ void polling_loop(void* unused) {
         // Polling without an argument checks for realtime characters
         // Polling with an argument both checks for realtime characters and
         // returns a line-oriented command if one is ready.
+        machine_status_publish();
+        FlightRecorder::sample();
+        if (Job::active()) {
+            JobStats::sample();
+        }
         pollChannels();
         for (auto const& module : Modules()) {
             module->poll();
         }
 
-        // If activeChannel is non-null, it means that we have recieved a line
-        // but the task running protocol_main_loop() has not yet picked it up.
-        // activeChannel is thus a form of flow control between the protocol
-        // task that processes GCode lines and other events and this task that
-        // handles IO from channels.
-        if (!activeChannel) {
+        // The ready ring is a form of flow control between the protocol task
+        // that processes GCode lines and other events and this task that
+        // handles IO from channels.  Job lines are handed over one at a time,
+        // as are lines that follow one that might start a job, so they are
+        // never read ahead of lines that the job itself would run.
+        size_t head = readyHead;
+        bool   room = head == readyTail ||
+                    (head - readyTail < readyCapacity && !Job::active() && allows_read_ahead(readyLines[(head - 1) % readyCapacity].line));
+        if (room) {
+            Channel* activeChannel = nullptr;
+            char*    activeLine    = readyLines[head % readyCapacity].line;
             // Job channels have priority
             if (!Job::active()) {
                 unwind_cause = nullptr;
@@ -166,8 +311,10 @@ void polling_loop(void* unused) {
                 }
                 // A job channel is active, so accept line-oriented input only
                 // from the job channel on top of the job stack.
-                auto channel = Job::channel();
-                auto status  = channel->pollLine(activeLine);
+                auto    channel   = Job::channel();
+                int64_t readStart = esp_timer_get_time();
+                auto    status    = channel->pollLine(activeLine);
+                JobStats::read_done(status == Error::Ok, esp_timer_get_time() - readStart);
                 switch (status) {
                     case Error::Ok:
                         activeChannel = channel;
@@ -177,7 +324,9 @@ void polling_loop(void* unused) {
                     case Error::Eof:
                         notifyf("Job done", "%s job sent", channel->name());
                         log_debug(channel->name() << " job sent");
-                        Job::unnest();
+                        if (!Job::next_file()) {
+                            Job::unnest();
+                        }
                         break;
                     default:
                         if (Job::leader) {
@@ -189,6 +338,15 @@ void polling_loop(void* unused) {
                         break;
                 }
             }
+            if (activeChannel) {
+#ifdef TRACE_POINTS
+                readyLines[head % readyCapacity].trace_id = Trace::received();
+#endif
+                readyLines[head % readyCapacity].channel = activeChannel;
+                readyHead                                = head + 1;
+                lastLine                                 = xTaskGetTickCount();
+                protocol_wake_main();
+            }
         }
     }
 }
@@ -203,23 +361,8 @@ void start_polling() {
     if (pollingTask) {
         vTaskResume(pollingTask);
     } else {
-        xTaskCreatePinnedToCore(polling_loop,      // task
-                                "poller",          // name for task
-                                8192,              // size of task stack
-                                0,                 // parameters
-                                1,                 // priority
-                                &pollingTask,      // task handle
-                                SUPPORT_TASK_CORE  // core
-        );
-        xTaskCreatePinnedToCore(output_loop,  // task
-                                "output",     // name for task
-                                16000,
-                                // 8192,              // size of task stack
-                                0,                 // parameters
-                                2,                 // priority
-                                &outputTask,       // task handle
-                                SUPPORT_TASK_CORE  // core
-        );
+        Machine::Tasks::create("poller", polling_loop, nullptr, &pollingTask);
+        Machine::Tasks::create("output", output_loop, nullptr, &outputTask);
     }
 }
 
@@ -271,32 +414,58 @@ uint32_t heapLowWater           = UINT_MAX;
 uint32_t heapLowWaterReported   = UINT_MAX;
 int32_t  heapLowWaterReportTime = 0;
 
+// The main loop may sleep only when nothing is moving, because it also feeds
+// the step segment buffer.
+static bool protocol_can_sleep() {
+    return !lines_ready() && !jog_velocity_active() && (state_is(State::Idle) || state_is(State::Alarm) || state_is(State::ConfigAlarm) || state_is(State::Sleep));
+}
+
 void protocol_main_loop() {
+    mainTask = xTaskGetCurrentTaskHandle();
     start_polling();
 
     // ---------------------------------------------------------------------------------
     // Primary loop! Upon a system abort, this exits back to main() to reset the system.
     // This is also where the system idles while waiting for something to do.
     // ---------------------------------------------------------------------------------
-    for (;; vTaskDelay(0)) {
-        if (activeChannel) {
+    for (;;) {
+        if (protocol_can_sleep()) {
+            flush_coordinates_when_idle();
+            ulTaskNotifyTake(pdTRUE, idleWaitTicks);
+        } else {
+            vTaskDelay(0);
+        }
+        if (lines_ready()) {
             // The input polling task has collected a line of input
+            size_t     tail  = readyTail;
+            ReadyLine& ready = readyLines[tail % readyCapacity];
             if (gcode_echo->get()) {
-                report_echo_line_received(activeLine, allChannels);
+                report_echo_line_received(ready.line, allChannels);
             }
 
-            Channel* out_channel = Job::leader ? Job::leader : activeChannel;
-            Error    status_code = execute_line(activeLine, *out_channel, AuthenticationLevel::LEVEL_GUEST);
+#ifdef TRACE_POINTS
+            Trace::current = ready.trace_id;
+#endif
+            Channel* out_channel = Job::leader ? Job::leader : ready.channel;
+            Error    status_code = execute_line(ready.line, *out_channel, AuthenticationLevel::LEVEL_GUEST);
+            Metrics::line_executed();
+            if (status_code != Error::Ok) {
+                FlightRecorder::error(status_code);
+            }
 
             // Tell the channel that the line has been processed.
-            // If the line was aborted, the channel could be invalid
-            if (!sys.abort) {
-                activeChannel->ack(status_code);
+            // If the line was aborted, the channel could be invalid,
+            // and any lines read after it are stale too.
+            if (sys.abort) {
+                discard_ready_lines();
+            } else {
+                ready.channel->ack(status_code);
+                readyTail = tail + 1;
             }
 
             // Tell the input polling task that the line has been processed,
             // so it can give us another one when available
-            activeChannel = nullptr;
+            protocol_wake_polling();
         }
 
         // Auto-cycle start any queued moves.
@@ -305,6 +474,7 @@ void protocol_main_loop() {
         if (sys.abort) {
             sys.abort = false;
         }
+        jog_velocity_poll();
 
         // check to see if we should disable the stepper drivers
         // If idleEndTime is 0, no disable is pending.
@@ -355,6 +525,10 @@ void protocol_buffer_synchronize() {
             return;  // Check for system abort
         }
     } while (plan_get_current_block() || state_is(State::Cycle));
+    // M62/M63, coolant and spindle speed changes that no motion has taken up happen once the motion is done
+    config->_userOutputs->applyQueued();
+    config->_coolant->apply_queued();
+    spindle->apply_queued();
 }
 
 // Auto-cycle start triggers when there is a motion ready to execute and if the main program is not
@@ -391,7 +565,13 @@ static void protocol_run_startup_lines() {
     config->_macros->_startup_line1.run(&allChannels);
 }
 
+// This is a warm restart: it clears the motion state in sys, the planner, the
+// stepper and the gcode parser, but keeps the parsed config and leaves the
+// peripherals alone - Trinamic drivers, the VFD link and network connections
+// are not set up again.  A full restart like $Bye reboots the chip instead.
 static void protocol_do_soft_restart() {
+    int64_t startTime = esp_timer_get_time();
+
     // Reset primary systems.
     system_reset();
     protocol_reset();
@@ -414,9 +594,15 @@ static void protocol_do_soft_restart() {
     // Sync cleared gcode and planner positions to current system position.
     plan_sync_position();
     gc_sync_position();
+
+    // With the planner cleared, the buffer sync before the NVS write has
+    // nothing to wait for
+    flush_coordinates();
     allChannels.flushRx();
+    discard_ready_lines();
     report_init_message(allChannels);
     mc_init();
+    log_debug("Soft reset took " << int(esp_timer_get_time() - startTime) << " us");
 
     // Check for and report alarm state after a reset, error, or an initial power up.
     // NOTE: Sleep mode disables the stepper drivers and position can't be guaranteed.
@@ -461,6 +647,8 @@ static void protocol_do_start() {
 
 static void protocol_do_alarm(void* alarmVoid) {
     lastAlarm = (ExecAlarm)((int)alarmVoid);
+    Metrics::alarm(lastAlarm);
+    FlightRecorder::alarm(lastAlarm);
     if (spindle->_off_on_alarm) {
         spindle->stop();
     }
@@ -485,23 +673,36 @@ static void protocol_do_alarm(void* alarmVoid) {
     alarm_msg(lastAlarm);
 }
 
+// A hold may already have been started by a control pin, from the prep task
 static void protocol_start_holding() {
-    if (!(sys.suspend.bit.motionCancel || sys.suspend.bit.jogCancel)) {  // Block, if already holding.
+    Stepper::PrepLock lock;
+    if (!(sys.suspend.bit.motionCancel || sys.suspend.bit.jogCancel || sys.step_control.executeHold)) {  // Block, if already holding.
         sys.step_control = {};
+        Stepper::truncate_segments();  // Start decelerating now, not after the queued segments
         Stepper::update_plan_block_parameters();
         sys.step_control.executeHold = true;  // Initiate suspend state with active flag.
     }
 }
 
 static void protocol_cancel_jogging() {
+    Stepper::PrepLock lock;
     if (!(sys.suspend.bit.motionCancel || sys.suspend.bit.jogCancel)) {  // Block, if already holding.
         sys.step_control = {};
+        Stepper::truncate_segments();
         Stepper::update_plan_block_parameters();
         sys.step_control.executeHold = true;  // Initiate suspend state with active flag.
         sys.suspend.bit.jogCancel    = true;
     }
 }
 
+void protocol_start_hold_early() {
+    if (state_is(State::Cycle)) {
+        protocol_start_holding();
+    } else if (state_is(State::Jog)) {
+        protocol_cancel_jogging();
+    }
+}
+
 static void protocol_hold_complete() {
     sys.suspend.value            = 0;
     sys.suspend.bit.holdComplete = true;
@@ -606,6 +807,7 @@ static void protocol_do_safety_door() {
             if (!sys.suspend.bit.jogCancel && sys.suspend.bit.initiateRestore) {  // Actively restoring
                 // Set hold and reset appropriate control flags to restart parking sequence.
                 if (sys.step_control.executeSysMotion) {
+                    Stepper::PrepLock lock;
                     Stepper::update_plan_block_parameters();  // Notify stepper module to recompute for hold deceleration.
                     sys.step_control                  = {};
                     sys.step_control.executeHold      = true;
@@ -783,7 +985,8 @@ void protocol_do_cycle_stop() {
             if (!soft_limit && !sys.suspend.bit.jogCancel) {
                 // Hold complete. Set to indicate ready to resume.  Remain in HOLD or DOOR states until user
                 // has issued a resume command or reset.
-                plan_cycle_reinitialize();
+                Stepper::PrepLock lock;
+                plan_hold_complete();
                 if (sys.step_control.executeHold) {
                     sys.suspend.bit.holdComplete = true;
                 }
@@ -802,6 +1005,7 @@ void protocol_do_cycle_stop() {
             // Motion complete. Includes CYCLE/JOG/HOMING states and jog cancel/motion cancel/soft limit events.
             // NOTE: Motion and jog cancel both immediately return to idle after the hold completes.
             if (sys.suspend.bit.jogCancel) {  // For jog cancel, flush buffers and sync positions.
+                Stepper::PrepLock lock;
                 sys.step_control = {};
                 plan_reset();
                 Stepper::reset();
@@ -815,6 +1019,8 @@ void protocol_do_cycle_stop() {
             } else {
                 sys.suspend.value = 0;
                 set_state(State::Idle);
+                config->_coolant->apply_queued();  // An M9 after the last motion of a stream
+                spindle->apply_queued();           // Likewise an S change
             }
             break;
         case State::Homing:
@@ -988,18 +1194,12 @@ static void protocol_exec_rt_suspend() {
     }
 }
 
-static void protocol_do_feed_override(void* incrementvp) {
-    int increment = int(incrementvp);
-    int percent;
-    if (increment == FeedOverride::Default) {
-        percent = FeedOverride::Default;
-    } else {
-        percent = sys.f_override + increment;
-        if (percent > FeedOverride::Max) {
-            percent = FeedOverride::Max;
-        } else if (percent < FeedOverride::Min) {
-            percent = FeedOverride::Min;
-        }
+static void protocol_do_feed_override(bool toDefault, int increment) {
+    int percent = (toDefault ? FeedOverride::Default : sys.f_override) + increment;
+    if (percent > FeedOverride::Max) {
+        percent = FeedOverride::Max;
+    } else if (percent < FeedOverride::Min) {
+        percent = FeedOverride::Min;
     }
     if (percent != sys.f_override) {
         sys.f_override = percent;
@@ -1008,8 +1208,20 @@ static void protocol_do_feed_override(void* incrementvp) {
     }
 }
 
-static void protocol_do_rapid_override(void* percentvp) {
-    int percent = int(percentvp);
+static void protocol_do_load_override(bool toDefault, int percent) {
+    if (toDefault) {
+        percent = FeedOverride::Default;
+    }
+    if (percent != sys.load_override) {
+        sys.load_override = percent;
+        plan_update_velocity_profile_parameters();  // Not reported, so no update_velocities()
+    }
+}
+
+static void protocol_do_rapid_override(bool toDefault, int percent) {
+    if (toDefault) {
+        percent = RapidOverride::Default;
+    }
     if (percent != sys.r_override) {
         sys.r_override = percent;
         update_velocities();
@@ -1017,18 +1229,12 @@ static void protocol_do_rapid_override(void* percentvp) {
     }
 }
 
-static void protocol_do_spindle_override(void* incrementvp) {
-    int percent;
-    int increment = int(incrementvp);
-    if (increment == SpindleSpeedOverride::Default) {
-        percent = SpindleSpeedOverride::Default;
-    } else {
-        percent = sys.spindle_speed_ovr + increment;
-        if (percent > SpindleSpeedOverride::Max) {
-            percent = SpindleSpeedOverride::Max;
-        } else if (percent < SpindleSpeedOverride::Min) {
-            percent = SpindleSpeedOverride::Min;
-        }
+static void protocol_do_spindle_override(bool toDefault, int increment) {
+    int percent = (toDefault ? SpindleSpeedOverride::Default : sys.spindle_speed_ovr) + increment;
+    if (percent > SpindleSpeedOverride::Max) {
+        percent = SpindleSpeedOverride::Max;
+    } else if (percent < SpindleSpeedOverride::Min) {
+        percent = SpindleSpeedOverride::Min;
     }
     if (percent != sys.spindle_speed_ovr) {
         sys.spindle_speed_ovr               = percent;
@@ -1058,8 +1264,8 @@ static void protocol_do_accessory_override(void* type) {
             }
             break;
         case AccessoryOverride::FloodToggle:
-            // NOTE: Since coolant state always performs a planner sync whenever it changes, the current
-            // run state can be determined by checking the parser state.
+            // NOTE: The toggle is applied to the parser state, so a coolant change queued with the
+            // motion still happens when its block starts.
             if (config->_coolant->hasFlood() && (state_is(State::Idle) || state_is(State::Cycle) || state_is(State::Hold))) {
                 gc_state.modal.coolant.Flood = !gc_state.modal.coolant.Flood;
                 config->_coolant->set_state(gc_state.modal.coolant);
@@ -1116,52 +1322,104 @@ void protocol_do_rt_reset() {
     protocol_send_event(&restartEvent);
 }
 
-const ArgEvent feedOverrideEvent { protocol_do_feed_override };
-const ArgEvent rapidOverrideEvent { protocol_do_rapid_override };
-const ArgEvent spindleOverrideEvent { protocol_do_spindle_override };
+const OverrideEvent feedOverrideEvent { protocol_do_feed_override, FeedOverride::Default };
+const OverrideEvent rapidOverrideEvent { protocol_do_rapid_override, RapidOverride::Default, true };
+const OverrideEvent loadOverrideEvent { protocol_do_load_override, FeedOverride::Default, true };
+const OverrideEvent spindleOverrideEvent { protocol_do_spindle_override, SpindleSpeedOverride::Default };
 const ArgEvent accessoryOverrideEvent { protocol_do_accessory_override };
-const ArgEvent limitEvent { protocol_do_limit };
-const ArgEvent faultPinEvent { protocol_do_fault_pin };
+const ArgEvent limitEvent { protocol_do_limit, Event::Motion };
+const ArgEvent faultPinEvent { protocol_do_fault_pin, Event::Motion };
 const ArgEvent reportStatusEvent { (void (*)(void*))report_realtime_status };
 
-const NoArgEvent safetyDoorEvent { request_safety_door };
-const NoArgEvent feedHoldEvent { protocol_do_feedhold };
-const NoArgEvent cycleStartEvent { protocol_do_cycle_start };
-const NoArgEvent cycleStopEvent { protocol_do_cycle_stop };
-const NoArgEvent motionCancelEvent { protocol_do_motion_cancel };
+const NoArgEvent safetyDoorEvent { request_safety_door, Event::Motion };
+const NoArgEvent feedHoldEvent { protocol_do_feedhold, Event::Motion };
+const NoArgEvent cycleStartEvent { protocol_do_cycle_start, Event::Motion };
+const NoArgEvent cycleStopEvent { protocol_do_cycle_stop, Event::Motion };
+const NoArgEvent motionCancelEvent { protocol_do_motion_cancel, Event::Motion };
 const NoArgEvent sleepEvent { protocol_do_sleep };
 const NoArgEvent debugEvent { report_realtime_debug };
 const NoArgEvent startEvent { protocol_do_start };
 const NoArgEvent restartEvent { protocol_do_soft_restart };
-const NoArgEvent fullResetEvent { restart };
+static void protocol_do_full_reset() {
+    flush_coordinates();
+    restart();
+}
+
+const NoArgEvent fullResetEvent { protocol_do_full_reset };
 const NoArgEvent runStartupLinesEvent { protocol_run_startup_lines };
 
-const NoArgEvent rtResetEvent { protocol_do_rt_reset };
+const NoArgEvent rtResetEvent { protocol_do_rt_reset, Event::Motion };
 
 // The problem is that report_realtime_status needs a channel argument
 // Event statusReportEvent { protocol_do_status_report(XXX) };
-const ArgEvent alarmEvent { (void (*)(void*))protocol_do_alarm };
+const ArgEvent alarmEvent { (void (*)(void*))protocol_do_alarm, Event::Motion };
 
 xQueueHandle event_queue;
+xQueueHandle motion_event_queue;
+
+// Events that did not fit in their queue, by lane.  For the Override lane,
+// the count is of changes folded into one that was already pending.
+static std::atomic<uint32_t> event_overflows[Event::N_LANES];
 
 void protocol_init() {
-    event_queue   = xQueueCreate(10, sizeof(EventItem));
-    message_queue = xQueueCreate(10, sizeof(LogMessage));
+    event_queue        = xQueueCreate(10, sizeof(EventItem));
+    motion_event_queue = xQueueCreate(16, sizeof(EventItem));
+    log_init();
 }
 
+// Override events must not be sent from an ISR, because merging them takes a mutex
 void IRAM_ATTR protocol_send_event_from_ISR(const Event* evt, void* arg) {
     EventItem item { evt, arg };
-    xQueueSendFromISR(event_queue, &item, NULL);
+    if (!xQueueSendFromISR(evt->lane() == Event::Motion ? motion_event_queue : event_queue, &item, NULL)) {
+        ++event_overflows[evt->lane()];
+    }
+    protocol_wake_main_from_ISR();
 }
 void protocol_send_event(const Event* evt, void* arg) {
-    EventItem item { evt, arg };
-    xQueueSend(event_queue, &item, 0);
+    if (evt->lane() == Event::Override) {
+        if (static_cast<const OverrideEvent*>(evt)->merge(int(arg))) {
+            ++event_overflows[Event::Override];
+        }
+    } else {
+        EventItem item { evt, arg };
+        if (!xQueueSend(evt->lane() == Event::Motion ? motion_event_queue : event_queue, &item, 0)) {
+            ++event_overflows[evt->lane()];
+        }
+    }
+    protocol_wake_main();
+}
+// Each velocity override replans the whole planner buffer, but the stepper
+// only picks up a new speed once per segment, so while moving, changes are
+// applied at most once per segment time and the ones in between are merged.
+// Spindle changes do not replan, so they are applied right away.
+static void protocol_apply_overrides() {
+    static TickType_t lastApplied = 0;
+
+    spindleOverrideEvent.run(nullptr);
+
+    if (!feedOverrideEvent.pending() && !rapidOverrideEvent.pending() && !loadOverrideEvent.pending()) {
+        return;
+    }
+    TickType_t now = xTaskGetTickCount();
+    if (inMotionState() && (now - lastApplied) < pdMS_TO_TICKS(1000 / Stepping::_accelerationTicks)) {
+        return;  // The main loop comes back within idleWaitTicks
+    }
+    lastApplied = now;
+    feedOverrideEvent.run(nullptr);
+    rapidOverrideEvent.run(nullptr);
+    loadOverrideEvent.run(nullptr);
 }
+
 void protocol_handle_events() {
     EventItem item;
-    while (xQueueReceive(event_queue, &item, 0)) {
+    // Motion events go first, even when other events were sent before them
+    while (xQueueReceive(motion_event_queue, &item, 0) || xQueueReceive(event_queue, &item, 0)) {
         item.event->run(item.arg);
     }
+    protocol_apply_overrides();
+}
+uint32_t protocol_event_overflows(Event::Lane lane) {
+    return event_overflows[lane];
 }
 void send_alarm(ExecAlarm alarm) {
     protocol_send_event(&alarmEvent, (void*)alarm);
@@ -46,6 +46,11 @@ void protocol_cancel_disable_steppers();
 
 void protocol_do_motion_cancel();
 
+// Starts the deceleration of a feed hold or jog cancel without changing the state,
+// for a control pin whose event the main loop has yet to handle.  Called from the
+// segment prep task.
+void protocol_start_hold_early();
+
 extern volatile bool rtCycleStop;
 
 extern volatile bool runLimitLoop;
@@ -68,6 +73,7 @@ enum class ExecAlarm : uint8_t {
     HardStop              = 13,
     Unhomed               = 14,
     Init                  = 15,
+    StepLoss              = 16,
 };
 
 extern volatile ExecAlarm lastAlarm;
@@ -84,9 +90,10 @@ enum AccessoryOverride {
     MistToggle     = 3,
 };
 
-extern const ArgEvent feedOverrideEvent;
-extern const ArgEvent rapidOverrideEvent;
-extern const ArgEvent spindleOverrideEvent;
+extern const OverrideEvent feedOverrideEvent;
+extern const OverrideEvent rapidOverrideEvent;
+extern const OverrideEvent loadOverrideEvent;
+extern const OverrideEvent spindleOverrideEvent;
 extern const ArgEvent accessoryOverrideEvent;
 extern const ArgEvent limitEvent;
 extern const ArgEvent faultPinEvent;
@@ -111,6 +118,7 @@ extern const NoArgEvent runStartupLinesEvent;
 // extern const NoArgEvent statusReportEvent;
 
 extern xQueueHandle event_queue;
+extern xQueueHandle motion_event_queue;
 
 extern bool pollingPaused;
 
@@ -122,6 +130,9 @@ struct EventItem {
 void protocol_send_event(const Event*, void* arg = 0);
 void protocol_handle_events();
 
+// Events dropped because their queue was full; for Event::Override, changes merged
+uint32_t protocol_event_overflows(Event::Lane lane);
+
 void send_alarm(ExecAlarm alarm);
 void send_alarm_from_ISR(ExecAlarm alarm);
 
@@ -133,4 +144,11 @@ void protocol_send_event_from_ISR(const Event* evt, void* arg = 0);
 
 void drain_messages();
 
+// When there is nothing to do, polling_loop() and protocol_main_loop() sleep
+// until woken by one of these or by a short fallback tick.  Input sources that
+// can signal new data call protocol_wake_polling(); events wake the main loop.
+void protocol_wake_polling();
+void protocol_wake_main();
+void protocol_wake_main_from_ISR();
+
 extern uint32_t heapLowWater;
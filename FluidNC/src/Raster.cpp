@@ -0,0 +1,162 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Raster.h"
+
+#include "GCode.h"  // gc_state
+#include "Machine/MachineConfig.h"
+#include "MotionControl.h"  // mc_linear()
+#include "Protocol.h"       // protocol_execute_realtime()
+#include "System.h"         // sys, state_is()
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace Raster {
+    // Enough to keep the planner busy with short scanlines
+    static const size_t poolSize = 8;
+
+    static Scanline pool[poolSize];
+    static size_t   next = 0;
+
+    void reset() {
+        for (auto& scanline : pool) {
+            scanline.busy = false;
+        }
+        next = 0;
+    }
+
+    // Waits like mc_move_motors() does for a full planner
+    static Scanline* allocate() {
+        Scanline* scanline = &pool[next];
+        while (scanline->busy.load(std::memory_order_acquire)) {
+            protocol_auto_cycle_start();
+            protocol_execute_realtime();
+            if (sys.abort) {
+                return nullptr;
+            }
+        }
+        next = (next + 1) % poolSize;
+        return scanline;
+    }
+
+    static int hex_digit(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        c = tolower(c);
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    static Error parse_pixels(const char* hex, Scanline& scanline) {
+        size_t len = strlen(hex);
+        if (len == 0 || len % 2 || len / 2 > maxPixels) {
+            return Error::InvalidValue;
+        }
+        for (size_t i = 0; i < len / 2; ++i) {
+            int hi = hex_digit(hex[2 * i]);
+            int lo = hex_digit(hex[2 * i + 1]);
+            if (hi < 0 || lo < 0) {
+                return Error::BadNumberFormat;
+            }
+            scanline.pixels[i] = uint8_t(hi << 4 | lo);
+        }
+        scanline.count = len / 2;
+        return Error::Ok;
+    }
+
+    // $Raster/Line=X<distance> [Y<distance> ...] F<feed> P<hex pixels>
+    Error line(const char* value, Channel& out) {
+        if (!value) {
+            return Error::InvalidStatement;
+        }
+        // The same lock as for GCode lines
+        if (state_is(State::Alarm) || state_is(State::ConfigAlarm) || state_is(State::Jog)) {
+            return Error::SystemGcLock;
+        }
+        if (!config->_kinematics->single_block_lines()) {
+            log_error_to(out, "Raster lines need kinematics that plan a line as one block");
+            return Error::GcodeUnsupportedCommand;
+        }
+
+        auto n_axis = Axes::_numberAxis;
+        float scale = gc_state.modal.units == Units::Inches ? MM_PER_INCH : 1.0f;
+
+        float target[MAX_N_AXIS];
+        copyAxes(target, gc_state.position);
+        bool        moves  = false;
+        float       feed   = 0.0f;
+        const char* pixels = nullptr;
+
+        const char* p = value;
+        while (*p) {
+            if (*p == ' ') {
+                ++p;
+                continue;
+            }
+            char letter = toupper(*p++);
+            if (letter == 'P') {
+                pixels = p;
+                break;
+            }
+            char* end;
+            float number = strtof(p, &end);
+            if (end == p) {
+                return Error::BadNumberFormat;
+            }
+            p = end;
+            if (letter == 'F') {
+                feed = number * scale;
+                continue;
+            }
+            const char* axis = strchr(Machine::Axes::_names, letter);
+            if (!axis || size_t(axis - Machine::Axes::_names) >= n_axis) {
+                return Error::GcodeUnusedWords;
+            }
+            target[axis - Machine::Axes::_names] += number * scale;
+            moves = true;
+        }
+        if (!moves) {
+            return Error::GcodeNoAxisWords;
+        }
+        if (feed <= 0.0f) {
+            return Error::GcodeUndefinedFeedRate;
+        }
+        if (!pixels) {
+            return Error::GcodeValueWordMissing;
+        }
+
+        plan_line_data_t plan_data;
+        memset(&plan_data, 0, sizeof(plan_line_data_t));
+        plan_data.feed_rate     = feed;
+        plan_data.spindle_speed = gc_state.spindle_speed;
+        plan_data.spindle       = gc_state.modal.spindle;
+        plan_data.coolant       = gc_state.modal.coolant;
+        plan_data.line_number   = gc_state.line_number;
+
+        if (!state_is(State::CheckMode)) {
+            Scanline* scanline = allocate();
+            if (!scanline) {
+                return Error::Reset;
+            }
+            Error err = parse_pixels(pixels, *scanline);
+            if (err != Error::Ok) {
+                return err;
+            }
+            // plan_buffer_line() marks it busy if the block is planned
+            plan_data.raster = scanline;
+        }
+
+        mc_linear(target, &plan_data, gc_state.position);
+        if (sys.abort) {
+            return Error::Reset;
+        }
+        gc_state.feed_rate = feed;
+        copyAxes(gc_state.position, target);
+        return Error::Ok;
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Raster.h - laser raster scanlines
+
+  $Raster/Line=X<distance> F<feed> P<hex pixels> moves the given distance from the
+  current position as a single planner block and modulates the laser along it, one
+  pixel after another, from an array that travels with the block.  The stepper sets
+  the output for each pixel as the steps reach it, so an engraving runs as fast as
+  the motion allows instead of as fast as G1 S lines can be parsed.
+
+  Each pixel is 0..255, a fraction of the output that the spindle state and S word
+  would give at that point, so M4 still corrects for the velocity.  Consecutive
+  collinear scanlines join at full speed; overscan is up to the sender.
+*/
+
+#include "Error.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class Channel;
+
+namespace Raster {
+    // A whole scanline in one 256-byte command line, 2 hex digits per pixel
+    const size_t maxPixels = 112;
+
+    struct Scanline {
+        uint16_t          count;
+        uint8_t           pixels[maxPixels];
+        std::atomic<bool> busy;  // Held by a planner or stepper block
+    };
+
+    Error line(const char* value, Channel& out);
+
+    // The stepper is done with a scanline
+    inline void release(Scanline* scanline) { scanline->busy.store(false, std::memory_order_release); }
+
+    // Forgets all the scanlines, with the planner
+    void reset();
+}
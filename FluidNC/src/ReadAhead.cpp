@@ -0,0 +1,149 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "ReadAhead.h"
+#include "Memory.h"
+#include "Machine/Tasks.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+struct FillRequest {
+    ReadAhead* owner;
+    int        which;
+};
+
+// One task serves all open files, one buffer at a time
+static QueueHandle_t fill_queue = nullptr;
+
+void ReadAhead::fill_task(void* unused) {
+    while (true) {
+        FillRequest req;
+        if (xQueueReceive(fill_queue, &req, portMAX_DELAY)) {
+            req.owner->fill(req.which);
+        }
+    }
+}
+
+ReadAhead* ReadAhead::create(FILE* fd, size_t position, Stats& stats) {
+    if (!fill_queue) {
+        fill_queue = xQueueCreate(4, sizeof(FillRequest));
+        Machine::Tasks::create("readahead", fill_task, nullptr);
+    }
+    ReadAhead* ra = new ReadAhead(fd, stats);
+    for (auto& b : ra->_buffers) {
+        b.data = static_cast<uint8_t*>(Memory::alloc(bufferSize, Memory::Region::Bulk));
+        if (!b.data) {
+            delete ra;
+            return nullptr;
+        }
+    }
+    ra->restart(position);
+    return ra;
+}
+
+ReadAhead::~ReadAhead() {
+    drain();
+    for (auto& b : _buffers) {
+        Memory::free(b.data);
+    }
+}
+
+void ReadAhead::request(int which) {
+    _buffers[which].ready = false;
+    ++_inFlight;
+    FillRequest req { this, which };
+    xQueueSend(fill_queue, &req, portMAX_DELAY);
+}
+
+void ReadAhead::fill(int which) {
+    Buffer& b     = _buffers[which];
+    int64_t start = esp_timer_get_time();
+    b.start       = _fillPosition;
+    b.length      = fread(b.data, 1, bufferSize, _fd);
+    _fillPosition += b.length;
+    uint32_t us = uint32_t(esp_timer_get_time() - start);
+    if (us > _stats.maxFillUs) {
+        _stats.maxFillUs = us;
+    }
+    ++_stats.fills;
+    b.ready = true;
+    --_inFlight;
+}
+
+void ReadAhead::wait(int which) {
+    while (!_buffers[which].ready) {
+        vTaskDelay(1);
+    }
+}
+
+void ReadAhead::drain() {
+    while (_inFlight) {
+        vTaskDelay(1);
+    }
+}
+
+// Discards the buffers and starts filling them from position
+void ReadAhead::restart(size_t position) {
+    drain();
+    fseek(_fd, position, SEEK_SET);
+    _fillPosition = position;
+    request(0);
+    request(1);
+    _current = 0;
+    _index   = 0;
+    wait(0);
+}
+
+// Moves on to the other buffer when this one is used up, refilling this one
+bool ReadAhead::advance() {
+    Buffer& done = _buffers[_current];
+    if (done.length < bufferSize) {
+        return false;  // End of file
+    }
+    int next = _current ^ 1;
+    if (!_buffers[next].ready) {
+        int64_t start = esp_timer_get_time();
+        wait(next);
+        uint32_t us = uint32_t(esp_timer_get_time() - start);
+        ++_stats.stalls;
+        _stats.totalStallUs += us;
+        if (us > _stats.maxStallUs) {
+            _stats.maxStallUs = us;
+        }
+    }
+    request(_current);
+    _current = next;
+    _index   = 0;
+    return _buffers[_current].length > 0;
+}
+
+size_t ReadAhead::read(uint8_t* buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        Buffer& b = _buffers[_current];
+        if (_index == b.length && !advance()) {
+            break;
+        }
+        Buffer& cur = _buffers[_current];
+        size_t  n   = std::min(length - done, cur.length - _index);
+        memcpy(buffer + done, cur.data + _index, n);
+        _index += n;
+        done += n;
+    }
+    return done;
+}
+
+void ReadAhead::seek(size_t position) {
+    Buffer& b = _buffers[_current];
+    if (position >= b.start && position <= b.start + b.length) {
+        _index = position - b.start;
+        return;
+    }
+    restart(position);
+}
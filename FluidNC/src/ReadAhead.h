@@ -0,0 +1,81 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  ReadAhead.h - double-buffered file reading for jobs
+
+  A background task fills two large buffers from the file while the reader consumes
+  the other one, so the latency of an SD card transaction, which can be long when the
+  card does internal housekeeping, is hidden from the GCode parser.  The reader stalls
+  only when it catches up with the card; stalls are counted and timed so that a slow
+  card shows up before it starves the planner.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+class ReadAhead {
+public:
+    static const size_t bufferSize = 16384;
+
+    struct Stats {
+        uint32_t fills        = 0;
+        uint32_t maxFillUs    = 0;  // Longest fread() of one buffer
+        uint32_t stalls       = 0;  // Times the reader waited for the card
+        uint32_t maxStallUs   = 0;
+        uint64_t totalStallUs = 0;
+    };
+
+    // Returns nullptr if the buffers cannot be allocated, in which case the caller
+    // reads the file directly.  Reading starts at position.
+    static ReadAhead* create(FILE* fd, size_t position, Stats& stats);
+
+    ReadAhead(const ReadAhead&)            = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    ~ReadAhead();  // Waits for a fill in progress
+
+    int read() {
+        Buffer& b = _buffers[_current];
+        if (_index < b.length) {
+            return b.data[_index++];
+        }
+        return advance() ? _buffers[_current].data[_index++] : -1;
+    }
+    size_t read(uint8_t* buffer, size_t length);
+
+    size_t position() const { return _buffers[_current].start + _index; }
+    void   seek(size_t position);
+
+private:
+    struct Buffer {
+        uint8_t*          data   = nullptr;
+        size_t            start  = 0;  // File position of data[0]
+        size_t            length = 0;  // Valid bytes; less than bufferSize at end of file
+        std::atomic<bool> ready { false };  // Filled and owned by the reader
+    };
+
+    ReadAhead(FILE* fd, Stats& stats) : _fd(fd), _stats(stats) {}
+
+    FILE*  _fd;
+    Stats& _stats;
+    Buffer _buffers[2];
+    int    _current = 0;  // Buffer being read
+    size_t _index   = 0;  // Next byte in it
+
+    size_t           _fillPosition = 0;  // Where the next fill starts; changed by seek() only when idle
+    std::atomic<int> _inFlight { 0 };
+
+    void request(int which);
+    void fill(int which);  // Runs in the fill task
+    void wait(int which);
+    void drain();
+    void restart(size_t position);
+    bool advance();
+
+    static void fill_task(void* unused);
+};
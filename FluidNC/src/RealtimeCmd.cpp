@@ -13,7 +13,7 @@ void execute_realtime_command(Cmd command, Channel& channel) {
             protocol_send_event(&rtResetEvent);
             break;
         case Cmd::StatusReport:
-            report_realtime_status(channel);  // direct call instead of setting flag
+            channel.reportStatus();  // direct call instead of setting flag
             // protocol_send_event(&reportStatusEvent, int(&channel));
             break;
         case Cmd::CycleStart:
@@ -1,4 +1,4 @@
-// Simple regular expression matcher from Rob Pike per
+// Simple regular expression matcher, after the one from Rob Pike per
 // https://www.cs.princeton.edu/courses/archive/spr09/cos333/beautiful.html
 
 //    c    matches any literal character c
@@ -6,58 +6,95 @@
 //    $    matches the end of the input string
 //    *    matches zero or more occurrences of any character
 
-// The code therein has been reformatted into the style used in this
-// project while replacing ints used as flags by bools.  The regex
-// syntax was changed by omitting '.' and making '*' equivalent to
-// ".*".  This regular expression matcher is for matching setting
-// names, where arbitrary repetion of literal characters is
+// The regex syntax differs from Pike's by omitting '.' and making '*'
+// equivalent to ".*".  This regular expression matcher is for matching
+// setting names, where arbitrary repetion of literal characters is
 // unlikely.  Literal character repetition is most useful for
 // skipping whitespace, which does not occur in setting names.  The
 // "bare * wildcard" is similar to filename wildcarding in many shells
 // and CLIs.
 
-#include <ctype.h>
+// With only the bare wildcard, an expression is a list of literal runs
+// separated by *s, and a text matches if the runs occur in it in order.
+// Taking the leftmost place for each run is never worse than a later one,
+// so Regex finds them one after the other with no backtracking, instead
+// of trying every split of the text recursively as Pike's matcher does.
+// A ^ pins the first run to the beginning of the text and a $ the last
+// run to the end; when the first run is pinned, most names are rejected
+// by their first character.
 
-static bool matchHere(const char* regexp, const char* text, bool case_sensitive);
+#include "Regex.h"
 
-// matchStar - search for *regexp at beginning of text
-static bool matchStar(const char* regexp, const char* text, bool case_sensitive) {
-    do {
-        if (matchHere(regexp, text, case_sensitive)) {
-            return true;
-        }
-    } while (*text++ != '\0');
-    return false;
-}
+#include <ctype.h>
+#include <string.h>
 
-// matchHere - search for regex at beginning of text
-static bool matchHere(const char* regexp, const char* text, bool case_sensitive) {
-    if (regexp[0] == '\0') {
-        return true;
+Regex::Regex(const char* regexp, bool case_sensitive) : _case_sensitive(case_sensitive) {
+    _anchor_start = regexp[0] == '^';
+    if (_anchor_start) {
+        ++regexp;
     }
-    if (regexp[0] == '*') {
-        return matchStar(regexp + 1, text, case_sensitive);
+    size_t len  = strlen(regexp);
+    _anchor_end = len && regexp[len - 1] == '$';
+    if (_anchor_end) {
+        --len;
     }
-    if (regexp[0] == '$' && regexp[1] == '\0') {
-        return *text == '\0';
+    for (size_t i = 0; i < len; ++i) {
+        if (regexp[i] == '*') {
+            _ends.push_back(_literals.length());
+        } else {
+            _literals += case_sensitive ? regexp[i] : char(tolower(regexp[i]));
+        }
     }
-    if (*text != '\0' && (case_sensitive ? regexp[0] == *text : tolower(regexp[0]) == tolower(*text))) {
-        return matchHere(++regexp, ++text, case_sensitive);
+    _ends.push_back(_literals.length());
+}
+
+// True if the run of _literals from begin to end is at the start of text
+bool Regex::matchAt(const char* text, size_t begin, size_t end) const {
+    for (size_t i = begin; i < end; ++i, ++text) {
+        if (*text == '\0' || (_case_sensitive ? *text : char(tolower(*text))) != _literals[i]) {
+            return false;
+        }
     }
-    return false;
+    return true;
+}
+
+bool Regex::match(const char* text) const {
+    const char* text_end = _anchor_end ? text + strlen(text) : nullptr;
+    size_t      begin    = 0;
+    for (size_t run = 0; run < _ends.size(); ++run) {
+        size_t end = _ends[run];
+        size_t n   = end - begin;
+        if (run == _ends.size() - 1 && _anchor_end) {
+            // The last run must end the text, after the earlier runs
+            if (size_t(text_end - text) < n || (run == 0 && _anchor_start && size_t(text_end - text) != n)) {
+                return false;
+            }
+            return matchAt(text_end - n, begin, end);
+        }
+        if (run == 0 && _anchor_start) {
+            if (!matchAt(text, begin, end)) {
+                return false;
+            }
+        } else if (n) {
+            // The leftmost place for the run, looking for its first character before comparing the rest
+            char first = _literals[begin];
+            for (;; ++text) {
+                if (*text == '\0') {
+                    return false;
+                }
+                if ((_case_sensitive ? *text : char(tolower(*text))) == first && matchAt(text, begin, end)) {
+                    break;
+                }
+            }
+        }
+        text += n;
+        begin = end;
+    }
+    return true;
 }
 
-// match - search for regular expression anywhere in text
 // Returns true if text contains the regular expression regexp
 // cppcheck-suppress unusedFunction
 bool regexMatch(const char* regexp, const char* text, bool case_sensitive) {
-    if (regexp[0] == '^') {
-        return matchHere(++regexp, text, case_sensitive);
-    }
-    do {
-        if (matchHere(regexp, text, case_sensitive)) {
-            return true;
-        }
-    } while (*text++ != '\0');
-    return false;
+    return Regex(regexp, case_sensitive).match(text);
 }
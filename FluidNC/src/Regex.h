@@ -1,5 +1,28 @@
 // Simple regular expression matcher.
 // See Regex.cpp for attribution, description and discussion
 
+#pragma once
+
+#include <string>
+#include <vector>
+
 // Returns true if text contains the regular expression regexp
 bool regexMatch(const char* regexp, const char* text, bool case_sensitive = true);
+
+// The same expressions, taken apart once so that many texts can be matched
+// against one without interpreting it again for each
+class Regex {
+    std::string         _literals;  // The literal runs between the *s, case-folded if not case sensitive
+    std::vector<size_t> _ends;      // End of each run in _literals
+    bool                _anchor_start;
+    bool                _anchor_end;
+    bool                _case_sensitive;
+
+    bool matchAt(const char* text, size_t begin, size_t end) const;
+
+public:
+    explicit Regex(const char* regexp, bool case_sensitive = true);
+
+    // Returns true if text contains the expression
+    bool match(const char* text) const;
+};
@@ -27,17 +27,21 @@
 #include "Planner.h"                     // plan_get_block_buffer_available
 #include "Stepper.h"                     // step_count
 #include "Platform.h"                    // WEAK_LINK
+#include "HeapStats.h"                   // HeapScope
 #include "WebUI/NotificationsService.h"  // WebUI::notificationsService
 #include "InputFile.h"
 #include "Job.h"
+#include "AxisCount.h"
+#include "FixedFormat.h"
+#include "EnumTable.h"
+#include "xmodem.h"  // crc16_ccitt
 
-#include <map>
 #include <freertos/task.h>
 #include <cstring>
+#include <algorithm>
 #include <cstdio>
 #include <cstdarg>
-#include <sstream>
-#include <iomanip>
+#include <cmath>
 
 #ifdef DEBUG_REPORT_HEAP
 EspClass esp;
@@ -76,39 +80,41 @@ void notifyf(const char* title, const char* format, ...) {
 Counter report_ovr_counter = 0;
 Counter report_wco_counter = 0;
 
-static const int coordStringLen = 20;
-static const int axesStringLen  = coordStringLen * MAX_N_AXIS;
-
-// Sends the axis values to the output channel
-static std::string report_util_axis_values(const float* axis_value) {
-    std::ostringstream msg;
-    auto               n_axis = Axes::_numberAxis;
-    for (size_t idx = 0; idx < n_axis; idx++) {
-        int   decimals;
-        float value = axis_value[idx];
-        if (idx >= A_AXIS && idx <= C_AXIS) {
-            // Rotary axes are in degrees so mm vs inch is not
-            // relevant.  Three decimal places is probably overkill
-            // for rotary axes but we use 3 in case somebody wants
-            // to use ABC as linear axes in mm.
-            decimals = 3;
-        } else {
-            if (config->_reportInches) {
-                value /= MM_PER_INCH;
-                decimals = 4;  // Report inches to 4 decimal places
+static const int axesStringLen = fixedStringLen * MAX_N_AXIS;
+
+// Writes the axis values, separated by commas, into buf, which has room for axesStringLen
+static const char* report_util_axis_values(const float* axis_value, char* buf) {
+    char* p = buf;
+    // With the axis count constant, the rotary test below is resolved for each axis at compile time
+    with_axis_count<MAX_N_AXIS>(Axes::_numberAxis, [&](auto n_axis) {
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            int   decimals;
+            float value = axis_value[idx];
+            if (idx >= A_AXIS && idx <= C_AXIS) {
+                // Rotary axes are in degrees so mm vs inch is not
+                // relevant.  Three decimal places is probably overkill
+                // for rotary axes but we use 3 in case somebody wants
+                // to use ABC as linear axes in mm.
+                decimals = 3;
             } else {
-                decimals = 3;  // Report mm to 3 decimal places
+                if (config->_reportInches) {
+                    value /= MM_PER_INCH;
+                    decimals = 4;  // Report inches to 4 decimal places
+                } else {
+                    decimals = 3;  // Report mm to 3 decimal places
+                }
+            }
+            p += format_fixed(p, value, decimals);
+            if (idx < (n_axis - 1)) {
+                *p++ = ',';
             }
         }
-        msg << std::fixed << std::setprecision(decimals) << value;
-        if (idx < (n_axis - 1)) {
-            msg << ",";
-        }
-    }
-    return msg.str();
+    });
+    *p = '\0';
+    return buf;
 }
 
-std::map<Message, const char*> MessageText = {
+static constexpr EnumText<Message> messageList[] = {
     { Message::CriticalEvent, "Reset to continue" },
     { Message::AlarmLock, "'$H'|'$X' to unlock" },
     { Message::AlarmUnlock, "Caution: Unlocked" },
@@ -125,6 +131,7 @@ std::map<Message, const char*> MessageText = {
     // Handled separately due to numeric argument
     // { Message::FileQuit, "Reset during file job at line: %d" },
 };
+static constexpr auto MessageText = enum_table<size_t(Message::FileQuit) + 1>(messageList);
 
 // Prints feedback messages. This serves as a centralized method to provide additional
 // user feedback for things that are not of the status/alarm message protocol. These are
@@ -132,15 +139,13 @@ std::map<Message, const char*> MessageText = {
 // NOTE: For interfaces, messages are always placed within brackets. And if silent mode
 // is installed, the message number codes are less than zero.
 void report_feedback_message(Message message) {  // ok to send to all channels
-    auto it = MessageText.find(message);
-    if (it != MessageText.end()) {
-        log_info(it->second);
+    if (auto text = enum_text(MessageText, message)) {
+        log_info(text);
     }
 }
 void report_error_message(Message message) {  // ok to send to all channels
-    auto it = MessageText.find(message);
-    if (it != MessageText.end()) {
-        log_error(it->second);
+    if (auto text = enum_text(MessageText, message)) {
+        log_error(text);
     }
 }
 
@@ -198,16 +203,40 @@ void report_probe_parameters(Channel& channel) {
     // Report in terms of machine position.
     // get the machine position and put them into a string and append to the probe report
     float print_position[MAX_N_AXIS];
-    motor_steps_to_mpos(print_position, probe_steps);
+    probe_steps_to_mpos(print_position);
 
-    log_stream(channel, "[PRB:" << report_util_axis_values(print_position) << ":" << probe_succeeded);
+    char axes[axesStringLen];
+    log_stream(channel, "[PRB:" << report_util_axis_values(print_position, axes) << ":" << probe_succeeded);
 }
 
+// Formats into a reused string, so a snapshot field or a cached report costs no LogStream
+class FieldStream : public Print {
+    std::string& _s;
+
+public:
+    FieldStream(std::string& s) : _s(s) { _s.clear(); }
+    size_t write(uint8_t c) override {
+        _s += char(c);
+        return 1;
+    }
+};
+
 // Prints NGC parameters (coordinate offsets, probing)
 void report_g92(Channel& channel) {}
 void report_tlo(Channel& channel) {}
 
-void report_ngc_coord(CoordIndex coord, Channel& channel) {
+// The $# lines are kept as sent and reformatted only after gc_offsets_changed()
+// or a change of report units, so a sender that polls $# costs a copy per line.
+static std::string ngcLines[size_t(CoordIndex::End)];
+static bool        ngcValid[size_t(CoordIndex::End)] = {};
+static bool        ngcInches                         = false;
+
+void report_ngc_invalidate() {
+    std::fill_n(ngcValid, size_t(CoordIndex::End), false);
+}
+
+static void format_ngc_coord(CoordIndex coord, std::string& line) {
+    FieldStream msg(line);
     if (coord == CoordIndex::TLO) {  // Non-persistent tool length offset
         float tlo      = gc_state.tool_length_offset;
         int   decimals = 3;
@@ -215,19 +244,31 @@ void report_ngc_coord(CoordIndex coord, Channel& channel) {
             tlo *= INCH_PER_MM;
             decimals = 4;
         }
-        std::ostringstream msg;
-        msg << std::fixed << std::setprecision(decimals) << tlo;
-        log_stream(channel, "[TLO:" << msg.str());
+        char tlo_string[fixedStringLen];
+        format_fixed(tlo_string, tlo, decimals);
+        msg << "[TLO:" << tlo_string << "]";
         return;
     }
+    char axes[axesStringLen];
     if (coord == CoordIndex::G92) {  // Non-persistent G92 offset
-        log_stream(channel, "[G92:" << report_util_axis_values(gc_state.coord_offset));
+        msg << "[G92:" << report_util_axis_values(gc_state.coord_offset, axes) << "]";
         return;
     }
     // Persistent offsets G54 - G59, G28, and G30
-    std::string name(coords[coord]->getName());
-    name += ":";
-    log_stream(channel, "[" << name << report_util_axis_values(coords[coord]->get()));
+    msg << "[" << coords[coord]->getName() << ":" << report_util_axis_values(coords[coord]->get(), axes) << "]";
+}
+
+void report_ngc_coord(CoordIndex coord, Channel& channel) {
+    if (ngcInches != config->_reportInches) {
+        ngcInches = config->_reportInches;
+        report_ngc_invalidate();
+    }
+    size_t i = size_t(coord);
+    if (!ngcValid[i]) {
+        format_ngc_coord(coord, ngcLines[i]);
+        ngcValid[i] = true;
+    }
+    log_string(channel, std::string_view(ngcLines[i]));
 }
 void report_ngc_parameters(Channel& channel) {
     for (auto coord = CoordIndex::Begin; coord < CoordIndex::End; ++coord) {
@@ -235,9 +276,9 @@ void report_ngc_parameters(Channel& channel) {
     }
 }
 
-// Print current gcode parser mode state
-void report_gcode_modes(Channel& channel) {
-    std::ostringstream msg;
+static void format_gcode_modes(std::string& line) {
+    FieldStream msg(line);
+    msg << "[GC:";
     switch (gc_state.modal.motion) {
         case Motion::None:
             msg << "G80";
@@ -254,6 +295,18 @@ void report_gcode_modes(Channel& channel) {
         case Motion::CcwArc:
             msg << "G3";
             break;
+        case Motion::CubicSpline:
+            msg << "G5";
+            break;
+        case Motion::QuadSpline:
+            msg << "G5.1";
+            break;
+        case Motion::SpindleSync:
+            msg << "G33";
+            break;
+        case Motion::RigidTap:
+            msg << "G33.1";
+            break;
         case Motion::ProbeToward:
             msg << "G38.2";
             break;
@@ -266,6 +319,30 @@ void report_gcode_modes(Channel& channel) {
         case Motion::ProbeAwayNoError:
             msg << "G38.5";
             break;
+        case Motion::DrillChipBreak:
+            msg << "G73";
+            break;
+        case Motion::Drill:
+            msg << "G81";
+            break;
+        case Motion::DrillDwell:
+            msg << "G82";
+            break;
+        case Motion::DrillPeck:
+            msg << "G83";
+            break;
+        case Motion::Tap:
+            msg << "G84";
+            break;
+        case Motion::Bore:
+            msg << "G85";
+            break;
+        case Motion::BoreSpindleStop:
+            msg << "G86";
+            break;
+        case Motion::BoreDwell:
+            msg << "G89";
+            break;
     }
 
     msg << " G" << (gc_state.modal.coord_select + 54);
@@ -316,6 +393,22 @@ void report_gcode_modes(Channel& channel) {
             break;
     }
 
+    switch (gc_state.modal.retract_mode) {
+        case RetractMode::OldZ:
+            msg << " G98";
+            break;
+        case RetractMode::RPlane:
+            msg << " G99";
+            break;
+    }
+
+    if (gc_state.modal.scaling == Scaling::Enable) {
+        msg << " G51";
+    }
+    if (gc_state.modal.rotation == Rotation::Enable) {
+        msg << " G68";
+    }
+
     //report_util_gcode_modes_M();
     switch (gc_state.modal.program_flow) {
         case ProgramFlow::Running:
@@ -369,9 +462,43 @@ void report_gcode_modes(Channel& channel) {
 
     msg << " T" << gc_state.selected_tool;
     int digits = config->_reportInches ? 1 : 0;
-    msg << " F" << std::fixed << std::setprecision(digits) << gc_state.feed_rate;
-    msg << " S" << uint32_t(gc_state.spindle_speed);
-    log_stream(channel, "[GC:" << msg.str())
+    char feed[fixedStringLen];
+    format_fixed(feed, gc_state.feed_rate, digits);
+    msg << " F" << feed;
+    msg << " S" << uint32_t(gc_state.spindle_speed) << "]";
+}
+
+// The [GC:] line is rebuilt only when something that it shows has changed; the
+// key is compared as bytes, so it is zeroed before it is filled in.
+struct GCodeModesKey {
+    gc_modal_t modal;
+    uint32_t   tool;
+    float      feed_rate;
+    float      spindle_speed;
+    Override   override_ctrl;
+    bool       parking_control;
+    bool       inches;
+};
+
+// Print current gcode parser mode state
+void report_gcode_modes(Channel& channel) {
+    static std::string   line;
+    static GCodeModesKey last;
+
+    GCodeModesKey key;
+    memset(&key, 0, sizeof(key));
+    memcpy(&key.modal, &gc_state.modal, sizeof(key.modal));
+    key.tool            = gc_state.selected_tool;
+    key.feed_rate       = gc_state.feed_rate;
+    key.spindle_speed   = gc_state.spindle_speed;
+    key.override_ctrl   = sys.override_ctrl;
+    key.parking_control = config->_enableParkingOverrideControl;
+    key.inches          = config->_reportInches;
+    if (line.empty() || memcmp(&key, &last, sizeof(key))) {
+        format_gcode_modes(line);
+        memcpy(&last, &key, sizeof(key));
+    }
+    log_string(channel, std::string_view(line));
 }
 
 // Prints build info line
@@ -409,6 +536,7 @@ void report_build_info(const char* line, Channel& channel) {
     log_stream(channel, "[OPT:" << msg);
 
     log_msg_to(channel, "Machine: " << config->_name);
+    log_msg_to(channel, "Planner blocks: " << plan_get_block_buffer_size());
 
     for (auto const& module : Modules()) {
         module->build_info(channel);
@@ -501,128 +629,324 @@ void report_recompute_pin_string() {
 // Define this to do something if a debug request comes in over serial
 void report_realtime_debug() {}
 
-// Prints real-time data. This function grabs a real-time snapshot of the stepper subprogram
-// and the actual location of the CNC machine. Users may change the following function to their
-// specific needs, but the desired real-time data report must be as short as possible. This is
-// requires as it minimizes the computational overhead to keep running smoothly,
-// especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
-void report_realtime_status(Channel& channel) {
-    LogStream msg(channel, "<");
-    msg << state_name();
+void report_snapshot(StatusSnapshot& snapshot) {
+    snapshot.state = state_name();
 
     // Report position
-    float* print_position = get_mpos();
-    if (bits_are_true(status_mask->get(), RtStatus::Position)) {
-        msg << "|MPos:";
-    } else {
-        msg << "|WPos:";
-        mpos_to_wpos(print_position);
-    }
-    msg << report_util_axis_values(print_position).c_str();
-
-    // Returns planner and serial read buffer states.
-
-    if (bits_are_true(status_mask->get(), RtStatus::Buffer)) {
-        msg << "|Bf:" << plan_get_block_buffer_available() << "," << channel.rx_buffer_available();
-    }
-
-    if (config->_useLineNumbers) {
-        // Report current line number
-        plan_block_t* cur_block = plan_get_current_block();
-        if (cur_block != NULL) {
-            uint32_t ln = cur_block->line_number;
-            if (ln > 0) {
-                msg << "|Ln:" << ln;
+    {
+        FieldStream msg(snapshot.position);
+        float*      print_position = get_mpos();
+        if (bits_are_true(status_mask->get(), RtStatus::Position)) {
+            msg << "|MPos:";
+        } else {
+            msg << "|WPos:";
+            mpos_to_wpos(print_position);
+        }
+        char axes[axesStringLen];
+        msg << report_util_axis_values(print_position, axes);
+    }
+
+    snapshot.planner_available = plan_get_block_buffer_available();
+
+    {
+        FieldStream msg(snapshot.line);
+        if (config->_useLineNumbers) {
+            // Report current line number
+            plan_block_t* cur_block = plan_get_current_block();
+            if (cur_block != NULL) {
+                uint32_t ln = cur_block->line_number;
+                if (ln > 0) {
+                    msg << "|Ln:" << ln;
+                }
             }
         }
     }
 
-    // Report realtime feed speed
-    float rate = Stepper::get_realtime_rate();
-    if (config->_reportInches) {
-        rate /= MM_PER_INCH;
-    }
-    msg << "|FS:" << setprecision(0) << rate << "," << sys.spindle_speed;
-
-    if (report_pin_string.length()) {
-        msg << "|Pn:" << report_pin_string;
+    {
+        // Report realtime feed speed
+        FieldStream msg(snapshot.feed);
+        float       rate = Stepper::get_realtime_rate();
+        if (config->_reportInches) {
+            rate /= MM_PER_INCH;
+        }
+        msg << "|FS:" << setprecision(0) << rate << "," << sys.spindle_speed;
     }
 
-    if (report_wco_counter > 0) {
-        report_wco_counter--;
-    } else {
-        switch (sys.state) {
-            case State::Homing:
-            case State::Cycle:
-            case State::Hold:
-            case State::Jog:
-            case State::SafetyDoor:
-                report_wco_counter = (REPORT_WCO_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
-            default:
-                report_wco_counter = (REPORT_WCO_REFRESH_IDLE_COUNT - 1);
-                break;
-        }
-        if (report_ovr_counter == 0) {
-            report_ovr_counter = 1;  // Set override on next report.
+    {
+        FieldStream msg(snapshot.pins);
+        if (report_pin_string.length()) {
+            msg << "|Pn:" << report_pin_string;
         }
-        msg << "|WCO:" << report_util_axis_values(get_wco()).c_str();
     }
 
-    if (report_ovr_counter > 0) {
-        report_ovr_counter--;
-    } else {
-        switch (sys.state) {
-            case State::Homing:
-            case State::Cycle:
-            case State::Hold:
-            case State::Jog:
-            case State::SafetyDoor:
-                report_ovr_counter = (REPORT_OVR_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
-            default:
-                report_ovr_counter = (REPORT_OVR_REFRESH_IDLE_COUNT - 1);
-                break;
+    {
+        FieldStream msg(snapshot.wco);
+        if (report_wco_counter > 0) {
+            report_wco_counter--;
+        } else {
+            switch (sys.state) {
+                case State::Homing:
+                case State::Cycle:
+                case State::Hold:
+                case State::Jog:
+                case State::SafetyDoor:
+                    report_wco_counter = (REPORT_WCO_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
+                default:
+                    report_wco_counter = (REPORT_WCO_REFRESH_IDLE_COUNT - 1);
+                    break;
+            }
+            if (report_ovr_counter == 0) {
+                report_ovr_counter = 1;  // Set override on next report.
+            }
+            char axes[axesStringLen];
+            msg << "|WCO:" << report_util_axis_values(get_wco(), axes);
         }
+    }
 
-        msg << "|Ov:" << int(sys.f_override) << "," << int(sys.r_override) << "," << int(sys.spindle_speed_ovr);
-        SpindleState sp_state      = spindle->get_state();
-        CoolantState coolant_state = config->_coolant->get_state();
-        if (sp_state != SpindleState::Disable || coolant_state.Mist || coolant_state.Flood) {
-            msg << "|A:";
-            switch (sp_state) {
-                case SpindleState::Disable:
-                    break;
-                case SpindleState::Cw:
-                    msg << "S";
-                    break;
-                case SpindleState::Ccw:
-                    msg << "C";
-                    break;
-                case SpindleState::Unknown:
+    {
+        FieldStream msg(snapshot.overrides);
+        if (report_ovr_counter > 0) {
+            report_ovr_counter--;
+        } else {
+            switch (sys.state) {
+                case State::Homing:
+                case State::Cycle:
+                case State::Hold:
+                case State::Jog:
+                case State::SafetyDoor:
+                    report_ovr_counter = (REPORT_OVR_REFRESH_BUSY_COUNT - 1);  // Reset counter for slow refresh
+                default:
+                    report_ovr_counter = (REPORT_OVR_REFRESH_IDLE_COUNT - 1);
                     break;
             }
 
-            auto coolant = coolant_state;
-            if (coolant.Flood) {
-                msg << "F";
-            }
-            if (coolant.Mist) {
-                msg << "M";
+            msg << "|Ov:" << int(sys.f_override) << "," << int(sys.r_override) << "," << int(sys.spindle_speed_ovr);
+            SpindleState sp_state      = spindle->get_state();
+            CoolantState coolant_state = config->_coolant->get_state();
+            if (sp_state != SpindleState::Disable || coolant_state.Mist || coolant_state.Flood) {
+                msg << "|A:";
+                switch (sp_state) {
+                    case SpindleState::Disable:
+                        break;
+                    case SpindleState::Cw:
+                        msg << "S";
+                        break;
+                    case SpindleState::Ccw:
+                        msg << "C";
+                        break;
+                    case SpindleState::Unknown:
+                        break;
+                }
+
+                auto coolant = coolant_state;
+                if (coolant.Flood) {
+                    msg << "F";
+                }
+                if (coolant.Mist) {
+                    msg << "M";
+                }
             }
         }
     }
-    if (Job::active()) {
-        msg << "|" << Job::channel()->_progress;
-    }
+
+    {
+        FieldStream msg(snapshot.extra);
+        if (Job::active()) {
+            msg << "|" << Job::channel()->_progress;
+        }
 #ifdef DEBUG_STEPPER_ISR
-    msg << "|ISRs:" << Stepper::isr_count;
+        msg << "|ISRs:" << Stepper::isr_count;
 #endif
 #ifdef DEBUG_REPORT_HEAP
-    msg << "|Heap:" << xPortGetFreeHeapSize();
+        msg << "|Heap:" << xPortGetFreeHeapSize();
 #endif
+    }
+}
+
+void report_snapshot_to(const StatusSnapshot& snapshot, Channel& channel, StatusSnapshot* last, uint8_t fields) {
+    LogStream msg(channel, "<");
+    msg << snapshot.state;
+
+    // A field that is always reported is sent when it changes, and one that has
+    // gone away is sent empty so the receiver can clear it.
+    auto steady = [&](const std::string& now, std::string* before, const char* cleared) {
+        if (!before) {
+            msg << now;
+        } else if (now != *before) {
+            msg << (now.empty() ? cleared : now.c_str());
+            *before = now;
+        }
+    };
+    // A field that is only in some reports is sent when it differs from the last value sent.
+    auto periodic = [&](const std::string& now, std::string* before) {
+        if (now.empty()) {
+            return;
+        }
+        if (!before) {
+            msg << now;
+        } else if (now != *before) {
+            msg << now;
+            *before = now;
+        }
+    };
+
+    if (fields & ReportField::Position) {
+        steady(snapshot.position, last ? &last->position : nullptr, "");
+    }
+
+    // Returns planner and serial read buffer states.  The planner value counts free slots
+    // against the stepping/planner_blocks capacity, which is reported by $I.
+
+    // With LineCredits, the read buffer state is the number of lines of up to the maximum
+    // length that can be sent, for senders that count lines rather than characters.
+    if ((fields & ReportField::Buffer) && bits_are_true(status_mask->get(), RtStatus::Buffer)) {
+        int rx_available = channel.rx_buffer_available();
+        if (bits_are_true(status_mask->get(), RtStatus::LineCredits)) {
+            rx_available /= Channel::maxLine;
+        }
+        msg << "|Bf:" << snapshot.planner_available << "," << rx_available;
+    }
+
+    if (fields & ReportField::Line) {
+        steady(snapshot.line, last ? &last->line : nullptr, "");
+    }
+    if (fields & ReportField::Feed) {
+        steady(snapshot.feed, last ? &last->feed : nullptr, "");
+    }
+    if (fields & ReportField::Pins) {
+        steady(snapshot.pins, last ? &last->pins : nullptr, "|Pn:");
+    }
+    if (fields & ReportField::Wco) {
+        periodic(snapshot.wco, last ? &last->wco : nullptr);
+    }
+    if (fields & ReportField::Overrides) {
+        periodic(snapshot.overrides, last ? &last->overrides : nullptr);
+    }
+    if (fields & ReportField::Extra) {
+        msg << snapshot.extra;
+    }
     msg << ">";
     // The destructor sends the line when msg goes out of scope
 }
 
+// Appends little-endian fields to a binary status frame
+class BinaryFrame {
+    uint8_t _data[3 + 29 + 8 * MAX_N_AXIS + 2];  // Header, payload, CRC
+    size_t  _length = 3;
+
+public:
+    BinaryFrame() {
+        _data[0] = binaryStatusStart;
+        _data[1] = binaryStatusType;
+    }
+    void u8(uint8_t v) { _data[_length++] = v; }
+    void u16(uint16_t v) {
+        u8(uint8_t(v));
+        u8(uint8_t(v >> 8));
+    }
+    void u32(uint32_t v) {
+        u16(uint16_t(v));
+        u16(uint16_t(v >> 16));
+    }
+    void um(float mm) { u32(uint32_t(int32_t(lroundf(mm * 1000.0f)))); }
+
+    void send(Channel& channel) {
+        _data[2]     = uint8_t(_length - 3);
+        uint16_t crc = crc16_ccitt(_data + 1, _length - 1);
+        u16(crc);
+        channel.sendBytes(_data, _length);
+    }
+};
+
+void report_binary_status(Channel& channel) {
+    BinaryFrame frame;
+    auto        n_axis = Axes::_numberAxis;
+
+    const char* name  = state_name();
+    const char* colon = strchr(name, ':');
+    bool        wpos  = !bits_are_true(status_mask->get(), RtStatus::Position);
+
+    frame.u8(binaryStatusVersion);
+    frame.u8(uint8_t(sys.state));
+    frame.u8(colon ? uint8_t(colon[1] - '0') : 0xff);
+    frame.u8((wpos ? BinaryStatusFlag::WPos : 0) | (Job::active() ? BinaryStatusFlag::JobActive : 0));
+    frame.u8(uint8_t(n_axis));
+
+    float* position = get_mpos();
+    if (wpos) {
+        mpos_to_wpos(position);
+    }
+    float* wco = get_wco();
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        frame.um(position[axis]);
+    }
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        frame.um(wco[axis]);
+    }
+
+    frame.u32(uint32_t(lroundf(Stepper::get_realtime_rate())));
+    frame.u32(sys.spindle_speed);
+
+    int rx_available = channel.rx_buffer_available();
+    if (bits_are_true(status_mask->get(), RtStatus::LineCredits)) {
+        rx_available /= Channel::maxLine;
+    }
+    frame.u16(uint16_t(plan_get_block_buffer_available()));
+    frame.u16(uint16_t(rx_available));
+
+    plan_block_t* cur_block = plan_get_current_block();
+    frame.u32(cur_block ? cur_block->line_number : 0);
+
+    uint16_t  limits        = 0;
+    MotorMask lim_pin_state = limits_get_state();
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        if (bitnum_is_true(lim_pin_state, Machine::Axes::motor_bit(axis, 0)) ||
+            bitnum_is_true(lim_pin_state, Machine::Axes::motor_bit(axis, 1))) {
+            limits |= 1 << axis;
+        }
+    }
+    frame.u16(limits);
+    frame.u16(uint16_t((config->_control->report_bits() << 1) | (config->_probe->get_state() ? 1 : 0)));
+
+    frame.u8(sys.f_override);
+    frame.u8(sys.r_override);
+    frame.u8(sys.spindle_speed_ovr);
+
+    SpindleState sp_state    = spindle->get_state();
+    CoolantState coolant     = config->_coolant->get_state();
+    uint8_t      accessories = 0;
+    if (sp_state == SpindleState::Cw) {
+        accessories |= 1 << 0;
+    } else if (sp_state == SpindleState::Ccw) {
+        accessories |= 1 << 1;
+    }
+    if (coolant.Flood) {
+        accessories |= 1 << 2;
+    }
+    if (coolant.Mist) {
+        accessories |= 1 << 3;
+    }
+    frame.u8(accessories);
+
+    frame.send(channel);
+}
+
+// Prints real-time data. This function grabs a real-time snapshot of the stepper subprogram
+// and the actual location of the CNC machine. Users may change the following function to their
+// specific needs, but the desired real-time data report must be as short as possible. This is
+// requires as it minimizes the computational overhead to keep running smoothly,
+// especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
+void report_realtime_status(Channel& channel) {
+    if (channel.getReportBinary()) {
+        report_binary_status(channel);
+        return;
+    }
+    HeapScope      heapScope(HeapTag::Report);
+    StatusSnapshot snapshot;
+    report_snapshot(snapshot);
+    report_snapshot_to(snapshot, channel);
+}
+
 void hex_msg(uint8_t* buf, const char* prefix, int len) {
     char report[200];
     char temp[20];
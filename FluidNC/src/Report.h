@@ -17,8 +17,9 @@
 
 // Define status reporting boolean enable bit flags in status_report_mask
 enum RtStatus {
-    Position = bitnum_to_mask(0),
-    Buffer   = bitnum_to_mask(1),
+    Position    = bitnum_to_mask(0),
+    Buffer      = bitnum_to_mask(1),
+    LineCredits = bitnum_to_mask(2),  // Bf: counts how many lines of any length fit, not bytes
 };
 
 const char* errorString(Error errorNumber);
@@ -71,6 +72,9 @@ void report_ngc_coord(CoordIndex coord, Channel& channel);
 // Prints NGC parameters (coordinate offsets, probe)
 void report_ngc_parameters(Channel& channel);
 
+// Drops the cached $# lines; called by gc_offsets_changed()
+void report_ngc_invalidate();
+
 // Prints current g-code parser mode state
 void report_gcode_modes(Channel& channel);
 
@@ -98,3 +102,83 @@ extern bool readyNext;
 
 extern std::string report_pin_string;
 void               report_recompute_pin_string();
+
+// A realtime status report split into its fields.  Automatic reports format
+// one snapshot per tick and share it among the channels that are due, each of
+// which adds its own Bf: field and, for delta reports, leaves out fields that
+// have not changed since its previous report.
+struct StatusSnapshot {
+    const char* state = "";
+    std::string position;  // |MPos: or |WPos:
+    int         planner_available = 0;
+    std::string line;       // |Ln:, if any
+    std::string feed;       // |FS:
+    std::string pins;       // |Pn:, if any pins are active
+    std::string wco;        // |WCO:, in some reports
+    std::string overrides;  // |Ov: and |A:, in some reports
+    std::string extra;      // Job progress and debug fields
+};
+
+// The fields of a status report that a channel can subscribe to, as bits
+namespace ReportField {
+    enum : uint8_t {
+        Position  = 1 << 0,  // MPos: or WPos:
+        Buffer    = 1 << 1,  // Bf:, if enabled by $Report/Status
+        Line      = 1 << 2,  // Ln:
+        Feed      = 1 << 3,  // FS:
+        Pins      = 1 << 4,  // Pn:
+        Wco       = 1 << 5,  // WCO:
+        Overrides = 1 << 6,  // Ov: and A:
+        Extra     = 1 << 7,  // Job progress and debug fields
+        All       = 0xff,
+    };
+}
+
+void report_snapshot(StatusSnapshot& snapshot);
+
+// The status report for channels with $Report/Format=binary, in place of <...>.
+// Each report is one frame
+//
+//     0xA5  'S'  length  payload[length]  crc16
+//
+// 0xA5 never starts a text line, so a host can tell frames from the text that
+// still arrives between them.  The CRC is CRC-16/XMODEM of the type, length and
+// payload bytes.  All fields are little-endian:
+//
+//     u8  version            binaryStatusVersion
+//     u8  state              State enum value
+//     u8  substate           N of Hold:N or Door:N, 0xff if none
+//     u8  flags              BinaryStatusFlag bits
+//     u8  n_axis
+//     i32 position[n_axis]   um, MPos or WPos according to the WPos flag
+//     i32 wco[n_axis]        um
+//     u32 feed_rate          mm/min
+//     u32 spindle_speed
+//     u16 planner_available
+//     u16 rx_available       Bytes, or lines with LineCredits
+//     u32 line_number        0 if none
+//     u16 limits             Axes with an active limit switch, X is bit 0
+//     u16 pins               Probe is bit 0, then control pins D R H S 0 1 2 3 F E
+//     u8  feed_override, rapid_override, spindle_override
+//     u8  accessories        Spindle CW bit 0, CCW bit 1, flood bit 2, mist bit 3
+//
+// Values are sent as integers, so neither end formats or parses numbers.
+const uint8_t binaryStatusStart   = 0xA5;
+const uint8_t binaryStatusType    = 'S';
+const uint8_t binaryStatusVersion = 1;
+
+namespace BinaryStatusFlag {
+    enum : uint8_t {
+        WPos      = 1 << 0,  // The position is the work position
+        JobActive = 1 << 1,  // A file or macro job is running
+    };
+}
+
+void report_binary_status(Channel& channel);
+
+// With last, sends only the fields that differ from last and updates it.  Fields whose
+// ReportField bit is not in fields are left out.
+void report_snapshot_to(const StatusSnapshot& snapshot,
+                        Channel&              channel,
+                        StatusSnapshot*       last   = nullptr,
+                        uint8_t               fields = ReportField::All);
@@ -0,0 +1,99 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SCurve.h - jerk-limited speed ramps for the segment prep engine
+
+  A ramp takes the place of one linear acceleration or deceleration ramp of the trapezoid
+  that Stepper::prep_buffer() computes from the planner block.  It keeps the same end
+  speeds and the same duration, hence the same distance, so the planner's junction speeds
+  and the segment bookkeeping are unchanged.  Within that duration the acceleration is
+  raised from zero at the jerk limit, held, and lowered to zero again (the jerk, constant
+  acceleration and jerk phases of an S-curve), so the acceleration no longer steps at
+  the ends of the ramp.
+
+  Keeping the duration means the peak acceleration of the ramp is somewhat higher than the
+  block acceleration; the jerk phase is made as short as the jerk limit allows to keep that
+  increase small.  When even the longest jerk phase (half the ramp) cannot meet the jerk
+  limit, the ramp is a pure S with no constant acceleration phase.
+
+  Units are those of the prep engine: mm/min for speed, minutes for time, mm/min^3 for jerk.
+*/
+
+#include <cmath>
+
+struct SCurveRamp {
+    float _start_speed = 0.0f;  // Speed at the beginning of the ramp (mm/min)
+    float _end_speed   = 0.0f;  // Speed at the end of the ramp (mm/min)
+    float _duration    = 0.0f;  // Ramp time (min)
+    float _jerk_time   = 0.0f;  // Duration of each of the two jerk phases (min)
+    float _accel       = 0.0f;  // Signed acceleration of the constant acceleration phase (mm/min^2)
+    float _elapsed     = 0.0f;  // Time into the ramp (min)
+    bool  _active      = false;
+
+    // Sets up a ramp from start_speed to end_speed over distance mm.  A zero jerk leaves
+    // the ramp inactive, so the caller uses its linear ramp.
+    void begin(float start_speed, float end_speed, float distance, float jerk) {
+        _active = false;
+        float sum_speed = start_speed + end_speed;
+        if (jerk <= 0.0f || distance <= 0.0f || sum_speed <= 0.0f || start_speed == end_speed) {
+            return;
+        }
+        _start_speed = start_speed;
+        _end_speed   = end_speed;
+        _duration    = 2.0f * distance / sum_speed;
+        _elapsed     = 0.0f;
+
+        // The jerk is dv / ((T - tj) * tj). Find the shortest tj for which it is within
+        // the limit, or use T/2 if none.
+        float dv           = fabsf(end_speed - start_speed);
+        float discriminant = _duration * _duration - 4.0f * dv / jerk;
+        _jerk_time         = discriminant > 0.0f ? 0.5f * (_duration - sqrtf(discriminant)) : 0.5f * _duration;
+        _accel             = (end_speed - start_speed) / (_duration - _jerk_time);
+        _active            = true;
+    }
+
+    bool active() const { return _active; }
+
+    // Distance traveled from the beginning of the ramp at time t.
+    float position(float t) const {
+        float tail = _duration - _jerk_time;
+        if (t < _jerk_time) {
+            return t * (_start_speed + _accel * t * t / (6.0f * _jerk_time));
+        }
+        if (t < tail) {
+            return _start_speed * t + _accel * (0.5f * t * t - 0.5f * _jerk_time * t + _jerk_time * _jerk_time / 6.0f);
+        }
+        float u = _duration - t;
+        return 0.5f * (_start_speed + _end_speed) * _duration - u * (_end_speed - _accel * u * u / (6.0f * _jerk_time));
+    }
+
+    // Speed at the current time into the ramp.
+    float speed() const {
+        float t = _elapsed;
+        if (t < _jerk_time) {
+            return _start_speed + 0.5f * _accel * t * t / _jerk_time;
+        }
+        if (t < _duration - _jerk_time) {
+            return _start_speed + _accel * (t - 0.5f * _jerk_time);
+        }
+        float u = _duration - t;
+        return _end_speed - 0.5f * _accel * u * u / _jerk_time;
+    }
+
+    // Advances the ramp by dt and returns the distance traveled.  If the ramp ends within dt,
+    // dt is shortened to the time remaining and the ramp becomes inactive.
+    float advance(float& dt) {
+        float t = _elapsed + dt;
+        if (t >= _duration) {
+            t       = _duration;
+            dt      = _duration - _elapsed;
+            _active = false;
+        }
+        float mm = position(t) - position(_elapsed);
+        _elapsed = t;
+        return mm;
+    }
+};
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SSD1306_I2C.h"
+
+#include <cstring>
+
+static const size_t commandLen = 7;  // Control byte, COLUMNADDR and PAGEADDR with their arguments
+
+bool SSD1306_I2C::connect() {
+    const int pages = height() / 8;
+
+    _pending  = static_cast<uint8_t*>(malloc(displayBufferSize));
+    _sending  = static_cast<uint8_t*>(malloc(displayBufferSize));
+    _shown    = static_cast<uint8_t*>(malloc(displayBufferSize));
+    _commands = static_cast<uint8_t*>(malloc(pages * commandLen));
+    _pageData = static_cast<uint8_t*>(malloc(pages * (width() + 1)));
+    return _pending && _sending && _shown && _commands && _pageData;
+}
+
+void SSD1306_I2C::display(void) {
+    if (_error || !_pageData) {
+        return;
+    }
+    bool start;
+    {
+        std::lock_guard<std::mutex> lock(_frameMutex);
+        memcpy(_pending, buffer, displayBufferSize);
+        _newFrame = true;
+        start     = !_busy;
+        _busy     = true;
+    }
+    if (start) {
+        sendFrame();
+    }
+}
+
+void SSD1306_I2C::transferDone(void* arg, int result) {
+    static_cast<SSD1306_I2C*>(arg)->release(1, result >= 0);
+}
+
+// Counts off transactions of the frame, finishing it after the last
+void SSD1306_I2C::release(int count, bool ok) {
+    if (!ok) {
+        _failed = true;
+    }
+    if (_remaining.fetch_sub(count) == count) {
+        frameDone();
+    }
+}
+
+void SSD1306_I2C::sendFrame() {
+    {
+        std::lock_guard<std::mutex> lock(_frameMutex);
+        memcpy(_sending, _pending, displayBufferSize);
+        _newFrame = false;
+    }
+
+    const int x_offset = (128 - width()) / 2;
+    const int w        = width();
+    const int pages    = height() / 8;
+
+    // The transactions of the frame, built before any is queued, since the bus task may
+    // finish them while the rest are being queued
+    I2CTransaction transactions[2 * pages];
+    int            n = 0;
+    for (int page = 0; page < pages; page++) {
+        const uint8_t* row   = &_sending[page * w];
+        const uint8_t* shown = &_shown[page * w];
+
+        // Narrow the transfer to the changed columns of the page
+        int first = 0;
+        int last  = w - 1;
+        if (_shownValid) {
+            while (first < w && row[first] == shown[first]) {
+                ++first;
+            }
+            if (first == w) {
+                continue;
+            }
+            while (row[last] == shown[last]) {
+                --last;
+            }
+        }
+
+        uint8_t* command = &_commands[page * commandLen];
+        command[0]       = 0x00;  // control, a stream of commands
+        command[1]       = COLUMNADDR;
+        command[2]       = x_offset + first;
+        command[3]       = x_offset + last;
+        command[4]       = PAGEADDR;
+        command[5]       = page;
+        command[6]       = page;
+
+        size_t   len  = last - first + 1;
+        uint8_t* data = &_pageData[page * (w + 1)];
+        data[0]       = 0x40;  // control
+        memcpy(&data[1], &row[first], len);
+
+        transactions[n++] = { _address, command, commandLen, nullptr, 0, transferDone, this };
+        transactions[n++] = { _address, data, len + 1, nullptr, 0, transferDone, this };
+    }
+
+    // One more count than there are transactions, so the frame cannot finish until all are queued
+    _failed  = false;
+    _dropped = false;
+    _remaining.store(n + 1);
+    int unqueued = 0;
+    for (int i = 0; i < n; i++) {
+        if (_dropped || !_i2c->submit(transactions[i])) {
+            _dropped = true;
+            ++unqueued;
+        }
+    }
+    release(unqueued + 1, true);
+}
+
+void SSD1306_I2C::frameDone() {
+    if (_failed) {
+        log_error("OLED is not responding");
+        _error = true;
+    } else if (_dropped) {
+        _shownValid = false;  // Part of the frame was not sent, so send all of the next one
+    } else {
+        memcpy(_shown, _sending, displayBufferSize);
+        _shownValid = true;
+    }
+    bool next;
+    {
+        std::lock_guard<std::mutex> lock(_frameMutex);
+        next  = _newFrame && !_error;
+        _busy = next;
+    }
+    if (next) {
+        sendFrame();
+    }
+}
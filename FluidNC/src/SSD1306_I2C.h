@@ -1,12 +1,17 @@
-
 #pragma once
 
 #include <OLEDDisplay.h>
 #include "Machine/I2CBus.h"
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 using namespace Machine;
 
+// Frames go over the bus as transactions queued on it, so a slow I2C transfer never holds
+// up the polling task that draws them.  display() copies the frame buffer and returns.
+// Only the columns of each page that differ from what the panel already shows are sent;
+// if frames arrive faster than the bus can take them, the next one sent is the newest.
 class SSD1306_I2C : public OLEDDisplay {
 private:
     uint8_t _address;
@@ -14,92 +19,36 @@ private:
     int     _frequency;
     bool    _error = false;
 
+    std::mutex _frameMutex;
+    uint8_t*   _pending    = nullptr;  // Latest frame from display()
+    bool       _newFrame   = false;
+    bool       _busy       = false;    // A frame is on the bus
+    uint8_t*   _sending    = nullptr;  // Frame on the bus
+    uint8_t*   _shown      = nullptr;  // What the panel shows
+    bool       _shownValid = false;
+    uint8_t*   _commands   = nullptr;  // Addressing commands for each page
+    uint8_t*   _pageData   = nullptr;  // Control byte and row of each page
+
+    // Transactions of the frame on the bus not yet done
+    std::atomic<int> _remaining;
+    bool             _failed  = false;  // The panel did not answer
+    bool             _dropped = false;  // The bus queue was full
+
+    void        sendFrame();
+    void        release(int count, bool ok);
+    void        frameDone();
+    static void transferDone(void* arg, int result);
+
 public:
     SSD1306_I2C(uint8_t address, OLEDDISPLAY_GEOMETRY g, I2CBus* i2c, int frequency) :
         _address(address), _i2c(i2c), _frequency(frequency), _error(false) {
         setGeometry(g);
     }
 
-    bool connect() {
-#if 0
-        if (_frequency != -1) {
-            _i2c->frequency(_frequency);
-        }
-#endif
-        return true;
-    }
-
-    void display(void) {
-        if (_error) {
-            return;
-        }
-        const int x_offset = (128 - this->width()) / 2;
-#ifdef OLEDDISPLAY_DOUBLE_BUFFER
-        uint8_t minBoundY = UINT8_MAX;
-        uint8_t maxBoundY = 0;
-
-        uint8_t minBoundX = UINT8_MAX;
-        uint8_t maxBoundX = 0;
-        uint8_t x, y;
-
-        // Calculate the Y bounding box of changes
-        // and copy buffer[pos] to buffer_back[pos];
-        for (y = 0; y < (this->height() / 8); y++) {
-            for (x = 0; x < this->width(); x++) {
-                uint16_t pos = x + y * this->width();
-                if (buffer[pos] != buffer_back[pos]) {
-                    minBoundY = std::min(minBoundY, y);
-                    maxBoundY = std::max(maxBoundY, y);
-                    minBoundX = std::min(minBoundX, x);
-                    maxBoundX = std::max(maxBoundX, x);
-                }
-                buffer_back[pos] = buffer[pos];
-            }
-            yield();
-        }
-
-        // If the minBoundY wasn't updated
-        // we can savely assume that buffer_back[pos] == buffer[pos]
-        // holdes true for all values of pos
+    bool connect();
 
-        if (minBoundY == UINT8_MAX)
-            return;
-
-        sendCommand(COLUMNADDR);
-        sendCommand(x_offset + minBoundX);  // column start address (0 = reset)
-        sendCommand(x_offset + maxBoundX);  // column end address (127 = reset)
-
-        sendCommand(PAGEADDR);
-        sendCommand(minBoundY);  // page start address
-        sendCommand(maxBoundY);  // page end address
-
-        for (y = minBoundY; y <= maxBoundY; y++) {
-            uint8_t* start = &buffer[(minBoundX + y * this->width()) - 1];
-            uint8_t  save  = *start;
-
-            *start = 0x40;  // control
-            _i2c->write(_address, start, (maxBoundX - minBoundX) + 1 + 1);
-            *start = save;
-        }
-#else
-
-        sendCommand(COLUMNADDR);
-        sendCommand(x_offset);                        // column start address (0 = reset)
-        sendCommand(x_offset + (this->width() - 1));  // column end address (127 = reset)
-
-        sendCommand(PAGEADDR);
-        sendCommand(0x0);  // page start address (0 = reset)
-
-        if (geometry == GEOMETRY_128_64) {
-            sendCommand(0x7);
-        } else if (geometry == GEOMETRY_128_32) {
-            sendCommand(0x3);
-        }
-
-        buffer[-1] = 0x40;  // control
-        _i2c->write(_address, (char*)&buffer[-1], displayBufferSize + 1);
-#endif
-    }
+    // Queues the frame on the bus and returns without waiting for it
+    void display(void);
 
 private:
     int getBufferOffset(void) { return 0; }
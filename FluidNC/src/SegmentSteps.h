@@ -0,0 +1,114 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SegmentSteps.h - turns the distance and time of a prepped segment into steps and a step period
+
+  Stepper::prep_buffer() finds, for each segment, the distance left to the end of the block
+  in steps and the segment time.  The quantizer rounds the distance to whole steps, times
+  those steps over the fractional distance actually covered, and carries the time of the
+  partial step over to the next segment, so the step rate follows the planned profile
+  exactly without accumulating round-off.
+
+  Float is the way Grbl does it.  Fixed keeps the steps left and the carried time as
+  integers with 16 fractional bits, in steps and timer ticks, so the per-segment rounding,
+  carry and period are integer operations and do not lose precision with the length of the
+  block.  Each takes the same float inputs and gives the same step counts; the periods
+  agree to a tick.  Build with FIXED_POINT_SEGMENTS to use Fixed.
+
+  A segment is taken in three calls: steps() gives the whole steps of the segment,
+  period() the timer ticks per step, and commit() makes it the new starting point.  A
+  segment that is abandoned after steps(), as at the end of a feed hold, is not committed.
+*/
+
+#include <cmath>
+#include <cstdint>
+
+namespace SegmentSteps {
+    class Float {
+    public:
+        struct State {
+            float steps_remaining;  // Distance left in the block, in steps
+            float dt_remainder;     // Minutes of the partial step carried into the next segment
+        };
+        State state = {};
+
+        void begin(uint32_t step_event_count) { state = { float(step_event_count), 0.0f }; }
+
+        // step_dist_remaining is the distance left in the block at the end of the segment
+        uint32_t steps(float step_dist_remaining) {
+            _dist        = step_dist_remaining;
+            _n_remaining = ceilf(_dist);
+            _last_n      = ceilf(state.steps_remaining);
+            return uint32_t(_last_n - _n_remaining);
+        }
+
+        // dt is the segment time in minutes
+        uint32_t period(float dt, float ticks_per_minute) {
+            dt += state.dt_remainder;
+            _inv_rate = dt / (_last_n - _dist);
+            return uint32_t(ceilf(ticks_per_minute * _inv_rate));
+        }
+
+        void commit() { state = { _n_remaining, (_n_remaining - _dist) * _inv_rate }; }
+
+    private:
+        float _dist;
+        float _n_remaining;
+        float _last_n;
+        float _inv_rate;
+    };
+
+    class Fixed {
+    public:
+        static const int      fraction_bits = 16;
+        static const uint64_t one           = uint64_t(1) << fraction_bits;
+
+        struct State {
+            uint64_t steps_remaining;  // Distance left in the block, in steps << fraction_bits
+            uint64_t tick_remainder;   // Ticks of the partial step carried into the next segment, << fraction_bits
+        };
+        State state = {};
+
+        void begin(uint32_t step_event_count) { state = { uint64_t(step_event_count) << fraction_bits, 0 }; }
+
+        uint32_t steps(float step_dist_remaining) {
+            // Scaling by a power of two is exact, so rounding the conversion up makes the
+            // ceiling below the same as ceilf() of the float.
+            float scaled = step_dist_remaining * float(one);
+            _dist        = uint64_t(scaled);
+            if (float(_dist) < scaled) {
+                ++_dist;
+            }
+            _n_remaining = ceil_steps(_dist);
+            _last_n      = ceil_steps(state.steps_remaining);
+            return uint32_t((_last_n - _n_remaining) >> fraction_bits);
+        }
+
+        uint32_t period(float dt, float ticks_per_minute) {
+            _ticks       = uint64_t(dt * ticks_per_minute * float(one)) + state.tick_remainder;
+            _span        = _last_n > _dist ? _last_n - _dist : 1;
+            uint64_t per = (_ticks + _span - 1) / _span;
+            return uint32_t(per);
+        }
+
+        void commit() { state = { _n_remaining, (_n_remaining - _dist) * _ticks / _span }; }
+
+    private:
+        static uint64_t ceil_steps(uint64_t steps) { return (steps + one - 1) & ~(one - 1); }
+
+        uint64_t _dist;
+        uint64_t _n_remaining;
+        uint64_t _last_n;
+        uint64_t _ticks;
+        uint64_t _span;
+    };
+
+#ifdef FIXED_POINT_SEGMENTS
+    using Quantizer = Fixed;
+#else
+    using Quantizer = Float;
+#endif
+}
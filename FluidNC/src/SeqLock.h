@@ -0,0 +1,49 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SeqLock.h - one writer, many readers, no blocking
+
+  The writer makes the sequence number odd while it copies a new value in and even again
+  when it is done.  A reader copies the value out between two reads of the sequence number
+  and tries again if the number was odd or changed, so it never sees half of an update and
+  never holds up the writer.  T must be trivially copyable.  Only one task may write.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable");
+
+    std::atomic<uint32_t> _sequence { 0 };
+    T                     _value {};
+
+public:
+    void write(const T& value) {
+        uint32_t seq = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(static_cast<void*>(&_value), &value, sizeof(T));
+        _sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns the number of completed writes, so a reader can tell whether anything is new.
+    uint32_t read(T& value) const {
+        uint32_t before, after;
+        do {
+            before = _sequence.load(std::memory_order_acquire);
+            memcpy(static_cast<void*>(&value), &_value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return before / 2;
+    }
+
+    uint32_t writes() const { return _sequence.load(std::memory_order_acquire) / 2; }
+};
@@ -175,6 +175,14 @@ void AllChannels::print_msg(MsgLevel level, const char* msg) {
     _mutex_general.unlock();
 }
 
+void AllChannels::flush() {
+    _mutex_general.lock();
+    for (auto channel : _channelq) {
+        channel->flush();
+    }
+    _mutex_general.unlock();
+}
+
 Channel* AllChannels::find(const std::string& name) {
     _mutex_general.lock();
     for (auto channel : _channelq) {
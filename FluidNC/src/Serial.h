@@ -47,6 +47,7 @@ public:
 
     void print_msg(MsgLevel level, const char* msg) override;
 
+    void flush() override;
     void flushRx();
 
     void notifyOvr();
@@ -3,17 +3,73 @@
 #include "System.h"    // sys
 #include "Protocol.h"  // protocol_buffer_synchronize
 #include "Machine/MachineConfig.h"
+#include "NameIndex.h"
+#include "BootTiming.h"
 
 #include <map>
 #include <limits>
 #include <cstring>
 #include <vector>
+#include <unordered_set>
 #include <charconv>
 #include <nvs.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>  // xTaskGetTickCount
 
 std::vector<Setting*> Setting::List __attribute__((init_priority(101))) = {};
 std::vector<Command*> Command::List __attribute__((init_priority(102))) = {};
 
+static NameIndex<Command> commandIndex;
+static NameIndex<Setting> settingNameIndex;
+static NameIndex<Setting> settingGrblIndex;
+static size_t             indexedCommands = 0;
+static size_t             indexedSettings = 0;
+
+size_t Setting::buildIndexes() {
+    commandIndex.clear();
+    for (Command* cp : Command::List) {
+        commandIndex.add(cp->getName(), cp);
+        commandIndex.add(cp->getGrblName(), cp);
+    }
+    commandIndex.sort();
+
+    // Full names and compatible names are indexed separately because a
+    // full-name match on any setting takes precedence over a compatible one
+    settingNameIndex.clear();
+    settingGrblIndex.clear();
+    for (Setting* s : Setting::List) {
+        settingNameIndex.add(s->getName(), s);
+        settingGrblIndex.add(s->getGrblName(), s);
+    }
+    settingNameIndex.sort();
+    settingGrblIndex.sort();
+
+    indexedCommands = Command::List.size();
+    indexedSettings = Setting::List.size();
+    return commandIndex.size() + settingNameIndex.size() + settingGrblIndex.size();
+}
+
+static void refresh_indexes() {
+    if (indexedCommands != Command::List.size() || indexedSettings != Setting::List.size()) {
+        Setting::buildIndexes();
+    }
+}
+
+Command* Command::find(const char* name) {
+    refresh_indexes();
+    return commandIndex.find(name);
+}
+
+Setting* Setting::findByName(const char* name) {
+    refresh_indexes();
+    return settingNameIndex.find(name);
+}
+
+Setting* Setting::findByGrblName(const char* name) {
+    refresh_indexes();
+    return settingGrblIndex.find(name);
+}
+
 bool get_param(const char* parameter, const char* key, std::string& s) {
     char* start = strstr(parameter, key);
     if (!start) {
@@ -100,14 +156,35 @@ Error Setting::check_state() {
 
 nvs_handle Setting::_handle = 0;
 
+// The keys in the FluidNC namespace, from one pass over it when NVS is opened.  Later
+// writes do not update it, so it is dropped when startup is over.
+static std::unordered_set<std::string>* storedKeys = nullptr;
+
 void Setting::init() {
     if (!_handle) {
+        BootPhase phase("NVS open");
         if (esp_err_t err = nvs_open("FluidNC", NVS_READWRITE, &_handle)) {
             log_debug("nvs_open failed with error " << err);
+            return;
+        }
+        storedKeys = new std::unordered_set<std::string>();
+        for (nvs_iterator_t it = nvs_entry_find(NVS_DEFAULT_PART_NAME, "FluidNC", NVS_TYPE_ANY); it; it = nvs_entry_next(it)) {
+            nvs_entry_info_t info;
+            nvs_entry_info(it, &info);
+            storedKeys->emplace(info.key);
         }
     }
 }
 
+bool Setting::isStored(const char* key) {
+    return !storedKeys || storedKeys->count(key);
+}
+
+void Setting::endBootLoad() {
+    delete storedKeys;
+    storedKeys = nullptr;
+}
+
 IntSetting::IntSetting(const char*   description,
                        type_t        type,
                        permissions_t permissions,
@@ -124,7 +201,7 @@ IntSetting::IntSetting(const char*   description,
 }
 
 void IntSetting::load() {
-    esp_err_t err = nvs_get_i32(_handle, _keyName, &_storedValue);
+    esp_err_t err = isStored(_keyName) ? nvs_get_i32(_handle, _keyName, &_storedValue) : ESP_ERR_NVS_NOT_FOUND;
     if (err) {
         _storedValue  = std::numeric_limits<int32_t>::min();
         _currentValue = _defaultValue;
@@ -223,7 +300,7 @@ StringSetting::StringSetting(const char*   description,
 
 void StringSetting::load() {
     size_t    len = 0;
-    esp_err_t err = nvs_get_str(_handle, _keyName, NULL, &len);
+    esp_err_t err = isStored(_keyName) ? nvs_get_str(_handle, _keyName, NULL, &len) : ESP_ERR_NVS_NOT_FOUND;
     if (err) {
         _storedValue  = _defaultValue;
         _currentValue = _defaultValue;
@@ -306,7 +383,7 @@ EnumSetting::EnumSetting(const char*       description,
 }
 
 void EnumSetting::load() {
-    esp_err_t err = nvs_get_i8(_handle, _keyName, &_storedValue);
+    esp_err_t err = isStored(_keyName) ? nvs_get_i8(_handle, _keyName, &_storedValue) : ESP_ERR_NVS_NOT_FOUND;
     if (err) {
         _storedValue  = -1;
         _currentValue = _defaultValue;
@@ -421,7 +498,11 @@ Error UserCommand::action(const char* value, AuthenticationLevel auth_level, Cha
 Coordinates* coords[CoordIndex::End];
 
 bool Coordinates::load() {
-    size_t len;
+    // Coordinates stored by a build with fewer axes are shorter; the rest stay at zero
+    size_t len = sizeof(_currentValue);
+    if (!Setting::isStored(_name)) {
+        return false;
+    }
     switch (nvs_get_blob(Setting::_handle, _name, _currentValue, &len)) {
         case ESP_OK:
             return true;
@@ -440,12 +521,140 @@ bool Coordinates::load() {
     }
 };
 
+static bool       coordinatesPending = false;
+static TickType_t coordinatesChangedAt;
+
+// Wear statistics for $Settings/Stats: how many offset changes there were, and how many
+// NVS writes they took after being batched
+static uint32_t offsetChanges = 0;
+static uint32_t offsetWrites  = 0;
+
+static void offsets_changed() {
+    ++offsetChanges;
+    coordinatesPending   = true;
+    coordinatesChangedAt = xTaskGetTickCount();
+}
+
+// Pending changes are written after they have been stable for this long, so a burst
+// of changes from a probing routine costs one write per coordinate system
+static const TickType_t coordinateWriteDelay = pdMS_TO_TICKS(250);
+
+void Coordinates::changed() {
+    _dirty = true;
+    offsets_changed();
+}
+
 void Coordinates::set(float value[MAX_N_AXIS]) {
     memcpy(&_currentValue, value, sizeof(_currentValue));
-    if (FORCE_BUFFER_SYNC_DURING_NVS_WRITE) {
-        protocol_buffer_synchronize();
+    changed();
+}
+
+bool Coordinates::flush() {
+    if (!_dirty) {
+        return false;
     }
+    _dirty = false;
     nvs_set_blob(Setting::_handle, _name, _currentValue, sizeof(_currentValue));
+    ++offsetWrites;
+    return true;
+}
+
+namespace ToolTable {
+    static float    lengths[maxTool + 1] = {};
+    static uint64_t dirty                = 0;  // Bit per tool with a change not yet in NVS
+
+    static void key(uint32_t tool, char* name) {
+        snprintf(name, 12, "Tool%u", unsigned(tool));
+    }
+
+    void load() {
+        for (uint32_t tool = 1; tool <= maxTool; tool++) {
+            char name[12];
+            key(tool, name);
+            size_t len = sizeof(lengths[tool]);
+            if (!Setting::isStored(name) || nvs_get_blob(Setting::_handle, name, &lengths[tool], &len) != ESP_OK) {
+                lengths[tool] = 0.0f;
+            }
+        }
+    }
+
+    float get(uint32_t tool) {
+        return tool <= maxTool ? lengths[tool] : 0.0f;
+    }
+
+    void set(uint32_t tool, float length) {
+        if (tool == 0 || tool > maxTool || lengths[tool] == length) {
+            return;
+        }
+        lengths[tool] = length;
+        dirty |= uint64_t(1) << tool;
+        offsets_changed();
+    }
+
+    void setDefault() {
+        for (uint32_t tool = 1; tool <= maxTool; tool++) {
+            set(tool, 0.0f);
+        }
+    }
+
+    static int flush() {
+        int written = 0;
+        for (uint32_t tool = 1; dirty; tool++) {
+            if (dirty & (uint64_t(1) << tool)) {
+                dirty &= ~(uint64_t(1) << tool);
+                char name[12];
+                key(tool, name);
+                nvs_set_blob(Setting::_handle, name, &lengths[tool], sizeof(lengths[tool]));
+                ++offsetWrites;
+                ++written;
+            }
+        }
+        return written;
+    }
+}
+
+int flush_coordinates() {
+    int written = 0;
+    if (coordinatesPending) {
+        coordinatesPending = false;
+        if (FORCE_BUFFER_SYNC_DURING_NVS_WRITE) {
+            protocol_buffer_synchronize();
+        }
+        for (auto coord : coords) {
+            if (coord && coord->flush()) {
+                ++written;
+            }
+        }
+        written += ToolTable::flush();
+    }
+    return written;
+}
+
+void flush_coordinates_when_idle() {
+    if (coordinatesPending && !inMotionState() && !state_is(State::Hold) &&
+        (xTaskGetTickCount() - coordinatesChangedAt) >= coordinateWriteDelay) {
+        flush_coordinates();
+    }
+}
+
+Error Setting::report_nvs_stats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    nvs_stats_t stats;
+    if (esp_err_t err = nvs_get_stats(NULL, &stats)) {
+        return Error::NvsGetStatsFailed;
+    }
+
+    log_info("NVS Used:" << stats.used_entries << " Free:" << stats.free_entries << " Total:" << stats.total_entries);
+    log_info("Offset changes:" << offsetChanges << " NVS writes:" << offsetWrites);
+#if 0  // The SDK we use does not have this yet
+    nvs_iterator_t it = nvs_entry_find(NULL, NULL, NVS_TYPE_ANY);
+    while (it != NULL) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        it = nvs_entry_next(it);
+        log_info("namespace:"<<info.namespace_name<<" key:"<<info.key<<" type:"<< info.type);
+    }
+#endif
+    return Error::Ok;
 }
 
 IPaddrSetting::IPaddrSetting(
@@ -470,7 +679,7 @@ IPaddrSetting::IPaddrSetting(
 }
 
 void IPaddrSetting::load() {
-    esp_err_t err = nvs_get_i32(_handle, _keyName, (int32_t*)&_storedValue);
+    esp_err_t err = isStored(_keyName) ? nvs_get_i32(_handle, _keyName, (int32_t*)&_storedValue) : ESP_ERR_NVS_NOT_FOUND;
     if (err) {
         _storedValue  = 0x000000ff;  // Unreasonable value for any IP thing
         _currentValue = _defaultValue;
@@ -93,6 +93,10 @@ public:
     // so common code can enumerate them.
     static std::vector<Command*> List;
 
+    // Finds a command by full or compatible name, ignoring case.
+    // The first matching command in List wins, as with a linear scan.
+    static Command* find(const char* name);
+
     ~Command() {}
     Command(const char*   description,
             type_t        type,
@@ -121,30 +125,30 @@ public:
     static nvs_handle _handle;
     static void       init();
 
+    // init() collects the stored keys in one pass over the namespace, so that the
+    // settings that were never changed, most of them, take their defaults at boot
+    // without a lookup each.  isStored() is false only for a key known not to be in
+    // NVS.  endBootLoad() drops the list once startup has created the settings.
+    static bool isStored(const char* key);
+    static void endBootLoad();
+
     // Setting::List is a vector of all settings,
     // so common code can enumerate them.
     static std::vector<Setting*> List;
 
+    // Find a setting by full name or by compatible name, ignoring case
+    static Setting* findByName(const char* name);
+    static Setting* findByGrblName(const char* name);
+
+    // Builds the hashed name indexes for Command::List and Setting::List.
+    // Lookups rebuild them if either list has grown since; calling this once
+    // after the lists are populated keeps that cost out of command handling.
+    // Returns the number of names indexed.
+    static size_t buildIndexes();
+
     Error check_state();
 
-    static Error report_nvs_stats(const char* value, AuthenticationLevel auth_level, Channel& out) {
-        nvs_stats_t stats;
-        if (esp_err_t err = nvs_get_stats(NULL, &stats)) {
-            return Error::NvsGetStatsFailed;
-        }
-
-        log_info("NVS Used:" << stats.used_entries << " Free:" << stats.free_entries << " Total:" << stats.total_entries);
-#if 0  // The SDK we use does not have this yet
-        nvs_iterator_t it = nvs_entry_find(NULL, NULL, NVS_TYPE_ANY);
-        while (it != NULL) {
-            nvs_entry_info_t info;
-            nvs_entry_info(it, &info);
-            it = nvs_entry_next(it);
-            log_info("namespace:"<<info.namespace_name<<" key:"<<info.key<<" type:"<< info.type);
-        }
-#endif
-        return Error::Ok;
-    }
+    static Error report_nvs_stats(const char* value, AuthenticationLevel auth_level, Channel& out);
 
     static Error eraseNVS(const char* value, AuthenticationLevel auth_level, Channel& out) {
         nvs_erase_all(_handle);
@@ -233,10 +237,16 @@ public:
     const char* getDefaultString() override { return ""; }
 };
 
+// Coordinate changes are kept in memory and written to NVS later, when nothing is
+// moving, because G10, G28.1/G30.1, parameter assignments and probing can change
+// several of them in a row and each flash write stalls the CPU.
 class Coordinates {
 private:
-    float       _currentValue[MAX_N_AXIS];
+    float       _currentValue[MAX_N_AXIS] = {};
     const char* _name;
+    bool        _dirty = false;
+
+    void changed();
 
 public:
     Coordinates(const char* name) : _name(name) {}
@@ -257,13 +267,40 @@ public:
     // Get an individual component
     const float get(int axis) { return _currentValue[axis]; }
     // Set an individual component
-    void set(int axis, float value) { _currentValue[axis] = value; }
+    void set(int axis, float value) {
+        _currentValue[axis] = value;
+        changed();
+    }
 
     void set(float* value);
+
+    // Writes the value to NVS if it has changed; returns true if it was written
+    bool flush();
 };
 
 extern Coordinates* coords[CoordIndex::End];
 
+// Tool length offsets, set by G10 L1 P<tool> and applied by G43 H<tool>.  Like the
+// coordinate systems, the table is held in RAM and changed entries are written to NVS
+// by flush_coordinates(), so a probing routine that measures several tools writes each
+// once, when the machine is idle.
+namespace ToolTable {
+    const uint32_t maxTool = 32;  // Tools 1 to maxTool have entries; H0 is no offset
+
+    void  load();
+    float get(uint32_t tool);
+    void  set(uint32_t tool, float length);
+    void  setDefault();  // Clears all entries
+}
+
+// Writes all pending coordinate system and tool table changes, returning how many
+// entries were written
+int flush_coordinates();
+
+// Writes pending coordinate changes once they have been stable for a while, if the
+// machine is not moving.  Called from the main loop.
+void flush_coordinates_when_idle();
+
 class StringSetting : public Setting {
 private:
     std::string _defaultValue;
@@ -38,6 +38,11 @@ const enum_opt_t onoffOptions = { { "OFF", 0 }, { "ON", 1 } };
 
 EnumSetting* gcode_echo;
 
+// File also writes the report next to the job file; see JobStats.h
+const enum_opt_t jobReportOptions = { { "OFF", 0 }, { "ON", 1 }, { "File", 2 } };
+
+EnumSetting* job_report;
+
 void make_coordinate(CoordIndex index, const char* name) {
     float coord_data[MAX_N_AXIS] = { 0.0 };
     auto  coord                  = new Coordinates(name);
@@ -70,13 +75,14 @@ void make_settings() {
     make_coordinate(CoordIndex::G30, "G30");
     make_coordinate(CoordIndex::G92, "G92");
     make_coordinate(CoordIndex::TLO, "TLO");
+    ToolTable::load();
 
     message_level = new EnumSetting("Which Messages", EXTENDED, WG, NULL, "Message/Level", MsgLevelInfo, &messageLevels);
 
     config_filename = new StringSetting("Name of Configuration File", EXTENDED, WG, NULL, "Config/Filename", "config.yaml", 1, 50);
 
     // GRBL Numbered Settings
-    status_mask = new IntSetting("What to include in status report", GRBL, WG, "10", "Report/Status", 1, 0, 3);
+    status_mask = new IntSetting("What to include in status report", GRBL, WG, "10", "Report/Status", 1, 0, 7);
 
     sd_fallback_cs = new IntSetting("SD CS pin if not configured", EXTENDED, WG, NULL, "SD/FallbackCS", -1, -1, 40);
 
@@ -87,6 +93,8 @@ void make_settings() {
 
     gcode_echo = new EnumSetting("GCode Echo Enable", WEBSET, WG, NULL, "GCode/Echo", 0, &onoffOptions);
 
+    job_report = new EnumSetting("Performance report at end of job", EXTENDED, WG, NULL, "Job/Report", 1, &jobReportOptions);
+
     // Some gcode senders expect Grbl to report certain numbered settings to improve
     // their reporting. The following macros set up various legacy numbered Grbl settings,
     // which are derived from MachineConfig settings.
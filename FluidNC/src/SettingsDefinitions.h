@@ -15,3 +15,5 @@ extern IntSetting* sd_fallback_cs;
 extern EnumSetting* message_level;
 
 extern EnumSetting* gcode_echo;
+
+extern EnumSetting* job_report;
@@ -38,6 +38,7 @@ namespace Spindles {
         _pwm = new PwmPin(_output_pin, _pwm_freq);  // allocate and setup a PWM channel
 
         _enable_pin.setAttr(Pin::Attr::Output);
+        _fast_enable.resolve(_enable_pin);
 
         // BESC PWM typically represents 0 speed as a 1ms pulse and max speed as a 2ms pulse
 
@@ -47,6 +48,7 @@ namespace Spindles {
         // Calculate the pulse length offset and scaler in counts of the PWM controller
         _min_pulse_counts  = (_min_pulse_us * _pwm->period()) / pulse_period_us;
         _pulse_span_counts = ((_max_pulse_us - _min_pulse_us) * _pwm->period()) / pulse_period_us;
+        _pulse_scale       = uint32_t((uint64_t(_pulse_span_counts) << 24) / _pwm->period());
 
         if (_speeds.size() == 0) {
             shelfSpeeds(4000, 20000);
@@ -77,7 +79,7 @@ namespace Spindles {
         // represents full on.  Typically the off value is a 1ms pulse length and the
         // full on value is a 2ms pulse.
         // uint32_t pulse_counts = _min_pulse_counts + (_pulse_span_counts * (uint64_t) duty)/_pwm->period();
-        _pwm->setDuty(_min_pulse_counts + (_pulse_span_counts * (uint64_t)duty) / _pwm->period());
+        _pwm->setDuty(_min_pulse_counts + uint32_t((uint64_t(_pulse_scale) * duty) >> 24));
         // _pwm->setDuty(_min_pulse_counts+duty); // More efficient by keeping math within 32bits??
         // log_info(name() << " duty:" << duty << " _min_pulse_counts:" << _min_pulse_counts
         //                 << " _pulse_span_counts:" << _pulse_span_counts << " pulse_counts" << pulse_counts);
@@ -36,6 +36,7 @@ namespace Spindles {
         // Calculated
         uint32_t _pulse_span_counts;  // In counts of a 32-bit counter. ESP32 uses up to 20bits
         uint32_t _min_pulse_counts;   // In counts of a 32-bit counter  ESP32 uses up to 20bits
+        uint32_t _pulse_scale;        // _pulse_span_counts / period, * 2^24, so the ISR does not divide
 
     protected:
         // Configurable
@@ -31,6 +31,8 @@ namespace Spindles {
             return;
         }
 
+        _dac_gpio = _output_pin.getNative(Pin::Capabilities::DAC);  // Not looked up from the ISR
+
         _direction_pin.setAttr(Pin::Attr::Output);
 
         is_reversable = _direction_pin.defined();
@@ -51,9 +53,7 @@ namespace Spindles {
     void IRAM_ATTR Dac::setSpeedfromISR(uint32_t speed) { set_output(speed); };
     void IRAM_ATTR Dac::set_output(uint32_t duty) {
         if (_gpio_ok) {
-            auto outputNative = _output_pin.getNative(Pin::Capabilities::DAC);
-
-            dacWrite(outputNative, static_cast<uint8_t>(duty));
+            dacWrite(_dac_gpio, static_cast<uint8_t>(duty));
         }
     }
 
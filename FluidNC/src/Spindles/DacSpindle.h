@@ -30,6 +30,7 @@ namespace Spindles {
         void init() override;
         void config_message() override;
         void setSpeedfromISR(uint32_t dev_speed) override;
+        bool speedSyncable() const override { return true; }
 
         // Configuration handlers:
         // Inherited from PWM
@@ -37,7 +38,8 @@ namespace Spindles {
         ~Dac() {}
 
     private:
-        bool _gpio_ok;  // DAC is on a valid pin
+        bool     _gpio_ok;  // DAC is on a valid pin
+        pinnum_t _dac_gpio = 0;
 
     protected:
         void set_output(uint32_t duty);  // sets DAC instead of PWM
@@ -120,10 +120,18 @@ namespace Spindles {
             return;
         }
 
-        _duty_update_needed = false;
-
         _current_pwm_duty = duty;
 
+        if (!_duty_update_needed) {
+            // Same state, so the idle channel is already at 0.  This is the
+            // stepper ISR path, where only the duty changes.
+            if (_state == SpindleState::Cw || _state == SpindleState::Ccw) {
+                _pwm_ccw->setDuty(duty);
+            }
+            return;
+        }
+        _duty_update_needed = false;
+
         if (_state == SpindleState::Cw) {
             _pwm_cw->setDuty(0);
             _pwm_ccw->setDuty(duty);
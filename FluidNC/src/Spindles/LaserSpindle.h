@@ -24,6 +24,7 @@ namespace Spindles {
         Laser& operator=(Laser&&)      = delete;
 
         bool isRateAdjusted() override;
+        bool interpolatesPower() override { return _interpolate_power; }
         void config_message() override;
         void init() override;
         void set_direction(bool Clockwise) override {};
@@ -34,9 +35,14 @@ namespace Spindles {
             // We cannot call PWM::group() because that would pick up
             // direction_pin, which we do not want in Laser
             handler.item("pwm_hz", _pwm_freq, 1000, 100000);
+            handler.item("interpolate_power", _interpolate_power);
             OnOff::groupCommon(handler);
         }
 
         ~Laser() {}
+
+    private:
+        // In M4 mode, ramp the power with the velocity on every step instead of once per segment
+        bool _interpolate_power = false;
     };
 }
@@ -13,6 +13,8 @@ namespace Spindles {
         _enable_pin.setAttr(Pin::Attr::Output);
         _output_pin.setAttr(Pin::Attr::Output);
         _direction_pin.setAttr(Pin::Attr::Output);
+        _fast_enable.resolve(_enable_pin);
+        _fast_output.resolve(_output_pin);
 
         is_reversable = _direction_pin.defined();
 
@@ -56,7 +58,7 @@ namespace Spindles {
     }
 
     void IRAM_ATTR OnOff::set_output(uint32_t dev_speed) {
-        _output_pin.synchronousWrite(dev_speed != 0);
+        _fast_output.write(dev_speed != 0);
     }
 
     void IRAM_ATTR OnOff::setSpeedfromISR(uint32_t dev_speed) {
@@ -68,7 +70,7 @@ namespace Spindles {
             enable = false;
         }
 
-        _enable_pin.synchronousWrite(enable);
+        _fast_enable.write(enable);
     }
 
     void OnOff::set_direction(bool Clockwise) {
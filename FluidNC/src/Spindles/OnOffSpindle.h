@@ -9,6 +9,7 @@
 */
 
 #include "Spindle.h"
+#include "../FastPin.h"
 
 namespace Spindles {
     // This is for an on/off spindle all RPMs above 0 are on
@@ -59,6 +60,10 @@ namespace Spindles {
         Pin _enable_pin;
         Pin _output_pin;
         Pin _direction_pin;
+
+        // The enable and output pins are written from the stepper ISR
+        FastPin _fast_enable;
+        FastPin _fast_output;
         // _disable_with_zero_speed forces a disable when speed is 0
         bool _disable_with_zero_speed = false;
         // _zero_speed_with_disable forces speed to 0 when disabled
@@ -36,6 +36,7 @@ namespace Spindles {
 
         _enable_pin.setAttr(Pin::Attr::Output);
         _direction_pin.setAttr(Pin::Attr::Output);
+        _fast_enable.resolve(_enable_pin);
 
         if (_speeds.size() == 0) {
             // The default speed map for a PWM spindle is linear from 0=0% to 10000=100%
@@ -30,6 +30,7 @@ namespace Spindles {
 
         void init() override;
         void setSpeedfromISR(uint32_t dev_speed) override;
+        bool speedSyncable() const override { return true; }
         void setState(SpindleState state, SpindleSpeed speed) override;
         void config_message() override;
         // Configuration handlers:
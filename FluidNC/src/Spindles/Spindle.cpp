@@ -9,6 +9,9 @@
 #include "../System.h"  //sys.spindle_speed_ovr
 #include "src/UartChannel.h"
 
+#include <algorithm>  // std::min
+#include <esp_timer.h>
+
 Spindles::Spindle* spindle = nullptr;
 
 namespace Spindles {
@@ -95,6 +98,20 @@ namespace Spindles {
         _speeds[i].offset = offset;
         scaler            = 0;
         _speeds[i].scale  = scaler;
+
+        _speedShift = 0;
+        while ((maxSpeed() >> _speedShift) >= speedBuckets) {
+            ++_speedShift;
+        }
+        _speedIndex.resize((maxSpeed() >> _speedShift) + 1);
+        int segment = 0;
+        for (size_t bucket = 0; bucket < _speedIndex.size(); ++bucket) {
+            SpindleSpeed start = SpindleSpeed(bucket) << _speedShift;
+            while (segment < nsegments && start >= _speeds[segment + 1].speed) {
+                ++segment;
+            }
+            _speedIndex[bucket] = segment;
+        }
     }
 
     void Spindle::validate() {
@@ -171,12 +188,12 @@ namespace Spindles {
         if (speed == 0) {
             return _speeds[0].offset;
         }
-        int num_segments = _speeds.size() - 1;
-        int i;
-        for (i = 0; i < num_segments; i++) {
-            if (speed < _speeds[i + 1].speed) {
-                break;
-            }
+        int    num_segments = _speeds.size() - 1;
+        size_t bucket       = std::min(size_t(speed >> _speedShift), _speedIndex.size() - 1);
+        int    i            = _speedIndex.empty() ? 0 : _speedIndex[bucket];
+        // The bucket can span the start of later segments, and the last one covers all higher speeds
+        while (i < num_segments && speed >= _speeds[i + 1].speed) {
+            i++;
         }
         uint32_t dev_speed = _speeds[i].offset;
 
@@ -194,6 +211,8 @@ namespace Spindles {
         return dev_speed;
     }
     void Spindle::spindleDelay(SpindleState state, SpindleSpeed speed) {
+        finishDelay();
+        _queued = false;
         uint32_t up = 0, down = 0;
         switch (state) {
             case SpindleState::Unknown:
@@ -253,13 +272,95 @@ namespace Spindles {
                         break;
                 }
         }
+        uint32_t down_ms = 0, up_ms = 0;
         if (down) {
-            dwell_ms(down < maxSpeed() ? _spindown_ms * down / maxSpeed() : _spindown_ms, DwellMode::SysSuspend);
+            down_ms = down < maxSpeed() ? _spindown_ms * down / maxSpeed() : _spindown_ms;
         }
         if (up) {
-            dwell_ms(up < maxSpeed() ? _spinup_ms * up / maxSpeed() : _spinup_ms, DwellMode::SysSuspend);
+            up_ms = up < maxSpeed() ? _spinup_ms * up / maxSpeed() : _spinup_ms;
+        }
+        if (_defer_delay) {
+            _defer_delay = false;
+            if (down_ms || up_ms) {
+                _delay_end_us = esp_timer_get_time() + int64_t(down_ms + up_ms) * 1000;
+            }
+        } else if (_at_speed_percent && (down_ms || up_ms)) {
+            waitForSpeed(state == SpindleState::Disable ? 0 : speed, down_ms + up_ms);
+        } else {
+            if (down_ms) {
+                dwell_ms(down_ms, DwellMode::SysSuspend);
+            }
+            if (up_ms) {
+                dwell_ms(up_ms, DwellMode::SysSuspend);
+            }
         }
         _current_state = state;
         _current_speed = speed;
     }
+
+    bool Spindle::queueSpeed(SpindleSpeed speed) {
+        if (!speedSyncable() || !_on_the_fly_percent || (_current_state != SpindleState::Cw && _current_state != SpindleState::Ccw)) {
+            return false;
+        }
+        SpindleSpeed change = speed > _current_speed ? speed - _current_speed : _current_speed - speed;
+        if (uint64_t(change) * 100 > uint64_t(maxSpeed()) * _on_the_fly_percent) {
+            return false;
+        }
+        finishDelay();
+        _queued        = true;
+        _queued_speed  = speed;
+        _current_speed = speed;
+        return true;
+    }
+
+    // The stepper has set the speed if a block took it up, in which case this changes nothing
+    void Spindle::apply_queued() {
+        if (_queued) {
+            _queued = false;
+            setState(_current_state, _queued_speed);
+        }
+    }
+
+    // A deferred delay is the whole configured time, even with a tachometer
+    void Spindle::finishDelay() {
+        if (_delay_end_us) {
+            int64_t remaining_us = _delay_end_us - esp_timer_get_time();
+            _delay_end_us        = 0;
+            if (remaining_us > 0) {
+                dwell_ms(uint32_t((remaining_us + 999) / 1000), DwellMode::SysSuspend);
+            }
+        }
+    }
+
+    // Waits until the measured speed is close to speed, for at most timeout_ms
+    void Spindle::waitForSpeed(SpindleSpeed speed, uint32_t timeout_ms) {
+        const uint32_t checkMs   = 10;
+        SpindleSpeed   tolerance = maxSpeed() * _at_speed_percent / 100;
+
+        startSpeedMeasurement();
+        for (uint32_t elapsed = 0; elapsed < timeout_ms; elapsed += checkMs) {
+            if (!dwell_ms(checkMs, DwellMode::SysSuspend)) {
+                return;
+            }
+            if (atSpeed(speed, tolerance)) {
+                log_debug(name() << ": at speed " << speed << " after " << elapsed + checkMs << "ms");
+                return;
+            }
+        }
+        log_debug(name() << ": speed " << speed << " not measured within " << timeout_ms << "ms");
+    }
+
+    void Spindle::startSpeedMeasurement() {
+        if (_tach) {
+            _tach->start();
+        }
+    }
+
+    bool Spindle::atSpeed(SpindleSpeed speed, SpindleSpeed tolerance) {
+        uint32_t rpm;
+        if (!_tach || !_tach->update(rpm)) {
+            return false;
+        }
+        return (rpm > speed ? rpm - speed : speed - rpm) <= tolerance;
+    }
 }
@@ -6,6 +6,8 @@
 #include <cstdint>
 
 #include "../SpindleDatatypes.h"
+#include "Tachometer.h"
+#include "SpindleEncoder.h"
 #include "../Machine/Macros.h"
 
 #include "../Configuration/Configurable.h"
@@ -51,6 +53,22 @@ namespace Spindles {
         static void switchSpindle(uint32_t new_tool, SpindleList spindles, Spindle*& spindle, bool& stop_spindle, bool& new_spindle);
 
         void         spindleDelay(SpindleState state, SpindleSpeed speed);
+        void         waitForSpeed(SpindleSpeed speed, uint32_t timeout_ms);
+
+        // deferDelay() lets the next spindleDelay() return without waiting, so that motion
+        // can run while the spindle changes speed.  finishDelay() waits for the rest of it;
+        // probing, M0 and the next speed change call it.
+        void deferDelay() { _defer_delay = true; }
+        void finishDelay();
+
+        // A speed change of at most on_the_fly_percent of the max speed, with motion queued,
+        // is left to the stepper, which sets the speed of each segment, so it happens as the
+        // blocks planned after it start.  Returns false if the change has to wait for the
+        // motion to finish and then for the spindle instead.
+        bool queueSpeed(SpindleSpeed speed);
+
+        // Sets a queued speed that no block has set, once the motion is done
+        void apply_queued();
         virtual void init() = 0;  // not in constructor because this also gets called when $$ settings change
         virtual void init_atc();
         std::string  atc_info() { return _atc_info; };
@@ -61,12 +79,18 @@ namespace Spindles {
         void            stop() { setState(SpindleState::Disable, 0); }
         virtual void    config_message() = 0;
         virtual bool    isRateAdjusted();
+        virtual bool    interpolatesPower() { return false; }
         virtual bool    use_delay_settings() const { return true; }
+        virtual bool    speedSyncable() const { return false; }  // True if setSpeedfromISR() sets the speed
         virtual uint8_t get_current_tool_num() { return _current_tool; }
         virtual bool    tool_change(uint32_t tool_number, bool pre_select, bool set_tool);
 
         virtual void setSpeedfromISR(uint32_t dev_speed) = 0;
 
+        // Measured speed for waitForSpeed(), from the tachometer if there is one
+        virtual void startSpeedMeasurement();
+        virtual bool atSpeed(SpindleSpeed speed, SpindleSpeed tolerance);
+
         void spinDown() { setState(SpindleState::Disable, 0); }
 
         bool                  is_reversable;
@@ -78,10 +102,31 @@ namespace Spindles {
         uint32_t _spinup_ms   = 0;
         uint32_t _spindown_ms = 0;
 
+        bool    _defer_delay  = false;
+        int64_t _delay_end_us = 0;  // esp_timer_get_time() when a deferred delay ends, or 0
+
+        uint32_t     _on_the_fly_percent = 0;
+        bool         _queued             = false;  // A speed change is left for the stepper, see queueSpeed()
+        SpindleSpeed _queued_speed       = 0;
+
+        // When set, spinup_ms and spindown_ms are timeouts and the spindle is up to
+        // speed when the measured speed is within this percent of the max speed
+        uint32_t    _at_speed_percent = 0;
+        Tachometer* _tach             = nullptr;
+
+        // Spindle position, for G33 and G33.1
+        SpindleEncoder* _encoder = nullptr;
+
         int _tool = -1;
 
         std::vector<Configuration::speedEntry> _speeds;
 
+        // The first _speeds segment for each bucket of 2^_speedShift speed units,
+        // so mapSpeed() does not have to search the whole map
+        static const uint32_t speedBuckets = 256;
+        std::vector<uint16_t> _speedIndex;
+        uint8_t               _speedShift = 0;
+
         bool _off_on_alarm = false;
 
         Macro       _m6_macro;
@@ -98,6 +143,12 @@ namespace Spindles {
             if (use_delay_settings()) {
                 handler.item("spinup_ms", _spinup_ms, 0, 60000);
                 handler.item("spindown_ms", _spindown_ms, 0, 60000);
+                handler.item("at_speed_percent", _at_speed_percent, 0, 50);
+                if (speedSyncable()) {
+                    handler.item("on_the_fly_percent", _on_the_fly_percent, 0, 100);
+                }
+                handler.section("tachometer", _tach);
+                handler.section("encoder", _encoder);
             }
             handler.item("tool_num", _tool, 0, MaxToolNumber);
             handler.item("speed_map", _speeds);
@@ -107,7 +158,10 @@ namespace Spindles {
         }
 
         // Virtual base classes require a virtual destructor.
-        virtual ~Spindle() {}
+        virtual ~Spindle() {
+            delete _tach;
+            delete _encoder;
+        }
 
     protected:
         uint8_t _current_tool = 0;
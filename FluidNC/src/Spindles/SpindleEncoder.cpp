@@ -0,0 +1,73 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SpindleEncoder.h"
+
+#include "src/Logging.h"
+
+#include "Driver/PulseCounter.h"
+#include "Driver/fluidnc_gpio.h"  // gpio_add_interrupt
+
+#include <esp_timer.h>
+
+namespace Spindles {
+    void IRAM_ATTR SpindleEncoder::index_isr(void* arg) {
+        auto encoder = static_cast<SpindleEncoder*>(arg);
+        if (encoder->_indexFast.read()) {
+            encoder->_index_counts = encoder->_counter->position();
+            encoder->_indexes      = encoder->_indexes + 1;
+        }
+    }
+
+    bool SpindleEncoder::start() {
+        if (_counter) {
+            return true;
+        }
+        if (_a_pin.undefined() || _b_pin.undefined() || _index_pin.undefined()) {
+            log_error("Spindle encoder needs a_pin, b_pin and index_pin");
+            return false;
+        }
+        if (!_index_pin.capabilities().has(Pin::Capabilities::Native)) {
+            log_error("Spindle encoder index_pin must be a GPIO");
+            return false;
+        }
+        _a_pin.setAttr(Pin::Attr::Input);
+        _b_pin.setAttr(Pin::Attr::Input);
+        _index_pin.setAttr(Pin::Attr::Input);
+        _counter = new QuadratureCounter(_a_pin, _b_pin);
+        _indexFast.resolve(_index_pin);
+        gpio_add_interrupt(_index_pin.index(), GPIO_EDGE_ANY, index_isr, this);
+
+        _speed_counts = _counter->position();
+        _speed_us     = esp_timer_get_time();
+        log_info("Spindle encoder A:" << _a_pin.name() << " B:" << _b_pin.name() << " Index:" << _index_pin.name()
+                                      << " counts/rev:" << _counts_per_rev);
+        return true;
+    }
+
+    int32_t SpindleEncoder::counts() {
+        return _counter ? _counter->position() : 0;
+    }
+
+    float SpindleEncoder::revs_per_sec() {
+        if (!_counter) {
+            return 0.0f;
+        }
+        int32_t counts = _counter->position();
+        int64_t now    = esp_timer_get_time();
+        int64_t dt     = now - _speed_us;
+        if (dt >= speedWindowUs) {
+            _rps          = float(counts - _speed_counts) * 1000000.0f / (float(dt) * _counts_per_rev);
+            _speed_counts = counts;
+            _speed_us     = now;
+        }
+        return _rps;
+    }
+
+    SpindleEncoder::~SpindleEncoder() {
+        if (_counter) {
+            gpio_remove_interrupt(_index_pin.index());
+            delete _counter;
+        }
+    }
+}
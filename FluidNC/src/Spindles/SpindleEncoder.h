@@ -0,0 +1,73 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SpindleEncoder.h - spindle position from a quadrature encoder with an index
+
+  Spindle synchronized motion, G33 and G33.1, needs to know where the spindle
+  is, not just how fast it turns.  The A and B signals are counted in hardware,
+  and the index pulse, once per revolution, is caught by an interrupt that
+  records the count at that moment.  A synchronized move starts at an index
+  pulse, so that each pass of a thread starts at the same spindle angle.
+  Swap a_pin and b_pin if the count runs backwards in M3.
+*/
+
+#include "src/Configuration/Configurable.h"
+#include "src/FastPin.h"
+#include "src/Pin.h"
+
+#include <cstdint>
+
+class QuadratureCounter;
+
+namespace Spindles {
+    class SpindleEncoder : public Configuration::Configurable {
+        static const int64_t speedWindowUs = 20000;
+
+        Pin      _a_pin;
+        Pin      _b_pin;
+        Pin      _index_pin;
+        uint32_t _counts_per_rev = 4096;  // Edges of A and B per revolution
+
+        QuadratureCounter* _counter = nullptr;
+        FastPin            _indexFast;
+
+        volatile uint32_t _indexes      = 0;  // Index pulses since start()
+        volatile int32_t  _index_counts = 0;  // The count at the last one
+
+        // The start of the current speed measurement, and the last result
+        int32_t _speed_counts = 0;
+        int64_t _speed_us     = 0;
+        float   _rps          = 0.0f;
+
+        static void index_isr(void* arg);
+
+    public:
+        // Sets up the counter and the index interrupt the first time.  Returns false
+        // if the pins are not usable.
+        bool start();
+
+        int32_t  counts();
+        uint32_t counts_per_rev() const { return _counts_per_rev; }
+
+        // For the stepper ISR, which starts a synchronized move at an index pulse
+        inline uint32_t IRAM_ATTR indexes() const { return _indexes; }
+        inline int32_t IRAM_ATTR  index_counts() const { return _index_counts; }
+
+        // Spindle speed in revolutions per second, negative when the count runs down.
+        // It is measured over at least speedWindowUs, so calls in between return the
+        // last measurement.
+        float revs_per_sec();
+
+        void group(Configuration::HandlerBase& handler) override {
+            handler.item("a_pin", _a_pin);
+            handler.item("b_pin", _b_pin);
+            handler.item("index_pin", _index_pin);
+            handler.item("counts_per_rev", _counts_per_rev, 4, 1000000);
+        }
+
+        ~SpindleEncoder();
+    };
+}
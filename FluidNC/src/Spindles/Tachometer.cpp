@@ -0,0 +1,42 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Tachometer.h"
+
+#include "Driver/PulseCounter.h"
+
+#include <esp_timer.h>
+
+namespace Spindles {
+    void Tachometer::start() {
+        if (!_counter) {
+            _pin.setAttr(Pin::Attr::Input);
+            _counter = new PulseCounter(_pin);
+        }
+        _counter->take();
+        _pulses   = 0;
+        _start_us = esp_timer_get_time();
+    }
+
+    // Called often enough that the counter does not wrap
+    bool Tachometer::update(uint32_t& rpm) {
+        if (!_counter) {
+            return false;
+        }
+        _pulses += _counter->take();
+
+        int64_t now = esp_timer_get_time();
+        int64_t dt  = now - _start_us;
+        if (dt <= 0 || (_pulses < minPulses && dt < maxWindowUs)) {
+            return false;
+        }
+        rpm       = uint32_t(uint64_t(_pulses) * 60000000 / (uint64_t(_pulses_per_rev) * uint64_t(dt)));
+        _pulses   = 0;
+        _start_us = now;
+        return true;
+    }
+
+    Tachometer::~Tachometer() {
+        delete _counter;
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Tachometer.h - spindle speed from a tach or encoder input
+
+  The pulses are counted in hardware.  A measurement ends when it has enough pulses for
+  a resolution of about 5%, or after half a second at low speeds, so the update rate
+  follows the speed and the pulses per revolution.
+*/
+
+#include "src/Configuration/Configurable.h"
+#include "src/Pin.h"
+
+class PulseCounter;
+
+namespace Spindles {
+    class Tachometer : public Configuration::Configurable {
+        static const uint32_t minPulses   = 20;
+        static const int64_t  maxWindowUs = 500000;
+
+        Pin      _pin;
+        uint32_t _pulses_per_rev = 1;
+
+        PulseCounter* _counter  = nullptr;
+        uint32_t      _pulses   = 0;
+        int64_t       _start_us = 0;
+
+    public:
+        // Begins a new measurement
+        void start();
+
+        // True when a measurement ends, with its speed in rpm
+        bool update(uint32_t& rpm);
+
+        void group(Configuration::HandlerBase& handler) override {
+            handler.item("pin", _pin);
+            handler.item("pulses_per_rev", _pulses_per_rev, 1, 10000);
+        }
+
+        ~Tachometer();
+    };
+}
@@ -2,6 +2,7 @@
 
 #include "../VFDSpindle.h"
 #include "../../MotionControl.h"  // mc_critical
+#include "../../Metrics.h"
 
 #include <freertos/task.h>
 #include <freertos/queue.h>
@@ -37,26 +38,55 @@ namespace Spindles {
             }
         }
 
+        // Whether the reported speed is close enough to the commanded one that polling can slow down
+        bool VFDProtocol::at_speed(VFDSpindle* spindle) {
+            int32_t  target = spindle->_current_dev_speed;
+            uint32_t actual = spindle->_sync_dev_speed;
+            if (target < 0 || actual == UINT32_MAX) {
+                return false;  // No speed set or read yet
+            }
+            uint32_t diff = actual > uint32_t(target) ? actual - target : target - actual;
+            return diff <= spindle->_slop;
+        }
+
         // The communications task
+        //
+        // Commands from the queue go out as soon as they arrive; the task waits for them
+        // with the poll period as the timeout, so status polls fill the idle time and never
+        // hold up a setpoint.  After a speed or mode change the poll period is ramp_poll_ms,
+        // and the polls ask for the speed, until the VFD reports the new speed or
+        // rampTimeoutMs passes.  Then it goes back to poll_ms.
         void VFDProtocol::vfd_cmd_task(void* pvParameters) {
             static bool unresponsive = false;  // to pop off a message once each time it becomes unresponsive
             static int  pollidx      = -1;
 
+            const TickType_t rampTimeout = pdMS_TO_TICKS(10000);
+
             VFDSpindle*   instance = static_cast<VFDSpindle*>(pvParameters);
             auto          impl     = instance->detail_;
             auto&         uart     = *instance->_uart;
             ModbusCommand next_cmd;
             uint8_t       rx_message[VFD_RS485_MAX_MSG_SIZE];
             bool          safetyPollingEnabled = impl->safety_polling();
+            bool          ramping              = false;
+            TickType_t    rampStart            = 0;
 
-            for (; true; delay_ms(instance->_poll_ms)) {
+            while (true) {
                 std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);  // read fence for settings
                 response_parser parser = nullptr;
 
+                if (ramping && (at_speed(instance) || xTaskGetTickCount() - rampStart > rampTimeout)) {
+                    ramping = false;
+                }
+                bool       fast = ramping || instance->_syncing;
+                TickType_t wait = pdMS_TO_TICKS(fast ? instance->_ramp_poll_ms : instance->_poll_ms);
+
                 // First check if we should ask the VFD for the speed parameters as part of the initialization.
                 if (pollidx < 0) {
                     if ((parser = impl->initialization_sequence(pollidx, next_cmd, instance)) == nullptr) {
                         pollidx = 1;  // Done with initialization. Main sequence.
+                    } else {
+                        delay_ms(instance->_poll_ms);
                     }
                 }
                 next_cmd.critical = false;
@@ -64,7 +94,9 @@ namespace Spindles {
                 VFDaction action;
                 if (parser == nullptr) {
                     // If we don't have a parser, the queue goes first.
-                    if (xQueueReceive(vfd_cmd_queue, &action, 0)) {
+                    if (xQueueReceive(vfd_cmd_queue, &action, wait)) {
+                        ramping   = true;
+                        rampStart = xTaskGetTickCount();
                         switch (action.action) {
                             case actionSetSpeed:
                                 if (!impl->prepareSetSpeedCommand(action.arg, next_cmd, instance)) {
@@ -88,9 +120,10 @@ namespace Spindles {
 
                         // We poll in a cycle. Note that the switch will fall through unless we encounter a hit.
                         // The weakest form here is 'get_status_ok' which should be implemented if the rest fails.
-                        if (instance->_syncing) {
+                        if (fast) {
                             parser = impl->get_current_speed(next_cmd);
-                        } else if (safetyPollingEnabled) {
+                        }
+                        if (parser == nullptr && safetyPollingEnabled) {
                             switch (pollidx) {
                                 case 1:
                                     parser = impl->get_current_speed(next_cmd);
@@ -192,6 +225,7 @@ namespace Spindles {
                                 }
                             } else {
                                 // Parsing failed
+                                Metrics::vfd_error();
                                 if (instance->_debug) {
                                     reportParsingErrors(next_cmd, rx_message, read_length);
                                 }
@@ -203,6 +237,7 @@ namespace Spindles {
                             }
                         }
                     } else {
+                        Metrics::vfd_error();
                         if (instance->_debug) {
                             reportCmdErrors(next_cmd, rx_message, read_length, instance->_modbus_id);
                         }
@@ -70,6 +70,8 @@ namespace Spindles {
             static void reportParsingErrors(ModbusCommand cmd, uint8_t* rx_message, size_t read_length);
             static void reportCmdErrors(ModbusCommand cmd, uint8_t* rx_message, size_t read_length, uint8_t id);
 
+            static bool at_speed(VFDSpindle* spindle);
+
         public:
             VFDProtocol() {}
             VFDProtocol(const VFDProtocol&)            = delete;
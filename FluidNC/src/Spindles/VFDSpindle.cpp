@@ -68,14 +68,7 @@ namespace Spindles {
         // Initialization is complete, so now it's okay to run the queue task:
         if (!VFD::VFDProtocol::vfd_cmd_queue) {  // init can happen many times, we only want to start one task
             VFD::VFDProtocol::vfd_cmd_queue = xQueueCreate(VFD_RS485_QUEUE_SIZE, sizeof(VFD::VFDProtocol::VFDaction));
-            xTaskCreatePinnedToCore(VFD::VFDProtocol::vfd_cmd_task,  // task
-                                    "vfd_cmdTaskHandle",             // name for task
-                                    2048,                            // size of task stack
-                                    this,                            // parameters
-                                    1,                               // priority
-                                    &VFD::VFDProtocol::vfd_cmdTaskHandle,
-                                    SUPPORT_TASK_CORE  // core
-            );
+            Machine::Tasks::create("vfd", VFD::VFDProtocol::vfd_cmd_task, this, &VFD::VFDProtocol::vfd_cmdTaskHandle);
         }
 
         init_atc();
@@ -177,6 +170,22 @@ namespace Spindles {
         //        }
     }
 
+    // For VFDs that use the delay settings but also report their speed
+    void VFDSpindle::startSpeedMeasurement() {
+        _sync_dev_speed = UINT32_MAX;  // Until the next report
+        Spindle::startSpeedMeasurement();
+    }
+
+    bool VFDSpindle::atSpeed(SpindleSpeed speed, SpindleSpeed tolerance) {
+        uint32_t actual = _sync_dev_speed;
+        if (actual == UINT32_MAX) {
+            return Spindle::atSpeed(speed, tolerance);
+        }
+        uint32_t minAllowed = speed > tolerance ? mapSpeed(speed - tolerance) : 0;
+        uint32_t maxAllowed = mapSpeed(speed + tolerance);
+        return actual >= minAllowed && actual <= maxAllowed;
+    }
+
     void IRAM_ATTR VFDSpindle::setSpeedfromISR(uint32_t dev_speed) {
         if (_current_dev_speed == dev_speed || _last_speed == dev_speed) {
             return;
@@ -226,6 +235,7 @@ namespace Spindles {
         handler.item("modbus_id", _modbus_id, 0, 247);  // per https://modbus.org/docs/PI_MBUS_300.pdf
         handler.item("debug", _debug, 0, 5);
         handler.item("poll_ms", _poll_ms, 250, 20000);
+        handler.item("ramp_poll_ms", _ramp_poll_ms, 20, 20000);
         handler.item("retries", _retries);
 
         Spindle::group(handler);
@@ -33,12 +33,13 @@ namespace Spindles {
 
     protected:
         // The constructor sets these
-        int      _uart_num  = -1;
-        Uart*    _uart      = nullptr;
-        uint8_t  _modbus_id = 1;
-        uint8_t  _debug     = 0;
-        uint32_t _poll_ms   = 250;
-        uint32_t _retries   = 5;
+        int      _uart_num     = -1;
+        Uart*    _uart         = nullptr;
+        uint8_t  _modbus_id    = 1;
+        uint8_t  _debug        = 0;
+        uint32_t _poll_ms      = 250;
+        uint32_t _ramp_poll_ms = 100;  // While the speed is changing
+        uint32_t _retries      = 5;
 
         void setSpeed(uint32_t dev_speed);
 
@@ -55,6 +56,10 @@ namespace Spindles {
         void config_message();
         void setState(SpindleState state, SpindleSpeed speed);
         void setSpeedfromISR(uint32_t dev_speed) override;
+        bool speedSyncable() const override { return true; }
+
+        void startSpeedMeasurement() override;
+        bool atSpeed(SpindleSpeed speed, SpindleSpeed tolerance) override;
 
         // volatile uint32_t _sync_dev_speed;
         uint32_t     _sync_dev_speed;
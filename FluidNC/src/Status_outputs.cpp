@@ -27,55 +27,33 @@ void Status_Outputs::init() {
     }
 
     log_info("Status outputs"
-             << " Interval:" << _report_interval_ms << " Idle:" << _Idle_pin.name() << " Cycle:" << _Run_pin.name()
+             << " Idle:" << _Idle_pin.name() << " Cycle:" << _Run_pin.name()
              << " Hold:" << _Hold_pin.name() << " Alarm:" << _Alarm_pin.name());
 
+    // Registered so that pollLine() is called; it does not use the reports
     allChannels.registration(this);
-    setReportInterval(_report_interval_ms);
-}
-
-void Status_Outputs::parse_report() {
-    if (_report.rfind("<", 0) == 0) {
-        parse_status_report();
-        return;
-    }
-}
-
-// This is how the OLED driver receives channel data
-size_t Status_Outputs::write(uint8_t data) {
-    char c = data;
-    if (c == '\r') {
-        return 1;
-    }
-    if (c == '\n') {
-        parse_report();
-        _report = "";
-        return 1;
-    }
-    _report += c;
-    return 1;
 }
 
 Error Status_Outputs::pollLine(char* line) {
-    autoReport();
+    MachineStatus status;
+    uint32_t      seq = machine_status_read(status);
+    if (seq == _lastSeq) {
+        return Error::NoData;
+    }
+    _lastSeq = seq;
+    if (_stateValid && status.state == _state) {
+        return Error::NoData;
+    }
+    _state      = status.state;
+    _stateValid = true;
+
+    _Idle_pin.write(_state == State::Idle);
+    _Run_pin.write(_state == State::Cycle);
+    _Hold_pin.write(_state == State::Hold);
+    _Alarm_pin.write(_state == State::Alarm || _state == State::ConfigAlarm || _state == State::Critical);
     return Error::NoData;
 }
 
-void Status_Outputs::parse_status_report() {
-    if (_report.back() == '>') {
-        _report.pop_back();
-    }
-    // Now the string is a sequence of field|field|field
-    size_t pos     = 0;
-    auto   nextpos = _report.find_first_of("|", pos);
-    _state         = _report.substr(pos + 1, nextpos - pos - 1);
-
-    _Idle_pin.write(_state == "Idle");
-    _Run_pin.write(_state == "Run");
-    _Hold_pin.write(_state.substr(0, 4) == "Hold");
-    _Alarm_pin.write(_state == "Alarm");
-}
-
 // Configuration registration
 namespace {
     ConfigurableModuleFactory::InstanceBuilder<Status_Outputs> registration("status_outputs");
@@ -3,6 +3,7 @@
 #include "src/Config.h"
 #include "src/Module.h"
 #include "src/Channel.h"
+#include "src/MachineStatus.h"
 
 class Status_Outputs : public Channel, public ConfigurableModule {
     Pin _Idle_pin;
@@ -12,14 +13,14 @@ class Status_Outputs : public Channel, public ConfigurableModule {
 
 public:
 private:
-    std::string _report;
-    std::string _state;
+    uint32_t _lastSeq = 0;
+    State    _state;
+    bool     _stateValid = false;
 
+    // Still accepted in config files.  The pins now follow the published
+    // MachineStatus, so they change as soon as the state does.
     int _report_interval_ms = 500;
 
-    void parse_report();
-    void parse_status_report();
-
 public:
     Status_Outputs(const char* name) : Channel(name), ConfigurableModule(name) {}
 
@@ -32,7 +33,7 @@ public:
 
     void init() override;
 
-    size_t write(uint8_t data) override;
+    size_t write(uint8_t data) override { return 1; }
 
     Error pollLine(char* line) override;
     void  flushRx() override {}
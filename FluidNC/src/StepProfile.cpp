@@ -0,0 +1,77 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "StepProfile.h"
+
+#include "Logging.h"
+#include "Stepping.h"  // Stepping::_accelerationTicks
+#include <esp32-hal-cpu.h>  // getCpuFrequencyMhz()
+#include <cstring>
+
+namespace StepProfile {
+    volatile bool enabled = false;
+    Histogram     histograms[N_PROBES];
+
+    static const char* probeNames[N_PROBES] = { "pulse_func", "step", "unstep", "prep_segment" };
+
+    // Smallest cycle count that falls in bucket b
+    static uint32_t bucket_floor(int b) {
+        if (b < sub_buckets) {
+            return b;
+        }
+        int octave = b / sub_buckets + 1;
+        return uint32_t(sub_buckets + b % sub_buckets) << (octave - 2);
+    }
+
+    void reset() {
+        bool was_enabled = enabled;
+        enabled          = false;
+        memset(histograms, 0, sizeof(histograms));
+        enabled = was_enabled;
+    }
+
+    void report(Channel& out) {
+        float mhz = getCpuFrequencyMhz();
+        log_stream(out, "Profiling " << (enabled ? "on" : "off") << ", cycles at " << int(mhz) << "MHz");
+        for (int p = 0; p < N_PROBES; ++p) {
+            const Histogram& h = histograms[p];
+            if (h.count == 0) {
+                log_stream(out, probeNames[p] << ": no samples");
+                continue;
+            }
+            // The 99th percentile is reported as the upper end of the bucket that holds it
+            uint32_t threshold = h.count - h.count / 100;
+            uint32_t seen      = 0;
+            uint32_t p99       = h.max;
+            for (int b = 0; b < n_buckets; ++b) {
+                seen += h.buckets[b];
+                if (seen >= threshold) {
+                    p99 = b + 1 < n_buckets ? bucket_floor(b + 1) - 1 : h.max;
+                    break;
+                }
+            }
+            if (p99 > h.max) {
+                p99 = h.max;
+            }
+            uint32_t avg = uint32_t(h.total / h.count);
+            log_stream(out,
+                       probeNames[p] << ": n=" << h.count << " min=" << h.min << " avg=" << avg << " p99=" << p99 << " max=" << h.max
+                                     << " (max " << (h.max / mhz) << "us)");
+        }
+        const Histogram& isr = histograms[PulseFunc];
+        if (isr.count) {
+            // Every step pulse costs one ISR, so the ISR cost bounds the step rate
+            uint32_t avg = uint32_t(isr.total / isr.count);
+            log_stream(out,
+                       "ISR-limited step rate: " << uint32_t(mhz * 1e6f / avg) << "/s at avg, " << uint32_t(mhz * 1e6f / isr.max)
+                                                 << "/s at max");
+        }
+        const Histogram& prep = histograms[PrepSegment];
+        if (prep.count) {
+            // While moving, segments are made at the segment rate
+            uint32_t avg     = uint32_t(prep.total / prep.count);
+            float    percent = avg * float(Machine::Stepping::_accelerationTicks) / (mhz * 1e6f) * 100;
+            log_stream(out, "Segment prep: " << percent << "% of a core at " << Machine::Stepping::_accelerationTicks << " segments/s");
+        }
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  StepProfile.h - cycle-count histograms for the stepping ISR
+
+  When enabled with $Stepping/Profile=on, the stepper ISR and the step engine calls record
+  how many CPU cycles each invocation took.  The histograms live in DRAM and are updated
+  with inline code, so they are safe to use from IRAM functions while the flash cache is
+  disabled.  $Stepping/Profile reports min/avg/p99/max per probe, which tells how much
+  headroom the chosen engine and pulse settings leave below the step rate limit, and
+  how much CPU segment prep takes at the configured acceleration_ticks_per_sec.
+*/
+
+#include <xtensa/core-macros.h>  // XTHAL_GET_CCOUNT()
+#include <cstdint>
+
+class Channel;
+
+namespace StepProfile {
+    enum Probe : int {
+        PulseFunc = 0,  // Stepper::pulse_func(), the whole ISR body
+        Step,           // Stepping::step()
+        Unstep,         // Stepping::unstep()
+        PrepSegment,    // One segment made by Stepper::prep_buffer()
+        N_PROBES,
+    };
+
+    // Buckets are a quarter octave wide, so p99 is reported to within 19%.
+    const int sub_buckets = 4;
+    const int n_buckets   = 24 * sub_buckets;  // Up to 16M cycles
+
+    struct Histogram {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t total;
+        uint32_t buckets[n_buckets];
+    };
+
+    extern volatile bool enabled;
+    extern Histogram     histograms[N_PROBES];
+
+    inline __attribute__((always_inline)) int bucket(uint32_t cycles) {
+        if (cycles < sub_buckets) {
+            return cycles;
+        }
+        int octave = 31 - __builtin_clz(cycles);
+        int b      = (octave - 1) * sub_buckets + ((cycles >> (octave - 2)) & (sub_buckets - 1));
+        return b < n_buckets ? b : n_buckets - 1;
+    }
+
+    inline __attribute__((always_inline)) void record(Probe probe, uint32_t cycles) {
+        Histogram& h = histograms[probe];
+        if (h.count == 0 || cycles < h.min) {
+            h.min = cycles;
+        }
+        if (cycles > h.max) {
+            h.max = cycles;
+        }
+        ++h.count;
+        h.total += cycles;
+        ++h.buckets[bucket(cycles)];
+    }
+
+    // Records the cycles from construction to destruction, if profiling is enabled.
+    class Scope {
+        Probe    _probe;
+        uint32_t _start;
+
+    public:
+        inline __attribute__((always_inline)) Scope(Probe probe) : _probe(probe), _start(enabled ? XTHAL_GET_CCOUNT() : 0) {}
+        inline __attribute__((always_inline)) ~Scope() {
+            if (_start) {
+                record(_probe, XTHAL_GET_CCOUNT() - _start);
+            }
+        }
+    };
+
+    void reset();
+    void report(Channel& out);
+}
@@ -9,13 +9,28 @@
 
 #include "Stepper.h"
 
+#include "AxisCount.h"
 #include "Machine/MachineConfig.h"
 #include "MotionControl.h"
 #include "Stepping.h"
 #include "StepperPrivate.h"
 #include "Planner.h"
 #include "Protocol.h"
-#include <esp_attr.h>  // IRAM_ATTR
+#include "SCurve.h"
+#include "SegmentSteps.h"
+#include "InputShaper.h"
+#include "StepProfile.h"
+#include "SyncLink.h"
+#include "Trace.h"
+#include "Motors/Servo.h"  // Servo::update_segment()
+#include "Machine/LimitPin.h"
+#include "ControlPin.h"
+#include <esp_attr.h>      // IRAM_ATTR
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 
 using namespace Stepper;
@@ -31,8 +46,26 @@ static bool awake = false;
 struct st_block_t {
     uint32_t steps[MAX_N_AXIS];
     uint32_t step_event_count;
-    uint8_t  direction_bits;
+    AxisMask direction_bits;
     bool     is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
+    bool     is_pwm_interpolated;   // Laser power also follows the velocity within segments
+
+    Raster::Scanline* raster;  // Laser pixels along the block, or nullptr
+
+    uint8_t outputs_mask;  // M62/M63 user outputs switched as the block starts
+    uint8_t outputs_on;
+
+    bool         coolant_sync;  // M7/M8/M9 made as the block starts, see prep_coolant()
+    CoolantState coolant;
+
+    uint8_t     n_output_events;  // M62/M63 Q user outputs, at steps scaled like step_event_count
+    OutputEvent output_events[maxOutputEvents];
+
+    bool sync_start;  // Starts a run of spindle synchronized blocks, at the next index pulse
+
+#ifdef TRACE_POINTS
+    uint32_t trace_id;
+#endif
 };
 static volatile st_block_t* st_block_buffer = nullptr;
 
@@ -46,10 +79,22 @@ struct segment_t {
     uint8_t      st_block_index;     // Stepper block data index. Uses this information to execute this segment.
     uint8_t      amass_level;        // AMASS level for the ISR to execute this segment
     uint32_t     spindle_dev_speed;  // Spindle speed scaled to the device
+    int32_t      spindle_dev_slope;  // Change of spindle_dev_speed per ISR tick, * 256, for power interpolation
     SpindleSpeed spindle_speed;      // Spindle speed in GCode units
 };
 static segment_t* segment_buffer = nullptr;
 
+// The prep state from just before each queued segment was prepped, so that a feed hold can
+// take back the segments the ISR has not reached and start decelerating from an earlier point.
+struct segment_rewind_t {
+    float                          millimeters;  // Of the planner block
+    SegmentSteps::Quantizer::State steps;
+    float                          current_speed;
+};
+static segment_rewind_t* segment_rewind = nullptr;
+
+static float dt_segment;  // Minutes per segment, from stepping/acceleration_ticks_per_sec
+
 void Stepper::init() {
     if (st_block_buffer) {
         delete[] st_block_buffer;
@@ -59,6 +104,22 @@ void Stepper::init() {
         delete[] segment_buffer;
     }
     segment_buffer = new segment_t[Stepping::_segments];
+    if (segment_rewind) {
+        delete[] segment_rewind;
+    }
+    segment_rewind = new segment_rewind_t[Stepping::_segments];
+    dt_segment     = 1.0f / (float(Stepping::_accelerationTicks) * 60.0f);
+
+    memset(&backlash, 0, sizeof(backlash));
+    for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
+        auto a = Axes::_axis[axis];
+        if (a && a->_backlash > 0.0f) {
+            backlash.steps[axis]  = uint32_t(lroundf(a->_backlash * a->_stepsPerMm));
+            float takeup_rate     = a->_stepsPerMm * a->_maxRate / 60.0f / 2.0f;  // Steps per second
+            backlash.period[axis] = uint32_t(Stepping::fStepperTimer / takeup_rate);
+            log_info("  Backlash " << Axes::axisName(axis) << " " << backlash.steps[axis] << " steps");
+        }
+    }
 }
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
@@ -67,27 +128,153 @@ typedef struct {
 
     uint32_t counter[MAX_N_AXIS];  // Counter variables for the bresenham line tracer
 
-    uint8_t  step_bits;     // Stores out_bits output to complete the step pulse delay
+    AxisMask step_bits;     // Stores out_bits output to complete the step pulse delay
     uint8_t  execute_step;  // Flags step execution for each interrupt.
-    uint8_t  step_outbits;  // The next stepping-bits to be output
-    uint8_t  dir_outbits;
+    AxisMask step_outbits;  // The next stepping-bits to be output
+    AxisMask dir_outbits;
     uint32_t steps[MAX_N_AXIS];
 
     uint16_t             step_count;        // Steps remaining in line segment motion
+    AxisMask             run_mask;          // Axes that step at every event of the segment, if no others move
+    bool                 run_timer;         // The timer period was set for a run
+    uint16_t             isr_period;        // Timer ticks between ISR ticks of the last segment loaded
+    uint32_t             spindle_dev_speed; // Segment spindle output, interpolated
+    uint32_t             spindle_output;    // Last value sent to the spindle
     uint8_t              exec_block_index;  // Tracks the current st_block index. Change indicates new block.
     volatile st_block_t* exec_block;        // Pointer to the block data for the segment being executed
     volatile segment_t*  exec_segment;      // Pointer to the segment being executed
+
+    // Raster scanline of the executing block.  raster_acc counts the progress along the
+    // block times the pixel count, so a pixel ends each time it reaches step_event_count.
+    Raster::Scanline* raster;
+    uint16_t          raster_pixel;
+    uint32_t          raster_acc;
+    uint32_t          raster_inc;  // Per ISR tick at the AMASS level of the segment
+
+    // M62/M63 Q events of the executing block.  output_acc counts the progress along the
+    // block in the units of its step_event_count.
+    uint8_t  output_event;  // The next one to fire
+    uint32_t output_acc;
+    uint32_t output_inc;  // Per ISR tick at the AMASS level of the segment
+
+    AxisMask uncounted_outbits;  // Backlash take-up pulses among step_outbits
+
+    bool     sync_wait;     // Holding the first segment of a synchronized run for the index
+    uint32_t sync_indexes;  // Index pulses counted when the wait began
 } stepper_t;
 static stepper_t st;
 
-// Step segment ring buffer indices
-static volatile uint32_t segment_buffer_tail;
-static volatile uint32_t segment_buffer_head;
-static uint32_t          segment_next_head;
+// Backlash compensation.  When an axis with backlash reverses, its slack is taken up by
+// extra step pulses that do not change its position.  They are sent during the reversing
+// block, between the block's own steps and at up to half the axis maximum rate, instead
+// of as a separate move, so the planner's junction speeds are unaffected.  This state
+// follows the mechanics rather than the motion, so a stepper reset does not clear it.
+struct backlash_t {
+    uint32_t steps[MAX_N_AXIS];    // Backlash of each axis in steps, 0 if none
+    uint32_t period[MAX_N_AXIS];   // Least timer ticks between take-up pulses
+    uint32_t pending[MAX_N_AXIS];  // Take-up pulses still to be sent
+    uint32_t elapsed[MAX_N_AXIS];  // Timer ticks since the last take-up pulse
+    AxisMask dir;                  // Direction of the last motion of each axis, as in direction_bits
+    AxisMask active;               // Axes with take-up pulses pending
+};
+static backlash_t backlash;
+
+// Called as a block starts executing
+static inline void IRAM_ATTR backlash_block(volatile st_block_t* block, size_t n_axis) {
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        AxisMask bit = bitnum_to_mask(axis);
+        if (!block->steps[axis] || !((block->direction_bits ^ backlash.dir) & bit)) {
+            continue;
+        }
+        backlash.dir ^= bit;
+        if (!backlash.steps[axis]) {
+            continue;
+        }
+        // Homing re-references the axis with the slack taken up by its last move.
+        // Otherwise the slack taken up in the old direction has to be taken up again.
+        backlash.pending[axis] = sys.state == State::Homing ? 0 : backlash.steps[axis] - backlash.pending[axis];
+        backlash.elapsed[axis] = backlash.period[axis];
+        if (backlash.pending[axis]) {
+            backlash.active |= bit;
+        } else {
+            backlash.active &= ~bit;
+        }
+    }
+}
+
+// Called for each step event, after the Bresenham steps of the event are known
+static inline void IRAM_ATTR backlash_take_up(size_t n_axis) {
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        AxisMask bit = bitnum_to_mask(axis);
+        if (!(backlash.active & bit) || !st.exec_block->steps[axis]) {
+            continue;
+        }
+        backlash.elapsed[axis] += st.isr_period;
+        if (backlash.elapsed[axis] >= backlash.period[axis] && !(st.step_outbits & bit)) {
+            st.step_outbits |= bit;
+            st.uncounted_outbits |= bit;
+            backlash.elapsed[axis] = 0;
+            if (--backlash.pending[axis] == 0) {
+                backlash.active &= ~bit;
+            }
+        }
+    }
+}
+
+// Spindle synchronized motion, G33.  A run of consecutive synchronized blocks starts when
+// the ISR, holding the run's first segment, sees a spindle index pulse.  From then on the
+// spindle position is counted in revolutions from the encoder count at that pulse, and
+// prep_buffer() sets the speed of each segment so that the travel along the run keeps up
+// with the spindle.  A feed hold ends the run; what is left of the block after the resume
+// runs at its nominal feed rate, unsynchronized.
+struct sync_t {
+    Spindles::SpindleEncoder* encoder;
+    volatile bool             started;  // The ISR has seen the index pulse that starts the run
+    volatile int32_t          anchor;   // The encoder count at that pulse
+    float                     dir;      // 1, or -1 if the run started in M4, when the count runs down
+};
+static sync_t sync;
+
+// Segments queued ahead of a synchronized move.  This bounds how late the motion can
+// respond to a change of spindle speed.
+const uint32_t syncLeadSegments = 4;
+
+// Called for each ISR tick while sync_wait is set.  Returns true when the run may start.
+static inline bool IRAM_ATTR sync_begin() {
+    if (sync.encoder->indexes() == st.sync_indexes && !sys.step_control.executeHold) {
+        return false;
+    }
+    sync.anchor  = sync.encoder->index_counts();
+    sync.started = true;
+    st.sync_wait = false;
+    return true;
+}
+
+// Step segment ring buffer indices. The ring has a single producer, prep_buffer(), and a single
+// consumer, pulse_func(), which may run on different cores. Each index is written only by its
+// owner; the release store after filling or draining a segment, paired with the acquire load on
+// the other side, makes the segment contents visible before the index that hands it over.
+static std::atomic<uint32_t> segment_buffer_tail;  // Written by pulse_func()
+static std::atomic<uint32_t> segment_buffer_head;  // Written by prep_buffer()
+static uint32_t              segment_next_head;    // Private to prep_buffer()
+
+// True while prep_buffer() owes more segments to the current motion, so that an empty ring
+// seen by pulse_func() is an underrun rather than the end of the motion.
+static std::atomic<bool> prep_in_motion;
+
+// The optional segment prep task, and the lock that keeps it out while the main loop changes
+// what prep_buffer() works on.
+static TaskHandle_t      prep_task_handle = nullptr;
+static SemaphoreHandle_t prep_mutex       = nullptr;
+
+// Ring statistics, updated by pulse_func() while prep_in_motion is set.
+static uint32_t underrun_count = 0;           // ISR found the ring empty mid-motion
+static uint32_t low_water_mark = UINT32_MAX;  // Fewest segments queued when the ISR took one
 
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t*        pl_block;       // Pointer to the planner block being prepped
+static plan_speed_t*        pl_speed;       // Its speed fields, valid while pl_block is set
 static volatile st_block_t* st_prep_block;  // Pointer to the stepper block data being prepped
 
 // Segment preparation data struct. Contains all the necessary information to compute new segments
@@ -96,15 +283,13 @@ typedef struct {
     uint8_t  st_block_index;  // Index of stepper common data block being prepped
     PrepFlag recalculate_flag;
 
-    float dt_remainder;
-    float steps_remaining;
-    float step_per_mm;
-    float req_mm_increment;
+    SegmentSteps::Quantizer steps;  // Steps and timing of the block left to prep
+    float                   step_per_mm;
+    float                   req_mm_increment;
 
-    uint8_t last_st_block_index;
-    float   last_steps_remaining;
-    float   last_step_per_mm;
-    float   last_dt_remainder;
+    uint8_t                        last_st_block_index;
+    SegmentSteps::Quantizer::State last_steps;
+    float                          last_step_per_mm;
 
     uint8_t ramp_type;    // Current segment ramp state
     float   mm_complete;  // End of velocity profile from end of current planner block in (mm).
@@ -115,12 +300,37 @@ typedef struct {
     float accelerate_until;  // Acceleration ramp end measured from end of block (mm)
     float decelerate_after;  // Deceleration ramp start measured from end of block (mm)
 
+    float      jerk;    // Jerk limit of the executing profile (mm/min^3). Zero for linear ramps.
+    SCurveRamp scurve;  // Jerk-limited shape of the current acceleration or deceleration ramp
+
+    InputShaper::Impulses shaper;  // Input shaper of the axis that dominates the prepped block
+
     float        inv_rate;  // Used by PWM laser mode to speed up segment calculations.
     SpindleSpeed current_spindle_speed;
 
+    uint64_t dwell_ticks;  // Timer ticks left in the dwell block being prepped
+
+    // Spindle synchronized run being prepped, see sync_t.  Positions along the run are
+    // in spindle revolutions, signed by the direction of the spindle when it started.
+    bool  sync_active;
+    float sync_start_rev;   // Position at the start of the prepped block
+    float sync_block_revs;  // Revolutions the prepped block spans
+    float sync_sign;        // 1, or -1 after the spindle reversed for G33.1
+    float sync_block_mm;    // Length of the prepped block
+
+    // Arc block being prepped, see prep_arc_chord()
+    bool  arc_block_used;  // st_prep_block has a segment, so the next chord needs a block of its own
+    float arc_ticks;       // Timer ticks of the last chord's partial tick, carried into the next
+    float arc_max_mm;      // Longest segment whose chord is within arc_tolerance_mm of the arc
+
+    CoolantState coolant;  // Of the last block of the program that was prepped
+
 } st_prep_t;
 static st_prep_t prep;
 
+// Unshaped speeds of the recently prepped segments, for the input shaper
+static InputShaper::SpeedHistory shaper_history;
+
 /* "The Stepper Driver Interrupt" - This timer interrupt is the workhorse, employing
    the venerable Bresenham line algorithm to manage and exactly synchronize multi-axis moves.
    Unlike the popular DDA algorithm, the Bresenham algorithm is not susceptible to numerical
@@ -193,7 +403,17 @@ uint32_t Stepper::isr_count;  // for debugging only
  * is to keep pulse timing as regular as possible.
  * Returns true if step interrupts should continue
  */
+// The spindle output at this point of the segment, scaled by the raster pixel if any
+static inline uint32_t IRAM_ATTR spindle_output() {
+    uint32_t output = st.spindle_dev_speed;
+    if (st.raster) {
+        output = output * st.raster->pixels[st.raster_pixel] / 255;
+    }
+    return output;
+}
+
 bool IRAM_ATTR Stepper::pulse_func() {
+    StepProfile::Scope profile(StepProfile::PulseFunc);
 #ifdef DEBUG_STEPPER_ISR
     isr_count++;
 #endif
@@ -201,29 +421,69 @@ bool IRAM_ATTR Stepper::pulse_func() {
     if (!awake) {
         return false;
     }
+    if (Machine::ControlPin::halt_requested()) {
+        stop_stepping();
+        return false;
+    }
     auto n_axis = Axes::_numberAxis;
 
-    Stepping::step(st.step_outbits, st.dir_outbits);
-    st.step_outbits = 0;
+    Stepping::step(st.step_outbits, st.dir_outbits, st.uncounted_outbits);
+    st.step_outbits      = 0;
+    st.uncounted_outbits = 0;
+
+    if (st.run_timer) {
+        // The last call set the timer for a run; return to the period of the segment
+        st.run_timer = false;
+        Stepping::setTimerPeriod(st.isr_period);
+    }
+
+    // The step timer also times the limit switch debounce
+    Machine::LimitPin::debounce();
 
     // If there is no step segment, attempt to pop one from the stepper buffer
     if (st.exec_segment == NULL) {
         // Anything in the buffer? If so, load and initialize next step segment.
-        if (segment_buffer_head != segment_buffer_tail) {
+        uint32_t tail = segment_buffer_tail.load(std::memory_order_relaxed);
+        uint32_t head = segment_buffer_head.load(std::memory_order_acquire);
+        if (head != tail) {
+            if (prep_in_motion.load(std::memory_order_relaxed)) {
+                uint32_t queued = head >= tail ? head - tail : head + Stepping::_segments - tail;
+                if (queued < low_water_mark) {
+                    low_water_mark = queued;
+                }
+            }
             // Initialize new step segment and load number of steps to execute
-            st.exec_segment = &segment_buffer[segment_buffer_tail];
+            st.exec_segment = &segment_buffer[tail];
             // Initialize step segment timing per step and load number of steps to execute.
             Stepping::setTimerPeriod(st.exec_segment->isrPeriod);
+            st.isr_period = st.exec_segment->isrPeriod;
             st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
             // If the new segment starts a new planner block, initialize stepper variables and counters.
             // NOTE: When the segment data index changes, this indicates a new planner block.
             if (st.exec_block_index != st.exec_segment->st_block_index) {
                 st.exec_block_index = st.exec_segment->st_block_index;
                 st.exec_block       = &st_block_buffer[st.exec_block_index];
+                st.raster           = st.exec_block->raster;
+                st.raster_pixel     = 0;
+                st.raster_acc       = 0;
+                st.output_event     = 0;
+                st.output_acc       = 0;
                 // Initialize Bresenham line and distance counters
                 for (int axis = 0; axis < n_axis; axis++) {
                     st.counter[axis] = st.exec_block->step_event_count >> 1;
                 }
+                if (st.exec_block->outputs_mask) {
+                    Machine::UserOutputs::writeMask(st.exec_block->outputs_mask, st.exec_block->outputs_on);
+                }
+                if (st.exec_block->coolant_sync) {
+                    config->_coolant->sync_write(st.exec_block->coolant);
+                }
+                backlash_block(st.exec_block, n_axis);
+                if (st.exec_block->sync_start) {
+                    st.sync_wait    = true;
+                    st.sync_indexes = sync.encoder->indexes();
+                }
+                TRACE_POINT(Stepped, st.exec_block->trace_id);
             }
 
             st.dir_outbits = st.exec_block->direction_bits;
@@ -231,10 +491,36 @@ bool IRAM_ATTR Stepper::pulse_func() {
             for (int axis = 0; axis < n_axis; axis++) {
                 st.steps[axis] = st.exec_block->steps[axis] >> st.exec_segment->amass_level;
             }
+            // An axis steps at every event when its steps equal the event count, which
+            // happens only at AMASS level 0.  Runs skip the per-event work of rasters, laser
+            // power, probing and homing, so they are not used then.
+            st.run_mask = 0;
+            if (!st.raster && !st.exec_segment->spindle_dev_slope && st.output_event == st.exec_block->n_output_events && !probing &&
+                sys.state != State::Homing && !backlash.active) {
+                uint32_t event_count = st.exec_block->step_event_count;
+                for (int axis = 0; axis < n_axis; axis++) {
+                    if (st.steps[axis] == event_count) {
+                        set_bitnum(st.run_mask, axis);
+                    } else if (st.steps[axis]) {
+                        st.run_mask = 0;
+                        break;
+                    }
+                }
+            }
+            if (st.raster) {
+                st.raster_inc = uint32_t(st.raster->count) << (maxAmassLevel - st.exec_segment->amass_level);
+            }
+            st.output_inc = 1 << (maxAmassLevel - st.exec_segment->amass_level);
             // Set real-time spindle output as segment is loaded, just prior to the first step.
-            spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
+            st.spindle_dev_speed = st.exec_segment->spindle_dev_speed;
+            st.spindle_output    = spindle_output();
+            spindle->setSpeedfromISR(st.spindle_output);
+            MotorDrivers::Servo::update_segment();
         } else {
             // Segment buffer empty. Shutdown.
+            if (prep_in_motion.load(std::memory_order_relaxed)) {
+                ++underrun_count;
+            }
             stop_stepping();
             if (!state_is(State::Jog)) {  // added to prevent ... jog after probing crash
                 // Ensure pwm is set properly upon completion of rate-controlled motion.
@@ -250,26 +536,115 @@ bool IRAM_ATTR Stepper::pulse_func() {
         }
     }
 
-    for (int axis = 0; axis < n_axis; axis++) {
-        // Execute step displacement profile by Bresenham line algorithm
-        st.counter[axis] += st.steps[axis];
-        if (st.counter[axis] > st.exec_block->step_event_count) {
-            set_bitnum(st.step_outbits, axis);
-            st.counter[axis] -= st.exec_block->step_event_count;
+    if (st.sync_wait && !sync_begin()) {
+        Stepping::unstep();
+        return true;  // Keep ticking at the segment period until the index pulse
+    }
+
+    // Execute step displacement profile by Bresenham line algorithm, unrolled for the axis count
+    uint32_t step_event_count = st.exec_block->step_event_count;
+    with_axis_count<MAX_N_AXIS>(n_axis, [&](auto n) __attribute__((always_inline)) {
+        for (size_t axis = 0; axis < n; axis++) {
+            st.counter[axis] += st.steps[axis];
+            if (st.counter[axis] > step_event_count) {
+                set_bitnum(st.step_outbits, axis);
+                st.counter[axis] -= step_event_count;
+            }
+        }
+    });
+
+    if (backlash.active) {
+        backlash_take_up(n_axis);
+    }
+
+    // When the same axes step at every event, let the engine pulse the rest of the segment.
+    // The first pulse of the run is this event's, and the next call comes after the last.
+    if (st.run_mask && st.step_count > 2) {
+        uint32_t run = Stepping::maxRun(st.isr_period);
+        if (run > st.step_count) {
+            run = st.step_count;
+        }
+        if (run > 2) {
+            Stepping::stepRun(st.step_outbits, st.dir_outbits, run, st.isr_period);
+            Stepping::setTimerPeriod(st.isr_period * run);
+            st.step_outbits = 0;
+            st.step_count -= run - 1;  // The decrement below counts this event
+            st.run_timer = true;
+        }
+    }
+
+    if (st.raster) {
+        st.raster_acc += st.raster_inc;
+        while (st.raster_acc >= st.exec_block->step_event_count) {
+            st.raster_acc -= st.exec_block->step_event_count;
+            if (++st.raster_pixel == st.raster->count) {
+                // This is the last step of the block
+                Raster::release(st.raster);
+                st.raster = nullptr;
+                break;
+            }
+        }
+    }
+
+    if (st.output_event < st.exec_block->n_output_events) {
+        st.output_acc += st.output_inc;
+        while (st.output_event < st.exec_block->n_output_events && st.output_acc >= st.exec_block->output_events[st.output_event].step) {
+            auto& event = st.exec_block->output_events[st.output_event++];
+            Machine::UserOutputs::writeMask(event.mask, event.on);
         }
     }
 
     st.step_count--;  // Decrement step events count
     if (st.step_count == 0) {
         // Segment is complete. Discard current segment and advance segment indexing.
-        st.exec_segment     = NULL;
-        segment_buffer_tail = segment_buffer_tail >= (Stepping::_segments - 1) ? 0 : segment_buffer_tail + 1;
+        st.exec_segment = NULL;
+        uint32_t tail   = segment_buffer_tail.load(std::memory_order_relaxed);
+        segment_buffer_tail.store(tail >= (Stepping::_segments - 1) ? 0 : tail + 1, std::memory_order_release);
+    } else if (st.exec_segment->spindle_dev_slope || st.raster) {
+        if (st.exec_segment->spindle_dev_slope) {
+            // Laser power follows the velocity between segment loads
+            int32_t done         = st.exec_segment->n_step - st.step_count;
+            st.spindle_dev_speed = st.exec_segment->spindle_dev_speed + ((st.exec_segment->spindle_dev_slope * done) >> 8);
+        }
+        uint32_t output = spindle_output();
+        if (output != st.spindle_output) {
+            st.spindle_output = output;
+            spindle->setSpeedfromISR(output);
+        }
     }
 
     Stepping::unstep();
     return true;
 }
 
+// The Bresenham counter of an axis starts at half of step_event_count and steps when it passes
+// step_event_count, so after an ISR tick the ideal position of the axis at the next tick is
+// the steps already taken, plus a pending step, plus (counter - step_event_count/2) steps.
+// Backing that off by the part of the tick interval that is still to come gives the ideal
+// position at the given time, to a fraction of a step.  It is computed in fixed point
+// because floating point is not usable in an ISR.
+void IRAM_ATTR Stepper::latch_position(uint32_t ticks, int32_t* steps, int32_t* substeps) {
+    auto n_axis = Axes::_numberAxis;
+    for (int axis = 0; axis < n_axis; axis++) {
+        steps[axis]    = Stepping::getSteps(axis);
+        substeps[axis] = 0;
+    }
+    if (!awake || st.exec_block == NULL || st.isr_period == 0) {
+        return;
+    }
+    int64_t event_count = st.exec_block->step_event_count;
+    int64_t to_come     = ticks < st.isr_period ? ((int64_t)(st.isr_period - ticks) << 16) / st.isr_period : 0;
+    for (int axis = 0; axis < n_axis; axis++) {
+        int64_t fraction = ((int64_t)st.counter[axis] - (event_count >> 1)) * 65536;
+        fraction -= to_come * st.steps[axis];
+        fraction /= event_count;
+        if (bitnum_is_true(st.step_outbits, axis)) {
+            fraction += 65536;
+        }
+        substeps[axis] = bitnum_is_true(st.dir_outbits, axis) ? -fraction : fraction;
+    }
+}
+
 // enabled. Startup init and limits call this function but shouldn't start the cycle.
 void Stepper::wake_up() {
     if (awake) {
@@ -283,53 +658,221 @@ void Stepper::wake_up() {
 
     // Enable Stepping Driver Interrupt
     Stepping::startTimer();
+    if (SyncLink::leading) {
+        SyncLink::send_start();
+    }
+
+    if (prep_task_handle) {
+        xTaskNotifyGive(prep_task_handle);
+    }
+}
+
+Stepper::PrepLock::PrepLock() {
+    if (prep_mutex) {
+        xSemaphoreTakeRecursive(prep_mutex, portMAX_DELAY);
+    }
+}
+
+Stepper::PrepLock::~PrepLock() {
+    if (prep_mutex) {
+        xSemaphoreGiveRecursive(prep_mutex);
+    }
+}
+
+// Refills the segment buffer while the steppers run. The period is half of a segment, so
+// the buffer never drops by more than one segment between refills.
+static void prep_task(void*) {
+    TickType_t period = pdMS_TO_TICKS(500 / Stepping::_accelerationTicks);
+    if (period == 0) {
+        period = 1;
+    }
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, period);
+        Machine::ControlPin::start_pending_hold();
+        if (awake) {
+            Stepper::prep_buffer();
+        }
+    }
+}
+
+void Stepper::start_prep_task() {
+    if (!Stepping::_prepTask || prep_task_handle) {
+        return;
+    }
+    prep_mutex = xSemaphoreCreateRecursiveMutex();
+    if (Machine::Tasks::create("prep", prep_task, nullptr, &prep_task_handle) == pdPASS) {
+        log_info("Segment prep task on core " << xTaskGetAffinity(prep_task_handle));
+    }
+}
+
+bool IRAM_ATTR Stepper::wake_prep_task_from_ISR() {
+    if (!prep_task_handle) {
+        return false;
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(prep_task_handle, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+    return true;
 }
 
 void Stepper::go_idle() {
     awake = false;
     stop_stepping();
     protocol_disable_steppers();
+    shaper_history.reset();
 }
 
 // Reset and clear stepper subsystem variables
 void Stepper::reset() {
+    PrepLock lock;
+
     // Initialize Stepping driver idle state.
     Stepping::reset();
+    Machine::ControlPin::cancel_halt();
 
     go_idle();
 
     // Initialize stepper algorithm variables.
     memset(&prep, 0, sizeof(st_prep_t));
     memset(&st, 0, sizeof(stepper_t));
-    st.exec_segment     = NULL;
-    pl_block            = NULL;  // Planner block pointer used by segment buffer
-    segment_buffer_tail = 0;
-    segment_buffer_head = 0;  // empty = tail
-    segment_next_head   = 1;
-    st.step_outbits     = 0;
-    st.dir_outbits      = 0;  // Initialize direction bits to default.
+    memset(&sync, 0, sizeof(sync_t));
+    st.exec_segment = NULL;
+    pl_block        = NULL;  // Planner block pointer used by segment buffer
+    segment_buffer_tail.store(0, std::memory_order_relaxed);
+    segment_buffer_head.store(0, std::memory_order_relaxed);  // empty = tail
+    segment_next_head = 1;
+    prep_in_motion.store(false, std::memory_order_relaxed);
+    st.step_outbits = 0;
+    st.dir_outbits  = 0;  // Initialize direction bits to default.
     // TODO do we need to turn step pins off?
+
+    if (SyncLink::leading) {
+        SyncLink::send_reset();
+    }
 }
 
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 bool Stepper::update_plan_block_parameters() {
+    PrepLock lock;
     if (pl_block != NULL) {  // Ignore if at start of a new block.
         prep.recalculate_flag.recalculate = 1;
-        pl_block->entry_speed_sqr         = prep.current_speed * prep.current_speed;  // Update entry speed.
+        pl_speed->entry_speed_sqr         = prep.current_speed * prep.current_speed;  // Update entry speed.
         pl_block                          = NULL;  // Flag prep_segment() to load and check active velocity profile.
         return true;
     }
     return false;
 }
 
+// Keeps the segment the ISR is executing and the one after it, which it may load at any
+// moment; the ISR cannot get past those in less than a segment time.  Only segments of the
+// block being prepped are taken back, since earlier blocks are gone from the planner.  Input
+// shaping keeps a history of the prepped speeds that cannot be taken back, so a shaped block
+// is left alone, as are dwells and parking motions.  A sync link follower already has the
+// segments, so nothing is taken back while leading one.
+uint32_t Stepper::truncate_segments() {
+    PrepLock lock;
+    if (SyncLink::leading || pl_block == NULL || pl_block->dwell_us || prep.shaper.count || prep.recalculate_flag.parking ||
+        sys.step_control.executeSysMotion) {
+        return 0;
+    }
+    const uint32_t n_segments = Stepping::_segments;
+    auto           next       = [n_segments](uint32_t index) { return index + 1 == n_segments ? 0 : index + 1; };
+    auto           prev       = [n_segments](uint32_t index) { return (index == 0 ? n_segments : index) - 1; };
+
+    static portMUX_TYPE truncate_mux = portMUX_INITIALIZER_UNLOCKED;
+    portENTER_CRITICAL(&truncate_mux);  // Not preempted between reading the tail and moving the head
+    uint32_t head   = segment_buffer_head.load(std::memory_order_relaxed);
+    uint32_t tail   = segment_buffer_tail.load(std::memory_order_acquire);
+    uint32_t queued = head >= tail ? head - tail : head + n_segments - tail;
+    uint32_t first  = head;
+    if (queued > 2) {
+        uint32_t keep = next(next(tail));
+        while (first != keep && segment_buffer[prev(first)].st_block_index == prep.st_block_index) {
+            first = prev(first);
+        }
+    }
+    if (first != head) {
+        segment_buffer_head.store(first, std::memory_order_release);
+        segment_next_head = next(first);
+    }
+    portEXIT_CRITICAL(&truncate_mux);
+
+    if (first == head) {
+        return 0;
+    }
+    segment_rewind_t* rewind = &segment_rewind[first];
+    pl_speed->millimeters    = rewind->millimeters;
+    prep.steps.state         = rewind->steps;
+    prep.current_speed       = rewind->current_speed;
+    return head >= first ? head - first : head + n_segments - first;
+}
+
+uint32_t Stepper::segments_free() {
+    const uint32_t n_segments = Stepping::_segments;
+    uint32_t       head       = segment_buffer_head.load(std::memory_order_relaxed);
+    uint32_t       tail       = segment_buffer_tail.load(std::memory_order_acquire);
+    uint32_t       queued     = head >= tail ? head - tail : head + n_segments - tail;
+    return n_segments - 1 - queued;
+}
+
+// A new block needs a free segment slot, as in prep_buffer(), so that its index cannot be
+// that of a block which queued segments still refer to.
+bool Stepper::follower_block(const uint32_t* steps, uint32_t step_event_count, AxisMask direction_bits) {
+    PrepLock lock;
+    if (segment_buffer_tail.load(std::memory_order_acquire) == segment_next_head) {
+        return false;
+    }
+    prep.st_block_index = next_block_index(prep.st_block_index);
+    st_prep_block       = &st_block_buffer[prep.st_block_index];
+    for (size_t idx = 0; idx < MAX_N_AXIS; idx++) {
+        st_prep_block->steps[idx] = steps[idx];
+    }
+    st_prep_block->step_event_count     = step_event_count;
+    st_prep_block->direction_bits       = direction_bits;
+    st_prep_block->is_pwm_rate_adjusted = false;
+    st_prep_block->is_pwm_interpolated  = false;
+    st_prep_block->raster               = nullptr;
+    st_prep_block->outputs_mask         = 0;
+    st_prep_block->outputs_on           = 0;
+    st_prep_block->coolant_sync         = false;
+    st_prep_block->n_output_events      = 0;
+    st_prep_block->sync_start           = false;
+#ifdef TRACE_POINTS
+    st_prep_block->trace_id = 0;
+#endif
+    return true;
+}
+
+bool Stepper::follower_segment(uint16_t n_step, uint16_t period, uint8_t amass_level) {
+    PrepLock lock;
+    if (segment_buffer_tail.load(std::memory_order_acquire) == segment_next_head) {
+        return false;
+    }
+    volatile segment_t* segment = &segment_buffer[segment_buffer_head.load(std::memory_order_relaxed)];
+    segment->st_block_index     = prep.st_block_index;
+    segment->n_step             = n_step;
+    segment->isrPeriod          = period;
+    segment->amass_level        = amass_level;
+    segment->spindle_speed      = 0;
+    segment->spindle_dev_speed  = 0;
+    segment->spindle_dev_slope  = 0;
+
+    auto lastseg      = segment_next_head;
+    segment_next_head = segment_next_head >= (Stepping::_segments - 1) ? 0 : segment_next_head + 1;
+    segment_buffer_head.store(lastseg, std::memory_order_release);
+    return true;
+}
+
 // Changes the run state of the step segment buffer to execute the special parking motion.
 void Stepper::parking_setup_buffer() {
+    PrepLock lock;
     // Store step execution data of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
-        prep.last_st_block_index  = prep.st_block_index;
-        prep.last_steps_remaining = prep.steps_remaining;
-        prep.last_dt_remainder    = prep.dt_remainder;
-        prep.last_step_per_mm     = prep.step_per_mm;
+        prep.last_st_block_index = prep.st_block_index;
+        prep.last_steps          = prep.steps.state;
+        prep.last_step_per_mm    = prep.step_per_mm;
     }
     // Set flags to execute a parking motion
     prep.recalculate_flag.parking     = 1;
@@ -339,12 +882,12 @@ void Stepper::parking_setup_buffer() {
 
 // Restores the step segment buffer to the normal run state after a parking motion.
 void Stepper::parking_restore_buffer() {
+    PrepLock lock;
     // Restore step execution data and flags of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         st_prep_block                          = &st_block_buffer[prep.last_st_block_index];
         prep.st_block_index                    = prep.last_st_block_index;
-        prep.steps_remaining                   = prep.last_steps_remaining;
-        prep.dt_remainder                      = prep.last_dt_remainder;
+        prep.steps.state                       = prep.last_steps;
         prep.step_per_mm                       = prep.last_step_per_mm;
         prep.recalculate_flag.holdPartialBlock = 1;
         prep.recalculate_flag.recalculate      = 1;
@@ -362,6 +905,234 @@ static uint8_t next_block_index(uint8_t block_index) {
     return block_index == (Stepping::_segments - 1) ? 0 : block_index;
 }
 
+// True if pl_block changes the coolant from the last block of the program, and the pins
+// can be switched from the step ISR.  Parking and homing switch the coolant themselves,
+// and a jog leaves it as it is.
+static bool prep_coolant() {
+    if (pl_block->motion.systemMotion || pl_block->is_jog) {
+        return false;
+    }
+    bool change  = pl_block->coolant.Mist != prep.coolant.Mist || pl_block->coolant.Flood != prep.coolant.Flood;
+    prep.coolant = pl_block->coolant;
+    return change && config->_coolant->syncable();
+}
+
+// Loads a dwell block from the planner.  A dwell is a run of ISR ticks with no steps; a
+// nonzero step event count keeps the Bresenham counters of pulse_func() from stepping.
+static void prep_dwell_block() {
+    prep.st_block_index = next_block_index(prep.st_block_index);
+    st_prep_block       = &st_block_buffer[prep.st_block_index];
+
+    st_prep_block->direction_bits = pl_block->direction_bits;
+    for (size_t idx = 0; idx < Axes::_numberAxis; idx++) {
+        st_prep_block->steps[idx] = 0;
+    }
+    st_prep_block->step_event_count = 1;
+    st_prep_block->raster           = nullptr;
+    st_prep_block->outputs_mask     = pl_block->outputs_mask;
+    st_prep_block->outputs_on       = pl_block->outputs_on;
+    st_prep_block->coolant_sync     = prep_coolant();
+    st_prep_block->coolant          = pl_block->coolant;
+    st_prep_block->n_output_events  = 0;
+    st_prep_block->sync_start       = false;
+#ifdef TRACE_POINTS
+    st_prep_block->trace_id = pl_block->trace_id;
+#endif
+    TRACE_POINT(Prepped, pl_block->trace_id);
+    // A rate-adjusted laser is off while the machine is stopped, as at the end of any motion.
+    st_prep_block->is_pwm_rate_adjusted = spindle->isRateAdjusted() && pl_block->spindle == SpindleState::Ccw;
+    st_prep_block->is_pwm_interpolated  = false;
+    if (pl_block->spindle == SpindleState::Disable || st_prep_block->is_pwm_rate_adjusted) {
+        prep.current_spindle_speed = 0;
+    } else {
+        prep.current_spindle_speed = pl_block->spindle_speed;
+    }
+    sys.step_control.updateSpindleSpeed = false;
+
+    prep.current_speed = 0.0f;
+    prep.dwell_ticks   = uint64_t(pl_block->dwell_us) * (Machine::Stepping::fStepperTimer / 1000000);
+
+    if (SyncLink::leading) {
+        SyncLink::send_block(st_prep_block->steps, st_prep_block->step_event_count, st_prep_block->direction_bits);
+    }
+}
+
+// Queues the next segment of the dwell block being prepped.  Segments are at most dt_segment
+// long, so a feed hold stops a dwell as promptly as it stops motion.  Returns false if
+// prepping must stop.
+static bool prep_dwell_segment() {
+    if (sys.step_control.executeHold) {
+        // Nothing to decelerate.  The rest of the dwell runs when the cycle resumes.
+        sys.step_control.endMotion = true;
+        prep_in_motion.store(false, std::memory_order_relaxed);
+        if (!(prep.recalculate_flag.parking)) {
+            prep.recalculate_flag.holdPartialBlock = 1;
+        }
+        return false;
+    }
+
+    const uint64_t max_ticks = uint64_t(Machine::Stepping::fStepperTimer * 60 * dt_segment);
+    uint64_t       ticks     = prep.dwell_ticks < max_ticks ? prep.dwell_ticks : max_ticks;
+    uint32_t       n_tick    = uint32_t((ticks + 0xfffe) / 0xffff);  // ISR periods are 16 bits
+    uint32_t       period    = uint32_t(ticks / n_tick);
+
+    volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head.load(std::memory_order_relaxed)];
+    prep_segment->st_block_index     = prep.st_block_index;
+    prep_segment->n_step             = n_tick;
+    prep_segment->isrPeriod          = period;
+    prep_segment->amass_level        = 0;
+    prep_segment->spindle_speed      = prep.current_spindle_speed;
+    prep_segment->spindle_dev_speed  = spindle->mapSpeed(prep.current_spindle_speed);
+    prep_segment->spindle_dev_slope  = 0;
+
+    auto lastseg      = segment_next_head;
+    segment_next_head = segment_next_head >= (Stepping::_segments - 1) ? 0 : segment_next_head + 1;
+    prep_in_motion.store(true, std::memory_order_relaxed);
+    segment_buffer_head.store(lastseg, std::memory_order_release);
+    if (SyncLink::leading) {
+        SyncLink::send_segment(n_tick, period, 0);
+    }
+
+    // Less than a tick per ISR period can be left over; that is well under a microsecond.
+    prep.dwell_ticks -= uint64_t(period) * n_tick;
+    if (prep.dwell_ticks < n_tick) {
+        pl_block = NULL;
+        plan_discard_current_block();
+    }
+    return true;
+}
+
+// Sets up the spindle synchronized run for the block just loaded, or ends the run
+static void prep_sync_block() {
+    if (!pl_block->motion.spindleSync || !spindle->_encoder) {
+        prep.sync_active = false;
+        return;
+    }
+    if (prep.sync_active) {
+        // Continue the run from the end of the last block
+        prep.sync_start_rev += prep.sync_sign * prep.sync_block_revs;
+        if (pl_block->motion.syncReverse) {
+            prep.sync_sign = -prep.sync_sign;
+        }
+    } else {
+        sync.encoder              = spindle->_encoder;
+        sync.started              = false;
+        sync.dir                  = pl_block->spindle == SpindleState::Ccw ? -1.0f : 1.0f;
+        prep.sync_active          = true;
+        prep.sync_start_rev       = 0.0f;
+        prep.sync_sign            = 1.0f;
+        st_prep_block->sync_start = true;
+    }
+    prep.sync_block_mm   = pl_speed->millimeters;
+    prep.sync_block_revs = pl_speed->millimeters / pl_block->sync_pitch;
+}
+
+// The speed at the end of the next dt minutes of a synchronized block, in mm/min.  It is
+// the spindle speed times the pitch, corrected by the distance the prepped motion is
+// behind or ahead of the spindle at the time the segment will end.  Before the run has
+// started, the ISR is still waiting for the index, so there is nothing to correct yet.
+static float sync_speed(float dt, float mm_remaining) {
+    auto  encoder = sync.encoder;
+    float pitch   = pl_block->sync_pitch;
+    float rps     = encoder->revs_per_sec() * sync.dir;
+    float speed   = fabsf(rps) * 60.0f * pitch;
+    if (sync.started) {
+        uint32_t queued = Stepping::_segments - 1 - segments_free();
+        float    ahead  = queued * dt_segment + dt;  // Minutes until the segment ends
+
+        float revs   = sync.dir * float(encoder->counts() - sync.anchor) / encoder->counts_per_rev();
+        float target = prep.sync_sign * (revs + rps * 60.0f * ahead - prep.sync_start_rev) * pitch;
+        speed        = (target - (prep.sync_block_mm - mm_remaining)) / dt;
+    }
+    float dv = pl_speed->acceleration * dt;
+    speed    = std::min(std::max(speed, prep.current_speed - dv), prep.current_speed + dv);
+    // Leave room to slow down to the exit speed
+    speed = std::min(speed, sqrtf(prep.exit_speed * prep.exit_speed + 2.0f * pl_speed->acceleration * mm_remaining));
+    speed = std::min(speed, pl_block->rapid_rate);
+    // At least a step per segment, so that a segment is never stretched to get one
+    return std::max(speed, prep.req_mm_increment / dt_segment);
+}
+
+// Native arcs, see plan_buffer_arc().  The arc block has no Bresenham data of its own.  Each
+// segment is a chord from where the last one ended to the point on the arc where the segment
+// ends, given a stepper block of its own that the ISR runs as a straight line.  The points
+// are found from the distance left in the block, so a feed hold, a replan or a truncation
+// that sets that distance back needs no other state.
+static void prep_arc_block() {
+    const PlanArc* arc    = pl_block->arc;
+    float          radius = hypot_f(arc->start[arc->axis_0] - arc->center[0], arc->start[arc->axis_1] - arc->center[1]);
+    float          plane  = fabsf(arc->angular_travel) * radius / arc->millimeters;
+    float          spm    = std::min(Axes::_axis[arc->axis_0]->_stepsPerMm, Axes::_axis[arc->axis_1]->_stepsPerMm);
+    // A chord is at least 2/pi of the arc it spans, and one of the plane axes moves at least
+    // 1/sqrt(2) of the chord, so a step of that axis takes at most pi/sqrt(2) steps of arc.
+    // mc_arc() keeps the circle large enough that such a distance is less than half of it.
+    prep.step_per_mm = REQ_MM_INCREMENT_SCALAR * plane * spm / 2.2214f;
+    // As in mc_arc(), from the chord of the circle whose midpoint is arc_tolerance_mm inside it
+    float tolerance     = std::min(config->_arcTolerance, radius);
+    prep.arc_max_mm     = 2.0f * sqrtf(tolerance * (2.0f * radius - tolerance)) / plane;
+    prep.arc_block_used = false;
+    prep.arc_ticks      = 0.0f;
+}
+
+// The motor steps of the point mm_left before the end of the arc being prepped
+static void arc_steps(float mm_left, int32_t* steps) {
+    const PlanArc* arc = pl_block->arc;
+    float          mpos[MAX_N_AXIS];
+    plan_arc_point(arc, 1.0f - mm_left / arc->millimeters, mpos);
+    for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
+        steps[axis] = mpos_to_steps(mpos[axis], axis);
+    }
+}
+
+// Sets up the stepper block of the chord from where the last segment of the arc ended to the
+// point mm_left before its end.  Returns the step events of the chord.  If that is zero,
+// nothing is set up.
+static uint16_t prep_arc_chord(float mm_left) {
+    int32_t from[MAX_N_AXIS], to[MAX_N_AXIS];
+    arc_steps(pl_speed->millimeters, from);
+    arc_steps(mm_left, to);
+    auto     n_axis = Axes::_numberAxis;
+    uint32_t events = 0;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        events = std::max(events, uint32_t(labs(to[axis] - from[axis])));
+    }
+    if (events == 0) {
+        return 0;
+    }
+    if (prep.arc_block_used) {
+        // The same as the last chord's, except that outputs switch only as the arc starts
+        volatile st_block_t* last           = st_prep_block;
+        prep.st_block_index                 = next_block_index(prep.st_block_index);
+        st_prep_block                       = &st_block_buffer[prep.st_block_index];
+        st_prep_block->is_pwm_rate_adjusted = last->is_pwm_rate_adjusted;
+        st_prep_block->is_pwm_interpolated  = last->is_pwm_interpolated;
+        st_prep_block->raster               = nullptr;
+        st_prep_block->outputs_mask         = 0;
+        st_prep_block->outputs_on           = 0;
+        st_prep_block->coolant_sync         = false;
+        st_prep_block->n_output_events      = 0;
+        st_prep_block->sync_start           = false;
+#ifdef TRACE_POINTS
+        st_prep_block->trace_id = last->trace_id;
+#endif
+    }
+    prep.arc_block_used = true;
+
+    st_prep_block->direction_bits = 0;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        int32_t delta              = to[axis] - from[axis];
+        st_prep_block->steps[axis] = uint32_t(labs(delta)) << maxAmassLevel;
+        if (delta < 0) {
+            st_prep_block->direction_bits |= bitnum_to_mask(axis);
+        }
+    }
+    st_prep_block->step_event_count = events << maxAmassLevel;
+    if (SyncLink::leading) {
+        SyncLink::send_block(st_prep_block->steps, st_prep_block->step_event_count, st_prep_block->direction_bits);
+    }
+    return uint16_t(events);
+}
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -376,12 +1147,17 @@ static uint8_t next_block_index(uint8_t block_index) {
    NOTE: Computation units are in steps, millimeters, and minutes.
 */
 void Stepper::prep_buffer() {
+    PrepLock lock;
+
     // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
     if (sys.step_control.endMotion) {
         return;
     }
 
-    while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+    // Check if we need to fill the buffer.
+    while (segment_buffer_tail.load(std::memory_order_acquire) != segment_next_head) {
+        StepProfile::Scope profile(StepProfile::PrepSegment);
+
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -392,11 +1168,21 @@ void Stepper::prep_buffer() {
             }
 
             if (pl_block == NULL) {
+                prep_in_motion.store(false, std::memory_order_relaxed);
                 return;  // No planner blocks. Exit.
             }
+            pl_speed = plan_get_block_speed(pl_block);
 
             // Check if we need to only recompute the velocity profile or load a new block.
-            if (prep.recalculate_flag.recalculate) {
+            if (pl_block->dwell_us) {
+                if (prep.recalculate_flag.recalculate) {
+                    // Resuming after a feed hold; the remaining ticks are still in prep.
+                    prep.recalculate_flag = {};
+                } else {
+                    prep_dwell_block();
+                }
+                continue;  // A dwell has no velocity profile
+            } else if (prep.recalculate_flag.recalculate) {
                 if (prep.recalculate_flag.parking) {
                     prep.recalculate_flag.recalculate = 0;
                 } else {
@@ -420,31 +1206,75 @@ void Stepper::prep_buffer() {
                     st_prep_block->steps[idx] = pl_block->steps[idx] << maxAmassLevel;
                 }
                 st_prep_block->step_event_count = pl_block->step_event_count << maxAmassLevel;
+                st_prep_block->raster           = pl_block->raster;
+                st_prep_block->outputs_mask     = pl_block->outputs_mask;
+                st_prep_block->outputs_on       = pl_block->outputs_on;
+                st_prep_block->coolant_sync     = prep_coolant();
+                st_prep_block->coolant          = pl_block->coolant;
+                st_prep_block->n_output_events  = pl_block->n_output_events;
+                for (idx = 0; idx < pl_block->n_output_events; idx++) {
+                    const OutputEvent& event               = pl_block->output_events[idx];
+                    st_prep_block->output_events[idx].step = event.step << maxAmassLevel;
+                    st_prep_block->output_events[idx].mask = event.mask;
+                    st_prep_block->output_events[idx].on   = event.on;
+                }
+#ifdef TRACE_POINTS
+                st_prep_block->trace_id = pl_block->trace_id;
+#endif
+                TRACE_POINT(Prepped, pl_block->trace_id);
+                if (SyncLink::leading && !pl_block->arc) {  // An arc sends each chord
+                    SyncLink::send_block(st_prep_block->steps, st_prep_block->step_event_count, st_prep_block->direction_bits);
+                }
+
+                // The resonance that matters most is that of the axis that moves the farthest.
+                Machine::Axis* dominant = nullptr;
+                float          max_mm   = 0.0f;
+                for (idx = 0; idx < n_axis; idx++) {
+                    auto  axis = Axes::_axis[idx];
+                    float mm   = pl_block->steps[idx] / axis->_stepsPerMm;
+                    if (mm > max_mm) {
+                        max_mm   = mm;
+                        dominant = axis;
+                    }
+                }
+                if (!dominant && pl_block->arc) {
+                    dominant = Axes::_axis[pl_block->arc->axis_0];  // A full circle ends where it started
+                }
+                prep.shaper = dominant ? InputShaper::impulses(dominant->_shaperType, dominant->_shaperFreq, SHAPER_DAMPING_RATIO)
+                                       : InputShaper::Impulses();
 
                 // Initialize segment buffer data for generating the segments.
-                prep.steps_remaining  = (float)pl_block->step_event_count;
-                prep.step_per_mm      = prep.steps_remaining / pl_block->millimeters;
+                if (pl_block->arc) {
+                    prep_arc_block();
+                } else {
+                    prep.steps.begin(pl_block->step_event_count);  // Reset for new segment block
+                    prep.step_per_mm = (float)pl_block->step_event_count / pl_speed->millimeters;
+                }
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;
-                prep.dt_remainder     = 0.0;  // Reset for new segment block
                 if ((sys.step_control.executeHold) || prep.recalculate_flag.decelOverride) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed                  = prep.exit_speed;
-                    pl_block->entry_speed_sqr           = prep.exit_speed * prep.exit_speed;
+                    pl_speed->entry_speed_sqr           = prep.exit_speed * prep.exit_speed;
                     prep.recalculate_flag.decelOverride = 0;
                 } else {
-                    prep.current_speed = sqrtf(pl_block->entry_speed_sqr);
+                    prep.current_speed = sqrtf(pl_speed->entry_speed_sqr);
                 }
 
                 // prep.inv_rate is only used if is_pwm_rate_adjusted is true
                 st_prep_block->is_pwm_rate_adjusted = false;  // set default value
+                st_prep_block->is_pwm_interpolated  = false;
 
                 if (spindle->isRateAdjusted()) {
                     if (pl_block->spindle == SpindleState::Ccw) {
                         // Pre-compute inverse programmed rate to speed up PWM updating per step segment.
                         prep.inv_rate                       = 1.0f / pl_block->programmed_rate;
                         st_prep_block->is_pwm_rate_adjusted = true;
+                        st_prep_block->is_pwm_interpolated  = spindle->interpolatesPower();
                     }
                 }
+
+                st_prep_block->sync_start = false;
+                prep_sync_block();
             }
             /* ---------------------------------------------------------------------------------
              Compute the velocity profile of a new planner block based on its entry and exit
@@ -453,16 +1283,17 @@ void Stepper::prep_buffer() {
              hold, override the planner velocities and decelerate to the target exit speed.
             */
             prep.mm_complete  = 0.0;  // Default velocity profile complete at 0.0mm from end of block.
-            float inv_2_accel = 0.5f / pl_block->acceleration;
+            float inv_2_accel = 0.5f / pl_speed->acceleration;
             if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
                 // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
                 // the planner block profile, enforcing a deceleration to zero speed.
-                prep.ramp_type = RAMP_DECEL;
+                prep.ramp_type   = RAMP_DECEL;
+                prep.sync_active = false;
                 // Compute decelerate distance relative to end of block.
-                float decel_dist = pl_block->millimeters - inv_2_accel * pl_block->entry_speed_sqr;
+                float decel_dist = pl_speed->millimeters - inv_2_accel * pl_speed->entry_speed_sqr;
                 if (decel_dist < 0.0) {
                     // Deceleration through entire planner block. End of feed hold is not in this block.
-                    prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
+                    prep.exit_speed = sqrtf(pl_speed->entry_speed_sqr - 2 * pl_speed->acceleration * pl_speed->millimeters);
                 } else {
                     prep.mm_complete = decel_dist;  // End of feed hold.
                     prep.exit_speed  = 0.0;
@@ -470,11 +1301,13 @@ void Stepper::prep_buffer() {
             } else {  // [Normal Operation]
                 // Compute or recompute velocity profile parameters of the prepped planner block.
                 prep.ramp_type        = RAMP_ACCEL;  // Initialize as acceleration ramp.
-                prep.accelerate_until = pl_block->millimeters;
+                prep.accelerate_until = pl_speed->millimeters;
                 float exit_speed_sqr;
                 float nominal_speed;
                 if (sys.step_control.executeSysMotion) {
-                    prep.exit_speed = exit_speed_sqr = 0.0;  // Enforce stop at end of system motion.
+                    // Stop at the end of a system motion, unless another is chained to it
+                    exit_speed_sqr  = plan_get_system_motion_exit_speed_sqr();
+                    prep.exit_speed = sqrtf(exit_speed_sqr);
                 } else {
                     exit_speed_sqr  = plan_get_exec_block_exit_speed_sqr();
                     prep.exit_speed = sqrtf(exit_speed_sqr);
@@ -482,15 +1315,15 @@ void Stepper::prep_buffer() {
 
                 nominal_speed            = plan_compute_profile_nominal_speed(pl_block);
                 float nominal_speed_sqr  = nominal_speed * nominal_speed;
-                float intersect_distance = 0.5f * (pl_block->millimeters + inv_2_accel * (pl_block->entry_speed_sqr - exit_speed_sqr));
-                if (pl_block->entry_speed_sqr > nominal_speed_sqr) {  // Only occurs during override reductions.
-                    prep.accelerate_until = pl_block->millimeters - inv_2_accel * (pl_block->entry_speed_sqr - nominal_speed_sqr);
+                float intersect_distance = 0.5f * (pl_speed->millimeters + inv_2_accel * (pl_speed->entry_speed_sqr - exit_speed_sqr));
+                if (pl_speed->entry_speed_sqr > nominal_speed_sqr) {  // Only occurs during override reductions.
+                    prep.accelerate_until = pl_speed->millimeters - inv_2_accel * (pl_speed->entry_speed_sqr - nominal_speed_sqr);
                     if (prep.accelerate_until <= 0.0) {  // Deceleration-only.
                         prep.ramp_type = RAMP_DECEL;
-                        // prep.decelerate_after = pl_block->millimeters;
+                        // prep.decelerate_after = pl_speed->millimeters;
                         // prep.maximum_speed = prep.current_speed;
                         // Compute override block exit speed since it doesn't match the planner exit speed.
-                        prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
+                        prep.exit_speed = sqrtf(pl_speed->entry_speed_sqr - 2 * pl_speed->acceleration * pl_speed->millimeters);
                         prep.recalculate_flag.decelOverride = 1;  // Flag to load next block as deceleration override.
                         // TODO: Determine correct handling of parameters in deceleration-only.
                         // Can be tricky since entry speed will be current speed, as in feed holds.
@@ -502,26 +1335,26 @@ void Stepper::prep_buffer() {
                         prep.ramp_type        = RAMP_DECEL_OVERRIDE;
                     }
                 } else if (intersect_distance > 0.0) {
-                    if (intersect_distance < pl_block->millimeters) {  // Either trapezoid or triangle types
+                    if (intersect_distance < pl_speed->millimeters) {  // Either trapezoid or triangle types
                         // NOTE: For acceleration-cruise and cruise-only types, following calculation will be 0.0.
                         prep.decelerate_after = inv_2_accel * (nominal_speed_sqr - exit_speed_sqr);
                         if (prep.decelerate_after < intersect_distance) {  // Trapezoid type
                             prep.maximum_speed = nominal_speed;
-                            if (pl_block->entry_speed_sqr == nominal_speed_sqr) {
+                            if (pl_speed->entry_speed_sqr == nominal_speed_sqr) {
                                 // Cruise-deceleration or cruise-only type.
                                 prep.ramp_type = RAMP_CRUISE;
                             } else {
                                 // Full-trapezoid or acceleration-cruise types
-                                prep.accelerate_until -= inv_2_accel * (nominal_speed_sqr - pl_block->entry_speed_sqr);
+                                prep.accelerate_until -= inv_2_accel * (nominal_speed_sqr - pl_speed->entry_speed_sqr);
                             }
                         } else {  // Triangle type
                             prep.accelerate_until = intersect_distance;
                             prep.decelerate_after = intersect_distance;
-                            prep.maximum_speed    = sqrtf(2.0f * pl_block->acceleration * intersect_distance + exit_speed_sqr);
+                            prep.maximum_speed    = sqrtf(2.0f * pl_speed->acceleration * intersect_distance + exit_speed_sqr);
                         }
                     } else {  // Deceleration-only type
                         prep.ramp_type = RAMP_DECEL;
-                        // prep.decelerate_after = pl_block->millimeters;
+                        // prep.decelerate_after = pl_speed->millimeters;
                         // prep.maximum_speed = prep.current_speed;
                     }
                 } else {  // Acceleration-only type
@@ -529,53 +1362,88 @@ void Stepper::prep_buffer() {
                     // prep.decelerate_after = 0.0;
                     prep.maximum_speed = prep.exit_speed;
                 }
+                if (prep.sync_active) {
+                    prep.ramp_type = RAMP_SYNC;  // The spindle sets the speed instead
+                }
+            }
+
+            // Shape the first ramp of the profile when the block is jerk limited. Feed holds and
+            // deceleration overrides keep their linear ramps, since they must stop or slow down
+            // within the distances computed above.
+            prep.jerk = sys.step_control.executeHold ? 0.0f : pl_block->jerk;
+            if (prep.ramp_type == RAMP_ACCEL) {
+                prep.scurve.begin(prep.current_speed, prep.maximum_speed, pl_speed->millimeters - prep.accelerate_until, prep.jerk);
+            } else if (prep.ramp_type == RAMP_DECEL) {
+                prep.scurve.begin(prep.current_speed, prep.exit_speed, pl_speed->millimeters - prep.mm_complete, prep.jerk);
+            } else {
+                prep.scurve.begin(0.0f, 0.0f, 0.0f, 0.0f);
             }
 
             sys.step_control.updateSpindleSpeed = true;  // Force update whenever updating block.
         }
 
+        if (pl_block->dwell_us) {
+            if (!prep_dwell_segment()) {
+                return;
+            }
+            continue;
+        }
+
+        if (prep.ramp_type == RAMP_SYNC && Stepping::_segments - 1 - segments_free() >= syncLeadSegments) {
+            return;  // Stay close behind the spindle
+        }
+
         // Initialize new segment
-        volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+        volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head.load(std::memory_order_relaxed)];
 
         // Set new segment to point to the current segment data block.
         prep_segment->st_block_index = prep.st_block_index;
 
         /*------------------------------------------------------------------------------------
             Compute the average velocity of this new segment by determining the total distance
-          traveled over the segment time DT_SEGMENT. The following code first attempts to create
+          traveled over the segment time dt_segment. The following code first attempts to create
           a full segment based on the current ramp conditions. If the segment time is incomplete
           when terminating at a ramp state change, the code will continue to loop through the
           progressing ramp states to fill the remaining segment execution time. However, if
           an incomplete segment terminates at the end of the velocity profile, the segment is
-          considered completed despite having a truncated execution time less than DT_SEGMENT.
+          considered completed despite having a truncated execution time less than dt_segment.
             The velocity profile is always assumed to progress through the ramp sequence:
           acceleration ramp, cruising state, and deceleration ramp. Each ramp's travel distance
           may range from zero to the length of the block. Velocity profiles can end either at
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
         */
-        float dt_max   = DT_SEGMENT;                                // Maximum segment time
+        float dt_max   = dt_segment;                                // Maximum segment time
+        if (pl_block->arc) {
+            // Shorter segments where the chords would stray from the arc
+            float speed = std::max(prep.current_speed, prep.maximum_speed);
+            if (speed * dt_max > prep.arc_max_mm) {
+                dt_max = prep.arc_max_mm / speed;
+            }
+        }
         float dt       = 0.0;                                       // Initialize segment time
         float time_var = dt_max;                                    // Time worker variable
         float mm_var;                                               // mm-Distance worker variable
         float speed_var;                                            // Speed worker variable
-        float mm_remaining = pl_block->millimeters;                 // New segment distance from end of block.
+        float mm_remaining = pl_speed->millimeters;                 // New segment distance from end of block.
         float minimum_mm   = mm_remaining - prep.req_mm_increment;  // Guarantee at least one step.
 
         if (minimum_mm < 0.0) {
             minimum_mm = 0.0;
         }
 
+        float start_speed = prep.current_speed;  // For laser power interpolation
+
         do {
             switch (prep.ramp_type) {
                 case RAMP_DECEL_OVERRIDE:
-                    speed_var = pl_block->acceleration * time_var;
+                    speed_var = pl_speed->acceleration * time_var;
                     mm_var    = time_var * (prep.current_speed - 0.5f * speed_var);
                     mm_remaining -= mm_var;
                     if ((mm_remaining < prep.accelerate_until) || (mm_var <= 0)) {
                         // Cruise or cruise-deceleration types only for deceleration override.
                         mm_remaining       = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var           = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
+                        time_var           = 2.0f * (pl_speed->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         prep.ramp_type     = RAMP_CRUISE;
                         prep.current_speed = prep.maximum_speed;
                     } else {  // Mid-deceleration override ramp.
@@ -584,21 +1452,33 @@ void Stepper::prep_buffer() {
                     break;
                 case RAMP_ACCEL:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
-                    speed_var = pl_block->acceleration * time_var;
-                    mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
-                    if (mm_remaining < prep.accelerate_until) {  // End of acceleration ramp.
-                        // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    if (prep.scurve.active()) {
+                        // Jerk-limited ramp. advance() shortens time_var to the end of the ramp.
+                        mm_remaining -= prep.scurve.advance(time_var);
+                        if (prep.scurve.active() && mm_remaining > prep.accelerate_until) {
+                            prep.current_speed = prep.scurve.speed();
+                            break;
+                        }
                         mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var     = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
-                        if (mm_remaining == prep.decelerate_after) {
-                            prep.ramp_type = RAMP_DECEL;
-                        } else {
-                            prep.ramp_type = RAMP_CRUISE;
+                    } else {
+                        speed_var = pl_speed->acceleration * time_var;
+                        mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
+                        if (mm_remaining >= prep.accelerate_until) {  // Acceleration only.
+                            prep.current_speed += speed_var;
+                            break;
                         }
-                        prep.current_speed = prep.maximum_speed;
-                    } else {  // Acceleration only.
-                        prep.current_speed += speed_var;
+                        mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
+                        time_var     = 2.0f * (pl_speed->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
+                    }
+                    // End of acceleration ramp.
+                    // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    if (mm_remaining == prep.decelerate_after) {
+                        prep.ramp_type = RAMP_DECEL;
+                        prep.scurve.begin(prep.maximum_speed, prep.exit_speed, mm_remaining - prep.mm_complete, prep.jerk);
+                    } else {
+                        prep.ramp_type = RAMP_CRUISE;
                     }
+                    prep.current_speed = prep.maximum_speed;
                     break;
                 case RAMP_CRUISE:
                     // NOTE: mm_var used to retain the last mm_remaining for incomplete segment time_var calculations.
@@ -610,13 +1490,37 @@ void Stepper::prep_buffer() {
                         time_var       = (mm_remaining - prep.decelerate_after) / prep.maximum_speed;
                         mm_remaining   = prep.decelerate_after;  // NOTE: 0.0 at EOB
                         prep.ramp_type = RAMP_DECEL;
+                        prep.scurve.begin(prep.maximum_speed, prep.exit_speed, mm_remaining - prep.mm_complete, prep.jerk);
                     } else {  // Cruising only.
                         mm_remaining = mm_var;
                     }
                     break;
+                case RAMP_SYNC:
+                    speed_var = sync_speed(time_var, mm_remaining);
+                    mm_var    = 0.5f * (prep.current_speed + speed_var) * time_var;
+                    if (mm_var < mm_remaining) {
+                        mm_remaining -= mm_var;
+                    } else {  // End of block
+                        time_var     = 2.0f * mm_remaining / (prep.current_speed + speed_var);
+                        mm_remaining = 0.0f;
+                    }
+                    prep.current_speed = speed_var;
+                    break;
                 default:  // case RAMP_DECEL:
+                    if (prep.scurve.active()) {
+                        // Jerk-limited ramp. advance() shortens time_var to the end of the ramp.
+                        mm_var = mm_remaining - prep.scurve.advance(time_var);
+                        if (prep.scurve.active() && mm_var > prep.mm_complete) {
+                            mm_remaining       = mm_var;
+                            prep.current_speed = prep.scurve.speed();
+                            break;
+                        }
+                        mm_remaining       = prep.mm_complete;
+                        prep.current_speed = prep.exit_speed;
+                        break;
+                    }
                     // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
-                    speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
+                    speed_var = pl_speed->acceleration * time_var;  // Used as delta speed (mm/min)
                     if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
                         // Compute distance from end of segment to end of block.
                         mm_var = mm_remaining - time_var * (prep.current_speed - 0.5f * speed_var);  // (mm)
@@ -639,7 +1543,7 @@ void Stepper::prep_buffer() {
                 if (mm_remaining > minimum_mm) {  // Check for very slow segments with zero steps.
                     // Increase segment time to ensure at least one step in segment. Override and loop
                     // through distance calculations until minimum_mm or mm_complete.
-                    dt_max += DT_SEGMENT;
+                    dt_max += dt_segment;
                     time_var = dt_max - dt;
                 } else {
                     break;  // **Complete** Exit loop. Segment execution time maxed.
@@ -671,6 +1575,8 @@ void Stepper::prep_buffer() {
         }
         prep_segment->spindle_speed     = prep.current_spindle_speed;
         prep_segment->spindle_dev_speed = spindle->mapSpeed(prep.current_spindle_speed);  // Reload segment PWM value
+        prep_segment->spindle_dev_slope = 0;
+        bool interpolate_power          = st_prep_block->is_pwm_interpolated && pl_block->spindle != SpindleState::Disable;
 
         /* -----------------------------------------------------------------------------------
            Compute segment step rate, steps to execute, and apply necessary rate corrections.
@@ -680,12 +1586,15 @@ void Stepper::prep_buffer() {
            However, since floats have only 7.2 significant digits, long moves with extremely
            high step counts can exceed the precision of floats, which can lead to lost steps.
            Fortunately, this scenario is highly unlikely and unrealistic in typical DIY CNC
-           machines (i.e. exceeding 10 meters axis travel at 200 step/mm).
+           machines (i.e. exceeding 10 meters axis travel at 200 step/mm).  Built with
+           FIXED_POINT_SEGMENTS, the step and time bookkeeping is in fixed point; see SegmentSteps.h.
         */
-        float step_dist_remaining    = prep.step_per_mm * mm_remaining;                       // Convert mm_remaining to steps
-        float n_steps_remaining      = ceilf(step_dist_remaining);                            // Round-up current steps remaining
-        float last_n_steps_remaining = ceilf(prep.steps_remaining);                           // Round-up last steps remaining
-        prep_segment->n_step         = uint16_t(last_n_steps_remaining - n_steps_remaining);  // Compute number of steps to execute.
+        if (pl_block->arc) {
+            prep_segment->n_step         = prep_arc_chord(mm_remaining);
+            prep_segment->st_block_index = prep.st_block_index;
+        } else {
+            prep_segment->n_step = uint16_t(prep.steps.steps(prep.step_per_mm * mm_remaining));  // Whole steps to execute
+        }
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
         if (prep_segment->n_step == 0) {
@@ -693,11 +1602,21 @@ void Stepper::prep_buffer() {
                 // Less than one step to decelerate to zero speed, but already very close. AMASS
                 // requires full steps to execute. So, just bail.
                 sys.step_control.endMotion = true;
+                prep_in_motion.store(false, std::memory_order_relaxed);
                 if (!(prep.recalculate_flag.parking)) {
                     prep.recalculate_flag.holdPartialBlock = 1;
                 }
                 return;  // Segment not generated, but current step data still retained.
             }
+            if (pl_block->arc) {
+                // Only the end of an arc can be within a step of where the last chord ended
+                pl_speed->millimeters = mm_remaining;
+                if (mm_remaining == 0.0f) {
+                    pl_block = NULL;
+                    plan_discard_current_block();
+                }
+                continue;
+            }
         }
 
         // Compute segment step rate. Since steps are integers and mm distances traveled are not,
@@ -709,14 +1628,20 @@ void Stepper::prep_buffer() {
         // typically very small and do not adversely effect performance, but ensures that the
         // system outputs the exact acceleration and velocity profiles computed by the planner.
 
-        dt += prep.dt_remainder;  // Apply previous segment partial step execute time
-        // dt is in minutes so inv_rate is in minutes
-        float inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
-
-        // Compute CPU cycles per step for the prepped segment.
-        // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
-        // timerTicks/sec * 60 sec/minute * minutes = timerTicks
-        uint32_t timerTicks = uint32_t(ceilf((Machine::Stepping::fStepperTimer * 60) * inv_rate));  // (timerTicks/step)
+        // Retime the segment to the shaped speed. This only changes dt, never the steps.
+        dt = shaper_history.shape(prep.shaper, dt, pl_speed->millimeters - mm_remaining);
+
+        // Compute timer ticks per step for the prepped segment, with the previous segment's
+        // partial step time applied.  fStepperTimer is in units of timerTicks/sec and dt is
+        // in minutes, so the dimensional analysis is timerTicks/sec * 60 sec/minute * minutes = timerTicks
+        uint32_t timerTicks;  // (timerTicks/step)
+        if (pl_block->arc) {
+            float ticks    = dt * Machine::Stepping::fStepperTimer * 60.0f + prep.arc_ticks;
+            timerTicks     = uint32_t(ticks / prep_segment->n_step);
+            prep.arc_ticks = ticks - float(timerTicks) * prep_segment->n_step;
+        } else {
+            timerTicks = prep.steps.period(dt, Machine::Stepping::fStepperTimer * 60.0f);
+        }
         int      level;
 
         // Compute step timing and multi-axis smoothing level.
@@ -732,15 +1657,35 @@ void Stepper::prep_buffer() {
         // largest value that will fit in a uint16_t.
         prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
 
+        if (interpolate_power) {
+            // Ramp from the power for the velocity at the start of the segment to the power at its end.
+            // The values are in device units, so the ramp follows the speed map.
+            SpindleSpeed start_spindle_speed = SpindleSpeed(pl_block->spindle_speed * (start_speed * prep.inv_rate));
+            uint32_t     start_dev_speed     = spindle->mapSpeed(start_spindle_speed);
+            int32_t      delta               = int32_t(prep_segment->spindle_dev_speed) - int32_t(start_dev_speed);
+            prep_segment->spindle_dev_slope  = delta * 256 / int32_t(prep_segment->n_step);
+            prep_segment->spindle_dev_speed  = start_dev_speed;
+        }
+
+        segment_rewind_t* rewind = &segment_rewind[segment_buffer_head.load(std::memory_order_relaxed)];
+        rewind->millimeters      = pl_speed->millimeters;
+        rewind->steps            = prep.steps.state;
+        rewind->current_speed    = start_speed;
+
         // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        auto lastseg        = segment_next_head;
-        segment_next_head   = segment_next_head >= (Stepping::_segments - 1) ? 0 : segment_next_head + 1;
-        segment_buffer_head = lastseg;
+        auto lastseg      = segment_next_head;
+        segment_next_head = segment_next_head >= (Stepping::_segments - 1) ? 0 : segment_next_head + 1;
+        prep_in_motion.store(true, std::memory_order_relaxed);
+        segment_buffer_head.store(lastseg, std::memory_order_release);
+        if (SyncLink::leading) {
+            SyncLink::send_segment(prep_segment->n_step, prep_segment->isrPeriod, prep_segment->amass_level);
+        }
 
         // Update the appropriate planner and segment data.
-        pl_block->millimeters = mm_remaining;
-        prep.steps_remaining  = n_steps_remaining;
-        prep.dt_remainder     = (n_steps_remaining - step_dist_remaining) * inv_rate;
+        pl_speed->millimeters = mm_remaining;
+        if (!pl_block->arc) {
+            prep.steps.commit();
+        }
         // Check for exit conditions and flag to load next planner block.
         if (mm_remaining == prep.mm_complete) {
             // End of planner block or forced-termination. No more distance to be executed.
@@ -749,6 +1694,7 @@ void Stepper::prep_buffer() {
                 // the segment queue, where realtime protocol will set new state upon receiving the
                 // cycle stop flag from the ISR. Prep_segment is blocked until then.
                 sys.step_control.endMotion = true;
+                prep_in_motion.store(false, std::memory_order_relaxed);
                 if (!(prep.recalculate_flag.parking)) {
                     prep.recalculate_flag.holdPartialBlock = 1;
                 }
@@ -756,16 +1702,29 @@ void Stepper::prep_buffer() {
             } else {     // End of planner block
                 // The planner block is complete. All steps are set to be executed in the segment buffer.
                 if (sys.step_control.executeSysMotion) {
-                    sys.step_control.endMotion = true;
-                    return;
+                    // Stop, or go on to the system motion chained to this one
+                    if (!plan_next_system_motion()) {
+                        sys.step_control.endMotion = true;
+                        prep_in_motion.store(false, std::memory_order_relaxed);
+                        return;
+                    }
+                } else {
+                    plan_discard_current_block();
                 }
                 pl_block = NULL;  // Set pointer to indicate check and load next planner block.
-                plan_discard_current_block();
             }
         }
     }
 }
 
+uint32_t Stepper::segment_underruns() {
+    return underrun_count;
+}
+
+uint32_t Stepper::segment_low_water() {
+    return low_water_mark == UINT32_MAX ? 0 : low_water_mark;
+}
+
 // Called by realtime status reporting to fetch the current speed being executed. This value
 // however is not exactly the current speed, but the speed computed in the last step segment
 // in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
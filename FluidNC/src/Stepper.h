@@ -10,6 +10,7 @@
 */
 
 #include "EnumItem.h"
+#include "Types.h"  // AxisMask
 
 #include <cstdint>
 
@@ -39,11 +40,54 @@ namespace Stepper {
     // Reloads step segment buffer. Called continuously by realtime execution system.
     void prep_buffer();
 
+    // Starts the segment prep task if stepping/prep_task is set. Call from the core that
+    // runs the step timer.
+    void start_prep_task();
+
+    // Runs the prep task now, for a control pin that asks for a hold.  Returns false
+    // if there is no prep task.
+    bool wake_prep_task_from_ISR();
+
+    // While a PrepLock is held, prep_buffer() cannot run in the prep task.  Code outside the
+    // prep task that changes the planner blocks, or the step control flags that prep_buffer()
+    // reads, must hold one.  It may be nested, and costs nothing without the prep task.
+    class PrepLock {
+    public:
+        PrepLock();
+        ~PrepLock();
+        PrepLock(const PrepLock&)            = delete;
+        PrepLock& operator=(const PrepLock&) = delete;
+    };
+
+    // Called from an ISR to capture the motor position at a time, in step timer ticks, since the
+    // last step timer interrupt.  substeps is the signed offset from steps of the ideal motion
+    // at that time, in 1/65536 step.  Valid only for stepping engines that call pulse_func()
+    // at each step event.
+    void latch_position(uint32_t ticks, int32_t* steps, int32_t* substeps);
+
     // Called by planner_recalculate() when the executing block is updated by the new plan.
     bool update_plan_block_parameters();
 
+    // Discards the queued segments that the ISR has not started, so that a feed hold begins
+    // decelerating within about two segment times instead of after the whole segment buffer.
+    // Call before update_plan_block_parameters().  Returns the number of segments discarded.
+    uint32_t truncate_segments();
+
+    // Queue a sync link leader's blocks and segments on a follower, in place of those that
+    // prep_buffer() makes from the planner, which must be empty.  A segment belongs to the
+    // last block queued.  Both return false if there is no room.  Steps are AMASS scaled.
+    bool     follower_block(const uint32_t* steps, uint32_t step_event_count, AxisMask direction_bits);
+    bool     follower_segment(uint16_t n_step, uint16_t period, uint8_t amass_level);
+    uint32_t segments_free();
+
     // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
     float get_realtime_rate();
 
+    // Number of times the stepper ISR found the segment buffer empty in the middle of a motion,
+    // and the fewest segments that were queued when it took one, since startup.  A low water
+    // mark near zero, or any underruns, mean Stepping::_segments is too small for the load.
+    uint32_t segment_underruns();
+    uint32_t segment_low_water();
+
     extern uint32_t isr_count;
 }
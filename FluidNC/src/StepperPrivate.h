@@ -4,12 +4,12 @@
 #pragma once
 
 // Some useful constants.
-const float DT_SEGMENT              = (1.0f / (float(ACCELERATION_TICKS_PER_SECOND) * 60.0f));  // min/segment
 const float REQ_MM_INCREMENT_SCALAR = 1.25f;
 const int   RAMP_ACCEL              = 0;
 const int   RAMP_CRUISE             = 1;
 const int   RAMP_DECEL              = 2;
 const int   RAMP_DECEL_OVERRIDE     = 3;
+const int   RAMP_SYNC               = 4;  // Spindle synchronized, G33
 
 struct PrepFlag {
     uint8_t recalculate : 1;
@@ -2,12 +2,19 @@
 #include "EnumItem.h"
 #include "Stepping.h"
 #include "Machine/MachineConfig.h"  // config
+#include "StepProfile.h"
 
 #include <atomic>
 
 step_engine_t* step_engines = NULL;  // Linked list of stepping engines
 
 step_engine_t* find_engine(const char* name) {
+    // An engine registered under the exact name takes precedence, e.g. I2S_STREAM
+    for (step_engine_t* p = step_engines; p; p = p->link) {
+        if (strcmp(name, p->name) == 0) {
+            return p;
+        }
+    }
     for (step_engine_t* p = step_engines; p; p = p->link) {
         // Initial substring match, handles different forms of I2S
         if (strncmp(name, p->name, strlen(p->name)) == 0) {
@@ -28,11 +35,16 @@ namespace Machine {
 
     bool   Stepping::_switchedStepper = false;
     size_t Stepping::_segments        = 12;
+    size_t Stepping::_planner_blocks  = 16;
+    bool   Stepping::_prepTask        = false;
+
+    uint32_t Stepping::_accelerationTicks = ACCELERATION_TICKS_PER_SECOND;
 
     uint32_t Stepping::_idleMsecs           = 255;
     uint32_t Stepping::_pulseUsecs          = 4;
     uint32_t Stepping::_directionDelayUsecs = 0;
     uint32_t Stepping::_disableDelayUsecs   = 0;
+    uint32_t Stepping::_enableStaggerUsecs  = 0;
 
     step_engine_t* Stepping::step_engine;
 
@@ -40,18 +52,21 @@ namespace Machine {
                                    { Stepping::RMT_ENGINE, "RMT" },
                                    { Stepping::I2S_STATIC, "I2S_STATIC" },
                                    { Stepping::I2S_STREAM, "I2S_STREAM" },
+                                   { Stepping::RMT_BATCH, "RMT_BATCH" },
+                                   { Stepping::MCPWM_ENGINE, "MCPWM" },
                                    EnumItem(Stepping::RMT_ENGINE) };
 
     void Stepping::afterParse() {
         const char* name = stepTypes[_engine].name;
         step_engine      = find_engine(name);
         Assert(step_engine, "Cannot find stepping engine for %s", name);
-        Assert(strcmp("I2S", name) || config->_i2so, "I2SO bus must be configured for this stepping type");
+        Assert(strncmp("I2S", name, 3) || config->_i2so, "I2SO bus must be configured for this stepping type");
     }
 
     void Stepping::init() {
         log_info("Stepping:" << stepTypes[_engine].name << " Pulse:" << _pulseUsecs << "us Dsbl Delay:" << _disableDelayUsecs
                              << "us Dir Delay:" << _directionDelayUsecs << "us Idle Delay:" << _idleMsecs << "ms");
+        log_info("Segments:" << _segments << " of " << 1000.0f / _accelerationTicks << "ms");
 
         uint32_t actual = step_engine->init(_directionDelayUsecs, _pulseUsecs, fStepperTimer, Stepper::pulse_func);
         if (actual != _pulseUsecs) {
@@ -120,11 +135,11 @@ void Stepping::unlimit(int axis, int motor) {
     }
 }
 
-void IRAM_ATTR Stepping::step(uint8_t step_mask, uint8_t dir_mask) {
-    // Set the direction pins, but optimize for the common
-    // situation where the direction bits haven't changed.
-    static uint8_t previous_dir_mask = 255;  // should never be this value
-    if (previous_dir_mask == 255) {
+// Set the direction pins, but optimize for the common
+// situation where the direction bits haven't changed.
+void IRAM_ATTR Stepping::setDirections(AxisMask dir_mask) {
+    static AxisMask previous_dir_mask = 0xffff;  // should never be this value
+    if (previous_dir_mask == 0xffff) {
         // Set all the direction bits the first time
         previous_dir_mask = ~dir_mask;
     }
@@ -146,14 +161,21 @@ void IRAM_ATTR Stepping::step(uint8_t step_mask, uint8_t dir_mask) {
         }
         previous_dir_mask = dir_mask;
     }
+}
+
+void IRAM_ATTR Stepping::step(AxisMask step_mask, AxisMask dir_mask, AxisMask uncounted_mask) {
+    StepProfile::Scope profile(StepProfile::Step);
+
+    setDirections(dir_mask);
 
     step_engine->start_step();
 
     // Turn on step pulses for motors that are supposed to step now
     for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
         if (bitnum_is_true(step_mask, axis)) {
-            auto increment = bitnum_is_true(dir_mask, axis) ? -1 : 1;
-            axis_steps[axis] += increment;
+            if (!bitnum_is_true(uncounted_mask, axis)) {
+                axis_steps[axis] += bitnum_is_true(dir_mask, axis) ? -1 : 1;
+            }
             for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
                 auto m = axis_motors[axis][motor];
                 if (m && !m->blocked && !m->limited) {
@@ -165,8 +187,31 @@ void IRAM_ATTR Stepping::step(uint8_t step_mask, uint8_t dir_mask) {
     step_engine->finish_step();
 }
 
+uint32_t IRAM_ATTR Stepping::maxRun(uint32_t ticks) {
+    return step_engine->max_run ? step_engine->max_run(ticks) : 0;
+}
+
+void IRAM_ATTR Stepping::stepRun(AxisMask step_mask, AxisMask dir_mask, uint32_t count, uint32_t ticks) {
+    setDirections(dir_mask);
+
+    for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
+        if (bitnum_is_true(step_mask, axis)) {
+            int32_t increment = bitnum_is_true(dir_mask, axis) ? -int32_t(count) : int32_t(count);
+            axis_steps[axis] += increment;
+            for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
+                auto m = axis_motors[axis][motor];
+                if (m && !m->blocked && !m->limited) {
+                    step_engine->set_run_pin(m->step_pin, count, ticks);
+                }
+            }
+        }
+    }
+}
+
 // Turn all stepper pins off
 void IRAM_ATTR Stepping::unstep() {
+    StepProfile::Scope profile(StepProfile::Unstep);
+
     if (step_engine->start_unstep()) {
         return;
     }
@@ -181,7 +226,20 @@ void IRAM_ATTR Stepping::unstep() {
     step_engine->finish_unstep();
 }
 
-void Stepping::reset() {}
+// Cancels any run that the engine is still pulsing
+void Stepping::reset() {
+    if (!step_engine->set_run_pin) {
+        return;
+    }
+    for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
+        for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
+            auto m = axis_motors[axis][motor];
+            if (m) {
+                step_engine->set_run_pin(m->step_pin, 0, 0);
+            }
+        }
+    }
+}
 void Stepping::beginLowLatency() {}
 void Stepping::endLowLatency() {}
 
@@ -207,7 +265,11 @@ void Stepping::group(Configuration::HandlerBase& handler) {
     handler.item("pulse_us", _pulseUsecs, 0, 30);
     handler.item("dir_delay_us", _directionDelayUsecs, 0, 10);
     handler.item("disable_delay_us", _disableDelayUsecs, 0, 1000000);  // max 1 second
+    handler.item("enable_stagger_us", _enableStaggerUsecs, 0, 10000);
     handler.item("segments", _segments, 6, 20);
+    handler.item("acceleration_ticks_per_sec", _accelerationTicks, 20, 1000);
+    handler.item("planner_blocks", _planner_blocks, 10, 1024);
+    handler.item("prep_task", _prepTask);
 }
 
 uint32_t Stepping::maxPulsesPerSec() {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Configuration/Configurable.h"
+#include "Types.h"  // AxisMask
 #include "Driver/step_engine.h"
 
 namespace Machine {
@@ -31,6 +32,7 @@ namespace Machine {
 
         static void    startPulseTimer();
         static void    waitDirection();  // Wait for direction delay
+        static void    setDirections(AxisMask dir_mask);
         static int32_t axis_steps[MAX_N_AXIS];
 
         static step_engine_t* step_engine;
@@ -41,23 +43,44 @@ namespace Machine {
             RMT_ENGINE,
             I2S_STATIC,
             I2S_STREAM,
+            RMT_BATCH,
+            MCPWM_ENGINE,
         };
 
         Stepping() = default;
 
         // _segments is the number of entries in the step segment buffer between the step execution algorithm
         // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
-        // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
+        // fixed time of 1/_accelerationTicks seconds. They are computed such that the planner
         // block velocity profile is traced exactly. The size of this buffer governs how much step
-        // execution lead time there is for other processes to run.  The latency for a feedhold or other
-        // override is roughly 10 ms times _segments.
+        // execution lead time there is for other processes to run.  The latency for an override is
+        // roughly the segment time times _segments.  A feedhold takes back the segments that have not
+        // started, so it begins to decelerate within about two segment times.
 
         static size_t _segments;
 
+        // _accelerationTicks is the number of segments per second.  More segments follow the
+        // acceleration ramps more closely, which matters on machines with high acceleration,
+        // but each one costs a run of the segment prep code; $Stepping/Profile shows the cost.
+        static uint32_t _accelerationTicks;
+
+        // _planner_blocks is the number of entries in the planner look-ahead ring.  Dense toolpaths
+        // with many short segments need a deeper ring so the planner can reach the programmed feed
+        // rate before it must plan a stop at the end of the buffered motion.  The ring is allocated
+        // at boot, from PSRAM when it is present.
+        static size_t _planner_blocks;
+
+        // _prepTask moves the refill of the step segment buffer out of the main loop into a task
+        // of its own, pinned to the core that runs the step timer, so that a slow line of GCode
+        // cannot starve the buffer.
+
+        static bool _prepTask;
+
         static uint32_t _idleMsecs;
         static uint32_t _pulseUsecs;
         static uint32_t _directionDelayUsecs;
         static uint32_t _disableDelayUsecs;
+        static uint32_t _enableStaggerUsecs;
 
         static int _engine;
 
@@ -73,9 +96,17 @@ namespace Machine {
         static void beginLowLatency();
         static void endLowLatency();
 
-        static void step(uint8_t step_mask, uint8_t dir_mask);
+        // Axes in uncounted_mask are pulsed without changing their positions, for backlash take-up
+        static void step(AxisMask step_mask, AxisMask dir_mask, AxisMask uncounted_mask = 0);
         static void unstep();
 
+        // Runs let the engine pulse a stretch of step events in which the same axes step at
+        // every event, without calling pulse_func() for each.  maxRun() is the longest run
+        // the engine can take for events ticks apart, 0 if it cannot.  stepRun() pulses the
+        // axes of step_mask count times, the first ticks from now, and counts the steps.
+        static uint32_t maxRun(uint32_t ticks);
+        static void     stepRun(AxisMask step_mask, AxisMask dir_mask, uint32_t count, uint32_t ticks);
+
         // Used to stop a motor quickly when a limit switch is hit
         static bool* limit_var(int axis, int motor);
         static void  limit(int axis, int motor);
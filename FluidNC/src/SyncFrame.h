@@ -0,0 +1,238 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SyncFrame.h - the wire format and clock alignment of the sync link
+
+  A leader controller sends the stepper blocks and segments it prepares to a
+  follower, which executes them with its own motors in lockstep.  Each message
+  is a frame
+
+      0xA5  type  length  payload[length]  crc8
+
+  with little-endian payload fields.  A receiver that sees a bad CRC drops
+  bytes until the next 0xA5, so a corrupted frame costs only itself; the
+  segment sequence numbers tell the follower that one was lost.
+
+  The follower aligns its clock with the leader's by timing ping / pong round
+  trips.  The sample with the shortest round trip among recent ones gives the
+  offset between the clocks, and the change of offset over time gives their
+  rate difference, which the follower applies to the segment periods so that
+  the two machines do not drift apart during a long job.
+
+  Everything here is plain C++ so that it can be tested on the host.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace SyncLink {
+    enum FrameType : uint8_t {
+        Block   = 1,  // step_event_count u32, direction_bits u16, n_axis u8, steps u32[n_axis]
+        Segment = 2,  // seq u16, n_step u16, period u16, amass_level u8
+        Start   = 3,  // leader_us u32, the leader's time when its step timer started
+        Reset   = 4,  // no payload; discard all queued motion
+        Ping    = 5,  // follower_us u32
+        Pong    = 6,  // follower_us u32, leader_us u32
+    };
+
+    static const uint8_t  frameStart   = 0xA5;
+    static const size_t   maxAxes      = 9;
+    static const size_t   maxPayload   = 7 + 4 * maxAxes;  // A block
+    static const size_t   maxFrame     = maxPayload + 4;
+    static const uint32_t pingInterval = 250000;  // us
+
+    inline uint8_t crc8(const uint8_t* data, size_t length) {
+        uint8_t crc = 0;
+        while (length--) {
+            crc ^= *data++;
+            for (int i = 0; i < 8; i++) {
+                crc = (crc & 0x80) ? uint8_t((crc << 1) ^ 0x07) : uint8_t(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    // Builds a frame a field at a time
+    class FrameWriter {
+        uint8_t _data[maxFrame];
+        size_t  _length = 3;
+
+    public:
+        explicit FrameWriter(FrameType type) {
+            _data[0] = frameStart;
+            _data[1] = type;
+        }
+
+        FrameWriter& u8(uint8_t v) {
+            _data[_length++] = v;
+            return *this;
+        }
+        FrameWriter& u16(uint16_t v) { return u8(uint8_t(v)).u8(uint8_t(v >> 8)); }
+        FrameWriter& u32(uint32_t v) { return u16(uint16_t(v)).u16(uint16_t(v >> 16)); }
+
+        // Completes the frame and returns its length
+        size_t finish() {
+            _data[2]         = uint8_t(_length - 3);
+            _data[_length++] = crc8(_data + 1, _length - 1);
+            return _length;
+        }
+        const uint8_t* data() const { return _data; }
+    };
+
+    // Reads the fields of a received payload in order
+    class FrameReader {
+        const uint8_t* _data;
+        size_t         _length;
+        size_t         _pos = 0;
+
+    public:
+        FrameReader(const uint8_t* data, size_t length) : _data(data), _length(length) {}
+
+        bool    ok(size_t n) const { return _pos + n <= _length; }
+        uint8_t u8() { return ok(1) ? _data[_pos++] : 0; }
+        uint16_t u16() {
+            uint16_t lo = u8();
+            return uint16_t(lo | (u8() << 8));
+        }
+        uint32_t u32() {
+            uint32_t lo = u16();
+            return lo | (uint32_t(u16()) << 16);
+        }
+    };
+
+    // Assembles frames from received bytes.  push() returns true when a frame
+    // with a good CRC is complete; type() and payload() are then valid until
+    // the next push().
+    class FrameParser {
+        uint8_t  _data[maxFrame];
+        size_t   _length = 0;
+        uint32_t _errors = 0;
+
+    public:
+        bool push(uint8_t byte) {
+            if (_length == 0 && byte != frameStart) {
+                return false;
+            }
+            _data[_length++] = byte;
+            if (_length == 3 && _data[2] > maxPayload) {
+                ++_errors;
+                _length = 0;
+                return false;
+            }
+            if (_length < 3 || _length < size_t(_data[2]) + 4) {
+                return false;
+            }
+            size_t length = _length;
+            _length       = 0;
+            if (crc8(_data + 1, length - 2) != _data[length - 1]) {
+                ++_errors;
+                return false;
+            }
+            return true;
+        }
+
+        FrameType      type() const { return FrameType(_data[1]); }
+        FrameReader    payload() const { return FrameReader(_data + 3, _data[2]); }
+        uint32_t       errors() const { return _errors; }
+    };
+
+    // Estimates the leader's clock from ping / pong round trips.  Times are
+    // microsecond counters that may wrap; only their differences are used.
+    class ClockSync {
+        static const int window = 8;  // Round trips per estimate
+
+        uint32_t _bestRtt    = UINT32_MAX;
+        int32_t  _bestOffset = 0;  // leader - local, of the shortest round trip
+        uint32_t _bestLocal  = 0;
+        int      _samples    = 0;
+
+        bool     _valid       = false;
+        int32_t  _offset      = 0;
+        uint32_t _offsetLocal = 0;  // When _offset was measured
+        float    _rate        = 0;  // d(offset) / d(local), leader fast is positive
+
+    public:
+        // follower_us was sent in the ping and came back in the pong with
+        // leader_us; local_us is when the pong arrived.
+        void pong(uint32_t follower_us, uint32_t leader_us, uint32_t local_us) {
+            uint32_t rtt = local_us - follower_us;
+            if (rtt < _bestRtt) {
+                _bestRtt    = rtt;
+                _bestOffset = int32_t(leader_us - (follower_us + rtt / 2));
+                _bestLocal  = follower_us + rtt / 2;
+            }
+            if (++_samples < window) {
+                return;
+            }
+            if (_valid) {
+                int32_t elapsed = int32_t(_bestLocal - _offsetLocal);
+                if (elapsed > 1000000) {
+                    float rate = float(int32_t(_bestOffset - _offset)) / float(elapsed);
+                    // The first estimate is taken as is; later ones are smoothed
+                    _rate = _rate == 0 ? rate : _rate + (rate - _rate) / 4;
+                }
+            }
+            _valid       = true;
+            _offset      = _bestOffset;
+            _offsetLocal = _bestLocal;
+            _bestRtt     = UINT32_MAX;
+            _samples     = 0;
+        }
+
+        bool valid() const { return _valid; }
+
+        // The local time at which the leader's clock reads leader_us
+        uint32_t to_local(uint32_t leader_us) const {
+            // offset(t) = _offset + _rate * (t - _offsetLocal), and leader = local + offset
+            int32_t guess = int32_t(leader_us - _offset - _offsetLocal);
+            return _offsetLocal + uint32_t(int32_t(float(guess) / (1.0f + _rate)));
+        }
+
+        float rate() const { return _rate; }
+        float ppm() const { return _rate * 1e6f; }
+    };
+
+    // Converts the leader's segment periods to local timer ticks.  The rate
+    // difference stretches or shrinks every period, and a pending correction,
+    // such as the lateness of the start, is worked off at most maxCorrection of
+    // a segment at a time.  The fractions of a tick that periods cannot carry
+    // accumulate, so the total time comes out exact.
+    class PeriodScaler {
+        static constexpr float maxCorrection = 0.05f;
+
+        float _carry = 0;  // Ticks still to add, or to remove if negative
+
+    public:
+        void  correct(float ticks) { _carry += ticks; }
+        float pending() const { return _carry; }
+        void  reset() { _carry = 0; }
+
+        // rate as from ClockSync::rate()
+        uint16_t scale(uint16_t n_step, uint16_t period, float rate) {
+            if (n_step == 0) {
+                return period;
+            }
+            float total = float(n_step) * float(period) / (1.0f + rate);
+            float ideal = total + _carry;
+            float limit = total * maxCorrection;
+            if (ideal > total + limit) {
+                ideal = total + limit;
+            } else if (ideal < total - limit) {
+                ideal = total - limit;
+            }
+            float scaled = ideal / n_step + 0.5f;
+            if (scaled > 65535.0f) {
+                scaled = 65535.0f;
+            } else if (scaled < 1.0f) {
+                scaled = 1.0f;
+            }
+            uint16_t result = uint16_t(scaled);
+            _carry += total - float(result) * n_step;
+            return result;
+        }
+    };
+}
@@ -0,0 +1,421 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  SyncLink.cpp - a second controller that executes the motion of the first
+
+  For machines with more motors than one controller can drive, a follower
+  controller receives the stepper blocks and segments that the leader
+  prepares, over a UART of each, and executes them with its own motors in
+  lockstep with the leader's.  The follower's planner is not involved, so the
+  follower runs the leader's Bresenham and AMASS data exactly; each follower
+  axis takes the steps of the leader axis that axis_map names for it.
+
+    sync_link:
+      role: leader
+      uart_num: 1
+
+    sync_link:
+      role: follower
+      uart_num: 1
+      axis_map: XYZX
+
+  Here the follower's A motor runs a second copy of the leader's X axis.
+  With no axis_map, each follower axis follows the leader axis of its name.
+
+  The leader sends a Start frame with its clock when its step timer starts.
+  The follower has the segments by then, since the leader prepares them
+  before starting, so it starts its own timer and works off the delay from
+  the leader's start by shortening the first segments a little.  The
+  follower times ping / pong round trips to estimate the leader's clock and
+  its rate, and scales every segment period by the rate difference so that
+  the two do not drift apart.  A lost segment, a corrupted frame during
+  motion, or a link too slow to keep the follower supplied is a position
+  loss, so the follower stops with an alarm; the leader cannot tell.
+
+  The link carries about 10 bytes per segment.  A baud rate of 1000000 or
+  more is recommended; the frames of a block with six axes take 0.3ms there.
+  See SyncFrame.h for the frame format.
+*/
+
+#include "SyncLink.h"
+
+#include "SyncFrame.h"
+#include "Module.h"
+#include "Stepper.h"
+#include "Stepping.h"
+#include "Protocol.h"
+#include "Report.h"  // state_name()
+#include "System.h"
+#include "GCode.h"
+#include "Planner.h"
+#include "MotionControl.h"  // mc_critical
+#include "EnumItem.h"
+#include "Machine/MachineConfig.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+namespace SyncLink {
+    bool leading = false;
+
+    static Uart*    link_uart   = nullptr;
+    static uint16_t segment_seq = 0;  // Changed only under the prep lock
+
+    static uint32_t now_us() {
+        return uint32_t(esp_timer_get_time());
+    }
+
+    // One write per frame, so frames from different tasks do not interleave
+    static void send(FrameWriter& frame) {
+        size_t length = frame.finish();
+        link_uart->write(frame.data(), length);
+    }
+
+    void send_block(const volatile uint32_t* steps, uint32_t step_event_count, uint16_t direction_bits) {
+        auto        n_axis = Axes::_numberAxis;
+        FrameWriter frame(Block);
+        frame.u32(step_event_count).u16(direction_bits).u8(n_axis);
+        for (int axis = 0; axis < n_axis; axis++) {
+            frame.u32(steps[axis]);
+        }
+        send(frame);
+    }
+
+    void send_segment(uint16_t n_step, uint16_t period, uint8_t amass_level) {
+        FrameWriter frame(Segment);
+        frame.u16(segment_seq++).u16(n_step).u16(period).u8(amass_level);
+        send(frame);
+    }
+
+    void send_start() {
+        FrameWriter frame(Start);
+        frame.u32(now_us());
+        send(frame);
+    }
+
+    void send_reset() {
+        segment_seq = 0;
+        FrameWriter frame(Reset);
+        send(frame);
+    }
+
+    // The follower's state belongs to the link task, except for the flags that the
+    // events below, which run in the main loop, use to report back.
+    struct Item {
+        bool     block;
+        uint8_t  amass_level;
+        AxisMask direction_bits;
+        uint16_t n_step;
+        uint16_t period;
+        uint32_t step_event_count;
+        uint32_t steps[MAX_N_AXIS];
+    };
+
+    static const size_t queueSize = 64;
+
+    static Item   queue[queueSize];  // Received motion waiting for room in the segment buffer
+    static size_t queue_head = 0;
+    static size_t queue_tail = 0;
+
+    static FrameParser  parser;
+    static ClockSync    clock;
+    static PeriodScaler scaler;
+    static uint8_t      axis_map[MAX_N_AXIS];
+
+    static uint16_t next_seq    = 0;
+    static bool     running     = false;  // Between a Start and the end of the motion
+    static bool     discarding  = false;  // After a failure, until the next Start
+    static bool     corrected   = false;  // The start delay has been taken into account
+    static uint32_t start_us    = 0;      // The leader's time from the Start frame
+    static uint32_t errors_seen = 0;
+    static uint32_t next_ping   = 0;
+
+    // The follower's cycle, as the start event moves it along
+    enum Phase : uint8_t { Waiting, Requested, Started, Refused };
+
+    static std::atomic<uint8_t>  phase;
+    static std::atomic<uint32_t> started_us;  // Local time of the follower's start
+
+    static void start_follower() {
+        if (!state_is(State::Idle)) {
+            log_error("Sync link: follower cannot start in state " << state_name());
+            phase = Refused;
+            return;
+        }
+        set_state(State::Cycle);
+        Stepper::wake_up();
+        started_us = now_us();
+        phase      = Started;
+    }
+
+    // The follower's steps moved its motors but not its parser or planner
+    static void sync_follower() {
+        if (state_is(State::Idle)) {
+            gc_sync_position();
+            plan_sync_position();
+        }
+    }
+
+    static const NoArgEvent followerStartEvent { start_follower, Event::Motion };
+    static const NoArgEvent followerSyncEvent { sync_follower };
+
+    static void clear_queue() {
+        queue_head = queue_tail = 0;
+        scaler.reset();
+    }
+
+    static void fail(const char* why) {
+        log_error("Sync link: " << why);
+        clear_queue();
+        discarding = true;
+        if (running) {
+            running = false;
+            phase   = Waiting;
+            mc_critical(ExecAlarm::AbortCycle);
+        }
+    }
+
+    static Item* push() {
+        size_t next = (queue_head + 1) % queueSize;
+        if (next == queue_tail) {
+            fail("follower queue overflow");
+            return nullptr;
+        }
+        Item* item = &queue[queue_head];
+        queue_head = next;
+        return item;
+    }
+
+    static void follower_frame() {
+        auto payload = parser.payload();
+        switch (parser.type()) {
+            case Pong: {
+                uint32_t follower_us = payload.u32();
+                uint32_t leader_us   = payload.u32();
+                bool     was_valid   = clock.valid();
+                clock.pong(follower_us, leader_us, now_us());
+                if (!was_valid && clock.valid()) {
+                    log_info("Sync link: leader clock found");
+                }
+                break;
+            }
+            case Block: {
+                uint32_t step_event_count = payload.u32();
+                uint16_t direction_bits   = payload.u16();
+                uint8_t  n_axis           = payload.u8();
+
+                uint32_t steps[maxAxes] = {};  // The leader may have more axes
+                if (n_axis > maxAxes || !payload.ok(4 * n_axis)) {
+                    fail("malformed block");
+                    break;
+                }
+                for (size_t axis = 0; axis < n_axis; axis++) {
+                    steps[axis] = payload.u32();
+                }
+                if (discarding) {
+                    break;
+                }
+                Item* item = push();
+                if (!item) {
+                    break;
+                }
+                item->block            = true;
+                item->step_event_count = step_event_count;
+                item->direction_bits   = 0;
+                for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+                    auto from         = axis_map[axis];
+                    item->steps[axis] = from < n_axis ? steps[from] : 0;
+                    if (from < n_axis && bitnum_is_true(direction_bits, from)) {
+                        set_bitnum(item->direction_bits, axis);
+                    }
+                }
+                break;
+            }
+            case Segment: {
+                uint16_t seq = payload.u16();
+                if (seq != next_seq && !discarding) {
+                    fail("lost a segment");
+                }
+                next_seq = seq + 1;
+                if (discarding) {
+                    break;
+                }
+                Item* item = push();
+                if (!item) {
+                    break;
+                }
+                item->block       = false;
+                item->n_step      = payload.u16();
+                item->period      = payload.u16();
+                item->amass_level = payload.u8();
+                break;
+            }
+            case Start:
+                start_us   = payload.u32();
+                discarding = false;
+                if (!running) {
+                    running   = true;
+                    corrected = false;
+                    if (!clock.valid()) {
+                        log_warn("Sync link: starting before the leader clock is known");
+                    }
+                }
+                break;
+            case Reset:
+                next_seq = 0;
+                if (running) {
+                    fail("leader reset");
+                }
+                clear_queue();
+                discarding = false;
+                break;
+            default:
+                break;
+        }
+    }
+
+    static void leader_frame() {
+        if (parser.type() == Ping) {
+            uint32_t    follower_us = parser.payload().u32();
+            FrameWriter frame(Pong);
+            frame.u32(follower_us).u32(now_us());
+            send(frame);
+        }
+    }
+
+    // Moves received motion into the segment buffer while there is room, and starts
+    // and ends the follower's cycle
+    static void feed_stepper() {
+        if (phase == Refused) {
+            phase   = Waiting;
+            running = false;
+            clear_queue();
+            discarding = true;
+            return;
+        }
+        if (!running) {
+            return;
+        }
+        if (phase == Started && !corrected && clock.valid()) {
+            // Positive when the follower started after the leader
+            int32_t late_us = int32_t(started_us.load() - clock.to_local(start_us));
+            scaler.correct(-float(late_us) * (Machine::Stepping::fStepperTimer / 1000000));
+            corrected = true;
+        }
+        while (queue_tail != queue_head && Stepper::segments_free()) {
+            Item& item = queue[queue_tail];
+            if (item.block) {
+                Stepper::follower_block(item.steps, item.step_event_count, item.direction_bits);
+            } else {
+                Stepper::follower_segment(item.n_step, scaler.scale(item.n_step, item.period, clock.rate()), item.amass_level);
+            }
+            queue_tail = (queue_tail + 1) % queueSize;
+        }
+        if (phase == Waiting) {
+            phase = Requested;
+            protocol_send_event(&followerStartEvent);
+            return;
+        }
+        if (phase == Started && state_is(State::Idle)) {
+            // The stepper ran out of segments
+            phase = Waiting;
+            if (queue_tail != queue_head) {
+                fail("link too slow for the motion");
+                return;
+            }
+            running = false;
+            protocol_send_event(&followerSyncEvent);
+        }
+    }
+
+    static void link_task(void* unused) {
+        next_ping = now_us();
+        while (true) {
+            uint8_t buffer[64];
+            size_t  length = link_uart->timedReadBytes(buffer, sizeof(buffer), 1);
+            for (size_t i = 0; i < length; i++) {
+                if (!parser.push(buffer[i])) {
+                    continue;
+                }
+                if (leading) {
+                    leader_frame();
+                } else {
+                    follower_frame();
+                }
+            }
+            if (leading) {
+                continue;
+            }
+            if (parser.errors() != errors_seen) {
+                errors_seen = parser.errors();
+                if (running) {
+                    fail("corrupted frame during motion");
+                }
+            }
+            uint32_t now = now_us();
+            if (int32_t(now - next_ping) >= 0) {
+                next_ping = now + pingInterval;
+                FrameWriter frame(Ping);
+                frame.u32(now);
+                send(frame);
+            }
+            feed_stepper();
+        }
+    }
+
+    class SyncLinkConfig : public ConfigurableModule {
+        enum Role { Leader = 0, Follower };
+
+        int         _role     = Leader;
+        int         _uart_num = 1;
+        std::string _axis_map;
+
+    public:
+        SyncLinkConfig(const char* name) : ConfigurableModule(name) {}
+
+        void init() override {
+            link_uart = config->_uarts[_uart_num];
+            if (!link_uart) {
+                log_error("Sync link: missing uart" << _uart_num << " section");
+                return;
+            }
+            for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+                axis_map[axis] = axis;
+                if (axis < _axis_map.length()) {
+                    for (size_t from = 0; from < MAX_N_AXIS; from++) {
+                        if (Axes::axisName(from) == toupper(_axis_map[axis])) {
+                            axis_map[axis] = from;
+                        }
+                    }
+                }
+            }
+            leading = _role == Leader;
+            Machine::Tasks::create("sync_link", link_task, nullptr);
+            log_info("Sync link " << (leading ? "leader" : "follower") << " on uart" << _uart_num);
+        }
+
+        void validate() override {
+            for (auto c : _axis_map) {
+                Assert(strchr("XYZABCUVWxyzabcuvw", c), "Sync link axis_map has an axis letter that is not XYZABCUVW");
+            }
+        }
+
+        void group(Configuration::HandlerBase& handler) override {
+            static const EnumItem roles[] = { { Leader, "leader" }, { Follower, "follower" }, EnumItem(Leader) };
+
+            handler.item("role", _role, roles);
+            handler.item("uart_num", _uart_num, 1, MAX_N_UARTS - 1);
+            handler.item("axis_map", _axis_map, 0, MAX_N_AXIS);
+        }
+    };
+
+    namespace {
+        ConfigurableModuleFactory::InstanceBuilder<SyncLinkConfig> sync_link_module("sync_link");
+    }
+}
@@ -0,0 +1,19 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+
+// The leader side of the sync link, which sends the stepper's blocks and segments
+// to a follower controller.  See SyncLink.cpp.
+namespace SyncLink {
+    // True when the sync_link: section makes this controller a leader.  Stepper tests
+    // it before each call below, so a machine without a link pays only for the test.
+    extern bool leading;
+
+    void send_block(const volatile uint32_t* steps, uint32_t step_event_count, uint16_t direction_bits);
+    void send_segment(uint16_t n_step, uint16_t period, uint8_t amass_level);
+    void send_start();  // When the step timer starts
+    void send_reset();  // When the queued segments are discarded
+}
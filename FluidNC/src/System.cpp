@@ -11,13 +11,16 @@
 #include "Config.h"                 // MAX_N_AXIS
 #include "Machine/MachineConfig.h"  // config
 #include "src/Stepping.h"           // config
+#include "FlightRecorder.h"
 
 #include <cstring>  // memset
 #include <cmath>    // roundf
+#include <mutex>
 
 // Declare system global variable structure
 system_t sys;
-int32_t  probe_steps[MAX_N_AXIS];  // Last probe position in steps.
+int32_t  probe_steps[MAX_N_AXIS];     // Last probe position in steps.
+int32_t  probe_substeps[MAX_N_AXIS];  // Fraction of a step beyond probe_steps, in 1/65536 step.
 
 void system_reset() {
     // Reset system variables.
@@ -28,8 +31,10 @@ void system_reset() {
     sys.abort             = prior_abort;
     sys.f_override        = FeedOverride::Default;          // Set to 100%
     sys.r_override        = RapidOverride::Default;         // Set to 100%
+    sys.load_override     = FeedOverride::Default;          // Set to 100%
     sys.spindle_speed_ovr = SpindleSpeedOverride::Default;  // Set to 100%
     memset(probe_steps, 0, sizeof(probe_steps));            // Clear probe position.
+    memset(probe_substeps, 0, sizeof(probe_substeps));
     report_ovr_counter = 0;
     report_wco_counter = 0;
 }
@@ -51,8 +56,22 @@ void motor_steps_to_mpos(float* position, int32_t* steps) {
     config->_kinematics->motors_to_cartesian(position, motor_mpos, n_axis);
 }
 
+void probe_steps_to_mpos(float* position) {
+    float motor_mpos[MAX_N_AXIS];
+    auto  n_axis = Axes::_numberAxis;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        float steps     = probe_steps[idx] + probe_substeps[idx] / 65536.0f;
+        motor_mpos[idx] = steps / Axes::_axis[idx]->_stepsPerMm;
+    }
+    config->_kinematics->motors_to_cartesian(position, motor_mpos, n_axis);
+}
+
 void set_motor_steps(size_t axis, int32_t steps) {
     Stepping::setSteps(axis, steps);
+    auto encoder = config->_axes->_axis[axis]->_encoder;
+    if (encoder) {
+        encoder->rereference();
+    }
 }
 
 void set_motor_steps_from_mpos(float* mpos) {
@@ -82,10 +101,31 @@ int32_t* get_motor_steps() {
     return motor_steps;
 }
 
+// The last conversion is cached, keyed on the steps, because forward kinematics can be
+// costly and status reports ask for the position many times a second while idle.
+static int32_t    cached_steps[MAX_N_AXIS];
+static float      cached_mpos[MAX_N_AXIS];
+static bool       mpos_cached = false;
+static std::mutex mpos_mutex;
+
+void invalidate_mpos() {
+    std::lock_guard<std::mutex> lock(mpos_mutex);
+    mpos_cached = false;
+}
+
 float* get_mpos() {
     static float position[MAX_N_AXIS];
 
-    motor_steps_to_mpos(position, get_motor_steps());
+    int32_t steps[MAX_N_AXIS];
+    get_motor_steps(steps);
+
+    std::lock_guard<std::mutex> lock(mpos_mutex);
+    if (!mpos_cached || memcmp(steps, cached_steps, Axes::_numberAxis * sizeof(int32_t))) {
+        motor_steps_to_mpos(cached_mpos, steps);
+        memcpy(cached_steps, steps, sizeof(cached_steps));
+        mpos_cached = true;
+    }
+    memcpy(position, cached_mpos, sizeof(position));  // Callers may modify it
     return position;
 };
 
@@ -117,7 +157,11 @@ const std::map<State, const char*> StateName = {
 };
 
 void set_state(State s) {
-    sys.state = s;
+    bool changed = sys.state != s;
+    sys.state    = s;
+    if (changed) {
+        FlightRecorder::state_changed();
+    }
 }
 bool state_is(State s) {
     return sys.state == s;
@@ -46,6 +46,7 @@ struct system_t {
     StepControl    step_control;       // Governs the step segment generator depending on system state.
     Percent        f_override;         // Feed rate override value in percent
     Percent        r_override;         // Rapids override value in percent
+    Percent        load_override;      // Feed limit from motor load in percent, see TrinamicTelemetry.h
     Percent        spindle_speed_ovr;  // Spindle speed value in percent
     Override       override_ctrl;      // Tracks override control states.
     SpindleSpeed   spindle_speed;
@@ -53,8 +54,9 @@ struct system_t {
 extern system_t sys;
 
 // NOTE: These position variables may need to be declared as volatiles, if problems arise.
-extern int32_t motor_steps[MAX_N_AXIS];  // Real-time machine (aka home) position vector in steps.
-extern int32_t probe_steps[MAX_N_AXIS];  // Last probe position in machine coordinates and steps.
+extern int32_t motor_steps[MAX_N_AXIS];     // Real-time machine (aka home) position vector in steps.
+extern int32_t probe_steps[MAX_N_AXIS];     // Last probe position in machine coordinates and steps.
+extern int32_t probe_substeps[MAX_N_AXIS];  // Fraction of a step beyond probe_steps, in 1/65536 step.
 
 void system_reset();
 
@@ -70,7 +72,11 @@ void     get_motor_steps(int32_t* steps);
 // Updates a machine position array from a steps array
 void motor_steps_to_mpos(float* position, int32_t* steps);
 
+// The last probe position, including the fraction of a step, in machine coordinates
+void probe_steps_to_mpos(float* position);
+
 float* get_mpos();
+void   invalidate_mpos();  // After a change to the conversion from steps, e.g. steps_per_mm
 float* get_wco();
 
 bool inMotionState();  // True if moving, i.e. the stepping engine is active
@@ -3,6 +3,7 @@
 
 #include "atc_manual.h"
 #include "../Machine/MachineConfig.h"
+#include "../Settings.h"  // ToolTable
 #include <cstdio>
 #include <iostream>
 
@@ -31,6 +32,11 @@
      -- Set TLO
      -- Returns to position before command
 
+  The TLO of each tool is written to the tool table with G10 L1 and applied with
+  G43 H, so it is kept in RAM, reaches NVS with the other deferred offset writes,
+  and G43 H<tool> can apply it later without another probe.  Tools above the
+  table's range fall back to G43.1.
+
   Posible New Persistant values (might want a save_ATC_values: config item. default false)
      -- TLO
      -- Tool number
@@ -88,7 +94,7 @@ namespace ATCs {
             if (_prev_tool == 0) {  // M6T<anything> from T0 is used for a manual change before zero'ing
                 move_to_change_location();
                 _macro.addf("G4P0 0.1");
-                _macro.addf("G43.1Z0");
+                set_tlo(new_tool, "0");  // The first tool is the reference
                 _macro.addf("(MSG : Install tool #%d)", new_tool);
                 if (was_inch_mode) {
                     _macro.addf("G20");
@@ -105,14 +111,16 @@ namespace ATCs {
             _macro.addf("#<start_y >= #<_y>");
             _macro.addf("#<start_z >= #<_z>");
 
-            move_to_safe_z();
-
-            // turn off the spindle
+            // Turn off the spindle and retract while it slows down.  The planner is empty, so
+            // M5 does not wait for motion, and the deferred spindown delay is finished by the
+            // probe or M0 that needs the spindle stopped.
             if (gc_state.modal.spindle != SpindleState::Disable) {
                 spindle_was_on = true;
                 _macro.addf("M5");
             }
 
+            move_to_safe_z();
+
             // if we have not determined the tool setter offset yet, we need to do that.
             if (!_have_tool_setter_offset) {
                 move_over_toolsetter();
@@ -134,7 +142,7 @@ namespace ATCs {
 
             // TLO is simply the difference between the tool1 probe and the new tool probe.
             _macro.addf("#<_my_tlo_z >=[#5063 - #<_ets_tool1_z>]");
-            _macro.addf("G43.1Z#<_my_tlo_z>");
+            set_tlo(new_tool, "#<_my_tlo_z>");
 
             move_to_safe_z();
 
@@ -150,6 +158,9 @@ namespace ATCs {
                 _macro.addf("G20");
             }
 
+            if (spindle_was_on) {
+                spindle->deferDelay();
+            }
             _macro.run(nullptr);
 
             return true;
@@ -166,6 +177,16 @@ namespace ATCs {
         _macro.addf("(MSG: TLO Z reset to 0)");    //
     }
 
+    void Manual_ATC::set_tlo(uint8_t tool, const char* length) {
+        if (tool >= 1 && tool <= ToolTable::maxTool) {
+            // Separate lines, because G43 H reads the table before G10 in the same block sets it
+            _macro.addf("G10L1P%dZ%s", tool, length);
+            _macro.addf("G43H%d", tool);
+        } else {
+            _macro.addf("G43.1Z%s", length);
+        }
+    }
+
     void Manual_ATC::move_to_change_location() {
         move_to_safe_z();
         _macro.addf("G53G0X%0.3fY%0.3fZ%0.3f", _change_mpos[0], _change_mpos[1], _change_mpos[2]);
@@ -183,14 +204,17 @@ namespace ATCs {
     void Manual_ATC::ets_probe() {
         _macro.addf("G53G0Z #</ atc_manual / ets_rapid_z_mpos_mm>");  // rapid down
 
+        // With a toolsetter input of its own, a touch probe left plugged in cannot stop the cycle
+        const char* input = config->_probe->exists(ProbeInput::Toolsetter) ? " Q2" : "";
+
         // do a fast probe if there is a seek that is faster than feed
         if (_probe_seek_rate > _probe_feed_rate) {
-            _macro.addf("G53 G38.2 Z%0.3f F%0.3f", _ets_mpos[2], _probe_seek_rate);
+            _macro.addf("G53 G38.2 Z%0.3f F%0.3f%s", _ets_mpos[2], _probe_seek_rate, input);
             _macro.addf("G0Z[#<_z> + 5]");  // retract befor next probe
         }
 
         // do the feed rate probe
-        _macro.addf("G53 G38.2 Z%0.3f F%0.3f", _ets_mpos[2], _probe_feed_rate);
+        _macro.addf("G53 G38.2 Z%0.3f F%0.3f%s", _ets_mpos[2], _probe_feed_rate, input);
     }
 
     namespace {
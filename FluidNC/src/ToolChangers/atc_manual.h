@@ -43,6 +43,7 @@ namespace ATCs {
         void move_to_safe_z();
         void move_over_toolsetter();
         void ets_probe();
+        void set_tlo(uint8_t tool, const char* length);
         void reset();
 
         Macro _macro;
@@ -0,0 +1,143 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Trace.h"
+
+#include "Logging.h"
+
+#ifdef TRACE_POINTS
+#    include <esp_attr.h>  // IRAM_ATTR
+#    include <esp_timer.h>
+#    include <freertos/FreeRTOS.h>
+#    include <algorithm>
+#    include <array>
+#    include <atomic>
+#    include <cstdio>
+#    include <map>
+#    include <vector>
+#endif
+#include <strings.h>
+
+namespace Trace {
+#ifdef TRACE_POINTS
+    struct Record {
+        uint32_t id;
+        uint32_t time_us;  // esp_timer_get_time(), wrapped; the CPU cycle counters differ between cores
+        Stage    stage;
+    };
+
+    // A writer claims a slot by advancing the head, so the tasks and the ISR on a core
+    // can share its ring.  The oldest records are overwritten.
+    static const size_t ringSize = 512;  // A power of 2
+    struct Ring {
+        std::atomic<uint32_t> head { 0 };
+        Record                records[ringSize];
+    };
+    static Ring rings[portNUM_PROCESSORS];
+
+    static std::atomic<uint32_t> lastId { 0 };
+
+    uint32_t current = 0;
+
+    void IRAM_ATTR record(Stage stage, uint32_t id) {
+        if (id == 0) {
+            return;
+        }
+        Ring&    ring      = rings[xPortGetCoreID()];
+        uint32_t slot      = ring.head.fetch_add(1, std::memory_order_relaxed) & (ringSize - 1);
+        ring.records[slot] = { id, uint32_t(esp_timer_get_time()), stage };
+    }
+
+    uint32_t received() {
+        uint32_t id = ++lastId;
+        record(Received, id);
+        return id;
+    }
+
+    static void reset() {
+        for (auto& ring : rings) {
+            ring.head = 0;
+            for (auto& r : ring.records) {
+                r.id = 0;
+            }
+        }
+    }
+
+    static const char* stageNames[] = { "received", "parsed", "planned", "prepped", "stepped" };
+
+    static void report_latency(Channel& out, const char* from, const char* to, std::vector<uint32_t>& deltas) {
+        if (deltas.empty()) {
+            log_stream(out, from << " to " << to << ": no lines");
+            return;
+        }
+        std::sort(deltas.begin(), deltas.end());
+        auto pct = [&deltas](int p) { return deltas[(deltas.size() - 1) * p / 100]; };
+        char line[120];
+        snprintf(line,
+                 sizeof(line),
+                 "%s to %s: %u lines, us min:%u p50:%u p90:%u p99:%u max:%u",
+                 from,
+                 to,
+                 unsigned(deltas.size()),
+                 unsigned(deltas.front()),
+                 unsigned(pct(50)),
+                 unsigned(pct(90)),
+                 unsigned(pct(99)),
+                 unsigned(deltas.back()));
+        log_stream(out, line);
+    }
+
+    static void report(Channel& out) {
+        // The first time each line reached each stage; 0 if it has not.  A line with
+        // several blocks is timed by its first.
+        std::map<uint32_t, std::array<uint32_t, N_STAGES>> lines;
+        for (auto& ring : rings) {
+            for (auto& r : ring.records) {
+                if (r.id == 0 || r.stage >= N_STAGES) {
+                    continue;
+                }
+                auto& times = lines[r.id];
+                if (times[r.stage] == 0 || int32_t(r.time_us - times[r.stage]) < 0) {
+                    times[r.stage] = r.time_us;
+                }
+            }
+        }
+
+        std::vector<uint32_t> deltas;
+        for (int stage = Received; stage < N_STAGES - 1; stage++) {
+            deltas.clear();
+            for (auto const& [id, times] : lines) {
+                if (times[stage] && times[stage + 1]) {
+                    deltas.push_back(times[stage + 1] - times[stage]);
+                }
+            }
+            report_latency(out, stageNames[stage], stageNames[stage + 1], deltas);
+        }
+        deltas.clear();
+        for (auto const& [id, times] : lines) {
+            if (times[Received] && times[Stepped]) {
+                deltas.push_back(times[Stepped] - times[Received]);
+            }
+        }
+        report_latency(out, stageNames[Received], stageNames[Stepped], deltas);
+    }
+
+    // $Trace[=reset]
+    Error command(const char* value, Channel& out) {
+        if (value && *value) {
+            if (strcasecmp(value, "reset") != 0) {
+                return Error::InvalidValue;
+            }
+            reset();
+            return Error::Ok;
+        }
+        report(out);
+        return Error::Ok;
+    }
+#else
+    Error command(const char* value, Channel& out) {
+        log_stream(out, "Trace points need a build with -DTRACE_POINTS");
+        return Error::Ok;
+    }
+#endif
+}
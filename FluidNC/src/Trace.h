@@ -0,0 +1,56 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Trace.h - latency trace points along the motion pipeline
+
+  When the firmware is built with -DTRACE_POINTS, each line gets an id when the
+  polling task receives it, and the id is timestamped as the line passes each
+  stage: received, parsed (gc_execute_line() starts executing it), planned
+  (its first block is in the planner), prepped (the segment prep starts on
+  that block) and stepped (the step ISR starts the block).  The records go
+  into a ring per core, which every task and the ISR can write without a
+  lock.  $Trace shows the distribution of the time from each stage to the
+  next, so a stutter can be traced to input, parsing, planning or prep;
+  $Trace=reset clears the rings.  Without TRACE_POINTS, the trace points
+  compile to nothing.
+*/
+
+#include "Error.h"
+
+#include <cstdint>
+
+class Channel;
+
+namespace Trace {
+    enum Stage : uint8_t {
+        Received = 0,
+        Parsed,
+        Planned,
+        Prepped,
+        Stepped,
+        N_STAGES,
+    };
+
+#ifdef TRACE_POINTS
+    // The id of the line that the main loop is executing
+    extern uint32_t current;
+
+    // Records a new line as received and returns its id
+    uint32_t received();
+
+    void record(Stage stage, uint32_t id);
+#endif
+
+    Error command(const char* value, Channel& out);
+}
+
+#ifdef TRACE_POINTS
+#    define TRACE_POINT(stage, id) Trace::record(Trace::stage, id)
+#else
+#    define TRACE_POINT(stage, id)                                                                                                         \
+        do {                                                                                                                               \
+        } while (0)
+#endif
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Trochoid.h"
+
+#include "GCode.h"  // gc_state
+#include "Machine/MachineConfig.h"
+#include "MotionControl.h"  // mc_linear(), mc_arc()
+#include "System.h"         // sys, state_is()
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace Trochoid {
+    // Enough circles for a slot across any machine at a sensible stepover
+    static const uint32_t maxCircles = 100000;
+
+    // $Gen/Trochoid=X<distance> Y<distance> W<width> S<stepover> F<feed>
+    Error slot(const char* value, Channel& out) {
+        if (!value) {
+            return Error::InvalidStatement;
+        }
+        // The same lock as for GCode lines
+        if (state_is(State::Alarm) || state_is(State::ConfigAlarm) || state_is(State::Jog)) {
+            return Error::SystemGcLock;
+        }
+
+        float scale    = gc_state.modal.units == Units::Inches ? MM_PER_INCH : 1.0f;
+        float dx       = 0.0f;
+        float dy       = 0.0f;
+        float width    = 0.0f;
+        float stepover = 0.0f;
+        float feed     = 0.0f;
+
+        const char* p = value;
+        while (*p) {
+            if (*p == ' ') {
+                ++p;
+                continue;
+            }
+            char  letter = toupper(*p++);
+            char* end;
+            float number = strtof(p, &end);
+            if (end == p) {
+                return Error::BadNumberFormat;
+            }
+            p = end;
+            number *= scale;
+            switch (letter) {
+                case 'X':
+                    dx = number;
+                    break;
+                case 'Y':
+                    dy = number;
+                    break;
+                case 'W':
+                    width = number;
+                    break;
+                case 'S':
+                    stepover = number;
+                    break;
+                case 'F':
+                    feed = number;
+                    break;
+                default:
+                    return Error::GcodeUnusedWords;
+            }
+        }
+        if (feed <= 0.0f) {
+            return Error::GcodeUndefinedFeedRate;
+        }
+        if (width <= 0.0f || stepover <= 0.0f) {
+            return Error::GcodeValueWordMissing;
+        }
+        float radius = width / 2;
+        if (stepover > radius) {
+            log_error_to(out, "Trochoid stepover is more than half the width");
+            return Error::InvalidValue;
+        }
+
+        // Evenly spaced circles, one at each end of the slot
+        float    length  = hypot_f(dx, dy);
+        uint32_t circles = uint32_t(ceilf(length / stepover)) + 1;
+        if (circles > maxCircles) {
+            return Error::InvalidValue;
+        }
+        float ux = 1.0f;  // Along the slot; any direction will do for a round hole
+        float uy = 0.0f;
+        if (length > 0.0f) {
+            ux = dx / length;
+            uy = dy / length;
+        }
+        float step = circles > 1 ? length / (circles - 1) : 0.0f;
+
+        plan_line_data_t plan_data;
+        memset(&plan_data, 0, sizeof(plan_line_data_t));
+        plan_data.spindle_speed = gc_state.spindle_speed;
+        plan_data.spindle       = gc_state.modal.spindle;
+        plan_data.coolant       = gc_state.modal.coolant;
+        plan_data.line_number   = gc_state.line_number;
+
+        float* position = gc_state.position;
+        float  start_x  = position[X_AXIS];
+        float  start_y  = position[Y_AXIS];
+        float  target[MAX_N_AXIS];
+        copyAxes(target, position);
+
+        // The left side of the circle, with its center offset to the right
+        float offset[MAX_N_AXIS] = { 0 };
+        offset[X_AXIS]           = uy * radius;
+        offset[Y_AXIS]           = -ux * radius;
+
+        for (uint32_t i = 0; i < circles; i++) {
+            float along         = i * step;
+            target[X_AXIS]      = start_x + ux * along - offset[X_AXIS];
+            target[Y_AXIS]      = start_y + uy * along - offset[Y_AXIS];
+            plan_data.feed_rate = feed;  // Kinematics may alter the feed rate
+            mc_linear(target, &plan_data, position);
+            copyAxes(position, target);
+            if (sys.abort) {
+                return Error::Reset;
+            }
+            plan_data.feed_rate = feed;
+            mc_arc(target, &plan_data, position, offset, radius, X_AXIS, Y_AXIS, Z_AXIS, false, 1);
+            if (sys.abort) {
+                return Error::Reset;
+            }
+        }
+        target[X_AXIS]      = start_x + dx;
+        target[Y_AXIS]      = start_y + dy;
+        plan_data.feed_rate = feed;
+        mc_linear(target, &plan_data, position);
+        if (sys.abort) {
+            return Error::Reset;
+        }
+        gc_state.feed_rate = feed;
+        copyAxes(position, target);
+        return Error::Ok;
+    }
+}
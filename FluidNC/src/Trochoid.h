@@ -0,0 +1,27 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Trochoid.h - trochoidal slots generated on the controller
+
+  $Gen/Trochoid=X<distance> Y<distance> W<width> S<stepover> F<feed> cuts a slot
+  from the current position to the given distance away in the XY plane, with a
+  circle of tool path diameter W every S along the slot.  The circles run
+  counterclockwise, climb milling with M3, and are joined by short lines on the
+  left side; the tool ends on the slot center line at the end of the slot.
+
+  W is the diameter of the path of the tool center, so the slot is W plus the
+  tool diameter wide.  The stepover is reduced so the circles are evenly spaced.
+  The moves go to mc_arc() and mc_linear() as they are generated, which wait for
+  room in the planner, so a slot of any length costs one command line.
+*/
+
+#include "Error.h"
+
+class Channel;
+
+namespace Trochoid {
+    Error slot(const char* value, Channel& out);
+}
@@ -6,15 +6,33 @@
  */
 
 #include "Uart.h"
+#include "Machine/Tasks.h"
 
 #include <driver/uart.h>
 #include <esp_ipc.h>
 #include "hal/uart_hal.h"
 
+#include <algorithm>
+
 Uart::Uart(int uart_num) : _uart_num(uart_num) {}
 
+struct UartInstall {
+    int            uart_num;
+    int            rx_buffer_size;
+    int            tx_buffer_size;
+    QueueHandle_t* events;  // nullptr for no event queue
+};
+
+static const int eventQueueSize = 16;
+
 static void uart_driver_n_install(void* arg) {
-    uart_driver_install((uart_port_t)arg, 256, 0, 0, NULL, ESP_INTR_FLAG_IRAM);
+    auto install = static_cast<UartInstall*>(arg);
+    uart_driver_install((uart_port_t)install->uart_num,
+                        install->rx_buffer_size,
+                        install->tx_buffer_size,
+                        install->events ? eventQueueSize : 0,
+                        install->events,
+                        ESP_INTR_FLAG_IRAM);
 }
 
 // This version is used for the initial console UART where we do not want to change the pins
@@ -28,14 +46,80 @@ void Uart::begin(unsigned long baud, UartData dataBits, UartStop stopBits, UartP
     conf.stop_bits           = uart_stop_bits_t(_stopBits);
     conf.flow_ctrl           = UART_HW_FLOWCTRL_DISABLE;
     conf.rx_flow_ctrl_thresh = 0;
+    if (_rtscts) {
+        bool rts                 = !_rts_pin.undefined();
+        bool cts                 = !_cts_pin.undefined();
+        conf.flow_ctrl           = rts && cts ? UART_HW_FLOWCTRL_CTS_RTS : rts ? UART_HW_FLOWCTRL_RTS : UART_HW_FLOWCTRL_CTS;
+        conf.rx_flow_ctrl_thresh = _rtsThreshold;
+    }
     if (uart_param_config(uart_port_t(_uart_num), &conf) != ESP_OK) {
         // TODO FIXME - should this throw an error?
         return;
     };
 
-    // We init UARTs on core 0 so the interrupt handler runs there,
-    // thus avoiding conflict with the StepTimer interrupt
-    esp_ipc_call_blocking(0, uart_driver_n_install, (void*)_uart_num);
+    install();
+}
+
+// We init UARTs on core 0 so the interrupt handler runs there,
+// thus avoiding conflict with the StepTimer interrupt
+void Uart::install() {
+    if (_eventTask) {
+        // It is blocked on the queue that the driver is about to replace
+        vTaskDelete(_eventTask);
+        _eventTask = nullptr;
+    }
+    UartInstall install = { _uart_num, _rxBufferSize, _txBufferSize, _wake ? &_events : nullptr };
+    esp_ipc_call_blocking(0, uart_driver_n_install, &install);
+
+    uart_set_rx_full_threshold(uart_port_t(_uart_num), _rxFullThreshold);
+    uart_set_rx_timeout(uart_port_t(_uart_num), _rxTimeout);
+
+    if (_wake) {
+        Machine::Tasks::create("uart_events", event_loop, this, &_eventTask);
+    }
+}
+
+void Uart::event_loop(void* arg) {
+    auto         uart = static_cast<Uart*>(arg);
+    uart_event_t event;
+    while (true) {
+        if (!xQueueReceive(uart->_events, &event, portMAX_DELAY)) {
+            continue;
+        }
+        switch (event.type) {
+            case UART_DATA:
+                uart->_wake();
+                break;
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                // The driver keeps what it has; the reader is behind, so wake it
+                ++uart->_overruns;
+                log_warn("UART" << uart->_uart_num << " input overrun");
+                uart->_wake();
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void Uart::setWakeOnInput(void (*wake)()) {
+    _wake = wake;
+    if (uart_is_driver_installed(uart_port_t(_uart_num))) {
+        _pushback = -1;
+        uart_driver_delete(uart_port_t(_uart_num));
+        install();
+    }
+}
+
+void Uart::setRxBufferSize(int size) {
+    if (size == _rxBufferSize) {
+        return;
+    }
+    _rxBufferSize = size;
+    _pushback     = -1;
+    uart_driver_delete(uart_port_t(_uart_num));
+    install();
 }
 
 // This version is used when we have a config section with all the parameters
@@ -79,10 +163,15 @@ size_t Uart::write(const uint8_t* buffer, size_t length) {
 // }
 
 size_t Uart::timedReadBytes(char* buffer, size_t len, TickType_t timeout) {
-    int res = uart_read_bytes(uart_port_t(_uart_num), buffer, len, timeout);
+    size_t got = 0;
+    if (_pushback != -1 && len) {
+        buffer[got++] = _pushback;
+        _pushback     = -1;
+    }
+    int res = uart_read_bytes(uart_port_t(_uart_num), buffer + got, len - got, timeout);
     // If res < 0, no bytes were read
 
-    return res < 0 ? 0 : res;
+    return res < 0 ? got : got + res;
 }
 
 void Uart::forceXon() {
@@ -113,11 +202,12 @@ bool Uart::flushTxTimed(TickType_t ticks) {
 }
 
 void Uart::config_message(const char* prefix, const char* usage) {
-    log_info(prefix << usage << " Tx:" << _txd_pin.name() << " Rx:" << _rxd_pin.name() << " RTS:" << _rts_pin.name() << " Baud:" << _baud);
+    log_info(prefix << usage << " Tx:" << _txd_pin.name() << " Rx:" << _rxd_pin.name() << " RTS:" << _rts_pin.name()
+                    << " CTS:" << _cts_pin.name() << " Baud:" << _baud << (_rtscts ? " RTS/CTS" : ""));
 }
 
 int Uart::rx_buffer_available(void) {
-    return UART_FIFO_LEN - available();
+    return std::max(0, _rxBufferSize - available());
 }
 
 int Uart::peek() {
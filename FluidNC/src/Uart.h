@@ -10,6 +10,8 @@
 #include "UartTypes.h"
 
 #include <freertos/FreeRTOS.h>  // TickType_T
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 class Uart : public Stream, public Configuration::Configurable {
 private:
@@ -24,6 +26,16 @@ private:
 
     int _uart_num = 0;  // Hardware UART engine number
 
+    // Driver events, when a reader wants to be woken by input instead of polling
+    QueueHandle_t _events    = nullptr;
+    TaskHandle_t  _eventTask = nullptr;
+    uint32_t      _overruns  = 0;
+
+    void (*_wake)() = nullptr;
+
+    void        install();
+    static void event_loop(void* arg);
+
 public:
     // These are public so that validators from classes
     // that use Uart can check that the setup is suitable.
@@ -35,6 +47,25 @@ public:
     UartParity _parity   = UartParity::None;
     UartStop   _stopBits = UartStop::Bits1;
 
+    // Size of the driver's receive ring.  Deep rings let character-counting senders stream
+    // further ahead of the "ok" responses.
+    int _rxBufferSize = 256;
+
+    // Size of the driver's transmit ring.  With 0, write() returns only when the data
+    // is in the hardware FIFO.
+    int _txBufferSize = 0;
+
+    // The driver empties the 128-byte RX FIFO into its ring when the FIFO holds
+    // _rxFullThreshold bytes, or when the line has been idle for _rxTimeout symbol
+    // times.  Lower values leave more room for bursts at high baud rates.
+    int _rxFullThreshold = 120;
+    int _rxTimeout       = 10;
+
+    // With _rtscts, the UART raises RTS when its RX FIFO holds _rtsThreshold bytes and
+    // holds off sending while CTS is high.  Leaving out either pin uses one direction.
+    bool _rtscts       = false;
+    int  _rtsThreshold = 100;
+
     Pin _txd_pin;
     Pin _rxd_pin;
     Pin _rts_pin;
@@ -64,6 +95,7 @@ public:
     // Support methods for UartChannel
     void   flushRx();
     int    rx_buffer_available(void);
+    void   setRxBufferSize(int size);  // Reinstalls the driver, discarding pending input
     size_t timedReadBytes(char* buffer, size_t len, TickType_t timeout);
     size_t timedReadBytes(uint8_t* buffer, size_t len, TickType_t timeout) { return timedReadBytes((char*)buffer, len, timeout); }
 
@@ -78,11 +110,22 @@ public:
 
     void setSwFlowControl(bool on, int rx_threshold, int tx_threshold);
 
+    // Calls wake, from a task of the UART's own, whenever input arrives, so that the
+    // reader can block until then instead of polling.  Reinstalls the driver if it is
+    // running, discarding pending input.
+    void setWakeOnInput(void (*wake)());
+
+    // Times input was lost because the FIFO or the ring was full, if setWakeOnInput()
+    // is in use
+    uint32_t overruns() { return _overruns; }
+
     // Configuration handlers:
     void validate() override {
         Assert(!_txd_pin.undefined(), "UART: TXD is undefined");
         Assert(!_rxd_pin.undefined(), "UART: RXD is undefined");
-        // RTS and CTS are optional.
+        // RTS and CTS are optional, unless hardware flow control is on
+        Assert(!_rtscts || !_rts_pin.undefined() || !_cts_pin.undefined(), "UART: rtscts needs rts_pin or cts_pin");
+        Assert(_txBufferSize == 0 || _txBufferSize > 128, "UART: tx_buffer_size must be 0 or more than 128");
     }
 
     void afterParse() override {}
@@ -95,6 +138,12 @@ public:
 
         handler.item("baud", _baud, 2400, 10000000);
         handler.item("mode", _dataBits, _parity, _stopBits);
+        handler.item("rx_buffer_size", _rxBufferSize, 256, 16384);
+        handler.item("tx_buffer_size", _txBufferSize, 0, 16384);
+        handler.item("rx_full_threshold", _rxFullThreshold, 1, 127);
+        handler.item("rx_timeout", _rxTimeout, 1, 126);
+        handler.item("rtscts", _rtscts);
+        handler.item("rts_threshold", _rtsThreshold, 1, 127);
     }
 
     void config_message(const char* prefix, const char* usage);
@@ -4,6 +4,10 @@
 #include "UartChannel.h"
 #include "Machine/MachineConfig.h"  // config
 #include "Serial.h"                 // allChannels
+#include "Protocol.h"               // protocol_wake_polling
+
+#include <algorithm>
+#include <cstring>
 
 UartChannel::UartChannel(int num, bool addCR) : Channel("uart_channel", num, addCR) {
     _lineedit = new Lineedit(this, _line, Channel::maxLine - 1);
@@ -21,6 +25,7 @@ void UartChannel::init() {
 }
 void UartChannel::init(Uart* uart) {
     _uart = uart;
+    _uart->setWakeOnInput(protocol_wake_polling);
     allChannels.registration(this);
     if (_report_interval_ms) {
         log_info("uart_channel" << _uart_num << " created at report interval: " << _report_interval_ms);
@@ -63,7 +68,7 @@ size_t UartChannel::write(const uint8_t* buffer, size_t length) {
 }
 
 int UartChannel::available() {
-    return _uart->available();
+    return _uart->available() + _queue.size();
 }
 
 int UartChannel::peek() {
@@ -71,7 +76,8 @@ int UartChannel::peek() {
 }
 
 int UartChannel::rx_buffer_available() {
-    return _uart->rx_buffer_available();
+    // Input moved into the queue by readBulk() has not been taken yet either
+    return std::max(0, _uart->rx_buffer_available() - int(_queue.size()));
 }
 
 bool UartChannel::realtimeOkay(char c) {
@@ -99,6 +105,16 @@ int UartChannel::read() {
     return c;
 }
 
+size_t UartChannel::readBulk(uint8_t* buffer, size_t length) {
+    size_t n = _uart->timedReadBytes(buffer, length, 0);
+    if (memchr(buffer, 0x11, n)) {
+        // As in read(), XON is a request to use software flow control
+        _uart->setSwFlowControl(true, -1, -1);
+        n = std::remove(buffer, buffer + n, 0x11) - buffer;
+    }
+    return n;
+}
+
 void UartChannel::flushRx() {
     _uart->flushRx();
     Channel::flushRx();
@@ -108,10 +124,11 @@ size_t UartChannel::timedReadBytes(char* buffer, size_t length, TickType_t timeo
     // It is likely that _queue will be empty because timedReadBytes() is only
     // used in situations where the UART is not receiving GCode commands
     // and Grbl realtime characters.
-    size_t remlen = length;
-    while (remlen && _queue.size()) {
-        *buffer++ = _queue.front();
-        _queue.pop();
+    size_t queued = _queue.read(reinterpret_cast<uint8_t*>(buffer), length);
+    buffer += queued;
+    size_t remlen = length - queued;
+    if (remlen == 0) {
+        return length;
     }
 
     int res = _uart->timedReadBytes(buffer, remlen, timeout);
@@ -34,11 +34,14 @@ public:
 
     // Channel methods
     int    rx_buffer_available() override;
+    void   setRxBufferSize(int size) { _uart->setRxBufferSize(size); }
     void   flushRx() override;
     size_t timedReadBytes(char* buffer, size_t length, TickType_t timeout);
     size_t timedReadBytes(uint8_t* buffer, size_t length, TickType_t timeout) { return timedReadBytes((char*)buffer, length, timeout); };
     bool   realtimeOkay(char c) override;
     bool   lineComplete(char* line, char c) override;
+    bool   lineIdle() override { return _lineedit->idle(); }
+    size_t readBulk(uint8_t* buffer, size_t length) override;
 
     void out(const std::string& s, const char* tag) override;
     void out_acked(const std::string& s, const char* tag) override;
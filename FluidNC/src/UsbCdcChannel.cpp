@@ -0,0 +1,122 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  UsbCdcChannel.cpp - a Channel on the native USB port, as a CDC-ACM device
+
+  The link runs at USB full speed with no baud rate, so a sender can stream
+  far faster than through a USB-to-UART bridge.  Each poll moves everything
+  that has arrived into the channel's input queue in bulk, as much as the
+  queue can take; the rest waits in the TinyUSB receive buffer, and when that
+  fills, the host is held off by the USB flow control instead of losing data.
+  rx_buffer_available() counts the free space in both, which is what a
+  character-counting sender may send.
+*/
+
+#include "UsbCdcChannel.h"
+
+#include "Channel.h"
+#include "Serial.h"    // allChannels
+#include "Protocol.h"  // protocol_wake_polling()
+
+#include <sdkconfig.h>
+#include <algorithm>
+
+#if CONFIG_TINYUSB_CDC_ENABLED && ARDUINO_USB_MODE == 0
+
+#    include <USB.h>
+#    include <USBCDC.h>
+
+class UsbCdcChannel : public Channel {
+    static constexpr size_t rxBufferSize = 4096;  // The TinyUSB receive buffer
+    static constexpr size_t chunkSize    = 256;   // Of the bulk reads
+
+    USBCDC _cdc;
+
+    static void rx_event(void* arg, esp_event_base_t base, int32_t id, void* data) { protocol_wake_polling(); }
+
+public:
+    UsbCdcChannel() : Channel("usb_cdc", true), _cdc(0) {}
+
+    void init() {
+        _cdc.setRxBufferSize(rxBufferSize);
+        _cdc.onEvent(ARDUINO_USB_CDC_RX_EVENT, rx_event);
+        _cdc.begin();
+        USB.begin();
+        allChannels.registration(this);
+        log_info("USB CDC channel created");
+    }
+
+    void handle() override {
+        uint8_t buffer[chunkSize];
+        size_t  n;
+        while ((n = std::min({ size_t(_cdc.available()), _queue.free(), chunkSize })) != 0) {
+            n = _cdc.read(buffer, n);
+            if (n == 0) {
+                break;
+            }
+            _active = true;
+            push(buffer, n);
+        }
+    }
+
+    int rx_buffer_available() override { return int(_queue.free() + rxBufferSize - _cdc.available()); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t* buffer, size_t length) override {
+        // Replace \n with \r\n
+        if (!_addCR) {
+            return _cdc.write(buffer, length);
+        }
+        uint8_t modbuf[chunkSize];
+        size_t  k        = 0;
+        char    lastchar = '\0';
+        for (size_t j = 0; j < length; ++j) {
+            // Room for two in case the character is \n
+            if (k > chunkSize - 2) {
+                _cdc.write(modbuf, k);
+                k = 0;
+            }
+            char c = buffer[j];
+            if (c == '\n' && lastchar != '\r') {
+                modbuf[k++] = '\r';
+            }
+            lastchar    = c;
+            modbuf[k++] = c;
+        }
+        _cdc.write(modbuf, k);
+        return length;
+    }
+
+    void flush() override { _cdc.flush(); }
+
+    void flushRx() override {
+        while (_cdc.available()) {
+            _cdc.read();
+        }
+        Channel::flushRx();
+    }
+
+    size_t timedReadBytes(char* buffer, size_t length, TickType_t timeout) override {
+        size_t queued = _queue.read(reinterpret_cast<uint8_t*>(buffer), length);
+        if (queued == length) {
+            return length;
+        }
+        _cdc.setTimeout(timeout);
+        return queued + _cdc.readBytes(buffer + queued, length - queued);
+    }
+};
+
+static UsbCdcChannel* usbCdc = nullptr;
+
+void usbCdcInit() {
+    usbCdc = new UsbCdcChannel();
+    usbCdc->init();
+}
+
+#else
+
+void usbCdcInit() {}
+
+#endif
@@ -0,0 +1,9 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Starts a channel on the native USB port of chips that have one, such as the
+// ESP32-S3, when the build uses TinyUSB (ARDUINO_USB_MODE=0).  Elsewhere it
+// does nothing.
+void usbCdcInit();
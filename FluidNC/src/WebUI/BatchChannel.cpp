@@ -0,0 +1,51 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "BatchChannel.h"
+
+namespace WebUI {
+    BatchChannel batchChannel;
+
+    void BatchChannel::attach() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _attached = true;
+        _output.clear();
+        _line.clear();
+        _results = 0;
+    }
+
+    void BatchChannel::detach() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _attached = false;
+        _output.clear();
+        flushRx();
+    }
+
+    size_t BatchChannel::take(std::string& out) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        out.swap(_output);
+        _output.clear();
+        return _results;
+    }
+
+    size_t BatchChannel::write(const uint8_t* buffer, size_t length) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_attached) {
+            return length;
+        }
+        _output.append(reinterpret_cast<const char*>(buffer), length);
+        for (size_t i = 0; i < length; ++i) {
+            char c = buffer[i];
+            if (c == '\n') {
+                // Each line gets one ok or error:N, sent by Channel::ack()
+                if (_line == "ok" || _line.compare(0, 6, "error:") == 0) {
+                    ++_results;
+                }
+                _line.clear();
+            } else if (c != '\r' && _line.length() < 8) {
+                _line += c;
+            }
+        }
+        return length;
+    }
+}
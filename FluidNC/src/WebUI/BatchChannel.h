@@ -0,0 +1,49 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  BatchChannel.h - the channel behind the /command_batch endpoint
+
+  An HTTP sender posts many newline-separated lines in one request.  The web
+  task hands them to this channel as its input queue has room, and the polling
+  task takes them like lines from a serial sender.  Everything the channel is
+  sent, including the ok or error:N for each line, is collected for the web
+  task to stream back in the response.  Counting those results tells the web
+  task when the last line has been executed.
+
+  There is one instance, registered once and never deleted, so late output
+  for it, e.g. from messages still in the output queue, is simply dropped.
+*/
+
+#include "src/Channel.h"
+
+#include <mutex>
+#include <string>
+
+namespace WebUI {
+    class BatchChannel : public Channel {
+    public:
+        BatchChannel() : Channel("httpbatch") {}
+
+        // Starts and ends collecting output for a request
+        void attach();
+        void detach();
+
+        // Moves the collected output to out and returns the number of results so far
+        size_t take(std::string& out);
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t* buffer, size_t length) override;
+
+    private:
+        std::mutex  _mutex;
+        bool        _attached = false;
+        std::string _output;
+        std::string _line;  // The start of the current output line
+        size_t      _results = 0;
+    };
+
+    extern BatchChannel batchChannel;
+}
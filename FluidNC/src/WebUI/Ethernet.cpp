@@ -0,0 +1,224 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  Ethernet.cpp - a wired network interface alongside or instead of WiFi
+
+  A LAN8720 PHY on the ESP32's internal EMAC (RMII), or a W5500 on the SPI bus
+  for chips like the ESP32-S3 that have no EMAC.  The interface gets its own
+  address, by DHCP or statically, and the Telnet, HTTP and WebSocket servers
+  accept connections on it as on WiFi.  A wired link does not suffer the
+  retransmits and latency spikes of a busy WiFi channel when streaming.
+
+    ethernet:
+      phy: LAN8720
+      mdc_pin: gpio.23
+      mdio_pin: gpio.18
+      power_pin: gpio.16
+      clock: GPIO0_IN
+      phy_addr: 1
+
+    ethernet:
+      phy: W5500
+      cs_pin: gpio.10
+      int_pin: gpio.9
+      reset_pin: gpio.14
+      frequency_mhz: 20
+
+  With ip: 0.0.0.0, the default, the address comes from DHCP.
+*/
+
+#include "Ethernet.h"
+
+#include "src/Module.h"
+#include "src/EnumItem.h"
+#include "src/Machine/MachineConfig.h"
+#include "Driver/ethernet.h"
+
+#include <IPAddress.h>
+#include <string>
+
+namespace WebUI {
+    class Ethernet;
+
+    static Ethernet* ethernet_config = nullptr;
+    static bool      ethernet_started = false;
+
+    class Ethernet : public ConfigurableModule {
+        enum Phy { LAN8720 = 0, W5500 };
+
+        int         _phy      = LAN8720;
+        std::string _hostname = "fluidnc";
+        IPAddress   _ip;
+        IPAddress   _gateway;
+        IPAddress   _netmask;
+
+        // LAN8720
+        Pin _mdc_pin;
+        Pin _mdio_pin;
+        Pin _power_pin;
+        int _clock    = ETH_CLOCK_GPIO0_IN;
+        int _phy_addr = 0;
+
+        // W5500
+        Pin _cs_pin;
+        Pin _int_pin;
+        Pin _reset_pin;
+        int _frequency_mhz = 20;
+
+        bool     _link     = false;
+        uint32_t _reported = 0;
+
+    public:
+        Ethernet(const char* name) : ConfigurableModule(name) { ethernet_config = this; }
+
+        // Called by the starter module below, before the network services start
+        void start() {
+            eth_addr_t addr = { uint32_t(_ip), uint32_t(_gateway), uint32_t(_netmask) };
+
+            bool ok;
+            if (_phy == LAN8720) {
+                if (_power_pin.defined()) {
+                    // Many boards gate the PHY's 50 MHz oscillator with this pin
+                    _power_pin.setAttr(Pin::Attr::Output);
+                    _power_pin.write(true);
+                    delay_ms(10);
+                }
+                auto mdc  = _mdc_pin.getNative(Pin::Capabilities::Output | Pin::Capabilities::Native);
+                auto mdio = _mdio_pin.getNative(Pin::Capabilities::Output | Pin::Capabilities::Input | Pin::Capabilities::Native);
+                log_info("Ethernet LAN8720 MDC:" << _mdc_pin.name() << " MDIO:" << _mdio_pin.name() << " Power:" << _power_pin.name()
+                                                 << " PHY address:" << _phy_addr);
+                ok = eth_start_rmii(_phy_addr, mdc, mdio, eth_clock_t(_clock), _hostname.c_str(), &addr);
+            } else {
+                if (!config->_spi->defined()) {
+                    log_error("Ethernet W5500 needs SPI");
+                    return;
+                }
+                auto cs    = _cs_pin.getNative(Pin::Capabilities::Output | Pin::Capabilities::Native);
+                auto irq   = _int_pin.getNative(Pin::Capabilities::Input | Pin::Capabilities::Native);
+                int  reset = _reset_pin.defined() ? _reset_pin.getNative(Pin::Capabilities::Output | Pin::Capabilities::Native) : -1;
+                log_info("Ethernet W5500 CS:" << _cs_pin.name() << " INT:" << _int_pin.name() << " Reset:" << _reset_pin.name() << " "
+                                              << _frequency_mhz << "MHz");
+                ok = eth_start_w5500(cs, irq, reset, _frequency_mhz, _hostname.c_str(), &addr);
+            }
+            if (!ok) {
+                log_error("Cannot start Ethernet");
+                return;
+            }
+            ethernet_started = true;
+        }
+
+        const char* hostname() { return _hostname.c_str(); }
+
+        // Link and address changes are reported from here rather than from the
+        // event task, so the messages go through the usual channels
+        void poll_link() {
+            bool     link = eth_link_up();
+            uint32_t ip   = eth_local_ip();
+            if (link != _link) {
+                _link = link;
+                if (link) {
+                    log_info("Ethernet link up " << eth_speed_mbps() << "Mbps " << (eth_full_duplex() ? "full" : "half") << " duplex");
+                } else {
+                    log_info("Ethernet link down");
+                }
+            }
+            if (ip != _reported) {
+                _reported = ip;
+                if (ip) {
+                    log_info("Ethernet IP is " << IP_string(ip));
+                }
+            }
+        }
+
+        void build_info(Channel& out) {
+            uint8_t mac[6];
+            eth_mac(mac);
+            char macstr[18];
+            snprintf(macstr, sizeof(macstr), "%02X-%02X-%02X-%02X-%02X-%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+            log_msg_to(out,
+                       "Mode=ETH:Status=" << (eth_link_up() ? "Connected" : "Not connected") << ":IP=" << IP_string(eth_local_ip())
+                                          << ":MAC=" << macstr);
+        }
+
+        void validate() override {
+            if (_phy == LAN8720) {
+                Assert(_mdc_pin.defined() && _mdio_pin.defined(), "Ethernet LAN8720 needs mdc_pin and mdio_pin");
+            } else {
+                Assert(_cs_pin.defined() && _int_pin.defined(), "Ethernet W5500 needs cs_pin and int_pin");
+            }
+        }
+
+        void group(Configuration::HandlerBase& handler) override {
+            static const EnumItem phyTypes[]   = { { LAN8720, "LAN8720" }, { W5500, "W5500" }, EnumItem(LAN8720) };
+            static const EnumItem clockTypes[] = { { ETH_CLOCK_GPIO0_IN, "GPIO0_IN" },
+                                                   { ETH_CLOCK_GPIO0_OUT, "GPIO0_OUT" },
+                                                   { ETH_CLOCK_GPIO16_OUT, "GPIO16_OUT" },
+                                                   { ETH_CLOCK_GPIO17_OUT, "GPIO17_OUT" },
+                                                   EnumItem(ETH_CLOCK_GPIO0_IN) };
+
+            handler.item("phy", _phy, phyTypes);
+            handler.item("hostname", _hostname, 1, 32);
+            handler.item("ip", _ip);
+            handler.item("gateway", _gateway);
+            handler.item("netmask", _netmask);
+
+            handler.item("mdc_pin", _mdc_pin);
+            handler.item("mdio_pin", _mdio_pin);
+            handler.item("power_pin", _power_pin);
+            handler.item("clock", _clock, clockTypes);
+            handler.item("phy_addr", _phy_addr, 0, 31);
+
+            handler.item("cs_pin", _cs_pin);
+            handler.item("int_pin", _int_pin);
+            handler.item("reset_pin", _reset_pin);
+            handler.item("frequency_mhz", _frequency_mhz, 1, 80);
+        }
+
+        void deinit() override {
+            eth_stop();
+            ethernet_started = false;
+        }
+
+        ~Ethernet() { deinit(); }
+    };
+
+    // ConfigurableModules are initialized after all the Modules, which is too
+    // late for the servers, so this Module starts the configured interface
+    // between WiFi and the services that listen on it.
+    class EthernetStarter : public Module {
+    public:
+        EthernetStarter(const char* name) : Module(name) {}
+
+        void init() override {
+            if (ethernet_config) {
+                ethernet_config->start();
+            }
+        }
+
+        void poll() override {
+            if (ethernet_started) {
+                ethernet_config->poll_link();
+            }
+        }
+
+        void build_info(Channel& out) override {
+            if (ethernet_started) {
+                ethernet_config->build_info(out);
+            }
+        }
+    };
+
+    bool ethernet_on() {
+        return ethernet_started;
+    }
+
+    const char* ethernet_hostname() {
+        return ethernet_config ? ethernet_config->hostname() : "";
+    }
+
+    namespace {
+        ConfigurableModuleFactory::InstanceBuilder<Ethernet> ethernet_module("ethernet");
+    }
+    ModuleFactory::InstanceBuilder<EthernetStarter> __attribute__((init_priority(106))) ethernet_starter("ethernet", true);
+}
@@ -0,0 +1,11 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+namespace WebUI {
+    // True once the ethernet: interface from the config file has been started,
+    // so that the network services start even when WiFi is off
+    bool        ethernet_on();
+    const char* ethernet_hostname();
+}
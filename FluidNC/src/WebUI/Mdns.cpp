@@ -3,38 +3,55 @@
 
 #include "src/Module.h"
 #include "Mdns.h"
+#include "Ethernet.h"  // ethernet_on()
+#include "src/BootTiming.h"
 #include <WiFi.h>
 
 namespace WebUI {
     EnumSetting* Mdns::_enable;
+    bool         Mdns::_started = false;
+
+    // mDNS answers on every interface that is up, WiFi STA or Ethernet
+    static bool network_on() {
+        return WiFi.getMode() == WIFI_STA || ethernet_on();
+    }
 
     void Mdns::init() {
         _enable = new EnumSetting("mDNS enable", WEBSET, WA, NULL, "MDNS/Enable", true, &onoffOptions);
 
-        if (WiFi.getMode() == WIFI_STA && _enable->get()) {
+        if (network_on() && _enable->get()) {
+            BootPhase phase("mDNS");
             if (mdns_init()) {
                 log_error("Cannot start mDNS");
                 return;
             }
-            const char* h = WiFi.getHostname();
+            const char* h = WiFi.getMode() == WIFI_STA ? WiFi.getHostname() : ethernet_hostname();
             if (mdns_hostname_set(h)) {
                 log_error("Cannot set mDNS hostname to " << h);
+                mdns_free();
                 return;
             }
+            _started = true;
             log_info("Start mDNS with hostname:http://" << h << ".local/");
+        } else if (network_on()) {
+            // For networks with fixed addresses, where nothing needs to find the machine
+            log_info("mDNS is off");
         }
     }
 
     void Mdns::deinit() {
-        mdns_free();
+        if (_started) {
+            mdns_free();
+            _started = false;
+        }
     }
     void Mdns::add(const char* service, const char* proto, int port) {
-        if (WiFi.getMode() == WIFI_STA && _enable->get()) {
+        if (_started) {
             mdns_service_add(NULL, service, proto, port, NULL, 0);
         }
     }
     void Mdns::remove(const char* service, const char* proto) {
-        if (WiFi.getMode() == WIFI_STA && _enable->get()) {
+        if (_started) {
             mdns_service_remove(service, proto);
         }
     }
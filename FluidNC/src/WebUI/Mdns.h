@@ -9,6 +9,7 @@
 namespace WebUI {
     class Mdns : public Module {
         static EnumSetting* _enable;
+        static bool         _started;
 
     public:
         Mdns(const char* name) : Module(name) {}
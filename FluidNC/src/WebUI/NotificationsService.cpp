@@ -19,6 +19,9 @@
 
 #include <WiFiClientSecure.h>
 #include <base64.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 namespace WebUI {
     static const int PUSHOVER_NOTIFICATION = 1;
@@ -42,6 +45,20 @@ namespace WebUI {
 
     static const int EMAILTIMEOUT = 5000;
 
+    // Messages wait here for the notification task, so that notify() never waits for
+    // a server.  When the queue is full, new messages are dropped.
+    struct Notification {
+        std::string title;
+        std::string message;
+    };
+    static const int     notifyQueueLength = 4;
+    static QueueHandle_t notifyQueue       = nullptr;
+
+    // Pushover and LINE are HTTPS requests to the same server each time, so the
+    // connection is kept open between messages and the TLS handshake is only done
+    // again when the server has closed it.
+    static WiFiClientSecure* httpsClient = nullptr;
+
     bool        NotificationsService::_started = false;
     uint8_t     NotificationsService::_notificationType;
     std::string NotificationsService::_token1;
@@ -108,7 +125,7 @@ namespace WebUI {
             log_string(out, "Invalid message!");
             return Error::InvalidValue;
         }
-        if (!sendMSG("GRBL Notification", parameter)) {
+        if (!queueMSG("GRBL Notification", parameter)) {
             log_string(out, "Cannot send message!");
             return Error::MessageFailed;
         }
@@ -144,6 +161,62 @@ namespace WebUI {
         return false;
     }
 
+    // Sends request and waits for a reply line containing expected_answer, reusing the
+    // open connection if there is one
+    static bool httpsRequest(
+        const std::string& host, uint16_t port, const std::string& request, const char* expected_answer, uint32_t timeout) {
+        if (!httpsClient) {
+            httpsClient = new WiFiClientSecure();
+        }
+        if (httpsClient->connected()) {
+            // Drop whatever is left of the previous reply
+            while (httpsClient->available()) {
+                httpsClient->read();
+            }
+            httpsClient->print(request.c_str());
+            bool res = Wait4Answer(*httpsClient, "{", expected_answer, timeout);
+            if (res || httpsClient->connected()) {
+                return res;
+            }
+            // The server closed the idle connection, so the request went nowhere
+            httpsClient->stop();
+        }
+        if (!httpsClient->connect(host.c_str(), port)) {
+            return false;
+        }
+        httpsClient->print(request.c_str());
+        bool res = Wait4Answer(*httpsClient, "{", expected_answer, timeout);
+        if (!res) {
+            httpsClient->stop();
+        }
+        return res;
+    }
+
+    void NotificationsService::notifyTask(void* unused) {
+        while (true) {
+            Notification* n;
+            if (xQueueReceive(notifyQueue, &n, portMAX_DELAY)) {
+                if (!sendMSG(n->title.c_str(), n->message.c_str())) {
+                    log_info("Cannot send notification: " << n->title);
+                }
+                delete n;
+            }
+        }
+    }
+
+    bool NotificationsService::queueMSG(const char* title, const char* message) {
+        if (!_started || !notifyQueue) {
+            return false;
+        }
+        auto n = new Notification { title, message };
+        if (xQueueSend(notifyQueue, &n, 0) != pdTRUE) {
+            log_debug("Notification queue full, dropped: " << title);
+            delete n;
+            return false;
+        }
+        return true;
+    }
+
     bool NotificationsService::started() {
         return _started;
     }
@@ -186,12 +259,7 @@ namespace WebUI {
     //Messages are currently limited to 1024 4-byte UTF-8 characters
     //but we do not do any check
     bool NotificationsService::sendPushoverMSG(const char* title, const char* message) {
-        std::string      data, postcmd;
-        bool             res;
-        WiFiClientSecure Notificationclient;
-        if (!Notificationclient.connect(_serveraddress.c_str(), _port)) {
-            return false;
-        }
+        std::string data, postcmd;
         //build data for post
         data = "user=";
         data += _token1;
@@ -205,16 +273,13 @@ namespace WebUI {
         data += "&device=";
         data += WiFi.getHostname();
         //build post query
-        postcmd = "POST /1/messages.json HTTP/1.1\r\nHost: api.pushover.net\r\nConnection: close\r\nCache-Control: no-cache\r\nUser-Agent: "
-                  "ESP3D\r\nAccept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\nContent-Length: ";
-        postcmd += data.length();
+        postcmd = "POST /1/messages.json HTTP/1.1\r\nHost: api.pushover.net\r\nConnection: keep-alive\r\nCache-Control: no-cache\r\n"
+                  "User-Agent: ESP3D\r\nAccept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\nContent-Length: ";
+        postcmd += std::to_string(data.length());
         postcmd += "\r\n\r\n";
         postcmd += data;
         //send query
-        Notificationclient.print(postcmd.c_str());
-        res = Wait4Answer(Notificationclient, "{", "\"status\":1", PUSHOVERTIMEOUT);
-        Notificationclient.stop();
-        return res;
+        return httpsRequest(_serveraddress, _port, postcmd, "\"status\":1", PUSHOVERTIMEOUT);
     }
 
     bool NotificationsService::sendEmailMSG(const char* title, const char* message) {
@@ -294,19 +359,14 @@ namespace WebUI {
         return true;
     }
     bool NotificationsService::sendLineMSG(const char* title, const char* message) {
-        std::string      data, postcmd;
-        bool             res;
-        WiFiClientSecure Notificationclient;
+        std::string data, postcmd;
         (void)title;
-        if (!Notificationclient.connect(_serveraddress.c_str(), _port)) {
-            return false;
-        }
         //build data for post
         data = "message=";
         data += message;
         //build post query
-        postcmd = "POST /api/notify HTTP/1.1\r\nHost: notify-api.line.me\r\nConnection: close\r\nCache-Control: no-cache\r\nUser-Agent: "
-                  "ESP3D\r\nAccept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\nContent-Type: "
+        postcmd = "POST /api/notify HTTP/1.1\r\nHost: notify-api.line.me\r\nConnection: keep-alive\r\nCache-Control: no-cache\r\n"
+                  "User-Agent: ESP3D\r\nAccept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\nContent-Type: "
                   "application/x-www-form-urlencoded\r\n";
         postcmd += "Authorization: Bearer ";
         postcmd += _token1 + "\r\n";
@@ -315,10 +375,7 @@ namespace WebUI {
         postcmd += "\r\n\r\n";
         postcmd += data;
         //send query
-        Notificationclient.print(postcmd.c_str());
-        res = Wait4Answer(Notificationclient, "{", "\"status\":200", LINETIMEOUT);
-        Notificationclient.stop();
-        return res;
+        return httpsRequest(_serveraddress, _port, postcmd, "\"status\":200", LINETIMEOUT);
     }
     //Email#serveraddress:port
     bool NotificationsService::getPortFromSettings() {
@@ -419,6 +476,10 @@ namespace WebUI {
             deinit();
         }
         _started = res;
+        if (_started && !notifyQueue) {
+            notifyQueue = xQueueCreate(notifyQueueLength, sizeof(Notification*));
+            Machine::Tasks::create("notify", notifyTask, nullptr);
+        }
     }
 
     void NotificationsService::deinit() {
@@ -444,5 +505,5 @@ namespace WebUI {
 
 // Override weak link
 void notify(const char* title, const char* msg) {
-    WebUI::NotificationsService::sendMSG(title, msg);
+    WebUI::NotificationsService::queueMSG(title, msg);
 }
@@ -19,7 +19,13 @@ namespace WebUI {
             _settings         = "";
         }
 
-        static bool        sendMSG(const char* title, const char* message);
+        // Sends the message now, waiting for the server
+        static bool sendMSG(const char* title, const char* message);
+
+        // Hands the message to the notification task and returns at once.  False if
+        // notifications are off or too many messages are waiting already.
+        static bool queueMSG(const char* title, const char* message);
+
         static const char* getTypeString();
         static bool        started();
 
@@ -37,6 +43,8 @@ namespace WebUI {
         static std::string _serveraddress;
         static uint16_t    _port;
 
+        static void notifyTask(void* unused);
+
         static Error sendMessage(const char* parameter, AuthenticationLevel auth_level, Channel& out);
         static bool  sendPushoverMSG(const char* title, const char* message);
         static bool  sendEmailMSG(const char* title, const char* message);
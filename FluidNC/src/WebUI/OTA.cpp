@@ -2,27 +2,32 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "src/Module.h"
+#include "src/Settings.h"  // WebCommand
 
 #include "src/Logging.h"
+#include "Ethernet.h"  // WebUI::ethernet_on()
 #include <WiFi.h>
 #include "Driver/localfs.h"
 #include <ArduinoOTA.h>
+#include "OtaWriter.h"
 
 class OTA : public Module {
 public:
     OTA(const char* name) : Module(name) {}
 
     void init() override {
-        if (WiFi.getMode() == WIFI_OFF) {
+        if (WiFi.getMode() == WIFI_OFF && !WebUI::ethernet_on()) {
             return;
         }
 
+        new WebCommand("url", WEBCMD, WA, NULL, "Firmware/Fetch", WebUI::OtaWriter::fetch);
+
         ArduinoOTA
             // By default, ArduinoOTA starts MDNS and advertises itself to the ArduinoIDE
             // We don't care about the Arduino IDE, and we want to start MDNS explicitly
             // in Mdns.cpp
             .setMdnsEnabled(false)
-            .setHostname(WiFi.getHostname())
+            .setHostname(WiFi.getMode() == WIFI_OFF ? WebUI::ethernet_hostname() : WiFi.getHostname())
             .onStart([]() {
                 const char* type;
                 if (ArduinoOTA.getCommand() == U_FLASH) {
@@ -70,4 +75,4 @@ public:
     ~OTA() {}
 };
 
-ModuleFactory::InstanceBuilder<OTA> __attribute__((init_priority(106))) ota_module("ota", true);
+ModuleFactory::InstanceBuilder<OTA> __attribute__((init_priority(107))) ota_module("ota", true);
@@ -0,0 +1,256 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "OtaWriter.h"
+
+#include "src/Config.h"    // SUPPORT_TASK_CORE
+#include "src/Logging.h"
+#include "src/HashFS.h"
+#include "src/Protocol.h"  // protocol_send_event
+#include "src/Memory.h"
+
+#include <Update.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace WebUI {
+    static const size_t bufferSize = 4096;  // One flash sector
+
+    struct Buffer {
+        uint8_t* data   = nullptr;
+        size_t   length = 0;
+    };
+    static Buffer buffers[2];
+
+    static QueueHandle_t full_queue = nullptr;  // Buffers waiting for the writer
+    static QueueHandle_t free_queue = nullptr;  // Buffers ready to be filled
+    static int           current    = -1;       // The buffer being filled, if any
+
+    static HashFS::Hasher* hasher = nullptr;
+    static std::string     expected;
+    static bool            active   = false;  // Between begin() and end() or abort()
+    static volatile bool   failed   = false;
+    static volatile bool   fetching = false;
+
+    const char* OtaWriter::_error = nullptr;
+
+    void OtaWriter::writerTask(void* unused) {
+        while (true) {
+            int which;
+            if (xQueueReceive(full_queue, &which, portMAX_DELAY)) {
+                Buffer& b = buffers[which];
+                if (!failed) {
+                    hasher->update(b.data, b.length);
+                    if (Update.write(b.data, b.length) != b.length) {
+                        _error = "Flash write failed";
+                        failed = true;
+                    }
+                }
+                xQueueSend(free_queue, &which, portMAX_DELAY);
+            }
+        }
+    }
+
+    // Hands over the partly filled buffer and waits until both have been written
+    static void drain() {
+        active = false;
+        if (current >= 0) {
+            xQueueSend(buffers[current].length ? full_queue : free_queue, &current, portMAX_DELAY);
+            current = -1;
+        }
+        for (int i = 0; i < 2; ++i) {
+            int which;
+            xQueueReceive(free_queue, &which, portMAX_DELAY);
+        }
+        for (auto& b : buffers) {
+            Memory::free(b.data);
+            b.data = nullptr;
+        }
+    }
+
+    bool OtaWriter::begin(const std::string& expectedHash) {
+        if (active) {
+            _error = "An update is already in progress";
+            return false;
+        }
+        if (!full_queue) {
+            full_queue = xQueueCreate(2, sizeof(int));
+            free_queue = xQueueCreate(2, sizeof(int));
+            xTaskCreatePinnedToCore(writerTask,        // task
+                                    "otawriter",       // name for task
+                                    4096,              // size of task stack
+                                    0,                 // parameters
+                                    1,                 // priority
+                                    nullptr,           // task handle
+                                    SUPPORT_TASK_CORE  // core
+            );
+        }
+        _error = nullptr;
+        failed = false;
+        for (auto& b : buffers) {
+            if (!b.data) {
+                b.data = static_cast<uint8_t*>(Memory::alloc(bufferSize, Memory::Region::Bulk));
+            }
+        }
+        if (!buffers[0].data || !buffers[1].data) {
+            for (auto& b : buffers) {
+                Memory::free(b.data);
+                b.data = nullptr;
+            }
+            _error = "Not enough memory";
+            return false;
+        }
+        xQueueReset(full_queue);
+        xQueueReset(free_queue);
+        for (int which = 0; which < 2; ++which) {
+            xQueueSend(free_queue, &which, 0);
+        }
+        active   = true;
+        current  = -1;
+        expected = expectedHash;
+        delete hasher;
+        hasher = new HashFS::Hasher;
+        if (!Update.begin()) {  // Start with max available size
+            _error = "Not enough space";
+            drain();
+            return false;
+        }
+        return true;
+    }
+
+    bool OtaWriter::write(const uint8_t* data, size_t length) {
+        while (length && !failed) {
+            if (current < 0) {
+                xQueueReceive(free_queue, &current, portMAX_DELAY);
+                buffers[current].length = 0;
+            }
+            Buffer& b = buffers[current];
+            size_t  n = std::min(length, bufferSize - b.length);
+            memcpy(b.data + b.length, data, n);
+            b.length += n;
+            data += n;
+            length -= n;
+            if (b.length == bufferSize) {
+                xQueueSend(full_queue, &current, portMAX_DELAY);
+                current = -1;
+            }
+        }
+        return !failed;
+    }
+
+    bool OtaWriter::end() {
+        if (!active) {
+            return false;
+        }
+        drain();
+        if (!failed && !expected.empty()) {
+            std::string hash = hasher->finish();
+            if (hash != expected) {
+                log_info("Update hash mismatch - exp " << expected << " got " << hash);
+                _error = "Image hash mismatch";
+                failed = true;
+            }
+        }
+        delete hasher;
+        hasher = nullptr;
+        if (failed) {
+            Update.abort();
+            return false;
+        }
+        if (!Update.end(true)) {  // true to set the size to the current progress
+            _error = "Image not valid";
+            return false;
+        }
+        return true;
+    }
+
+    void OtaWriter::abort() {
+        if (!active) {
+            return;
+        }
+        drain();
+        delete hasher;
+        hasher = nullptr;
+        Update.abort();
+    }
+
+    // Lets HTTPClient::writeToStream(), which undoes chunked transfer encoding,
+    // deliver the body straight to the writer
+    class OtaStream : public Stream {
+    public:
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t* buffer, size_t size) override { return OtaWriter::write(buffer, size) ? size : 0; }
+        int    available() override { return 0; }
+        int    read() override { return -1; }
+        int    peek() override { return -1; }
+        void   flush() override {}
+    };
+
+    void OtaWriter::fetchTask(void* arg) {
+        auto             url = static_cast<std::string*>(arg);
+        HTTPClient       http;
+        WiFiClient       plain;
+        WiFiClientSecure secure;
+        bool             ok;
+        if (url->compare(0, 6, "https:") == 0) {
+            // There is no certificate store, so the image is trusted for its own checksum
+            secure.setInsecure();
+            ok = http.begin(secure, url->c_str());
+        } else {
+            ok = http.begin(plain, url->c_str());
+        }
+        int code = ok ? http.GET() : -1;
+        if (code != HTTP_CODE_OK) {
+            log_error("Firmware fetch failed: HTTP " << code);
+        } else if (!begin("")) {
+            log_error("Firmware fetch failed: " << _error);
+        } else {
+            uint32_t  start = millis();
+            OtaStream stream;
+            int       size = http.writeToStream(&stream);
+            if (size > 0 && end()) {
+                log_info("Firmware fetched, " << size << " bytes in " << (millis() - start) << "ms; restarting");
+                protocol_send_event(&fullResetEvent);
+            } else {
+                if (size > 0) {
+                    log_error("Firmware fetch failed: " << _error);
+                } else {
+                    abort();
+                    log_error("Firmware fetch failed: " << (_error ? _error : http.errorToString(size).c_str()));
+                }
+            }
+        }
+        http.end();
+        delete url;
+        fetching = false;
+        vTaskDelete(NULL);
+    }
+
+    Error OtaWriter::fetch(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+        if (!parameter || !*parameter) {
+            log_error_to(out, "Usage: $Firmware/Fetch=<url>");
+            return Error::InvalidValue;
+        }
+        if (fetching || active) {
+            log_error_to(out, "An update is already in progress");
+            return Error::AnotherInterfaceBusy;
+        }
+        fetching = true;
+        log_info_to(out, "Fetching " << parameter);
+        xTaskCreatePinnedToCore(fetchTask,                   // task
+                                "otafetch",                  // name for task
+                                8192,                        // size of task stack, enough for a TLS handshake
+                                new std::string(parameter),  // parameters
+                                1,                           // priority
+                                nullptr,                     // task handle
+                                SUPPORT_TASK_CORE            // core
+        );
+        return Error::Ok;
+    }
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  OtaWriter.h - firmware image writer for web and fetched updates
+
+  The image is collected in two flash-sector-sized buffers.  When one is full
+  it goes to a writer task, which writes it to the update partition and adds
+  it to the image hash, while the caller fills the other one from the network.
+  Flash erase and write time is thus overlapped with receiving instead of
+  added to it, and the web server is only held up when both buffers are
+  waiting to be written.
+*/
+
+#include "src/Error.h"
+#include "src/WebUI/Authentication.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Channel;
+
+namespace WebUI {
+    class OtaWriter {
+    public:
+        // Starts writing an image to the update partition.  If expectedHash is not
+        // empty, end() fails unless the image hash, in HashFS format, matches it.
+        static bool begin(const std::string& expectedHash);
+
+        // Returns false if this or an earlier write failed
+        static bool write(const uint8_t* data, size_t length);
+
+        // Writes what is left, checks the hash and marks the image bootable
+        static bool end();
+
+        // Waits for the writer and discards the image; nothing if no image is being written
+        static void abort();
+
+        static const char* errorString() { return _error; }
+
+        // $Firmware/Fetch=<url> downloads an image over HTTP or HTTPS from a task of
+        // its own, and restarts with it when it has been written
+        static Error fetch(const char* parameter, AuthenticationLevel auth_level, Channel& out);
+
+    private:
+        static const char* _error;
+
+        static void writerTask(void* unused);
+        static void fetchTask(void* arg);
+    };
+}
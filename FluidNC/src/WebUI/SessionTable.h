@@ -0,0 +1,154 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  SessionTable.h - login sessions of the web server
+
+  Every authenticated request looks its session up by client address and
+  session ID, so the sessions are kept in a fixed open-addressed table hashed
+  on the session ID, with linear probing.  A lookup is a hash and usually one
+  compare, and a session costs no heap.  Removal shifts the following entries
+  of the probe run back, so there are no tombstones to clean up.
+
+  Sessions expire after lifetimeMs without a request.  Each lookup also checks
+  one slot of the table for expiry, round-robin, so stale sessions are swept a
+  slot at a time instead of in a walk over the whole table.
+*/
+
+#include "Authentication.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+template <size_t Slots>
+class SessionTable {
+public:
+    static const uint32_t lifetimeMs  = 360000;
+    static const size_t   maxSessions = Slots * 2 / 3;  // Keeps probe runs short
+    static const size_t   idLength    = 16;
+
+    struct Session {
+        bool                used = false;
+        uint32_t            ip   = 0;
+        AuthenticationLevel level;
+        char                userID[idLength + 1];
+        char                sessionID[idLength + 1];
+        uint32_t            last_time;
+    };
+
+    // Adds a session, or returns nullptr if the table is full or sessionID is in use
+    Session* add(uint32_t ip, AuthenticationLevel level, const char* userID, const char* sessionID, uint32_t now) {
+        if (_count >= maxSessions || lookup(ip, sessionID) != Slots) {
+            return nullptr;
+        }
+        size_t i = home(sessionID);
+        while (_slots[i].used) {
+            i = next(i);
+        }
+        Session& s = _slots[i];
+        s.used     = true;
+        s.ip       = ip;
+        s.level    = level;
+        copy(s.userID, userID);
+        copy(s.sessionID, sessionID);
+        s.last_time = now;
+        ++_count;
+        return &s;
+    }
+
+    // The unexpired session with this address and ID, or nullptr
+    Session* find(uint32_t ip, const char* sessionID, uint32_t now) {
+        sweep(now);
+        size_t i = lookup(ip, sessionID);
+        if (i == Slots) {
+            return nullptr;
+        }
+        if (expired(_slots[i], now)) {
+            erase(i);
+            return nullptr;
+        }
+        return &_slots[i];
+    }
+
+    // Returns false if there was no such session
+    bool remove(uint32_t ip, const char* sessionID) {
+        size_t i = lookup(ip, sessionID);
+        if (i == Slots) {
+            return false;
+        }
+        erase(i);
+        return true;
+    }
+
+    void clear() {
+        for (auto& s : _slots) {
+            s.used = false;
+        }
+        _count = 0;
+    }
+
+    size_t size() const { return _count; }
+
+private:
+    Session _slots[Slots];
+    size_t  _count = 0;
+    size_t  _sweep = 0;  // The next slot to check for expiry
+
+    static size_t next(size_t i) { return i + 1 == Slots ? 0 : i + 1; }
+
+    static bool expired(const Session& s, uint32_t now) { return now - s.last_time > lifetimeMs; }
+
+    static void copy(char* to, const char* from) {
+        strncpy(to, from, idLength);
+        to[idLength] = '\0';
+    }
+
+    // FNV-1a of the session ID, as stored
+    static size_t home(const char* sessionID) {
+        uint32_t h = 2166136261u;
+        for (size_t n = 0; n < idLength && sessionID[n]; ++n) {
+            h = (h ^ uint8_t(sessionID[n])) * 16777619u;
+        }
+        return h % Slots;
+    }
+
+    // The slot of the session, or Slots if there is none.  A probe run always
+    // ends at a free slot because the table is never full.
+    size_t lookup(uint32_t ip, const char* sessionID) const {
+        for (size_t i = home(sessionID); _slots[i].used; i = next(i)) {
+            const Session& s = _slots[i];
+            if (s.ip == ip && strncmp(s.sessionID, sessionID, idLength) == 0 && strlen(sessionID) <= idLength) {
+                return i;
+            }
+        }
+        return Slots;
+    }
+
+    // Frees slot i, moving back any later entry of the run that would no longer be
+    // reachable from its home slot
+    void erase(size_t i) {
+        _slots[i].used = false;
+        --_count;
+        for (size_t j = next(i); _slots[j].used; j = next(j)) {
+            size_t h = home(_slots[j].sessionID);
+            // Entry j may move to i unless its home lies cyclically in (i, j]
+            bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+            if (!stays) {
+                _slots[i]      = _slots[j];
+                _slots[j].used = false;
+                i              = j;
+            }
+        }
+    }
+
+    void sweep(uint32_t now) {
+        size_t i = _sweep;
+        _sweep   = next(_sweep);
+        if (_slots[i].used && expired(_slots[i], now)) {
+            erase(i);
+        }
+    }
+};
@@ -7,9 +7,31 @@
 #include <WiFi.h>
 
 namespace WebUI {
-    TelnetClient::TelnetClient(WiFiClient* wifiClient) : Channel("telnet"), _wifiClient(wifiClient) {}
+    TelnetClient::TelnetClient(WiFiClient* wifiClient) : Channel("telnet"), _wifiClient(wifiClient) {
+        TelnetServer::_clients++;
+        _wifiClient->setNoDelay(TelnetServer::noDelay());
+    }
+
+    // Output written from outside the output task, which flushes after each
+    // batch, goes out on the next poll.
+    void TelnetClient::handle() {
+        flush();
+    }
+
+    void TelnetClient::sendTx() {
+        if (_txLength) {
+            auto nWritten = _wifiClient->write(_txBuffer, _txLength);
+            _txLength     = 0;
+            if (nWritten == 0) {
+                closeOnDisconnect();
+            }
+        }
+    }
 
-    void TelnetClient::handle() {}
+    void TelnetClient::flush() {
+        std::lock_guard<std::mutex> lock(_txMutex);
+        sendTx();
+    }
 
     void TelnetClient::closeOnDisconnect() {
         if (_state != -1 && !_wifiClient->connected()) {
@@ -27,30 +49,20 @@ namespace WebUI {
     }
 
     size_t TelnetClient::write(const uint8_t* buffer, size_t length) {
+        std::lock_guard<std::mutex> lock(_txMutex);
         // Replace \n with \r\n
-        size_t  rem      = length;
-        uint8_t lastchar = '\0';
-        size_t  j        = 0;
-        while (rem) {
-            const int bufsize = 128;
-            uint8_t   modbuf[bufsize];
-            // bufsize-1 in case the last character is \n
-            size_t k = 0;
-            while (rem && k < (bufsize - 1)) {
-                uint8_t c = buffer[j++];
-                if (c == '\n' && lastchar != '\r') {
-                    modbuf[k++] = '\r';
-                }
-                lastchar    = c;
-                modbuf[k++] = c;
-                --rem;
+        uint8_t lastchar = _txLength ? _txBuffer[_txLength - 1] : '\0';
+        for (size_t j = 0; j < length; ++j) {
+            // Room for two in case the character is \n
+            if (_txLength > TX_BUFFER_SIZE - 2) {
+                sendTx();
             }
-            if (k) {
-                auto nWritten = _wifiClient->write(modbuf, k);
-                if (nWritten == 0) {
-                    closeOnDisconnect();
-                }
+            uint8_t c = buffer[j];
+            if (c == '\n' && lastchar != '\r') {
+                _txBuffer[_txLength++] = '\r';
             }
+            lastchar               = c;
+            _txBuffer[_txLength++] = c;
         }
         return length;
     }
@@ -88,6 +100,7 @@ namespace WebUI {
     }
 
     TelnetClient::~TelnetClient() {
+        TelnetServer::_clients--;
         delete _wifiClient;
     }
 }
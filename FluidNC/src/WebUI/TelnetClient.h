@@ -6,6 +6,7 @@
 #include "src/Channel.h"
 
 #include <WiFi.h>
+#include <mutex>
 
 namespace WebUI {
     class TelnetClient : public Channel {
@@ -23,6 +24,17 @@ namespace WebUI {
 
         int _state = 0;
 
+        // Output collects here until a flush point, such as the end of an output
+        // batch, so a report goes out as one TCP segment rather than a segment
+        // per write.  The size fits in one Ethernet-sized segment.
+        static const size_t TX_BUFFER_SIZE = 1400;
+
+        uint8_t    _txBuffer[TX_BUFFER_SIZE];
+        size_t     _txLength = 0;
+        std::mutex _txMutex;
+
+        void sendTx();  // Call with _txMutex held
+
     public:
         TelnetClient(WiFiClient* wifiClient);
 
@@ -32,7 +44,7 @@ namespace WebUI {
         int    read(void) override;
         int    peek(void) override;
         int    available() override;
-        void   flush() override {}
+        void   flush() override;
         void   flushRx() override;
 
         void closeOnDisconnect();
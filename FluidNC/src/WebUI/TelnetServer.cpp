@@ -6,6 +6,7 @@
 #include "TelnetServer.h"
 
 #include "Mdns.h"
+#include "Ethernet.h"  // ethernet_on()
 #include "src/Report.h"  // report_init_message()
 
 #include <WiFi.h>
@@ -14,13 +15,22 @@ namespace WebUI {
 
     EnumSetting* telnet_enable;
     IntSetting*  telnet_port;
+    EnumSetting* telnet_nodelay;
+    IntSetting*  telnet_max_clients;
 
-    uint16_t TelnetServer::_port = 0;
+    uint16_t TelnetServer::_port    = 0;
+    int      TelnetServer::_clients = 0;
+
+    // With TCP_NODELAY, each flush goes out at once.  Without it, Nagle's
+    // algorithm may merge small flushes further at the cost of latency.
+    bool TelnetServer::noDelay() {
+        return !telnet_nodelay || telnet_nodelay->get();
+    }
 
     std::queue<TelnetClient*> TelnetServer::_disconnected;
 
     void TelnetServer::init() {
-        if (WiFi.getMode() == WIFI_OFF) {
+        if (WiFi.getMode() == WIFI_OFF && !ethernet_on()) {
             return;
         }
 
@@ -31,14 +41,19 @@ namespace WebUI {
 
         telnet_enable = new EnumSetting("Telnet Enable", WEBSET, WA, "ESP130", "Telnet/Enable", DEFAULT_TELNET_STATE, &onoffOptions);
 
+        telnet_nodelay = new EnumSetting("Telnet TCP_NODELAY", WEBSET, WA, NULL, "Telnet/NoDelay", 1, &onoffOptions);
+
+        telnet_max_clients =
+            new IntSetting("Telnet Max Clients", WEBSET, WA, NULL, "Telnet/MaxClients", DEFAULT_TLNT_CLIENTS, 1, MAX_TLNT_CLIENTS);
+
         if (!WebUI::telnet_enable->get()) {
             return;
         }
         _port = WebUI::telnet_port->get();
 
         //create instance
-        _wifiServer = new WiFiServer(_port, MAX_TLNT_CLIENTS);
-        _wifiServer->setNoDelay(true);
+        _wifiServer = new WiFiServer(_port, telnet_max_clients->get());
+        _wifiServer->setNoDelay(noDelay());
         log_info("Telnet started on port " << _port);
         //start telnet server
         _wifiServer->begin();
@@ -73,6 +88,12 @@ namespace WebUI {
 
         //check if there are any new clients
         if (_wifiServer->hasClient()) {
+            if (_clients >= telnet_max_clients->get()) {
+                WiFiClient extra = _wifiServer->available();
+                log_debug("Telnet from " << extra.remoteIP() << " refused; too many clients");
+                extra.stop();
+                return;
+            }
             WiFiClient* tcpClient = new WiFiClient(_wifiServer->available());
             if (!tcpClient) {
                 log_error("Creating telnet client failed");
@@ -20,7 +20,8 @@ namespace WebUI {
         static const int MAX_TELNET_PORT = 65001;
         static const int MIN_TELNET_PORT = 1;
 
-        static const int MAX_TLNT_CLIENTS = 2;
+        static const int DEFAULT_TLNT_CLIENTS = 2;
+        static const int MAX_TLNT_CLIENTS     = 8;
 
         static const int FLUSHTIMEOUT = 500;
 
@@ -28,6 +29,10 @@ namespace WebUI {
         TelnetServer(const char* name) : Module(name) {}
 
         static uint16_t port() { return _port; }
+        static bool     noDelay();
+
+        // The number of live clients, which is limited by Telnet/MaxClients
+        static int _clients;
 
         static std::queue<TelnetClient*> _disconnected;
 
@@ -7,8 +7,16 @@
 #include "WebServer.h"
 #include <WebSocketsServer.h>
 #include <WiFi.h>
+#include <algorithm>
+#include <vector>
 
-#include "src/Serial.h"  // is_realtime_command
+#include "src/Serial.h"    // is_realtime_command
+#include "src/Protocol.h"  // protocol_wake_polling
+#include "src/Machine/MachineConfig.h"  // config
+#include "src/Limits.h"                 // limits_get_state
+#include "src/Planner.h"
+#include "src/Stepper.h"
+#include "src/System.h"  // sys, get_mpos
 
 namespace WebUI {
     class WSChannels;
@@ -60,14 +68,11 @@ namespace WebUI {
             out    = (uint8_t*)_output_line.c_str();
             outlen = _output_line.length();
         }
-        int stat = _server->canSend(_clientNum);
-        if (stat < 0) {
-            _active = false;
-            return 0;
-        }
-        if (!_server->sendBIN(_clientNum, out, outlen)) {
-            _active = false;
-        }
+        // A pending status report is superseded by a newer one, unless the reports
+        // are deltas, each of which depends on the ones before it.
+        bool status = out[0] == '<' && !getReportDelta();
+        // Binary messages to a /binary client are frames, so text goes as text.
+        queue(out, outlen, _binary, status);
         if (_output_line.length()) {
             _output_line = "";
         }
@@ -79,29 +84,208 @@ namespace WebUI {
         if (!_active) {
             return false;
         }
-        if (!_server->sendTXT(_clientNum, s.c_str())) {
-            _active = false;
-            log_debug_to(Uart0, "WebSocket is unresponsive; closing");
+        return queue((const uint8_t*)s.c_str(), s.length(), true, false);
+    }
+
+    bool WSChannel::queue(const uint8_t* data, size_t length, bool text, bool latestOnly) {
+        std::lock_guard<std::mutex> lock(_txMutex);
+        if (latestOnly) {
+            for (auto& msg : _txQueue) {
+                if (msg.latestOnly) {
+                    _txBytes = _txBytes - msg.data.length() + length;
+                    msg.data.assign((const char*)data, length);
+                    return true;
+                }
+            }
+        }
+        if (_txBytes + length > txQueueLimit) {
+            if (_dropped++ == 0) {
+                _overflowStart = millis();
+            } else if (millis() - _overflowStart >= slowClientMs) {
+                _slow = true;
+            }
+            return false;
+        }
+        _txQueue.push_back({ std::string((const char*)data, length), text, latestOnly });
+        _txBytes += length;
+        protocol_wake_polling();
+        return true;
+    }
+
+    bool WSChannel::drain() {
+        std::unique_lock<std::mutex> lock(_txMutex);
+        if (_slow) {
+            if (_active) {
+                _active = false;
+                log_info_to(Uart0, "WebSocket " << _clientNum << " is not keeping up; closing");
+            }
             return false;
         }
+        while (!_txQueue.empty()) {
+            int stat = _active ? _server->canSend(_clientNum) : -1;
+            if (stat < 0) {
+                if (_active) {
+                    _active = false;
+                    log_debug_to(Uart0, "WebSocket is dead; closing");
+                }
+                _txQueue.clear();
+                _txBytes = 0;
+                break;
+            }
+            if (stat == 0) {
+                return true;
+            }
+            TxMessage msg = std::move(_txQueue.front());
+            _txQueue.pop_front();
+            _txBytes -= msg.data.length();
+            // Writers can go on queueing while this message is sent
+            lock.unlock();
+            auto data = (uint8_t*)msg.data.c_str();
+            auto len  = msg.data.length();
+            if (!(msg.text ? _server->sendTXT(_clientNum, data, len) : _server->sendBIN(_clientNum, data, len))) {
+                _active = false;
+                log_debug_to(Uart0, "WebSocket is unresponsive; closing");
+            }
+            lock.lock();
+        }
+        if (_dropped) {
+            log_debug_to(Uart0, "WebSocket " << _clientNum << " dropped " << _dropped << " messages");
+            _dropped = 0;
+        }
         return true;
     }
 
+    void WSChannel::disconnect() {
+        _server->disconnect(_clientNum);
+    }
+
     void WSChannel::autoReport() {
         if (!_active) {
             return;
         }
-        int stat = _server->canSend(_clientNum);
-        if (stat < 0) {
-            _active = false;
-            log_debug_to(Uart0, "WebSocket is dead; closing");
+        Channel::autoReport();
+    }
+
+    bool WSChannel::sendFrame(uint8_t kind, const void* payload, size_t length) {
+        if (!_active) {
+            return false;
+        }
+        uint8_t frame[WSFrame::headerSize + sizeof(BinaryStatus)];
+        Assert(length <= sizeof(frame) - WSFrame::headerSize, "WebSocket frame too long");
+        frame[0] = kind;
+        frame[1] = length & 0xff;
+        frame[2] = length >> 8;
+        memcpy(frame + WSFrame::headerSize, payload, length);
+        // Binary status reports are always complete, so only the latest is needed
+        return queue(frame, WSFrame::headerSize + length, false, kind == WSFrame::Status);
+    }
+
+    void WSChannel::reportStatus() {
+        if (!_binary) {
+            Channel::reportStatus();
             return;
         }
-        if (stat == 0) {
+        BinaryStatus status;
+        status.state             = uint8_t(sys.state);
+        status.n_axis            = uint8_t(Axes::_numberAxis);
+        status.planner_available = uint16_t(plan_get_block_buffer_available());
+        status.rx_available      = uint16_t(rx_buffer_available());
+
+        plan_block_t* cur_block = plan_get_current_block();
+        status.line_number      = cur_block ? cur_block->line_number : 0;
+
+        status.feed_rate        = Stepper::get_realtime_rate();
+        status.spindle_speed    = sys.spindle_speed;
+        status.limits           = limits_get_state();
+        status.probe            = config->_probe->get_state();
+        status.feed_override    = sys.f_override;
+        status.rapid_override   = sys.r_override;
+        status.spindle_override = sys.spindle_speed_ovr;
+
+        memset(status.mpos, 0, sizeof(status.mpos));
+        memcpy(status.mpos, get_mpos(), Axes::_numberAxis * sizeof(float));
+
+        sendFrame(WSFrame::Status, &status, sizeof(status));
+    }
+
+    void WSChannel::autoReportStatus() {
+        if (_binary) {
+            reportStatus();
+        } else {
+            Channel::autoReportStatus();
+        }
+    }
+
+    void WSChannel::ack(Error status) {
+        if (!_binary || _lineIds.empty()) {
+            // Lines that did not come in GCode frames, e.g. from the HTTP command API
+            Channel::ack(status);
             return;
         }
+        auto& run = _lineIds.front();
+        uint8_t payload[5];
+        memcpy(payload, &run.first, sizeof(run.first));
+        payload[4] = uint8_t(status);
+        ++run.first;
+        if (--run.second == 0) {
+            _lineIds.pop_front();
+        }
+        sendFrame(WSFrame::Ack, payload, sizeof(payload));
+    }
 
-        Channel::autoReport();
+    void WSChannel::pushFrames(const uint8_t* data, size_t length) {
+        while (length >= WSFrame::headerSize) {
+            uint8_t kind = data[0];
+            size_t  len  = data[1] | (data[2] << 8);
+            data += WSFrame::headerSize;
+            length -= WSFrame::headerSize;
+            if (len > length) {
+                log_error_to(*this, "Truncated WebSocket frame");
+                return;
+            }
+            switch (kind) {
+                case WSFrame::GCode: {
+                    uint32_t id;
+                    if (len < sizeof(id)) {
+                        log_error_to(*this, "Short GCode frame");
+                        break;
+                    }
+                    memcpy(&id, data, sizeof(id));
+                    std::string_view lines((const char*)data + sizeof(id), len - sizeof(id));
+                    if (lines.empty()) {
+                        break;
+                    }
+                    if (int(lines.length()) + 1 > rx_buffer_available()) {
+                        // The ids would no longer match the lines, so reject the whole frame
+                        uint8_t payload[5];
+                        memcpy(payload, &id, sizeof(id));
+                        payload[4] = uint8_t(Error::Overflow);
+                        sendFrame(WSFrame::Ack, payload, sizeof(payload));
+                        break;
+                    }
+                    uint32_t count = std::count(lines.begin(), lines.end(), '\n');
+                    push(lines);
+                    if (lines.back() != '\n') {
+                        push('\n');
+                        ++count;
+                    }
+                    _lineIds.emplace_back(id, count);
+                } break;
+                case WSFrame::Realtime:
+                    for (size_t i = 0; i < len; ++i) {
+                        handleRealtimeCharacter(data[i]);
+                    }
+                    break;
+                case WSFrame::Status:
+                    reportStatus();
+                    break;
+                default:
+                    log_error_to(*this, "Unknown WebSocket frame " << int(kind));
+                    break;
+            }
+            data += len;
+            length -= len;
+        }
     }
 
     WSChannel::~WSChannel() {}
@@ -191,6 +375,20 @@ namespace WebUI {
         }
     }
 
+    void WSChannels::drain() {
+        // Disconnecting removes the channel from _wsChannels, so it cannot be done
+        // while iterating over it
+        std::vector<WSChannel*> slow;
+        for (auto& [num, wsChannel] : _wsChannels) {
+            if (!wsChannel->drain()) {
+                slow.push_back(wsChannel);
+            }
+        }
+        for (auto wsChannel : slow) {
+            wsChannel->disconnect();
+        }
+    }
+
     void WSChannels::handleEvent(WebSocketsServer* server, uint8_t num, uint8_t type, uint8_t* payload, size_t length) {
         switch (type) {
             case WStype_DISCONNECTED:
@@ -255,6 +453,9 @@ namespace WebUI {
                     allChannels.registration(wsChannel);
                     _wsChannels[num] = wsChannel;
 
+                    if (uri == "/binary") {
+                        wsChannel->setBinary();
+                    }
                     if (uri == "/") {
                         std::string s("currentID:");
                         s += std::to_string(num);
@@ -266,7 +467,9 @@ namespace WebUI {
                         server->broadcastTXT(s.c_str());
                     }
 
-                    for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++)
+                    // Binary clients are machine interfaces, not WebUI pages, so they
+                    // do not take over from one.
+                    for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX && !wsChannel->isBinary(); i++)
                         if (i != num && server->clientIsConnected(i)) {
                             server->disconnect(i);
                         }
@@ -284,7 +487,12 @@ namespace WebUI {
                 break;
             case WStype_BIN:
                 try {
-                    _wsChannels.at(num)->push(payload, length);
+                    WSChannel* wsChannel = _wsChannels.at(num);
+                    if (wsChannel->isBinary()) {
+                        wsChannel->pushFrames(payload, length);
+                    } else {
+                        wsChannel->push(payload, length);
+                    }
                 } catch (std::out_of_range& oor) {}
                 break;
             default:
@@ -5,14 +5,49 @@
 
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <list>
 #include <map>
+#include <mutex>
+#include <string>
+#include <utility>
 
 class WebSocketsServer;
 
 #include "src/Channel.h"
+#include "src/Config.h"  // MAX_N_AXIS
 
 namespace WebUI {
+    // A WebSocket client that connects with the URI /binary speaks a framed protocol in
+    // binary messages.  A message holds one or more frames, each a one-byte kind and a
+    // 16-bit little-endian payload length followed by the payload.  Text messages in
+    // both directions are unchanged, so log output and [MSG: lines still arrive as text.
+    namespace WSFrame {
+        const uint8_t GCode    = 'G';  // Client: uint32 id of the first line, then lines of GCode
+        const uint8_t Realtime = 'R';  // Client: realtime command bytes
+        const uint8_t Status   = 'S';  // Client: status request, no payload; server: BinaryStatus
+        const uint8_t Ack      = 'A';  // Server: uint32 line id, uint8 Error code (0 is ok)
+
+        const size_t headerSize = 3;
+    }
+
+    // All values are little-endian, as on the ESP32.
+    struct __attribute__((packed)) BinaryStatus {
+        uint8_t  state;              // State enum value
+        uint8_t  n_axis;             // Number of valid mpos entries
+        uint16_t planner_available;  // Free planner blocks
+        uint16_t rx_available;       // Free bytes in the channel input queue
+        uint32_t line_number;        // Of the executing block, 0 if none
+        float    feed_rate;          // mm/min
+        uint32_t spindle_speed;
+        uint32_t limits;  // MotorMask of active limit switches
+        uint8_t  probe;   // Nonzero if the probe is active
+        uint8_t  feed_override;
+        uint8_t  rapid_override;
+        uint8_t  spindle_override;
+        float    mpos[MAX_N_AXIS];  // mm
+    };
+
     class WSChannel : public Channel {
     public:
         WSChannel(WebSocketsServer* server, uint8_t clientNum);
@@ -32,8 +67,6 @@ namespace WebUI {
 
         int id() { return _clientNum; }
 
-        int rx_buffer_available() override { return std::max(0, 256 - int(_queue.size())); }
-
         operator bool() const;
 
         ~WSChannel();
@@ -42,8 +75,50 @@ namespace WebUI {
         int available() override { return _queue.size() + (_rtchar > -1); }
 
         void autoReport() override;
+        void reportStatus() override;
+        void autoReportStatus() override;
+        void ack(Error status) override;
+
+        void setBinary() { _binary = true; }
+        bool isBinary() { return _binary; }
+
+        // Parses the frames in a binary message from a /binary client
+        void pushFrames(const uint8_t* data, size_t length);
+
+        // Sends queued messages while the client can take them.  Returns false if
+        // the client has fallen too far behind and should be disconnected.
+        bool drain();
+
+        void disconnect();
 
     private:
+        // Output is queued and sent from the polling task by drain(), so a client on a
+        // slow link delays only itself and not the tasks that write to all channels.
+        struct TxMessage {
+            std::string data;
+            bool        text;        // sendTXT instead of sendBIN
+            bool        latestOnly;  // A status report that a newer one replaces
+        };
+
+        static const size_t   txQueueLimit = 8192;  // Bytes
+        static const uint32_t slowClientMs = 5000;  // Overflowing this long disconnects
+
+        bool queue(const uint8_t* data, size_t length, bool text, bool latestOnly);
+
+        std::deque<TxMessage> _txQueue;
+        size_t                _txBytes = 0;
+        std::mutex            _txMutex;
+        uint32_t              _dropped       = 0;  // Messages dropped since the queue last emptied
+        uint32_t              _overflowStart = 0;  // millis() of the first of them
+        bool                  _slow          = false;
+
+        bool sendFrame(uint8_t kind, const void* payload, size_t length);
+
+        bool _binary = false;
+
+        // Ids of queued lines awaiting acknowledgment, as (next id, lines left) runs
+        std::deque<std::pair<uint32_t, uint32_t>> _lineIds;
+
         WebSocketsServer* _server;
         uint8_t           _clientNum;
 
@@ -67,9 +142,11 @@ namespace WebUI {
         static void removeChannel(WSChannel* channel);
         static void removeChannel(uint8_t num);
 
+        static bool hasChannel(int pageid) { return getWSChannel(pageid) != nullptr; }
         static bool runGCode(int pageid, std::string_view cmd);
         static bool sendError(int pageid, std::string error);
         static void sendPing();
+        static void drain();
         static void handleEvent(WebSocketsServer* server, uint8_t num, uint8_t type, uint8_t* payload, size_t length);
         static void handlev3Event(WebSocketsServer* server, uint8_t num, uint8_t type, uint8_t* payload, size_t length);
     };
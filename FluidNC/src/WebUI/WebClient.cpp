@@ -72,6 +72,12 @@ namespace WebUI {
     void WebClient::sendLine(MsgLevel level, const std::string& line) {
         print_msg(level, line.c_str());
     }
+    void WebClient::sendLine(MsgLevel level, std::string_view line) {
+        if (_message_level >= level) {
+            write(reinterpret_cast<const uint8_t*>(line.data()), line.length());
+            println();
+        }
+    }
 
     void WebClient::out(const char* s, const char* tag) {
         write((uint8_t*)s, strlen(s));
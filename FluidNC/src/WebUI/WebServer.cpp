@@ -6,8 +6,10 @@
 #include "src/Settings.h"  // settings_execute_line()
 
 #include "WebServer.h"
+#include "OtaWriter.h"
 
 #include "Mdns.h"
+#include "Ethernet.h"  // ethernet_on()
 
 #include <WebSocketsServer.h>
 #include <WiFi.h>
@@ -21,13 +23,23 @@
 #include "WSChannel.h"
 
 #include "WebClient.h"
+#include "BatchChannel.h"
 
 #include "src/Protocol.h"  // protocol_send_event
 #include "src/FluidPath.h"
 #include "src/JSONEncoder.h"
 
 #include "src/HashFS.h"
+#include "src/BootTiming.h"
+#include "src/DirCache.h"
+#include "src/Memory.h"
+#include "src/Metrics.h"
 #include <list>
+#include <map>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 namespace WebUI {
     const byte DNS_PORT = 53;
@@ -59,14 +71,69 @@ namespace WebUI {
     WebSocketsServer* Web_Server::_socket_server   = NULL;
     WebSocketsServer* Web_Server::_socket_serverv3 = NULL;
 #ifdef ENABLE_AUTHENTICATION
-    AuthenticationIP* Web_Server::_head  = NULL;
-    uint8_t           Web_Server::_nb_ip = 0;
-    const int         MAX_AUTH_IP        = 10;
+    SessionTable<16> Web_Server::_sessions;
 #endif
     FileStream* Web_Server::_uploadFile = nullptr;
 
+    // HTTP requests are served by their own task, so a slow client or a large file
+    // transfer cannot delay the polling loop that delivers lines to the planner.
+    // The websocket servers stay in the polling loop with the channels they feed,
+    // and GCode that arrives over HTTP is queued for the polling loop to push into
+    // its websocket channel.
+    struct QueuedCommand {
+        int          pageid;
+        std::string* cmd;
+    };
+    static const int     commandQueueLength = 8;
+    static QueueHandle_t commandQueue       = nullptr;
+    static TaskHandle_t  webTask            = nullptr;
+    static volatile bool webTaskStop        = false;
+    static std::mutex    socketMutex;  // WebSocketsServer is used by the web task and the polling loop
+
+    // Uploads are collected into whole sectors before they are written, because the
+    // web server delivers fragments of arbitrary size and small writes are slow on SD.
+    static const size_t uploadBufferSize = 16384;
+    static const size_t sendBufferSize   = 8192;
+
+    uint8_t* Web_Server::_uploadBuffer  = nullptr;
+    size_t   Web_Server::_uploadFill    = 0;
+    size_t   Web_Server::_uploadBytes   = 0;
+    uint32_t Web_Server::_uploadStartMs = 0;
+    uint32_t Web_Server::_uploadMs      = 0;
+
+    HashFS::Hasher* Web_Server::_uploadHasher = nullptr;
+    std::string     Web_Server::_uploadExpectedHash;
+
+    // Converts a client-supplied hex digest, with or without quotes, to HashFS form
+    static std::string normalize_hash(const std::string& hex) {
+        std::string hash("\"");
+        for (char c : hex) {
+            if (c != '"') {
+                hash += toupper(c);
+            }
+        }
+        hash += '"';
+        return hash;
+    }
+
+    static bool copy_local(const stdfs::path& from, const stdfs::path& to) {
+        try {
+            FileStream inFile { from, "r" };
+            FileStream outFile { to, "w" };
+            uint8_t    buf[512];
+            size_t     len;
+            while ((len = inFile.read(buf, sizeof(buf))) > 0) {
+                if (outFile.write(buf, len) != len) {
+                    return false;
+                }
+            }
+        } catch (const Error err) { return false; }
+        return true;
+    }
+
     EnumSetting *http_enable, *http_block_during_motion;
     IntSetting*  http_port;
+    IntSetting*  http_asset_cache;
 
     Web_Server::~Web_Server() {
         deinit();
@@ -82,10 +149,11 @@ namespace WebUI {
                                                    "HTTP/BlockDuringMotion",
                                                    DEFAULT_HTTP_BLOCKED_DURING_MOTION,
                                                    &onoffOptions);
+        http_asset_cache = new IntSetting("Cache small LocalFS files in RAM (KB)", WEBSET, WA, NULL, "HTTP/AssetCacheKB", 16, 0, 128);
 
         _setupdone = false;
 
-        if (WiFi.getMode() == WIFI_OFF || !http_enable->get()) {
+        if ((WiFi.getMode() == WIFI_OFF && !ethernet_on()) || !http_enable->get()) {
             return;
         }
 
@@ -102,7 +170,7 @@ namespace WebUI {
 #endif
 
         //here the list of headers to be recorded
-        const char* headerkeys[]   = { "If-None-Match" };
+        const char* headerkeys[]   = { "If-None-Match", "Range", "Accept-Encoding" };
         size_t      headerkeyssize = sizeof(headerkeys) / sizeof(char*);
         _webserver->collectHeaders(headerkeys, headerkeyssize);
 
@@ -132,10 +200,12 @@ namespace WebUI {
         //web commands
         _webserver->on("/command", HTTP_ANY, handle_web_command);
         _webserver->on("/command_silent", HTTP_ANY, handle_web_command_silent);
+        _webserver->on("/command_batch", HTTP_POST, handle_command_batch);
         _webserver->on("/feedhold_reload", HTTP_ANY, handleFeedholdReload);
         _webserver->on("/cyclestart_reload", HTTP_ANY, handleCyclestartReload);
         _webserver->on("/restart_reload", HTTP_ANY, handleRestartReload);
         _webserver->on("/did_restart", HTTP_ANY, handleDidRestart);
+        _webserver->on("/metrics", HTTP_GET, handleMetrics);
 
         //LocalFS
         _webserver->on("/files", HTTP_ANY, handleFileList, LocalFSFileupload);
@@ -188,12 +258,40 @@ namespace WebUI {
 
         Mdns::add("_http", "_tcp", _port);
 
-        HashFS::hash_all();
+        {
+            BootPhase phase("HashFS");
+            HashFS::hash_all();
+        }
 
         _setupdone = true;
+
+        if (!commandQueue) {
+            commandQueue = xQueueCreate(commandQueueLength, sizeof(QueuedCommand));
+        }
+        webTaskStop = false;
+        Machine::Tasks::create("webserver", serverTask, nullptr, &webTask);
+    }
+
+    void Web_Server::serverTask(void* unused) {
+        while (!webTaskStop) {
+            if (WiFi.getMode() == WIFI_AP) {
+                dnsServer.processNextRequest();
+            }
+            _webserver->handleClient();
+            vTaskDelay(1);
+        }
+        webTask = nullptr;
+        Machine::Tasks::exiting();
+        vTaskDelete(NULL);
     }
 
     void Web_Server::deinit() {
+        if (webTask) {
+            webTaskStop = true;
+            while (webTask) {
+                delay_ms(1);
+            }
+        }
         _setupdone = false;
 
         //        SSDP.end();
@@ -216,24 +314,87 @@ namespace WebUI {
         }
 
 #ifdef ENABLE_AUTHENTICATION
-        while (_head) {
-            AuthenticationIP* current = _head;
-            _head                     = _head->_next;
-            delete current;
-        }
-        _nb_ip = 0;
+        _sessions.clear();
 #endif
     }
 
-    // Send a file, either the specified path or path.gz
+    // Small LocalFS files such as WebUI scripts and icons are kept in RAM with the
+    // ETag they were read with, so reloading WebUI neither waits for nor contends
+    // with the FLASH filesystem.  An asset is valid only while HashFS still has the
+    // same hash for the file; HashFS forgets the hash when the file changes.
+    struct CachedAsset {
+        std::string etag;
+        std::string data;
+        bool        isGzip;
+        uint32_t    lastUse;
+    };
+    static std::map<std::string, CachedAsset> assetCache;
+    static size_t                             assetBytes = 0;
+    static uint32_t                           assetUses  = 0;
+    static const size_t                       maxAsset   = 8192;
+
+    static CachedAsset* find_asset(const std::string& path, const std::string& etag) {
+        auto it = assetCache.find(path);
+        if (it == assetCache.end()) {
+            return nullptr;
+        }
+        if (etag.empty() || it->second.etag != etag) {
+            assetBytes -= it->second.data.length();
+            assetCache.erase(it);
+            return nullptr;
+        }
+        it->second.lastUse = ++assetUses;
+        return &it->second;
+    }
+
+    static void store_asset(const std::string& path, const std::string& etag, std::string&& data, bool isGzip) {
+        size_t limit = http_asset_cache->get() * 1024;
+        if (data.length() > limit) {
+            return;
+        }
+        while (assetBytes + data.length() > limit) {
+            auto oldest = assetCache.begin();
+            for (auto it = assetCache.begin(); it != assetCache.end(); ++it) {
+                if (it->second.lastUse < oldest->second.lastUse) {
+                    oldest = it;
+                }
+            }
+            assetBytes -= oldest->second.data.length();
+            assetCache.erase(oldest);
+        }
+        assetBytes += data.length();
+        assetCache[path] = { etag, std::move(data), isGzip, ++assetUses };
+    }
+
+    void Web_Server::sendAsset(const char* path, const std::string& etag, const std::string& data, bool isGzip, bool download) {
+        if (download) {
+            _webserver->sendHeader("Content-Disposition", "attachment");
+        }
+        _webserver->sendHeader("ETag", etag.c_str());
+        if (isGzip) {
+            _webserver->sendHeader("Content-Encoding", "gzip");
+            _webserver->sendHeader("Vary", "Accept-Encoding");
+        }
+        _webserver->setContentLength(data.length());
+        _webserver->send(200, getContentType(path), "");
+        _webserver->client().write((const uint8_t*)data.data(), data.length());
+    }
+
+    // Send a file, either the specified path or path.gz.  When both exist, path.gz
+    // is sent to clients that accept gzip unless it is older than path.
     bool Web_Server::myStreamFile(const char* path, bool download) {
         std::error_code ec;
         FluidPath       fpath { path, localfsName, ec };
         if (ec) {
             return false;
         }
+        std::filesystem::path gzpath(fpath);
+        gzpath += ".gz";
+
+        bool acceptsGzip = strstr(_webserver->header("Accept-Encoding").c_str(), "gzip") != nullptr;
 
         std::string hash;
+        std::string inm(_webserver->header("If-None-Match").c_str());
 
         // If you load or reload WebUI while a program is running, there is a high
         // risk of stalling the motion because serving a file from
@@ -244,71 +405,165 @@ namespace WebUI {
         // way to trigger such problems is to refresh WebUI during motion.
         if (http_block_during_motion->get() && inMotionState()) {
             // Check to see if we have a cached hash of the file that can be retrieved without accessing FLASH
-            hash = HashFS::hash(fpath, true);
-            if (!hash.length()) {
-                std::filesystem::path gzpath(fpath);
-                gzpath += ".gz";
-                hash = HashFS::hash(gzpath, true);
+            std::filesystem::path cachedpath = fpath;
+            hash                             = HashFS::hash(fpath, true);
+            if (!hash.length() || (acceptsGzip && assetCache.count(gzpath))) {
+                cachedpath = gzpath;
+                hash       = HashFS::hash(gzpath, true);
             }
 
-            if (hash.length() && std::string(_webserver->header("If-None-Match").c_str()) == hash) {
+            if (hash.length() && inm == hash) {
                 _webserver->send(304);
                 return true;
             }
 
+            // A file that is cached in RAM can be sent without touching FLASH
+            CachedAsset* asset = find_asset(cachedpath, hash);
+            if (asset && !_webserver->hasHeader("Range")) {
+                sendAsset(path, asset->etag, asset->data, asset->isGzip, download);
+                return true;
+            }
+
             Web_Server::handleReloadBlocked();
             return true;
         }
 
-        // Check for brower cache match
-        hash = HashFS::hash(fpath);
-        if (!hash.length()) {
-            std::filesystem::path gzpath(fpath);
-            gzpath += ".gz";
-            hash = HashFS::hash(gzpath);
+        bool havePlain = stdfs::exists(fpath, ec);
+        bool haveGzip  = stdfs::exists(gzpath, ec);
+        if (!havePlain && !haveGzip) {
+            log_debug(path << " not found");
+            return false;
         }
+        bool isGzip = haveGzip && (!havePlain || (acceptsGzip && stdfs::last_write_time(gzpath, ec) >= stdfs::last_write_time(fpath, ec)));
+        std::filesystem::path servedpath = isGzip ? gzpath : std::filesystem::path(fpath);
+
+        // Check for brower cache match
+        hash = HashFS::hash(servedpath);
 
-        if (hash.length() && std::string(_webserver->header("If-None-Match").c_str()) == hash) {
+        if (hash.length() && inm == hash) {
             _webserver->send(304);
             return true;
         }
 
-        bool        isGzip = false;
+        bool ranged = _webserver->hasHeader("Range");
+        if (!ranged && hash.length()) {
+            CachedAsset* asset = find_asset(servedpath, hash);
+            if (asset) {
+                sendAsset(path, asset->etag, asset->data, asset->isGzip, download);
+                return true;
+            }
+        }
+
         FileStream* file;
         try {
-            file = new FileStream(path, "r", "");
+            file = new FileStream(servedpath, "r", "");
         } catch (const Error err) {
-            try {
-                std::filesystem::path gzpath(fpath);
-                gzpath += ".gz";
-                file   = new FileStream(gzpath, "r", "");
-                isGzip = true;
-            } catch (const Error err) {
-                log_debug(path << " not found");
-                return false;
+            log_debug(path << " not found");
+            return false;
+        }
+        size_t size  = file->size();
+        size_t first = 0;
+        size_t last  = size ? size - 1 : 0;
+        int    code  = 200;
+
+        if (!ranged && hash.length() && size <= maxAsset && size <= size_t(http_asset_cache->get()) * 1024) {
+            std::string data(size, '\0');
+            if (file->read((uint8_t*)data.data(), size) == size) {
+                delete file;
+                sendAsset(path, hash, data, isGzip, download);
+                store_asset(servedpath, hash, std::move(data), isGzip);
+                return true;
+            }
+            file->set_position(0);
+        }
+
+        if (ranged) {
+            if (!parseRange(_webserver->header("Range").c_str(), size, first, last)) {
+                _webserver->sendHeader("Content-Range", (std::string("bytes */") + std::to_string(size)).c_str());
+                _webserver->send(416);
+                delete file;
+                return true;
             }
+            code = 206;
+            std::string range("bytes ");
+            range += std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size);
+            _webserver->sendHeader("Content-Range", range.c_str());
         }
+
         if (download) {
             _webserver->sendHeader("Content-Disposition", "attachment");
         }
         if (hash.length()) {
             _webserver->sendHeader("ETag", hash.c_str());
         }
-        _webserver->setContentLength(file->size());
+        _webserver->sendHeader("Accept-Ranges", "bytes");
+        _webserver->setContentLength(size ? last - first + 1 : 0);
         if (isGzip) {
             _webserver->sendHeader("Content-Encoding", "gzip");
+            _webserver->sendHeader("Vary", "Accept-Encoding");
         }
-        _webserver->send(200, getContentType(path), "");
+        _webserver->send(code, getContentType(path), "");
 
-        // This depends on the fact that FileStream inherits from Stream
-        // The Arduino implementation of WiFiClient::write(Stream*) just
-        // reads repetitively from the stream in 1360-byte chunks and
-        // sends the data over the TCP socket. so nothing special.
-        _webserver->client().write(*file);
+        if (size) {
+            sendFileRange(file, first, last - first + 1);
+        }
 
         delete file;
         return true;
     }
+
+    // Parses "bytes=first-last", "bytes=first-" or "bytes=-suffix", which is all that
+    // a browser or download manager sends when resuming.  Multiple ranges are not
+    // supported.
+    bool Web_Server::parseRange(const char* header, size_t size, size_t& first, size_t& last) {
+        if (strncmp(header, "bytes=", 6) || !size) {
+            return false;
+        }
+        const char* p = header + 6;
+        char*       end;
+        if (*p == '-') {
+            size_t suffix = strtoul(p + 1, &end, 10);
+            if (end == p + 1 || !suffix) {
+                return false;
+            }
+            first = suffix < size ? size - suffix : 0;
+            last  = size - 1;
+            return true;
+        }
+        first = strtoul(p, &end, 10);
+        if (end == p || *end != '-' || first >= size) {
+            return false;
+        }
+        p    = end + 1;
+        last = *p ? strtoul(p, &end, 10) : size - 1;
+        if (*p && (end == p || last < first)) {
+            return false;
+        }
+        if (last >= size) {
+            last = size - 1;
+        }
+        return true;
+    }
+
+    // WiFiClient::write(Stream&) reads the stream in 1360-byte chunks; reading
+    // larger chunks lets the filesystem transfer whole clusters at a time.
+    void Web_Server::sendFileRange(FileStream* file, size_t start, size_t length) {
+        if (start) {
+            file->set_position(start);
+        }
+        uint8_t  fallback[1024];
+        uint8_t* buffer  = static_cast<uint8_t*>(Memory::alloc(sendBufferSize, Memory::Region::Bulk));
+        size_t   bufsize = buffer ? sendBufferSize : sizeof(fallback);
+        auto&    client  = _webserver->client();
+        while (length) {
+            size_t n = file->read(buffer ? buffer : fallback, std::min(length, bufsize));
+            if (!n || client.write(buffer ? buffer : fallback, n) != n) {
+                break;
+            }
+            length -= n;
+        }
+        Memory::free(buffer);
+    }
     void Web_Server::sendWithOurAddress(const char* content, int code) {
         auto        ip    = WiFi.getMode() == WIFI_STA ? WiFi.localIP() : WiFi.softAPIP();
         std::string ipstr = IP_string(ip);
@@ -476,7 +731,20 @@ namespace WebUI {
             return;
         }
 
-        bool hasError = WSChannels::runGCode(pageid, cmd);
+        bool hasError;
+        {
+            std::lock_guard<std::mutex> lock(socketMutex);
+            hasError = !WSChannels::hasChannel(pageid);
+        }
+        if (!hasError) {
+            QueuedCommand qc { pageid, new std::string(cmd) };
+            if (xQueueSend(commandQueue, &qc, 0) != pdTRUE) {
+                delete qc.cmd;
+                _webserver->send(503, "text/plain", "Busy\n");
+                return;
+            }
+            protocol_wake_polling();
+        }
         _webserver->send(hasError ? 500 : 200, "text/plain", hasError ? "WebSocket dead" : "");
     }
     void Web_Server::_handle_web_command(bool silent) {
@@ -510,6 +778,93 @@ namespace WebUI {
         _webserver->send(500, "text/plain", "Invalid command");
     }
 
+    // POST /command_batch runs the newline-separated lines of the request body as a
+    // sender streaming them over a serial link would, handing them to the channel as
+    // it has room, and streams back the ok or error:N for each line along with any
+    // other output.  The response ends when the last line has been executed, or
+    // with an error line if no line completes for batchTimeoutMs.
+    void Web_Server::handle_command_batch() {
+        const uint32_t batchTimeoutMs = 60000;
+
+        AuthenticationLevel auth_level = is_authenticated();
+        if (auth_level == AuthenticationLevel::LEVEL_GUEST) {
+            _webserver->send(401, "text/plain", "Authentication failed\n");
+            return;
+        }
+        if (!_webserver->hasArg("plain")) {
+            _webserver->send(400, "text/plain", "No commands\n");
+            return;
+        }
+        static bool registered = false;
+        if (!registered) {
+            allChannels.registration(&batchChannel);
+            registered = true;
+        }
+
+        const String&    body = _webserver->arg("plain");
+        std::string_view rest(body.c_str(), body.length());
+        std::string      output;
+        size_t           sent     = 0;
+        size_t           results  = 0;
+        uint32_t         progress = millis();
+
+        webClient.attachWS(_webserver, false);
+        webClient.write(nullptr, 0);  // Send the headers now
+        batchChannel.attach();
+        while (true) {
+            while (!rest.empty()) {
+                auto             newline = rest.find('\n');
+                std::string_view line    = rest.substr(0, newline);
+                while (!line.empty() && isspace(line.back())) {
+                    line.remove_suffix(1);
+                }
+                bool tooLong = line.length() >= Channel::maxLine;
+                if (!tooLong && int(line.length()) + 1 > batchChannel.rx_buffer_available()) {
+                    break;
+                }
+                rest = newline == std::string_view::npos ? std::string_view() : rest.substr(newline + 1);
+                if (tooLong) {
+                    std::string msg = "error:" + std::to_string(int(Error::LineLengthExceeded)) + "\n";
+                    webClient.write(reinterpret_cast<const uint8_t*>(msg.c_str()), msg.length());
+                    continue;
+                }
+                if (line.empty()) {
+                    continue;  // Blank lines get no result
+                }
+                batchChannel.push(line);
+                batchChannel.push('\n');
+                ++sent;
+                protocol_wake_polling();
+            }
+            size_t now_results = batchChannel.take(output);
+            if (output.length()) {
+                webClient.write(reinterpret_cast<const uint8_t*>(output.c_str()), output.length());
+                webClient.flush();
+                output.clear();
+            }
+            if (now_results != results) {
+                results  = now_results;
+                progress = millis();
+            }
+            if (results >= sent && rest.empty()) {
+                break;
+            }
+            if (!_webserver->client().connected()) {
+                log_debug("Command batch abandoned by the client");
+                break;
+            }
+            if (millis() - progress > batchTimeoutMs) {
+                std::string msg = "[MSG:ERR: Batch timed out after " + std::to_string(results) + " of " + std::to_string(sent);
+                msg += " lines]\n";
+                webClient.write(reinterpret_cast<const uint8_t*>(msg.c_str()), msg.length());
+                break;
+            }
+            vTaskDelay(1);
+        }
+        batchChannel.detach();
+        webClient.detachWS();
+    }
+
     //login status check
     void Web_Server::handle_login() {
 #ifdef ENABLE_AUTHENTICATION
@@ -527,7 +882,7 @@ namespace WebUI {
                 int pos2  = cookie.find(";", pos);
                 sessionID = cookie.substr(pos + strlen("ESPSESSIONID="), pos2);
             }
-            ClearAuthIP(_webserver->client().remoteIP(), sessionID);
+            _sessions.remove(uint32_t(_webserver->client().remoteIP()), sessionID.c_str());
             _webserver->sendHeader("Set-Cookie", "ESPSESSIONID=0");
             _webserver->sendHeader("Cache-Control", "no-cache");
             sendAuth("Ok", "guest", "");
@@ -608,15 +963,11 @@ namespace WebUI {
                 }
                 //create Session
                 if ((current_auth_level != auth_level) || (auth_level == AuthenticationLevel::LEVEL_GUEST)) {
-                    AuthenticationIP* current_auth = new AuthenticationIP;
-                    current_auth->level            = current_auth_level;
-                    current_auth->ip               = _webserver->client().remoteIP();
-                    strcpy(current_auth->sessionID, create_session_ID());
-                    strcpy(current_auth->userID, sUser.c_str());
-                    current_auth->last_time = millis();
-                    if (AddAuthIP(current_auth)) {
+                    auto current_auth = _sessions.add(
+                        uint32_t(_webserver->client().remoteIP()), current_auth_level, sUser.c_str(), create_session_ID(), millis());
+                    if (current_auth) {
                         std::string tmps = "ESPSESSIONID=";
-                        tmps += current_auth->sessionID.c_str();
+                        tmps += current_auth->sessionID;
                         _webserver->sendHeader("Set-Cookie", tmps);
                         _webserver->sendHeader("Cache-Control", "no-cache");
                         switch (current_auth->level) {
@@ -631,7 +982,6 @@ namespace WebUI {
                                 break;
                         }
                     } else {
-                        delete current_auth;
                         msg_alert_error = true;
                         code            = 500;
                         smsg            = "Error: Too many connections";
@@ -649,9 +999,9 @@ namespace WebUI {
                 int         pos = cookie.find("ESPSESSIONID=");
                 std::string sessionID;
                 if (pos != std::string::npos) {
-                    int pos2                            = cookie.find(";", pos);
-                    sessionID                           = cookie.substr(pos + strlen("ESPSESSIONID="), pos2);
-                    AuthenticationIP* current_auth_info = GetAuth(_webserver->client().remoteIP(), sessionID.c_str());
+                    int pos2               = cookie.find(";", pos);
+                    sessionID              = cookie.substr(pos + strlen("ESPSESSIONID="), pos2);
+                    auto current_auth_info = _sessions.find(uint32_t(_webserver->client().remoteIP()), sessionID.c_str(), millis());
                     if (current_auth_info != NULL) {
                         sUser = current_auth_info->userID;
                     }
@@ -692,6 +1042,16 @@ namespace WebUI {
                          "<button onclick='window.location.replace(\"/\")'>Reload WebUI</button>"
                          "</body></html>");
     }
+    // Counters and gauges in the Prometheus text format, for monitoring many machines
+    void Web_Server::handleMetrics() {
+        std::string text;
+        Metrics::write(text);
+        if (WiFi.getMode() == WIFI_STA && WiFi.isConnected()) {
+            Metrics::gauge(text, "fluidnc_wifi_rssi_dbm", "Signal strength of the Wi-Fi connection", WiFi.RSSI());
+        }
+        _webserver->send(200, "text/plain; version=0.0.4", text.c_str());
+    }
+
     // This page issues a feedhold to pause the motion then retries the WebUI reload
     void Web_Server::handleFeedholdReload() {
         protocol_send_event(&feedHoldEvent);
@@ -735,14 +1095,22 @@ namespace WebUI {
 
             uint32_t start_time = millis();
             while ((millis() - start_time) < timeout) {
-                _socket_server->loop();
+                {
+                    std::lock_guard<std::mutex> lock(socketMutex);
+                    _socket_server->loop();
+                    WSChannels::drain();
+                }
                 delay_ms(10);
             }
 
             if (_socket_serverv3) {
                 start_time = millis();
                 while ((millis() - start_time) < timeout) {
-                    _socket_serverv3->loop();
+                    {
+                        std::lock_guard<std::mutex> lock(socketMutex);
+                        _socket_serverv3->loop();
+                        WSChannels::drain();
+                    }
                     delay_ms(10);
                 }
             }
@@ -892,9 +1260,16 @@ namespace WebUI {
                     }
                     if (_upload_status != UploadStatus::FAILED) {
                         last_upload_update = 0;
-                        if (!Update.begin()) {  //start with max available size
+                        // An image hash may be given like an upload's
+                        std::string hashargname(upload.filename.c_str());
+                        hashargname += "H";
+                        std::string hash;
+                        if (_webserver->hasArg(hashargname.c_str())) {
+                            hash = normalize_hash(_webserver->arg(hashargname.c_str()).c_str());
+                        }
+                        if (!OtaWriter::begin(hash)) {
                             _upload_status = UploadStatus::FAILED;
-                            log_info("Update cancelled");
+                            log_info("Update cancelled: " << OtaWriter::errorString());
                             pushError(ESP_ERROR_NOT_ENOUGH_SPACE, "Upload rejected, not enough space");
                         } else {
                             log_info("Update 0%");
@@ -903,7 +1278,6 @@ namespace WebUI {
                     //Upload write
                     //**************
                 } else if (upload.status == UPLOAD_FILE_WRITE) {
-                    delay_ms(1);
                     //check if no error
                     if (_upload_status == UploadStatus::ONGOING) {
                         if (((100 * upload.totalSize) / maxSketchSpace) != last_upload_update) {
@@ -915,27 +1289,29 @@ namespace WebUI {
 
                             log_info("Update " << last_upload_update << "%");
                         }
-                        if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
+                        // Waits only if both buffers are still being written
+                        if (!OtaWriter::write(upload.buf, upload.currentSize)) {
                             _upload_status = UploadStatus::FAILED;
-                            log_info("Update write failed");
+                            log_info("Update write failed: " << OtaWriter::errorString());
                             pushError(ESP_ERROR_FILE_WRITE, "File write failed");
                         }
                     }
                     //Upload end
                     //**************
                 } else if (upload.status == UPLOAD_FILE_END) {
-                    if (Update.end(true)) {  //true to set the size to the current progress
+                    if (OtaWriter::end()) {
                         //Now Reboot
                         log_info("Update 100%");
                         _upload_status = UploadStatus::SUCCESSFUL;
                     } else {
                         _upload_status = UploadStatus::FAILED;
-                        log_info("Update failed");
+                        log_info("Update failed: " << OtaWriter::errorString());
                         pushError(ESP_ERROR_UPLOAD, "Update upload failed");
                     }
                 } else if (upload.status == UPLOAD_FILE_ABORTED) {
                     log_info("Update failed");
                     _upload_status = UploadStatus::FAILED;
+                    OtaWriter::abort();
                     return;
                 }
             }
@@ -943,7 +1319,7 @@ namespace WebUI {
 
         if (_upload_status == UploadStatus::FAILED) {
             cancelUpload();
-            Update.end();
+            OtaWriter::abort();
         }
     }
 
@@ -1004,6 +1380,7 @@ namespace WebUI {
                 int count = stdfs::remove_all(dirpath, ec);
                 if (count > 0) {
                     sstatus = filename + " deleted";
+                    DirCache::invalidate(dirpath);
                     HashFS::report_change();
                 } else {
                     log_debug("remove_all returned " << count);
@@ -1013,6 +1390,7 @@ namespace WebUI {
             } else if (action == "createdir") {
                 if (stdfs::create_directory(fpath / filename, ec)) {
                     sstatus = filename + " created";
+                    DirCache::invalidate(fpath / filename);
                     HashFS::report_change();
                 } else {
                     sstatus = "Cannot create ";
@@ -1032,6 +1410,29 @@ namespace WebUI {
                         HashFS::rename_file(fpath / filename, fpath / newname);
                     }
                 }
+            } else if (action == "check") {
+                // Pre-flight for an upload: if a file with the same content is already
+                // here, there is no need to send it again.
+                if (!_webserver->hasArg("hash") || !_webserver->hasArg("size")) {
+                    sstatus = "Missing hash or size";
+                } else {
+                    std::string hash   = normalize_hash(_webserver->arg("hash").c_str());
+                    uintmax_t   size   = strtoull(_webserver->arg("size").c_str(), nullptr, 10);
+                    stdfs::path target = fpath / filename;
+                    if (stdfs::file_size(target, ec) == size && !ec && HashFS::hash(target) == hash) {
+                        sstatus = filename + " identical, upload skipped";
+                    } else {
+                        ec.clear();
+                        stdfs::path source = HashFS::find(hash, size);
+                        if (!source.empty() && copy_local(source, target)) {
+                            HashFS::rehash_file(target);
+                            HashFS::set_hash(target, hash);
+                            sstatus = filename + " copied from " + source.string() + ", upload skipped";
+                        } else {
+                            sstatus = filename + " upload needed";
+                        }
+                    }
+                }
             }
         }
 
@@ -1040,19 +1441,22 @@ namespace WebUI {
             list_files = false;
         }
 
-        std::string s;
-        JSONencoder j(&s);
+        // The listing is sent with chunked transfer encoding as it is generated
+        _webserver->sendHeader("Cache-Control", "no-cache");
+        _webserver->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        _webserver->send(200, "application/json", "");
+        JSONencoder j([](const char* data, size_t length) { _webserver->sendContent(data, length); }, 1024);
         j.begin();
 
         if (list_files) {
-            auto iter = stdfs::directory_iterator { fpath, ec };
-            if (!ec) {
+            auto listing = DirCache::list(fpath, ec);
+            if (listing) {
                 j.begin_array("files");
-                for (auto const& dir_entry : iter) {
+                for (auto const& entry : *listing) {
                     j.begin_object();
-                    j.member("name", dir_entry.path().filename());
-                    j.member("shortname", dir_entry.path().filename());
-                    j.member("size", dir_entry.is_directory() ? -1 : dir_entry.file_size());
+                    j.member("name", entry.name);
+                    j.member("shortname", entry.name);
+                    j.member("size", entry.isDir ? -1 : int(entry.size));
                     j.member("datetime", "");
                     j.end_object();
                 }
@@ -1072,8 +1476,17 @@ namespace WebUI {
 
         j.member("occupation", percent);
         j.member("status", sstatus);
+        if (_uploadMs) {
+            // Throughput of the upload that just finished
+            j.begin_member_object("upload");
+            j.member("bytes", int(_uploadBytes));
+            j.member("ms", int(_uploadMs));
+            j.member("kbps", int(uint64_t(_uploadBytes) * 1000 / 1024 / _uploadMs));
+            j.end_object();
+            _uploadMs = 0;
+        }
         j.end();
-        sendJSON(200, s);
+        _webserver->sendContent("");  // Last chunk
     }
 
     void Web_Server::handle_direct_SDFileList() {
@@ -1087,6 +1500,12 @@ namespace WebUI {
     void Web_Server::uploadStart(const char* filename, size_t filesize, const char* fs) {
         std::error_code ec;
 
+        // An interrupted upload can be resumed by sending the rest of the file with
+        // <filename>R set to the number of bytes already on the card.
+        std::string resumeargname(filename);
+        resumeargname += "R";
+        size_t resume = _webserver->hasArg(resumeargname.c_str()) ? _webserver->arg(resumeargname.c_str()).toInt() : 0;
+
         FluidPath fpath { filename, fs, ec };
         if (ec) {
             _upload_status = UploadStatus::FAILED;
@@ -1111,8 +1530,37 @@ namespace WebUI {
         if (_upload_status != UploadStatus::FAILED) {
             //Create file for writing
             try {
-                _uploadFile    = new FileStream(fpath, "w");
+                const char* mode = "w";
+                if (resume) {
+                    if (stdfs::file_size(fpath, ec) != resume || ec) {
+                        _upload_status = UploadStatus::FAILED;
+                        log_info("Upload cannot resume at " << resume);
+                        pushError(ESP_ERROR_UPLOAD, "Upload rejected, resume offset mismatch");
+                        return;
+                    }
+                    mode = "a";
+                }
+                _uploadFile = new FileStream(fpath, mode);
+                if (!_uploadBuffer) {
+                    _uploadBuffer = static_cast<uint8_t*>(Memory::alloc(uploadBufferSize, Memory::Region::Bulk));
+                }
+                _uploadFill    = 0;
+                _uploadBytes   = 0;
+                _uploadMs      = 0;
+                _uploadStartMs = millis();
                 _upload_status = UploadStatus::ONGOING;
+
+                // The hash is computed as the data arrives, so the file need not be
+                // read back.  A resumed upload is hashed later, on demand.
+                delete _uploadHasher;
+                _uploadHasher = resume ? nullptr : new HashFS::Hasher;
+
+                std::string hashargname(filename);
+                hashargname += "H";
+                _uploadExpectedHash.clear();
+                if (_uploadHasher && _webserver->hasArg(hashargname.c_str())) {
+                    _uploadExpectedHash = normalize_hash(_webserver->arg(hashargname.c_str()).c_str());
+                }
             } catch (const Error err) {
                 _uploadFile    = nullptr;
                 _upload_status = UploadStatus::FAILED;
@@ -1122,11 +1570,36 @@ namespace WebUI {
         }
     }
 
+    // Writes the buffered data, returning false on failure
+    bool Web_Server::uploadFlush() {
+        size_t length = _uploadFill;
+        _uploadFill   = 0;
+        return !length || _uploadFile->write(_uploadBuffer, length) == length;
+    }
+
     void Web_Server::uploadWrite(uint8_t* buffer, size_t length) {
         delay_ms(1);
         if (_uploadFile && _upload_status == UploadStatus::ONGOING) {
             //no error write post data
-            if (length != _uploadFile->write(buffer, length)) {
+            bool ok = true;
+            _uploadBytes += length;
+            if (_uploadHasher) {
+                _uploadHasher->update(buffer, length);
+            }
+            if (!_uploadBuffer) {
+                ok = _uploadFile->write(buffer, length) == length;
+            }
+            while (ok && _uploadBuffer && length) {
+                size_t n = std::min(length, uploadBufferSize - _uploadFill);
+                memcpy(_uploadBuffer + _uploadFill, buffer, n);
+                _uploadFill += n;
+                buffer += n;
+                length -= n;
+                if (_uploadFill == uploadBufferSize) {
+                    ok = uploadFlush();
+                }
+            }
+            if (!ok) {
                 _upload_status = UploadStatus::FAILED;
                 log_info("Upload failed - file write failed");
                 pushError(ESP_ERROR_FILE_WRITE, "File write failed");
@@ -1141,8 +1614,12 @@ namespace WebUI {
     void Web_Server::uploadEnd(size_t filesize) {
         //if file is open close it
         if (_uploadFile) {
-            //            delete _uploadFile;
-            // _uploadFile = nullptr;
+            if (_upload_status == UploadStatus::ONGOING && !uploadFlush()) {
+                _upload_status = UploadStatus::FAILED;
+                log_info("Upload failed - file write failed");
+                pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+            }
+            uploadRelease();
 
             std::string pathname = _uploadFile->fpath();
             delete _uploadFile;
@@ -1166,6 +1643,19 @@ namespace WebUI {
                     log_info("Upload failed - size mismatch - exp " << filesize << " got " << actual_size);
                 }
             }
+
+            if (_uploadHasher && _upload_status == UploadStatus::ONGOING) {
+                std::string hash = _uploadHasher->finish();
+                if (!_uploadExpectedHash.empty() && hash != _uploadExpectedHash) {
+                    _upload_status = UploadStatus::FAILED;
+                    pushError(ESP_ERROR_UPLOAD, "File hash mismatch");
+                    log_info("Upload failed - hash mismatch - exp " << _uploadExpectedHash << " got " << hash);
+                } else {
+                    HashFS::set_hash(filepath, hash);
+                }
+            }
+            delete _uploadHasher;
+            _uploadHasher = nullptr;
         } else {
             _upload_status = UploadStatus::FAILED;
             log_info("Upload failed - file not open");
@@ -1173,15 +1663,27 @@ namespace WebUI {
         }
         if (_upload_status == UploadStatus::ONGOING) {
             _upload_status = UploadStatus::SUCCESSFUL;
+            _uploadMs      = std::max(uint32_t(millis() - _uploadStartMs), uint32_t(1));
+            log_debug("Upload " << _uploadBytes << " bytes in " << _uploadMs << "ms");
         } else {
             _upload_status = UploadStatus::FAILED;
             pushError(ESP_ERROR_UPLOAD, "Upload error 8");
         }
     }
+    void Web_Server::uploadRelease() {
+        Memory::free(_uploadBuffer);
+        _uploadBuffer = nullptr;
+        _uploadFill   = 0;
+    }
     void Web_Server::uploadStop() {
         _upload_status = UploadStatus::FAILED;
         log_info("Upload cancelled");
+        delete _uploadHasher;
+        _uploadHasher = nullptr;
         if (_uploadFile) {
+            // Keep what was received so that the upload can be resumed
+            uploadFlush();
+            uploadRelease();
             std::filesystem::path filepath = _uploadFile->fpath();
             delete _uploadFile;
             _uploadFile = nullptr;
@@ -1192,6 +1694,7 @@ namespace WebUI {
         std::error_code error_code;
         if (_upload_status == UploadStatus::FAILED) {
             cancelUpload();
+            uploadRelease();
             if (_uploadFile) {
                 std::filesystem::path filepath = _uploadFile->fpath();
                 delete _uploadFile;
@@ -1204,18 +1707,19 @@ namespace WebUI {
 
     void Web_Server::poll() {
         static uint32_t start_time = millis();
-        if (WiFi.getMode() == WIFI_AP) {
-            dnsServer.processNextRequest();
-        }
-        if (_webserver) {
-            _webserver->handleClient();
+        QueuedCommand   qc;
+        while (commandQueue && xQueueReceive(commandQueue, &qc, 0) == pdTRUE) {
+            WSChannels::runGCode(qc.pageid, *qc.cmd);
+            delete qc.cmd;
         }
+        std::lock_guard<std::mutex> lock(socketMutex);
         if (_socket_server && _setupdone) {
             _socket_server->loop();
         }
         if (_socket_serverv3 && _setupdone) {
             _socket_serverv3->loop();
         }
+        WSChannels::drain();
         if ((millis() - start_time) > 10000 && _socket_server) {
             WSChannels::sendPing();
             start_time = millis();
@@ -1274,9 +1778,12 @@ namespace WebUI {
             if (pos != std::string::npos) {
                 size_t      pos2      = cookie.find(";", pos);
                 std::string sessionID = cookie.substr(pos + strlen("ESPSESSIONID="), pos2);
-                IPAddress   ip        = _webserver->client().remoteIP();
-                //check if cookie can be reset and clean table in same time
-                return ResetAuthIP(ip, sessionID.c_str());
+                auto        session   = _sessions.find(uint32_t(_webserver->client().remoteIP()), sessionID.c_str(), millis());
+                if (session) {
+                    // The session stays alive while it is used
+                    session->last_time = millis();
+                    return session->level;
+                }
             }
         }
         return AuthenticationLevel::LEVEL_GUEST;
@@ -1287,17 +1794,6 @@ namespace WebUI {
 
 #ifdef ENABLE_AUTHENTICATION
 
-    //add the information in the linked list if possible
-    bool Web_Server::AddAuthIP(AuthenticationIP* item) {
-        if (_nb_ip > MAX_AUTH_IP) {
-            return false;
-        }
-        item->_next = _head;
-        _head       = item;
-        _nb_ip++;
-        return true;
-    }
-
     //Session ID based on IP and time using 16 char
     char* Web_Server::create_session_ID() {
         static char sessionID[17];
@@ -1324,81 +1820,6 @@ namespace WebUI {
         }
         return sessionID;
     }
-
-    bool Web_Server::ClearAuthIP(IPAddress ip, const char* sessionID) {
-        AuthenticationIP* current  = _head;
-        AuthenticationIP* previous = NULL;
-        bool              done     = false;
-        while (current) {
-            if ((ip == current->ip) && (strcmp(sessionID, current->sessionID) == 0)) {
-                //remove
-                done = true;
-                if (current == _head) {
-                    _head = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = _head;
-                } else {
-                    previous->_next = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = previous->_next;
-                }
-            } else {
-                previous = current;
-                current  = current->_next;
-            }
-        }
-        return done;
-    }
-
-    //Get info
-    AuthenticationIP* Web_Server::GetAuth(IPAddress ip, const char* sessionID) {
-        AuthenticationIP* current = _head;
-        //AuthenticationIP * previous = NULL;
-        while (current) {
-            if (ip == current->ip) {
-                if (strcmp(sessionID, current->sessionID) == 0) {
-                    //found
-                    return current;
-                }
-            }
-            //previous = current;
-            current = current->_next;
-        }
-        return NULL;
-    }
-
-    //Review all IP to reset timers
-    AuthenticationLevel Web_Server::ResetAuthIP(IPAddress ip, const char* sessionID) {
-        AuthenticationIP* current  = _head;
-        AuthenticationIP* previous = NULL;
-        while (current) {
-            if ((millis() - current->last_time) > 360000) {
-                //remove
-                if (current == _head) {
-                    _head = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = _head;
-                } else {
-                    previous->_next = current->_next;
-                    _nb_ip--;
-                    delete current;
-                    current = previous->_next;
-                }
-            } else {
-                if (ip == current->ip && strcmp(sessionID, current->sessionID) == 0) {
-                    //reset time
-                    current->last_time = millis();
-                    return (AuthenticationLevel)current->level;
-                }
-                previous = current;
-                current  = current->_next;
-            }
-        }
-        return AuthenticationLevel::LEVEL_GUEST;
-    }
 #endif
     ModuleFactory::InstanceBuilder<Web_Server> __attribute__((init_priority(108))) web_server_module("wifi", true);
 }
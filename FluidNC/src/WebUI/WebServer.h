@@ -4,11 +4,13 @@
 #pragma once
 
 #include "src/FileStream.h"
+#include "src/HashFS.h"
 
 #include "src/Settings.h"
 #include "src/Module.h"
 
 #include "Authentication.h"  // AuthenticationLevel
+#include "SessionTable.h"
 
 class WebSocketsServer;
 class WebServer;
@@ -24,17 +26,6 @@ namespace WebUI {
     extern EnumSetting* http_enable;
     extern IntSetting*  http_port;
 
-#ifdef ENABLE_AUTHENTICATION
-    struct AuthenticationIP {
-        IPAddress           ip;
-        AuthenticationLevel level;
-        char                userID[17];
-        char                sessionID[17];
-        uint32_t            last_time;
-        AuthenticationIP*   _next;
-    };
-#endif
-
     //Upload status
     enum class UploadStatus : uint8_t { NONE = 0, FAILED = 1, CANCELLED = 2, SUCCESSFUL = 3, ONGOING = 4 };
 
@@ -59,18 +50,22 @@ namespace WebUI {
         static uint16_t          _port;
         static UploadStatus      _upload_status;
         static FileStream*       _uploadFile;
+        static uint8_t*          _uploadBuffer;
+        static size_t            _uploadFill;
+        static size_t            _uploadBytes;
+        static uint32_t          _uploadStartMs;
+        static uint32_t          _uploadMs;  // Duration of the last successful upload
+        static HashFS::Hasher*   _uploadHasher;
+        static std::string       _uploadExpectedHash;
 
         static const char* getContentType(const char* filename);
 
+        static void serverTask(void* unused);
+
         static AuthenticationLevel is_authenticated();
 #ifdef ENABLE_AUTHENTICATION
-        static AuthenticationIP*   _head;
-        static uint8_t             _nb_ip;
-        static bool                AddAuthIP(AuthenticationIP* item);
-        static char*               create_session_ID();
-        static bool                ClearAuthIP(IPAddress ip, const char* sessionID);
-        static AuthenticationIP*   GetAuth(IPAddress ip, const char* sessionID);
-        static AuthenticationLevel ResetAuthIP(IPAddress ip, const char* sessionID);
+        static SessionTable<16> _sessions;
+        static char*            create_session_ID();
 #endif
         static void handle_SSDP();
         static void handle_root();
@@ -83,6 +78,7 @@ namespace WebUI {
         static void handle_web_command_silent() {
             _handle_web_command(true);
         }
+        static void handle_command_batch();
         static void handle_Websocket_Event(uint8_t num, uint8_t type, uint8_t* payload, size_t length);
         static void handle_Websocketv3_Event(uint8_t num, uint8_t type, uint8_t* payload, size_t length);
         static void handleReloadBlocked();
@@ -90,12 +86,16 @@ namespace WebUI {
         static void handleCyclestartReload();
         static void handleRestartReload();
         static void handleDidRestart();
+        static void handleMetrics();
         static void LocalFSFileupload();
         static void handleFileList();
         static void handleUpdate();
         static void WebUpdateUpload();
 
         static bool myStreamFile(const char* path, bool download = false);
+        static void sendAsset(const char* path, const std::string& etag, const std::string& data, bool isGzip, bool download);
+        static bool parseRange(const char* header, size_t size, size_t& first, size_t& last);
+        static void sendFileRange(FileStream* file, size_t start, size_t length);
 
         static void pushError(int code, const char* st, bool web_error = 500, uint16_t timeout = 1000);
 
@@ -106,7 +106,9 @@ namespace WebUI {
         static void SDFileUpload();
         static void uploadStart(const char* filename, size_t filesize, const char* fs);
         static void uploadWrite(uint8_t* buffer, size_t length);
+        static bool uploadFlush();
         static void uploadEnd(size_t filesize);
+        static void uploadRelease();
         static void uploadStop();
         static void uploadCheck();
 
@@ -20,10 +20,14 @@
 #include <WiFi.h>
 #include <esp_wifi.h>
 #include "Driver/localfs.h"
+#include "Driver/ethernet.h"  // eth_local_ip()
 #include <string>
 #include <cstring>
+#include <algorithm>
 
 #include <esp_ota_ops.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 namespace WebUI {
     enum WiFiStartupMode {
@@ -178,13 +182,26 @@ namespace WebUI {
     static EnumSetting*     _sta_min_security;
     static PasswordSetting* _sta_password;
     static EnumSetting*     _wifi_ps_mode;
+    static EnumSetting*     _motion_first;
 
     class WiFiConfig : public Module {
     private:
         static void print_mac(Channel& out, const char* prefix, const char* mac) { log_stream(out, prefix << " (" << mac << ")"); }
 
         static Error showIP(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP111
-            log_stream(out, parameter << IP_string(WiFi.getMode() == WIFI_STA ? WiFi.localIP() : WiFi.softAPIP()));
+            uint32_t ip;
+            switch (WiFi.getMode()) {
+                case WIFI_STA:
+                    ip = WiFi.localIP();
+                    break;
+                case WIFI_OFF:  // Ethernet only
+                    ip = eth_local_ip();
+                    break;
+                default:
+                    ip = WiFi.softAPIP();
+                    break;
+            }
+            log_stream(out, parameter << IP_string(ip));
             return Error::Ok;
         }
 
@@ -523,8 +540,8 @@ namespace WebUI {
                   case WIFI_AP_STA:
                     j.member("WebSocketIP", IP_string(WiFi.softAPIP()));
                     break;
-                  default:
-                    j.member("WebSocketIP", "0.0.0.0");
+                  default:  // Ethernet only, or 0.0.0.0
+                    j.member("WebSocketIP", IP_string(eth_local_ip()));
                     break;
                 }
 
@@ -596,8 +613,8 @@ namespace WebUI {
                 case WIFI_AP_STA:
                     s << IP_string(WiFi.softAPIP());
                     break;
-                default:
-                    s << "0.0.0.0";
+                default:  // Ethernet only, or 0.0.0.0
+                    s << IP_string(eth_local_ip());
                     break;
             }
 #endif
@@ -706,7 +723,8 @@ namespace WebUI {
             return false;
         }
 
-        static bool StartSTA() {
+        // Starts connecting as a station, without waiting for the connection
+        static bool BeginSTA() {
             //Sanity check
             auto mode = WiFi.getMode();
             if (mode == WIFI_STA || mode == WIFI_AP_STA) {
@@ -745,13 +763,17 @@ namespace WebUI {
             }
             if (WiFi.begin(SSID, (strlen(password) > 0) ? password : NULL)) {
                 log_info("Connecting to STA SSID:" << SSID);
-                return ConnectSTA2AP();
+                return true;
             } else {
                 log_info("Starting client failed");
                 return false;
             }
         }
 
+        static bool StartSTA() {
+            return BeginSTA() && ConnectSTA2AP();
+        }
+
         static bool StartAP() {
             //Sanity check
             if ((WiFi.getMode() == WIFI_STA) || (WiFi.getMode() == WIFI_AP_STA)) {
@@ -795,6 +817,48 @@ namespace WebUI {
             return false;
         }
 
+        // With WiFi/MotionFirst on, startup does not wait for the station to connect.
+        // This task watches the connection instead.  If it fails, STA>AP mode falls
+        // back to AP as it would have at startup, and STA mode retries with a
+        // growing delay.  The services that were started with the station come up
+        // on whichever interface ends up running.
+        static const uint32_t connectTimeoutMs = 20000;  // Matches ConnectSTA2AP()
+        static const uint32_t maxBackoffMs     = 60000;
+
+        static void connect_task(void* unused) {
+            uint32_t backoffMs = 2000;
+            uint32_t waitedMs  = 0;
+            while (true) {
+                auto status = WiFi.status();
+                if (status == WL_CONNECTED) {
+                    log_info("Connected - IP is " << IP_string(WiFi.localIP()));
+                    break;
+                }
+                if (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED || waitedMs >= connectTimeoutMs) {
+                    if (_mode->get() == WiFiFallback) {
+                        log_info("STA connection failed");
+                        WiFi.mode(WIFI_OFF);
+                        esp_wifi_restore();
+                        delay_ms(100);
+                        if (!StartAP()) {
+                            log_info("WiFi off");
+                            WiFi.mode(WIFI_OFF);
+                        }
+                        break;
+                    }
+                    log_info("STA connection failed, retrying in " << backoffMs / 1000 << " s");
+                    delay_ms(backoffMs);
+                    backoffMs = std::min(backoffMs * 2, maxBackoffMs);
+                    waitedMs  = 0;
+                    WiFi.reconnect();
+                    continue;
+                }
+                delay_ms(500);
+                waitedMs += 500;
+            }
+            vTaskDelete(nullptr);
+        }
+
         static void reset() {
             WiFi.persistent(false);
             WiFi.disconnect(true);
@@ -941,6 +1005,8 @@ namespace WebUI {
 
             _mode         = new EnumSetting("WiFi mode", WEBSET, WA, "ESP116", "WiFi/Mode", WiFiFallback, &wifiModeOptions);
             _wifi_ps_mode = new EnumSetting("WiFi power saving mode", WEBSET, WA, NULL, "WiFi/PsMode", WIFI_PS_NONE, &wifiPsModeOptions);
+            _motion_first =
+                new EnumSetting("Do not wait for the STA connection at startup", WEBSET, WA, NULL, "WiFi/MotionFirst", 0, &onoffOptions);
 
             new WebCommand(NULL, WEBCMD, WU, "ESP410", "WiFi/ListAPs", listAPs);
             new WebCommand(NULL, WEBCMD, WG, "ESP800", "Firmware/Info", showFwInfo, anyState);
@@ -951,6 +1017,13 @@ namespace WebUI {
             //stop active services
             // wifi_services.end();
 
+            if (_motion_first->get() && (_mode->get() == WiFiSTA || _mode->get() == WiFiFallback) && BeginSTA()) {
+                if (xTaskCreatePinnedToCore(connect_task, "wifi_connect", 4096, nullptr, 1, nullptr, SUPPORT_TASK_CORE) == pdPASS) {
+                    goto wifi_on;
+                }
+                log_error("Cannot start the WiFi connection task");
+            }
+
             switch (_mode->get()) {
                 case WiFiOff:
                     log_info("WiFi is disabled");
@@ -88,4 +88,7 @@ public:
     int  finish();
     bool step(int c);
     bool realtime(int c);
+
+    // True when not editing and no line is partly collected, so a whole line can bypass step()
+    bool idle() { return !editing && endaddr == startaddr; }
 };
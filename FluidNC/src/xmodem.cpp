@@ -34,6 +34,10 @@
 
 #include "xmodem.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
 static Channel* serialPort;
 static Print*   file;
 
@@ -42,6 +46,19 @@ static int _inbyte(uint16_t timeout) {
     auto    res = serialPort->timedReadBytes(&data, 1, timeout);
     return res != 1 ? -1 : data;
 }
+// Reads len bytes in as few calls as possible, failing if the line
+// is silent for timeout msec
+static bool _inbytes(uint8_t* buf, size_t len, uint16_t timeout) {
+    while (len) {
+        auto res = serialPort->timedReadBytes(buf, len, timeout);
+        if (res == 0) {
+            return false;
+        }
+        buf += res;
+        len -= res;
+    }
+    return true;
+}
 static void _outbyte(int c) {
     serialPort->write((uint8_t)c);
 }
@@ -114,6 +131,34 @@ static void flushinput(void) {
         ;
 }
 
+// Received data is collected into larger writes, because each fwrite()
+// to a filesystem costs far more than copying a packet.
+static uint8_t write_buffer[4096];
+static size_t  write_len;
+static void    buffered_write(const uint8_t* data, size_t len) {
+    while (len) {
+        size_t n = std::min(len, sizeof(write_buffer) - write_len);
+        memcpy(write_buffer + write_len, data, n);
+        write_len += n;
+        data += n;
+        len -= n;
+        if (write_len == sizeof(write_buffer)) {
+            file->write(write_buffer, write_len);
+            write_len = 0;
+        }
+    }
+}
+static void flush_writes() {
+    if (write_len) {
+        file->write(write_buffer, write_len);
+        write_len = 0;
+    }
+}
+
+// The number of bytes still expected when a YMODEM header gave the
+// file size, or -1 when the size is unknown.
+static int64_t remaining;
+
 // We delay writing each packet until the next one arrives
 // so that we can remove trailing control-Z's in only the
 // last one.  The Xmodem protocol has no good way to denote
@@ -124,7 +169,8 @@ static void flushinput(void) {
 // fails with binary files that are supposed to have trailing
 // control-Z's.  Doing the control-Z removal only on the final
 // packet avoids removing interior control-Z's that happen to
-// land at the end of a packet.
+// land at the end of a packet.  When YMODEM supplies the size,
+// the padding is cut off exactly instead.
 static uint8_t held_packet[1024];
 static size_t  held_packet_len;
 static void    flush_packet(size_t packet_len, size_t& total_len) {
@@ -136,32 +182,51 @@ static void    flush_packet(size_t packet_len, size_t& total_len) {
                 break;
             }
         }
-        file->write(held_packet, count);
+        buffered_write(held_packet, count);
         total_len += count;
         held_packet_len = 0;
     }
+    flush_writes();
 }
 static void write_packet(uint8_t* buf, size_t packet_len, size_t& total_len) {
+    if (remaining >= 0) {
+        size_t count = std::min(int64_t(packet_len), remaining);
+        buffered_write(buf, count);
+        total_len += count;
+        remaining -= count;
+        return;
+    }
     if (held_packet_len > 0) {
-        file->write(held_packet, held_packet_len);
+        buffered_write(held_packet, held_packet_len);
         total_len += held_packet_len;
         held_packet_len = 0;
     }
     memcpy(held_packet, buf, packet_len);
     held_packet_len = packet_len;
 }
-int xmodemReceive(Channel* serial, FileStream* out) {
-    serialPort      = serial;
-    file            = out;
+
+static void cancel() {
+    _outbyte(CAN);
+    _outbyte(CAN);
+    _outbyte(CAN);
+}
+
+// Receives the data blocks of one file, starting by sending trychar:
+// 'C' for CRC, falling back to NAK for checksums, or 'G' for YMODEM-g
+// streaming, in which blocks are not acknowledged and any error
+// cancels the transfer.  In a YMODEM batch the final EOT is followed by
+// the next header, so the input is not flushed.
+static int receive_file(uint8_t trychar, bool batch) {
     held_packet_len = 0;
+    write_len       = 0;
 
-    uint8_t  xbuff[1030]; /* 1024 for XModem 1k + 3 head chars + 2 crc + nul */
-    uint8_t* p;
-    int      bufsz = 0, crc = 0;
-    uint8_t  trychar  = 'C';
-    uint8_t  packetno = 1;
-    int      i, c           = 0;
-    int      retry, retrans = MAXRETRANS;
+    uint8_t xbuff[1030]; /* 1024 for XModem 1k + 3 head chars + 2 crc + nul */
+    int     bufsz = 0, crc = 0;
+    bool    streaming = trychar == 'G';
+    uint8_t packetno  = 1;
+    int     c         = 0;
+    int     retry, retrans = MAXRETRANS;
+    bool    eot_seen = false;
 
     size_t len = 0;
 
@@ -178,9 +243,18 @@ int xmodemReceive(Channel* serial, FileStream* out) {
                         bufsz = 1024;
                         goto start_recv;
                     case EOT:
+                        if (batch && !eot_seen && !streaming) {
+                            // YMODEM senders repeat EOT after a NAK, which
+                            // guards against a corrupted EOT ending the file
+                            eot_seen = true;
+                            _outbyte(NAK);
+                            continue;
+                        }
                         flush_packet(bufsz, len);
                         _outbyte(ACK);
-                        flushinput();
+                        if (!batch) {
+                            flushinput();
+                        }
                         return len; /* normal end */
                     case CAN:
                         if ((c = _inbyte(DLY_1S)) == CAN) {
@@ -199,22 +273,16 @@ int xmodemReceive(Channel* serial, FileStream* out) {
             continue;
         }
         flushinput();
-        _outbyte(CAN);
-        _outbyte(CAN);
-        _outbyte(CAN);
+        cancel();
         return -2; /* sync error */
 
     start_recv:
-        if (trychar == 'C')
+        if (trychar == 'C' || trychar == 'G')
             crc = 1;
-        trychar = 0;
-        p       = xbuff;
-        *p++    = c;
-        for (i = 0; i < (bufsz + (crc ? 1 : 0) + 3); ++i) {
-            if ((c = _inbyte(DLY_1S)) < 0)
-                goto reject;
-            *p++ = c;
-        }
+        trychar  = 0;
+        xbuff[0] = c;
+        if (!_inbytes(xbuff + 1, bufsz + (crc ? 1 : 0) + 3, DLY_1S))
+            goto reject;
 
         if (xbuff[1] == (uint8_t)(~xbuff[2]) && (xbuff[1] == packetno || xbuff[1] == packetno - 1) && check(crc, &xbuff[3], bufsz)) {
             if (xbuff[1] == packetno) {
@@ -224,20 +292,118 @@ int xmodemReceive(Channel* serial, FileStream* out) {
             }
             if (--retrans <= 0) {
                 flushinput();
-                _outbyte(CAN);
-                _outbyte(CAN);
-                _outbyte(CAN);
+                cancel();
                 return -3; /* too many retry error */
             }
-            _outbyte(ACK);
+            if (!streaming) {
+                _outbyte(ACK);
+            }
             continue;
         }
     reject:
         flushinput();
+        if (streaming) {
+            cancel();
+            return -3;
+        }
         _outbyte(NAK);
     }
 }
 
+int xmodemReceive(Channel* serial, FileStream* out) {
+    serialPort = serial;
+    file       = out;
+    remaining  = -1;
+    return receive_file('C', false);
+}
+
+// Receives a YMODEM block 0, which holds the file name and the
+// decimal size, sending trychar until it arrives.  Returns 1 for a
+// file, 0 for the empty header that ends a batch, or a negative
+// status.
+static int receive_header(uint8_t trychar, std::string& name, int64_t& size) {
+    uint8_t xbuff[1030];
+    int     bufsz;
+    int     c;
+    for (int retry = 0; retry < 16; ++retry) {
+        _outbyte(trychar);
+        if ((c = _inbyte((DLY_1S) << 1)) < 0) {
+            continue;
+        }
+        if (c == CAN) {
+            if ((c = _inbyte(DLY_1S)) == CAN) {
+                flushinput();
+                _outbyte(ACK);
+                return -1; /* canceled by remote */
+            }
+            continue;
+        }
+        if (c != SOH && c != STX) {
+            continue;
+        }
+        bufsz = c == SOH ? 128 : 1024;
+        if (!_inbytes(xbuff + 1, bufsz + 4, DLY_1S) || xbuff[1] != 0 || xbuff[2] != 0xff || !check(1, &xbuff[3], bufsz)) {
+            flushinput();
+            if (trychar == 'G') {
+                break;
+            }
+            continue;
+        }
+        const char* p = reinterpret_cast<const char*>(&xbuff[3]);
+        name          = std::string(p, strnlen(p, bufsz));
+        size          = -1;
+        if (name.length() < size_t(bufsz - 1) && isdigit(p[name.length() + 1])) {
+            size = atoll(p + name.length() + 1);
+        }
+        // Keep only the last path component so a sender cannot write outside the directory
+        auto slash = name.find_last_of('/');
+        if (slash != std::string::npos) {
+            name = name.substr(slash + 1);
+        }
+        if (name.empty()) {
+            _outbyte(ACK);
+            return 0;
+        }
+        if (trychar != 'G') {
+            _outbyte(ACK);
+        }
+        return 1;
+    }
+    flushinput();
+    cancel();
+    return -2; /* sync error */
+}
+
+int ymodemReceive(Channel* serial, const char* dir, bool streaming, const std::function<void(FileStream*, int)>& received) {
+    serialPort      = serial;
+    uint8_t trychar = streaming ? 'G' : 'C';
+    int     total   = 0;
+    for (;;) {
+        std::string name;
+        int64_t     size;
+        int         status = receive_header(trychar, name, size);
+        if (status <= 0) {
+            return status < 0 ? status : total;
+        }
+        FileStream* out;
+        try {
+            out = new FileStream(*dir ? std::string(dir) + "/" + name : name, "w");
+        } catch (...) {
+            cancel();
+            flushinput();
+            return -6; /* cannot open file */
+        }
+        file      = out;
+        remaining = size;
+        int len   = receive_file(trychar, true);
+        received(out, len);
+        if (len < 0) {
+            return len;
+        }
+        total += len;
+    }
+}
+
 int xmodemTransmit(Channel* serial, FileStream* infile) {
     serialPort = serial;
 
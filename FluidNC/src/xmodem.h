@@ -3,5 +3,15 @@
 #include "Channel.h"
 #include "FileStream.h"
 
+#include <functional>
+
 int xmodemReceive(Channel* serial, FileStream* outfile);
 int xmodemTransmit(Channel* serial, FileStream* infile);
+
+// CRC-16/XMODEM, which the binary status report also uses
+uint16_t crc16_ccitt(const uint8_t* buf, size_t len);
+
+// Receives a YMODEM batch into dir, calling received() with each file and
+// its length, or a negative status if it failed; received() owns the file.
+// With streaming, it uses YMODEM-g, which needs an error-free link.
+int ymodemReceive(Channel* serial, const char* dir, bool streaming, const std::function<void(FileStream*, int)>& received);
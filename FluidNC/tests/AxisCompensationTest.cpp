@@ -0,0 +1,46 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/Kinematics/AxisCompensation.h"
+
+using namespace Kinematics;
+
+TEST(AxisCompensation, PitchTable) {
+    PitchTable table;
+    EXPECT_FLOAT_EQ(table.error(12.0f), 0.0f);
+    EXPECT_FALSE(table.set(0.0f, 0.0f, { 0.01f }));
+    ASSERT_TRUE(table.set(-100.0f, 50.0f, { 0.0f, 0.02f, -0.01f, 0.005f }));
+
+    EXPECT_NEAR(table.error(-100.0f), 0.0f, 1e-6);
+    EXPECT_NEAR(table.error(-75.0f), 0.01f, 1e-6);
+    EXPECT_NEAR(table.error(-50.0f), 0.02f, 1e-6);
+    EXPECT_NEAR(table.error(-10.0f), 0.02f - 0.03f * 0.8f, 1e-6);
+    EXPECT_NEAR(table.error(50.0f), 0.005f, 1e-6);
+
+    // The end values hold outside the table
+    EXPECT_NEAR(table.error(-500.0f), 0.0f, 1e-6);
+    EXPECT_NEAR(table.error(80.0f), 0.005f, 1e-6);
+
+    for (float position = -120.0f; position < 70.0f; position += 1.3f) {
+        float motor = position + table.error(position);
+        EXPECT_NEAR(table.invert(motor), position, 1e-5) << position;
+    }
+}
+
+TEST(AxisCompensation, Skew) {
+    Skew skew;
+    EXPECT_TRUE(skew.empty());
+    skew.xy = 0.001f;
+    skew.xz = -0.002f;
+    skew.yz = 0.0005f;
+
+    float p[3] = { 100.0f, 200.0f, -30.0f };
+    skew.apply(p);
+    EXPECT_NEAR(p[0], 100.0f + 0.2f + 0.06f, 1e-4);
+    EXPECT_NEAR(p[1], 200.0f - 0.015f, 1e-4);
+    EXPECT_FLOAT_EQ(p[2], -30.0f);
+    skew.remove(p);
+    EXPECT_NEAR(p[0], 100.0f, 1e-4);
+    EXPECT_NEAR(p[1], 200.0f, 1e-4);
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/AxisCount.h"
+
+static const size_t MAX_N_AXIS = 9;
+
+TEST(AxisCount, RunsTheBodyForTheConfiguredCount) {
+    for (size_t n_axis = MIN_N_AXIS; n_axis <= MAX_N_AXIS; n_axis++) {
+        size_t seen  = 0;
+        int    calls = 0;
+        with_axis_count<MAX_N_AXIS>(n_axis, [&](auto n) {
+            static_assert(decltype(n)::value >= MIN_N_AXIS && decltype(n)::value <= MAX_N_AXIS, "count out of range");
+            seen = n;
+            ++calls;
+        });
+        EXPECT_EQ(seen, n_axis);
+        EXPECT_EQ(calls, 1);
+    }
+}
+
+TEST(AxisCount, CountIsAConstantExpression) {
+    int steps[MAX_N_AXIS] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    int sum               = 0;
+    with_axis_count<MAX_N_AXIS>(4, [&](auto n) {
+        int partial[n];  // Not a VLA; n is constexpr
+        for (size_t axis = 0; axis < n; axis++) {
+            partial[axis] = steps[axis];
+        }
+        for (size_t axis = 0; axis < n; axis++) {
+            sum += partial[axis];
+        }
+    });
+    EXPECT_EQ(sum, 10);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Bench.h - timing and reporting for the benchmarks among the unit tests
+
+  A benchmark is an ordinary test whose name ends in Benchmark, so that
+  "pio test -e bench" can run just those, optimized and without sanitizers.
+  bench_report() prints a result for people to read and, if the BENCH_OUTPUT
+  environment variable names a file, appends it there as one line of JSON,
+  so that the results of two builds can be compared by a script.
+*/
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+inline void bench_report(const char* name, double value, const char* unit) {
+    printf("[ BENCH    ] %s: %.1f %s\n", name, value, unit);
+
+    const char* path = getenv("BENCH_OUTPUT");
+    if (path && *path) {
+        if (FILE* f = fopen(path, "a")) {
+            auto test = ::testing::UnitTest::GetInstance()->current_test_info();
+            fprintf(f,
+                    "{\"test\":\"%s.%s\",\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\"}\n",
+                    test ? test->test_suite_name() : "",
+                    test ? test->name() : "",
+                    name,
+                    value,
+                    unit);
+            fclose(f);
+        }
+    }
+}
+
+// Calls f() iterations times and returns the average time of a call in nanoseconds
+template <typename F>
+double bench_ns_per_call(size_t iterations, F&& f) {
+    using clock = std::chrono::steady_clock;
+    auto start  = clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        f();
+    }
+    return std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+}
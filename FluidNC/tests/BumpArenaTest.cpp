@@ -0,0 +1,42 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/BumpArena.h"
+
+#include <cstring>
+
+TEST(BumpArena, AllocatesAlignedFromOneChunk) {
+    BumpArena arena(1024);
+    void*     a = arena.allocate(3);
+    void*     b = arena.allocate(17);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t), 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(std::max_align_t), 0u);
+    EXPECT_EQ(arena.chunks(), 1u);
+    EXPECT_TRUE(arena.owns(a));
+    EXPECT_TRUE(arena.owns(b));
+
+    int local;
+    EXPECT_FALSE(arena.owns(&local));
+}
+
+TEST(BumpArena, GrowsAndReleases) {
+    BumpArena arena(64);
+    for (int i = 0; i < 20; i++) {
+        memset(arena.allocate(16), i, 16);
+    }
+    EXPECT_GT(arena.chunks(), 1u);
+    EXPECT_GE(arena.reserved(), arena.used());
+
+    void* big = arena.allocate(1000);
+    ASSERT_NE(big, nullptr);
+    EXPECT_TRUE(arena.owns(big));
+    EXPECT_GE(arena.reserved(), 1000u);
+
+    arena.release();
+    EXPECT_EQ(arena.chunks(), 0u);
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_FALSE(arena.owns(big));
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/ByteRing.h"
+
+#include <string>
+
+TEST(ByteRing, PushAndPop) {
+    ByteRing<8> ring;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.pop(), -1);
+    EXPECT_TRUE(ring.push('a'));
+    EXPECT_TRUE(ring.push(0xff));
+    EXPECT_EQ(ring.size(), 2u);
+    EXPECT_EQ(ring.free(), 6u);
+    EXPECT_EQ(ring.pop(), 'a');
+    EXPECT_EQ(ring.pop(), 0xff);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(ByteRing, BulkPushStopsWhenFull) {
+    ByteRing<8> ring;
+    const uint8_t text[] = "0123456789";
+    EXPECT_EQ(ring.push(text, 10), 8u);
+    EXPECT_FALSE(ring.push('x'));
+    uint8_t out[10];
+    EXPECT_EQ(ring.read(out, sizeof(out)), 8u);
+    EXPECT_EQ(std::string(reinterpret_cast<char*>(out), 8), "01234567");
+}
+
+TEST(ByteRing, WrapsAround) {
+    ByteRing<8> ring;
+    const uint8_t text[] = "abcdefgh";
+    ring.push(text, 6);
+    uint8_t out[8];
+    EXPECT_EQ(ring.read(out, 5), 5u);
+    EXPECT_EQ(ring.push(text, 6), 6u);  // Crosses the end of the storage
+
+    // The oldest contiguous run ends at the end of the storage
+    size_t         run;
+    const uint8_t* data = ring.data(run);
+    EXPECT_EQ(run, 3u);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(data), run), "fab");
+    ring.consume(run);
+    data = ring.data(run);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(data), run), "cdef");
+
+    ring.clear();
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.free(), 8u);
+}
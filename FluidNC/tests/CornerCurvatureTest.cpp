@@ -0,0 +1,65 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/CornerCurvature.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+    const float accel     = 1000.0f * 60 * 60;  // 1000 mm/sec^2 in mm/min^2
+    const float tolerance = 0.01f;
+
+    // Feeds the junctions of a circle of the given radius divided into lines of step radians,
+    // returning the speed squared at each.
+    std::vector<float> circle(float radius, float step, int junctions) {
+        CornerCurvature    c;
+        float              mm = 2.0f * radius * std::sin(0.5f * step);
+        std::vector<float> speeds;
+        for (int i = 0; i < junctions; ++i) {
+            speeds.push_back(c.junction_speed_sqr(mm, mm, std::cos(step), tolerance, accel));
+        }
+        return speeds;
+    }
+
+    TEST(CornerCurvature, FollowsCircle) {
+        auto speeds = circle(20.0f, 0.05f, 5);
+        EXPECT_EQ(speeds[0], 0.0f);  // The first junction has no neighbour to agree with
+        for (size_t i = 1; i < speeds.size(); ++i) {
+            EXPECT_NEAR(speeds[i], accel * 20.0f, accel * 20.0f * 1e-3f);
+        }
+    }
+
+    TEST(CornerCurvature, CoarseLinesAreCorners) {
+        // Lines 2 mm long on a 20 mm circle stray 25 microns from it
+        for (auto speed : circle(20.0f, 0.1f, 5)) {
+            EXPECT_EQ(speed, 0.0f);
+        }
+    }
+
+    TEST(CornerCurvature, LoneCorner) {
+        CornerCurvature c;
+        // Long lines meeting at a small angle, then a short curve-like pair after a straight
+        EXPECT_EQ(c.junction_speed_sqr(50.0f, 50.0f, std::cos(0.2f), tolerance, accel), 0.0f);
+        EXPECT_EQ(c.junction_speed_sqr(50.0f, 0.5f, std::cos(0.02f), tolerance, accel), 0.0f);
+        c.reset();
+        EXPECT_EQ(c.junction_speed_sqr(0.5f, 0.5f, std::cos(0.02f), tolerance, accel), 0.0f);
+    }
+
+    TEST(CornerCurvature, RadiusChangeUsesSmaller) {
+        CornerCurvature c;
+        c.junction_speed_sqr(1.0f, 1.0f, std::cos(1.0f / 30.0f), tolerance, accel);                // R 30
+        float speed = c.junction_speed_sqr(1.0f, 1.0f, std::cos(1.0f / 20.0f), tolerance, accel);  // R 20
+        EXPECT_NEAR(speed, accel * 20.0f, accel * 0.1f);
+        // A jump by more than a factor of two is not a smooth curve
+        EXPECT_EQ(c.junction_speed_sqr(0.2f, 0.2f, std::cos(0.2f / 5.0f), tolerance, accel), 0.0f);
+    }
+
+    TEST(CornerCurvature, Disabled) {
+        CornerCurvature c;
+        float           mm = 0.5f, cosine = std::cos(0.01f);
+        c.junction_speed_sqr(mm, mm, cosine, 0.0f, accel);
+        EXPECT_EQ(c.junction_speed_sqr(mm, mm, cosine, 0.0f, accel), 0.0f);
+    }
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/Kinematics/DeltaMath.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace Kinematics;
+
+namespace {
+    // The previous implementation, computed in double throughout as the reference
+    bool ref_angle(const DeltaGeometry& g, double x0, double y0, double z0, double& theta) {
+        double y1 = -0.5 * 0.57735026919 * g.f;
+        y0 -= 0.5 * 0.57735026919 * g.e;
+        double a = (x0 * x0 + y0 * y0 + z0 * z0 + g.rf * g.rf - g.re * g.re - y1 * y1) / (2 * z0);
+        double b = (y1 - y0) / z0;
+        double d = -(a + b * y1) * (a + b * y1) + g.rf * (b * b * g.rf + g.rf);
+        if (d < 0) {
+            return false;
+        }
+        double yj = (y1 - a * b - sqrt(d)) / (b * b + 1);
+        double zj = a + b * yj;
+        theta     = atan(-zj / (y1 - yj)) + ((yj > y1) ? M_PI : 0.0);
+        return true;
+    }
+
+    bool ref_inverse(const DeltaGeometry& g, const float* c, double* m) {
+        double s = sqrt(3.0) / 2, k = -0.5;
+        return ref_angle(g, c[0], c[1], c[2], m[0]) && ref_angle(g, c[0] * k + c[1] * s, c[1] * k - c[0] * s, c[2], m[1]) &&
+               ref_angle(g, c[0] * k - c[1] * s, c[1] * k + c[0] * s, c[2], m[2]);
+    }
+
+    template <typename F>
+    double ns_per_call(F f, int n) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; ++i) {
+            f(i);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+    }
+}
+
+TEST(DeltaMath, InverseMatchesDoubleReference) {
+    DeltaGeometry g;
+    int           checked = 0;
+    for (float z = -180.0f; z <= -100.0f; z += 5.0f) {
+        for (float x = -60.0f; x <= 60.0f; x += 5.0f) {
+            for (float y = -60.0f; y <= 60.0f; y += 5.0f) {
+                float  cart[3] = { x, y, z };
+                float  motors[3];
+                double ref[3];
+                bool   ok = ref_inverse(g, cart, ref);
+                ASSERT_EQ(DeltaMath::inverse(g, cart, motors), ok) << x << "," << y << "," << z;
+                if (ok) {
+                    for (int i = 0; i < 3; ++i) {
+                        EXPECT_NEAR(motors[i], ref[i], 1e-4) << x << "," << y << "," << z;
+                    }
+                    ++checked;
+                }
+            }
+        }
+    }
+    EXPECT_GT(checked, 1000);
+}
+
+TEST(DeltaMath, ForwardInvertsInverse) {
+    DeltaGeometry g;
+    for (float z = -180.0f; z <= -100.0f; z += 10.0f) {
+        for (float x = -50.0f; x <= 50.0f; x += 10.0f) {
+            for (float y = -50.0f; y <= 50.0f; y += 10.0f) {
+                float cart[3] = { x, y, z };
+                float motors[3];
+                float back[3];
+                if (DeltaMath::inverse(g, cart, motors)) {
+                    ASSERT_TRUE(DeltaMath::forward(g, motors, back));
+                    for (int i = 0; i < 3; ++i) {
+                        EXPECT_NEAR(back[i], cart[i], 0.005f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(DeltaMath, Throughput) {
+    DeltaGeometry  g;
+    const int      n    = 200000;
+    volatile float sink = 0;
+
+    double f_ns = ns_per_call(
+        [&](int i) {
+            float cart[3] = { float(i % 97) - 48.0f, float(i % 89) - 44.0f, -140.0f };
+            float m[3];
+            DeltaMath::inverse(g, cart, m);
+            sink = sink + m[0];
+        },
+        n);
+    double d_ns = ns_per_call(
+        [&](int i) {
+            float  cart[3] = { float(i % 97) - 48.0f, float(i % 89) - 44.0f, -140.0f };
+            double m[3];
+            ref_inverse(g, cart, m);
+            sink = sink + m[0];
+        },
+        n);
+    // Timing on the host is only indicative; on the ESP32 the double path is emulated
+    printf("delta inverse: float %.1f ns, double %.1f ns per call\n", f_ns, d_ns);
+    EXPECT_GT(f_ns, 0.0);
+}
+
+TEST(DeltaMath, GridIsCloseToExact) {
+    DeltaGeometry g;
+    DeltaGrid     grid;
+    float         lo[3] = { -60.0f, -60.0f, -180.0f };
+    float         hi[3] = { 60.0f, 60.0f, -100.0f };
+    EXPECT_FALSE(grid.build(g, lo, hi, 1.0f, 8192, 0.001f));
+    EXPECT_FALSE(grid.active());
+    ASSERT_TRUE(grid.build(g, lo, hi, 5.0f, 16384, 0.001f));
+
+    float bound = grid.max_error();
+    EXPECT_LE(bound, 0.001f);
+    EXPECT_GT(grid.coverage(), 0.5f);
+    printf("delta grid: %d nodes, %.0f%% of cells used\n", int(grid.nodes()), grid.coverage() * 100);
+
+    int used = 0;
+    for (float z = -179.0f; z < -100.0f; z += 3.7f) {
+        for (float x = -59.0f; x < 60.0f; x += 4.3f) {
+            for (float y = -59.0f; y < 60.0f; y += 4.1f) {
+                float cart[3] = { x, y, z };
+                float approx[3], exact[3];
+                if (grid.inverse(cart, approx)) {
+                    ASSERT_TRUE(DeltaMath::inverse(g, cart, exact));
+                    for (int i = 0; i < 3; ++i) {
+                        EXPECT_NEAR(approx[i], exact[i], 2 * bound);
+                    }
+                    ++used;
+                }
+            }
+        }
+    }
+    EXPECT_GT(used, 1000);
+
+    float outside[3] = { 61.0f, 0.0f, -140.0f };
+    float motors[3];
+    EXPECT_FALSE(grid.inverse(outside, motors));
+}
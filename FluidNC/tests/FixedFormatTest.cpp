@@ -0,0 +1,82 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "Bench.h"
+#include "src/FixedFormat.h"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+static std::string fixed(float value, int decimals) {
+    char buf[fixedStringLen];
+    size_t len = format_fixed(buf, value, decimals);
+    EXPECT_EQ(len, strlen(buf));
+    return buf;
+}
+
+TEST(FixedFormat, Decimals) {
+    EXPECT_EQ(fixed(0.0f, 3), "0.000");
+    EXPECT_EQ(fixed(12.5f, 3), "12.500");
+    EXPECT_EQ(fixed(-12.5f, 4), "-12.5000");
+    EXPECT_EQ(fixed(1500.0f, 0), "1500");
+    EXPECT_EQ(fixed(0.25f, 1), "0.3");
+    EXPECT_EQ(fixed(-0.0004f, 3), "-0.000");
+}
+
+TEST(FixedFormat, Rounding) {
+    EXPECT_EQ(fixed(1.9996f, 3), "2.000");
+    EXPECT_EQ(fixed(-999.9999f, 3), "-1000.000");
+    EXPECT_EQ(fixed(0.00049f, 3), "0.000");
+}
+
+TEST(FixedFormat, MatchesIostream) {
+    for (int i = -20000; i <= 20000; i += 7) {
+        float value = i * 0.0123f;
+        for (int decimals : { 3, 4 }) {
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(decimals) << value;
+            // Float scaling can round the last digit the other way at an exact half
+            std::string expect = msg.str();
+            std::string got    = fixed(value, decimals);
+            if (got != expect) {
+                EXPECT_NEAR(std::stod(got), std::stod(expect), 1.01 * std::pow(10.0, -decimals)) << value;
+            }
+        }
+    }
+}
+
+TEST(FixedFormat, OutOfRange) {
+    EXPECT_EQ(fixed(1e13f, 0), "9999999827968");
+    EXPECT_EQ(fixed(NAN, 3), "nan");
+    EXPECT_EQ(fixed(-INFINITY, 3), "-inf");
+}
+
+TEST(FixedFormat, AxesBenchmark) {
+    float axes[6] = { 123.456f, -78.9f, 0.001f, 360.0f, -1234.5678f, 5.0f };
+
+    std::string report;
+    auto        stream = bench_ns_per_call(100000, [&] {
+        std::ostringstream msg;
+        for (float value : axes) {
+            msg << std::fixed << std::setprecision(3) << value << ",";
+        }
+        report = msg.str();
+    });
+    char buf[fixedStringLen * 6];
+    auto direct = bench_ns_per_call(100000, [&] {
+        char* p = buf;
+        for (float value : axes) {
+            p += format_fixed(p, value, 3);
+            *p++ = ',';
+        }
+        *p = '\0';
+    });
+    EXPECT_EQ(report, buf);
+    bench_report("ostringstream 6 axes", stream, "ns");
+    bench_report("format_fixed 6 axes", direct, "ns");
+    bench_report("format_fixed reports/s", 1e9 / direct, "reports/s");
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/HeightMap.h"
+
+namespace {
+    // A tilted plane
+    void fill(HeightMap& map) {
+        for (int j = 0; j < map.ny(); ++j) {
+            for (int i = 0; i < map.nx(); ++i) {
+                map.set(i, j, 5.0f + 0.01f * map.x(i) - 0.02f * map.y(j));
+            }
+        }
+    }
+}
+
+TEST(HeightMap, Interpolation) {
+    HeightMap map;
+    EXPECT_FALSE(map.resize(0, 0, 100, 50, 1, 3));
+    ASSERT_TRUE(map.resize(0, 0, 100, 50, 5, 3));
+    EXPECT_FLOAT_EQ(map.spacing(), 25.0f);
+    EXPECT_FALSE(map.enable(true));  // Not probed yet
+    EXPECT_FALSE(map.active());
+
+    fill(map);
+    map.normalize();
+    EXPECT_FLOAT_EQ(map.z(0, 0), 0.0f);
+    EXPECT_TRUE(map.enable(true));
+    EXPECT_TRUE(map.active());
+
+    // Bilinear interpolation reproduces a plane
+    for (float y = 0; y <= 50; y += 3.7f) {
+        for (float x = 0; x <= 100; x += 4.3f) {
+            EXPECT_NEAR(map.offset(x, y), 0.01f * x - 0.02f * y, 1e-5) << x << "," << y;
+        }
+    }
+    // and holds the edge outside the grid
+    EXPECT_NEAR(map.offset(-10, -10), 0.0f, 1e-5);
+    EXPECT_NEAR(map.offset(200, 80), 0.01f * 100 - 0.02f * 50, 1e-5);
+
+    map.set(2, 1, map.z(2, 1) + 1.0f);
+    EXPECT_NEAR(map.offset(50, 25), 0.5f - 0.5f + 1.0f, 1e-5);
+    EXPECT_NEAR(map.offset(62.5f, 25), 0.625f - 0.5f + 0.5f, 1e-5);
+}
+
+TEST(HeightMap, Text) {
+    HeightMap map;
+    ASSERT_TRUE(map.resize(-20, 10, 40, 70, 4, 3));
+    fill(map);
+    map.normalize();
+    std::string text = map.to_text();
+
+    HeightMap copy;
+    ASSERT_TRUE(copy.from_text(text.c_str()));
+    EXPECT_EQ(copy.nx(), 4);
+    EXPECT_EQ(copy.ny(), 3);
+    EXPECT_TRUE(copy.complete());
+    EXPECT_FALSE(copy.active());  // Loading does not turn compensation on
+    for (float y = 10; y <= 70; y += 7) {
+        for (float x = -20; x <= 40; x += 6) {
+            EXPECT_NEAR(copy.offset(x, y), map.offset(x, y), 1e-3);
+        }
+    }
+
+    EXPECT_FALSE(copy.from_text("0 0 10 10 3 3\n1 2 3\n4 5\n"));
+    EXPECT_TRUE(copy.empty());
+    EXPECT_FALSE(copy.from_text("0 0 0 10 3 3\n"));
+    EXPECT_FALSE(copy.from_text("garbage"));
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/InputShaper.h"
+
+namespace {
+    const float dt = 1.0f / (100 * 60);  // DT_SEGMENT at 100 ticks per second
+}
+
+TEST(InputShaper, ImpulsesHaveUnitGain) {
+    for (int type : { InputShaper::ZV, InputShaper::ZVD, InputShaper::MZV }) {
+        auto  s   = InputShaper::impulses(type, 40.0f, 0.1f);
+        float sum = 0.0f;
+        for (int i = 0; i < s.count; ++i) {
+            sum += s.amplitude[i];
+            EXPECT_GT(s.amplitude[i], 0.0f);
+        }
+        EXPECT_NEAR(sum, 1.0f, 1e-6f);
+        EXPECT_EQ(s.time[0], 0.0f);
+    }
+    EXPECT_EQ(InputShaper::impulses(InputShaper::None, 40.0f, 0.1f).count, 0);
+}
+
+TEST(InputShaper, ZVDelayIsHalfThePeriod) {
+    auto s = InputShaper::impulses(InputShaper::ZV, 50.0f, 0.0f);
+    ASSERT_EQ(s.count, 2);
+    EXPECT_NEAR(s.time[1] * 60.0f, 0.01f, 1e-6f);
+    EXPECT_NEAR(s.amplitude[0], 0.5f, 1e-6f);
+}
+
+TEST(InputShaper, ConstantSpeedIsUnchanged) {
+    auto                      s = InputShaper::impulses(InputShaper::ZVD, 20.0f, 0.1f);
+    InputShaper::SpeedHistory history;
+    // From rest the first segments are slowed, then the shaped speed settles on the input.
+    float first = history.shape(s, dt, 1000.0f * dt);
+    EXPECT_GT(first, dt);
+    float last = 0.0f;
+    for (int i = 0; i < 40; ++i) {
+        last = history.shape(s, dt, 1000.0f * dt);
+    }
+    EXPECT_NEAR(last, dt, dt * 1e-4f);
+}
+
+TEST(InputShaper, SpeedStepIsSpread) {
+    auto                      s = InputShaper::impulses(InputShaper::ZV, 25.0f, 0.0f);
+    InputShaper::SpeedHistory history;
+    for (int i = 0; i < 40; ++i) {
+        history.shape(s, dt, 600.0f * dt);
+    }
+    // The speed doubles; the ZV shaper at 25 Hz delays half of the change by 20 ms, two segments.
+    float shaped[4];
+    for (int i = 0; i < 4; ++i) {
+        shaped[i] = 1200.0f * dt / history.shape(s, dt, 1200.0f * dt);
+    }
+    EXPECT_NEAR(shaped[0], 900.0f, 1.0f);
+    EXPECT_NEAR(shaped[1], 900.0f, 1.0f);
+    EXPECT_NEAR(shaped[2], 1200.0f, 1.0f);
+    EXPECT_NEAR(shaped[3], 1200.0f, 1.0f);
+}
+
+TEST(InputShaper, NoShaperKeepsTime) {
+    InputShaper::Impulses     none;
+    InputShaper::SpeedHistory history;
+    EXPECT_EQ(history.shape(none, dt, 10.0f * dt), dt);
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "Simulator.h"
+#include "src/JobEstimate.h"
+
+namespace {
+    const float accel = 200.0f * 3600.0f;  // mm/min^2
+
+    // The time from the same profile the simulated stepper follows
+    double simulated(float entry, float nominal, float exit, float mm) {
+        return Simulator::Trapezoid(entry, exit, nominal, accel, mm).duration();
+    }
+}
+
+TEST(JobEstimate, Cruise) {
+    // 100 mm at 6000 mm/min from and to rest: 0.5 s ramps of 25 mm each, 50 mm of cruise
+    EXPECT_NEAR(block_minutes(0.0f, 6000.0f, 0.0f, accel, 100.0f) * 60.0f, 1.5f, 1e-4f);
+    EXPECT_NEAR(block_minutes(0.0f, 6000.0f, 0.0f, accel, 100.0f), simulated(0.0f, 6000.0f, 0.0f, 100.0f), 1e-6);
+    EXPECT_NEAR(block_minutes(1000.0f, 3000.0f, 2000.0f, accel, 10.0f), simulated(1000.0f, 3000.0f, 2000.0f, 10.0f), 1e-6);
+    EXPECT_NEAR(block_minutes(1500.0f, 1500.0f, 1500.0f, accel, 3.0f), 3.0f / 1500.0f, 1e-7);
+}
+
+TEST(JobEstimate, Triangle) {
+    // Too short to reach the nominal speed
+    EXPECT_NEAR(block_minutes(0.0f, 6000.0f, 0.0f, accel, 10.0f), simulated(0.0f, 6000.0f, 0.0f, 10.0f), 1e-6);
+    EXPECT_NEAR(block_minutes(500.0f, 6000.0f, 1200.0f, accel, 2.0f), simulated(500.0f, 6000.0f, 1200.0f, 2.0f), 1e-6);
+}
+
+TEST(JobEstimate, SingleRamp) {
+    // Decelerating the whole block, as into a stop
+    float v = sqrtf(2.0f * accel * 5.0f);
+    EXPECT_NEAR(block_minutes(v, v, 0.0f, accel, 5.0f), v / accel, 1e-6f);
+    // Entry above a lowered nominal speed, with no room to reach it
+    EXPECT_NEAR(block_minutes(3000.0f, 1000.0f, 2900.0f, accel, 0.5f), 1.0f / 5900.0f, 1e-7f);
+    EXPECT_EQ(block_minutes(0.0f, 3000.0f, 0.0f, accel, 0.0f), 0.0f);
+}
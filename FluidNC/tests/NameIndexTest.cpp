@@ -0,0 +1,82 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/NameIndex.h"
+#include "Bench.h"
+
+#include <cstring>
+#include <string>
+
+TEST(NameIndex, FindsCaseInsensitively) {
+    int            a = 1, b = 2;
+    NameIndex<int> index;
+    index.add("Report/Interval", &a);
+    index.add("ESP800", &b);
+    index.add(nullptr, &b);
+    index.sort();
+
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(index.find("report/interval"), &a);
+    EXPECT_EQ(index.find("esp800"), &b);
+    EXPECT_EQ(index.find("ESP801"), nullptr);
+    EXPECT_EQ(index.find(""), nullptr);
+}
+
+TEST(NameIndex, FirstAddedWins) {
+    int            a = 1, b = 2;
+    NameIndex<int> index;
+    index.add("X", &a);
+    index.add("x", &b);
+    index.sort();
+    EXPECT_EQ(index.find("X"), &a);
+}
+
+TEST(NameIndex, ManyNames) {
+    std::vector<std::string> names;
+    std::vector<int>         items(500);
+    for (int i = 0; i < 500; i++) {
+        names.push_back("Setting/" + std::to_string(i));
+    }
+    NameIndex<int> index;
+    for (int i = 0; i < 500; i++) {
+        index.add(names[i].c_str(), &items[i]);
+    }
+    index.sort();
+    for (int i = 0; i < 500; i++) {
+        EXPECT_EQ(index.find(names[i].c_str()), &items[i]);
+    }
+}
+
+// Compares the index with the linear strcasecmp() scan of the settings list that it replaced
+TEST(NameIndex, LookupBenchmark) {
+    const int                n_names = 300;
+    std::vector<std::string> names;
+    std::vector<int>         items(n_names);
+    NameIndex<int>           index;
+    for (int i = 0; i < n_names; i++) {
+        names.push_back("Group" + std::to_string(i % 10) + "/Setting" + std::to_string(i));
+    }
+    for (int i = 0; i < n_names; i++) {
+        index.add(names[i].c_str(), &items[i]);
+    }
+    index.sort();
+
+    int  next   = 0;
+    int* found  = nullptr;
+    auto linear = bench_ns_per_call(100000, [&] {
+        const char* name = names[next++ % n_names].c_str();
+        for (int i = 0; i < n_names; i++) {
+            if (!strcasecmp(names[i].c_str(), name)) {
+                found = &items[i];
+                break;
+            }
+        }
+    });
+    EXPECT_NE(found, nullptr);
+    auto indexed = bench_ns_per_call(100000, [&] { found = index.find(names[next++ % n_names].c_str()); });
+    EXPECT_NE(found, nullptr);
+
+    bench_report("linear scan lookup", linear, "ns");
+    bench_report("NameIndex lookup", indexed, "ns");
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/ParamTable.h"
+#include "Bench.h"
+
+#include <chrono>
+#include <map>
+
+TEST(ParamTable, SetAndGet) {
+    ParamTable<16> table;
+    float          value;
+    EXPECT_FALSE(table.get("X", value));
+    EXPECT_TRUE(table.set("X", 1.5f));
+    EXPECT_TRUE(table.get("X", value));
+    EXPECT_EQ(value, 1.5f);
+    EXPECT_TRUE(table.set("X", 2.5f));
+    EXPECT_TRUE(table.get("X", value));
+    EXPECT_EQ(value, 2.5f);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_FALSE(table.set("", 1.0f));
+}
+
+TEST(ParamTable, NamesAreCaseInsensitive) {
+    ParamTable<16> table;
+    float          value;
+    table.set("depth", 3.0f);
+    EXPECT_TRUE(table.exists("DEPTH"));
+    EXPECT_TRUE(table.get("Depth", value));
+    EXPECT_EQ(value, 3.0f);
+    EXPECT_FALSE(table.exists("DEPT"));
+}
+
+TEST(ParamTable, FullTableRejectsNewNames) {
+    ParamTable<8> table;
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_TRUE(table.set("P" + std::to_string(i), float(i)));
+    }
+    EXPECT_FALSE(table.set("P7", 7.0f));
+    EXPECT_FALSE(table.exists("P7"));
+    EXPECT_TRUE(table.set("P3", 30.0f));  // Existing names can still be assigned
+    for (int i = 0; i < 7; ++i) {
+        float value;
+        EXPECT_TRUE(table.get("P" + std::to_string(i), value));
+        EXPECT_EQ(value, i == 3 ? 30.0f : float(i));
+    }
+}
+
+// Compares lookups of the table with the std::map<std::string, float> it replaced, for the
+// pattern of a parametric program that reads a few names on every line.  The parser hands
+// names to the store as text, so the map needs a std::string for every lookup.
+TEST(ParamTable, LookupBenchmark) {
+    const char* names[] = { "X_START", "Y_START", "STEP", "DEPTH", "PASS", "FEED", "TOOL_DIA", "STEPOVER" };
+    const int   n_names = sizeof(names) / sizeof(names[0]);
+    const int   rounds  = 200000;
+
+    ParamTable<64>               table;
+    std::map<std::string, float> map;
+    for (int i = 0; i < n_names; ++i) {
+        table.set(names[i], float(i));
+        map[names[i]] = float(i);
+    }
+
+    using clock = std::chrono::steady_clock;
+    float sum_map = 0.0f;
+    auto  t0      = clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        std::string name(names[r % n_names]);
+        auto        it = map.find(name);
+        sum_map += it->second;
+    }
+    auto  t1        = clock::now();
+    float sum_table = 0.0f;
+    for (int r = 0; r < rounds; ++r) {
+        float value;
+        table.get(names[r % n_names], value);
+        sum_table += value;
+    }
+    auto t2 = clock::now();
+    EXPECT_EQ(sum_map, sum_table);
+
+    auto ns = [](clock::duration d) { return std::chrono::duration<double, std::nano>(d).count() / rounds; };
+    bench_report("std::map lookup", ns(t1 - t0), "ns");
+    bench_report("ParamTable lookup", ns(t2 - t1), "ns");
+}
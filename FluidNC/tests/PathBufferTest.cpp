@@ -0,0 +1,75 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/PathBuffer.h"
+
+#include <string>
+
+TEST(PathBuffer, AppendAddsSeparators) {
+    PathBuffer<32> path("/sd");
+    EXPECT_TRUE(path.append("jobs"));
+    EXPECT_EQ(path.view(), "/sd/jobs");
+
+    PathBuffer<32> slash("/sd/");
+    EXPECT_TRUE(slash.append("jobs"));
+    EXPECT_STREQ(slash.c_str(), "/sd/jobs");
+}
+
+TEST(PathBuffer, TruncateReusesTheDirectory) {
+    PathBuffer<32> path("/localfs");
+    size_t         base = path.length();
+    EXPECT_TRUE(path.append("config.yaml"));
+    EXPECT_EQ(path.view(), "/localfs/config.yaml");
+    path.truncate(base);
+    EXPECT_TRUE(path.append("index.html.gz"));
+    EXPECT_EQ(path.view(), "/localfs/index.html.gz");
+}
+
+TEST(PathBuffer, OverflowLeavesThePathUnchanged) {
+    PathBuffer<12> path("/sd/a");
+    EXPECT_FALSE(path.append("toolong.nc"));
+    EXPECT_EQ(path.view(), "/sd/a");
+    EXPECT_TRUE(path.append("b.nc"));
+    EXPECT_EQ(path.view(), "/sd/a/b.nc");
+
+    EXPECT_FALSE(path.assign("/sd/0123456789"));
+    EXPECT_EQ(path.length(), 0u);
+}
+
+TEST(PathBuffer, Mount) {
+    EXPECT_EQ(path_mount("/sd/jobs/part.nc"), "sd");
+    EXPECT_EQ(path_mount("/localfs"), "localfs");
+    EXPECT_EQ(path_mount("/"), "");
+    EXPECT_EQ(path_mount("sd/jobs"), "");
+}
+
+TEST(PathBuffer, Tail) {
+    EXPECT_TRUE(path_has_tail("/sd/jobs"));
+    EXPECT_TRUE(path_has_tail("/sd/"));
+    EXPECT_FALSE(path_has_tail("/sd"));
+    EXPECT_FALSE(path_has_tail("/"));
+}
+
+TEST(PathBuffer, SplitName) {
+    std::string_view stem, extension;
+    path_split_name("part.nc", stem, extension);
+    EXPECT_EQ(stem, "part");
+    EXPECT_EQ(extension, ".nc");
+
+    path_split_name("a.b.gcode", stem, extension);
+    EXPECT_EQ(stem, "a.b");
+    EXPECT_EQ(extension, ".gcode");
+
+    path_split_name(".hidden", stem, extension);
+    EXPECT_EQ(stem, ".hidden");
+    EXPECT_EQ(extension, "");
+
+    path_split_name("Makefile", stem, extension);
+    EXPECT_EQ(stem, "Makefile");
+    EXPECT_EQ(extension, "");
+
+    path_split_name("..", stem, extension);
+    EXPECT_EQ(stem, "..");
+    EXPECT_EQ(extension, "");
+}
@@ -0,0 +1,191 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/PlannerRecalculate.h"
+#include "Bench.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    struct Block {
+        float entry_speed_sqr;
+        float max_entry_speed_sqr;
+        float acceleration;
+        float millimeters;
+    };
+
+    // A minimal stand-in for plan_buffer_line() and plan_discard_current_block(), which
+    // keeps the ring indices the same way Planner.cpp does.
+    class Ring {
+    public:
+        std::vector<Block> blocks;
+        size_t             tail    = 0;
+        size_t             head    = 0;
+        size_t             planned = 0;
+        bool               optimal_window;
+        size_t             tail_changes = 0;
+
+        Ring(size_t size, bool optimal) : blocks(size), optimal_window(optimal) {}
+
+        size_t next(size_t index) const { return ++index == blocks.size() ? 0 : index; }
+        bool   full() const { return next(head) == tail; }
+
+        void discard() {
+            size_t index = next(tail);
+            if (tail == planned) {
+                planned = index;
+            }
+            tail = index;
+        }
+
+        void push(float millimeters, float max_entry_speed_sqr) {
+            if (full()) {
+                discard();
+            }
+            Block& block              = blocks[head];
+            block.entry_speed_sqr     = 0.0f;
+            block.max_entry_speed_sqr = head == tail ? 0.0f : max_entry_speed_sqr;
+            block.acceleration        = 200.0f * 60 * 60;  // 200 mm/sec^2 in mm/min^2
+            block.millimeters         = millimeters;
+            head                      = next(head);
+            Planner::recalculate(blocks.data(), blocks.size(), tail, head, planned, optimal_window, [this] { ++tail_changes; });
+        }
+    };
+
+    // A dense CAM-like toolpath: short segments along a spiral whose curvature keeps changing,
+    // with junction speeds from the same junction deviation model the planner uses.  With a
+    // small max_turn the path is nearly straight, so the junctions do not limit the speed and
+    // the look-ahead window spans most of the ring.
+    class Toolpath {
+        float _max_turn;
+        float _angle = 0.0f;
+        float _turn  = 0.0f;
+        int   _n     = 0;
+
+    public:
+        explicit Toolpath(float max_turn = 0.3f) : _max_turn(max_turn) {}
+
+        void next(float& millimeters, float& max_entry_speed_sqr) {
+            const float feed      = 6000.0f;  // mm/min
+            const float accel     = 200.0f * 60 * 60;
+            const float deviation = 0.01f;
+
+            millimeters = 0.02f + 0.08f * float((_n * 7919) % 100) / 100.0f;
+            _turn       = 0.1f * _max_turn + 0.9f * _max_turn * std::fabs(std::sin(_n * 0.013f));
+            _angle += _turn;
+            ++_n;
+
+            float sin_theta_d2  = std::sin(0.5f * (float(M_PI) - _turn));
+            float junction_sqr  = (accel * deviation * sin_theta_d2) / (1.0f - sin_theta_d2);
+            max_entry_speed_sqr = std::fmin(feed * feed, junction_sqr);
+        }
+    };
+
+    void expect_same_speeds(const Ring& a, const Ring& b) {
+        ASSERT_EQ(a.tail, b.tail);
+        ASSERT_EQ(a.head, b.head);
+        for (size_t i = a.tail; i != a.head; i = a.next(i)) {
+            ASSERT_EQ(a.blocks[i].entry_speed_sqr, b.blocks[i].entry_speed_sqr) << "block " << i;
+        }
+    }
+
+    void expect_same_plan(const Ring& a, const Ring& b) {
+        ASSERT_EQ(a.planned, b.planned);
+        expect_same_speeds(a, b);
+    }
+
+    double blocks_per_second(size_t ring_size, bool optimal, size_t n_blocks, float max_turn) {
+        Ring     ring(ring_size, optimal);
+        Toolpath path(max_turn);
+        auto     start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n_blocks; ++i) {
+            float mm, max_entry;
+            path.next(mm, max_entry);
+            ring.push(mm, max_entry);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return n_blocks / elapsed.count();
+    }
+}
+
+TEST(PlannerRecalculate, OptimalWindowMatchesFullReplan) {
+    for (size_t ring_size : { 16, 65, 256 }) {
+        for (float max_turn : { 0.3f, 0.002f }) {
+            Ring     full(ring_size, false);
+            Ring     windowed(ring_size, true);
+            Toolpath path(max_turn);
+            for (int i = 0; i < 5000; ++i) {
+                float mm, max_entry;
+                path.next(mm, max_entry);
+                full.push(mm, max_entry);
+                windowed.push(mm, max_entry);
+                expect_same_plan(full, windowed);
+            }
+            EXPECT_LE(windowed.tail_changes, full.tail_changes);
+        }
+    }
+}
+
+TEST(PlannerRecalculate, SingleLongMoveStopsAtEnd) {
+    Ring ring(16, true);
+    ring.push(100.0f, 6000.0f * 6000.0f);
+    EXPECT_EQ(ring.blocks[0].entry_speed_sqr, 0.0f);
+    ring.push(100.0f, 6000.0f * 6000.0f);
+    // The second block must be able to stop by its end, and the first block starts from rest.
+    EXPECT_EQ(ring.blocks[0].entry_speed_sqr, 0.0f);
+    EXPECT_LE(ring.blocks[1].entry_speed_sqr, 6000.0f * 6000.0f);
+    EXPECT_GT(ring.blocks[1].entry_speed_sqr, 0.0f);
+}
+
+TEST(PlannerRecalculate, ReplanFromStopMatchesFullReplan) {
+    for (bool optimal : { false, true }) {
+        Ring     ring(65, optimal);
+        Toolpath path(0.05f);
+        for (int i = 0; i < 2000; ++i) {
+            float mm, max_entry;
+            path.next(mm, max_entry);
+            ring.push(mm, max_entry);
+            if (i % 37 == 0) {
+                // A feed hold brings the block at the tail to a stop
+                Ring full    = ring;
+                Ring resumed = ring;
+                full.blocks[full.tail].entry_speed_sqr       = 0.0f;
+                resumed.blocks[resumed.tail].entry_speed_sqr = 0.0f;
+                full.planned                                 = full.tail;
+                Planner::recalculate(full.blocks.data(), full.blocks.size(), full.tail, full.head, full.planned, false, [] {});
+                Planner::replan_from_stop(resumed.blocks.data(), resumed.blocks.size(), resumed.tail, resumed.head, resumed.planned);
+                expect_same_speeds(full, resumed);
+
+                // The planned index may stay further back, which only costs later replans some time
+                Toolpath more(0.3f);
+                for (int j = 0; j < 10; ++j) {
+                    more.next(mm, max_entry);
+                    full.push(mm, max_entry);
+                    resumed.push(mm, max_entry);
+                    expect_same_speeds(full, resumed);
+                }
+            }
+        }
+    }
+}
+
+// Not a pass/fail test; reports planner throughput for a dense toolpath in both modes.
+TEST(PlannerRecalculate, Benchmark) {
+    const size_t n_blocks = 50000;
+    for (float max_turn : { 0.3f, 0.002f }) {
+        for (size_t ring_size : { 16, 128, 512 }) {
+            double full     = blocks_per_second(ring_size, false, n_blocks, max_turn);
+            double windowed = blocks_per_second(ring_size, true, n_blocks, max_turn);
+            char name[64];
+            snprintf(name, sizeof(name), "turn %.3f rad, %zu blocks, full replan", max_turn, ring_size);
+            bench_report(name, full, "blocks/s");
+            snprintf(name, sizeof(name), "turn %.3f rad, %zu blocks, optimal window", max_turn, ring_size);
+            bench_report(name, windowed, "blocks/s");
+            EXPECT_GT(windowed, 0.0);
+        }
+    }
+}
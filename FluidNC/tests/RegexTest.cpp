@@ -0,0 +1,129 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/Regex.h"
+#include "Bench.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+    // The recursive matcher that Regex replaced, to check that they agree
+    bool pikeHere(const char* regexp, const char* text, bool case_sensitive);
+
+    bool pikeStar(const char* regexp, const char* text, bool case_sensitive) {
+        do {
+            if (pikeHere(regexp, text, case_sensitive)) {
+                return true;
+            }
+        } while (*text++ != '\0');
+        return false;
+    }
+
+    bool pikeHere(const char* regexp, const char* text, bool case_sensitive) {
+        if (regexp[0] == '\0') {
+            return true;
+        }
+        if (regexp[0] == '*') {
+            return pikeStar(regexp + 1, text, case_sensitive);
+        }
+        if (regexp[0] == '$' && regexp[1] == '\0') {
+            return *text == '\0';
+        }
+        if (*text != '\0' && (case_sensitive ? regexp[0] == *text : tolower(regexp[0]) == tolower(*text))) {
+            return pikeHere(regexp + 1, text + 1, case_sensitive);
+        }
+        return false;
+    }
+
+    bool pike(const char* regexp, const char* text, bool case_sensitive) {
+        if (regexp[0] == '^') {
+            return pikeHere(regexp + 1, text, case_sensitive);
+        }
+        return pikeStar(regexp, text, case_sensitive);
+    }
+
+    const std::vector<std::string> names = {
+        "Report/Interval", "Report/Status", "Start/Message", "Firmware/Build", "Hostname", "Sta/SSID", "Sta/Password",
+        "AP/SSID", "AP/Channel", "Config/Filename", "GCode/Echo", "Macro0", "Macro1", "",
+    };
+}
+
+TEST(Regex, Syntax) {
+    EXPECT_TRUE(regexMatch("port", "Report/Interval"));
+    EXPECT_FALSE(regexMatch("^port", "Report/Interval"));
+    EXPECT_TRUE(regexMatch("^rep*val$", "Report/Interval", false));
+    EXPECT_FALSE(regexMatch("^rep*val$", "Report/Interval"));
+    EXPECT_TRUE(regexMatch("ssid$", "AP/SSID", false));
+    EXPECT_FALSE(regexMatch("ssid$", "AP/SSID/x", false));
+    EXPECT_TRUE(regexMatch("^$", ""));
+    EXPECT_FALSE(regexMatch("^$", "x"));
+    EXPECT_TRUE(regexMatch("a$b", "xa$by"));  // $ is literal except at the end
+    EXPECT_TRUE(regexMatch("*", ""));
+}
+
+TEST(Regex, MatchesRecursiveMatcher) {
+    const std::vector<std::string> patterns = {
+        "", "^", "$", "^$", "*", "**", "s", "^s", "s$", "^s$", "sta", "^sta/*", "*/s*d$", "^a*a", "a*a$", "ss*id", "^*s",
+        "m*0", "^macro", "macro$", "o*o*o", "r*r*r$", "^r*l$", "/", "//", "^*$", "p*/*s", "nel$", "^hos*", "e*e", "ab$c",
+    };
+    for (auto& p : patterns) {
+        for (bool cs : { true, false }) {
+            Regex regex(p.c_str(), cs);
+            for (auto& n : names) {
+                EXPECT_EQ(regex.match(n.c_str()), pike(p.c_str(), n.c_str(), cs)) << p << " " << n << " " << cs;
+            }
+        }
+    }
+
+    // Random patterns over a small alphabet, so that runs repeat and overlap
+    srand(1);
+    const char alphabet[] = "ab*";
+    for (int i = 0; i < 20000; ++i) {
+        std::string p, t;
+        if (rand() % 3 == 0) {
+            p += '^';
+        }
+        for (int n = rand() % 6; n; --n) {
+            p += alphabet[rand() % 3];
+        }
+        if (rand() % 3 == 0) {
+            p += '$';
+        }
+        for (int n = rand() % 8; n; --n) {
+            t += "abAB"[rand() % 4];
+        }
+        bool cs = rand() % 2;
+        ASSERT_EQ(Regex(p.c_str(), cs).match(t.c_str()), pike(p.c_str(), t.c_str(), cs)) << p << " " << t << " " << cs;
+    }
+}
+
+TEST(Regex, FilterBenchmark) {
+    // A $S filter over a few hundred names, as from the WebUI settings page
+    std::vector<std::string> many;
+    for (int i = 0; i < 20; ++i) {
+        for (auto& n : names) {
+            many.push_back(n + std::to_string(i));
+        }
+    }
+    for (const char* filter : { "^sta/*d", "ssid" }) {
+        size_t a = 0, b = 0;
+        auto   interpreted = bench_ns_per_call(200, [&] {
+            for (auto& n : many) {
+                a += pike(filter, n.c_str(), false);
+            }
+        });
+        auto compiled = bench_ns_per_call(200, [&] {
+            Regex regex(filter, false);
+            for (auto& n : many) {
+                b += regex.match(n.c_str());
+            }
+        });
+        EXPECT_EQ(a, b);
+        bench_report((std::string(filter) + " interpreted").c_str(), interpreted, "ns");
+        bench_report((std::string(filter) + " compiled").c_str(), compiled, "ns");
+    }
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/SCurve.h"
+
+namespace {
+    const float jerk = 5000.0f * 60 * 60 * 60;  // 5000 mm/sec^3 in mm/min^3
+
+    // Runs a ramp in prep-sized time steps, returning the distance covered and checking
+    // that the speed stays between the end speeds and that the jerk stays within the limit.
+    float run_ramp(SCurveRamp& ramp, float start, float end, float dt) {
+        float distance   = 0.0f;
+        float last_speed = start;
+        float last_accel = 0.0f;
+        float lo         = std::fmin(start, end) * 0.999f;
+        float hi         = std::fmax(start, end) * 1.001f;
+        while (ramp.active()) {
+            float step = dt;
+            distance += ramp.advance(step);
+            float speed = ramp.active() ? ramp.speed() : end;
+            EXPECT_GE(speed, lo);
+            EXPECT_LE(speed, hi);
+            float accel = (speed - last_speed) / step;
+            if (ramp.active() && step == dt && ramp._jerk_time < 0.5f * ramp._duration) {
+                EXPECT_LE(std::fabs(accel - last_accel) / dt, jerk * 1.01f);
+            }
+            last_speed = speed;
+            last_accel = accel;
+        }
+        return distance;
+    }
+}
+
+TEST(SCurve, ZeroJerkIsInactive) {
+    SCurveRamp ramp;
+    ramp.begin(0.0f, 1000.0f, 10.0f, 0.0f);
+    EXPECT_FALSE(ramp.active());
+    ramp.begin(500.0f, 500.0f, 10.0f, jerk);
+    EXPECT_FALSE(ramp.active());
+}
+
+TEST(SCurve, KeepsTrapezoidDistanceAndEndSpeeds) {
+    const float dt = 1.0f / (100 * 60);  // DT_SEGMENT at 100 ticks per second
+    // The 0.5mm ramps are too short to meet the jerk limit, so they are pure S-curves.
+    for (float distance : { 0.5f, 10.0f, 50.0f }) {
+        SCurveRamp up;
+        up.begin(0.0f, 3000.0f, distance, jerk);
+        ASSERT_TRUE(up.active());
+        EXPECT_NEAR(run_ramp(up, 0.0f, 3000.0f, dt), distance, distance * 1e-3f);
+
+        SCurveRamp down;
+        down.begin(3000.0f, 600.0f, distance, jerk);
+        ASSERT_TRUE(down.active());
+        EXPECT_NEAR(run_ramp(down, 3000.0f, 600.0f, dt), distance, distance * 1e-3f);
+    }
+}
+
+TEST(SCurve, ShortRampIsPureS) {
+    SCurveRamp ramp;
+    ramp.begin(0.0f, 3000.0f, 0.5f, jerk);
+    ASSERT_TRUE(ramp.active());
+    EXPECT_FLOAT_EQ(ramp._jerk_time, 0.5f * ramp._duration);
+}
+
+TEST(SCurve, PositionIsContinuousAcrossPhases) {
+    SCurveRamp ramp;
+    ramp.begin(100.0f, 2000.0f, 20.0f, jerk);
+    ASSERT_TRUE(ramp.active());
+    const float eps = ramp._duration * 1e-5f;
+    for (float t : { ramp._jerk_time, ramp._duration - ramp._jerk_time }) {
+        EXPECT_NEAR(ramp.position(t - eps), ramp.position(t + eps), 1e-3f);
+    }
+    EXPECT_NEAR(ramp.position(ramp._duration), 20.0f, 1e-3f);
+}
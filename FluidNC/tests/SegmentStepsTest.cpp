@@ -0,0 +1,105 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "Bench.h"
+#include "Simulator.h"
+#include "src/SegmentSteps.h"
+
+#include <vector>
+
+namespace {
+    const float ticks_per_minute = Simulator::timer_hz * 60.0f;
+
+    struct Segment {
+        uint32_t n_step;
+        uint32_t period;
+    };
+
+    // Runs a block through the quantizer the way prep_buffer() does, with the distance
+    // left at the end of each segment taken from a trapezoid profile.
+    template <typename Quantizer>
+    std::vector<Segment> quantize(uint32_t step_event_count, float mm, float entry, float nominal, float exit, float accel) {
+        Simulator::Trapezoid profile(entry, exit, nominal, accel, mm);
+        float                step_per_mm = step_event_count / mm;
+        double               duration    = profile.duration();
+        std::vector<Segment> segments;
+        Quantizer            q;
+        q.begin(step_event_count);
+        for (double t = 0.0; t < duration;) {
+            double t_next       = std::fmin(t + Simulator::dt_segment, duration);
+            float  mm_remaining = t_next >= duration ? 0.0f : float(mm - profile.position(t_next));
+            float  dt           = float(t_next - t);
+            t                   = t_next;
+            uint32_t n_step     = q.steps(step_per_mm * mm_remaining);
+            uint32_t period     = q.period(dt, ticks_per_minute);
+            q.commit();
+            segments.push_back({ n_step, period });
+        }
+        return segments;
+    }
+
+    void expect_same(uint32_t step_event_count, float mm, float entry, float nominal, float exit, float accel) {
+        auto     f       = quantize<SegmentSteps::Float>(step_event_count, mm, entry, nominal, exit, accel);
+        auto     x       = quantize<SegmentSteps::Fixed>(step_event_count, mm, entry, nominal, exit, accel);
+        uint64_t steps   = 0;
+        double   f_ticks = 0;
+        double   x_ticks = 0;
+        ASSERT_EQ(f.size(), x.size());
+        for (size_t i = 0; i < f.size(); ++i) {
+            ASSERT_EQ(f[i].n_step, x[i].n_step) << "segment " << i;
+            EXPECT_LE(std::abs(int64_t(f[i].period) - int64_t(x[i].period)), 1) << "segment " << i;
+            steps += f[i].n_step;
+            f_ticks += double(f[i].n_step) * f[i].period;
+            x_ticks += double(x[i].n_step) * x[i].period;
+        }
+        EXPECT_EQ(steps, step_event_count);
+        EXPECT_NEAR(x_ticks, f_ticks, f_ticks * 1e-4);
+    }
+}
+
+TEST(SegmentSteps, FixedMatchesFloat) {
+    const float accel = 200.0f * 3600.0f;  // mm/min^2
+    expect_same(800, 10.0f, 0.0f, 3000.0f, 0.0f, accel);
+    expect_same(8000, 100.0f, 0.0f, 5000.0f, 0.0f, accel);
+    expect_same(12, 0.15f, 500.0f, 3000.0f, 200.0f, accel);
+    expect_same(40000, 500.0f, 1000.0f, 1000.0f, 1000.0f, accel);
+    expect_same(3200, 10.0f, 0.0f, 60.0f, 0.0f, accel);  // Slow, with segments of no steps
+}
+
+TEST(SegmentSteps, ZeroStepSegmentCarriesTime) {
+    SegmentSteps::Fixed q;
+    q.begin(10);
+    EXPECT_EQ(q.steps(9.5f), 0u);
+    q.period(0.001f, ticks_per_minute);
+    q.commit();
+    EXPECT_EQ(q.steps(8.5f), 1u);
+    // Two segments of time over 1.5 steps, timed over the one step taken and the carried half
+    uint32_t period = q.period(0.001f, ticks_per_minute);
+    EXPECT_NEAR(period, 0.002 * ticks_per_minute / 1.5, 1.0);
+}
+
+TEST(SegmentSteps, FixedKeepsLongBlocksExact) {
+    // Past 2^24 steps a float cannot hold the step count, but the fixed point state can
+    const uint32_t      count = (1 << 25) + 1;
+    SegmentSteps::Fixed q;
+    q.begin(count);
+    uint64_t steps = 0;
+    for (float left : { float(count) - 1000.5f, 1000.25f, 0.0f }) {
+        steps += q.steps(left);
+        q.period(0.01f, ticks_per_minute);
+        q.commit();
+    }
+    EXPECT_EQ(steps, count);
+}
+
+TEST(SegmentSteps, Benchmark) {
+    const float          accel = 200.0f * 3600.0f;
+    std::vector<Segment> f, x;
+    auto f_ns = bench_ns_per_call(200, [&] { f = quantize<SegmentSteps::Float>(8000, 100.0f, 0.0f, 5000.0f, 0.0f, accel); });
+    auto x_ns = bench_ns_per_call(200, [&] { x = quantize<SegmentSteps::Fixed>(8000, 100.0f, 0.0f, 5000.0f, 0.0f, accel); });
+    EXPECT_EQ(f.size(), x.size());
+    // Includes the profile math of quantize(), which is the same for both
+    bench_report("Float segment", f_ns / f.size(), "ns");
+    bench_report("Fixed segment", x_ns / x.size(), "ns");
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/SeqLock.h"
+
+#include <thread>
+
+struct Sample {
+    uint32_t a;
+    uint32_t b[15];
+};
+
+TEST(SeqLock, ReadsLastWrite) {
+    SeqLock<Sample> lock;
+    Sample          s;
+    EXPECT_EQ(lock.read(s), 0u);
+    EXPECT_EQ(s.a, 0u);
+
+    s.a    = 7;
+    s.b[3] = 9;
+    lock.write(s);
+    Sample out;
+    EXPECT_EQ(lock.read(out), 1u);
+    EXPECT_EQ(out.a, 7u);
+    EXPECT_EQ(out.b[3], 9u);
+    EXPECT_EQ(lock.writes(), 1u);
+}
+
+TEST(SeqLock, ReaderNeverSeesTornValue) {
+    SeqLock<Sample> lock;
+    const uint32_t  n = 200000;
+
+    std::thread writer([&lock, n]() {
+        Sample s;
+        for (uint32_t i = 1; i <= n; i++) {
+            s.a = i;
+            for (auto& v : s.b) {
+                v = i;
+            }
+            lock.write(s);
+        }
+    });
+
+    uint32_t last = 0;
+    while (last < n) {
+        Sample s;
+        lock.read(s);
+        for (auto v : s.b) {
+            ASSERT_EQ(v, s.a);
+        }
+        ASSERT_GE(s.a, last);
+        last = s.a;
+    }
+    writer.join();
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/WebUI/SessionTable.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace {
+    using Table = SessionTable<16>;
+
+    TEST(SessionTable, AddFindRemove) {
+        Table t;
+        ASSERT_NE(t.add(1, AuthenticationLevel::LEVEL_ADMIN, "admin", "00AA", 0), nullptr);
+        ASSERT_NE(t.add(2, AuthenticationLevel::LEVEL_USER, "user", "00BB", 0), nullptr);
+        EXPECT_EQ(t.add(1, AuthenticationLevel::LEVEL_USER, "user", "00AA", 0), nullptr);
+
+        auto s = t.find(1, "00AA", 10);
+        ASSERT_NE(s, nullptr);
+        EXPECT_EQ(s->level, AuthenticationLevel::LEVEL_ADMIN);
+        EXPECT_STREQ(s->userID, "admin");
+        EXPECT_EQ(t.find(2, "00AA", 10), nullptr);  // Wrong address
+
+        EXPECT_TRUE(t.remove(1, "00AA"));
+        EXPECT_FALSE(t.remove(1, "00AA"));
+        EXPECT_EQ(t.find(1, "00AA", 10), nullptr);
+        EXPECT_NE(t.find(2, "00BB", 10), nullptr);
+        EXPECT_EQ(t.size(), 1);
+    }
+
+    TEST(SessionTable, Expiry) {
+        Table t;
+        t.add(1, AuthenticationLevel::LEVEL_USER, "user", "A", 0);
+        auto s = t.find(1, "A", Table::lifetimeMs);
+        ASSERT_NE(s, nullptr);
+        s->last_time = Table::lifetimeMs;  // As a request refreshes it
+        EXPECT_NE(t.find(1, "A", 2 * Table::lifetimeMs), nullptr);
+        EXPECT_EQ(t.find(1, "A", 2 * Table::lifetimeMs + 1), nullptr);
+        EXPECT_EQ(t.size(), 0);
+    }
+
+    TEST(SessionTable, SweepFreesIdleSessions) {
+        Table t;
+        for (int i = 0; i < 5; ++i) {
+            t.add(i, AuthenticationLevel::LEVEL_USER, "user", std::to_string(i).c_str(), 0);
+        }
+        t.add(99, AuthenticationLevel::LEVEL_USER, "user", "live", Table::lifetimeMs);
+        for (size_t i = 0; i < 16; ++i) {
+            t.find(99, "live", Table::lifetimeMs + 1);
+        }
+        EXPECT_EQ(t.size(), 1);
+    }
+
+    TEST(SessionTable, Full) {
+        Table t;
+        for (size_t i = 0; i < Table::maxSessions; ++i) {
+            ASSERT_NE(t.add(i, AuthenticationLevel::LEVEL_USER, "user", "same", 0), nullptr);
+        }
+        EXPECT_EQ(t.add(100, AuthenticationLevel::LEVEL_USER, "user", "other", 0), nullptr);
+        t.remove(3, "same");
+        EXPECT_NE(t.add(100, AuthenticationLevel::LEVEL_USER, "user", "other", 0), nullptr);
+    }
+
+    // Random adds and removes with few distinct IDs, so that probe runs collide and
+    // removal has to move entries back, checked against a map
+    TEST(SessionTable, MatchesMap) {
+        Table                                           t;
+        std::map<std::pair<uint32_t, std::string>, int> ref;
+        std::mt19937                                    rng(7);
+        for (int n = 0; n < 20000; ++n) {
+            uint32_t    ip  = rng() % 4;
+            std::string id  = std::to_string(rng() % 8);
+            auto        key = std::make_pair(ip, id);
+            if (rng() % 2) {
+                bool added = t.add(ip, AuthenticationLevel::LEVEL_USER, "user", id.c_str(), 0) != nullptr;
+                EXPECT_EQ(added, !ref.count(key) && ref.size() < Table::maxSessions);
+                if (added) {
+                    ref[key] = 1;
+                }
+            } else {
+                EXPECT_EQ(t.remove(ip, id.c_str()), ref.erase(key) == 1);
+            }
+            ASSERT_EQ(t.size(), ref.size());
+            for (auto& [k, v] : ref) {
+                ASSERT_NE(t.find(k.first, k.second.c_str(), 0), nullptr);
+            }
+        }
+    }
+}
@@ -0,0 +1,477 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Simulator.h - host-side simulation of the planner and step generation for a G-code job
+
+  Planner.cpp and Stepper.cpp are bound to the machine configuration and FreeRTOS, so the
+  simulator uses the parts of them that build on the host: the velocity planning passes
+  from PlannerRecalculate.h, run on a ring of blocks that are set up with the same
+  junction deviation and axis limit math as plan_buffer_line(), and the step_engine_t
+  interface, through a fake engine that records step events instead of driving pins.
+  Blocks are executed when the ring fills, the way the stepper drains it, as segments of
+  DT_SEGMENT traced with the Bresenham counters of Stepper::pulse_func().
+
+  The result is deterministic, so per-job statistics and step traces can be compared
+  across planner and prep changes without a machine.
+
+  The trace file is "FNCTRACE", the uint32_t timer frequency, then one record per step
+  event of uint64_t timer ticks, uint8_t step mask, uint8_t direction mask, little-endian.
+*/
+
+#include "Driver/step_engine.h"
+#include "src/PlannerRecalculate.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Simulator {
+    const int      n_axis     = 3;
+    const uint32_t timer_hz   = 20000000;             // Stepping::fStepperTimer
+    const double   dt_segment = 1.0 / (100.0 * 60.0);  // Segment time in minutes, as in Stepper.cpp
+
+    struct Axis {
+        float steps_per_mm = 80.0f;
+        float max_rate     = 5000.0f;  // mm/min
+        float acceleration = 200.0f;   // mm/sec^2
+    };
+
+    struct Machine {
+        Axis  axes[n_axis];
+        float junction_deviation = 0.01f;  // mm
+        int   planner_blocks     = 16;
+    };
+
+    struct Block {
+        // Used by Planner::recalculate()
+        float entry_speed_sqr;
+        float max_entry_speed_sqr;
+        float acceleration;  // mm/min^2
+        float millimeters;
+
+        float    max_junction_speed_sqr;
+        float    nominal_speed;
+        uint32_t steps[n_axis];
+        uint32_t step_event_count;
+        uint8_t  direction_bits;
+    };
+
+    struct TraceRecord {
+        uint64_t ticks;
+        uint8_t  step_mask;
+        uint8_t  dir_mask;
+    };
+
+    struct Stats {
+        uint64_t           total_ticks = 0;
+        uint64_t           events      = 0;
+        uint64_t           steps[n_axis] {};
+        uint64_t           min_interval[n_axis];  // Ticks between steps of an axis
+        uint64_t           max_interval[n_axis] {};
+        std::vector<float> junction_speeds;  // Entry speed of each block (mm/min)
+
+        Stats() {
+            for (int i = 0; i < n_axis; ++i) {
+                min_interval[i] = UINT64_MAX;
+            }
+        }
+        double total_seconds() const { return double(total_ticks) / timer_hz; }
+    };
+
+    // A step_engine_t that records the step and direction pins of each step event.  The
+    // engine is a C function table, so its state is static; one simulation runs at a time.
+    namespace FakeEngine {
+        inline uint64_t& now() {
+            static uint64_t t;
+            return t;
+        }
+        inline uint8_t& dir_mask() {
+            static uint8_t m;
+            return m;
+        }
+        inline uint8_t& step_mask() {
+            static uint8_t m;
+            return m;
+        }
+        inline uint32_t& period() {
+            static uint32_t p;
+            return p;
+        }
+        inline std::vector<TraceRecord>& trace() {
+            static std::vector<TraceRecord> t;
+            return t;
+        }
+
+        inline uint32_t init(uint32_t dir_delay_us, uint32_t pulse_delay_us, uint32_t frequency, bool (*fn)(void)) {
+            now()       = 0;
+            dir_mask()  = 0;
+            step_mask() = 0;
+            trace().clear();
+            return pulse_delay_us;
+        }
+        inline int  init_step_pin(int pin, int inverted) { return pin; }
+        inline void set_dir_pin(int pin, int level) {
+            if (level) {
+                dir_mask() |= 1 << pin;
+            } else {
+                dir_mask() &= ~(1 << pin);
+            }
+        }
+        inline void finish_dir() {}
+        inline void start_step() { step_mask() = 0; }
+        inline void set_step_pin(int pin, int level) {
+            if (level) {
+                step_mask() |= 1 << pin;
+            }
+        }
+        inline void finish_step() {
+            if (step_mask()) {
+                trace().push_back({ now(), step_mask(), dir_mask() });
+            }
+        }
+        inline int      start_unstep() { return 1; }
+        inline void     finish_unstep() {}
+        inline uint32_t max_pulses_per_sec() { return 250000; }
+        inline void     set_timer_ticks(uint32_t ticks) { period() = ticks; }
+        inline void     start_timer() {}
+        inline void     stop_timer() {}
+
+        inline step_engine_t* engine() {
+            // clang-format off
+            static step_engine_t e = {
+                "Fake",
+                init,
+                init_step_pin,
+                set_dir_pin,
+                finish_dir,
+                start_step,
+                set_step_pin,
+                finish_step,
+                start_unstep,
+                finish_unstep,
+                max_pulses_per_sec,
+                set_timer_ticks,
+                start_timer,
+                stop_timer,
+                nullptr
+            };
+            // clang-format on
+            return &e;
+        }
+    }
+
+    // Position along a trapezoidal profile, as prep_buffer() computes it from the block.
+    struct Trapezoid {
+        double v0, v1, vp, accel;           // mm/min, mm/min^2
+        double t_accel, t_cruise, t_decel;  // min
+
+        Trapezoid(double entry, double exit, double nominal, double a, double mm) : v0(entry), v1(exit), vp(nominal), accel(a) {
+            double d_accel = (vp * vp - v0 * v0) / (2 * a);
+            double d_decel = (vp * vp - v1 * v1) / (2 * a);
+            if (d_accel + d_decel > mm) {
+                // No cruise; accelerate to the intersection of the ramps
+                vp      = std::sqrt(std::fmax(0.0, (2 * a * mm + v0 * v0 + v1 * v1) / 2));
+                d_accel = (vp * vp - v0 * v0) / (2 * a);
+                d_decel = mm - d_accel;
+            }
+            vp       = std::fmax(vp, std::fmax(v0, v1));
+            t_accel  = (vp - v0) / a;
+            t_decel  = (vp - v1) / a;
+            t_cruise = vp > 0 ? std::fmax(0.0, mm - d_accel - d_decel) / vp : 0.0;
+        }
+        double duration() const { return t_accel + t_cruise + t_decel; }
+        double position(double t) const {
+            if (t <= t_accel) {
+                return v0 * t + 0.5 * accel * t * t;
+            }
+            double s = v0 * t_accel + 0.5 * accel * t_accel * t_accel;
+            t -= t_accel;
+            if (t <= t_cruise) {
+                return s + vp * t;
+            }
+            s += vp * t_cruise;
+            t = std::fmin(t - t_cruise, t_decel);
+            return s + vp * t - 0.5 * accel * t * t;
+        }
+    };
+
+    class Simulation {
+        Machine            _machine;
+        std::vector<Block> _ring;
+        size_t             _tail = 0, _head = 0, _planned = 0;
+        int32_t            _position[n_axis] {};  // Planner position in steps
+        float              _previous_unit_vec[n_axis] {};
+        float              _previous_nominal_speed = 0.0f;
+        step_engine_t*     _engine;
+        Stats              _stats;
+        uint64_t           _last_step[n_axis] {};
+        bool               _stepped[n_axis] {};
+
+        // Modal state of gcode_line()
+        float _target[n_axis] {};
+        float _feed  = 1000.0f;
+        bool  _rapid = false;
+
+        size_t next(size_t i) const { return ++i == _ring.size() ? 0 : i; }
+
+        void recalculate() { Planner::recalculate(_ring.data(), _ring.size(), _tail, _head, _planned, true, [] {}); }
+
+        void record_steps(uint8_t mask, uint64_t ticks) {
+            ++_stats.events;
+            for (int axis = 0; axis < n_axis; ++axis) {
+                if (mask & (1 << axis)) {
+                    ++_stats.steps[axis];
+                    if (_stepped[axis]) {
+                        uint64_t interval = ticks - _last_step[axis];
+                        if (interval < _stats.min_interval[axis]) {
+                            _stats.min_interval[axis] = interval;
+                        }
+                        if (interval > _stats.max_interval[axis]) {
+                            _stats.max_interval[axis] = interval;
+                        }
+                    }
+                    _stepped[axis]   = true;
+                    _last_step[axis] = ticks;
+                }
+            }
+        }
+
+        // Executes the block at the tail, then discards it.
+        void execute_tail() {
+            Block& block = _ring[_tail];
+            size_t n     = next(_tail);
+            float  exit  = n == _head ? 0.0f : _ring[n].entry_speed_sqr;
+            _stats.junction_speeds.push_back(std::sqrt(block.entry_speed_sqr));
+
+            Trapezoid profile(std::sqrt(block.entry_speed_sqr), std::sqrt(exit), block.nominal_speed, block.acceleration, block.millimeters);
+            double    duration = profile.duration();
+            double    per_mm   = block.step_event_count / block.millimeters;
+
+            for (int axis = 0; axis < n_axis; ++axis) {
+                _engine->set_dir_pin(axis, (block.direction_bits >> axis) & 1);
+            }
+            _engine->finish_dir();
+
+            uint32_t counter[n_axis];
+            for (int axis = 0; axis < n_axis; ++axis) {
+                counter[axis] = block.step_event_count >> 1;
+            }
+            uint64_t& now        = FakeEngine::now();
+            uint32_t  steps_done = 0;
+            double    t          = 0.0;
+            double    position   = 0.0;  // Fractional step position at t
+            while (steps_done < block.step_event_count) {
+                // Like prep_buffer(), time each segment's steps at its average rate over
+                // fractional steps, so whole-step rounding does not make the rate jitter.
+                double t_next   = std::fmin(t + dt_segment, duration);
+                double seg_time = t_next - t;
+                double next_pos = t_next >= duration ? double(block.step_event_count) : profile.position(t_next) * per_mm;
+                t               = t_next;
+                if (next_pos <= position) {
+                    continue;
+                }
+                uint32_t target = std::fmin(std::floor(next_pos), double(block.step_event_count));
+                _engine->set_timer_ticks(uint32_t(seg_time * 60.0 * timer_hz / (next_pos - position)));
+                position        = next_pos;
+                uint32_t n_step = target - steps_done;
+                for (uint32_t i = 0; i < n_step; ++i) {
+                    _engine->start_step();
+                    for (int axis = 0; axis < n_axis; ++axis) {
+                        counter[axis] += block.steps[axis];
+                        if (counter[axis] > block.step_event_count) {
+                            counter[axis] -= block.step_event_count;
+                            _engine->set_step_pin(axis, 1);
+                        }
+                    }
+                    _engine->finish_step();
+                    record_steps(FakeEngine::step_mask(), now);
+                    now += FakeEngine::period();
+                }
+                steps_done = target;
+            }
+            _stats.total_ticks = now;
+
+            if (_tail == _planned) {
+                _planned = n;
+            }
+            _tail = n;
+        }
+
+    public:
+        explicit Simulation(const Machine& machine = Machine()) : _machine(machine), _ring(machine.planner_blocks) {
+            _engine = FakeEngine::engine();
+            _engine->init(0, 4, timer_hz, nullptr);
+        }
+
+        // Plans a line to target (mm) at feed_rate (mm/min), or at the rapid rate when
+        // rapid is set, as plan_buffer_line() does.
+        void line(const float* target, float feed_rate, bool rapid) {
+            Block   block {};
+            int32_t target_steps[n_axis];
+            float   unit_vec[n_axis];
+            for (int axis = 0; axis < n_axis; ++axis) {
+                target_steps[axis] = int32_t(std::lround(target[axis] * _machine.axes[axis].steps_per_mm));
+                int32_t delta      = target_steps[axis] - _position[axis];
+                block.steps[axis]  = uint32_t(std::abs(delta));
+                if (block.steps[axis] > block.step_event_count) {
+                    block.step_event_count = block.steps[axis];
+                }
+                unit_vec[axis] = delta / _machine.axes[axis].steps_per_mm;
+                if (delta < 0) {
+                    block.direction_bits |= 1 << axis;
+                }
+            }
+            if (block.step_event_count == 0) {
+                return;
+            }
+            float mm = 0.0f;
+            for (int axis = 0; axis < n_axis; ++axis) {
+                mm += unit_vec[axis] * unit_vec[axis];
+            }
+            block.millimeters = std::sqrt(mm);
+            float accel = 1e38f, rate = 1e38f;
+            for (int axis = 0; axis < n_axis; ++axis) {
+                unit_vec[axis] /= block.millimeters;
+                if (unit_vec[axis] != 0) {
+                    accel = std::fmin(accel, std::fabs(_machine.axes[axis].acceleration / unit_vec[axis]));
+                    rate  = std::fmin(rate, std::fabs(_machine.axes[axis].max_rate / unit_vec[axis]));
+                }
+            }
+            block.acceleration  = accel * 60 * 60;
+            block.nominal_speed = rapid ? rate : std::fmin(feed_rate, rate);
+
+            if (next(_head) == _tail) {
+                execute_tail();
+            }
+            if (_head == _tail) {
+                block.max_junction_speed_sqr = 0.0f;
+            } else {
+                float junction_cos_theta = 0.0f;
+                float junction_unit_vec[n_axis];
+                for (int axis = 0; axis < n_axis; ++axis) {
+                    junction_cos_theta -= _previous_unit_vec[axis] * unit_vec[axis];
+                    junction_unit_vec[axis] = unit_vec[axis] - _previous_unit_vec[axis];
+                }
+                if (junction_cos_theta > 0.999999f) {
+                    block.max_junction_speed_sqr = 0.0f;
+                } else if (junction_cos_theta < -0.999999f) {
+                    block.max_junction_speed_sqr = 1e38f;
+                } else {
+                    float len = 0.0f;
+                    for (int axis = 0; axis < n_axis; ++axis) {
+                        len += junction_unit_vec[axis] * junction_unit_vec[axis];
+                    }
+                    len                  = std::sqrt(len);
+                    float junction_accel = 1e38f;
+                    for (int axis = 0; axis < n_axis; ++axis) {
+                        if (junction_unit_vec[axis] != 0) {
+                            junction_accel = std::fmin(junction_accel, std::fabs(_machine.axes[axis].acceleration * len / junction_unit_vec[axis]));
+                        }
+                    }
+                    junction_accel *= 60 * 60;
+                    float sin_theta_d2           = std::sqrt(0.5f * (1.0f - junction_cos_theta));
+                    block.max_junction_speed_sqr = (junction_accel * _machine.junction_deviation * sin_theta_d2) / (1.0f - sin_theta_d2);
+                }
+            }
+            float limit               = std::fmin(block.nominal_speed, _previous_nominal_speed);
+            block.max_entry_speed_sqr = std::fmin(limit * limit, block.max_junction_speed_sqr);
+
+            _ring[_head]            = block;
+            _head                   = next(_head);
+            _previous_nominal_speed = block.nominal_speed;
+            std::memcpy(_previous_unit_vec, unit_vec, sizeof(unit_vec));
+            std::memcpy(_position, target_steps, sizeof(target_steps));
+            recalculate();
+        }
+
+        // Executes the remaining blocks, as at the end of a job.
+        void finish() {
+            while (_tail != _head) {
+                execute_tail();
+            }
+        }
+
+        // Runs G0/G1 lines with absolute X, Y, Z and F words.  Comments and other words are
+        // ignored, as are lines with other motion modes; this is for planner benchmarking,
+        // not G-code coverage.
+        void gcode_line(const std::string& text) {
+            bool motion = false;
+            bool skip   = false;
+            for (size_t i = 0; i < text.size(); ++i) {
+                char c = char(toupper(text[i]));
+                if (c == '(' || c == ';') {
+                    break;
+                }
+                if (!isalpha(c)) {
+                    continue;
+                }
+                char* end;
+                float value = std::strtof(text.c_str() + i + 1, &end);
+                i           = end - text.c_str() - 1;
+                switch (c) {
+                    case 'G':
+                        if (value == 0 || value == 1) {
+                            _rapid = value == 0;
+                        } else if (value == 2 || value == 3) {
+                            skip = true;
+                        }
+                        break;
+                    case 'X':
+                    case 'Y':
+                    case 'Z':
+                        _target[c - 'X'] = value;
+                        motion           = true;
+                        break;
+                    case 'F':
+                        _feed = value;
+                        break;
+                }
+            }
+            if (motion && !skip) {
+                line(_target, _feed, _rapid);
+            }
+        }
+
+        bool run_file(const char* path) {
+            FILE* f = std::fopen(path, "r");
+            if (!f) {
+                return false;
+            }
+            char buf[256];
+            while (std::fgets(buf, sizeof(buf), f)) {
+                gcode_line(buf);
+            }
+            std::fclose(f);
+            finish();
+            return true;
+        }
+
+        const Stats&                    stats() const { return _stats; }
+        const std::vector<TraceRecord>& trace() const { return FakeEngine::trace(); }
+
+        bool write_trace(const char* path) const {
+            FILE* f = std::fopen(path, "wb");
+            if (!f) {
+                return false;
+            }
+            std::fwrite("FNCTRACE", 1, 8, f);
+            uint32_t hz = timer_hz;
+            std::fwrite(&hz, sizeof(hz), 1, f);
+            for (auto& r : trace()) {
+                std::fwrite(&r.ticks, sizeof(r.ticks), 1, f);
+                std::fwrite(&r.step_mask, 1, 1, f);
+                std::fwrite(&r.dir_mask, 1, 1, f);
+            }
+            std::fclose(f);
+            return true;
+        }
+    };
+}
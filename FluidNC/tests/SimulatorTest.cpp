@@ -0,0 +1,104 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "Simulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    const double ticks_per_sec = Simulator::timer_hz;
+}
+
+TEST(Simulator, StraightLineTime) {
+    Simulator::Simulation sim;
+    // 100 mm at 50 mm/sec with 200 mm/sec^2: 0.25 sec ramps of 6.25 mm and 87.5 mm of cruise
+    sim.gcode_line("G1 X100 F3000");
+    sim.finish();
+    auto& stats = sim.stats();
+    EXPECT_EQ(stats.steps[0], 8000u);
+    EXPECT_EQ(stats.steps[1], 0u);
+    EXPECT_NEAR(stats.total_seconds(), 2.25, 0.02);
+    // At 50 mm/sec and 80 steps/mm, steps are 250 us apart
+    EXPECT_GE(stats.min_interval[0], uint64_t(250e-6 * ticks_per_sec * 0.99));
+}
+
+TEST(Simulator, SquareCornersAreJunctionLimited) {
+    Simulator::Simulation sim;
+    for (auto line : { "G1 X20 F3000", "Y20", "X0", "Y0" }) {
+        sim.gcode_line(line);
+    }
+    sim.finish();
+    auto& stats = sim.stats();
+    ASSERT_EQ(stats.junction_speeds.size(), 4u);
+    EXPECT_EQ(stats.junction_speeds[0], 0.0f);
+    // 90 degree corners at 0.01 mm deviation and 200*sqrt(2) mm/sec^2 junction acceleration
+    float sin_theta_d2 = std::sqrt(0.5f);
+    float limit        = std::sqrt(200.0f * float(M_SQRT2) * 3600 * 0.01f * sin_theta_d2 / (1 - sin_theta_d2));
+    for (size_t i = 1; i < 4; ++i) {
+        EXPECT_GT(stats.junction_speeds[i], 0.0f);
+        EXPECT_LE(stats.junction_speeds[i], limit * 1.001f);
+    }
+    // The tool returns to the start: every step has a matching step the other way
+    int32_t position[Simulator::n_axis] = {};
+    for (auto& r : sim.trace()) {
+        for (int axis = 0; axis < Simulator::n_axis; ++axis) {
+            if (r.step_mask & (1 << axis)) {
+                position[axis] += (r.dir_mask & (1 << axis)) ? -1 : 1;
+            }
+        }
+    }
+    EXPECT_EQ(position[0], 0);
+    EXPECT_EQ(position[1], 0);
+}
+
+TEST(Simulator, TraceIsMonotonic) {
+    Simulator::Simulation sim;
+    for (int i = 1; i <= 200; ++i) {
+        char line[64];
+        snprintf(line, sizeof(line), "G1 X%.3f Y%.3f F2400", 10 * std::cos(i * 0.05), 10 * std::sin(i * 0.05));
+        sim.gcode_line(line);
+    }
+    sim.finish();
+    uint64_t last = 0;
+    for (auto& r : sim.trace()) {
+        ASSERT_GE(r.ticks, last);
+        last = r.ticks;
+    }
+    EXPECT_EQ(sim.stats().junction_speeds.size(), 200u);
+}
+
+// Runs the G-code file in FLUIDNC_SIM_GCODE, if set, and reports the job statistics.  The
+// step trace is written to FLUIDNC_SIM_TRACE if that is set.
+TEST(Simulator, Job) {
+    const char* gcode = std::getenv("FLUIDNC_SIM_GCODE");
+    if (!gcode) {
+        GTEST_SKIP() << "FLUIDNC_SIM_GCODE is not set";
+    }
+    Simulator::Simulation sim;
+    ASSERT_TRUE(sim.run_file(gcode)) << "Cannot open " << gcode;
+    auto& stats = sim.stats();
+    printf("[ SIM      ] %s: %.3f s, %llu step events, %zu blocks\n",
+           gcode,
+           stats.total_seconds(),
+           (unsigned long long)stats.events,
+           stats.junction_speeds.size());
+    for (int axis = 0; axis < Simulator::n_axis; ++axis) {
+        if (stats.steps[axis] > 1) {
+            printf("[ SIM      ] %c: %llu steps, step interval min %.2f us max %.2f us\n",
+                   "XYZ"[axis],
+                   (unsigned long long)stats.steps[axis],
+                   stats.min_interval[axis] * 1e6 / ticks_per_sec,
+                   stats.max_interval[axis] * 1e6 / ticks_per_sec);
+        }
+    }
+    float max_junction = 0.0f;
+    for (float v : stats.junction_speeds) {
+        max_junction = std::fmax(max_junction, v);
+    }
+    printf("[ SIM      ] max junction speed %.1f mm/min\n", max_junction);
+    if (const char* trace = std::getenv("FLUIDNC_SIM_TRACE")) {
+        EXPECT_TRUE(sim.write_trace(trace));
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/SyncFrame.h"
+
+using namespace SyncLink;
+
+static bool feed(FrameParser& parser, const uint8_t* data, size_t length) {
+    bool complete = false;
+    for (size_t i = 0; i < length; i++) {
+        complete = parser.push(data[i]);
+    }
+    return complete;
+}
+
+TEST(SyncFrame, RoundTrip) {
+    FrameWriter w(Segment);
+    size_t      length = w.u16(0x1234).u16(7).u16(40000).u8(2).finish();
+    EXPECT_EQ(length, 4u + 7u);
+
+    FrameParser parser;
+    ASSERT_TRUE(feed(parser, w.data(), length));
+    EXPECT_EQ(parser.type(), Segment);
+    auto r = parser.payload();
+    EXPECT_EQ(r.u16(), 0x1234);
+    EXPECT_EQ(r.u16(), 7);
+    EXPECT_EQ(r.u16(), 40000);
+    EXPECT_EQ(r.u8(), 2);
+    EXPECT_FALSE(r.ok(1));
+    EXPECT_EQ(parser.errors(), 0u);
+}
+
+TEST(SyncFrame, ResynchronizesAfterCorruption) {
+    FrameWriter a(Start);
+    size_t      alen = a.u32(0xdeadbeef).finish();
+    FrameWriter b(Ping);
+    size_t      blen = b.u32(42).finish();
+
+    uint8_t stream[2 * maxFrame + 3] = { 0x00, 0x17 };  // Noise before the first frame
+    size_t  n                        = 2;
+    memcpy(stream + n, a.data(), alen);
+    stream[n + 4] ^= 0x40;  // Corrupt the payload
+    n += alen;
+    memcpy(stream + n, b.data(), blen);
+    n += blen;
+
+    FrameParser parser;
+    int         frames = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (parser.push(stream[i])) {
+            ++frames;
+            EXPECT_EQ(parser.type(), Ping);
+            EXPECT_EQ(parser.payload().u32(), 42u);
+        }
+    }
+    EXPECT_EQ(frames, 1);
+    EXPECT_EQ(parser.errors(), 1u);
+}
+
+TEST(SyncFrame, ClockSyncFindsOffsetAndRate) {
+    // The leader runs 50 ppm fast and 1 s ahead; round trips take 300 to 2000 us
+    ClockSync sync;
+    auto      leader = [](double local) { return uint32_t(int64_t(1000000 + local * (1 + 50e-6))); };
+    double    local  = 4294000000.0;  // Wraps during the test
+    for (int i = 0; i < 200; i++) {
+        double   rtt  = 300 + (i * 7919 % 1700);
+        uint32_t sent = uint32_t(int64_t(local));
+        uint32_t at   = leader(local + rtt / 2);
+        sync.pong(sent, at, uint32_t(int64_t(local + rtt)));
+        local += 250000;
+    }
+    ASSERT_TRUE(sync.valid());
+    EXPECT_NEAR(sync.ppm(), 50.0, 2.0);
+
+    uint32_t expected = uint32_t(int64_t(local));
+    EXPECT_NEAR(double(int32_t(sync.to_local(leader(local)) - expected)), 0.0, 200.0);
+}
+
+TEST(SyncFrame, PeriodScalerKeepsTotalTime) {
+    PeriodScaler scaler;
+    double       leaderTicks = 0, localTicks = 0;
+    const float  rate        = 30e-6f;
+    for (int i = 0; i < 10000; i++) {
+        uint16_t n_step = uint16_t(1 + i % 37);
+        uint16_t period = uint16_t(1000 + (i * 13) % 50000);
+        leaderTicks += double(n_step) * period;
+        localTicks += double(n_step) * scaler.scale(n_step, period, rate);
+    }
+    EXPECT_NEAR(localTicks, leaderTicks / (1 + rate), 100.0);  // Of about 10^10 ticks
+}
+
+TEST(SyncFrame, PeriodScalerWorksOffCorrectionGradually) {
+    PeriodScaler scaler;
+    scaler.correct(-5000);  // Started 5000 ticks late
+    EXPECT_EQ(scaler.scale(10, 1000, 0), 950);  // At most 5% of a segment
+    EXPECT_NEAR(scaler.pending(), -4500, 1);
+    for (int i = 0; i < 20; i++) {
+        scaler.scale(10, 1000, 0);
+    }
+    EXPECT_NEAR(scaler.pending(), 0, 1);
+    EXPECT_EQ(scaler.scale(10, 1000, 0), 1000);
+}
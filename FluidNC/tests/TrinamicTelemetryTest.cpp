@@ -0,0 +1,51 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/Motors/TrinamicTelemetry.h"
+
+using namespace MotorDrivers;
+
+TEST(TrinamicTelemetry, SampleRing) {
+    SampleRing<4>   ring;
+    TelemetrySample s;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.pop(s));
+
+    for (uint32_t i = 0; i < 6; ++i) {
+        ring.push({ i, 100.0f, uint16_t(i * 10), 16, 0 });
+    }
+    EXPECT_EQ(ring.size(), 4u);
+    EXPECT_EQ(ring.dropped(), 2u);  // The newest ones
+
+    ASSERT_TRUE(ring.pop(s));
+    EXPECT_EQ(s.time_us, 0u);
+    ring.push({ 9, 0.0f, 90, 0, 1 });  // Wraps
+    for (uint32_t expected : { 1u, 2u, 3u, 9u }) {
+        ASSERT_TRUE(ring.pop(s));
+        EXPECT_EQ(s.time_us, expected);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(TrinamicTelemetry, LoadLimiter) {
+    LoadLimiter limiter;
+    EXPECT_EQ(limiter.update(300, 0, 10), 100);  // No limit
+    limiter.reset();
+    EXPECT_EQ(limiter.update(300, 200, 10), 100);  // Light load
+
+    // The filtered value falls toward 100, half the limit
+    int last = 100;
+    for (int i = 0; i < 50; ++i) {
+        int percent = limiter.update(100, 200, 10);
+        EXPECT_LE(percent, last);
+        last = percent;
+    }
+    EXPECT_EQ(last, 50);
+
+    EXPECT_EQ(limiter.update(0, 200, 10), 40);  // 100 + 0.2 * (0 - 100) = 80
+    for (int i = 0; i < 50; ++i) {
+        last = limiter.update(0, 200, 10);
+    }
+    EXPECT_EQ(last, 10);  // Held at the minimum
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 -  FluidNC contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/Kinematics/Workspace.h"
+
+using namespace Kinematics;
+
+namespace {
+    // A cylinder of radius 50 from z -100 to 0, with a sloped cut across +X
+    void shape(Workspace& w) {
+        float lo[3] = { -HUGE_VALF, -HUGE_VALF, -100.0f };
+        float hi[3] = { HUGE_VALF, HUGE_VALF, 0.0f };
+        w.set_box(lo, hi);
+        w.set_cylinder(0.0f, 0.0f, 50.0f);
+        ASSERT_TRUE(w.add_plane(1.0f, 0.0f, 1.0f, 0.0f));  // x + z <= 0
+        EXPECT_FALSE(w.add_plane(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+}
+
+TEST(Workspace, Contains) {
+    Workspace w;
+    float     anywhere[3] = { 1e6f, -1e6f, 3.0f };
+    EXPECT_TRUE(w.contains(anywhere));  // Unlimited by default
+
+    shape(w);
+    float inside[3]  = { 10.0f, 10.0f, -50.0f };
+    float below[3]   = { 0.0f, 0.0f, -101.0f };
+    float outside[3] = { 40.0f, 40.0f, -50.0f };  // Beyond the radius
+    float cut[3]     = { 30.0f, 0.0f, -20.0f };   // Beyond the plane
+    EXPECT_TRUE(w.contains(inside));
+    EXPECT_FALSE(w.contains(below));
+    EXPECT_FALSE(w.contains(outside));
+    EXPECT_FALSE(w.contains(cut));
+}
+
+TEST(Workspace, Clip) {
+    Workspace w;
+    shape(w);
+    float start[3] = { 0.0f, 0.0f, -50.0f };
+
+    float inside[3] = { -20.0f, 10.0f, -80.0f };
+    EXPECT_FLOAT_EQ(w.clip(start, inside), 1.0f);
+
+    float radial[3] = { -100.0f, 0.0f, -50.0f };  // Leaves the cylinder at x = -50
+    EXPECT_NEAR(w.clip(start, radial), 0.5f, 1e-5);
+
+    float down[3] = { 0.0f, 0.0f, -150.0f };  // Leaves the box at z = -100
+    EXPECT_NEAR(w.clip(start, down), 0.5f, 1e-5);
+
+    float across[3] = { 100.0f, 0.0f, -50.0f };  // Meets the cylinder and the plane at x = 50
+    EXPECT_NEAR(w.clip(start, across), 0.5f, 1e-5);
+
+    float up[3] = { 40.0f, 0.0f, -10.0f };  // Meets x + z = 0 at x = 25
+    EXPECT_NEAR(w.clip(start, up), 0.625f, 1e-5);
+
+    // From outside, only moves that end inside are allowed
+    float out[3] = { 0.0f, 0.0f, -120.0f };
+    EXPECT_FLOAT_EQ(w.clip(out, start), 1.0f);
+    EXPECT_FLOAT_EQ(w.clip(out, down), 0.0f);
+}
+
+TEST(Workspace, Arc) {
+    Workspace w;
+    shape(w);
+    size_t xy[3]     = { 0, 1, 2 };
+    float  center[2] = { -10.0f, 0.0f };
+    EXPECT_TRUE(w.contains_arc(center, 20.0f, -60.0f, -40.0f, xy));
+    EXPECT_FALSE(w.contains_arc(center, 45.0f, -60.0f, -40.0f, xy));
+    EXPECT_FALSE(w.contains_arc(center, 20.0f, -110.0f, -40.0f, xy));
+}
@@ -5,6 +5,11 @@ int main(int argc, char** argv) {
     // if you plan to use GMock, replace the line above with
     // ::testing::InitGoogleMock(&argc, argv);
 
+#ifdef BENCHMARK
+    // The bench environment runs only the benchmarks; see tests/Bench.h
+    ::testing::GTEST_FLAG(filter) = "*Benchmark";
+#endif
+
     if (RUN_ALL_TESTS()) {}
 
     // Always return zero-code and allow PlatformIO to parse results
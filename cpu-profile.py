@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# Summarizes a CPU profile captured with $CPU/Profile=ON ... $CPU/Profile=OFF.
+#
+# Save the output of $CPU/Profile=OFF to a file, from FluidTerm or the WebUI
+# console, then run
+#   python cpu-profile.py capture.txt [.pio/build/wifi/firmware.elf]
+# The ELF file must come from the same build as the running firmware.  The
+# addresses are looked up with xtensa-esp32-elf-addr2line, which PlatformIO
+# installs with the ESP32 toolchain; set ADDR2LINE if it is not on the PATH.
+
+import collections
+import os
+import re
+import subprocess
+import sys
+
+sample_re = re.compile(r'PC:(\d),([^,]*),([0-9a-fA-F]{8})')
+
+
+def read_samples(path):
+    samples = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = sample_re.search(line)
+            if m:
+                samples.append((int(m.group(1)), m.group(2), int(m.group(3), 16)))
+    return samples
+
+
+def symbolize(elf, addresses):
+    addr2line = os.environ.get('ADDR2LINE', 'xtensa-esp32-elf-addr2line')
+    addresses = sorted(addresses)
+    args = [addr2line, '-f', '-C', '-e', elf] + ['%08x' % a for a in addresses]
+    output = subprocess.run(args, capture_output=True, text=True, check=True).stdout.splitlines()
+    # Two lines per address: the function, then file:line
+    return {a: output[2 * i] for i, a in enumerate(addresses)}
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit('usage: cpu-profile.py capture.txt [firmware.elf]')
+    elf = sys.argv[2] if len(sys.argv) > 2 else '.pio/build/wifi/firmware.elf'
+    samples = read_samples(sys.argv[1])
+    if not samples:
+        sys.exit('No PC: lines in ' + sys.argv[1])
+
+    names = symbolize(elf, {pc for _, _, pc in samples if pc})
+    for core in (0, 1):
+        on_core = [(task, pc) for c, task, pc in samples if c == core]
+        if not on_core:
+            continue
+        print('Core %d: %d samples' % (core, len(on_core)))
+        functions = collections.Counter((task, names.get(pc, '??')) for task, pc in on_core)
+        for (task, function), count in functions.most_common(25):
+            print('  %5.1f%%  %-16s %s' % (100.0 * count / len(on_core), task, function))
+        print()
+
+
+if __name__ == '__main__':
+    main()
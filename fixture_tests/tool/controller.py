@@ -7,6 +7,7 @@ class Controller:
         self._debug = False
         self._serial = serial.Serial(device, baudrate, timeout=timeout)
         self._current_line = None
+        self._pending = b""
 
     def send_soft_reset(self):
         self._serial.write(b"\x18")
@@ -34,6 +35,12 @@ class Controller:
         # print(colored("[c] -> " + line, "light_blue"))
         self._serial.write(line.encode("utf-8") + b"\n")
 
+    def available_lines(self):
+        # Returns the complete lines received so far without waiting for more
+        self._pending += self._serial.read(self._serial.in_waiting)
+        *lines, self._pending = self._pending.split(b"\n")
+        return [line.decode("utf-8").strip() for line in lines]
+
     def getc(self, size):
         return self._serial.read(size) or None
 
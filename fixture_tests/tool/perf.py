@@ -0,0 +1,144 @@
+import json
+import re
+import time
+
+from tool.utils import color
+
+# The controller's serial receive buffer, for character-counting flow control.
+# Keeping fewer bytes outstanding than this means the controller never has to
+# drop characters, and more than one line is always waiting to be parsed.
+RX_BUFFER_SIZE = 127
+
+# How often a realtime ? is sent to sample the buffer levels
+STATUS_INTERVAL = 0.1
+
+BF_RE = re.compile(r"\|Bf:(\d+),(\d+)")
+STATE_RE = re.compile(r"^<(\w+)")
+
+# Metrics recorded for each job, whether a larger value is better, and the unit
+METRICS = {
+    "job_seconds": (False, "s"),
+    "lines_per_second": (True, "lines/s"),
+    "acks_per_second": (True, "acks/s"),
+    "planner_free_mean": (False, "blocks"),
+    "planner_starved_pct": (False, "%"),
+}
+
+
+class StreamError(Exception):
+    pass
+
+
+def stream_job(controller, lines, rx_buffer_size=RX_BUFFER_SIZE):
+    """Streams lines with character-counting flow control and returns the measurements.
+
+    A line is sent as soon as the bytes of the lines not yet acknowledged leave
+    room for it, which is how fast senders keep the planner full.  The job ends
+    when every line has been acknowledged and the machine is idle again.
+    """
+    controller.send_line("$Report/Status=3")  # MPos and Bf:, counting bytes
+    controller.drain(wait_for=0.5)
+
+    outstanding = []  # lengths of lines sent but not yet acknowledged
+    next_line = 0
+    acks = 0
+    errors = []
+    samples = []  # planner free blocks from each status report
+    state = None
+
+    start = time.monotonic()
+    next_status = start
+    last_ack = start
+    while True:
+        now = time.monotonic()
+
+        while next_line < len(lines):
+            length = len(lines[next_line]) + 1
+            if sum(outstanding) + length > rx_buffer_size:
+                break
+            controller.send_line(lines[next_line])
+            outstanding.append(length)
+            next_line += 1
+
+        if now >= next_status:
+            controller.putc(b"?")
+            next_status = now + STATUS_INTERVAL
+
+        for response in controller.available_lines():
+            if response == "ok" or response.startswith("error:"):
+                if not outstanding:
+                    raise StreamError(f"Unexpected acknowledgement: {response}")
+                if response != "ok":
+                    errors.append(f"{lines[next_line - len(outstanding)]}: {response}")
+                outstanding.pop(0)
+                acks += 1
+                last_ack = now
+                state = None  # wait for a report sent after this
+            elif response.startswith("<"):
+                matcher = BF_RE.search(response)
+                if matcher and next_line < len(lines):
+                    # Only while sending, so the idle tail does not count as starving
+                    samples.append(int(matcher.group(1)))
+                matcher = STATE_RE.match(response)
+                if matcher:
+                    state = matcher.group(1)
+            elif response.startswith("ALARM:"):
+                raise StreamError(f"Controller raised {response}")
+
+        if next_line == len(lines) and not outstanding and state == "Idle":
+            break
+        if outstanding and now - last_ack > 10:
+            raise StreamError(f"No acknowledgement for 10 seconds after line {next_line - len(outstanding) + 1}")
+
+        time.sleep(0.001)
+
+    elapsed = time.monotonic() - start
+    planner_size = max(samples) if samples else 0
+    return {
+        "lines": len(lines),
+        "bytes": sum(len(line) + 1 for line in lines),
+        "errors": errors,
+        "job_seconds": round(elapsed, 3),
+        "lines_per_second": round(len(lines) / elapsed, 1),
+        "acks_per_second": round(acks / elapsed, 1),
+        "planner_free_mean": round(sum(samples) / len(samples), 2) if samples else 0,
+        "planner_free_max": planner_size,
+        # A free count at its maximum means the planner ran dry
+        "planner_starved_pct": round(100 * sum(1 for s in samples if s == planner_size) / len(samples), 1) if samples else 0,
+    }
+
+
+def load_baselines(path):
+    try:
+        with open(path, "r") as f:
+            return json.load(f)
+    except FileNotFoundError:
+        return {}
+
+
+def save_baselines(path, baselines):
+    with open(path, "w") as f:
+        json.dump(baselines, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+
+def compare(result, baseline, tolerance_pct):
+    """Prints each metric against its baseline and returns the names of those that regressed."""
+    regressions = []
+    for metric, (higher_is_better, unit) in METRICS.items():
+        value = result[metric]
+        if metric not in baseline:
+            print(f"  {metric:22} {value:>10} {unit:8} " + color.dark_grey("(no baseline)"))
+            continue
+        expected = baseline[metric]
+        # Absolute slack of 1 so that metrics near zero do not fail on noise
+        slack = max(abs(expected) * tolerance_pct / 100, 1 if not higher_is_better else 0)
+        worse = value < expected - slack if higher_is_better else value > expected + slack
+        change = f"{(value - expected) / expected * 100:+.1f}%" if expected else ""
+        text = f"  {metric:22} {value:>10} {unit:8} baseline {expected:>10} {change}"
+        if worse:
+            regressions.append(metric)
+            print(color.error(text + " REGRESSED"))
+        else:
+            print(color.green(text))
+    return regressions
@@ -0,0 +1,82 @@
+import math
+
+# Benchmark jobs for run_perf.  Each generator returns a list of GCode lines.
+# They are generated rather than stored so that the jobs are identical on every
+# run and can be made as large as needed; the sizes are chosen so that every
+# job runs for tens of seconds, long enough for the planner to stay full.
+#
+# All motion stays within 50mm of the origin, in the positive quadrant, so the
+# jobs can run on any machine with that much travel.
+
+
+def _header(feed):
+    return ["G21", "G90", "G17", "G94", f"F{feed}", "G0 X0 Y0 Z0"]
+
+
+def _footer():
+    return ["G0 X0 Y0 Z0"]
+
+
+def dense_3d(points=8000):
+    # Many very short segments with small direction changes, as in a 3D
+    # finishing pass from CAM.  This is the case that starves the planner.
+    lines = _header(3000)
+    for i in range(points):
+        t = i / points
+        x = 25 + 20 * math.cos(t * 40 * math.pi) * (1 - t)
+        y = 25 + 20 * math.sin(t * 40 * math.pi) * (1 - t)
+        z = -1 + 0.5 * math.sin(t * 200 * math.pi)
+        lines.append(f"G1 X{x:.4f} Y{y:.4f} Z{z:.4f}")
+    return lines + _footer()
+
+
+def raster(rows=200, columns=100):
+    # Back and forth rows with the laser power changing at every step, as in
+    # image engraving.  Every line carries an S word.
+    lines = _header(6000) + ["M4 S0"]
+    step = 0.25
+    for row in range(rows):
+        y = row * step
+        start = 0 if row % 2 == 0 else columns * step
+        lines.append(f"G0 X{start:.3f} Y{y:.3f}")
+        order = range(columns) if row % 2 == 0 else range(columns - 1, -1, -1)
+        for col in order:
+            x = (col + 1) * step if row % 2 == 0 else col * step
+            power = int(500 + 500 * math.sin(row * 0.1) * math.cos(col * 0.1))
+            lines.append(f"G1 X{x:.3f} S{power}")
+    return lines + ["M5"] + _footer()
+
+
+def arcs(count=2000):
+    # Alternating G2 and G3 arcs of varying radius, which exercise the arc
+    # segmentation in the parser as well as the planner.
+    lines = _header(2000)
+    x, y = 10.0, 25.0
+    lines.append(f"G0 X{x:.3f} Y{y:.3f}")
+    for i in range(count):
+        r = 1 + (i % 5) * 0.5
+        direction = "G2" if i % 2 == 0 else "G3"
+        dx = r if x < 40 else -r
+        lines.append(f"{direction} X{x + dx:.3f} Y{y:.3f} I{dx / 2:.3f} J0")
+        x += dx
+    return lines + _footer()
+
+
+def parametric(loops=40, points=200):
+    # A rose curve traced repeatedly through GCode parameters and expressions,
+    # so the parser evaluates several expressions on every line.
+    lines = _header(2500) + ["#<cx> = 25", "#<cy> = 25", "#<r> = 20"]
+    for loop in range(loops):
+        lines.append(f"#<k> = {2 + loop % 5}")
+        for i in range(points):
+            lines.append(f"#<t> = {i * 360 / points:.3f}")
+            lines.append("G1 X[#<cx> + #<r> * COS[#<k> * #<t>] * COS[#<t>]] Y[#<cy> + #<r> * COS[#<k> * #<t>] * SIN[#<t>]]")
+    return lines + _footer()
+
+
+JOBS = {
+    "dense_3d": dense_3d,
+    "raster": raster,
+    "arcs": arcs,
+    "parametric": parametric,
+}
@@ -1116,6 +1116,136 @@ class Miniterm(object):
            eol=key_description('\x0c'))
 
 
+class Streamer(object):
+    """\
+    Send a G-code file as fast as the controller takes it, counting characters.
+
+    Lines are sent while the bytes sent but not yet acknowledged fit in the
+    controller's receive buffer, so several lines are always in flight.  An
+    "ok" acknowledges the oldest line, "ok:N" (from $Ack/Batch) the oldest N,
+    and "error:X" the oldest one.  Status reports are requested a few times a
+    second; their Bf: field, when present, gives the planner and receive
+    buffer levels.  Progress, lines/sec and buffer levels are shown on stderr.
+    """
+
+    def __init__(self, serial_instance, rx_buffer=None, ack_batch=0, quiet=False):
+        self.serial = serial_instance
+        self.rx_buffer = rx_buffer
+        self.ack_batch = ack_batch
+        self.quiet = quiet
+        self.in_flight = []         # Lengths of the lines sent and not yet acknowledged
+        self.in_flight_bytes = 0
+        self.commands = 0           # Of those, setup commands sent before the file
+        self.acked = 0
+        self.errors = 0
+        self.planner_free = None
+        self.rx_free = None
+        self.alarm = None
+        self._partial = b''
+
+    def _handle_line(self, line):
+        if line.startswith('ok'):
+            count = int(line[3:]) if line.startswith('ok:') else 1
+            self._ack(count)
+        elif line.startswith('error'):
+            self.errors += 1
+            where = 'setup command' if self.commands else f'line {self.acked + 1}'
+            sys.stderr.write(f'\n--- {where}: {line} ---\n')
+            self._ack(1)
+        elif line.startswith('<'):
+            for field in line.strip('<>').split('|'):
+                if field.startswith('Bf:'):
+                    planner, rx = field[3:].split(',')
+                    self.planner_free, self.rx_free = int(planner), int(rx)
+        elif line.startswith('ALARM'):
+            self.alarm = line
+        elif line and not self.quiet:
+            sys.stderr.write(f'\n{line}\n')
+
+    def _ack(self, count):
+        for _ in range(min(count, len(self.in_flight))):
+            self.in_flight_bytes -= self.in_flight.pop(0)
+            if self.commands:
+                self.commands -= 1
+            else:
+                self.acked += 1
+
+    def _poll(self):
+        data = self.serial.read(self.serial.in_waiting or 1)
+        if not data:
+            return
+        lines = (self._partial + data).split(b'\n')
+        self._partial = lines.pop()
+        for line in lines:
+            self._handle_line(line.decode('utf-8', 'replace').strip())
+
+    def _wait_for_rx_buffer(self):
+        """Use the receive buffer size from an idle status report unless one was given"""
+        deadline = time.time() + 2
+        self.serial.write(b'?')
+        while self.rx_free is None and time.time() < deadline:
+            self._poll()
+        if self.rx_buffer is None:
+            self.rx_buffer = self.rx_free or 128
+        sys.stderr.write(f'--- Receive buffer {self.rx_buffer} bytes ---\n')
+
+    def _show(self, start, sent, total):
+        elapsed = max(time.time() - start, 1e-6)
+        buffers = ''
+        if self.planner_free is not None:
+            buffers = f'  planner free {self.planner_free}  rx free {self.rx_free}'
+        sys.stderr.write(f'\r--- {self.acked}/{total} lines  {self.acked / elapsed:7.1f} lines/s  '
+                         f'{sent / elapsed / 1024:6.1f} KB/s  in flight {self.in_flight_bytes:4}{buffers} ')
+        sys.stderr.flush()
+
+    def stream(self, filename):
+        with open(filename, 'rb') as f:
+            lines = [line.strip() + b'\n' for line in f]
+        lines = [line for line in lines if line != b'\n' and not line.startswith(b';')]
+
+        self.serial.timeout = 0.01
+        self.serial.reset_input_buffer()
+        if self.ack_batch:
+            command = f'$Ack/Batch={self.ack_batch}\n'.encode()
+            self.serial.write(command)
+            self.in_flight.append(len(command))
+            self.in_flight_bytes += len(command)
+            self.commands += 1
+        self._wait_for_rx_buffer()
+        too_long = [n for n, line in enumerate(lines) if len(line) > self.rx_buffer]
+        if too_long:
+            sys.stderr.write(f'--- line {too_long[0] + 1} is longer than the receive buffer ---\n')
+            return False
+
+        start = time.time()
+        next_status = next_show = start
+        sent = 0
+        index = 0
+        while (index < len(lines) or self.in_flight) and not self.alarm:
+            while index < len(lines) and self.in_flight_bytes + len(lines[index]) <= self.rx_buffer:
+                line = lines[index]
+                self.serial.write(line)
+                self.in_flight.append(len(line))
+                self.in_flight_bytes += len(line)
+                sent += len(line)
+                index += 1
+            self._poll()
+            now = time.time()
+            if now >= next_status:
+                self.serial.write(b'?')
+                next_status = now + 0.2
+            if now >= next_show:
+                self._show(start, sent, len(lines))
+                next_show = now + 1
+        self._show(start, sent, len(lines))
+        sys.stderr.write('\n')
+        if self.alarm:
+            sys.stderr.write(f'--- Stopped by {self.alarm} ---\n')
+            return False
+        sys.stderr.write(f'--- {len(lines)} lines, {sent} bytes in {time.time() - start:.1f} s, {self.errors} errors ---\n')
+        return self.errors == 0
+
+
 # - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 # default args can be used to override when calling main() from an other script
 # e.g to create a miniterm-my-device.py
@@ -1221,6 +1351,26 @@ def main(default_port=None, default_baudrate=115200, default_rts=None, default_d
         help='Do no apply any encodings/transformations',
         default=False)
 
+    group = parser.add_argument_group('streaming')
+
+    group.add_argument(
+        '--stream',
+        metavar='FILE',
+        help='send a G-code file with character counting, showing throughput, then exit')
+
+    group.add_argument(
+        '--rx-buffer',
+        type=int,
+        metavar='BYTES',
+        help='controller receive buffer size for --stream, default: from the Bf: status field, else 128')
+
+    group.add_argument(
+        '--ack-batch',
+        type=int,
+        metavar='MS',
+        help='for --stream, have the controller batch acknowledgments for up to MS milliseconds ($Ack/Batch)',
+        default=0)
+
     group = parser.add_argument_group('hotkeys')
 
     group.add_argument(
@@ -1316,6 +1466,12 @@ def main(default_port=None, default_baudrate=115200, default_rts=None, default_d
         else:
             break
 
+    if args.stream:
+        streamer = Streamer(serial_instance, rx_buffer=args.rx_buffer, ack_batch=args.ack_batch, quiet=args.quiet)
+        ok = streamer.stream(args.stream)
+        serial_instance.close()
+        sys.exit(0 if ok else 1)
+
     miniterm = Miniterm(
         serial_instance,
         echo=args.echo,
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+
+# Lists the flash-resident code and constant data that the step and pin
+# interrupt handlers can reach.
+#
+# Code in an ISR must not touch flash: while the SPI flash is being written,
+# as when saving to LittleFS or NVS, the flash cache is off, and the access
+# crashes or, at best, stalls stepping until the write completes.  Run
+#   python isr-flash-check.py [.pio/build/wifi/firmware.elf] [--root REGEX]... [--strict]
+# after a build.  The roots are the functions in IRAM whose names look like
+# interrupt handlers, and Stepper::pulse_func; --root adds more.  Every
+# function reachable from them by direct calls is checked, and each that is
+# in flash is listed with the chain of calls that reaches it.  Literal pool
+# words that point into flash, which is how the code loads the address of a
+# flash string, table, vtable or function, are listed too.
+#
+# Calls through function pointers and virtual methods cannot be followed, so
+# the functions that make them are listed as well; their targets need to be
+# checked by hand, or placed with custom_isr_in_iram (see
+# FluidNC/ld/esp32/README.md).
+#
+# The tools come with the PlatformIO ESP32 toolchain; set OBJDUMP and NM if
+# xtensa-esp32-elf-objdump and xtensa-esp32-elf-nm are not on the PATH.
+
+import bisect
+import collections
+import os
+import re
+import struct
+import subprocess
+import sys
+
+default_roots = [r'(?i)isr\b', r'^Stepper::pulse_func\b']
+
+# Flash mapped code and data on the ESP32 and the ESP32-S3
+flash_text = [(0x400C2000, 0x40C00000), (0x42000000, 0x44000000)]
+flash_data = [(0x3F400000, 0x3F800000), (0x3C000000, 0x3E000000)]
+
+call_re = re.compile(r'^call(0|4|8|12)$')
+callx_re = re.compile(r'^callx(0|4|8|12)$')
+func_re = re.compile(r'^([0-9a-f]+) <(.+)>:$')
+insn_re = re.compile(r'^\s*([0-9a-f]+):\s+(\S+)\s*(.*)$')
+target_re = re.compile(r'([0-9a-f]{8})\b')
+
+
+def in_ranges(address, ranges):
+    return any(lo <= address < hi for lo, hi in ranges)
+
+
+def tool(name, default):
+    return os.environ.get(name, default)
+
+
+class Elf:
+    """Just enough of an ELF32 little-endian reader to fetch words by address"""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, kind, _, addr, offset, size = struct.unpack_from('<IIIIII', self.data, shoff + i * shentsize)
+            if kind != 8 and addr and size:  # Not SHT_NOBITS
+                self.sections.append((addr, size, offset))
+
+    def word(self, address):
+        for addr, size, offset in self.sections:
+            if addr <= address and address + 4 <= addr + size:
+                return struct.unpack_from('<I', self.data, offset + address - addr)[0]
+        return None
+
+
+def read_symbols(elf):
+    args = [tool('NM', 'xtensa-esp32-elf-nm'), '-C', '-n', elf]
+    symbols = []
+    for line in subprocess.run(args, capture_output=True, text=True, check=True).stdout.splitlines():
+        parts = line.split(' ', 2)
+        if len(parts) == 3 and parts[1] not in 'aAUw':
+            symbols.append((int(parts[0], 16), parts[2]))
+    return symbols
+
+
+def read_functions(elf):
+    """Returns {address: (name, [call targets], [literal addresses], indirect call count)}"""
+    args = [tool('OBJDUMP', 'xtensa-esp32-elf-objdump'), '-d', '-C', '--no-show-raw-insn', elf]
+    output = subprocess.run(args, capture_output=True, text=True, check=True).stdout
+    functions = {}
+    current = None
+    for line in output.splitlines():
+        m = func_re.match(line)
+        if m:
+            current = [m.group(2), [], [], 0]
+            functions[int(m.group(1), 16)] = current
+            continue
+        m = insn_re.match(line)
+        if not m or current is None:
+            continue
+        mnemonic, operands = m.group(2), m.group(3)
+        if call_re.match(mnemonic) or mnemonic in ('j', 'j.l'):
+            t = target_re.search(operands)
+            if t:
+                current[1].append(int(t.group(1), 16))
+        elif mnemonic == 'l32r':
+            t = target_re.search(operands)
+            if t:
+                current[2].append(int(t.group(1), 16))
+        elif callx_re.match(mnemonic) or mnemonic == 'jx':
+            current[3] += 1
+    return functions
+
+
+def main():
+    args = sys.argv[1:]
+    strict = '--strict' in args
+    roots = list(default_roots)
+    elf = '.pio/build/wifi/firmware.elf'
+    i = 0
+    while i < len(args):
+        if args[i] == '--root' and i + 1 < len(args):
+            roots.append(args[i + 1])
+            i += 1
+        elif args[i] != '--strict':
+            elf = args[i]
+        i += 1
+    root_res = [re.compile(r) for r in roots]
+
+    functions = read_functions(elf)
+    starts = sorted(functions)
+    symbols = read_symbols(elf)
+    symbol_starts = [a for a, _ in symbols]
+    image = Elf(elf)
+
+    def function_at(address):
+        i = bisect.bisect_right(starts, address) - 1
+        return starts[i] if i >= 0 else None
+
+    def symbol_at(address):
+        i = bisect.bisect_right(symbol_starts, address) - 1
+        return symbols[i][1] if i >= 0 else '?'
+
+    # Breadth first, so the chain to each function is a shortest one
+    parent = {}
+    queue = collections.deque()
+    for address, (name, _, _, _) in functions.items():
+        if not in_ranges(address, flash_text) and any(r.search(name) for r in root_res):
+            parent[address] = None
+            queue.append(address)
+    if not queue:
+        sys.exit('No ISR roots found in ' + elf)
+
+    while queue:
+        address = queue.popleft()
+        for target in functions[address][1]:
+            callee = function_at(target)
+            if callee is not None and callee != address and callee not in parent:
+                parent[callee] = address
+                queue.append(callee)
+
+    def chain(address):
+        names = []
+        while address is not None:
+            names.append(functions[address][0])
+            address = parent[address]
+        return ' <- '.join(names)
+
+    in_flash = sorted(a for a in parent if in_ranges(a, flash_text))
+    literals = collections.defaultdict(set)
+    indirect = []
+    for address in sorted(parent):
+        name, _, pool, n_indirect = functions[address]
+        if n_indirect:
+            indirect.append((name, n_indirect))
+        if in_ranges(address, flash_text):
+            continue  # Already reported
+        for literal in pool:
+            value = image.word(literal)
+            if value is not None and (in_ranges(value, flash_data) or in_ranges(value, flash_text)):
+                literals[name].add(symbol_at(value))
+
+    print('%d functions reachable from %d ISR roots' % (len(parent), sum(1 for p in parent.values() if p is None)))
+    if in_flash:
+        print('\nFunctions in flash:')
+        for address in in_flash:
+            print('  ' + chain(address))
+    if literals:
+        print('\nFlash addresses loaded by IRAM code:')
+        for name in sorted(literals):
+            print('  %s: %s' % (name, ', '.join(sorted(literals[name]))))
+    if indirect:
+        print('\nIndirect calls, not followed:')
+        for name, count in indirect:
+            print('  %s: %d' % (name, count))
+    if not in_flash and not literals:
+        print('No flash references found')
+
+    if strict and (in_flash or literals):
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()